@@ -0,0 +1,112 @@
+#include "ANNIEEventKeys.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BoostStore.h"
+#include "ADCPulse.h"
+#include "BeamStatus.h"
+#include "Hit.h"
+#include "LAPPDHit.h"
+#include "Particle.h"
+#include "PsecData.h"
+#include "TimeClass.h"
+#include "TriggerClass.h"
+#include "Waveform.h"
+
+namespace {
+
+	typedef std::function<bool(BoostStore*, BoostStore*, const std::string&, bool)> KeyCopier;
+
+	// The pointer form of Get works for keys that were Set either by value
+	// or by pointer, and leaves the source store owning the object. The
+	// target gets its own copy by pointer rather than a serialized one.
+	template<typename T> bool CopyTyped(BoostStore* from, BoostStore* to, const std::string& key, bool){
+		T* value = nullptr;
+		if(!from->Get(key,value) || value==nullptr) return false;
+		to->Set(key,new T(*value));
+		return true;
+	}
+
+	// TDCData holds MCHits in simulation and Hits in data
+	bool CopyTDCData(BoostStore* from, BoostStore* to, const std::string& key, bool mc_flag){
+		if(mc_flag) return CopyTyped<std::map<unsigned long,std::vector<MCHit>>>(from,to,key,mc_flag);
+		return CopyTyped<std::map<unsigned long,std::vector<Hit>>>(from,to,key,mc_flag);
+	}
+
+	const std::map<std::string,KeyCopier>& Copiers(){
+		static const std::map<std::string,KeyCopier> copiers = {
+			// event header
+			{"RunNumber", CopyTyped<int>},
+			{"SubrunNumber", CopyTyped<int>},
+			{"PartNumber", CopyTyped<int>},
+			{"RunType", CopyTyped<int>},
+			{"RunStartTime", CopyTyped<uint64_t>},
+			{"EventNumber", CopyTyped<uint32_t>},
+			{"LocalEventNumber", CopyTyped<size_t>},
+			{"DataStreams", CopyTyped<std::map<std::string,bool>>},
+			{"CTCTimestamp", CopyTyped<uint64_t>},
+			{"TriggerWord", CopyTyped<uint32_t>},
+			{"TriggerExtended", CopyTyped<int>},
+			{"TriggerData", CopyTyped<TriggerClass>},
+			{"BeamStatus", CopyTyped<BeamStatus>},
+			{"EventTimeTank", CopyTyped<uint64_t>},
+			{"EventTimeMRD", CopyTyped<TimeClass>},
+			{"EventTimeLAPPD", CopyTyped<uint64_t>},
+			{"LAPPDOffset", CopyTyped<uint64_t>},
+			{"MRDTriggerType", CopyTyped<std::string>},
+			{"MRDLoopbackTDC", CopyTyped<std::map<std::string,int>>},
+			// tank and MRD data
+			{"Hits", CopyTyped<std::map<unsigned long,std::vector<Hit>>>},
+			{"AuxHits", CopyTyped<std::map<unsigned long,std::vector<Hit>>>},
+			{"TDCData", CopyTDCData},
+			{"RawAcqSize", CopyTyped<std::map<unsigned long,std::vector<int>>>},
+			{"RecoADCData", CopyTyped<std::map<unsigned long,std::vector<std::vector<ADCPulse>>>>},
+			{"RecoAuxADCData", CopyTyped<std::map<unsigned long,std::vector<std::vector<ADCPulse>>>>},
+			{"RawADCData", CopyTyped<std::map<unsigned long,std::vector<Waveform<uint16_t>>>>},
+			{"RawADCAuxData", CopyTyped<std::map<unsigned long,std::vector<Waveform<uint16_t>>>>},
+			// LAPPD data
+			{"LAPPDData", CopyTyped<PsecData>},
+			{"RawLAPPDData", CopyTyped<std::map<unsigned long,std::vector<Waveform<uint16_t>>>>},
+			// MC truth
+			{"MCFlag", CopyTyped<bool>},
+			{"MCFile", CopyTyped<std::string>},
+			{"MCEventNum", CopyTyped<uint64_t>},
+			{"MCTriggernum", CopyTyped<uint16_t>},
+			{"EventTime", CopyTyped<TimeClass>},
+			{"MCParticles", CopyTyped<std::vector<MCParticle>>},
+			{"MCHits", CopyTyped<std::map<unsigned long,std::vector<MCHit>>>},
+			{"MCLAPPDHits", CopyTyped<std::map<unsigned long,std::vector<MCLAPPDHit>>>},
+			{"MCNeutCap", CopyTyped<std::map<std::string,std::vector<double>>>},
+			{"MCNeutCapGammas", CopyTyped<std::map<std::string,std::vector<std::vector<double>>>>},
+			{"PrimaryMuonIndex", CopyTyped<int>}
+		};
+		return copiers;
+	}
+
+}
+
+bool annieeventkeys::CopyKey(BoostStore* from, BoostStore* to, const std::string& key, bool mc_flag){
+	auto it = Copiers().find(key);
+	if(it==Copiers().end()) return false;
+	return it->second(from,to,key,mc_flag);
+}
+
+bool annieeventkeys::IsMC(BoostStore* annie_event){
+	bool mc_flag = false;
+	annie_event->Get("MCFlag",mc_flag);
+	return mc_flag;
+}
+
+bool annieeventkeys::IsKnownKey(const std::string& key){
+	return Copiers().count(key)>0;
+}
+
+std::vector<std::string> annieeventkeys::KnownKeys(){
+	std::vector<std::string> keys;
+	for(auto& copier : Copiers()) keys.push_back(copier.first);
+	return keys;
+}
@@ -0,0 +1,33 @@
+#ifndef ANNIEEVENTKEYS_H
+#define ANNIEEVENTKEYS_H
+
+#include <string>
+#include <vector>
+
+class BoostStore;
+
+// Type-aware copying of individual ANNIEEvent keys between BoostStores.
+// BoostStore only (de)serializes with the concrete type known, so every
+// key that should be copyable without the caller knowing its type is
+// listed in ANNIEEventKeys.cpp.
+namespace annieeventkeys{
+
+	// Copy key from one store to another. The object is read from the
+	// source once and handed to the target by pointer, so the target owns
+	// its own copy and only serializes it if it is saved. mc_flag selects
+	// the type of keys that differ between data and simulation (TDCData);
+	// take it from the ANNIEEvent with IsMC, not from a key group store.
+	// Returns false if the key is not in the source store or is unknown.
+	bool CopyKey(BoostStore* from, BoostStore* to, const std::string& key, bool mc_flag);
+
+	// MCFlag of an ANNIEEvent entry, false if it is not set
+	bool IsMC(BoostStore* annie_event);
+
+	// Whether CopyKey knows the type of this key
+	bool IsKnownKey(const std::string& key);
+
+	// All keys known to CopyKey
+	std::vector<std::string> KnownKeys();
+}
+
+#endif
@@ -0,0 +1,98 @@
+// standard library includes
+#include <algorithm>
+
+// ToolAnalysis includes
+#include "BeamConditionsIndex.h"
+
+void BeamIntervalIndex::Fill(
+  const std::map<int, std::pair<uint64_t, uint64_t> >& intervals)
+{
+  std::vector<std::pair<std::pair<uint64_t, uint64_t>, int> > sorted;
+  sorted.reserve(intervals.size());
+  for (const auto& pair : intervals) sorted.push_back({pair.second, pair.first});
+  std::sort(sorted.begin(), sorted.end());
+
+  starts_.clear();
+  ends_.clear();
+  labels_.clear();
+  max_ends_.clear();
+  for (const auto& interval : sorted) {
+    starts_.push_back(interval.first.first);
+    ends_.push_back(interval.first.second);
+    labels_.push_back(interval.second);
+    uint64_t max_end = interval.first.second;
+    if (!max_ends_.empty()) max_end = std::max(max_end, max_ends_.back());
+    max_ends_.push_back(max_end);
+  }
+}
+
+int BeamIntervalIndex::Find(uint64_t t) const
+{
+  // Last interval starting at or before t
+  long i = std::upper_bound(starts_.begin(), starts_.end(), t)
+    - starts_.begin() - 1;
+
+  int label = -1;
+  for ( ; i >= 0 && max_ends_[i] >= t; --i) {
+    if (ends_[i] >= t && (label < 0 || labels_[i] < label)) label = labels_[i];
+  }
+  return label;
+}
+
+void BeamConditionsIndex::Clear()
+{
+  device_ids_.clear();
+  device_names_.clear();
+  offsets_.clear();
+  times_.clear();
+  points_.clear();
+}
+
+void BeamConditionsIndex::Fill(
+  const std::map<std::string, std::map<uint64_t, BeamDataPoint> >& beam_data)
+{
+  Clear();
+
+  size_t n_points = 0;
+  for (const auto& device_pair : beam_data) n_points += device_pair.second.size();
+  times_.reserve(n_points);
+  points_.reserve(n_points);
+  offsets_.reserve(beam_data.size() + 1);
+
+  offsets_.push_back(0);
+  for (const auto& device_pair : beam_data) {
+    device_ids_[device_pair.first] = device_names_.size();
+    device_names_.push_back(device_pair.first);
+    // std::map iterates in time order, so each device's block is sorted
+    for (const auto& measurement : device_pair.second) {
+      times_.push_back(measurement.first);
+      points_.push_back(measurement.second);
+    }
+    offsets_.push_back(times_.size());
+  }
+}
+
+int BeamConditionsIndex::DeviceID(const std::string& device_name) const
+{
+  auto it = device_ids_.find(device_name);
+  if (it == device_ids_.end()) return -1;
+  return it->second;
+}
+
+long BeamConditionsIndex::FindClosest(int device_id, uint64_t ms_since_epoch)
+  const
+{
+  if (device_id < 0 || device_id >= (int)device_names_.size()) return -1;
+  auto begin = times_.begin() + offsets_[device_id];
+  auto end = times_.begin() + offsets_[device_id + 1];
+
+  auto low = std::lower_bound(begin, end, ms_since_epoch);
+  if (low == end) return -1;
+  if (low == begin) return low - times_.begin();
+
+  // We're between two time values, so pick the closer one
+  auto prev = low - 1;
+  if ((ms_since_epoch - *prev) < (*low - ms_since_epoch))
+    return prev - times_.begin();
+  return low - times_.begin();
+}
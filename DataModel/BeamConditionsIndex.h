@@ -0,0 +1,86 @@
+// Flat, binary-searchable view of Intensity Frontier beam database
+// information, used for fast beam status lookups
+#ifndef BEAMCONDITIONSINDEX_H
+#define BEAMCONDITIONSINDEX_H
+
+// standard library includes
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// ToolAnalysis includes
+#include "BeamDataPoint.h"
+
+/// @brief Sorted list of time intervals, each labelled with an integer
+/// (e.g. the beam database entry covering that interval)
+class BeamIntervalIndex {
+
+  public:
+
+    BeamIntervalIndex() {}
+
+    /// @brief Build the index from a map of label -> (start, end)
+    void Fill(const std::map<int, std::pair<uint64_t, uint64_t> >& intervals);
+
+    /// @brief Label of the interval containing t, or -1 if there is none.
+    /// If several intervals contain t, the smallest label is returned.
+    int Find(uint64_t t) const;
+
+    inline size_t size() const { return starts_.size(); }
+
+  private:
+
+    // All arrays are sorted by interval start time
+    std::vector<uint64_t> starts_;
+    std::vector<uint64_t> ends_;
+    std::vector<int> labels_;
+    // Largest end time of all intervals up to and including this one,
+    // used to stop the backwards search for overlapping intervals
+    std::vector<uint64_t> max_ends_;
+};
+
+/// @brief Beam database measurements stored in flat arrays. Device names
+/// are interned to integer IDs, and the measurements of each device are
+/// sorted by time so the closest one can be found by binary search.
+class BeamConditionsIndex {
+
+  public:
+
+    BeamConditionsIndex() {}
+
+    void Clear();
+
+    /// @brief Build the index from the device -> (time -> measurement) map
+    /// stored in a beam database entry
+    void Fill(const std::map<std::string, std::map<uint64_t, BeamDataPoint> >&
+      beam_data);
+
+    inline size_t NumDevices() const { return device_names_.size(); }
+
+    /// @brief Integer ID of a device, or -1 if it is unknown
+    int DeviceID(const std::string& device_name) const;
+    inline const std::string& DeviceName(int device_id) const
+      { return device_names_.at(device_id); }
+
+    /// @brief Position of the measurement of a device closest in time to
+    /// ms_since_epoch (ties go to the later measurement), or -1 if there is
+    /// no measurement at or after that time
+    long FindClosest(int device_id, uint64_t ms_since_epoch) const;
+
+    inline uint64_t Time(long position) const { return times_[position]; }
+    inline const BeamDataPoint& Point(long position) const
+      { return points_[position]; }
+
+  private:
+
+    std::map<std::string, int> device_ids_;
+    std::vector<std::string> device_names_;
+
+    // The measurements of device d are at [offsets_[d], offsets_[d+1])
+    std::vector<size_t> offsets_;
+    std::vector<uint64_t> times_;
+    std::vector<BeamDataPoint> points_;
+};
+
+#endif
@@ -0,0 +1,204 @@
+// standard library includes
+#include <algorithm>
+
+// ToolAnalysis includes
+#include "ClusterTable.h"
+
+namespace {
+
+  // Builds the table from a time-keyed cluster map; missing or short
+  // detkey lists give detkey 0
+  template<typename HitType> void FillFromMaps(ClusterTable& table,
+    const std::map<double, std::vector<HitType> >& clusters,
+    const std::map<double, std::vector<unsigned long> >& cluster_detkeys)
+  {
+    table.Clear();
+    for (const auto& cluster : clusters) {
+      auto it_detkeys = cluster_detkeys.find(cluster.first);
+      const std::vector<unsigned long>* detkeys = (it_detkeys
+        != cluster_detkeys.end()) ? &it_detkeys->second : nullptr;
+      double charge = 0.;
+      table.BeginCluster();
+      for (size_t i_hit = 0; i_hit < cluster.second.size(); ++i_hit) {
+        const HitType& ahit = cluster.second[i_hit];
+        unsigned long detkey = (detkeys && i_hit < detkeys->size())
+          ? detkeys->at(i_hit) : 0;
+        table.AddHit(ahit, detkey);
+        charge += ahit.GetCharge();
+      }
+      table.EndCluster(cluster.first, charge);
+    }
+  }
+
+  template<typename HitType> void FillToMaps(const ClusterTable& table,
+    const std::vector<HitType>& hits,
+    std::map<double, std::vector<HitType> >& clusters,
+    std::map<double, std::vector<unsigned long> >& cluster_detkeys)
+  {
+    clusters.clear();
+    cluster_detkeys.clear();
+    const std::vector<unsigned long>& detkeys = table.Detkeys();
+    for (int id = 0; id < table.NClusters(); ++id) {
+      clusters.emplace_hint(clusters.end(), table.Time(id),
+        std::vector<HitType>(hits.begin() + table.HitBegin(id),
+        hits.begin() + table.HitEnd(id)));
+      cluster_detkeys.emplace_hint(cluster_detkeys.end(), table.Time(id),
+        std::vector<unsigned long>(detkeys.begin() + table.HitBegin(id),
+        detkeys.begin() + table.HitEnd(id)));
+    }
+  }
+
+}
+
+void ClusterTable::Clear()
+{
+  is_mc_ = false;
+  has_features_ = false;
+  hits_.clear();
+  mchits_.clear();
+  detkeys_.clear();
+  time_.clear();
+  charge_.clear();
+  hit_begin_.clear();
+  hit_end_.clear();
+  total_pe_.clear();
+  max_pe_.clear();
+  charge_balance_.clear();
+  charge_point_.clear();
+  open_begin_ = 0;
+}
+
+void ClusterTable::BeginCluster()
+{
+  open_begin_ = detkeys_.size();
+}
+
+void ClusterTable::AddHit(const Hit& hit, unsigned long detkey)
+{
+  hits_.push_back(hit);
+  detkeys_.push_back(detkey);
+}
+
+void ClusterTable::AddHit(const MCHit& hit, unsigned long detkey)
+{
+  is_mc_ = true;
+  mchits_.push_back(hit);
+  detkeys_.push_back(detkey);
+}
+
+int ClusterTable::EndCluster(double time, double charge)
+{
+  time_.push_back(time);
+  charge_.push_back(charge);
+  hit_begin_.push_back(open_begin_);
+  hit_end_.push_back(detkeys_.size());
+  open_begin_ = detkeys_.size();
+  ResizeFeatures();
+  return time_.size() - 1;
+}
+
+void ClusterTable::SortByTime()
+{
+  const size_t n_clusters = time_.size();
+  bool sorted = true;
+  for (size_t id = 1; id < n_clusters && sorted; ++id)
+    sorted = time_[id - 1] < time_[id];
+  if (sorted) return;
+
+  // equal times keep the order they were found in, so merged clusters list
+  // their hits in the same order as the map did
+  std::vector<uint32_t> order(n_clusters);
+  for (uint32_t id = 0; id < n_clusters; ++id) order[id] = id;
+  std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    return time_[a] < time_[b];
+  });
+
+  std::vector<Hit> hits;
+  std::vector<MCHit> mchits;
+  std::vector<unsigned long> detkeys;
+  std::vector<double> time, charge;
+  std::vector<uint32_t> hit_begin, hit_end;
+  hits.reserve(hits_.size());
+  mchits.reserve(mchits_.size());
+  detkeys.reserve(detkeys_.size());
+  for (uint32_t id : order) {
+    if (time.empty() || time.back() != time_[id]) {
+      time.push_back(time_[id]);
+      charge.push_back(0.);
+      hit_begin.push_back(detkeys.size());
+      hit_end.push_back(detkeys.size());
+    }
+    charge.back() += charge_[id];
+    for (uint32_t i_hit = hit_begin_[id]; i_hit < hit_end_[id]; ++i_hit) {
+      if (is_mc_) mchits.push_back(mchits_[i_hit]);
+      else hits.push_back(hits_[i_hit]);
+      detkeys.push_back(detkeys_[i_hit]);
+    }
+    hit_end.back() = detkeys.size();
+  }
+
+  hits_.swap(hits);
+  mchits_.swap(mchits);
+  detkeys_.swap(detkeys);
+  time_.swap(time);
+  charge_.swap(charge);
+  hit_begin_.swap(hit_begin);
+  hit_end_.swap(hit_end);
+  open_begin_ = detkeys_.size();
+  has_features_ = false;
+  total_pe_.clear();
+  max_pe_.clear();
+  charge_balance_.clear();
+  charge_point_.clear();
+  ResizeFeatures();
+}
+
+int ClusterTable::FindTime(double time) const
+{
+  auto it = std::lower_bound(time_.begin(), time_.end(), time);
+  if (it == time_.end() || *it != time) return -1;
+  return it - time_.begin();
+}
+
+void ClusterTable::SetFeatures(int id, double total_pe, double max_pe,
+  double charge_balance, const Position& charge_point)
+{
+  total_pe_[id] = total_pe;
+  max_pe_[id] = max_pe;
+  charge_balance_[id] = charge_balance;
+  charge_point_[id] = charge_point;
+  has_features_ = true;
+}
+
+void ClusterTable::ResizeFeatures()
+{
+  total_pe_.resize(time_.size(), 0.);
+  max_pe_.resize(time_.size(), 0.);
+  charge_balance_.resize(time_.size(), 0.);
+  charge_point_.resize(time_.size(), Position(0., 0., 0.));
+}
+
+void ClusterTable::FillMaps(std::map<double, std::vector<Hit> >& clusters,
+  std::map<double, std::vector<unsigned long> >& cluster_detkeys) const
+{
+  FillToMaps(*this, hits_, clusters, cluster_detkeys);
+}
+
+void ClusterTable::FillMaps(std::map<double, std::vector<MCHit> >& clusters,
+  std::map<double, std::vector<unsigned long> >& cluster_detkeys) const
+{
+  FillToMaps(*this, mchits_, clusters, cluster_detkeys);
+}
+
+void ClusterTable::FromMaps(const std::map<double, std::vector<Hit> >& clusters,
+  const std::map<double, std::vector<unsigned long> >& cluster_detkeys)
+{
+  FillFromMaps(*this, clusters, cluster_detkeys);
+}
+
+void ClusterTable::FromMaps(const std::map<double, std::vector<MCHit> >& clusters,
+  const std::map<double, std::vector<unsigned long> >& cluster_detkeys)
+{
+  FillFromMaps(*this, clusters, cluster_detkeys);
+  is_mc_ = true;
+}
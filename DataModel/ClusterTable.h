@@ -0,0 +1,111 @@
+// Flat table of the tank PMT hit clusters of one event, shared by the
+// cluster finding and cluster classification tools
+#ifndef CLUSTERTABLE_H
+#define CLUSTERTABLE_H
+
+// standard library includes
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// ToolAnalysis includes
+#include "Hit.h"
+#include "Position.h"
+
+/// @brief Clusters stored as rows of a table. The ID of a cluster is its row,
+/// and rows are ordered by cluster time, so IDs count clusters in the same
+/// order as iterating the old time-keyed cluster maps. The hits of all
+/// clusters share one array (Hit for data, MCHit for simulation); cluster i
+/// owns the hits [HitBegin(i), HitEnd(i)). The derived features are filled
+/// by ClusterClassifiers.
+class ClusterTable {
+
+  public:
+
+    ClusterTable() : is_mc_(false), has_features_(false), open_begin_(0) {}
+
+    void Clear();
+
+    /// @brief Building: the hits added after BeginCluster belong to the
+    /// cluster closed by EndCluster, which returns its row
+    void BeginCluster();
+    void AddHit(const Hit& hit, unsigned long detkey);
+    void AddHit(const MCHit& hit, unsigned long detkey);
+    int EndCluster(double time, double charge);
+
+    /// @brief Orders the rows by time. Clusters with equal times are merged,
+    /// as they were when the clusters were keyed by time in a map.
+    void SortByTime();
+
+    inline int NClusters() const { return time_.size(); }
+    inline bool IsMC() const { return is_mc_; }
+
+    inline double Time(int id) const { return time_[id]; }
+    /// Summed charge of the hits of the cluster
+    inline double Charge(int id) const { return charge_[id]; }
+    inline uint32_t HitBegin(int id) const { return hit_begin_[id]; }
+    inline uint32_t HitEnd(int id) const { return hit_end_[id]; }
+    inline int NHits(int id) const { return hit_end_[id] - hit_begin_[id]; }
+
+    /// @brief Row of the cluster at this time, or -1 if there is none
+    int FindTime(double time) const;
+
+    // Hits, indexed by position in the shared hit array
+    inline const std::vector<Hit>& Hits() const { return hits_; }
+    inline const std::vector<MCHit>& MCHits() const { return mchits_; }
+    inline const std::vector<unsigned long>& Detkeys() const { return detkeys_; }
+    inline double HitTime(uint32_t i) const
+      { return is_mc_ ? mchits_[i].GetTime() : hits_[i].GetTime(); }
+    inline double HitCharge(uint32_t i) const
+      { return is_mc_ ? mchits_[i].GetCharge() : hits_[i].GetCharge(); }
+    inline int HitTubeId(uint32_t i) const
+      { return is_mc_ ? mchits_[i].GetTubeId() : hits_[i].GetTubeId(); }
+    inline unsigned long HitDetkey(uint32_t i) const { return detkeys_[i]; }
+
+    /// @brief Derived features, one column each
+    void SetFeatures(int id, double total_pe, double max_pe,
+      double charge_balance, const Position& charge_point);
+    inline bool HasFeatures() const { return has_features_; }
+    inline double TotalPE(int id) const { return total_pe_[id]; }
+    inline double MaxPE(int id) const { return max_pe_[id]; }
+    inline double ChargeBalance(int id) const { return charge_balance_[id]; }
+    inline const Position& ChargePoint(int id) const { return charge_point_[id]; }
+
+    /// @brief Adapter to the time-keyed cluster maps (ClusterMap,
+    /// ClusterMapMC, ClusterMapDetkey) used by the other tools
+    void FillMaps(std::map<double, std::vector<Hit> >& clusters,
+      std::map<double, std::vector<unsigned long> >& cluster_detkeys) const;
+    void FillMaps(std::map<double, std::vector<MCHit> >& clusters,
+      std::map<double, std::vector<unsigned long> >& cluster_detkeys) const;
+    void FromMaps(const std::map<double, std::vector<Hit> >& clusters,
+      const std::map<double, std::vector<unsigned long> >& cluster_detkeys);
+    void FromMaps(const std::map<double, std::vector<MCHit> >& clusters,
+      const std::map<double, std::vector<unsigned long> >& cluster_detkeys);
+
+  private:
+
+    void ResizeFeatures();
+
+    bool is_mc_;
+    bool has_features_;
+
+    // per hit
+    std::vector<Hit> hits_;
+    std::vector<MCHit> mchits_;
+    std::vector<unsigned long> detkeys_;
+
+    // per cluster
+    std::vector<double> time_;
+    std::vector<double> charge_;
+    std::vector<uint32_t> hit_begin_;
+    std::vector<uint32_t> hit_end_;
+    std::vector<double> total_pe_;
+    std::vector<double> max_pe_;
+    std::vector<double> charge_balance_;
+    std::vector<Position> charge_point_;
+
+    // first hit of the cluster being built
+    uint32_t open_begin_;
+};
+
+#endif
@@ -10,6 +10,7 @@
 
 #include "Store.h"
 #include "BoostStore.h"
+#include "StoreMap.h"
 #include "Logging.h"
 #include "LAPPD.h"
 #include "ANNIEalgorithms.h"
@@ -66,7 +67,7 @@ class DataModel {
 
   Store vars; ///< This Store can be used for any variables. It is an inefficent ascii based storage    
   BoostStore CStore; ///< This is a more efficent binary BoostStore that can be used to store a dynamic set of inter Tool variables.
-  std::map<std::string,BoostStore*> Stores; ///< This is a map of named BooStore pointers which can be deffined to hold a nammed collection of any tipe of BoostStore. It is usefull to store data that needs subdividing into differnt stores.
+  StoreMap Stores; ///< This is a map of named BooStore pointers which can be deffined to hold a nammed collection of any tipe of BoostStore. It is usefull to store data that needs subdividing into differnt stores.
   
   Logging *Log; ///< Log class pointer for use in Tools, it can be used to send messages which can have multiple error levels and destination end points  
 
@@ -1,6 +1,8 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "Geometry.h"
 
+#include <algorithm>
+
 Geometry::Geometry(double ver, Position tankc, double tankr, double tankhh, double pmtencr, double pmtenchh, double mrdw, double mrdh, double mrdd, double mrds, int ntankpmts, int nmrdpmts, int nvetopmts, int nlappds, geostatus statin, std::map<std::string,std::map<unsigned long,Detector> >dets){
 	NextFreeChannelKey=0;
 	NextFreeDetectorKey=0;
@@ -24,33 +26,119 @@ Geometry::Geometry(double ver, Position tankc, double tankr, double tankhh, doub
 }
 
 Detector*  Geometry::GetDetector(unsigned long DetectorKey){
+	if(!lookup_tables_built) BuildLookupTables();
+	if(DetectorKey<DetectorsByKey.size()) return DetectorsByKey[DetectorKey];
+	// keys beyond the dense table
 	for(std::map<std::string,std::map<unsigned long,Detector>>::iterator it = RealDetectors.begin();
 		it!=RealDetectors.end();
 		++it){
-		for (std::map<unsigned long,Detector>::iterator it2=it->second.begin();
-														it2!=it->second.end();
-														++it2){
-			if(DetectorKey==it2->first){
-				Detector* det= &it2->second;
-				return det;
-			}
-		}
+		std::map<unsigned long,Detector>::iterator it2 = it->second.find(DetectorKey);
+		if(it2!=it->second.end()) return &it2->second;
 	}
 	return 0;
 }
 
 Detector* Geometry::ChannelToDetector(unsigned long ChannelKey){
+	if(!lookup_tables_built) BuildLookupTables();
+	if(ChannelKey<DetectorsByChannelKey.size()) return DetectorsByChannelKey[ChannelKey];
 	if(ChannelMap.size()==0) InitChannelMap();
 	if(ChannelMap.count(ChannelKey)) return ChannelMap.at(ChannelKey);
 	return 0;
 }
 
 Channel* Geometry::GetChannel(unsigned long ChannelKey){
+	if(!lookup_tables_built) BuildLookupTables();
+	if(ChannelKey<ChannelsByKey.size()) return ChannelsByKey[ChannelKey];
 	if(ChannelMap.size()==0) InitChannelMap();
 	if(ChannelMap.count(ChannelKey)) return &(ChannelMap.at(ChannelKey)->GetChannels()->at(ChannelKey));
 	return 0;
 }
 
+// keys above this are left to the map lookups, to bound the size of the tables
+static const unsigned long max_dense_key = 1<<20;
+
+void Geometry::ClearLookupTables(){
+	lookup_tables_built=false;
+	DetectorInfos.clear();
+	ChannelInfos.clear();
+	DetectorsByKey.clear();
+	DetectorsByChannelKey.clear();
+	ChannelsByKey.clear();
+	DetectorElements.clear();
+	ChannelMap.clear();
+}
+
+void Geometry::BuildLookupTables(){
+	ClearLookupTables();
+	
+	// size the tables to the largest keys in use
+	unsigned long detectorkeys=0, channelkeys=0;
+	for(auto&& aset : RealDetectors){
+		for(auto&& adetector : aset.second){
+			if(adetector.first<max_dense_key) detectorkeys = std::max(detectorkeys,adetector.first+1);
+			for(auto&& achannel : *adetector.second.GetChannels()){
+				if(achannel.first<max_dense_key) channelkeys = std::max(channelkeys,achannel.first+1);
+			}
+		}
+	}
+	DetectorInfos.resize(detectorkeys);
+	DetectorsByKey.assign(detectorkeys,nullptr);
+	ChannelInfos.resize(channelkeys);
+	DetectorsByChannelKey.assign(channelkeys,nullptr);
+	ChannelsByKey.assign(channelkeys,nullptr);
+	
+	for(auto&& aset : RealDetectors){
+		int element = DetectorElements.size();
+		DetectorElements.push_back(aset.first);
+		for(auto&& adetector : aset.second){
+			Detector* thedetector = &adetector.second;
+			Position detpos = thedetector->GetDetectorPosition();
+			Direction detdir = thedetector->GetDetectorDirection();
+			if(adetector.first<detectorkeys){
+				DetectorsByKey[adetector.first] = thedetector;
+				DetectorInfo& info = DetectorInfos[adetector.first];
+				info.valid = true;
+				info.element = element;
+				info.x = detpos.X(); info.y = detpos.Y(); info.z = detpos.Z();
+				info.dir_x = detdir.X(); info.dir_y = detdir.Y(); info.dir_z = detdir.Z();
+				info.status = thedetector->GetStatus();
+			}
+			for(auto&& achannel : *thedetector->GetChannels()){
+				if(achannel.first>=channelkeys) continue;
+				if(ChannelsByKey[achannel.first]!=nullptr){
+					cerr<<"ERROR: Geometry::BuildLookupTables(): Detector "<<adetector.first
+						<<" has channel key "<<achannel.first<<" which is not unique!"<<endl;
+					continue;
+				}
+				Channel* thechannel = &achannel.second;
+				DetectorsByChannelKey[achannel.first] = thedetector;
+				ChannelsByKey[achannel.first] = thechannel;
+				ChannelInfo& info = ChannelInfos[achannel.first];
+				Position chanpos = thechannel->GetChannelPosition();
+				info.valid = true;
+				info.detector_key = adetector.first;
+				info.element = element;
+				info.x = detpos.X(); info.y = detpos.Y(); info.z = detpos.Z();
+				info.dir_x = detdir.X(); info.dir_y = detdir.Y(); info.dir_z = detdir.Z();
+				info.chan_x = chanpos.X(); info.chan_y = chanpos.Y(); info.chan_z = chanpos.Z();
+				info.strip_side = thechannel->GetStripSide();
+				info.strip_num = thechannel->GetStripNum();
+				info.signal_crate = thechannel->GetSignalCrate();
+				info.signal_card = thechannel->GetSignalCard();
+				info.signal_channel = thechannel->GetSignalChannel();
+				info.level2_crate = thechannel->GetLevel2Crate();
+				info.level2_card = thechannel->GetLevel2Card();
+				info.level2_channel = thechannel->GetLevel2Channel();
+				info.hv_crate = thechannel->GetHvCrate();
+				info.hv_card = thechannel->GetHvCard();
+				info.hv_channel = thechannel->GetHvChannel();
+				info.status = thechannel->GetStatus();
+			}
+		}
+	}
+	lookup_tables_built=true;
+}
+
 void Geometry::InitChannelMap(){
 	// loop over detector sets
 	for(std::map<std::string,std::map<unsigned long,Detector>>::iterator it = RealDetectors.begin();
@@ -12,6 +12,30 @@ using namespace std;
 
 enum class geostatus : uint8_t { FULLY_OPERATIONAL, TANK_ONLY, MRD_ONLY, };
 
+// Flat copies of the Detector and Channel information used for per-hit lookups,
+// held by Geometry in arrays indexed by DetectorKey and ChannelKey
+struct DetectorInfo {
+	bool valid=false;             // false for DetectorKeys with no Detector
+	int element=-1;               // index into Geometry::GetDetectorElements()
+	double x=0, y=0, z=0;         // DetectorPosition, meters
+	double dir_x=0, dir_y=0, dir_z=0;
+	detectorstatus status=detectorstatus::OFF;
+};
+
+struct ChannelInfo {
+	bool valid=false;             // false for ChannelKeys with no Channel
+	unsigned long detector_key=0;
+	int element=-1;               // index into Geometry::GetDetectorElements()
+	double x=0, y=0, z=0;         // position of the owning Detector, meters
+	double dir_x=0, dir_y=0, dir_z=0;
+	double chan_x=0, chan_y=0, chan_z=0; // Channel position, e.g. of an LAPPD strip
+	int strip_side=-1, strip_num=-1;
+	unsigned int signal_crate=0, signal_card=0, signal_channel=0;
+	unsigned int level2_crate=0, level2_card=0, level2_channel=0;
+	unsigned int hv_crate=0, hv_card=0, hv_channel=0;
+	channelstatus status=channelstatus::OFF;
+};
+
 class Geometry : public SerialisableObject{
 	
 	friend class boost::serialization::access;
@@ -25,6 +49,7 @@ class Geometry : public SerialisableObject{
 	Geometry(double ver, Position tankc, double tankr, double tankhh, double pmtencr, double pmtenchh, double mrdw, double mrdh, double mrdd, double mrds, int ntankpmts, int nmrdpmts, int nvetopmts, int nlappds, geostatus statin, std::map<std::string,std::map<unsigned long,Detector> >dets=std::map<std::string,std::map<unsigned long,Detector> >{});
 	
 	inline std::map<std::string, std::map<unsigned long,Detector*> >* GetDetectors(){return &Detectors;}
+	inline std::map<unsigned long,Paddle>* GetPaddles(){return &Paddles;}
 	inline double GetVersion(){return Version;}
 	inline geostatus GetStatus(){return Status;}
 	inline Position GetTankCentre(){return tank_centre;}
@@ -56,6 +81,7 @@ class Geometry : public SerialisableObject{
 	inline void SetMrdDepth(double mrd_depthIn){mrd_depth = mrd_depthIn;}
 	inline void SetMrdStart(double mrd_startIn){mrd_start = mrd_startIn;}
 	void SetDetectors(std::map<std::string,std::map<unsigned long,Detector> >DetectorsIn){
+		ClearLookupTables();
 		RealDetectors = DetectorsIn;  // copy them in; we want to own our detectors
 		// although if we're going to use this, we may wish to provide a method for passing in
 		// detectors on the heap and taking ownership of them to avoid the copy.. TODO
@@ -129,6 +155,8 @@ class Geometry : public SerialisableObject{
 			DetectorKeys.emplace(detin.GetDetectorID(),1);
 		}
 		
+		ClearLookupTables();
+		
 		// Pass a pointer to it's owning geometry to this Detector
 		// we need to do this before calling `emplace` as that must do a copy-construction
 		detin.SetGeometryPtr(this);
@@ -161,6 +189,36 @@ class Geometry : public SerialisableObject{
 	}
 	void InitChannelMap();
 	
+	// Dense lookup tables indexed by DetectorKey and ChannelKey, built from the
+	// detector maps on first use and cleared whenever a Detector is added.
+	// Keys with no Detector/Channel return nullptr.
+	void BuildLookupTables();
+	void ClearLookupTables();
+	inline const DetectorInfo* GetDetectorInfo(unsigned long DetectorKey){
+		if(!lookup_tables_built) BuildLookupTables();
+		if(DetectorKey>=DetectorInfos.size() || !DetectorInfos[DetectorKey].valid) return nullptr;
+		return &DetectorInfos[DetectorKey];
+	}
+	inline const ChannelInfo* GetChannelInfo(unsigned long ChannelKey){
+		if(!lookup_tables_built) BuildLookupTables();
+		if(ChannelKey>=ChannelInfos.size() || !ChannelInfos[ChannelKey].valid) return nullptr;
+		return &ChannelInfos[ChannelKey];
+	}
+	// whole arrays, for tools that loop over all channels
+	inline const std::vector<DetectorInfo>& GetDetectorInfos(){
+		if(!lookup_tables_built) BuildLookupTables();
+		return DetectorInfos;
+	}
+	inline const std::vector<ChannelInfo>& GetChannelInfos(){
+		if(!lookup_tables_built) BuildLookupTables();
+		return ChannelInfos;
+	}
+	// names of the detector sets ("Tank", "MRD", "Veto", "LAPPD"...), as indexed by DetectorInfo/ChannelInfo::element
+	inline const std::vector<std::string>& GetDetectorElements(){
+		if(!lookup_tables_built) BuildLookupTables();
+		return DetectorElements;
+	}
+	
 	int GetNumDetectorsInSet(std::string SetName){
 		if(Detectors.count(SetName)==0){
 			return 0;
@@ -287,6 +345,14 @@ class Geometry : public SerialisableObject{
 	std::map<std::string,std::map<unsigned long,Detector>> RealDetectors;
 	std::map<std::string,std::map<unsigned long,Detector*>> Detectors;
 	std::map<unsigned long, Paddle> Paddles;
+	// dense lookup tables; not serialised, rebuilt on first use
+	bool lookup_tables_built=false;
+	std::vector<DetectorInfo> DetectorInfos;
+	std::vector<ChannelInfo> ChannelInfos;
+	std::vector<Detector*> DetectorsByKey;
+	std::vector<Detector*> DetectorsByChannelKey;
+	std::vector<Channel*> ChannelsByKey;
+	std::vector<std::string> DetectorElements;
 	double Version;
 	geostatus Status;
 	Position tank_centre;
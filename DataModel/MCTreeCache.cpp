@@ -0,0 +1,18 @@
+#include "MCTreeCache.h"
+
+#include "TTree.h"
+
+namespace mctreecache{
+
+	bool Configure(TTree* tree, const Config& config){
+		if(tree==nullptr) return false;
+		if(config.cache_bytes<=0 && config.learn_entries<=0 && !config.parallel_unzip) return true;
+
+		// the unzip mode is picked up when the cache is created, so set it first
+		if(config.parallel_unzip) tree->SetParallelUnzip(kTRUE);
+		if(config.cache_bytes>0 && tree->SetCacheSize(config.cache_bytes)<0) return false;
+		// no AddBranchToCache: the cache picks up the branches read while learning
+		if(config.learn_entries>0) tree->SetCacheLearnEntries(config.learn_entries);
+		return true;
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef MCTREECACHE_H
+#define MCTREECACHE_H
+
+class TTree;
+
+// Read cache setup shared by the MC input tools (LoadWCSim, LoadGenieEvent).
+// The TTreeCache learns which branches are actually read during the first
+// entries and from then on fetches the baskets of those branches for a
+// whole cluster of entries in one read. With parallel unzip enabled a
+// background thread decompresses the cached baskets ahead of GetEntry.
+namespace mctreecache{
+
+	struct Config{
+		long long cache_bytes = 0;   // 0: leave the tree's default cache
+		long long learn_entries = 0; // 0: ROOT default (100 entries)
+		bool parallel_unzip = false;
+	};
+
+	// Apply the cache settings to a TTree or TChain. Must be called again
+	// whenever a new tree is loaded from a file outside a TChain.
+	// Returns false if the cache could not be created.
+	bool Configure(TTree* tree, const Config& config);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "StoreMap.h"
+
+#include <utility>
+
+namespace {
+  // stores bound on this thread, by owning StoreMap and name
+  typedef std::map<std::pair<const StoreMap*,std::string>,BoostStore*> ThreadBindings;
+  thread_local ThreadBindings thread_bindings;
+  thread_local unsigned long thread_lookups = 0;
+}
+
+unsigned long StoreMap::ThreadLookups(){
+  return thread_lookups;
+}
+
+BoostStore** StoreMap::FindThreadStore(const std::string& name) const {
+  ++thread_lookups;
+  if(thread_bindings.empty()) return nullptr;
+  ThreadBindings::iterator it = thread_bindings.find(std::make_pair(this,name));
+  if(it==thread_bindings.end()) return nullptr;
+  return &(it->second);
+}
+
+BoostStore*& StoreMap::operator[](const std::string& name){
+  BoostStore** bound = FindThreadStore(name);
+  if(bound) return *bound;
+  return std::map<std::string,BoostStore*>::operator[](name);
+}
+
+BoostStore*& StoreMap::at(const std::string& name){
+  BoostStore** bound = FindThreadStore(name);
+  if(bound) return *bound;
+  return std::map<std::string,BoostStore*>::at(name);
+}
+
+BoostStore* const& StoreMap::at(const std::string& name) const {
+  BoostStore** bound = FindThreadStore(name);
+  if(bound) return *bound;
+  return std::map<std::string,BoostStore*>::at(name);
+}
+
+void StoreMap::BindThreadStore(const std::string& name, BoostStore* store){
+  thread_bindings[std::make_pair(static_cast<const StoreMap*>(this),name)] = store;
+}
+
+void StoreMap::UnbindThreadStore(const std::string& name){
+  thread_bindings.erase(std::make_pair(static_cast<const StoreMap*>(this),name));
+}
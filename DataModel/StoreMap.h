@@ -0,0 +1,40 @@
+#ifndef STOREMAP_H
+#define STOREMAP_H
+
+#include <map>
+#include <string>
+
+class BoostStore;
+
+/**
+ * \class StoreMap
+ *
+ * The map of named BoostStores held by the DataModel. It behaves as a
+ * std::map, except that a store can be rebound by name for the calling
+ * thread only: while a binding is in place, operator[] and at() on that
+ * thread return the bound store instead of the one in the map. This is what
+ * lets the PipelineToolChain give every event in flight its own ANNIEEvent
+ * while all tools keep using m_data->Stores["ANNIEEvent"].
+ */
+class StoreMap : public std::map<std::string,BoostStore*> {
+
+ public:
+
+  BoostStore*& operator[](const std::string& name);
+  BoostStore*& at(const std::string& name);
+  BoostStore* const& at(const std::string& name) const;
+
+  /// Make name resolve to store on the calling thread until it is unbound
+  void BindThreadStore(const std::string& name, BoostStore* store);
+  void UnbindThreadStore(const std::string& name);
+
+  /// Number of operator[] and at() calls made on the calling thread, on any StoreMap
+  static unsigned long ThreadLookups();
+
+ private:
+
+  BoostStore** FindThreadStore(const std::string& name) const;
+
+};
+
+#endif
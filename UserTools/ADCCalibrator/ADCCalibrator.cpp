@@ -2,9 +2,12 @@
 
 // ToolAnalysis includes
 #include "ADCCalibrator.h"
+#include "ToolRegistry.h"
 #include "ANNIEalgorithms.h"
 #include "ANNIEconstants.h"
 
+REGISTER_TOOL(ADCCalibrator);
+
 ADCCalibrator::ADCCalibrator() : Tool() {}
 
 bool ADCCalibrator::Initialise(std::string config_filename, DataModel& data)
@@ -6,11 +6,14 @@
 
 // ToolAnalysis includes
 #include "ADCHitFinder.h"
+#include "ToolRegistry.h"
 #include "ADCPulse.h"
 #include "ANNIEconstants.h"
 #include "CalibratedADCWaveform.h"
 #include "Waveform.h"
 
+REGISTER_TOOL(ADCHitFinder);
+
 ADCHitFinder::ADCHitFinder() : Tool() {}
 
 bool ADCHitFinder::Initialise(std::string config_filename, DataModel& data) {
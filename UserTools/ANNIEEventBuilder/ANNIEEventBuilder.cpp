@@ -1,4 +1,7 @@
 #include "ANNIEEventBuilder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ANNIEEventBuilder);
 
 ANNIEEventBuilder::ANNIEEventBuilder():Tool(){}
 
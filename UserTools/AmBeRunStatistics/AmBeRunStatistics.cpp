@@ -1,4 +1,7 @@
 #include "AmBeRunStatistics.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(AmBeRunStatistics);
 
 AmBeRunStatistics::AmBeRunStatistics():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "ApplyMRDEff.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ApplyMRDEff);
 
 ApplyMRDEff::ApplyMRDEff():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "AssignBunchTimingMC.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(AssignBunchTimingMC);
 
 AssignBunchTimingMC::AssignBunchTimingMC():Tool(){}
 
@@ -1,4 +1,9 @@
 #include "BackTracker.h"
+#include "ToolRegistry.h"
+
+#include <algorithm>
+
+REGISTER_TOOL(BackTracker);
 
 BackTracker::BackTracker():Tool(){}
 
@@ -51,12 +56,12 @@ bool BackTracker::Execute()
   fClusterPurity           ->clear();
   fClusterTotalCharge      ->clear();
 
-  fParticleToTankTotalCharge.clear();
+  BuildParticleIndex();
   SumParticleTankCharge();
 
   
   // Loop over the clusters and do the things
-  for (std::pair<double, std::vector<MCHit>>&& apair : *fClusterMapMC) {
+  for (const auto &apair : *fClusterMapMC) {
     int prtId = -5;
     int prtPdg = -5;
     double eff = -5;
@@ -88,29 +93,48 @@ bool BackTracker::Finalise()
   return true;
 }
 
+//------------------------------------------------------------------------------
+void BackTracker::BuildParticleIndex()
+{
+  // Invert the particle Id -> MCParticles index map. If two Ids point to the
+  // same particle the larger Id wins, as it did with the old linear search
+  size_t nIdxs = fMCParticles->size();
+  for (const auto &it : *fMCParticleIndexMap) {
+    if (it.second >= (int)nIdxs) nIdxs = it.second + 1;
+  }
+
+  fIndexToParticleId.assign(nIdxs, -5);
+  for (const auto &it : *fMCParticleIndexMap) {
+    if (it.second >= 0) fIndexToParticleId[it.second] = it.first;
+  }
+
+  fIndexToTankCharge.assign(nIdxs, 0.);
+  fIndexToClusterCharge.assign(nIdxs, 0.);
+  fClusterParticleIdxs.clear();
+}
+
+//------------------------------------------------------------------------------
+int BackTracker::ParentParticleIndex(MCHit const &mchit) const
+{
+  // technically a MCHit could have multiple parents, but they don't appear to in practice
+  // skip any cases we come across
+  const std::vector<int> &parentIdxs = *(mchit.GetParents());
+  if (parentIdxs.size() != 1) return -1;
+
+  int parentIdx = parentIdxs[0];
+  if (parentIdx < 0 || parentIdx >= (int)fIndexToParticleId.size()) return -1;
+  if (fIndexToParticleId[parentIdx] == -5) return -1;
+  return parentIdx;
+}
+
 //------------------------------------------------------------------------------
 void BackTracker::SumParticleTankCharge()
 {
-  for (auto mcHitsIt : *fMCHitsMap) {
-    std::vector<MCHit> mcHits = mcHitsIt.second;
-    for (uint mcHitIdx = 0; mcHitIdx < mcHits.size(); ++mcHitIdx) {
-
-      // technically a MCHit could have multiple parents, but they don't appear to in practice
-      // skip any cases we come across
-      std::vector<int> parentIdxs = *(mcHits[mcHitIdx].GetParents());
-      if (parentIdxs.size() != 1) continue;
-      
-      int particleId = -5;
-      for (auto it : *fMCParticleIndexMap) {
-	if (it.second == parentIdxs[0]) particleId = it.first;
-      }
-      if (particleId == -5) continue;
-	
-      double depositedCharge = mcHits[mcHitIdx].GetCharge();      
-      if (!fParticleToTankTotalCharge.count(particleId)) 
-	fParticleToTankTotalCharge.emplace(particleId, depositedCharge);
-      else 
-	fParticleToTankTotalCharge.at(particleId) += depositedCharge;
+  for (const auto &mcHitsIt : *fMCHitsMap) {
+    for (const MCHit &mchit : mcHitsIt.second) {
+      int parentIdx = ParentParticleIndex(mchit);
+      if (parentIdx < 0) continue;
+      fIndexToTankCharge[parentIdx] += mchit.GetCharge();
     }    
   }
 }
@@ -120,47 +144,52 @@ void BackTracker::MatchMCParticle(std::vector<MCHit> const &mchits, int &prtId,
 {
   // Loop over the hits and get all of their parents and the energy that each one contributed
   //  be sure to bunch up all neutronic contributions
-  std::map<int, double> mapParticleToTotalClusterCharge;
   totalCharge = 0;
 
-  for (auto mchit : mchits) {    
-    std::vector<int> parentIdxs = *(mchit.GetParents());
-    if (parentIdxs.size() != 1) {
-      logmessage = "BackTracker::MatchMCParticle: this MCHit has ";
-      logmessage += std::to_string(parentIdxs.size()) + " parents!";
-      Log(logmessage, v_debug, verbosity);
+  for (const MCHit &mchit : mchits) {    
+    int parentIdx = ParentParticleIndex(mchit);
+    if (parentIdx < 0) {
+      if (mchit.GetParents()->size() != 1) {
+        logmessage = "BackTracker::MatchMCParticle: this MCHit has ";
+        logmessage += std::to_string(mchit.GetParents()->size()) + " parents!";
+        Log(logmessage, v_debug, verbosity);
+      }
       continue;
     }
     
-    int particleId = -5;
-    for (auto it : *fMCParticleIndexMap) {
-      if (it.second == parentIdxs[0]) particleId = it.first;
-    }
-    if (particleId == -5) continue;
-    
     double depositedCharge = mchit.GetCharge();
     totalCharge += depositedCharge;
-    
-    if (mapParticleToTotalClusterCharge.count(particleId) == 0) 
-      mapParticleToTotalClusterCharge.emplace(particleId, depositedCharge);
-    else
-      mapParticleToTotalClusterCharge[particleId] += depositedCharge;    
+
+    fIndexToClusterCharge[parentIdx] += depositedCharge;
+    fClusterParticleIdxs.push_back(parentIdx);
   }       
 
+  // Ties go to the smallest particleId, so visit the particles in Id order.
+  // Every index has its own Id, so duplicates end up next to each other
+  std::sort(fClusterParticleIdxs.begin(), fClusterParticleIdxs.end(),
+	    [this](int a, int b) { return fIndexToParticleId[a] < fIndexToParticleId[b]; });
+  fClusterParticleIdxs.erase(std::unique(fClusterParticleIdxs.begin(), fClusterParticleIdxs.end()),
+			     fClusterParticleIdxs.end());
+
   // Loop over the particleIds to find the primary contributer to the cluster
   double maxCharge = 0;
-  for (auto apair : mapParticleToTotalClusterCharge) {
-    if (apair.second > maxCharge) {
-      maxCharge = apair.second;
-      prtId = apair.first;
+  int prtIdx = -1;
+  for (int idx : fClusterParticleIdxs) {
+    if (fIndexToClusterCharge[idx] > maxCharge) {
+      maxCharge = fIndexToClusterCharge[idx];
+      prtIdx = idx;
+      prtId = fIndexToParticleId[idx];
     }
+    // reset the scratch space for the next cluster
+    fIndexToClusterCharge[idx] = 0.;
   }
+  fClusterParticleIdxs.clear();
 
   // Check that we have some charge, if not then something is wrong so pass back all -5
   if (totalCharge > 0) {
-    eff = maxCharge/fParticleToTankTotalCharge.at(prtId);
+    eff = maxCharge/fIndexToTankCharge.at(prtIdx);
     pur = maxCharge/totalCharge;
-    prtPdg = (fMCParticles->at(fMCParticleIndexMap->at(prtId))).GetPdgCode();
+    prtPdg = (fMCParticles->at(prtIdx)).GetPdgCode();
   } else {
     prtId = -5;
     eff = -5;
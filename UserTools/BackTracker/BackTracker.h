@@ -29,6 +29,8 @@ class BackTracker: public Tool {
   bool Finalise(); ///< Finalise function used to clean up resources.
 
   bool LoadFromStores(); ///< Does all the loading so I can move it away from the Execute function
+  void BuildParticleIndex(); ///< Invert TrackId_to_MCParticleIndex once per event
+  int  ParentParticleIndex(MCHit const &mchit) const; ///< MCParticle index of the hit's parent, or -1 if it can't be matched
   void SumParticleTankCharge();
   void MatchMCParticle(std::vector<MCHit> const &mchits, int &prtId, int &prtPdg, double &eff, double &pur, double &totalCharge); ///< The meat and potatoes
   
@@ -40,10 +42,15 @@ class BackTracker: public Tool {
   std::vector<MCParticle>                     *fMCParticles = nullptr;        ///< The true particles from the event
   std::map<int, int>                          *fMCParticleIndexMap = nullptr; ///< Map between the particle Id and it's position in MCParticles vector
 
-  // We'll calculate this map from MCHit parent particle to the total charge deposited throughout the tank
-  // technically a MCHit could have multiple parents, but they don't appear to in practice
-  // the key is particle Id and value is total tank charge
-  std::map<int, double> fParticleToTankTotalCharge; 
+  // Flat per-event lookup tables, indexed by position in the MCParticles vector
+  //   the particle Id at that position (-5 if no Id points to it)
+  //   the total charge deposited by that particle throughout the tank
+  //     (technically a MCHit could have multiple parents, but they don't appear to in practice)
+  //   scratch space for the charge of each particle in the current cluster
+  std::vector<int>    fIndexToParticleId;
+  std::vector<double> fIndexToTankCharge;
+  std::vector<double> fIndexToClusterCharge;
+  std::vector<int>    fClusterParticleIdxs; ///< particles with charge in the current cluster
     
   // We'll save out maps between the local cluster time and
   //   the ID and PDG of the particle that contributed the most energy
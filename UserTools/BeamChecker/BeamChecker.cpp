@@ -7,6 +7,7 @@
 // ToolAnalysis includes
 //#include "ANNIEconstants.h"
 #include "BeamChecker.h"
+#include "ToolRegistry.h"
 //#include "BeamDataPoint.h"
 //#include "BeamStatus.h"
 //#include "HeftyInfo.h"
@@ -26,6 +27,8 @@ namespace {
 
 }
 
+REGISTER_TOOL(BeamChecker);
+
 BeamChecker::BeamChecker() : Tool(),
   beam_db_store_(false, BOOST_STORE_MULTIEVENT_FORMAT)
 {}
@@ -1,4 +1,7 @@
 #include "BeamClusterPlots.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(BeamClusterPlots);
 
 BeamClusterPlots::BeamClusterPlots():Tool(){}
 
@@ -1,4 +1,5 @@
 #include "BeamDecoder.h"
+#include "ToolRegistry.h"
 
 //Definitions local to this source file
 namespace {
@@ -14,6 +15,8 @@ namespace {
 
 }
 
+REGISTER_TOOL(BeamDecoder);
+
 BeamDecoder::BeamDecoder():Tool(),
 beam_db_store_(false, BOOST_STORE_MULTIEVENT_FORMAT)
 {}
@@ -38,9 +41,28 @@ bool BeamDecoder::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("SecondToroid", second_toroid);
   m_variables.Get("HornCurrentDevice", horn_current_device);
 
+  // Get beam quality cut parameters
+  pot_min_ = BOGUS_DOUBLE;
+  pot_max_ = BOGUS_DOUBLE;
+  m_variables.Get("CutPOTMax", pot_max_);
+  m_variables.Get("CutPOTMin", pot_min_);
+
+  horn_current_min_ = BOGUS_DOUBLE;
+  horn_current_max_ = BOGUS_DOUBLE;
+  m_variables.Get("CutPeakHornCurrentMax", horn_current_max_);
+  m_variables.Get("CutPeakHornCurrentMin", horn_current_min_);
+
+  toroid_tol_ = BOGUS_DOUBLE;
+  m_variables.Get("CutToroidAgreement", toroid_tol_);
+
+  t_tol_ = BOGUS_INT;
+  m_variables.Get("CutTimestampAgreement", t_tol_);
+
   BeamStatusMap = new std::map<uint64_t,BeamStatus>;
 
   first_entry = true;
+  current_beam_db_entry_ = 0;
+  got_first_beam_entry_ = false;
 
   m_data->CStore.Set("NewBeamDataAvailable",false);
 
@@ -138,6 +160,7 @@ bool BeamDecoder::initialise_beam_db(){
       verbosity_);
     return false;
   }
+  beam_db_intervals_.Fill(beam_db_index_);
 
   bool got_start = beam_db_store_.Header->Get("StartMillisecondsSinceEpoch",
     start_ms_since_epoch_);
@@ -190,15 +213,9 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
       BeamCondition::NonBeamMinibuffer);
   }
 
-  static std::map<std::string, std::map<uint64_t, BeamDataPoint> >
-    beam_data;
-  static int current_beam_db_entry = 0;
-  static bool got_first_beam_entry = false;
-
-  if ( !got_first_beam_entry ) {
-    beam_db_store_.GetEntry(current_beam_db_entry);
-    beam_db_store_.Get("BeamDB", beam_data);
-    got_first_beam_entry = true;
+  if ( !got_first_beam_entry_ ) {
+    load_beam_db_entry(current_beam_db_entry_);
+    got_first_beam_entry_ = true;
   }
 
   // The beam database uses timestamps with ms precision
@@ -210,22 +227,12 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
   // Find the beam database entry that contains POT information for the
   // moment of interest
   
-  auto iter = std::find_if(beam_db_index_.cbegin(),
-    beam_db_index_.cend(),
-    [ms_since_epoch](const std::pair<int, std::pair<uint64_t,
-      uint64_t> >& pair) -> bool {
-      uint64_t start_ms = pair.second.first;
-      uint64_t end_ms = pair.second.second;
-      return ms_since_epoch >= start_ms && ms_since_epoch <= end_ms;
-    }
-  );
+  int new_entry_number = beam_db_intervals_.Find(ms_since_epoch);
 
   // If a suitable entry could not be found, then complain and return
   // a BeamStatus object that indicates that the data were missing
- 
-  bool found_pot_entry = ( iter != beam_db_index_.cend() );
 
-  if ( !found_pot_entry ) {
+  if ( new_entry_number < 0 ) {
     Log("BeamDecoder tool: WARNING: unable to find a suitable entry for "
       + make_time_string(ms_since_epoch) + " (" + std::to_string(ms_since_epoch)
       + " ms since the Unix epoch) in the beam database file", 0, verbosity_);
@@ -236,13 +243,8 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
   // Avoid loading a new entry if you don't have to (the maps stored in
   // each entry are fairly large)   
 
-  int new_entry_number = iter->first;
-  if ( new_entry_number != current_beam_db_entry ) {
-
-    beam_db_store_.GetEntry(new_entry_number);
-    beam_db_store_.Get("BeamDB", beam_data);
-
-    current_beam_db_entry = new_entry_number;
+  if ( new_entry_number != current_beam_db_entry_ ) {
+    load_beam_db_entry(new_entry_number);
   }
 
   // Temporary storage for this function's return value
@@ -254,45 +256,21 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
 
       // Retrieve a measurement for each of the monitoring devices included
       // in the bundle from the Intensity Frontier beam database
-      for (const auto& device_pair : beam_data) {
-        const std::string& device_name = device_pair.first;
-
-      // Obtain a map of measurements for the current device.
-      // Keys are timestamps (in ms since the Unix epoch),
-      // while values are BeamDataPoint objects.
-      const std::map<uint64_t, BeamDataPoint>& measurement_map
-        = device_pair.second;
+      for (size_t device_id = 0; device_id < beam_conditions_.NumDevices(); ++device_id) {
 
       // Find the measurement entry with the closest time to that requested by
       // the user, and add it to the BeamStatus object that will be returned
-      std::map<uint64_t, BeamDataPoint>::const_iterator
-      low = measurement_map.lower_bound(ms_since_epoch);
+      long closest = beam_conditions_.FindClosest(device_id, ms_since_epoch);
 
-      if ( low == measurement_map.cend() ) {
+      if ( closest < 0 ) {
         Log("BeamDecoder tool: WARNING: IF beam database did not have any information"
-          " for device " + device_name + " at " + std::to_string(ms_since_epoch)
-          + " ms after the Unix epoch (" + make_time_string(ms_since_epoch)
-          + ')', 1, verbosity_);
-      }
-
-      else if ( low == measurement_map.cbegin() ) {
-        beam_status.add_measurement(device_name, low->first, low->second );
+          " for device " + beam_conditions_.DeviceName(device_id) + " at "
+          + std::to_string(ms_since_epoch) + " ms after the Unix epoch ("
+          + make_time_string(ms_since_epoch) + ')', 1, verbosity_);
       }
-
-      // We're between two time values, so we need to figure out which is
-      // closest to the value requested by the user
       else {
-
-        std::map<uint64_t, BeamDataPoint>::const_iterator
-          prev = low;
-        --prev;
-
-        if ((ms_since_epoch - prev->first) < (low->first - ms_since_epoch)) {
-          beam_status.add_measurement(device_name, prev->first, prev->second);
-        }
-        else {
-          beam_status.add_measurement(device_name, low->first, low->second);
-        }
+        beam_status.add_measurement(beam_conditions_.DeviceName(device_id),
+          beam_conditions_.Time(closest), beam_conditions_.Point(closest));
       }
     }
 
@@ -331,47 +309,30 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
 
     // Wait to set the beam condition until we've applied quality cuts
 
-    // Get beam quality cut parameters
-    double pot_min = BOGUS_DOUBLE;
-    double pot_max = BOGUS_DOUBLE;
-    m_variables.Get("CutPOTMax", pot_max);
-    m_variables.Get("CutPOTMin", pot_min);
-
-    double horn_current_min = BOGUS_DOUBLE;
-    double horn_current_max = BOGUS_DOUBLE;
-    m_variables.Get("CutPeakHornCurrentMax", horn_current_max);
-    m_variables.Get("CutPeakHornCurrentMin", horn_current_min);
-
-    double toroid_tol = BOGUS_DOUBLE;
-    m_variables.Get("CutToroidAgreement", toroid_tol);
-
-    int64_t t_tol = BOGUS_INT;
-    m_variables.Get("CutTimestampAgreement", t_tol);
-
     // TODO: add beam targeting efficiency cut
     BeamCondition bc = BeamCondition::Ok;
 
     // POT cut
-    beam_status.add_cut("POT in range", (beam_status.pot() >= pot_min)
-      && (beam_status.pot() <= pot_max));
+    beam_status.add_cut("POT in range", (beam_status.pot() >= pot_min_)
+      && (beam_status.pot() <= pot_max_));
     
     // Peak horn current cut
     beam_status.add_cut("peak horn current in range",
-      (peak_horn_current >= horn_current_min)
-      && (peak_horn_current <= horn_current_max));
+      (peak_horn_current >= horn_current_min_)
+      && (peak_horn_current <= horn_current_max_));
 
     // Toroid disagreement cut
     double tor_diff_frac = 2.*std::abs( pot_second_toroid - pot_first_toroid )
       / ( pot_second_toroid + pot_first_toroid );
-    beam_status.add_cut("toroids agree", tor_diff_frac <= toroid_tol);
+    beam_status.add_cut("toroids agree", tor_diff_frac <= toroid_tol_);
 
     // Timestamp cut. Make sure measurements within the timing tolerance
     // were available for all required devices
     int64_t ms_since_epoch = static_cast<int64_t>( ns_since_epoch / MILLION );
     beam_status.add_cut("timestamps agree",
-      ( std::abs(ms_since_epoch_horn - ms_since_epoch) <= t_tol )
-      &&  ( std::abs(ms_since_epoch_first_toroid - ms_since_epoch) <= t_tol )
-      &&  ( std::abs(ms_since_epoch_second_toroid - ms_since_epoch) <= t_tol ));
+      ( std::abs(ms_since_epoch_horn - ms_since_epoch) <= t_tol_ )
+      &&  ( std::abs(ms_since_epoch_first_toroid - ms_since_epoch) <= t_tol_ )
+      &&  ( std::abs(ms_since_epoch_second_toroid - ms_since_epoch) <= t_tol_ ));
 
     Log("BeamDecoder tool: ANNIE DAQ ms since epoch = " + std::to_string(ms_since_epoch), 4,
       verbosity_);
@@ -412,3 +373,13 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
 
   return beam_status;
 }
+
+void BeamDecoder::load_beam_db_entry(int entry_number){
+
+  std::map<std::string, std::map<uint64_t, BeamDataPoint> > beam_data;
+  beam_db_store_.GetEntry(entry_number);
+  beam_db_store_.Get("BeamDB", beam_data);
+  beam_conditions_.Fill(beam_data);
+
+  current_beam_db_entry_ = entry_number;
+}
@@ -13,6 +13,7 @@
 #include "MinibufferLabel.h"
 #include "ANNIEconstants.h"
 #include "BeamDataPoint.h"
+#include "BeamConditionsIndex.h"
 #include "TimeClass.h"
 
 
@@ -58,6 +59,24 @@ class BeamDecoder: public Tool {
   uint64_t start_ms_since_epoch_;
   uint64_t end_ms_since_epoch_;
 
+  // Lookup of the beam database entry covering a given time
+  BeamIntervalIndex beam_db_intervals_;
+
+  // Measurements of the currently loaded beam database entry
+  BeamConditionsIndex beam_conditions_;
+  int current_beam_db_entry_;
+  bool got_first_beam_entry_;
+
+  // Beam quality cut parameters
+  double pot_min_;
+  double pot_max_;
+  double horn_current_min_;
+  double horn_current_max_;
+  double toroid_tol_;
+  int64_t t_tol_;
+
+  void load_beam_db_entry(int entry_number);
+
 };
 
 
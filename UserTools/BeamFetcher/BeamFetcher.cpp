@@ -4,6 +4,7 @@
 
 // ToolAnalysis includes
 #include "BeamFetcher.h"
+#include "ToolRegistry.h"
 #include "IFBeamDBInterface.h"
 
 namespace {
@@ -11,6 +12,8 @@ namespace {
   constexpr uint64_t THIRTY_SECONDS = 30000ull; // ms
 }
 
+REGISTER_TOOL(BeamFetcher);
+
 BeamFetcher::BeamFetcher() : Tool(),
   beam_db_store_(false, BOOST_STORE_MULTIEVENT_FORMAT)
 {}
@@ -0,0 +1,171 @@
+// standard library includes
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+// ToolAnalysis includes
+#include "BeamDBCache.h"
+#include "IFBeamDBInterfaceV2.h"
+
+namespace {
+  // Data for the most recent hour may still be arriving in the database,
+  // so responses for chunks that end later than this are not stored
+  constexpr uint64_t ONE_HOUR = 3600000ull; // ms
+
+  uint64_t NowMSec() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+}
+
+BeamDBCache::BeamDBCache(const std::string& cache_directory, bool is_bundle,
+  int num_workers, size_t max_pending)
+  : fCacheDirectory(cache_directory), fIsBundle(is_bundle),
+  fMaxPending(max_pending)
+{
+  if (num_workers < 1) num_workers = 1;
+  for (int i = 0; i < num_workers; ++i) {
+    fWorkers.emplace_back(&BeamDBCache::WorkerLoop, this);
+  }
+}
+
+BeamDBCache::~BeamDBCache()
+{
+  {
+    std::lock_guard<std::mutex> lock(fQueueMutex);
+    fStopping = true;
+    // nobody is going to ask for these any more
+    fQueue.clear();
+  }
+  fQueueCV.notify_all();
+  for (auto& worker : fWorkers) worker.join();
+}
+
+//------------------------------------------------------------------------------
+void BeamDBCache::WorkerLoop()
+{
+  while (true) {
+    std::packaged_task<std::string()> download;
+    {
+      std::unique_lock<std::mutex> lock(fQueueMutex);
+      fQueueCV.wait(lock, [this]{ return fStopping || !fQueue.empty(); });
+      if (fStopping) return;
+      download = std::move(fQueue.front());
+      fQueue.pop_front();
+    }
+    // exceptions are kept in the future and rethrown by Get
+    download();
+  }
+}
+
+//------------------------------------------------------------------------------
+std::string BeamDBCache::Get(const std::string& name, uint64_t t0, uint64_t t1)
+{
+  std::string key = this->Key(name, t0, t1);
+
+  // Prefetched chunks that end before this one will not be asked for again.
+  // If they are still queued or running, their result is simply discarded.
+  for (auto it = fPending.begin(); it != fPending.end(); ) {
+    if (it->second.t1 <= t0) it = fPending.erase(it);
+    else ++it;
+  }
+
+  auto pending = fPending.find(key);
+  if (pending != fPending.end()) {
+    std::shared_future<std::string> download = pending->second.response;
+    fPending.erase(pending);
+    ++fQueries;
+    // rethrows the exception if the download failed
+    return download.get();
+  }
+
+  std::string response;
+  if (this->ReadFile(key, response)) {
+    ++fCacheHits;
+    return response;
+  }
+
+  ++fQueries;
+  return this->Fetch(name, t0, t1);
+}
+
+//------------------------------------------------------------------------------
+void BeamDBCache::Prefetch(const std::string& name, uint64_t t0, uint64_t t1)
+{
+  std::string key = this->Key(name, t0, t1);
+  if (fPending.count(key) || fPending.size() >= fMaxPending) return;
+
+  if (!fCacheDirectory.empty()) {
+    std::ifstream cached(this->FileName(key));
+    if (cached.good()) return;
+  }
+
+  std::packaged_task<std::string()> download(
+    [this, name, t0, t1]{ return this->Fetch(name, t0, t1); });
+  fPending[key] = {t1, download.get_future().share()};
+  {
+    std::lock_guard<std::mutex> lock(fQueueMutex);
+    fQueue.push_back(std::move(download));
+  }
+  fQueueCV.notify_one();
+}
+
+//------------------------------------------------------------------------------
+std::string BeamDBCache::Fetch(const std::string& name, uint64_t t0,
+  uint64_t t1) const
+{
+  const auto& db = IFBeamDBInterfaceV2::Instance();
+  std::string response = (fIsBundle) ? db.FetchBeamDBBundleSpan(name, t0, t1)
+    : db.FetchBeamDBSingleSpan(name, t0, t1);
+  this->WriteFile(this->Key(name, t0, t1), t1, response);
+  return response;
+}
+
+//------------------------------------------------------------------------------
+std::string BeamDBCache::Key(const std::string& name, uint64_t t0,
+  uint64_t t1) const
+{
+  // Device names like E:TOR875 are turned into something usable as a file name
+  std::string key = name;
+  for (auto& c : key) if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+  return key + "_" + std::to_string(t0) + "_" + std::to_string(t1) + ".csv";
+}
+
+std::string BeamDBCache::FileName(const std::string& key) const
+{
+  return fCacheDirectory + "/" + key;
+}
+
+//------------------------------------------------------------------------------
+bool BeamDBCache::ReadFile(const std::string& key, std::string& response) const
+{
+  if (fCacheDirectory.empty()) return false;
+  std::ifstream infile(this->FileName(key), std::ios::binary);
+  if (!infile.good()) return false;
+
+  std::ostringstream contents;
+  contents << infile.rdbuf();
+  response = contents.str();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void BeamDBCache::WriteFile(const std::string& key, uint64_t t1,
+  const std::string& response) const
+{
+  if (fCacheDirectory.empty() || t1 + ONE_HOUR > NowMSec()) return;
+
+  // Write to a temporary file first so that other jobs sharing the cache
+  // directory never see a partially written response
+  std::string filename = this->FileName(key);
+  std::string tmpname = filename + ".tmp" + std::to_string(getpid());
+  std::ofstream outfile(tmpname, std::ios::binary | std::ios::trunc);
+  outfile.write(response.data(), response.size());
+  outfile.close();
+  if (outfile.good()) std::rename(tmpname.c_str(), filename.c_str());
+  else std::remove(tmpname.c_str());
+}
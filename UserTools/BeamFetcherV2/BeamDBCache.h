@@ -0,0 +1,96 @@
+// Cache of raw Intensity Frontier beam database responses used by the
+// BeamFetcherV2 tool. Responses are stored per device (or bundle) and time
+// chunk in a directory on disk, so that reprocessing the same runs does not
+// have to query the database again, and upcoming chunks can be downloaded
+// on a small pool of worker threads while the current one is being matched
+// to triggers.
+
+#pragma once
+
+// standard library includes
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class BeamDBCache {
+
+  public:
+
+    /// @brief Create the cache
+    /// @param cache_directory Directory holding the cached responses. If it
+    /// is empty, responses are only kept in memory until they are used.
+    /// @param is_bundle Whether the names passed to Get and Prefetch are
+    /// bundles rather than individual devices
+    /// @param num_workers Number of threads downloading prefetched responses
+    /// @param max_pending Most downloads started by Prefetch that have not
+    /// been taken by Get yet. Prefetch does nothing while there are as many.
+    BeamDBCache(const std::string& cache_directory, bool is_bundle,
+      int num_workers = 4, size_t max_pending = 64);
+
+    /// @brief Drops the downloads that have not started and waits for the
+    /// running ones
+    ~BeamDBCache();
+
+    /// @brief Get the database response for a device or bundle in the time
+    /// interval [t0, t1] (milliseconds since the Unix epoch). It is taken
+    /// from a finished prefetch or from disk if possible, otherwise the
+    /// database is queried. Requests come in time order, so prefetched
+    /// responses that end before t0 are dropped.
+    /// @note Throws std::runtime_error if the database query fails
+    std::string Get(const std::string& name, uint64_t t0, uint64_t t1);
+
+    /// @brief Queue the response for a device or bundle in the time interval
+    /// [t0, t1] for download on a worker thread, unless it is cached on disk,
+    /// already queued, or max_pending downloads are already waiting for Get
+    void Prefetch(const std::string& name, uint64_t t0, uint64_t t1);
+
+    /// @brief Number of responses read from disk and downloaded so far
+    inline int NumCacheHits() const { return fCacheHits; }
+    inline int NumQueries() const { return fQueries; }
+    /// @brief Number of prefetched responses not taken by Get yet
+    inline size_t NumPending() const { return fPending.size(); }
+
+  protected:
+
+    /// @brief Query the database and store the response on disk. Called on
+    /// the worker threads, so it only touches const members.
+    std::string Fetch(const std::string& name, uint64_t t0, uint64_t t1) const;
+
+    /// @brief Run queued downloads until the cache is destroyed
+    void WorkerLoop();
+
+    std::string Key(const std::string& name, uint64_t t0, uint64_t t1) const;
+    std::string FileName(const std::string& key) const;
+    bool ReadFile(const std::string& key, std::string& response) const;
+    void WriteFile(const std::string& key, uint64_t t1,
+      const std::string& response) const;
+
+    std::string fCacheDirectory;
+    bool fIsBundle;
+
+    struct PendingDownload {
+      uint64_t t1;
+      std::shared_future<std::string> response;
+    };
+
+    /// @brief Downloads queued by Prefetch and not taken by Get, by cache
+    /// key. Only used on the calling thread.
+    std::map<std::string, PendingDownload> fPending;
+    size_t fMaxPending;
+
+    /// @brief Downloads waiting for a worker, shared with the workers
+    std::deque<std::packaged_task<std::string()> > fQueue;
+    std::mutex fQueueMutex;
+    std::condition_variable fQueueCV;
+    bool fStopping = false;
+    std::vector<std::thread> fWorkers;
+
+    int fCacheHits = 0;
+    int fQueries = 0;
+};
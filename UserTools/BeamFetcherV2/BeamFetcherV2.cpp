@@ -4,6 +4,7 @@
 
 // ToolAnalysis includes
 #include "BeamFetcherV2.h"
+#include "ToolRegistry.h"
 #include "IFBeamDBInterfaceV2.h"
 
 namespace {
@@ -11,7 +12,9 @@ namespace {
   constexpr uint64_t THIRTY_SECONDS = 30000ull; // ms
 }
 
-BeamFetcherV2::BeamFetcherV2():Tool()			     
+REGISTER_TOOL(BeamFetcherV2);
+
+BeamFetcherV2::BeamFetcherV2():Tool(), fCache(nullptr)
 {}
 
 //------------------------------------------------------------------------------
@@ -30,6 +33,12 @@ bool BeamFetcherV2::Initialise(std::string config_filename, DataModel& data)
   bool got_saveroot      = m_variables.Get("SaveROOT", fSaveROOT);
   bool got_chunkMSec     = m_variables.Get("TimeChunkStepInMilliseconds", fChunkStepMSec);
   bool got_deletectcdata = m_variables.Get("DeleteCTCData", fDeleteCTCData);
+  bool got_prefetch      = m_variables.Get("PrefetchChunks", fPrefetchChunks);
+  bool got_threads       = m_variables.Get("PrefetchThreads", fPrefetchThreads);
+  m_variables.Get("BeamCacheDirectory", fCacheDirectory);
+
+  std::string db_url;
+  if (m_variables.Get("BeamDBURL", db_url)) IFBeamDBInterfaceV2::SetServerURL(db_url);
   
   
   // Check the config parameters and set default values if necessary 
@@ -97,8 +106,17 @@ bool BeamFetcherV2::Initialise(std::string config_filename, DataModel& data)
     return 0;
   }
 
+  if (!got_prefetch || fPrefetchChunks < 0) fPrefetchChunks = 1;
+  if (!got_threads || fPrefetchThreads < 1) fPrefetchThreads = 4;
+
   if (fSaveROOT) this->SetupROOTFile();
 
+  // LoadChunk asks for the current and PrefetchChunks following chunks of
+  // every device; leave room for one more round while those are pending
+  size_t n_names = (fIsBundle) ? 1 : fDevices.size();
+  size_t max_pending = 2 * n_names * (fPrefetchChunks + 1);
+  fCache = new BeamDBCache(fCacheDirectory, fIsBundle, fPrefetchThreads, max_pending);
+
   // initialize the last timestamp
   fLastTimestampFetched = 0;
   fLastTimestampSaved = 0;
@@ -148,6 +166,15 @@ bool BeamFetcherV2::Execute()
 bool BeamFetcherV2::Finalise()
 {
   if (fSaveROOT) this->SaveROOTFile();
+
+  if (fCache) {
+    logmessage = ("Message (BeamFetcherV2): Took " + std::to_string(fCache->NumCacheHits())
+		  + " beam database responses from the cache and queried "
+		  + std::to_string(fCache->NumQueries()));
+    Log(logmessage, v_message, verbosity);
+    delete fCache;
+    fCache = nullptr;
+  }
   
   std::cout << "BeamFetcherV2 tool exitting" << std::endl;
   
@@ -157,9 +184,6 @@ bool BeamFetcherV2::Finalise()
 //------------------------------------------------------------------------------
 bool BeamFetcherV2::FetchFromTrigger()
 {
-  // Get a const reference to the beam database interface
-  const auto& db = IFBeamDBInterfaceV2::Instance();
-
   // Need to get the trigger times
   std::map<uint64_t,std::vector<uint32_t>>* TimeToTriggerWordMap=nullptr;
   bool got_triggers = m_data->CStore.Get("TimeToTriggerWordMap",TimeToTriggerWordMap);
@@ -190,28 +214,19 @@ bool BeamFetcherV2::FetchFromTrigger()
 	continue;
       }
 
-      // Check if we already have the info we need
-      bool fetch = false;
+      // The data is pulled fChunkStepMSec at a time to avoid rapid queries.
+      // Chunks are aligned to multiples of the step so that every job asks
+      // for the same chunks, which can then be reused from the cache
+      uint64_t chunk_start = trigTimestamp - trigTimestamp % fChunkStepMSec;
+      if (!fLoadedChunks.count(chunk_start) && !this->LoadChunk(chunk_start))
+	return false;
+
+      // The closest DB timestamp may be at the beginning of the next chunk
       std::map<uint64_t, std::map<std::string, BeamDataPoint> >::iterator low, prev;
       low = BeamDataQuery.lower_bound(trigTimestamp);
-      if (low == BeamDataQuery.end()) {
-	fetch = true;
-	logmessage = ("BeamFetcherV2: I'm going to query the DB");
-	Log(logmessage, v_message, verbosity);
+      if (low == BeamDataQuery.end() && !fLoadedChunks.count(chunk_start + fChunkStepMSec)) {
+	if (!this->LoadChunk(chunk_start + fChunkStepMSec)) return false;
       }
-      
-      // We'll pull fChunkStepMSec worth of data at a time to avoid rapid queries      
-      if (fetch) {
-	if (fIsBundle) {
-	  BeamDataQuery = db.QueryBeamDBBundleSpan(fDevices[0], trigTimestamp, trigTimestamp+fChunkStepMSec);
-	} else {
-	  std::map<uint64_t, std::map<std::string, BeamDataPoint> > tempMap;
-	  for (auto device : fDevices) {
-	    auto tempMap = db.QueryBeamDBSingleSpan(device, trigTimestamp, trigTimestamp+fChunkStepMSec);
-	    BeamDataQuery.insert(tempMap.begin(), tempMap.end());
-	  }	
-	}
-      }	
 	
       // Now we can match the Beam info to CTC timestamps for saving to the CStore
       low = BeamDataQuery.lower_bound(trigTimestamp);
@@ -244,6 +259,53 @@ bool BeamFetcherV2::FetchFromTrigger()
   return true;
 }
 
+//------------------------------------------------------------------------------
+bool BeamFetcherV2::LoadChunk(uint64_t chunk_start)
+{
+  const auto& db = IFBeamDBInterfaceV2::Instance();
+
+  // A bundle query returns all of its devices at once
+  std::vector<std::string> names = fDevices;
+  if (fIsBundle) names.resize(1);
+
+  // Queue this chunk for all devices, along with the next few chunks, which
+  // are parsed when the triggers get to them
+  for (int i_chunk = 0; i_chunk <= fPrefetchChunks; ++i_chunk) {
+    uint64_t t0 = chunk_start + i_chunk * fChunkStepMSec;
+    for (const auto& name : names) fCache->Prefetch(name, t0, t0 + fChunkStepMSec);
+  }
+
+  logmessage = ("BeamFetcherV2: Loading beam data from " + std::to_string(chunk_start)
+		+ " to " + std::to_string(chunk_start + fChunkStepMSec));
+  Log(logmessage, v_message, verbosity);
+
+  for (const auto& name : names) {
+    std::string response;
+    try {
+      response = fCache->Get(name, chunk_start, chunk_start + fChunkStepMSec);
+    } catch (const std::exception& e) {
+      logmessage = ("Error (BeamFetcherV2): Query for " + name + " failed: " + e.what());
+      Log(logmessage, v_error, verbosity);
+      return false;
+    }
+
+    auto tempMap = (fIsBundle) ? db.ParseDBResponseBundleSpan(response)
+      : db.ParseDBResponseSingleSpan(response);
+    BeamDataQuery.insert(tempMap.begin(), tempMap.end());
+  }
+
+  // Triggers arrive in time order, so anything before the previous chunk
+  // is no longer needed
+  if (chunk_start > fChunkStepMSec) {
+    uint64_t keep_from = chunk_start - fChunkStepMSec;
+    BeamDataQuery.erase(BeamDataQuery.begin(), BeamDataQuery.lower_bound(keep_from));
+    fLoadedChunks.erase(fLoadedChunks.begin(), fLoadedChunks.lower_bound(keep_from));
+  }
+  fLoadedChunks.insert(chunk_start);
+
+  return true;
+}
+
 //------------------------------------------------------------------------------
 bool BeamFetcherV2::SaveToFile()
 {
@@ -8,6 +8,7 @@
 
 // standard library includes
 #include <iostream>
+#include <set>
 #include <string>
 
 // Boost includes
@@ -17,6 +18,7 @@
 // ToolAnalysis includes
 #include "Tool.h"
 #include "BeamDataPoint.h"
+#include "BeamDBCache.h"
 
 // ROOT includes
 #include "TFile.h"
@@ -33,6 +35,7 @@ class BeamFetcherV2: public Tool {
 
   protected:
     bool FetchFromTrigger();    
+    bool LoadChunk(uint64_t chunk_start);
     bool SaveToFile();
 
     void SetupROOTFile();
@@ -50,6 +53,12 @@ class BeamFetcherV2: public Tool {
     // Holder for the devices we're going to look up
     std::vector<std::string> fDevices;
 
+    // Start times of the chunks already in BeamDataQuery
+    std::set<uint64_t> fLoadedChunks;
+
+    // Disk cache and background downloads of the database responses
+    BeamDBCache *fCache;
+
     // Keep the last timestamp around to make sure we don't double count
     uint64_t fLastTimestampFetched;
     uint64_t fLastTimestampSaved;
@@ -73,6 +82,9 @@ class BeamFetcherV2: public Tool {
     std::string fDevicesFile;
     std::string fOutFileName;
     uint64_t fChunkStepMSec;
+    std::string fCacheDirectory;
+    int fPrefetchChunks;
+    int fPrefetchThreads;
 
     // Verbosity things
     int v_error   = 0;
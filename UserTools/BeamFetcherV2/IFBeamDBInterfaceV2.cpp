@@ -1,6 +1,8 @@
 // standard library includes
 #include <algorithm>
 #include <array>
+#include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -11,6 +13,102 @@
 #include "ANNIEconstants.h"
 #include "IFBeamDBInterfaceV2.h"
 
+namespace {
+
+  std::string db_server_url = "http://ifb-data.fnal.gov:8089/ifbeam/data/data";
+
+  /// @brief A field of a line in the database response, pointing into the
+  /// response string itself
+  struct CSVField {
+    const char* begin;
+    const char* end;
+  };
+
+  /// @brief Split the line [begin, end) at commas into at most max_fields
+  /// fields without copying. The last field takes the rest of the line.
+  size_t SplitCSVLine(const char* begin, const char* end, CSVField* fields,
+    size_t max_fields)
+  {
+    size_t n_fields = 0;
+    const char* field_start = begin;
+    while (n_fields + 1 < max_fields) {
+      const char* comma = static_cast<const char*>(
+        std::memchr(field_start, ',', end - field_start));
+      if (!comma) break;
+      fields[n_fields++] = {field_start, comma};
+      field_start = comma + 1;
+    }
+    fields[n_fields++] = {field_start, end};
+    return n_fields;
+  }
+
+  /// @brief Parse the CSV formatted span responses. The columns holding the
+  /// device name, the timestamp, the unit and the value differ between the
+  /// single device and the bundle queries.
+  void ParseCSVResponse(const std::string& response, size_t n_columns,
+    size_t device_column, size_t time_column, size_t unit_column,
+    size_t value_column,
+    std::map<uint64_t, std::map<std::string, BeamDataPoint> >& retMap)
+  {
+    // Holder for the earliest TS in a chunk
+    // We will roll this forward when a TS 60 ms later comes in
+    // (the max rate of $1D is 15 Hz or 66 ms)
+    uint64_t earlyTS = 0;
+
+    // The device name rarely changes from one line to the next, so only
+    // build a new string when it does
+    std::string data_type;
+
+    CSVField fields[8];
+    const char* pos = response.c_str();
+    const char* response_end = pos + response.size();
+
+    // Skip the first line (which gives textual column headers)
+    const char* line_end = static_cast<const char*>(
+      std::memchr(pos, '\n', response_end - pos));
+    pos = (line_end) ? line_end + 1 : response_end;
+
+    while (pos < response_end) {
+      line_end = static_cast<const char*>(
+        std::memchr(pos, '\n', response_end - pos));
+      if (!line_end) line_end = response_end;
+
+      size_t n_fields = SplitCSVLine(pos, line_end, fields, n_columns);
+      pos = line_end + 1;
+      if (n_fields < n_columns) continue;
+
+      // The response string is null-terminated, and every field is followed
+      // by a comma or a newline, so the C conversion functions stop at the
+      // end of their field
+      char* parse_end = nullptr;
+      uint64_t timestamp = std::strtoull(fields[time_column].begin, &parse_end, 10);
+      if (parse_end == fields[time_column].begin) continue;
+      double value = std::strtod(fields[value_column].begin, &parse_end);
+      if (parse_end == fields[value_column].begin) continue;
+
+      const CSVField& device = fields[device_column];
+      size_t device_length = device.end - device.begin;
+      if (data_type.size() != device_length
+        || data_type.compare(0, device_length, device.begin, device_length) != 0)
+      {
+        data_type.assign(device.begin, device_length);
+      }
+
+      if (timestamp - earlyTS > 60) earlyTS = timestamp;
+
+      retMap[earlyTS][data_type] = BeamDataPoint(value,
+        std::string(fields[unit_column].begin, fields[unit_column].end),
+        timestamp);
+    }
+  }
+
+}
+
+void IFBeamDBInterfaceV2::SetServerURL(const std::string& url)
+{
+  db_server_url = url;
+}
+
 IFBeamDBInterfaceV2::IFBeamDBInterfaceV2()
 {
   fCurl = curl_easy_init();
@@ -52,10 +150,18 @@ const IFBeamDBInterfaceV2& IFBeamDBInterfaceV2::Instance() {
 std::map<uint64_t, std::map<std::string, BeamDataPoint> >
   IFBeamDBInterfaceV2::QueryBeamDBSingleSpan(std::string device, uint64_t t0, uint64_t t1)
   const
+{
+  return ParseDBResponseSingleSpan(FetchBeamDBSingleSpan(device, t0, t1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string IFBeamDBInterfaceV2::FetchBeamDBSingleSpan(std::string device,
+  uint64_t t0, uint64_t t1) const
 {
   std::stringstream url_stream;
-  url_stream << "http://ifb-data.fnal.gov:8089/ifbeam/data/data?e=e,1d&v=";
+  url_stream << db_server_url << "?e=e,1d&v=";
   url_stream << device;
+  url_stream << "&t0=";
   url_stream << std::fixed << std::setprecision(3) << (t0 - 1)/1000.;
   url_stream << "&t1=" << (t1 + 1)/1000.;
   url_stream << "&f=csv";
@@ -66,18 +172,23 @@ std::map<uint64_t, std::map<std::string, BeamDataPoint> >
   if (code != CURLE_OK) throw std::runtime_error("Error accessing"
     " IF beam database. Please check your internet connection.");
 
-  auto beam_data = ParseDBResponseSingleSpan(response);
-
-  return beam_data;
+  return response;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::map<uint64_t, std::map<std::string, BeamDataPoint> >
   IFBeamDBInterfaceV2::QueryBeamDBBundleSpan(std::string bundle, uint64_t t0, uint64_t t1)
   const
+{
+  return ParseDBResponseBundleSpan(FetchBeamDBBundleSpan(bundle, t0, t1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string IFBeamDBInterfaceV2::FetchBeamDBBundleSpan(std::string bundle,
+  uint64_t t0, uint64_t t1) const
 {
   std::stringstream url_stream;
-  url_stream << "http://ifb-data.fnal.gov:8089/ifbeam/data/data?e=e,1d&b=";
+  url_stream << db_server_url << "?e=e,1d&b=";
   url_stream << bundle;
   url_stream << "&t0="; 
   url_stream << std::fixed << std::setprecision(3) << (t0 - 1)/1000.;
@@ -90,9 +201,7 @@ std::map<uint64_t, std::map<std::string, BeamDataPoint> >
   if (code != CURLE_OK) throw std::runtime_error("Error accessing"
     " IF beam database. Please check your internet connection.");
 
-  auto beam_data = ParseDBResponseBundleSpan(response);
-
-  return beam_data;
+  return response;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -100,7 +209,7 @@ std::map<uint64_t, std::map<std::string, BeamDataPoint> >
   IFBeamDBInterfaceV2::QueryBeamDBSingle(std::string device, uint64_t time) const
 {
   std::stringstream url_stream;
-  url_stream << "http://ifb-data.fnal.gov:8089/ifbeam/data/data?e=e,1d&v=";
+  url_stream << db_server_url << "?e=e,1d&v=";
   url_stream << device;
   url_stream << "&t=" << std::fixed << std::setprecision(3) << time/1000.;
   url_stream << "&f=xml";
@@ -121,7 +230,7 @@ std::map<uint64_t, std::map<std::string, BeamDataPoint> >
   IFBeamDBInterfaceV2::QueryBeamDBBundle(std::string bundle, uint64_t time) const
 {
   std::stringstream url_stream;
-  url_stream << "http://ifb-data.fnal.gov:8089/ifbeam/data/data?e=e,1d&b=";
+  url_stream << db_server_url << "?e=e,1d&b=";
   url_stream << bundle;
   url_stream << "&t=" << std::fixed << std::setprecision(3) << time/1000.;
   url_stream << "&f=csv";
@@ -146,13 +255,22 @@ int IFBeamDBInterfaceV2::RunQuery(const std::stringstream &url_stream, std::stri
     return -1;
   }
 
+  // Use a separate handle for every query: libcurl handles must not be
+  // shared between threads, and BeamFetcherV2 queries several devices
+  // concurrently
+  CURL* curl = curl_easy_init();
+  if (!curl) throw std::runtime_error("IFBeamDBInterfaceV2 failed to"
+    " initialize libcurl");
+
   //std::cout << "IFBeamDBInterfaceV2: sending the following query: " << url_stream.str() << std::endl;
   
-  curl_easy_setopt(fCurl, CURLOPT_URL, url_stream.str().c_str());
+  std::string url = url_stream.str();
+  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
 
   response_string.clear();
 
-  curl_easy_setopt(fCurl, CURLOPT_WRITEFUNCTION,
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
     static_cast<size_t(*)(char*, size_t, size_t, std::string*)>(
       [](char* ptr, size_t size,
         size_t num_members, std::string* data) -> size_t
@@ -163,17 +281,18 @@ int IFBeamDBInterfaceV2::RunQuery(const std::stringstream &url_stream, std::stri
     )
   );
 
-  curl_easy_setopt(fCurl, CURLOPT_WRITEDATA, &response_string);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
 
-  int code = curl_easy_perform(fCurl);
+  int code = curl_easy_perform(curl);
 
   // Check the HTTP response code from the IF beam database server. If
   // it's not 200, then throw an exception (something went wrong).
   // For more information about the possible HTTP status codes, see
   // this Wikipedia article: http://tinyurl.com/8yqvhwf
-  long http_response_code;
+  long http_response_code = 0;
   constexpr long HTTP_OK = 200;
-  curl_easy_getinfo(fCurl, CURLINFO_RESPONSE_CODE, &http_response_code);
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_response_code);
+  curl_easy_cleanup(curl);
   if (http_response_code != HTTP_OK) {
     throw std::runtime_error("HTTP error (code "
       + std::to_string(http_response_code) + ") encountered while querying"
@@ -218,50 +337,21 @@ IFBeamDBInterfaceV2::ParseDBResponseSingleSpan(const std::string& response) cons
   // Create an empty map to store the parsed data.
   std::map<uint64_t, std::map<std::string, BeamDataPoint> > retMap;
 
-  // Use a stringstream to parse the data
-  std::istringstream response_stream(response);
-
-  // Temporary storage for the comma-separated fields in the database response
-  // string
-  std::string line, junk, data_type, time_string, unit, val_string;
-  uint64_t timestamp;
-
-  // Holder for the earliest TS in a chunk
-  // We will roll this forward when a TS 60 ms later comes in
-  // (the max rate of $1D is 15 Hz or 66 ms)  
-  uint64_t earlyTS = 0;
-
-  // Skip the first line (which gives textual column headers)
-  std::getline(response_stream, line, '\n');
-
-  while (std::getline(response_stream, line, '\n')) {
-    std::stringstream ss(line);
-
-    std::getline(ss, junk, ',');
-    std::getline(ss, data_type, ',');
-    std::getline(ss, time_string, ',');
-    std::getline(ss, unit, ',');
-    std::getline(ss, val_string);
-
-    timestamp = std::stoull(time_string);
-    if (timestamp - earlyTS > 60) earlyTS = timestamp;
-    
-    retMap[earlyTS][data_type] = BeamDataPoint(std::stod(val_string),
-					       unit,
-					       timestamp);
-  }
+  // Columns: junk, device, time, unit, value
+  ParseCSVResponse(response, 5, 1, 2, 3, 4, retMap);
 
-for (auto &ts : retMap) {
+  for (auto &ts : retMap) {
     for (auto &dev : requiredDevices) {
       if (ts.second.find(dev.first) == ts.second.end()) {
-          ts.second[dev.first] = BeamDataPoint(-9999, dev.second, ts.first);
+          ts.second[dev.first] = BeamDataPoint(-9999., dev.second, ts.first);
       }
     }
   }
-  
+
   return retMap;
 }
 
+
 ////////////////////////////////////////////////////////////////////////////////
 std::map<uint64_t, std::map<std::string, BeamDataPoint> >
 IFBeamDBInterfaceV2::ParseDBResponseBundleSpan(const std::string& response) const
@@ -269,44 +359,8 @@ IFBeamDBInterfaceV2::ParseDBResponseBundleSpan(const std::string& response) cons
   // Create an empty map to store the parsed data.
   std::map<uint64_t, std::map<std::string, BeamDataPoint> > retMap;
 
-  // Use a stringstream to parse the data
-  std::istringstream response_stream(response);
-
-  // Temporary storage for the comma-separated fields in the database response
-  // string
-  std::string line, junk, data_type, time_string, unit, val_string;
-  uint64_t timestamp;
-
-  // Holder for the earliest TS in a chunk
-  // We will roll this forward when a TS 60 ms later comes in
-  // (the max rate of $1D is 15 Hz or 66 ms)  
-  uint64_t earlyTS = 0;
-
-
-  // Skip the first line (which gives textual column headers)
-  std::getline(response_stream, line, '\n');
-
-  while (std::getline(response_stream, line, '\n')) {
-    std::stringstream ss(line);
-
-    std::getline(ss, time_string, ',');
-    std::getline(ss, data_type, ',');
-    std::getline(ss, unit, ',');
-    std::getline(ss, val_string);
-
-    timestamp = std::stoull(time_string);
-    if (timestamp - earlyTS > 60) earlyTS = timestamp;
-    
-    retMap[earlyTS][data_type] = BeamDataPoint(std::stod(val_string),
-					       unit,
-					       timestamp);
-  }
-
-  // count the total number of elements in retMap times the number of elements in that element, print the total number
-  int total = 0;
-  for (auto &ts : retMap) {
-    total += ts.second.size();
-  }
+  // Columns: time, device, unit, value
+  ParseCSVResponse(response, 4, 1, 0, 2, 3, retMap);
 
   // check each timestamp in the retMap, to see if it have all the devices in the requiredDevices map keys, if yes, continue
   // if not, create entry for that device at retMap[TS], use the data type from the value of requiredDevices
@@ -314,20 +368,15 @@ IFBeamDBInterfaceV2::ParseDBResponseBundleSpan(const std::string& response) cons
   for (auto &ts : retMap) {
     for (auto &dev : requiredDevices) {
       if (ts.second.find(dev.first) == ts.second.end()) {
-          //cout<<" not finding device "<<dev.first<<" at time "<<ts.first<<endl;
           ts.second[dev.first] = BeamDataPoint(-9999., dev.second, ts.first);
       }
     }
   }
 
-  int totalAfter = 0;
-  for (auto &ts : retMap) {
-    totalAfter += ts.second.size();
-  }
-  
   return retMap;
 }
 
+
 ////////////////////////////////////////////////////////////////////////////////
 std::map<uint64_t, std::map<std::string, BeamDataPoint> >
 IFBeamDBInterfaceV2::ParseDBResponseSingle(const std::string& response) const
@@ -389,50 +438,18 @@ std::map<uint64_t, std::map<std::string, BeamDataPoint> >
 IFBeamDBInterfaceV2::ParseDBResponseBundle(const std::string& response) const
 {
   std::map<uint64_t, std::map<std::string, BeamDataPoint> > retMap;
-  
-  // Use a stringstream to parse the data
-  std::istringstream response_stream(response);
-
-  // Temporary storage for the comma-separated fields in the database response
-  // string
-  std::string line, junk, data_type, time_string, unit, val_string;
-  uint64_t timestamp;
-
-  // This is a bit less necessary here,
-  // but it keeps all the points in the same timestamp map element
-  // Holder for the earliest TS in a chunk
-  // We will roll this forward when a TS 60 ms later comes in
-  // (the max rate of $1D is 15 Hz or 66 ms)  
-  uint64_t earlyTS = 0;
-
-  // Skip the first line (which gives textual column headers)
-  std::getline(response_stream, line, '\n');
 
-  while (std::getline(response_stream, line, '\n')) {
-    std::stringstream ss(line);
-
-    std::getline(ss, data_type, ',');
-    std::getline(ss, junk, ',');
-    std::getline(ss, time_string, ',');
-    std::getline(ss, unit, ',');
-    std::getline(ss, val_string);
-
-    timestamp = std::stoull(time_string);
-    if (timestamp - earlyTS > 60) earlyTS = timestamp;
-    
-    retMap[earlyTS][data_type] = BeamDataPoint(std::stod(val_string),
-					       unit,
-					       timestamp);
-  }
+  // Columns: device, junk, time, unit, value
+  ParseCSVResponse(response, 5, 0, 2, 3, 4, retMap);
 
-for (auto &ts : retMap) {
+  for (auto &ts : retMap) {
     for (auto &dev : requiredDevices) {
       if (ts.second.find(dev.first) == ts.second.end()) {
-          ts.second[dev.first] = BeamDataPoint(-9999, dev.second, ts.first);
+          ts.second[dev.first] = BeamDataPoint(-9999., dev.second, ts.first);
       }
     }
   }
-  
+
   return retMap;
 }
 
@@ -67,8 +67,24 @@ class IFBeamDBInterfaceV2 {
     std::map<uint64_t, std::map<std::string, BeamDataPoint> >
       QueryBeamDBBundle(std::string bundle, uint64_t time) const;
 
+    /// @brief Raw CSV responses of the span queries, to be parsed with
+    /// ParseDBResponseSingleSpan/ParseDBResponseBundleSpan. Safe to call
+    /// from several threads at once.
+    std::string FetchBeamDBSingleSpan(std::string device, uint64_t t0, uint64_t t1) const;
+    std::string FetchBeamDBBundleSpan(std::string bundle, uint64_t t0, uint64_t t1) const;
+
+    std::map<uint64_t, std::map<std::string, BeamDataPoint> >
+      ParseDBResponseSingleSpan(const std::string& response) const;
+
+    std::map<uint64_t, std::map<std::string, BeamDataPoint> >
+      ParseDBResponseBundleSpan(const std::string& response) const;
+
     int RunQuery(const std::stringstream &url_stream, std::string &response_string) const;
 
+    /// @brief Change the database server, e.g. to a local stand-in that
+    /// serves recorded responses
+    static void SetServerURL(const std::string& url);
+
     /// @brief The list of devices required to save in the root tree
     std::map<std::string, std::string> requiredDevices;
     
@@ -76,12 +92,6 @@ class IFBeamDBInterfaceV2 {
     /// @brief Create the singleton IFBeamDBInterfaceV2 object
     IFBeamDBInterfaceV2();
 
-    std::map<uint64_t, std::map<std::string, BeamDataPoint> >
-      ParseDBResponseSingleSpan(const std::string& response) const;
-
-    std::map<uint64_t, std::map<std::string, BeamDataPoint> >
-      ParseDBResponseBundleSpan(const std::string& response) const;
-
     std::map<uint64_t, std::map<std::string, BeamDataPoint> >
       ParseDBResponseSingle(const std::string& response) const;
 
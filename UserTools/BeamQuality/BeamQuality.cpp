@@ -1,4 +1,7 @@
 #include "BeamQuality.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(BeamQuality);
 
 BeamQuality::BeamQuality():Tool(){}
 
@@ -147,9 +150,10 @@ bool BeamQuality::Execute()
     }
 
     // Check for beam DB info associated with the timestamp
-    if (BeamDataMap->find(timestamp_ms) != BeamDataMap->end()) {
+    auto beam_data_it = BeamDataMap->find(timestamp_ms);
+    if (beam_data_it != BeamDataMap->end()) {
       // Got the goods, now use it
-      BeamStatus tempStatus = assess_beam_quality(timestamp);
+      BeamStatus tempStatus = assess_beam_quality(timestamp, beam_data_it->second);
       BeamStatusMap->emplace(timestamp, tempStatus);
       
     } else {
@@ -185,45 +189,41 @@ bool BeamQuality::Finalise()
 }
 
 //------------------------------------------------------------------------------
-BeamStatus BeamQuality::assess_beam_quality(uint64_t timestamp)
+BeamStatus BeamQuality::assess_beam_quality(uint64_t timestamp,
+  const std::map<std::string, BeamDataPoint>& beam_data_points)
 {
   // initialize the beamstatus that we'll return
   BeamStatus retStatus;
   retStatus.set_time(TimeClass(timestamp));
 
   
-  // Check for and grab the quatities we want from the BeamDataMap
+  // Grab the quatities we want from the beam DB info of this timestamp
   uint64_t timestamp_ms = timestamp/1E6;
-  auto BeamDataPointMap = BeamDataMap->at(timestamp_ms);
+  std::map<std::string, BeamDataPoint>::const_iterator bdp;
 
-  std::string device_name = "";
-  
   // POT downstream toroid
-  device_name = "E:TOR875";
   double pot_ds_toroid = 0;
-  if (BeamDataPointMap.find(device_name) != BeamDataPointMap.end()) {
-  auto bdp = BeamDataPointMap[device_name];
-    retStatus.add_measurement(device_name, timestamp_ms, bdp);
-    retStatus.set_pot(bdp.value);
-    pot_ds_toroid = bdp.value;
+  bdp = beam_data_points.find("E:TOR875");
+  if (bdp != beam_data_points.end()) {
+    retStatus.add_measurement(bdp->first, timestamp_ms, bdp->second);
+    retStatus.set_pot(bdp->second.value);
+    pot_ds_toroid = bdp->second.value;
   }
   
   // POT upstream toroid
-  device_name = "E:TOR860";
   double pot_us_toroid = 0;
-  if (BeamDataPointMap.find(device_name) != BeamDataPointMap.end()) {
-    auto bdp = BeamDataPointMap[device_name];
-    retStatus.add_measurement(device_name, timestamp_ms, bdp);
-    pot_us_toroid = bdp.value;
+  bdp = beam_data_points.find("E:TOR860");
+  if (bdp != beam_data_points.end()) {
+    retStatus.add_measurement(bdp->first, timestamp_ms, bdp->second);
+    pot_us_toroid = bdp->second.value;
   }
 
   // Horn current
-  device_name = "E:THCURR";
   double horn_current = 0;
-  if (BeamDataPointMap.find(device_name) != BeamDataPointMap.end()) {
-    auto bdp = BeamDataPointMap[device_name];
-    retStatus.add_measurement(device_name, timestamp_ms, bdp);
-    horn_current = bdp.value;
+  bdp = beam_data_points.find("E:THCURR");
+  if (bdp != beam_data_points.end()) {
+    retStatus.add_measurement(bdp->first, timestamp_ms, bdp->second);
+    horn_current = bdp->second.value;
   }
 
   
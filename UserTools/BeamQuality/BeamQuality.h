@@ -37,7 +37,8 @@ class BeamQuality: public Tool {
   bool Finalise(); ///< Finalise function used to clean up resources.
 
  protected:
-  BeamStatus assess_beam_quality(uint64_t timestamp);
+  BeamStatus assess_beam_quality(uint64_t timestamp,
+    const std::map<std::string, BeamDataPoint>& beam_data_points);
 
 
  private:
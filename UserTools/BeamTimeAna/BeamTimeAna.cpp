@@ -1,4 +1,7 @@
 #include "BeamTimeAna.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(BeamTimeAna);
 
 BeamTimeAna::BeamTimeAna():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "BeamTimeTreeMaker.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(BeamTimeTreeMaker);
 
 BeamTimeTreeMaker::BeamTimeTreeMaker():Tool(){}
 
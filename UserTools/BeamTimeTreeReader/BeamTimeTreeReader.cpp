@@ -1,4 +1,7 @@
 #include "BeamTimeTreeReader.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(BeamTimeTreeReader);
 
 BeamTimeTreeReader::BeamTimeTreeReader():Tool(){}
 
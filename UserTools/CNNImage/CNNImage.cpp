@@ -1,4 +1,7 @@
 #include "CNNImage.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(CNNImage);
 
 CNNImage::CNNImage():Tool(){}
 
@@ -19,6 +22,9 @@ bool CNNImage::Initialise(std::string configfile, DataModel &data){
   isData = 0;
   use_LAPPDs = false;
   write_to_file = false;
+  output_format = "csv";
+  std::string tensor_channel_list = "charge,time";
+  int tensor_chunk_events = 100;
 
   //User-specified values
   m_variables.Get("verbosity",verbosity);
@@ -33,12 +39,18 @@ bool CNNImage::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("IsData",isData);
   m_variables.Get("useLAPPDs",use_LAPPDs);
   m_variables.Get("WriteToFile",write_to_file);
+  m_variables.Get("OutputFormat",output_format);
+  m_variables.Get("TensorChannels",tensor_channel_list);
+  m_variables.Get("TensorChunkEvents",tensor_chunk_events);
  
   Log("CNNImage tool: Initialising...",v_message,verbosity);
 
   //Check for user options
   if (data_mode != "Normal" && data_mode != "Charge-Weighted" && data_mode != "TimeEvolution") data_mode = "Normal";
   if (save_mode != "Geometric" && save_mode != "PMT-wise" && save_mode != "Static") save_mode = "Static";
+  if (output_format != "csv" && output_format != "npy" && output_format != "both") output_format = "csv";
+  write_csv = (output_format != "npy");
+  write_npy = (output_format != "csv");
   nlappdX = dimensionLAPPD;
   nlappdY = dimensionLAPPD;
 
@@ -60,7 +72,25 @@ bool CNNImage::Initialise(std::string configfile, DataModel &data){
   //Output configuration
   Log("CNNImage tool: Data mode: " + data_mode + " [Normal/Charge-Weighted]", v_message, verbosity);
   Log("CNNImage tool: Save mode: " + save_mode + " [Geometric/PMT-wise]", v_message, verbosity);
-  Log("CNNImage tool: LAPPD dimension: " + dimensionLAPPD, v_message, verbosity);
+  Log("CNNImage tool: LAPPD dimension: " + std::to_string(dimensionLAPPD), v_message, verbosity);
+  Log("CNNImage tool: Output format: " + output_format + " [csv/npy/both]", v_message, verbosity);
+
+  tensor_channels.clear();
+  boost::char_separator<char> sep(", ");
+  boost::tokenizer<boost::char_separator<char>> tokens(tensor_channel_list, sep);
+  for (const std::string& name : tokens) {
+    cnnimage::Channel channel;
+    if (!cnnimage::ParseChannel(name, channel)) {
+      Log("CNNImage tool: Unknown TensorChannels entry " + name + " [charge/charge_abs/time/time_first/time_abs/time_first_abs]",
+          v_error, verbosity);
+      return false;
+    }
+    tensor_channels.push_back(channel);
+  }
+  if (write_npy && tensor_channels.empty()) {
+    Log("CNNImage tool: No TensorChannels to write", v_error, verbosity);
+    return false;
+  }
 
   //---------------------------------------------------------------
   //----------------------Get geometry-----------------------------
@@ -131,6 +161,10 @@ bool CNNImage::Initialise(std::string configfile, DataModel &data){
   std::string csvfile_Rings = cnn_outpath + str_Rings + str_csv;
 
   if (write_to_file) {
+    outfile_Rings.open(csvfile_Rings.c_str());
+    outfile_MRD.open(csvfile_MRD.c_str());
+  }
+  if (write_to_file && write_csv) {
     file = new TFile(rootfile_name.c_str(),"RECREATE");
     outfile.open(csvfile_name.c_str());
     outfile_abs.open(csvfile_abs_name.c_str());
@@ -138,10 +172,8 @@ bool CNNImage::Initialise(std::string configfile, DataModel &data){
     outfile_time_first.open(csvfile_time_first_name.c_str());
     outfile_time_abs.open(csvfile_time_abs_name.c_str());
     outfile_time_first_abs.open(csvfile_time_first_abs_name.c_str());
-    outfile_Rings.open(csvfile_Rings.c_str());
-    outfile_MRD.open(csvfile_MRD.c_str());
   }
-  if (use_LAPPDs) {
+  if (write_to_file && write_csv && use_LAPPDs) {
     outfile_lappd.open(csvfile_lappd_name.c_str());
     outfile_lappd_abs.open(csvfile_lappd_abs_name.c_str());
     outfile_lappd_time.open(csvfile_lappd_time_name.c_str());
@@ -167,6 +199,28 @@ bool CNNImage::Initialise(std::string configfile, DataModel &data){
   // This needs to be executed after hist_cnn has been created, due to dynamic scaling of the histogram at execution
   //   time, and since the histogram is used to compute the binning.
   GeometricPMTBinning(geometric_pmt_mapping, hist_cnn);
+  if (!BuildPixelMap()) return false;
+
+  //---------------------------------------------------------------
+  //-------------------Define npy output files---------------------
+  //---------------------------------------------------------------
+  // (events, channels, y, x) for the PMTs and (events, channels, LAPPD, y, x) for the LAPPDs
+
+  if (write_to_file && write_npy) {
+    std::string error;
+    std::vector<size_t> pmt_shape = {tensor_channels.size(), (size_t)image_ny, (size_t)image_nx};
+    if (!npy_pmt.Open(cnn_outpath + "_pmt.npy", pmt_shape, tensor_chunk_events, error)) {
+      Log("CNNImage tool: " + error, v_error, verbosity);
+      return false;
+    }
+    if (use_LAPPDs) {
+      std::vector<size_t> lappd_shape = {tensor_channels.size(), lappd_detkeys.size(), (size_t)dimensionLAPPD, (size_t)dimensionLAPPD};
+      if (!npy_lappd.Open(cnn_outpath + "_lappd.npy", lappd_shape, tensor_chunk_events, error)) {
+        Log("CNNImage tool: " + error, v_error, verbosity);
+        return false;
+      }
+    }
+  }
 
   return true;
 }
@@ -454,142 +508,18 @@ bool CNNImage::Execute(){
 
   ReadoutMRD();
 
-  // Define histogram as an intermediate step to the CNN
-
-  std::stringstream ss_cnn, ss_title_cnn, ss_cnn_time, ss_title_cnn_time, ss_cnn_pmtwise, ss_title_cnn_pmtwise,
-    ss_cnn_time_pmtwise, ss_title_cnn_time_pmtwise;
-  std::stringstream ss_cnn_abs, ss_title_cnn_abs, ss_cnn_time_first, ss_title_cnn_time_first, ss_cnn_time_abs,
-    ss_title_cnn_time_abs, ss_cnn_time_first_abs, ss_title_cnn_time_first_abs, ss_cnn_abs_pmtwise,
-    ss_title_cnn_abs_pmtwise, ss_cnn_time_first_pmtwise, ss_title_cnn_time_first_pmtwise, ss_cnn_time_abs_pmtwise,
-    ss_title_cnn_time_abs_pmtwise, ss_cnn_time_first_abs_pmtwise, ss_title_cnn_time_first_abs_pmtwise;
-
-  ss_cnn<<"hist_cnn"<<evnum;
-  ss_title_cnn<<"EventDisplay (CNN), Event "<<evnum;
-  ss_cnn_abs<<"hist_cnn_abs"<<evnum;
-  ss_title_cnn_abs<<"EventDisplay Charge (CNN), Event "<<evnum;
-  ss_cnn_time<<"hist_cnn_time"<<evnum;
-  ss_title_cnn_time<<"EventDisplay Time (CNN), Event "<<evnum;
-  ss_cnn_time_first<<"hist_cnn_time_first"<<evnum;
-  ss_title_cnn_time_first<<"EventDisplay First Times (CNN), Event "<<evnum;
-  ss_cnn_time_abs<<"hist_cnn_time_abs"<<evnum;
-  ss_title_cnn_time_abs<<"EventDisplay Absolute Times (CNN), Event "<<evnum;
-  ss_cnn_time_first_abs<<"hist_cnn_time_first_abs"<<evnum;
-  ss_title_cnn_time_first_abs<<"EventDisplay Absolute First Times(CNN), Event "<<evnum;
-  ss_cnn_pmtwise<<"hist_cnn_pmtwise"<<evnum;
-  ss_title_cnn_pmtwise<<"EventDisplay (CNN, pmt wise), Event "<<evnum;
-  ss_cnn_abs_pmtwise<<"hist_cnn_abs_pmtwise"<<evnum;
-  ss_title_cnn_abs_pmtwise<<"EventDisplay Charge (CNN, pmt wise), Event "<<evnum;
-  ss_cnn_time_pmtwise << "hist_cnn_time_pmtwise"<<evnum;
-  ss_title_cnn_time_pmtwise <<"EventDisplay Time (CNN, pmt wise), Event "<<evnum;
-  ss_cnn_time_first_pmtwise << "hist_cnn_time_first_pmtwise"<<evnum;
-  ss_title_cnn_time_first_pmtwise <<"EventDisplay First Times (CNN, pmt wise), Event "<<evnum;
-  ss_cnn_time_abs_pmtwise << "hist_cnn_time_abs_pmtwise"<<evnum;
-  ss_title_cnn_time_abs_pmtwise <<"EventDisplay Absolute Times (CNN, pmt wise), Event "<<evnum;
-  ss_cnn_time_first_abs_pmtwise << "hist_cnn_time_first_abs_pmtwise"<<evnum;
-  ss_title_cnn_time_first_abs_pmtwise <<"EventDisplay Absolute First Times (CNN, pmt wise), Event "<<evnum;
-
-  hist_cnn->Reset();
-  hist_cnn_abs->Reset();
-  hist_cnn_time->Reset();
-  hist_cnn_time_abs->Reset();
-  hist_cnn_time_first->Reset();
-  hist_cnn_time_first_abs->Reset();
-  hist_cnn_pmtwise->Reset();
-  hist_cnn_abs_pmtwise->Reset();
-  hist_cnn_time_pmtwise->Reset();
-  hist_cnn_time_first_pmtwise->Reset();
-  hist_cnn_time_abs_pmtwise->Reset();
-  hist_cnn_time_first_abs_pmtwise->Reset();
-
-  hist_cnn->SetName(ss_cnn.str().c_str());
-  hist_cnn_abs->SetName(ss_cnn_abs.str().c_str());
-  hist_cnn_time->SetName(ss_cnn_time.str().c_str());
-  hist_cnn_time_abs->SetName(ss_cnn_time_abs.str().c_str());
-  hist_cnn_time_first->SetName(ss_title_cnn_time_first.str().c_str());
-  hist_cnn_time_first_abs->SetName(ss_cnn_time_first_abs.str().c_str());
-  hist_cnn_pmtwise->SetName(ss_cnn_pmtwise.str().c_str());
-  hist_cnn_abs_pmtwise->SetName(ss_cnn_abs_pmtwise.str().c_str());
-  hist_cnn_time_pmtwise->SetName(ss_cnn_time_pmtwise.str().c_str());
-  hist_cnn_time_first_pmtwise->SetName(ss_cnn_time_first_pmtwise.str().c_str());
-  hist_cnn_time_abs_pmtwise->SetName(ss_cnn_time_abs_pmtwise.str().c_str());
-  hist_cnn_time_first_abs_pmtwise->SetName(ss_cnn_time_first_abs_pmtwise.str().c_str());
-
-  hist_cnn->SetTitle(ss_title_cnn.str().c_str());
-  hist_cnn_abs->SetTitle(ss_title_cnn_abs.str().c_str());
-  hist_cnn_time->SetTitle(ss_title_cnn_time.str().c_str());
-  hist_cnn_time_abs->SetTitle(ss_title_cnn_time_abs.str().c_str());
-  hist_cnn_time_first->SetTitle(ss_title_cnn_time_first.str().c_str());
-  hist_cnn_time_first_abs->SetTitle(ss_title_cnn_time_first_abs.str().c_str());
-  hist_cnn_pmtwise->SetTitle(ss_title_cnn_pmtwise.str().c_str());
-  hist_cnn_abs_pmtwise->SetTitle(ss_title_cnn_abs_pmtwise.str().c_str());
-  hist_cnn_time_pmtwise->SetTitle(ss_title_cnn_time_pmtwise.str().c_str());
-  hist_cnn_time_first_pmtwise->SetTitle(ss_title_cnn_time_first_pmtwise.str().c_str());
-  hist_cnn_time_abs_pmtwise->SetTitle(ss_title_cnn_time_abs_pmtwise.str().c_str());
-  hist_cnn_time_first_abs_pmtwise->SetTitle(ss_title_cnn_time_first_abs_pmtwise.str().c_str());
-
-  // Define LAPPD histograms (1 per LAPPD)
-  std::vector<TH2F*> hists_lappd, hists_abs_lappd, hists_time_lappd, hists_time_first_lappd, hists_time_abs_lappd,
-    hists_time_first_abs_lappd;
-  if (use_LAPPDs) {
-    for (unsigned int i_lappd = 0; i_lappd < lappd_detkeys.size(); i_lappd++){
-      std::stringstream ss_hist_lappd, ss_title_lappd, ss_hist_abs_lappd, ss_title_abs_lappd, ss_hist_time_lappd,
-        ss_title_time_lappd, ss_hist_time_first_lappd, ss_title_time_first_lappd, ss_hist_time_abs_lappd,
-        ss_title_time_abs_lappd, ss_hist_time_first_abs_lappd, ss_title_time_first_abs_lappd;
-
-      ss_hist_lappd<<"hist_lappd"<<i_lappd<<"_ev"<<evnum;
-      ss_title_lappd<<"EventDisplay (CNN), LAPPD "<<i_lappd<<", Event "<<evnum;
-      ss_hist_abs_lappd<<"hist_lappd_abs"<<i_lappd<<"_ev"<<evnum;
-      ss_title_abs_lappd<<"EventDisplay Charge (CNN), LAPPD "<<i_lappd<<", Event "<<evnum;
-      ss_hist_time_lappd<<"hist_time_lappd"<<i_lappd<<"_ev"<<evnum;
-      ss_title_time_lappd<<"EventDisplay Time (CNN), LAPPD "<<i_lappd<<", Event "<<evnum;
-      ss_hist_time_first_lappd<<"hist_time_first_lappd"<<i_lappd<<"_ev"<<evnum;
-      ss_title_time_first_lappd<<"EventDisplay First Times (CNN), LAPPD "<<i_lappd<<", Event "<<evnum;
-      ss_hist_time_abs_lappd<<"hist_time_abs_lappd"<<i_lappd<<"_ev"<<evnum;
-      ss_title_time_abs_lappd<<"EventDisplay Absolute Times (CNN), LAPPD "<<i_lappd<<", Event "<<evnum;
-      ss_hist_time_first_abs_lappd<<"hist_time_first_abs_lappd"<<i_lappd<<"_ev"<<evnum;
-      ss_title_time_first_abs_lappd<<"EventDisplay Absolute First Times (CNN), LAPPD "<<i_lappd<<", Event "<<evnum;
-      TH2F *hist_lappd = new TH2F(
-        ss_hist_lappd.str().c_str(),ss_title_lappd.str().c_str(),dimensionLAPPD,0,dimensionLAPPD,dimensionLAPPD,0,
-        dimensionLAPPD
-      );    //resolution in x/y direction should be 1cm, over a total length of 20cm each
-      hists_lappd.push_back(hist_lappd);
-      TH2F *hist_abs_lappd = new TH2F(
-        ss_hist_abs_lappd.str().c_str(),ss_title_abs_lappd.str().c_str(),dimensionLAPPD,0,dimensionLAPPD,dimensionLAPPD,
-        0,dimensionLAPPD
-      );    //resolution in x/y direction should be 1cm, over a total length of 20cm each
-      hists_abs_lappd.push_back(hist_abs_lappd);
-      TH2F *hist_time_lappd = new TH2F(
-        ss_hist_time_lappd.str().c_str(),ss_title_time_lappd.str().c_str(),dimensionLAPPD,0,dimensionLAPPD,
-        dimensionLAPPD,0,dimensionLAPPD
-      );    //resolution in x/y direction should be 1cm, over a total length of 20cm each
-      hists_time_lappd.push_back(hist_time_lappd);
-      TH2F *hist_time_first_lappd = new TH2F(
-        ss_hist_time_first_lappd.str().c_str(),ss_title_time_first_lappd.str().c_str(),dimensionLAPPD,0,dimensionLAPPD,
-        dimensionLAPPD,0,dimensionLAPPD
-      );    //resolution in x/y direction should be 1cm, over a total length of 20cm each
-      hists_time_first_lappd.push_back(hist_time_first_lappd);
-      TH2F *hist_time_abs_lappd = new TH2F(
-        ss_hist_time_abs_lappd.str().c_str(),ss_title_time_abs_lappd.str().c_str(),
-        dimensionLAPPD,0,dimensionLAPPD,dimensionLAPPD,0,dimensionLAPPD
-      );    //resolution in x/y direction should be 1cm, over a total length of 20cm each
-      hists_time_abs_lappd.push_back(hist_time_abs_lappd);
-      TH2F *hist_time_first_abs_lappd = new TH2F(
-        ss_hist_time_first_abs_lappd.str().c_str(),ss_title_time_first_abs_lappd.str().c_str(),dimensionLAPPD,0,
-        dimensionLAPPD,dimensionLAPPD,0,dimensionLAPPD
-      );    //resolution in x/y direction should be 1cm, over a total length of 20cm each
-      hists_time_first_abs_lappd.push_back(hist_time_first_abs_lappd);
-    }
-  }
   //---------------------------------------------------------------
   //---------------- Fill PMT images ------------------------------
   //---------------------------------------------------------------
+  // Each PMT goes to the pixel precomputed for it in BuildPixelMap. In Geometric mode several PMTs can share a
+  // pixel, and their charges are summed.
 
+  pmt_image.Reset();
   for (int i_pmt=0;i_pmt<n_tank_pmts;i_pmt++){
+    int pixel = pmt_pixel[i_pmt];
+    if (pixel < 0) continue;
     unsigned long detkey = pmt_detkeys[i_pmt];
 
-    if (maximum_pmts < 0.001) maximum_pmts = 1.;
-    if (fabs(max_time_pmts) < 0.001) max_time_pmts = 1.;
-
     double charge_fill = charge[detkey]/global_max_charge;
     double time_fill = 0.;
     double time_first_fill = 0.;
@@ -598,81 +528,33 @@ bool CNNImage::Execute(){
       time_first_fill = (time_first[detkey] - global_min_time_first) / (global_max_time_first - global_min_time_first);
     }
 
-    if (save_mode == "Geometric") {
-      //Get corresponding geometric-mode bins for 2D (x,y)-position
-      int binx_geometric = geometric_pmt_mapping[detkey].first;
-      int biny_geometric = geometric_pmt_mapping[detkey].second;
-
-      Log("CNNImage tool: Filling binx_geometric: " + std::to_string(binx_geometric) + ", biny_geometric: " \
-        + std::to_string(biny_geometric) + " with charge: " \
-        + std::to_string(charge[detkey]) + ", time: " + std::to_string(time[detkey]), v_debug, verbosity
-      );
-
-      //Fill geometric histograms
-      hist_cnn->SetBinContent(
-        binx_geometric, biny_geometric,
-        hist_cnn->GetBinContent(binx_geometric, biny_geometric) + charge_fill
-      );
-      hist_cnn_abs->SetBinContent(
-        binx_geometric, biny_geometric, hist_cnn->GetBinContent(binx_geometric, biny_geometric) + charge[detkey]
-      );
-      hist_cnn_time->SetBinContent(
-        binx_geometric, biny_geometric, time_fill
-      );
-      hist_cnn_time_abs->SetBinContent(
-        binx_geometric, biny_geometric, time[detkey]
-      );
-      hist_cnn_time_first->SetBinContent(
-        binx_geometric, biny_geometric, time_first_fill
-      );
-      hist_cnn_time_first_abs->SetBinContent(
-        binx_geometric, biny_geometric, time_first[detkey]
-      );
-    }
-
-    if (save_mode == "PMT-wise" || save_mode == "Static") {
-      //Fill the static mapping and pmt-wise histograms
-      if ((y_pmt[detkey]>=max_y || y_pmt[detkey]<=min_y) && !includeTopBottom) continue;
+    Log("CNNImage tool: Filling pixel " + std::to_string(pixel) + " with charge: " + std::to_string(charge[detkey]) \
+        + ", time: " + std::to_string(time[detkey]), v_debug, verbosity);
 
-      int index_x = static_pmt_mapping[detkey].first;
-      int index_y = static_pmt_mapping[detkey].second;
-
-      // further safety. This error should never occur, however if the mapping contains unexpected values
-      // this will be caught here.
-      if (index_x <= -1 || index_y <= -1 || index_x >= npmtsX || index_y >= npmtsY) {
-        std::cout << index_x << "   " << index_y << std::endl;
-        Log(R"LSTR(CNNImage tool: Unexpected value for index_x or index_y when filling PMT-wise histogram to produce the 2D
-            CNNImage. This error is a result of at least one of the indices being outside the size of the specified
-            matrix (Xmax, Ymax) =
-            )LSTR"
-            + std::to_string(npmtsX) + ", " + std::to_string(npmtsY)
-            + R"LSTR(), and could hint
-            toward bad values within the mapping files for the PMT-wise mode, or unexpected behaviour when loading
-            those.)LSTR",
-            v_error, verbosity);
-        return false;
-      }
-
-      hist_cnn_pmtwise->SetBinContent(index_x+1, index_y+1, charge_fill);
-      hist_cnn_abs_pmtwise->SetBinContent(index_x+1, index_y+1, charge[detkey]);
-      hist_cnn_time_pmtwise->SetBinContent(index_x+1, index_y+1, time_fill);
-      hist_cnn_time_abs_pmtwise->SetBinContent(index_x+1, index_y+1, time[detkey]);
-      hist_cnn_time_first_pmtwise->SetBinContent(index_x+1, index_y+1, time_first_fill);
-      hist_cnn_time_first_abs_pmtwise->SetBinContent(index_x+1, index_y+1, time_first[detkey]);
-
-      Log("CNNImage tool: BinContent at (" + std::to_string(index_x) + "," + std::to_string(index_y) + ") is "
-          + std::to_string(hist_cnn_pmtwise->GetBinContent(index_x+1, index_y+1)), v_debug, verbosity);
+    if (save_mode == "Geometric") {
+      pmt_image.Add(cnnimage::kCharge, pixel, charge_fill);
+      pmt_image.Add(cnnimage::kChargeAbs, pixel, charge[detkey]);
+    } else {
+      pmt_image.Set(cnnimage::kCharge, pixel, charge_fill);
+      pmt_image.Set(cnnimage::kChargeAbs, pixel, charge[detkey]);
     }
+    pmt_image.Set(cnnimage::kTime, pixel, time_fill);
+    pmt_image.Set(cnnimage::kTimeAbs, pixel, time[detkey]);
+    pmt_image.Set(cnnimage::kTimeFirst, pixel, time_first_fill);
+    pmt_image.Set(cnnimage::kTimeFirstAbs, pixel, time_first[detkey]);
   }
-  
+
   //---------------------------------------------------------------
   //---------------- Fill LAPPD images ----------------------------
   //---------------------------------------------------------------
+  // One dimensionLAPPD x dimensionLAPPD plane per LAPPD, rows in y
   if (use_LAPPDs) {
+    lappd_image.Reset();
     for (unsigned int i_lappd=0; i_lappd<lappd_detkeys.size(); i_lappd++){
       unsigned long detkey = lappd_detkeys.at(i_lappd);
       for (int iX=0; iX < dimensionLAPPD; iX++){
         for (int iY=0; iY < dimensionLAPPD; iY++){
+          int pixel = (i_lappd*dimensionLAPPD + iY)*dimensionLAPPD + iX;
           double lappd_charge_fill = charge_lappd[detkey].at(iX).at(iY)/global_max_charge;
           double lappd_time_fill = 0.;
           double lappd_time_first_fill = 0.;
@@ -686,36 +568,30 @@ bool CNNImage::Execute(){
               << max_time_lappds << ", time_lappd: " << time_lappd[detkey].at(iX).at(iY) << ", fill time: " \
               << lappd_time_fill << std::endl;
           }
-          hists_lappd.at(i_lappd)->SetBinContent(iX+1,iY+1,lappd_charge_fill);
-          hists_abs_lappd.at(i_lappd)->SetBinContent(iX+1,iY+1,charge_lappd[detkey].at(iX).at(iY));
-          hists_time_lappd.at(i_lappd)->SetBinContent(iX+1,iY+1,lappd_time_fill);
-          hists_time_first_lappd.at(i_lappd)->SetBinContent(iX+1,iY+1,lappd_time_first_fill);
-          hists_time_abs_lappd.at(i_lappd)->SetBinContent(iX+1,iY+1,time_lappd[detkey].at(iX).at(iY));
-          hists_time_first_abs_lappd.at(i_lappd)->SetBinContent(iX+1,iY+1,time_first_lappd[detkey].at(iX).at(iY));
+          lappd_image.Set(cnnimage::kCharge, pixel, lappd_charge_fill);
+          lappd_image.Set(cnnimage::kChargeAbs, pixel, charge_lappd[detkey].at(iX).at(iY));
+          lappd_image.Set(cnnimage::kTime, pixel, lappd_time_fill);
+          lappd_image.Set(cnnimage::kTimeFirst, pixel, lappd_time_first_fill);
+          lappd_image.Set(cnnimage::kTimeAbs, pixel, time_lappd[detkey].at(iX).at(iY));
+          lappd_image.Set(cnnimage::kTimeFirstAbs, pixel, time_first_lappd[detkey].at(iX).at(iY));
         }
       }
     }
   }
 
   // Define vector that will store the CNNImage used in the CNN tools
-  int cnn_image_size = 0;
-  if (save_mode == "Static") cnn_image_size = 160;
-  if (save_mode == "PMT-Wise") cnn_image_size = 160;
-  if (save_mode == "Geometric") cnn_image_size = hist_cnn->GetNbinsY() *  hist_cnn->GetNbinsX();
+  size_t n_pixels = pmt_image.NumPixels();
+  size_t cnn_image_size = n_pixels;
+  if (save_mode == "Static") cnn_image_size = std::max<size_t>(160, n_pixels);
   std::vector<double> cnn_image_charge(cnn_image_size, 0);
   std::vector<double> cnn_image_charge_abs(cnn_image_size, 0);
   std::vector<double> cnn_image_time(cnn_image_size, 0);
   std::vector<double> cnn_image_time_first(cnn_image_size, 0);
 
   //---------------------------------------------------------------
-  //---------------- Write information to csv----------------------
+  //---------------- Write information to file --------------------
   //---------------------------------------------------------------
 
-  //
-  // Save information from histogram to csv file
-  // (1 line corresponds to 1 event, histogram entries flattened out to a 1D array)
-  //
-
   bool passed_eventselection;
   m_data->Stores["RecoEvent"]->Get("EventCutStatus",passed_eventselection);
   Log("CNNImage tool: Passed Event Selection: "+std::to_string(passed_eventselection),v_message,verbosity);
@@ -727,139 +603,52 @@ bool CNNImage::Execute(){
       outfile_MRD << mrdeventcounter << "," << num_mrd_paddles_cluster << "," << num_mrd_layers_cluster<< "," \
         << num_mrd_conslayers_cluster << "," << num_mrd_adjacent_cluster << "," << mrd_padperlayer_cluster << endl;
 
-      // Save root histograms
-      std::vector<TH2F*> temp_histograms_to_write_vec = {
-        hist_cnn, hist_cnn_abs, hist_cnn_time, hist_cnn_time_first, hist_cnn_time_abs, hist_cnn_time_first_abs,
-        hist_cnn_pmtwise, hist_cnn_abs_pmtwise, hist_cnn_time_pmtwise, hist_cnn_time_first_pmtwise,
-        hist_cnn_time_abs_pmtwise, hist_cnn_time_first_abs_pmtwise
-      };
-
-      for (auto hist : temp_histograms_to_write_vec) {
-        hist->Write();
-      }
-
-      if (use_LAPPDs) {
-        for (unsigned int i_lappd=0; i_lappd<lappd_detkeys.size();i_lappd++){
-          hists_lappd.at(i_lappd)->Write();
-          hists_abs_lappd.at(i_lappd)->Write();
-          hists_time_lappd.at(i_lappd)->Write();
-          hists_time_first_lappd.at(i_lappd)->Write();
-          hists_time_abs_lappd.at(i_lappd)->Write();
-          hists_time_first_abs_lappd.at(i_lappd)->Write();
+      if (write_csv) {
+        WriteROOTHistograms();
+
+        //
+        // Save the images to csv files
+        // (1 line corresponds to 1 event, images flattened out to a 1D array, x running fastest)
+        //
+        WriteImageCSV(outfile, pmt_image.Plane(cnnimage::kCharge), n_pixels);
+        WriteImageCSV(outfile_abs, pmt_image.Plane(cnnimage::kChargeAbs), n_pixels);
+        WriteImageCSV(outfile_time, pmt_image.Plane(cnnimage::kTime), n_pixels);
+        WriteImageCSV(outfile_time_first, pmt_image.Plane(cnnimage::kTimeFirst), n_pixels);
+        WriteImageCSV(outfile_time_abs, pmt_image.Plane(cnnimage::kTimeAbs), n_pixels);
+        WriteImageCSV(outfile_time_first_abs, pmt_image.Plane(cnnimage::kTimeFirstAbs), n_pixels);
+
+        if (use_LAPPDs && save_mode != "Geometric") {
+          size_t n_lappd_pixels = lappd_image.NumPixels();
+          WriteImageCSV(outfile_lappd, lappd_image.Plane(cnnimage::kCharge), n_lappd_pixels);
+          WriteImageCSV(outfile_lappd_abs, lappd_image.Plane(cnnimage::kChargeAbs), n_lappd_pixels);
+          WriteImageCSV(outfile_lappd_time, lappd_image.Plane(cnnimage::kTime), n_lappd_pixels);
+          WriteImageCSV(outfile_lappd_time_first, lappd_image.Plane(cnnimage::kTimeFirst), n_lappd_pixels);
+          WriteImageCSV(outfile_lappd_time_abs, lappd_image.Plane(cnnimage::kTimeAbs), n_lappd_pixels);
+          WriteImageCSV(outfile_lappd_time_first_abs, lappd_image.Plane(cnnimage::kTimeFirstAbs), n_lappd_pixels);
         }
       }
 
-      if (save_mode == "Geometric"){
-        for (int i_binY=0; i_binY < hist_cnn->GetNbinsY();i_binY++){
-          for (int i_binX=0; i_binX < hist_cnn->GetNbinsX();i_binX++){
-            PopulateHistInFilePMT(outfile, hist_cnn, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_abs, hist_cnn_abs, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_time, hist_cnn_time, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_time_first, hist_cnn_time_first, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_time_abs, hist_cnn_time_abs, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_time_first_abs, hist_cnn_time_first_abs, i_binX, i_binY);
-
-            cnn_image_charge[i_binY*hist_cnn->GetNbinsX() + i_binX] = hist_cnn->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_charge_abs[i_binY*hist_cnn_abs->GetNbinsX() + i_binX] = hist_cnn_abs->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_time[i_binY*hist_cnn_time->GetNbinsX() + i_binX] = hist_cnn_time->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_time_first[i_binY*hist_cnn_time_first->GetNbinsX() + i_binX] = hist_cnn_time_first->GetBinContent(i_binX+1,i_binY+1);
-          }
-        }
-      } else if (save_mode == "PMT-wise" || save_mode == "Static"){
-        for (int i_binY=0; i_binY < hist_cnn_pmtwise->GetNbinsY();i_binY++){
-          for (int i_binX=0; i_binX < hist_cnn_pmtwise->GetNbinsX();i_binX++){
-            PopulateHistInFilePMT(outfile, hist_cnn_pmtwise, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_abs, hist_cnn_abs_pmtwise, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_time, hist_cnn_time_pmtwise, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_time_first, hist_cnn_time_first_pmtwise, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_time_abs, hist_cnn_time_abs_pmtwise, i_binX, i_binY);
-            PopulateHistInFilePMT(outfile_time_first_abs, hist_cnn_time_first_abs_pmtwise, i_binX, i_binY);
-
-            cnn_image_charge[i_binY*hist_cnn_pmtwise->GetNbinsX() + i_binX] = hist_cnn_pmtwise->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_charge_abs[i_binY*hist_cnn_abs_pmtwise->GetNbinsX() + i_binX] = hist_cnn_abs_pmtwise->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_time[i_binY*hist_cnn_time_pmtwise->GetNbinsX() + i_binX] = hist_cnn_time_pmtwise->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_time_first[i_binY*hist_cnn_time_first_pmtwise->GetNbinsX() + i_binX] = hist_cnn_time_first_pmtwise->GetBinContent(i_binX+1,i_binY+1);
-          }
-        }
-        if (use_LAPPDs) {
-          for (unsigned int i_lappd=0;i_lappd<lappd_detkeys.size();i_lappd++){
-            for (int i_binY=0; i_binY < hists_lappd.at(i_lappd)->GetNbinsY();i_binY++){
-              for (int i_binX=0; i_binX < hists_lappd.at(i_lappd)->GetNbinsX();i_binX++){
-                outfile_lappd << hists_lappd.at(i_lappd)->GetBinContent(i_binX+1,i_binY+1);
-                outfile_lappd_abs << hists_abs_lappd.at(i_lappd)->GetBinContent(i_binX+1,i_binY+1);
-                if (i_binX != hists_lappd.at(i_lappd)->GetNbinsX()-1 || i_binY!=hists_lappd.at(i_lappd)->GetNbinsY()-1 || i_lappd != lappd_detkeys.size()-1) {
-                  outfile_lappd<<",";
-                  outfile_lappd_abs<<",";
-                }
-                outfile_lappd_time << hists_time_lappd.at(i_lappd)->GetBinContent(i_binX+1,i_binY+1);
-                outfile_lappd_time_first << hists_time_first_lappd.at(i_lappd)->GetBinContent(i_binX+1,i_binY+1);
-                outfile_lappd_time_abs << hists_time_abs_lappd.at(i_lappd)->GetBinContent(i_binX+1,i_binY+1);
-                outfile_lappd_time_first_abs << hists_time_first_abs_lappd.at(i_lappd)->GetBinContent(i_binX+1,i_binY+1);
-                if (i_binX != hists_time_lappd.at(i_lappd)->GetNbinsX()-1 || i_binY!=hists_time_lappd.at(i_lappd)->GetNbinsY()-1 || i_lappd != lappd_detkeys.size()-1) {
-                  outfile_lappd_time<<",";
-                  outfile_lappd_time_first<<",";
-                  outfile_lappd_time_abs<<",";
-                  outfile_lappd_time_first_abs<<",";
-                }
-              }
-            }
-          }
-          outfile_lappd << std::endl;
-          outfile_lappd_abs << std::endl;
-          outfile_lappd_time << std::endl;
-          outfile_lappd_time_first << std::endl;
-          outfile_lappd_time_abs << std::endl;
-          outfile_lappd_time_first_abs << std::endl;
-        }
-      }
-
-      Log("MCRecoEventLoader Tool: Push projected Mrd Hit", v_message, verbosity);
-
-      outfile << std::endl;
-      outfile_abs << std::endl;
-      outfile_time << std::endl;
-      outfile_time_first << std::endl;
-      outfile_time_abs << std::endl;
-      outfile_time_first_abs << std::endl;
-    } else {
-      if (save_mode == "Geometric") {
-        for (int i_binY=0; i_binY < hist_cnn->GetNbinsY();i_binY++) {
-          for (int i_binX=0; i_binX < hist_cnn->GetNbinsX();i_binX++) {
-            cnn_image_charge[i_binY*hist_cnn->GetNbinsX() + i_binX] = hist_cnn->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_charge_abs[i_binY*hist_cnn_abs->GetNbinsX() + i_binX] = hist_cnn_abs->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_time[i_binY*hist_cnn_time->GetNbinsX() + i_binX] = hist_cnn_time->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_time_first[i_binY*hist_cnn_time_first->GetNbinsX() + i_binX] = hist_cnn_time_first->GetBinContent(i_binX+1,i_binY+1);
-          }
-        }
-      }
-      else if (save_mode == "PMT-wise" || save_mode == "Static") {
-        for (int i_binY=0; i_binY < hist_cnn_pmtwise->GetNbinsY();i_binY++) {
-          for (int i_binX=0; i_binX < hist_cnn_pmtwise->GetNbinsX();i_binX++) {
-            cnn_image_charge[i_binY*hist_cnn_pmtwise->GetNbinsX() + i_binX] = hist_cnn_pmtwise->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_charge_abs[i_binY*hist_cnn_abs_pmtwise->GetNbinsX() + i_binX] = hist_cnn_abs_pmtwise->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_time[i_binY*hist_cnn_time_pmtwise->GetNbinsX() + i_binX] = hist_cnn_time_pmtwise->GetBinContent(i_binX+1,i_binY+1);
-            cnn_image_time_first[i_binY*hist_cnn_time_first_pmtwise->GetNbinsX() + i_binX] = hist_cnn_time_first_pmtwise->GetBinContent(i_binX+1,i_binY+1);
-          }
-        }
+      if (write_npy) {
+        if (!WriteTensor(npy_pmt, pmt_image)) return false;
+        if (use_LAPPDs && !WriteTensor(npy_lappd, lappd_image)) return false;
       }
     }
 
+    const float* image_charge = pmt_image.Plane(cnnimage::kCharge);
+    const float* image_charge_abs = pmt_image.Plane(cnnimage::kChargeAbs);
+    const float* image_time = pmt_image.Plane(cnnimage::kTime);
+    const float* image_time_first = pmt_image.Plane(cnnimage::kTimeFirst);
+    std::copy(image_charge, image_charge + n_pixels, cnn_image_charge.begin());
+    std::copy(image_charge_abs, image_charge_abs + n_pixels, cnn_image_charge_abs.begin());
+    std::copy(image_time, image_time + n_pixels, cnn_image_time.begin());
+    std::copy(image_time_first, image_time_first + n_pixels, cnn_image_time_first.begin());
+
     m_data->Stores.at("RecoEvent")->Set("CNNImageCharge", cnn_image_charge);
     m_data->Stores.at("RecoEvent")->Set("CNNImageChargeAbs", cnn_image_charge_abs);
     m_data->Stores.at("RecoEvent")->Set("CNNImageTime", cnn_image_time);
     m_data->Stores.at("RecoEvent")->Set("CNNImageTimeFirst", cnn_image_time_first);
   }
 
-  //TODO: Delete histograms after accessing them -> resetting instead of recreating
-  for (unsigned int i_lappd=0; i_lappd<lappd_detkeys.size();i_lappd++){
-    delete hists_lappd.at(i_lappd);
-    delete hists_abs_lappd.at(i_lappd);
-    delete hists_time_lappd.at(i_lappd);
-    delete hists_time_first_lappd.at(i_lappd);
-    delete hists_time_abs_lappd.at(i_lappd);
-    delete hists_time_first_abs_lappd.at(i_lappd);
-  }
-
   return true;
 }
 
@@ -881,7 +670,7 @@ bool CNNImage::Finalise(){
     delete hist_cnn_time_abs_pmtwise;
     delete hist_cnn_time_first_abs_pmtwise;
 
-    file->Close();
+    if (file) file->Close();
     outfile.close();
     outfile_abs.close();
     outfile_time.close();
@@ -897,6 +686,13 @@ bool CNNImage::Finalise(){
     outfile_Rings.close();
     outfile_MRD.close();
   }
+  if (npy_pmt.IsOpen()) {
+    Log("CNNImage tool: Wrote " + std::to_string(npy_pmt.NumEvents()) + " events to " + cnn_outpath + "_pmt.npy", v_message, verbosity);
+    if (!npy_pmt.Close()) Log("CNNImage tool: Error writing " + cnn_outpath + "_pmt.npy", v_error, verbosity);
+  }
+  if (npy_lappd.IsOpen() && !npy_lappd.Close()) {
+    Log("CNNImage tool: Error writing " + cnn_outpath + "_lappd.npy", v_error, verbosity);
+  }
   return true;
 }
 
@@ -1338,9 +1134,127 @@ void CNNImage::ReadoutMRD() {
   }
 }
 
-void CNNImage::PopulateHistInFilePMT(ofstream &outfile, TH2F* hist, int binX, int binY) {
-  outfile << hist->GetBinContent(binX+1, binY+1);
-  if (binX != hist->GetNbinsX()-1 || binY!=hist->GetNbinsY()-1) {
-    outfile << ",";
+bool CNNImage::BuildPixelMap() {
+  // Flat (y, x) pixel index of every tank PMT in the image, -1 for the PMTs that are not drawn
+  if (save_mode == "Geometric") {
+    image_nx = hist_cnn->GetNbinsX();
+    image_ny = hist_cnn->GetNbinsY();
+  } else {
+    image_nx = npmtsX;
+    image_ny = npmtsY;
+  }
+  pmt_pixel.assign(pmt_detkeys.size(), -1);
+
+  for (unsigned int i_pmt = 0; i_pmt < pmt_detkeys.size(); i_pmt++) {
+    unsigned long detkey = pmt_detkeys[i_pmt];
+    if (save_mode == "Geometric") {
+      // histogram bins start at 1, under- and overflow bins are not part of the image
+      int binx_geometric = geometric_pmt_mapping[detkey].first;
+      int biny_geometric = geometric_pmt_mapping[detkey].second;
+      if (binx_geometric < 1 || binx_geometric > image_nx || biny_geometric < 1 || biny_geometric > image_ny) continue;
+      pmt_pixel[i_pmt] = (biny_geometric-1)*image_nx + (binx_geometric-1);
+    } else {
+      if ((y_pmt[detkey]>=max_y || y_pmt[detkey]<=min_y) && !includeTopBottom) continue;
+
+      int index_x = static_pmt_mapping[detkey].first;
+      int index_y = static_pmt_mapping[detkey].second;
+
+      // further safety. This error should never occur, however if the mapping contains unexpected values
+      // this will be caught here.
+      if (index_x <= -1 || index_y <= -1 || index_x >= npmtsX || index_y >= npmtsY) {
+        Log("CNNImage tool: Unexpected value (" + std::to_string(index_x) + "," + std::to_string(index_y) \
+            + ") in the PMT-wise mapping of detkey " + std::to_string(detkey) + ", outside of the (Xmax, Ymax) = (" \
+            + std::to_string(npmtsX) + ", " + std::to_string(npmtsY) + ") matrix. This could hint toward bad values " \
+            + "within the mapping files for the PMT-wise mode, or unexpected behaviour when loading those.",
+            v_error, verbosity);
+        return false;
+      }
+      pmt_pixel[i_pmt] = index_y*image_nx + index_x;
+    }
+  }
+
+  pmt_image.Resize(image_nx*image_ny);
+  if (use_LAPPDs) lappd_image.Resize(lappd_detkeys.size()*dimensionLAPPD*dimensionLAPPD);
+  return true;
+}
+
+void CNNImage::WriteImageCSV(ofstream &outfile, const float* image, size_t n_pixels) {
+  for (size_t i_pixel = 0; i_pixel < n_pixels; i_pixel++) {
+    outfile << image[i_pixel];
+    if (i_pixel != n_pixels-1) outfile << ",";
+  }
+  outfile << std::endl;
+}
+
+bool CNNImage::WriteTensor(cnnimage::NpyWriter &writer, const cnnimage::Image &image) {
+  float* event = writer.NewEvent();
+  if (!event) {
+    Log("CNNImage tool: Error writing the npy output of event " + std::to_string(evnum), v_error, verbosity);
+    return false;
   }
-}
\ No newline at end of file
+  size_t n_pixels = image.NumPixels();
+  for (size_t i_channel = 0; i_channel < tensor_channels.size(); i_channel++) {
+    const float* plane = image.Plane(tensor_channels[i_channel]);
+    std::copy(plane, plane + n_pixels, event + i_channel*n_pixels);
+  }
+  return true;
+}
+
+void CNNImage::WriteROOTHistograms() {
+  // The images of this event as one histogram each, in the order of cnnimage::Channel
+  const std::vector<std::string> names = {"hist_cnn", "hist_cnn_abs", "hist_cnn_time", "hist_cnn_time_first",
+    "hist_cnn_time_abs", "hist_cnn_time_first_abs"};
+  const std::vector<std::string> lappd_names = {"hist_lappd", "hist_lappd_abs", "hist_time_lappd",
+    "hist_time_first_lappd", "hist_time_abs_lappd", "hist_time_first_abs_lappd"};
+  const std::vector<std::string> titles = {"EventDisplay", "EventDisplay Charge", "EventDisplay Time",
+    "EventDisplay First Times", "EventDisplay Absolute Times", "EventDisplay Absolute First Times"};
+
+  // Both sets of histograms are written for every event, as they always have been;
+  // the ones of the mode that is not in use stay empty
+  const std::vector<TH2F*> hists_geometric = {hist_cnn, hist_cnn_abs, hist_cnn_time, hist_cnn_time_first,
+    hist_cnn_time_abs, hist_cnn_time_first_abs};
+  const std::vector<TH2F*> hists_pmtwise = {hist_cnn_pmtwise, hist_cnn_abs_pmtwise, hist_cnn_time_pmtwise,
+    hist_cnn_time_first_pmtwise, hist_cnn_time_abs_pmtwise, hist_cnn_time_first_abs_pmtwise};
+
+  for (int i_mode = 0; i_mode < 2; i_mode++) {
+    bool geometric = (i_mode == 0);
+    bool filled = (geometric == (save_mode == "Geometric"));
+    const std::vector<TH2F*> &hists = (geometric) ? hists_geometric : hists_pmtwise;
+    std::string suffix = (geometric) ? "" : "_pmtwise";
+    std::string title_suffix = (geometric) ? " (CNN), Event " : " (CNN, pmt wise), Event ";
+
+    for (int i_channel = 0; i_channel < cnnimage::kNumChannels; i_channel++) {
+      TH2F* hist = hists.at(i_channel);
+      hist->Reset();
+      hist->SetName((names.at(i_channel) + suffix + std::to_string(evnum)).c_str());
+      hist->SetTitle((titles.at(i_channel) + title_suffix + std::to_string(evnum)).c_str());
+      if (filled) {
+        const float* plane = pmt_image.Plane(i_channel);
+        for (int i_binY = 0; i_binY < image_ny; i_binY++) {
+          for (int i_binX = 0; i_binX < image_nx; i_binX++) {
+            hist->SetBinContent(i_binX+1, i_binY+1, plane[i_binY*image_nx + i_binX]);
+          }
+        }
+      }
+      hist->Write();
+    }
+  }
+
+  if (use_LAPPDs) {
+    for (unsigned int i_lappd = 0; i_lappd < lappd_detkeys.size(); i_lappd++) {
+      for (int i_channel = 0; i_channel < cnnimage::kNumChannels; i_channel++) {
+        const float* plane = lappd_image.Plane(i_channel) + i_lappd*dimensionLAPPD*dimensionLAPPD;
+        std::string name = lappd_names.at(i_channel) + std::to_string(i_lappd) + "_ev" + std::to_string(evnum);
+        std::string title = titles.at(i_channel) + " (CNN), LAPPD " + std::to_string(i_lappd) + ", Event " + std::to_string(evnum);
+        //resolution in x/y direction should be 1cm, over a total length of 20cm each
+        TH2F hist_lappd(name.c_str(), title.c_str(), dimensionLAPPD, 0, dimensionLAPPD, dimensionLAPPD, 0, dimensionLAPPD);
+        for (int i_binY = 0; i_binY < dimensionLAPPD; i_binY++) {
+          for (int i_binX = 0; i_binX < dimensionLAPPD; i_binX++) {
+            hist_lappd.SetBinContent(i_binX+1, i_binY+1, plane[i_binY*dimensionLAPPD + i_binX]);
+          }
+        }
+        hist_lappd.Write();
+      }
+    }
+  }
+}
@@ -14,6 +14,8 @@
 
 #include "Tool.h"
 
+#include "TensorWriter.h"
+
 
 /**
 * \class CNNImage
@@ -50,7 +52,10 @@ class CNNImage: public Tool {
 
   void ReadoutMRD();
 
-  void PopulateHistInFilePMT(ofstream &outfile, TH2F* hist, int binX, int binY);
+  bool BuildPixelMap(); ///<Image pixel of every tank PMT, from the static or geometric mapping
+  void WriteImageCSV(ofstream &outfile, const float* image, size_t n_pixels); ///<One csv line per event
+  bool WriteTensor(cnnimage::NpyWriter &writer, const cnnimage::Image &image); ///<The TensorChannels of an image as one npy event
+  void WriteROOTHistograms(); ///<The images of the event as TH2F histograms in the root file
 
  private:
 
@@ -61,6 +66,9 @@ class CNNImage: public Tool {
   std::string save_mode;  //How is the PMT information supposed to be written out? Geometric/PMT-wise
   bool use_LAPPDs;
   bool write_to_file;
+  std::string output_format; //csv, npy or both
+  bool write_csv, write_npy;
+  std::vector<cnnimage::Channel> tensor_channels; //image types stacked in the npy output
   int dimensionX;        //dimension of the CNN image in x-direction
   int dimensionY;        //dimension of the CNN image in y-direction
   int dimensionLAPPD;    //dimension of LAPPD CNN images (both directions, square)
@@ -68,6 +76,12 @@ class CNNImage: public Tool {
 
   std::map<unsigned long, std::pair<int, int> > static_pmt_mapping;
   std::map<unsigned long, std::pair<int, int> > geometric_pmt_mapping;
+  std::vector<int> pmt_pixel;  //pixel of each PMT in pmt_detkeys, -1 if not in the image
+  int image_nx, image_ny;
+
+  // Images of the current event
+  cnnimage::Image pmt_image;   //image_ny x image_nx
+  cnnimage::Image lappd_image; //one dimensionLAPPD x dimensionLAPPD plane per LAPPD
 
   bool isData;
   int verbosity;
@@ -123,6 +137,7 @@ class CNNImage: public Tool {
   // I/O variables
   ofstream outfile, outfile_abs, outfile_time, outfile_time_first, outfile_time_abs, outfile_time_first_abs, outfile_lappd, outfile_lappd_abs, outfile_lappd_time, outfile_lappd_time_first, outfile_lappd_time_abs, outfile_lappd_time_first_abs, outfile_Rings, outfile_MRD;
   TFile *file = nullptr;
+  cnnimage::NpyWriter npy_pmt, npy_lappd;
 
   // PMT information
   std::map<int, double> x_pmt, y_pmt, z_pmt, x_lappd, y_lappd, z_lappd;
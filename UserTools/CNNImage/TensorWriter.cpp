@@ -0,0 +1,99 @@
+#include "TensorWriter.h"
+
+namespace {
+
+  const char* channel_names[cnnimage::kNumChannels] = {
+    "charge", "charge_abs", "time", "time_first", "time_abs", "time_first_abs"
+  };
+
+}
+
+const char* cnnimage::ChannelName(int channel){
+  return (channel>=0 && channel<kNumChannels) ? channel_names[channel] : "";
+}
+
+bool cnnimage::ParseChannel(const std::string& name, Channel& channel){
+  for(int i=0; i<kNumChannels; ++i){
+    if(name==channel_names[i]){
+      channel = static_cast<Channel>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+// NPY format 1.0: magic, version, little endian header length, then a python
+// dict literal padded with spaces to a multiple of 64 bytes and ending in '\n'
+std::string cnnimage::NpyWriter::Header(size_t events) const {
+  std::string dict = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + std::to_string(events);
+  for(size_t dim : shape) dict += ", " + std::to_string(dim);
+  dict += "), }";
+  size_t size = header_size;
+  if(size==0){
+    // leave room for any event count, so the header never has to grow
+    size = 10 + dict.size() + 20 + 1;
+    size = (size+63)/64*64;
+  }
+  std::string header("\x93NUMPY\x01\x00",8);
+  size_t dict_size = size - 10;
+  header += static_cast<char>(dict_size & 0xff);
+  header += static_cast<char>(dict_size >> 8);
+  header += dict;
+  header.append(size - header.size() - 1,' ');
+  header += '\n';
+  return header;
+}
+
+bool cnnimage::NpyWriter::Open(const std::string& filename, const std::vector<size_t>& event_shape, size_t chunk_events, std::string& error){
+  Close();
+  shape = event_shape;
+  event_size = 1;
+  for(size_t dim : shape) event_size *= dim;
+  chunk = std::max<size_t>(chunk_events,1);
+  nevents = 0;
+  nbuffered = 0;
+  buffer.assign(chunk*event_size,0.f);
+
+  file = fopen(filename.c_str(),"wb");
+  if(file==nullptr){
+    error = "could not open "+filename+" for writing";
+    return false;
+  }
+  header_size = 0;
+  std::string header = Header(0);
+  header_size = header.size();
+  if(fwrite(header.data(),1,header.size(),file)!=header.size()){
+    error = "could not write the header of "+filename;
+    fclose(file);
+    file = nullptr;
+    return false;
+  }
+  return true;
+}
+
+float* cnnimage::NpyWriter::NewEvent(){
+  if(file==nullptr) return nullptr;
+  if(nbuffered==chunk && !Flush()) return nullptr;
+  float* event = buffer.data() + nbuffered*event_size;
+  std::fill(event,event+event_size,0.f);
+  ++nbuffered;
+  ++nevents;
+  return event;
+}
+
+bool cnnimage::NpyWriter::Flush(){
+  if(nbuffered>0 && fwrite(buffer.data(),sizeof(float),nbuffered*event_size,file)!=nbuffered*event_size) return false;
+  nbuffered = 0;
+  // rewrite the event count, then go back to the end for the next chunk
+  std::string header = Header(nevents);
+  if(fseek(file,0,SEEK_SET)!=0 || fwrite(header.data(),1,header.size(),file)!=header.size()) return false;
+  return fseek(file,0,SEEK_END)==0 && fflush(file)==0;
+}
+
+bool cnnimage::NpyWriter::Close(){
+  if(file==nullptr) return true;
+  bool ok = Flush();
+  ok = (fclose(file)==0) && ok;
+  file = nullptr;
+  return ok;
+}
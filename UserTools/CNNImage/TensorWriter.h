@@ -0,0 +1,83 @@
+#ifndef TensorWriter_H
+#define TensorWriter_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Fixed-shape float32 event images, and a writer for them in the NumPy .npy
+// format, so they can be read with numpy.load (also with mmap_mode='r')
+namespace cnnimage {
+
+  // the image types CNNImage makes, in the order they are stored
+  enum Channel { kCharge, kChargeAbs, kTime, kTimeFirst, kTimeAbs, kTimeFirstAbs, kNumChannels };
+
+  const char* ChannelName(int channel);
+  // "charge", "charge_abs", "time", "time_first", "time_abs", "time_first_abs"
+  bool ParseChannel(const std::string& name, Channel& channel);
+
+  // kNumChannels planes of npixels float pixels
+  class Image {
+
+   public:
+
+    void Resize(size_t npixels_in){ npixels = npixels_in; pixels.assign(kNumChannels*npixels,0.f); }
+    void Reset(){ std::fill(pixels.begin(),pixels.end(),0.f); }
+    size_t NumPixels() const { return npixels; }
+
+    float* Plane(int channel){ return pixels.data() + channel*npixels; }
+    const float* Plane(int channel) const { return pixels.data() + channel*npixels; }
+    // the sum is rounded to float once, as TH2F::SetBinContent(GetBinContent()+value) does
+    void Add(int channel, int pixel, double value){ float& p = Plane(channel)[pixel]; p = p + value; }
+    void Set(int channel, int pixel, double value){ Plane(channel)[pixel] = value; }
+
+   private:
+
+    size_t npixels = 0;
+    std::vector<float> pixels;
+
+  };
+
+  // Appends events of a fixed shape to a .npy file, whose shape is
+  // (events, event_shape...). Events are buffered and written chunk_events at
+  // a time; the event count in the header is updated after every chunk, so
+  // the file is readable up to the last chunk even if the job dies.
+  class NpyWriter {
+
+   public:
+
+    NpyWriter() = default;
+    NpyWriter(const NpyWriter&) = delete;
+    NpyWriter& operator=(const NpyWriter&) = delete;
+    ~NpyWriter(){ Close(); }
+
+    bool Open(const std::string& filename, const std::vector<size_t>& event_shape, size_t chunk_events, std::string& error);
+    bool IsOpen() const { return file!=nullptr; }
+    // the EventSize() values of the next event, to be filled in; nullptr if
+    // writing out the previous chunk failed
+    float* NewEvent();
+    size_t EventSize() const { return event_size; }
+    size_t NumEvents() const { return nevents; }
+    bool Close();
+
+   private:
+
+    bool Flush();
+    std::string Header(size_t events) const;
+
+    FILE* file = nullptr;
+    size_t header_size = 0;
+    std::vector<size_t> shape;
+    size_t event_size = 0;
+    size_t chunk = 1;
+    size_t nevents = 0;               // written and buffered
+    size_t nbuffered = 0;
+    std::vector<float> buffer;
+
+  };
+
+}
+
+#endif
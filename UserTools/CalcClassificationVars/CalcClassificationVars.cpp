@@ -1,4 +1,7 @@
 #include "CalcClassificationVars.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(CalcClassificationVars);
 
 CalcClassificationVars::CalcClassificationVars():Tool(){}
 
@@ -55,6 +58,9 @@ bool CalcClassificationVars::Initialise(std::string configfile, DataModel &data)
     		if (pmts_y[chankey]<tank_ymin) tank_ymin = pmts_y.at(chankey);
   	}
 
+	// Angles of the tube positions are filled in as the tubes are first seen
+	tube_angles.assign(n_tank_pmts+1,classvars::TubeAngles());
+
 	if (isData){
 		//Get single PE gains when looking at data
 		ifstream file_singlepe(singlePEgains.c_str());
@@ -78,6 +84,13 @@ bool CalcClassificationVars::Initialise(std::string configfile, DataModel &data)
 	//Create mapping of variables to their respective variable type map
 	this->InitialiseClassificationMaps();
 
+	//Names of the entries of the PMT/LAPPD feature row
+	std::vector<std::string> feature_names;
+	for (int i_feature = 0; i_feature < classvars::kNFeatures; i_feature++){
+		feature_names.push_back(classvars::FeatureName(i_feature));
+	}
+	m_data->Stores["Classification"]->Set("PMTLAPPDFeatureNames",feature_names);
+
 	
 	return true;
 }
@@ -233,6 +246,10 @@ void CalcClassificationVars::InitialisePDFs(){
 	event_time = new TH1F("event_time","Time values for event",nbins_time,min_time,max_time);
 	event_theta = new TH1F("event_theta","Theta values for event",nbins_theta,min_theta,max_theta);
 	event_phi = new TH1F("event_phi","Phi values for event",nbins_phi,min_phi,max_phi);
+	event_hists[kCharge].Book(nbins_charge,min_charge,max_charge);
+	event_hists[kTime].Book(nbins_time,min_time,max_time);
+	event_hists[kTheta].Book(nbins_theta,min_theta,max_theta);
+	event_hists[kPhi].Book(nbins_phi,min_phi,max_phi);
 	
 	// Single/multi-ring pdfs
 	f_rings = new TFile(pdf_rings.c_str(),"READ");
@@ -414,513 +431,385 @@ void CalcClassificationVars::ClassificationVarsMCTruth(){
 
 }
 
+const classvars::TubeAngles& CalcClassificationVars::GetTubeAngles(int detector_id, double x, double y, double z){
+
+	classvars::TubeAngles* angles = &uncached_angles;
+	if (detector_id >= 0){
+		if (detector_id >= int(tube_angles.size())) tube_angles.resize(detector_id+1);
+		angles = &tube_angles[detector_id];
+		if (angles->valid && angles->x == x && angles->y == y && angles->z == z) return *angles;
+	}
+
+	angles->valid = (detector_id >= 0);
+	angles->x = x;
+	angles->y = y;
+	angles->z = z;
+	angles->dist = sqrt(pow(x,2)+pow(y,2)+pow(z,2));
+	angles->theta = acos((z*1.)/angles->dist);
+	angles->phi = CalcArcTan(x,z);
+	angles->has_gain = (isData && pmt_gains.find(detector_id)!=pmt_gains.end());
+	angles->gain = (angles->has_gain)? pmt_gains.at(detector_id) : 1.;
+	return *angles;
+}
+
 void CalcClassificationVars::ClassificationVarsPMTLAPPD(){
 
 	Log("CalcClassificationVars tool: Reading out PMT/LAPPD data",v_message,verbosity);
-	
-	event_charge->Reset();
-	event_time->Reset();
-	event_theta->Reset();
-	event_phi->Reset();
-
-	// Information available both in data & MC
-	double pmt_QDownstream=0.;
-	double pmt_avgT=0.;
-	double pmt_varT=0.;
-	Position pmtBaryQ(0.,0.,0.);
-	Position pmtBaryQ_Clustered(0.,0.,0.);
-	Position pmtBaryQ_NonClustered(0.,0.,0.);
-	double pmt_totalQ=0.;
-	double pmt_totalQ_Clustered=0.;
-	double pmt_totalQ_NonClustered=0.;
-	double pmt_highestQ=0.;
-	int pmt_hits=0;
-	int pmt_hits_late=0;
-	int pmt_hits_early=0;
-	int pmt_hits_lowq=0;
-	Position lappdBaryQ(0.,0.,0.);
-	double lappd_totalQ=0.;
-	double lappd_avgT=0.;
-	double lappd_varT=0.;
-	int lappd_hits=0;
-	std::vector<double> pmtQ, lappdQ, pmtT, pmtT_tof, lappdT, lappdT_tof, pmtID, lappdID;
-	std::vector<Position> pmtPos, lappdPos;
-	std::vector<double> pmtDist, pmtTheta, pmtPhi, pmtThetaBary, pmtPhiBary, pmtY, lappdDist, lappdTheta, lappdThetaBary, pmtThetaMC, pmtThetaBaryMC, lappdThetaMC, lappdThetaBaryMC;
-	double pmt_rmsTheta=0.; 
-	double pmt_rmsThetaMC=0.;
-	double pmt_rmsPhi=0.;
-	double pmt_avgDist=0.;
-	double lappd_rmsTheta=0.;
-	double lappd_rmsThetaMC=0.;
-	double lappd_avgDist=0.;
-
- 	// Information only available when using mctruth information
-	double pmt_QRing=0.;
-	int pmt_hitsRing=0;
-	double lappd_QRing=0.;
-	int lappd_hitsRing=0;
+
+	feature_row.fill(0.);
+	pmt_digits.Clear();
+	lappd_digits.Clear();
+	for (auto& hist : event_hists) hist.Reset();
+
+	classvars::Moments pmt, lappd;
 	Log("CalcClassificationVars tool: Reading in RecoDigits object of size: "+std::to_string(RecoDigits->size()),v_debug,verbosity);
 
-	for (unsigned int i_digit = 0; i_digit < RecoDigits->size(); i_digit++){
-		RecoDigit thisdigit = RecoDigits->at(i_digit);
+	//-----------------------------------------------------------------------
+	//--------------- Read digits into columns, accumulate sums -------------
+	//-----------------------------------------------------------------------
+
+	for (const RecoDigit& thisdigit : *RecoDigits){
+
+		int digittype = thisdigit.GetDigitType();		//0 - PMTs, 1 - LAPPDs
+		if (digittype != 0 && digittype != 1){
+			std::string logmessage = "CalcClassificationVars tool: Digit type " + std::to_string(digittype) + "was not recognized. Omit reading in entry from RecoEvent store.";
+			Log(logmessage,v_message,verbosity);
+			continue;
+		}
+
 		Position detector_pos = thisdigit.GetPosition();
 		detector_pos.UnitToMeter();
-		Direction detector_dir(detector_pos.X()-pos_x,detector_pos.Y()-pos_y,detector_pos.Z()-pos_z);
-		double detector_dirX = detector_pos.X()-pos_x;
-		double detector_dirY = detector_pos.Y()-pos_y;
-		double detector_dirZ = detector_pos.Z()-pos_z;
-		int digittype = thisdigit.GetDigitType();		//0 - PMTs, 1 - LAPPDs	
 		double digitQ = thisdigit.GetCalCharge();
 		double digitT = thisdigit.GetCalTime();
-		double detDist, detTheta, detPhi;
-		double MCdetDist=0.;
-		double MCdetTheta;
 		int digitID = thisdigit.GetDetectorID();
-			
-		if (isData){
-			if (pmt_gains.find(digitID)!=pmt_gains.end()) digitQ /= pmt_gains.at(digitID);
-			digitQ/=charge_conversion;		
-		}
-
-		//Standard calculations with respect to the center of the tank
-		detDist = sqrt(pow(detector_pos.X(),2)+pow(detector_pos.Y(),2)+pow(detector_pos.Z(),2));
-		detTheta = acos((detector_pos.Z()*1.)/detDist);
-		detPhi = CalcArcTan(detector_pos.X(), detector_pos.Z());
 
-		if (!isData){
-			//For MC, do additional calculations with respect to interaction vertex
-			MCdetDist = sqrt(pow(detector_dirX,2)+pow(detector_dirY,2)+pow(detector_dirZ,2));
-			MCdetTheta = acos((detector_dirX*dir_x+detector_dirY*dir_y+detector_dirZ*dir_z)/MCdetDist);
+		//Standard calculations with respect to the center of the tank. Tank PMTs
+		//keep their position, LAPPD digits are placed along the strips.
+		double detDist, detTheta, detPhi;
+		bool has_gain;
+		double gain = 1.;
+		if (digittype == 0){
+			const classvars::TubeAngles& angles = this->GetTubeAngles(digitID,detector_pos.X(),detector_pos.Y(),detector_pos.Z());
+			detDist = angles.dist;
+			detTheta = angles.theta;
+			detPhi = angles.phi;
+			has_gain = angles.has_gain;
+			gain = angles.gain;
+		} else {
+			detDist = detector_pos.Mag();
+			detTheta = acos((detector_pos.Z()*1.)/detDist);
+			detPhi = 0.;
+			has_gain = (isData && pmt_gains.find(digitID)!=pmt_gains.end());
+			if (has_gain) gain = pmt_gains.at(digitID);
 		}
 
-		if (digittype == 0){   //PMT hit
-
-			// Time/charge variables
-			pmtQ.push_back(digitQ);
-			pmtT.push_back(digitT);
-			pmtID.push_back(digitID);
-			event_charge->Fill(digitQ);
-			event_time->Fill(digitT);
-			pmtPos.push_back(detector_pos);
-			pmt_totalQ+=digitQ;
-			pmt_avgT+=digitT;
-			pmt_hits++;
-			pmtBaryQ += digitQ*detector_pos;
-			pmt_avgDist+=detDist;
-
-			// Early/late/lowQ classification
-			if (digitQ < 30) pmt_hits_lowq++;
-			if (digitT > 10) pmt_hits_late++;	
-			else if (digitT < 4) pmt_hits_early++;
-			if (digitQ > pmt_highestQ) pmt_highestQ = digitQ;
-			if (detTheta < TMath::Pi()/2.) pmt_QDownstream+=digitQ;
-
-			// Angular variables
-			pmt_rmsTheta+=(detTheta*detTheta);
-			pmt_rmsPhi+=(detPhi*detPhi);
-			pmtDist.push_back(detDist);
-			pmtTheta.push_back(detTheta);
-			pmtPhi.push_back(detPhi);
-			pmtY.push_back(detector_dirY);
-			if (!isData) {
-				pmtThetaMC.push_back(MCdetTheta);
-				pmt_rmsThetaMC+=(MCdetTheta)*(MCdetTheta);
-			}
+		if (isData){
+			if (has_gain) digitQ /= gain;
+			digitQ/=charge_conversion;
+		}
 
-			// HitCleaner filter status
-			if (thisdigit.GetFilterStatus() == 1) {
-				pmt_totalQ_Clustered+=digitQ;
-				pmtBaryQ_Clustered += digitQ*detector_pos;
-			} else {
-				pmt_totalQ_NonClustered+=digitQ;
-				pmtBaryQ_NonClustered += digitQ*detector_pos;
-			}
+		classvars::DigitColumns& digits = (digittype == 0)? pmt_digits : lappd_digits;
+		classvars::Moments& sums = (digittype == 0)? pmt : lappd;
 
-			// Cherenkov angle-related variables
-			if (!isData){
+		// Time/charge variables
+		digits.q.push_back(digitQ);
+		digits.t.push_back(digitT);
+		digits.id.push_back(digitID);
+		digits.dist.push_back(detDist);
+		digits.theta.push_back(detTheta);
+		sums.AddTime(digitT);
+		sums.total_q+=digitQ;
+		sums.bary_q += digitQ*detector_pos;
+		sums.sum_dist+=detDist;
 
-				double tof = MCdetDist/3.0e8*1e9;
-				double t_tof = digitT-tof;
-				pmtT_tof.push_back(t_tof);
-
-				if (MCdetTheta < cherenkov_angle) {
-					pmt_QRing+=digitQ;
-					pmt_hitsRing++;
-				}
-			}
+		// Angular variables
+		sums.sum_theta2+=(detTheta*detTheta);
+		sums.sum_q_theta2+=(detTheta*detTheta)*digitQ;
 
+		if (!isData){
+			//For MC, do additional calculations with respect to interaction vertex
+			double detector_dirX = detector_pos.X()-pos_x;
+			double detector_dirY = detector_pos.Y()-pos_y;
+			double detector_dirZ = detector_pos.Z()-pos_z;
+			double MCdetDist = sqrt(pow(detector_dirX,2)+pow(detector_dirY,2)+pow(detector_dirZ,2));
+			double MCdetTheta = acos((detector_dirX*dir_x+detector_dirY*dir_y+detector_dirZ*dir_z)/MCdetDist);
+			digits.theta_mc.push_back(MCdetTheta);
+			sums.sum_theta2_mc+=(MCdetTheta*MCdetTheta);
+			sums.sum_q_theta2_mc+=(MCdetTheta*MCdetTheta)*digitQ;
 
-		} else if (digittype == 1){		//LAPPD hit
-
-			// Time/charge variables
-			lappdQ.push_back(digitQ);
-			lappdT.push_back(digitT);
-			lappdID.push_back(digitID);
-			lappdPos.push_back(detector_pos);
-			lappdBaryQ += digitQ*detector_pos;
-			lappd_totalQ+=digitQ;
-			lappd_hits++;
-			lappd_avgT+=digitT;
-			lappd_avgDist+=detDist;
-			
-			// Angular variables
-			lappd_rmsTheta+=(detTheta*detTheta);
-			lappdDist.push_back(detDist);
-			lappdTheta.push_back(detTheta);
-			if (!isData){
-				lappd_rmsThetaMC+=(MCdetTheta)*(MCdetTheta);
-				lappdThetaMC.push_back(MCdetTheta);
-			}
-			// Cherenkov-angle related variables
-			if (!isData){
-				double tof = MCdetDist/3.0e8*1e9;
-				double t_tof = digitT-tof;
-				lappdT_tof.push_back(t_tof);
-
-				if (MCdetTheta < cherenkov_angle) {
-					lappd_QRing+=digitQ;
-					lappd_hitsRing++;
-				}
+			// Cherenkov angle-related variables
+			double tof = MCdetDist/3.0e8*1e9;
+			digits.t_tof.push_back(digitT-tof);
+			if (MCdetTheta < cherenkov_angle) {
+				sums.q_ring+=digitQ;
+				sums.hits_ring++;
 			}
+		}
 
+		if (digittype != 0) continue;
+
+		//PMT-only variables
+		event_hists[kCharge].Fill(digitQ);
+		event_hists[kTime].Fill(digitT);
+		pmt_digits.phi.push_back(detPhi);
+		pmt_digits.y.push_back(detector_pos.Y()-pos_y);
+		pmt.sum_phi2+=(detPhi*detPhi);
+		pmt.sum_q_phi2+=(detPhi*detPhi)*digitQ;
+
+		// Early/late/lowQ classification
+		if (digitQ < 30) pmt.hits_lowq++;
+		if (digitT > 10) pmt.hits_late++;
+		else if (digitT < 4) pmt.hits_early++;
+		if (digitQ > pmt.highest_q) pmt.highest_q = digitQ;
+		if (detTheta < TMath::Pi()/2.) pmt.q_downstream+=digitQ;
+
+		// HitCleaner filter status
+		if (thisdigit.GetFilterStatus() == 1) {
+			pmt.q_clustered+=digitQ;
+			pmt.bary_q_clustered += digitQ*detector_pos;
 		} else {
-			
-			std::string logmessage = "CalcClassificationVars tool: Digit type " + std::to_string(digittype) + "was not recognized. Omit reading in entry from RecoEvent store.";
-			Log(logmessage,v_message,verbosity);
-			
+			pmt.q_nonclustered+=digitQ;
+			pmt.bary_q_nonclustered += digitQ*detector_pos;
 		}
-
 	}
-	
+
 	//-----------------------------------------------------------------------
 	//--------------- Calculate classification variables --------------------
 	//-----------------------------------------------------------------------
 
-	double pmt_fracRing=0.;
-	double pmt_fracRingNoWeight=0.;	
-	double pmt_frachighestQ=0.;
-	double pmt_fracQDownstream=0.;
-	double pmt_fracClustered=0.;
-	double pmt_fracLowQ=0.;
-	double pmt_fracLate=0.;
-	double pmt_fracEarly=0.;
-	double lappd_fracRing=0.;
-	double pmt_ellip = 0.;
-	double pmt_qpmt=0.;
+	classvars::FeatureRow& row = feature_row;
+	Position pmtBaryQ = pmt.bary_q;
+	Position pmtBaryQ_Clustered = pmt.bary_q_clustered;
+	Position pmtBaryQ_NonClustered = pmt.bary_q_nonclustered;
+	Position lappdBaryQ = lappd.bary_q;
+	row[classvars::kPMTQtotal] = pmt.total_q;
+	row[classvars::kPMTQtotalClustered] = pmt.q_clustered;
+	row[classvars::kPMTHits] = pmt.hits;
+	row[classvars::kLAPPDQtotal] = lappd.total_q;
+	row[classvars::kLAPPDHits] = lappd.hits;
 
-	if (pmtQ.size()!=0) {
+	if (pmt.hits!=0) {
 
 		// Average PMT charge/time/barycenter
-		pmt_avgT /= pmtQ.size();
-		pmt_avgDist /= pmtQ.size();
-		pmt_rmsTheta = sqrt(pmt_rmsTheta/pmtQ.size());
-		pmt_rmsPhi = sqrt(pmt_rmsPhi/pmtQ.size());
-		pmtBaryQ = (1./pmt_totalQ)*pmtBaryQ;
+		row[classvars::kPMTAvgT] = pmt.mean_t;
+		row[classvars::kPMTAvgDist] = pmt.sum_dist/pmt.hits;
+		row[classvars::kPMTRMSTheta] = sqrt(pmt.sum_theta2/pmt.hits);
+		row[classvars::kPMTRMSPhi] = sqrt(pmt.sum_phi2/pmt.hits);
+		pmtBaryQ = (1./pmt.total_q)*pmtBaryQ;
 		m_data->CStore.Set("pmtBaryQ",pmtBaryQ);
-		if (pmt_totalQ_Clustered > 0.) pmtBaryQ_Clustered = (1./pmt_totalQ_Clustered)*pmtBaryQ_Clustered;
-		if (pmt_totalQ_NonClustered > 0.) pmtBaryQ_NonClustered = (1./pmt_totalQ_NonClustered)*pmtBaryQ_NonClustered;
-		pmt_qpmt = pmt_totalQ/pmtQ.size();
+		if (pmt.q_clustered > 0.) pmtBaryQ_Clustered = (1./pmt.q_clustered)*pmtBaryQ_Clustered;
+		if (pmt.q_nonclustered > 0.) pmtBaryQ_NonClustered = (1./pmt.q_nonclustered)*pmtBaryQ_NonClustered;
+		row[classvars::kPMTQPerPMT] = pmt.total_q/pmt.hits;
 
 		// PMT fractions
-		pmt_fracQDownstream = pmt_QDownstream/pmt_totalQ;
-		pmt_frachighestQ = pmt_highestQ/pmt_totalQ;
-		pmt_fracClustered = pmt_totalQ_Clustered/pmt_totalQ;
-		pmt_fracLowQ = double(pmt_hits_lowq)/pmt_hits;
-		pmt_fracLate = double(pmt_hits_late)/pmt_hits;		
-		pmt_fracEarly = double(pmt_hits_early)/pmt_hits;
+		row[classvars::kPMTFracQdownstream] = pmt.q_downstream/pmt.total_q;
+		row[classvars::kPMTFracQmax] = pmt.highest_q/pmt.total_q;
+		row[classvars::kPMTFracClustered] = pmt.q_clustered/pmt.total_q;
+		row[classvars::kPMTFracLowQ] = double(pmt.hits_lowq)/pmt.hits;
+		row[classvars::kPMTFracLate] = double(pmt.hits_late)/pmt.hits;
+		row[classvars::kPMTFracEarly] = double(pmt.hits_early)/pmt.hits;
+
+		// Variances with respect to the tank center / vertex
+		row[classvars::kPMTVarT] = sqrt(pmt.m2_t/pmt.hits);
+		row[classvars::kPMTVarTheta] = sqrt(pmt.sum_q_theta2/pmt.total_q);
+		row[classvars::kPMTVarPhi] = sqrt(pmt.sum_q_phi2/pmt.total_q);
 
 		// PMT fractions related to Cherenkov ring
 		if (!isData){
-			pmt_fracRing = pmt_QRing/pmt_totalQ;
-			pmt_fracRingNoWeight = double(pmt_hitsRing)/pmt_hits;
-			pmt_rmsThetaMC = sqrt(pmt_rmsThetaMC/pmtQ.size());
+			row[classvars::kMCPMTFracRing] = pmt.q_ring/pmt.total_q;
+			row[classvars::kMCPMTFracRingNoWeight] = double(pmt.hits_ring)/pmt.hits;
+			row[classvars::kMCPMTRMSTheta] = sqrt(pmt.sum_theta2_mc/pmt.hits);
+			row[classvars::kMCPMTVarTheta] = sqrt(pmt.sum_q_theta2_mc/pmt.total_q);
 		}
 	}
-	if (lappdQ.size()!=0){
-		
+	if (lappd.hits!=0){
+
 		// Average LAPPD charge/time/barycenter
-		lappd_avgT /= lappdQ.size();
-		lappd_avgDist /= lappdQ.size();
-		lappd_rmsTheta = sqrt(lappd_rmsTheta/lappdQ.size());
-		lappdBaryQ = (1./lappd_totalQ)*lappdBaryQ;
+		row[classvars::kLAPPDAvgT] = lappd.mean_t;
+		row[classvars::kLAPPDAvgDist] = lappd.sum_dist/lappd.hits;
+		row[classvars::kLAPPDRMSTheta] = sqrt(lappd.sum_theta2/lappd.hits);
+		lappdBaryQ = (1./lappd.total_q)*lappdBaryQ;
+		row[classvars::kLAPPDVarT] = sqrt(lappd.m2_t/lappd.hits);
+		row[classvars::kLAPPDVarTheta] = sqrt(lappd.sum_q_theta2/lappd.total_q);
 
 		// LAPPD fractions related to Cherenkov ring
 		if (!isData){
-			lappd_fracRing = lappd_QRing/lappd_totalQ;
-			lappd_rmsThetaMC = sqrt(lappd_rmsThetaMC/lappdQ.size());
+			row[classvars::kMCLAPPDFracRing] = lappd.q_ring/lappd.total_q;
+			row[classvars::kMCLAPPDRMSTheta] = sqrt(lappd.sum_theta2_mc/lappd.hits);
+			row[classvars::kMCLAPPDVarTheta] = sqrt(lappd.sum_q_theta2_mc/lappd.total_q);
 		}
 	}
 
-	double pmtBaryDist, pmtBaryTheta, pmtBaryPhi, pmtBaryY, lappdBaryDist, lappdBaryTheta;
-	double pmtBaryDist_Clustered, pmtBaryDist_NonClustered, pmtBaryTheta_Clustered, pmtBaryTheta_NonClustered;
-	double pmtBaryDistMC, pmtBaryThetaMC, lappdBaryDistMC, lappdBaryThetaMC;
-
+	double pmtBaryThetaMC = 0., lappdBaryThetaMC = 0.;
 	if (!isData){
 
 		// Angle and distance of barycenter calculated with respect to interaction point and primary particle direction
 		Position dirBaryQ = pmtBaryQ-pos;
-		pmtBaryDistMC = dirBaryQ.Mag();
+		double pmtBaryDistMC = dirBaryQ.Mag();
 		pmtBaryThetaMC = acos((dirBaryQ.X()*dir_x+dirBaryQ.Y()*dir_y+dirBaryQ.Z()*dir_z)/pmtBaryDistMC);
 		Position lappd_dirBaryQ = lappdBaryQ-pos;
-		lappdBaryDistMC = lappd_dirBaryQ.Mag();
+		double lappdBaryDistMC = lappd_dirBaryQ.Mag();
 		lappdBaryThetaMC = acos((lappd_dirBaryQ.X()*dir_x+lappd_dirBaryQ.Y()*dir_y+lappd_dirBaryQ.Z()*dir_z)/lappdBaryDistMC);
+		row[classvars::kMCPMTBaryTheta] = pmtBaryThetaMC;
+		row[classvars::kMCLAPPDBaryTheta] = lappdBaryThetaMC;
+	}
 
-	} 
-	
 	// Angle and distance of barycenter calculated with respect to (0,0,0)-position and (0,0,1)-direction
-	pmtBaryDist = pmtBaryQ.Mag();
-	pmtBaryDist_Clustered = pmtBaryQ_Clustered.Mag();
-	pmtBaryDist_NonClustered = pmtBaryQ_NonClustered.Mag();
-	if (fabs(pmtBaryDist)<0.0001) {
-		pmtBaryTheta = 0;
-		pmtBaryPhi = 0.;
-		pmtBaryY = 0.;
-	} else {
+	double pmtBaryTheta = 0., pmtBaryPhi = 0.;
+	double pmtBaryTheta_Clustered = 0., pmtBaryTheta_NonClustered = 0., lappdBaryTheta = 0.;
+	double pmtBaryDist = pmtBaryQ.Mag();
+	double pmtBaryDist_Clustered = pmtBaryQ_Clustered.Mag();
+	double pmtBaryDist_NonClustered = pmtBaryQ_NonClustered.Mag();
+	double lappdBaryDist = lappdBaryQ.Mag();
+	if (fabs(pmtBaryDist)>=0.0001) {
 		pmtBaryTheta = acos(pmtBaryQ.Z()/pmtBaryDist);
 		pmtBaryPhi = CalcArcTan(pmtBaryQ.X(),pmtBaryQ.Z());
-		pmtBaryY = pmtBaryQ.Y();
-	} 
-	if (fabs(pmtBaryDist_Clustered)<0.0001){
-		pmtBaryTheta_Clustered = 0.;
-	} else {
-		pmtBaryTheta_Clustered = acos(pmtBaryQ_Clustered.Z()/pmtBaryDist_Clustered);
-	}
-	if (fabs(pmtBaryDist_NonClustered)<0.0001){
-		pmtBaryTheta_NonClustered = 0.;
-	}
-	else {
-		pmtBaryTheta_NonClustered = acos(pmtBaryQ_NonClustered.Z()/pmtBaryDist_NonClustered);
 	}
-	lappdBaryDist = lappdBaryQ.Mag();
-	if (fabs(lappdBaryDist)<0.001) lappdBaryTheta=0.;
-	else lappdBaryTheta = acos(lappdBaryQ.Z()/lappdBaryDist);
-
-	double diff_barycenter_clustered = fabs(pmtBaryTheta_Clustered-pmtBaryTheta_NonClustered);
-
-	// Calculate variance/RMS of variables
-	double pmt_varTheta=0.;
-	double pmt_varThetaBary=0.;
-	double pmt_varThetaMC=0.;
-	double pmt_varThetaBaryMC=0.;
-	double pmt_varPhi=0.;
-	double pmt_varPhiBary = 0.;
-	double pmt_theta_bary = 0.;
-	double pmt_theta_baryMC = 0.;
-	double lappd_theta_bary = 0.;
-	double lappd_theta_baryMC = 0.;
-	double lappd_varTheta=0.;
-	double lappd_varThetaBary=0.;
-	double lappd_varThetaMC=0.;
-	double lappd_varThetaBaryMC=0.;
-	double pmt_rmsThetaBary=0.;
-	double pmt_rmsThetaBaryMC=0.;
-	double pmt_rmsPhiBary = 0.;
-	double lappd_rmsThetaBary=0.;
-	double lappd_rmsThetaBaryMC=0.;
-	double pmt_fracLargeAnglePhi=0.;
-	double pmt_fracLargeAngleTheta=0.;
+	if (fabs(pmtBaryDist_Clustered)>=0.0001) pmtBaryTheta_Clustered = acos(pmtBaryQ_Clustered.Z()/pmtBaryDist_Clustered);
+	if (fabs(pmtBaryDist_NonClustered)>=0.0001) pmtBaryTheta_NonClustered = acos(pmtBaryQ_NonClustered.Z()/pmtBaryDist_NonClustered);
+	if (fabs(lappdBaryDist)>=0.001) lappdBaryTheta = acos(lappdBaryQ.Z()/lappdBaryDist);
+	row[classvars::kPMTBaryTheta] = pmtBaryTheta;
+	row[classvars::kPMTBaryTheta_Clustered] = pmtBaryTheta_Clustered;
+	row[classvars::kPMTBaryTheta_NonClustered] = pmtBaryTheta_NonClustered;
+	row[classvars::kPMTDeltaBarycenter_Clustered] = fabs(pmtBaryTheta_Clustered-pmtBaryTheta_NonClustered);
+	row[classvars::kLAPPDBaryTheta] = lappdBaryTheta;
+
+	// Angles with respect to the barycenter need the finished barycenter, and
+	// phi is wrapped per hit, so these are one more sweep over the columns
+	double pmt_rmsThetaBary=0., pmt_varThetaBary=0., pmt_rmsThetaBaryMC=0.;
+	double pmt_rmsPhiBary=0., pmt_varPhiBary=0.;
 	int pmt_hits_largeangle_theta=0;
-	int pmt_hits_largeangle_phi=0;	
-
-	// Variances and RMS of angles/times with respect to barycenter
-	for (unsigned int i_pmt=0; i_pmt < pmtQ.size(); i_pmt++){
-		
-		pmt_varT+=pow(pmtT.at(i_pmt)-pmt_avgT,2);
-		pmt_varTheta+=(pow(pmtTheta.at(i_pmt),2)*pmtQ.at(i_pmt)/pmt_totalQ);
-		pmt_theta_bary = pmtTheta.at(i_pmt) - pmtBaryTheta;
-		event_theta->Fill(pmt_theta_bary);
-		pmtThetaBary.push_back(pmt_theta_bary);
-		pmt_rmsThetaBary+=pow(pmt_theta_bary,2);
-		pmt_varThetaBary+=(pow(pmt_theta_bary,2)*pmtQ.at(i_pmt)/pmt_totalQ);
-		if (!isData){
-			pmt_varThetaMC+=(pow(pmtThetaMC.at(i_pmt),2)*pmtQ.at(i_pmt)/pmt_totalQ);
-			pmt_theta_baryMC = pmtThetaMC.at(i_pmt) - pmtBaryThetaMC;
-			pmtThetaBaryMC.push_back(pmt_theta_baryMC);
-			pmt_rmsThetaBaryMC+=pow(pmt_theta_baryMC,2);
-			pmt_varThetaBaryMC+=(pow(pmt_theta_bary,2)*pmtQ.at(i_pmt)/pmt_totalQ);
-		}			
-
-		pmt_varPhi+=(pow(pmtPhi.at(i_pmt),2)*pmtQ.at(i_pmt)/pmt_totalQ);
-		double pmt_phi_bary = (pmtPhi.at(i_pmt)-pmtBaryPhi);
+	int pmt_hits_largeangle_phi=0;
+	const size_t n_pmt = pmt_digits.Size();
+	pmt_digits.theta_bary.resize(n_pmt);
+	pmt_digits.phi_bary.resize(n_pmt);
+	for (size_t i_pmt=0; i_pmt < n_pmt; i_pmt++){
+
+		double pmt_theta_bary = pmt_digits.theta[i_pmt] - pmtBaryTheta;
+		double pmt_phi_bary = pmt_digits.phi[i_pmt] - pmtBaryPhi;
 		if (pmt_phi_bary > TMath::Pi()) pmt_phi_bary = -(2*TMath::Pi()-pmt_phi_bary);
 		else if (pmt_phi_bary < -TMath::Pi()) pmt_phi_bary = 2*TMath::Pi()+pmt_phi_bary;
-		event_phi->Fill(pmt_phi_bary);
-		pmtPhiBary.push_back(pmt_phi_bary);
-		pmt_rmsPhiBary+=(pow(pmt_phi_bary,2));
-		pmt_varPhiBary+=(pow(pmt_phi_bary,2)*pmtQ.at(i_pmt)/pmt_totalQ);
-		
+		pmt_digits.theta_bary[i_pmt] = pmt_theta_bary;
+		pmt_digits.phi_bary[i_pmt] = pmt_phi_bary;
+		event_hists[kTheta].Fill(pmt_theta_bary);
+		event_hists[kPhi].Fill(pmt_phi_bary);
+
+		double theta_bary2 = pmt_theta_bary*pmt_theta_bary;
+		double phi_bary2 = pmt_phi_bary*pmt_phi_bary;
+		pmt_rmsThetaBary+=theta_bary2;
+		pmt_varThetaBary+=theta_bary2*pmt_digits.q[i_pmt];
+		pmt_rmsPhiBary+=phi_bary2;
+		pmt_varPhiBary+=phi_bary2*pmt_digits.q[i_pmt];
 		if (fabs(pmt_theta_bary) > 0.9) pmt_hits_largeangle_theta++;
 		if (fabs(pmt_phi_bary) > 1.) pmt_hits_largeangle_phi++;
 	}
-	
-	if (pmtQ.size()>0) {
-
-		pmt_varT = sqrt(pmt_varT/pmtQ.size());
-		pmt_rmsThetaBary = sqrt(pmt_rmsThetaBary/pmtQ.size());
-		pmt_rmsPhiBary = sqrt(pmt_rmsPhiBary/pmtQ.size());
-		pmt_ellip = pmt_rmsPhiBary/pmt_rmsThetaBary;
-		pmt_fracLargeAngleTheta = double(pmt_hits_largeangle_theta)/pmtQ.size();
-		pmt_fracLargeAnglePhi = double(pmt_hits_largeangle_phi)/pmtQ.size();	
-		pmt_varTheta = sqrt(pmt_varTheta);
-		pmt_varPhi = sqrt(pmt_varPhi);
+	if (!isData){
+		pmt_digits.theta_bary_mc.resize(n_pmt);
+		for (size_t i_pmt=0; i_pmt < n_pmt; i_pmt++){
+			double pmt_theta_baryMC = pmt_digits.theta_mc[i_pmt] - pmtBaryThetaMC;
+			pmt_digits.theta_bary_mc[i_pmt] = pmt_theta_baryMC;
+			pmt_rmsThetaBaryMC+=pmt_theta_baryMC*pmt_theta_baryMC;
+		}
+	}
+	row[classvars::kPMTHitsLargeAngleTheta] = pmt_hits_largeangle_theta;
+	row[classvars::kPMTHitsLargeAnglePhi] = pmt_hits_largeangle_phi;
+
+	if (n_pmt>0) {
+
+		// VarThetaBary/VarPhiBary stay squared, unlike VarTheta/VarPhi
+		pmt_rmsThetaBary = sqrt(pmt_rmsThetaBary/n_pmt);
+		pmt_rmsPhiBary = sqrt(pmt_rmsPhiBary/n_pmt);
+		row[classvars::kPMTRMSThetaBary] = pmt_rmsThetaBary;
+		row[classvars::kPMTVarThetaBary] = pmt_varThetaBary/pmt.total_q;
+		row[classvars::kPMTRMSPhiBary] = pmt_rmsPhiBary;
+		row[classvars::kPMTVarPhiBary] = pmt_varPhiBary/pmt.total_q;
+		row[classvars::kPMTEllip] = pmt_rmsPhiBary/pmt_rmsThetaBary;
+		row[classvars::kPMTFracLargeAngleTheta] = double(pmt_hits_largeangle_theta)/n_pmt;
+		row[classvars::kPMTFracLargeAnglePhi] = double(pmt_hits_largeangle_phi)/n_pmt;
 		if (!isData){
-			pmt_rmsThetaBaryMC = sqrt(pmt_rmsThetaBaryMC/pmtQ.size());
-			pmt_varThetaMC = sqrt(pmt_varThetaMC);
+			row[classvars::kMCPMTRMSThetaBary] = sqrt(pmt_rmsThetaBaryMC/n_pmt);
+			// spread around the barycenter seen from the tank center, not from the true vertex
+			row[classvars::kMCPMTVarThetaBary] = row[classvars::kPMTVarThetaBary];
 		}
-	}	
+	}
 
-	for (unsigned int i_lappd=0; i_lappd< lappdQ.size(); i_lappd++){
-	
-		lappd_varT+=pow(lappdT.at(i_lappd)-lappd_avgT,2);
-		lappd_varTheta+=(pow(lappdTheta.at(i_lappd),2)*lappdQ.at(i_lappd)/lappd_totalQ);
-		lappd_theta_bary = lappdTheta.at(i_lappd)-lappdBaryTheta;
-		lappd_rmsThetaBary+=pow(lappd_theta_bary,2);
-		lappd_varThetaBary+=(pow(lappd_theta_bary,2)*lappdQ.at(i_lappd)/lappd_totalQ);
-		lappdThetaBary.push_back(lappd_theta_bary);
-		if (!isData){
-			lappd_varThetaMC+=(pow(lappdThetaMC.at(i_lappd),2)*lappdQ.at(i_lappd)/lappd_totalQ);
-			lappd_theta_baryMC = lappdThetaMC.at(i_lappd)-lappdBaryThetaMC;
-			lappd_rmsThetaBaryMC+=pow(lappd_theta_baryMC,2);
-			lappd_varThetaBaryMC+=(pow(lappd_theta_baryMC,2)*lappdQ.at(i_lappd)/lappd_totalQ);
-			lappdThetaBaryMC.push_back(lappd_theta_baryMC);
+	double lappd_rmsThetaBary=0., lappd_varThetaBary=0.;
+	double lappd_rmsThetaBaryMC=0., lappd_varThetaBaryMC=0.;
+	const size_t n_lappd = lappd_digits.Size();
+	lappd_digits.theta_bary.resize(n_lappd);
+	for (size_t i_lappd=0; i_lappd < n_lappd; i_lappd++){
+		double lappd_theta_bary = lappd_digits.theta[i_lappd] - lappdBaryTheta;
+		lappd_digits.theta_bary[i_lappd] = lappd_theta_bary;
+		lappd_rmsThetaBary+=lappd_theta_bary*lappd_theta_bary;
+		lappd_varThetaBary+=lappd_theta_bary*lappd_theta_bary*lappd_digits.q[i_lappd];
+	}
+	if (!isData){
+		lappd_digits.theta_bary_mc.resize(n_lappd);
+		for (size_t i_lappd=0; i_lappd < n_lappd; i_lappd++){
+			double lappd_theta_baryMC = lappd_digits.theta_mc[i_lappd] - lappdBaryThetaMC;
+			lappd_digits.theta_bary_mc[i_lappd] = lappd_theta_baryMC;
+			lappd_rmsThetaBaryMC+=lappd_theta_baryMC*lappd_theta_baryMC;
+			lappd_varThetaBaryMC+=lappd_theta_baryMC*lappd_theta_baryMC*lappd_digits.q[i_lappd];
 		}
 	}
-	if (lappdQ.size()>0) {
-		lappd_varT = sqrt(lappd_varT/lappdQ.size());
-		lappd_rmsThetaBary = sqrt(lappd_rmsThetaBary/lappdQ.size());
-		lappd_varTheta = sqrt(lappd_varTheta);
+	if (n_lappd>0) {
+		row[classvars::kLAPPDRMSThetaBary] = sqrt(lappd_rmsThetaBary/n_lappd);
+		row[classvars::kLAPPDVarThetaBary] = lappd_varThetaBary/lappd.total_q;
 		if (!isData){
-			lappd_rmsThetaBaryMC = sqrt(lappd_rmsThetaBaryMC/lappdQ.size());
-			lappd_varThetaMC = sqrt(lappd_varThetaMC);
+			row[classvars::kMCLAPPDRMSThetaBary] = sqrt(lappd_rmsThetaBaryMC/n_lappd);
+			row[classvars::kMCLAPPDVarThetaBary] = lappd_varThetaBaryMC/lappd.total_q;
 		}
 	}
 
-	// Calculate likelihood variables
-	double pmt_charge_mu = pdf_mu_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
-	double pmt_time_mu = pdf_mu_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
-	double pmt_theta_mu = pdf_mu_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
-	double pmt_phi_mu = pdf_mu_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
-	double pmt_charge_e = pdf_e_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
-	double pmt_time_e = pdf_e_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
-	double pmt_theta_e = pdf_e_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
-	double pmt_phi_e = pdf_e_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
-	double pmt_charge_likelihood = pmt_charge_e - pmt_charge_mu;
-	double pmt_time_likelihood = pmt_time_e - pmt_time_mu;
-	double pmt_theta_likelihood = pmt_theta_e - pmt_theta_mu;
-	double pmt_phi_likelihood = pmt_phi_e - pmt_phi_mu;
-	
-	double pmt_charge_single = pdf_single_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
-	double pmt_time_single = pdf_single_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
-	double pmt_theta_single = pdf_single_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
-	double pmt_phi_single = pdf_single_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
-	double pmt_charge_multi = pdf_multi_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
-	double pmt_time_multi = pdf_multi_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
-	double pmt_theta_multi = pdf_multi_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
-	double pmt_phi_multi = pdf_multi_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
-	double pmt_charge_likelihood_rings = pmt_charge_multi - pmt_charge_single;
-	double pmt_time_likelihood_rings = pmt_time_multi - pmt_time_single;
-	double pmt_theta_likelihood_rings = pmt_theta_multi - pmt_theta_single;
-	double pmt_phi_likelihood_rings = pmt_phi_multi - pmt_phi_single;
-
+	// Calculate likelihood variables. The event histograms are filled once per
+	// event from the binned digits, then compared with the pdfs as before.
+	event_hists[kCharge].CopyTo(event_charge);
+	event_hists[kTime].CopyTo(event_time);
+	event_hists[kTheta].CopyTo(event_theta);
+	event_hists[kPhi].CopyTo(event_phi);
+	row[classvars::kPMTLikelihoodQ] = pdf_e_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF") - pdf_mu_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
+	row[classvars::kPMTLikelihoodT] = pdf_e_time->Chi2Test(event_time,"UUNORMCHI2/NDF") - pdf_mu_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
+	row[classvars::kPMTLikelihoodTheta] = pdf_e_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF") - pdf_mu_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
+	row[classvars::kPMTLikelihoodPhi] = pdf_e_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF") - pdf_mu_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
+	row[classvars::kPMTLikelihoodQRings] = pdf_multi_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF") - pdf_single_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
+	row[classvars::kPMTLikelihoodTRings] = pdf_multi_time->Chi2Test(event_time,"UUNORMCHI2/NDF") - pdf_single_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
+	row[classvars::kPMTLikelihoodThetaRings] = pdf_multi_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF") - pdf_single_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
+	row[classvars::kPMTLikelihoodPhiRings] = pdf_multi_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF") - pdf_single_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
 
 	// Obtain number of clusters from HitCleaner
-	int pmt_hitcleaning_clusters = fHitCleaningClusters->size();
-
-	// PMT variables
-	classification_map_double.emplace("PMTBaryTheta",pmtBaryTheta);
-	classification_map_double.emplace("PMTAvgDist",pmt_avgDist);
-	classification_map_double.emplace("PMTAvgT",pmt_avgT);
-	classification_map_double.emplace("PMTVarT",pmt_varT);
-	classification_map_double.emplace("PMTQtotal",pmt_totalQ);
-	classification_map_double.emplace("PMTQtotalClustered",pmt_totalQ_Clustered);
-	classification_map_int.emplace("PMTHits",pmt_hits);
-	classification_map_double.emplace("PMTQPerPMT",pmt_qpmt);
-	classification_map_double.emplace("PMTFracQmax",pmt_frachighestQ);
-	classification_map_double.emplace("PMTFracQdownstream",pmt_fracQDownstream);
-	classification_map_double.emplace("PMTFracClustered",pmt_fracClustered);
-	classification_map_double.emplace("PMTFracLowQ",pmt_fracLowQ);
-	classification_map_double.emplace("PMTFracEarly",pmt_fracEarly);
-	classification_map_double.emplace("PMTFracLate",pmt_fracLate);
-	classification_map_double.emplace("PMTRMSTheta",pmt_rmsTheta);
-	classification_map_double.emplace("PMTVarTheta",pmt_varTheta);
-	classification_map_double.emplace("PMTRMSThetaBary",pmt_rmsThetaBary);
-	classification_map_double.emplace("PMTVarThetaBary",pmt_varThetaBary);
-	classification_map_double.emplace("PMTRMSPhi",pmt_rmsPhi);
-	classification_map_double.emplace("PMTVarPhi",pmt_varPhi);
-	classification_map_double.emplace("PMTRMSPhiBary",pmt_rmsPhiBary);
-	classification_map_double.emplace("PMTVarPhiBary",pmt_varPhiBary);
-	classification_map_double.emplace("PMTFracLargeAnglePhi",pmt_fracLargeAnglePhi);
-	classification_map_double.emplace("PMTFracLargeAngleTheta",pmt_fracLargeAngleTheta);
-	classification_map_int.emplace("PMTHitsLargeAngleTheta",pmt_hits_largeangle_theta);
-	classification_map_int.emplace("PMTHitsLargeAnglePhi",pmt_hits_largeangle_phi);
-	classification_map_double.emplace("PMTEllip",pmt_ellip);
-	classification_map_double.emplace("PMTBaryTheta_Clustered",pmtBaryTheta_Clustered);
-	classification_map_double.emplace("PMTBaryTheta_NonClustered",pmtBaryTheta_NonClustered);
-	classification_map_double.emplace("PMTDeltaBarycenter_Clustered",diff_barycenter_clustered);
-	classification_map_double.emplace("PMTLikelihoodQ",pmt_charge_likelihood);
-	classification_map_double.emplace("PMTLikelihoodT",pmt_time_likelihood);
-	classification_map_double.emplace("PMTLikelihoodTheta",pmt_theta_likelihood);
-	classification_map_double.emplace("PMTLikelihoodPhi",pmt_phi_likelihood);
-	classification_map_double.emplace("PMTLikelihoodQRings",pmt_charge_likelihood_rings);
-	classification_map_double.emplace("PMTLikelihoodTRings",pmt_time_likelihood_rings);
-	classification_map_double.emplace("PMTLikelihoodThetaRings",pmt_theta_likelihood_rings);
-	classification_map_double.emplace("PMTLikelihoodPhiRings",pmt_phi_likelihood_rings);
-	classification_map_double.emplace("PMTHitCleaningClusters",pmt_hitcleaning_clusters);
-
-
-	// LAPPD variables
-	classification_map_double.emplace("LAPPDBaryTheta",lappdBaryTheta);
-	classification_map_double.emplace("LAPPDAvgDist",lappd_avgDist);
-	classification_map_double.emplace("LAPPDQtotal",lappd_totalQ);
-	classification_map_double.emplace("LAPPDAvgT",lappd_avgT);
-	classification_map_double.emplace("LAPPDVarT",lappd_varT);
-	classification_map_int.emplace("LAPPDHits",lappd_hits);
-	classification_map_double.emplace("LAPPDRMSTheta",lappd_rmsTheta);
-	classification_map_double.emplace("LAPPDVarTheta",lappd_varTheta);
-	classification_map_double.emplace("LAPPDRMSThetaBary",lappd_rmsThetaBary);
-	classification_map_double.emplace("LAPPDVarThetaBary",lappd_varThetaBary);
+	row[classvars::kPMTHitCleaningClusters] = fHitCleaningClusters->size();
 
+	// PMT & LAPPD scalar variables, MC truth ones only for MC
+	int n_features = (isData)? classvars::kFirstMCFeature : classvars::kNFeatures;
+	for (int i_feature = 0; i_feature < n_features; i_feature++){
+		if (classvars::IsIntFeature(i_feature)) classification_map_int.emplace(classvars::FeatureName(i_feature),int(row[i_feature]));
+		else classification_map_double.emplace(classvars::FeatureName(i_feature),row[i_feature]);
+	}
+	m_data->Stores["Classification"]->Set("PMTLAPPDFeatures",std::vector<double>(row.begin(),row.end()));
 
 	// PMT & LAPPD vector variables
-	classification_map_vector.emplace("PMTQVector",pmtQ);
-	classification_map_vector.emplace("PMTTVector",pmtT);
-	classification_map_vector.emplace("PMTDistVector",pmtDist);
-	classification_map_vector.emplace("PMTThetaVector",pmtTheta);
-	classification_map_vector.emplace("PMTThetaBaryVector",pmtThetaBary);
-	classification_map_vector.emplace("PMTPhiVector",pmtPhi);
-	classification_map_vector.emplace("PMTPhiBaryVector",pmtPhiBary);
-	classification_map_vector.emplace("PMTYVector",pmtY);
-	classification_map_vector.emplace("PMTIDVector",pmtID);
-	classification_map_vector.emplace("LAPPDQVector",lappdQ);
-	classification_map_vector.emplace("LAPPDTVector",lappdT);
-	classification_map_vector.emplace("LAPPDDistVector",lappdDist);
-	classification_map_vector.emplace("LAPPDThetaVector",lappdTheta);
-	classification_map_vector.emplace("LAPPDThetaBaryVector",lappdThetaBary);
-	classification_map_vector.emplace("LAPPDIDVector",lappdID);
-
-	// PMT & LAPPD mctruth variables
+	classification_map_vector.emplace("PMTQVector",pmt_digits.q);
+	classification_map_vector.emplace("PMTTVector",pmt_digits.t);
+	classification_map_vector.emplace("PMTDistVector",pmt_digits.dist);
+	classification_map_vector.emplace("PMTThetaVector",pmt_digits.theta);
+	classification_map_vector.emplace("PMTThetaBaryVector",pmt_digits.theta_bary);
+	classification_map_vector.emplace("PMTPhiVector",pmt_digits.phi);
+	classification_map_vector.emplace("PMTPhiBaryVector",pmt_digits.phi_bary);
+	classification_map_vector.emplace("PMTYVector",pmt_digits.y);
+	classification_map_vector.emplace("PMTIDVector",pmt_digits.id);
+	classification_map_vector.emplace("LAPPDQVector",lappd_digits.q);
+	classification_map_vector.emplace("LAPPDTVector",lappd_digits.t);
+	classification_map_vector.emplace("LAPPDDistVector",lappd_digits.dist);
+	classification_map_vector.emplace("LAPPDThetaVector",lappd_digits.theta);
+	classification_map_vector.emplace("LAPPDThetaBaryVector",lappd_digits.theta_bary);
+	classification_map_vector.emplace("LAPPDIDVector",lappd_digits.id);
+
+	// PMT & LAPPD mctruth vector variables
 	if (!isData){
-
-		classification_map_double.emplace("MCPMTFracRing",pmt_fracRing);
-		classification_map_double.emplace("MCPMTFracRingNoWeight",pmt_fracRingNoWeight);
-		classification_map_double.emplace("MCLAPPDFracRing",lappd_fracRing);
-	
-		classification_map_double.emplace("MCPMTBaryTheta",pmtBaryThetaMC);
-		classification_map_double.emplace("MCPMTVarTheta",pmt_varThetaMC);
-		classification_map_double.emplace("MCPMTRMSTheta",pmt_rmsThetaMC);
-		classification_map_double.emplace("MCPMTRMSThetaBary",pmt_rmsThetaBaryMC);
-		classification_map_double.emplace("MCPMTVarThetaBary",pmt_varThetaBaryMC);
-		classification_map_vector.emplace("MCPMTThetaBaryVector",pmtThetaBaryMC);
-                       
-                classification_map_double.emplace("MCLAPPDBaryTheta",lappdBaryThetaMC);
-		classification_map_double.emplace("MCLAPPDVarTheta",lappd_varThetaMC);
-		classification_map_double.emplace("MCLAPPDRMSTheta",lappd_rmsThetaMC);
-                classification_map_double.emplace("MCLAPPDRMSThetaBary",lappd_rmsThetaBaryMC);
-                classification_map_double.emplace("MCLAPPDVarThetaBary",lappd_varThetaBaryMC);
-		classification_map_vector.emplace("MCLAPPDThetaBaryVector",lappdThetaBaryMC);
-		
-		classification_map_vector.emplace("MCPMTTVectorTOF",pmtT_tof);
-		classification_map_vector.emplace("MCLAPPDTVectorTOF",lappdT_tof);
+		classification_map_vector.emplace("MCPMTThetaBaryVector",pmt_digits.theta_bary_mc);
+		classification_map_vector.emplace("MCLAPPDThetaBaryVector",lappd_digits.theta_bary_mc);
+		classification_map_vector.emplace("MCPMTTVectorTOF",pmt_digits.t_tof);
+		classification_map_vector.emplace("MCLAPPDTVectorTOF",lappd_digits.t_tof);
 	}
 
 }
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <array>
 
 #include "Tool.h"
 #include "TH1F.h"
@@ -21,8 +22,13 @@
 #include "RecoDigit.h"
 #include "RecoCluster.h"
 
+#include "PMTLAPPDFeatures.h"
+
 class CalcClassificationVars: public Tool {
 
+  // tests/CalcClassificationVars: compares the PMT/LAPPD features with the code they replaced
+  friend class PMTLAPPDFeatureComparison;
+
  public:
 
   CalcClassificationVars();
@@ -37,6 +43,7 @@ class CalcClassificationVars: public Tool {
   bool GetBoostStoreVariables();
   void ClassificationVarsMCTruth();
   void ClassificationVarsPMTLAPPD();
+  const classvars::TubeAngles& GetTubeAngles(int detector_id, double x, double y, double z);
   void ClassificationVarsMRD();
   double ComputeChi2(TH1F *h1, TH1F *h2);
 
@@ -112,6 +119,16 @@ class CalcClassificationVars: public Tool {
   TH1F *pdf_multi_theta = nullptr;
   TH1F *pdf_multi_phi = nullptr;
 
+  // Event histograms filled while reading the digits, copied to event_charge
+  // etc. for the likelihoods; indexed by PDFVariable
+  enum PDFVariable { kCharge = 0, kTime = 1, kTheta = 2, kPhi = 3 };
+  std::array<classvars::EventHistogram,4> event_hists;
+
+  // PMT/LAPPD digits and features of the current event
+  classvars::DigitColumns pmt_digits, lappd_digits;
+  classvars::FeatureRow feature_row;
+  std::vector<classvars::TubeAngles> tube_angles;	//indexed by detector ID
+  classvars::TubeAngles uncached_angles;
 
   //General variables
   double pos_x, pos_y, pos_z, dir_x, dir_y, dir_z;
@@ -0,0 +1,72 @@
+#include "PMTLAPPDFeatures.h"
+
+#include "TH1F.h"
+
+namespace {
+
+  const char* const feature_names[classvars::kNFeatures] = {
+    "PMTBaryTheta","PMTAvgDist","PMTAvgT","PMTVarT","PMTQtotal","PMTQtotalClustered",
+    "PMTHits","PMTQPerPMT","PMTFracQmax","PMTFracQdownstream","PMTFracClustered",
+    "PMTFracLowQ","PMTFracEarly","PMTFracLate","PMTRMSTheta","PMTVarTheta",
+    "PMTRMSThetaBary","PMTVarThetaBary","PMTRMSPhi","PMTVarPhi","PMTRMSPhiBary",
+    "PMTVarPhiBary","PMTFracLargeAnglePhi","PMTFracLargeAngleTheta",
+    "PMTHitsLargeAngleTheta","PMTHitsLargeAnglePhi","PMTEllip",
+    "PMTBaryTheta_Clustered","PMTBaryTheta_NonClustered","PMTDeltaBarycenter_Clustered",
+    "PMTLikelihoodQ","PMTLikelihoodT","PMTLikelihoodTheta","PMTLikelihoodPhi",
+    "PMTLikelihoodQRings","PMTLikelihoodTRings","PMTLikelihoodThetaRings",
+    "PMTLikelihoodPhiRings","PMTHitCleaningClusters",
+    "LAPPDBaryTheta","LAPPDAvgDist","LAPPDQtotal","LAPPDAvgT","LAPPDVarT","LAPPDHits",
+    "LAPPDRMSTheta","LAPPDVarTheta","LAPPDRMSThetaBary","LAPPDVarThetaBary",
+    "MCPMTFracRing","MCPMTFracRingNoWeight","MCLAPPDFracRing","MCPMTBaryTheta",
+    "MCPMTVarTheta","MCPMTRMSTheta","MCPMTRMSThetaBary","MCPMTVarThetaBary",
+    "MCLAPPDBaryTheta","MCLAPPDVarTheta","MCLAPPDRMSTheta","MCLAPPDRMSThetaBary",
+    "MCLAPPDVarThetaBary"
+  };
+
+}
+
+const char* classvars::FeatureName(int feature){
+  return feature_names[feature];
+}
+
+bool classvars::IsIntFeature(int feature){
+  return feature==kPMTHits || feature==kPMTHitsLargeAngleTheta ||
+         feature==kPMTHitsLargeAnglePhi || feature==kLAPPDHits;
+}
+
+void classvars::DigitColumns::Clear(){
+  for (std::vector<double>* column : {&q,&t,&id,&dist,&theta,&phi,&y,&theta_bary,
+                                      &phi_bary,&theta_mc,&theta_bary_mc,&t_tof}){
+    column->clear();
+  }
+}
+
+void classvars::EventHistogram::Book(int n, double lo, double hi){
+  nbins = n;
+  xmin = lo;
+  xmax = hi;
+  counts.assign(nbins+2,0.);
+}
+
+void classvars::EventHistogram::Reset(){
+  counts.assign(nbins+2,0.);
+}
+
+void classvars::EventHistogram::Fill(double x){
+  // same bin as TAxis::FindFixBin, NaN goes to the overflow
+  int bin;
+  if (x < xmin) bin = 0;
+  else if (!(x < xmax)) bin = nbins+1;
+  else bin = 1 + int(nbins*(x-xmin)/(xmax-xmin));
+  counts[bin] += 1.;
+}
+
+void classvars::EventHistogram::CopyTo(TH1F* histogram) const {
+  histogram->Reset();
+  double entries = 0.;
+  for (int bin = 0; bin < nbins+2; ++bin){
+    histogram->SetBinContent(bin,counts[bin]);
+    entries += counts[bin];
+  }
+  histogram->SetEntries(entries);
+}
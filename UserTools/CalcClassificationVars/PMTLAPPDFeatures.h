@@ -0,0 +1,114 @@
+#ifndef PMTLAPPDFeatures_H
+#define PMTLAPPDFeatures_H
+
+#include <array>
+#include <vector>
+
+#include "Position.h"
+
+class TH1F;
+
+// Building blocks of the PMT/LAPPD part of CalcClassificationVars: the digits
+// of an event as columns, the sums taken while reading them, the angles of
+// the tank PMTs, the event histograms compared to the likelihood pdfs, and
+// the fixed layout of the resulting features.
+namespace classvars {
+
+  // One entry per feature; FeatureName gives the key in the classification maps
+  enum Feature {
+    kPMTBaryTheta, kPMTAvgDist, kPMTAvgT, kPMTVarT, kPMTQtotal, kPMTQtotalClustered,
+    kPMTHits, kPMTQPerPMT, kPMTFracQmax, kPMTFracQdownstream, kPMTFracClustered,
+    kPMTFracLowQ, kPMTFracEarly, kPMTFracLate, kPMTRMSTheta, kPMTVarTheta,
+    kPMTRMSThetaBary, kPMTVarThetaBary, kPMTRMSPhi, kPMTVarPhi, kPMTRMSPhiBary,
+    kPMTVarPhiBary, kPMTFracLargeAnglePhi, kPMTFracLargeAngleTheta,
+    kPMTHitsLargeAngleTheta, kPMTHitsLargeAnglePhi, kPMTEllip,
+    kPMTBaryTheta_Clustered, kPMTBaryTheta_NonClustered, kPMTDeltaBarycenter_Clustered,
+    kPMTLikelihoodQ, kPMTLikelihoodT, kPMTLikelihoodTheta, kPMTLikelihoodPhi,
+    kPMTLikelihoodQRings, kPMTLikelihoodTRings, kPMTLikelihoodThetaRings,
+    kPMTLikelihoodPhiRings, kPMTHitCleaningClusters,
+    kLAPPDBaryTheta, kLAPPDAvgDist, kLAPPDQtotal, kLAPPDAvgT, kLAPPDVarT, kLAPPDHits,
+    kLAPPDRMSTheta, kLAPPDVarTheta, kLAPPDRMSThetaBary, kLAPPDVarThetaBary,
+    // features from here on need the true vertex and are left at 0 for data
+    kMCPMTFracRing, kMCPMTFracRingNoWeight, kMCLAPPDFracRing, kMCPMTBaryTheta,
+    kMCPMTVarTheta, kMCPMTRMSTheta, kMCPMTRMSThetaBary, kMCPMTVarThetaBary,
+    kMCLAPPDBaryTheta, kMCLAPPDVarTheta, kMCLAPPDRMSTheta, kMCLAPPDRMSThetaBary,
+    kMCLAPPDVarThetaBary,
+    kNFeatures
+  };
+
+  const Feature kFirstMCFeature = kMCPMTFracRing;
+
+  typedef std::array<double,kNFeatures> FeatureRow;
+
+  const char* FeatureName(int feature);
+  // stored in ClassificationMapInt rather than ClassificationMapDouble
+  bool IsIntFeature(int feature);
+
+  // The digits of one detector type, one column per quantity. Angles are
+  // with respect to the tank centre; the MC columns with respect to the
+  // true vertex and direction, and are only filled for MC.
+  struct DigitColumns {
+    std::vector<double> q, t, id, dist, theta;
+    std::vector<double> phi, y;                          // PMTs only
+    std::vector<double> theta_bary, phi_bary;
+    std::vector<double> theta_mc, theta_bary_mc, t_tof;
+    void Clear();
+    size_t Size() const { return q.size(); }
+  };
+
+  // Sums over the digits of one detector type, filled while reading them
+  struct Moments {
+    int hits = 0;
+    double total_q = 0.;
+    double mean_t = 0.;             // running mean of the times
+    double m2_t = 0.;               // running sum of squared deviations from mean_t
+    double sum_dist = 0.;
+    Position bary_q{0.,0.,0.};      // sum of charge * position
+    double sum_theta2 = 0.;
+    double sum_q_theta2 = 0.;       // charge weighted
+    double sum_phi2 = 0.;
+    double sum_q_phi2 = 0.;
+    double sum_theta2_mc = 0.;
+    double sum_q_theta2_mc = 0.;
+    double highest_q = 0.;
+    double q_downstream = 0.;
+    int hits_lowq = 0, hits_late = 0, hits_early = 0;
+    double q_clustered = 0., q_nonclustered = 0.;
+    Position bary_q_clustered{0.,0.,0.}, bary_q_nonclustered{0.,0.,0.};
+    double q_ring = 0.;
+    int hits_ring = 0;
+
+    void AddTime(double t){
+      ++hits;
+      double delta = t-mean_t;
+      mean_t += delta/hits;
+      m2_t += delta*(t-mean_t);
+    }
+  };
+
+  // Distance and angles of a tube position with respect to the tank centre.
+  // Tube positions do not change, so these are kept per detector ID and only
+  // recomputed if a digit of that tube comes with a different position.
+  struct TubeAngles {
+    bool valid = false;
+    double x = 0., y = 0., z = 0.;  // [m]
+    double dist = 0., theta = 0., phi = 0.;
+    bool has_gain = false;          // data: single PE gain of the tube is known
+    double gain = 1.;
+  };
+
+  // Event histogram with the binning of a TH1F with fixed bins; bins 0 and
+  // nbins+1 are the under- and overflow
+  struct EventHistogram {
+    int nbins = 0;
+    double xmin = 0., xmax = 0.;
+    std::vector<double> counts;
+    void Book(int n, double lo, double hi);
+    void Reset();
+    void Fill(double x);
+    void CopyTo(TH1F* histogram) const;
+  };
+
+}
+
+#endif
@@ -1,4 +1,7 @@
 #include "CheckDetectorCounts.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(CheckDetectorCounts);
 
 CheckDetectorCounts::CheckDetectorCounts():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "ClusterClassifiers.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ClusterClassifiers);
 
 ClusterClassifiers::ClusterClassifiers():Tool(){}
 
@@ -29,6 +32,8 @@ bool ClusterClassifiers::Initialise(std::string configfile, DataModel &data){
   m_data->CStore.Get("pmt_tubeid_to_channelkey_data",pmtid_to_channelkey);
   m_data->CStore.Get("channelkey_to_pmtid",channelkey_to_pmtid);
 
+  this->FillTubeInfo();
+
   return true;
 }
 
@@ -36,26 +41,17 @@ bool ClusterClassifiers::Initialise(std::string configfile, DataModel &data){
 bool ClusterClassifiers::Execute(){
 
   //We're gonna make ourselves a couple cluster classifier maps boyeeee
-  if(verbosity>4) std::cout << "ClusterClassifiers tool: Accessing cluster map in CStore" << std::endl;
-  bool get_clusters = false;
-  m_data->CStore.Get("ClusterMap",m_all_clusters);
-  if (isData){
-     get_clusters = m_data->CStore.Get("ClusterMap",m_all_clusters);
-     if(!get_clusters){
-       std::cout << "ClusterClassifiers tool: No clusters found!" << std::endl;
-       return false;
-     }
-   } else {
-     get_clusters = m_data->CStore.Get("ClusterMapMC",m_all_clusters_MC);
-     if(!get_clusters){
-       std::cout << "ClusterClassifiers tool: No clusters found! (MC)" << std::endl;
-       return false;
-     }
-   }
-   get_clusters = m_data->CStore.Get("ClusterMapDetkey",m_all_clusters_detkey);
-   if (!get_clusters){
-     std::cout << "ClusterClassifiers tool: No ClusterMapDetkey! (MC)" << std::endl;
-     return false;
+  if(verbosity>4) std::cout << "ClusterClassifiers tool: Accessing cluster table in CStore" << std::endl;
+  ClusterTable* clusters = nullptr;
+  bool get_clusters = m_data->CStore.Get("ClusterTable",clusters);
+  if (!get_clusters || !clusters){
+    //No cluster table (e.g. the clusters come from another tool): read the cluster maps
+    if (!this->ClustersFromMaps()) return false;
+    clusters = &m_cluster_table;
+  }
+  if (clusters->NClusters() > 0 && clusters->IsMC() == isData){
+    Log("ClusterClassifiers Tool: Clusters in CStore are not of the type expected for IsData = "+std::to_string(isData),v_error,verbosity);
+    return false;
   }
   if(verbosity>3) std::cout << "ClusterClassifiers Tool: looping through clusters to get cluster info now" << std::endl;
   
@@ -63,42 +59,19 @@ bool ClusterClassifiers::Execute(){
   std::map<double,Position> ClusterChargePoints;
   std::map<double,double> ClusterChargeBalances;
   std::map<double,double> ClusterTotalPEs;
-  std::vector<double> ClusterTimes;
   std::map<double,int> ClusterNHits;
 
-  if (isData){
-    for (std::pair<double,std::vector<Hit>>&& cluster_pair : *m_all_clusters) {
-      double cluster_time = cluster_pair.first;
-      std::vector<Hit> cluster_hits = cluster_pair.second;
-      if(verbosity>4) std::cout << "ClusterClassifiers Tool: cluster of hit time " << cluster_time << "processing.." << std::endl;
-      Position ChargePoint = this->CalculateChargePoint(cluster_hits);
-      ClusterChargePoints.emplace(cluster_time,ChargePoint);
-      double ChargeBalance = this->CalculateChargeBalance(cluster_hits);
-      ClusterChargeBalances.emplace(cluster_time,ChargeBalance);
-      double max_PE = this->CalculateMaxPE(cluster_hits);
-      ClusterMaxPEs.emplace(cluster_time,max_PE);
-      double total_PE = this->CalculateTotalPE(cluster_hits);
-      ClusterTotalPEs.emplace(cluster_time,total_PE);
-      ClusterTimes.push_back(cluster_time);
-      ClusterNHits.emplace(cluster_time,int(cluster_hits.size()));
-    }
-  } else {
-     for (std::pair<double,std::vector<MCHit>>&& cluster_pair : *m_all_clusters_MC) {
-       double cluster_time = cluster_pair.first;
-       std::vector<MCHit> cluster_hits = cluster_pair.second;
-       std::vector<unsigned long> cluster_detkey = m_all_clusters_detkey->at(cluster_time);
-       if(verbosity>4) std::cout << "ClusterClassifiers Tool: cluster of hit time " << cluster_time << "processing.." << std::endl;
-       Position ChargePoint = this->CalculateChargePointMC(cluster_hits,cluster_detkey);
-       ClusterChargePoints.emplace(cluster_time,ChargePoint);
-       double ChargeBalance = this->CalculateChargeBalanceMC(cluster_hits,cluster_detkey);
-       ClusterChargeBalances.emplace(cluster_time,ChargeBalance);
-       double max_PE = this->CalculateMaxPEMC(cluster_hits,cluster_detkey);
-       ClusterMaxPEs.emplace(cluster_time,max_PE);
-       double total_PE = this->CalculateTotalPEMC(cluster_hits,cluster_detkey);
-       ClusterTotalPEs.emplace(cluster_time,total_PE);
-       ClusterTimes.push_back(cluster_time);
-       ClusterNHits.emplace(cluster_time,int(cluster_hits.size()));
-     }
+  //All features of a cluster are filled into the cluster table in one pass over its hits,
+  //the maps keyed by cluster time are kept for the tools reading them from the ANNIEEvent
+  for (int cluster_id = 0; cluster_id < clusters->NClusters(); cluster_id++){
+    double cluster_time = clusters->Time(cluster_id);
+    if(verbosity>4) std::cout << "ClusterClassifiers Tool: cluster of hit time " << cluster_time << "processing.." << std::endl;
+    this->ClassifyCluster(*clusters,cluster_id);
+    ClusterChargePoints.emplace_hint(ClusterChargePoints.end(),cluster_time,clusters->ChargePoint(cluster_id));
+    ClusterChargeBalances.emplace_hint(ClusterChargeBalances.end(),cluster_time,clusters->ChargeBalance(cluster_id));
+    ClusterMaxPEs.emplace_hint(ClusterMaxPEs.end(),cluster_time,clusters->MaxPE(cluster_id));
+    ClusterTotalPEs.emplace_hint(ClusterTotalPEs.end(),cluster_time,clusters->TotalPE(cluster_id));
+    ClusterNHits.emplace_hint(ClusterNHits.end(),cluster_time,clusters->NHits(cluster_id));
   }
 
   //Save classifiers to ANNIEEvent
@@ -110,13 +83,13 @@ bool ClusterClassifiers::Execute(){
   m_data->Stores.at("ANNIEEvent")->Set("ClusterNHits", ClusterNHits);
 
   //identify prompt muon candidate
-  bool found_prompt_muon = this->IdentifyPromptMuonCluster(ClusterTotalPEs);
+  bool found_prompt_muon = this->IdentifyPromptMuonCluster(*clusters);
 
   //store indices of muon and neutron clusters to ANNIEEvent Store
   m_data->Stores.at("RecoEvent")->Set("ClusterIndexPromptMuon", prompt_muon_index);
   if (found_prompt_muon){
-    m_data->Stores.at("RecoEvent")->Set("PromptMuonTotalPE", ClusterTotalPEs.at(ClusterTimes.at(prompt_muon_index)));
-    m_data->Stores.at("RecoEvent")->Set("PromptMuonTime", ClusterTimes.at(prompt_muon_index));
+    m_data->Stores.at("RecoEvent")->Set("PromptMuonTotalPE", clusters->TotalPE(prompt_muon_index));
+    m_data->Stores.at("RecoEvent")->Set("PromptMuonTime", clusters->Time(prompt_muon_index));
   }
 
   return true;
@@ -128,190 +101,141 @@ bool ClusterClassifiers::Finalise(){
   return true;
 }
 
-Position ClusterClassifiers::CalculateChargePoint(std::vector<Hit> cluster_hits)
+void ClusterClassifiers::FillTubeInfo()
 {
-  if(verbosity>4) std::cout << "Calculating charge point" << std::endl;
-  double x_weight = 0;
-  double y_weight = 0;
-  double z_weight = 0;
+  //SPE charge and position (relative to the tank centre) of every tube with an SPE calibration,
+  //keyed by the tube ID of the hits
+  TubeInfos.clear();
   Position detector_center=geom->GetTankCentre();
-  double tank_center_x = detector_center.X();
-  double tank_center_y = detector_center.Y();
-  double tank_center_z = detector_center.Z();
-
-  for (int i = 0; i < (int) cluster_hits.size(); i++){
-    Hit ahit = cluster_hits.at(i); 
-    double hit_charge = ahit.GetCharge();
-    int channel_key = ahit.GetTubeId();
-    double hit_PE = 0;
-    std::map<int, double>::iterator it = ChannelKeyToSPEMap.find(channel_key);
-    if(it != ChannelKeyToSPEMap.end()){ //Charge to SPE conversion is available
-      hit_PE  = hit_charge / ChannelKeyToSPEMap.at(channel_key);
-      Detector* this_detector = geom->ChannelToDetector(channel_key);
+  std::map<int,double> tube_spe;
+  if (isData){
+    tube_spe = ChannelKeyToSPEMap;
+  } else {
+    //MC hits are keyed by the MC channel key, the SPE calibration by the data channel key
+    for (std::pair<const unsigned long,int>& apair : channelkey_to_pmtid){
+      std::map<int,unsigned long>::iterator it_data = pmtid_to_channelkey.find(apair.second);
+      if (it_data == pmtid_to_channelkey.end()) continue;
+      std::map<int,double>::iterator it_spe = ChannelKeyToSPEMap.find((int) it_data->second);
+      if (it_spe != ChannelKeyToSPEMap.end()) tube_spe.emplace((int) apair.first,it_spe->second);
+    }
+  }
+  for (std::pair<const int,double>& apair : tube_spe){
+    TubeInfo info;
+    info.spe_charge = apair.second;
+    info.dx = info.dy = info.dz = 0.;
+    info.pos_mag = 1.;
+    Detector* this_detector = geom->ChannelToDetector(apair.first);
+    if (this_detector){
       Position det_position = this_detector->GetDetectorPosition();
-      double pos_mag = sqrt(pow(det_position.X(),2) + pow(det_position.Y(),2) + pow(det_position.Z(),2));
-      x_weight+= (det_position.X()-tank_center_x)*hit_PE/pos_mag;
-      y_weight+= (det_position.Y()-tank_center_y)*hit_PE/pos_mag;
-      z_weight+= (det_position.Z()-tank_center_z)*hit_PE/pos_mag;
+      info.dx = det_position.X()-detector_center.X();
+      info.dy = det_position.Y()-detector_center.Y();
+      info.dz = det_position.Z()-detector_center.Z();
+      info.pos_mag = sqrt(pow(det_position.X(),2) + pow(det_position.Y(),2) + pow(det_position.Z(),2));
+    } else {
+      Log("ClusterClassifiers Tool: No detector for tube "+std::to_string(apair.first)+", it does not contribute to the charge point",v_warning,verbosity);
     }
+    TubeInfos.emplace(apair.first,info);
   }
+  if(verbosity>2) std::cout << "ClusterClassifiers Tool: SPE calibration available for " << TubeInfos.size() << " tubes" << std::endl;
+}
 
-  Position charge_weight(x_weight,y_weight,z_weight);
-  if(verbosity>4) std::cout << "ClusterClassifiers Tool: Calculated charge weight direction of  (" << charge_weight.X() << "," << charge_weight.Y() << "," << charge_weight.Z() << ")" << std::endl;
-  return charge_weight;
+bool ClusterClassifiers::ClustersFromMaps()
+{
+  std::map<double,std::vector<unsigned long>>* all_clusters_detkey = nullptr;
+  bool get_clusters = false;
+  if (isData){
+    std::map<double,std::vector<Hit>>* all_clusters = nullptr;
+    get_clusters = m_data->CStore.Get("ClusterMap",all_clusters);
+    if(!get_clusters){
+      std::cout << "ClusterClassifiers tool: No clusters found!" << std::endl;
+      return false;
+    }
+    get_clusters = m_data->CStore.Get("ClusterMapDetkey",all_clusters_detkey);
+    if (!get_clusters){
+      std::cout << "ClusterClassifiers tool: No ClusterMapDetkey!" << std::endl;
+      return false;
+    }
+    m_cluster_table.FromMaps(*all_clusters,*all_clusters_detkey);
+  } else {
+    std::map<double,std::vector<MCHit>>* all_clusters_MC = nullptr;
+    get_clusters = m_data->CStore.Get("ClusterMapMC",all_clusters_MC);
+    if(!get_clusters){
+      std::cout << "ClusterClassifiers tool: No clusters found! (MC)" << std::endl;
+      return false;
+    }
+    get_clusters = m_data->CStore.Get("ClusterMapDetkey",all_clusters_detkey);
+    if (!get_clusters){
+      std::cout << "ClusterClassifiers tool: No ClusterMapDetkey! (MC)" << std::endl;
+      return false;
+    }
+    m_cluster_table.FromMaps(*all_clusters_MC,*all_clusters_detkey);
+  }
+  return true;
 }
 
-Position ClusterClassifiers::CalculateChargePointMC(std::vector<MCHit> cluster_hits, std::vector<unsigned long> cluster_detkeys)
- {
-   if(verbosity>4) std::cout << "Calculating charge point" << std::endl;
-   double x_weight = 0;
-   double y_weight = 0;
-   double z_weight = 0;
-   Position detector_center=geom->GetTankCentre();
-   double tank_center_x = detector_center.X();
-   double tank_center_y = detector_center.Y();
-   double tank_center_z = detector_center.Z();
-
-   for (int i = 0; i < (int) cluster_hits.size(); i++){
-     MCHit ahit = cluster_hits.at(i); 
-     double hit_PE = ahit.GetCharge();
-     unsigned long detkey = cluster_detkeys.at(i);
-     int channel_key = (int) detkey;
-     int tubeid = ahit.GetTubeId();
-     unsigned long utubeid = (unsigned long) tubeid;
-     int wcsimid = channelkey_to_pmtid.at(tubeid);
-     unsigned long detkey_data = pmtid_to_channelkey[wcsimid];
-     int channel_key_data = (int) detkey_data;
-     double hit_charge = 0;
-     std::map<int, double>::iterator it = ChannelKeyToSPEMap.find(channel_key_data);
-     if(it != ChannelKeyToSPEMap.end()){ //Charge to SPE conversion is available
-       hit_charge  = hit_PE * ChannelKeyToSPEMap.at(channel_key_data);
-       Detector* this_detector = geom->ChannelToDetector(tubeid);
-       Position det_position = this_detector->GetDetectorPosition();
-       double pos_mag = sqrt(pow(det_position.X(),2) + pow(det_position.Y(),2) + pow(det_position.Z(),2));
-       x_weight+= (det_position.X()-tank_center_x)*hit_PE/pos_mag;
-       y_weight+= (det_position.Y()-tank_center_y)*hit_PE/pos_mag;
-       z_weight+= (det_position.Z()-tank_center_z)*hit_PE/pos_mag;
-     }
-   }
-
-   Position charge_weight(x_weight,y_weight,z_weight);
-   if(verbosity>4) std::cout << "ClusterClassifiers Tool: Calculated charge weight direction of  (" << charge_weight.X() << "," << charge_weight.Y() << "," << charge_weight.Z() << ")" << std::endl;
-   return charge_weight;
- }
-
-
-double ClusterClassifiers::CalculateChargeBalance(std::vector<Hit> cluster_hits)
+void ClusterClassifiers::ClassifyCluster(ClusterTable& clusters, int cluster_id)
 {
+  double total_PE = 0;
+  double max_PE = 0;
+  double x_weight = 0;
+  double y_weight = 0;
+  double z_weight = 0;
+  tube_charges.clear();
+
+  for (uint32_t i_hit = clusters.HitBegin(cluster_id); i_hit < clusters.HitEnd(cluster_id); i_hit++){
+    double hit_charge = clusters.HitCharge(i_hit);
+    int tubeid = clusters.HitTubeId(i_hit);
+    tube_charges.emplace_back(tubeid,hit_charge);
+    std::map<int,TubeInfo>::const_iterator it = TubeInfos.find(tubeid);
+    if (it == TubeInfos.end()) continue;  //No charge to SPE conversion available
+    const TubeInfo& info = it->second;
+    //MC hit charges are in PE already
+    double hit_PE = (isData) ? hit_charge / info.spe_charge : hit_charge;
+    total_PE += hit_PE;
+    if (hit_PE > max_PE) max_PE = hit_PE;
+    x_weight += info.dx*hit_PE/info.pos_mag;
+    y_weight += info.dy*hit_PE/info.pos_mag;
+    z_weight += info.dz*hit_PE/info.pos_mag;
+  }
+
+  //Charge balance of the charges summed per tube (in order of tube ID)
+  std::stable_sort(tube_charges.begin(),tube_charges.end(),
+    [](const std::pair<int,double>& a, const std::pair<int,double>& b){ return a.first < b.first; });
   double total_Q = 0;
   double total_QSquared = 0;
-  std::map<int, double> CBMap;
-  for (int i = 0; i < (int)cluster_hits.size(); i++){
-    Hit ahit = cluster_hits.at(i); 
-    double hit_charge = ahit.GetCharge();
-    int hit_ID = ahit.GetTubeId();
-    std::map<int, double>::iterator it = CBMap.find(hit_ID);
-    if(it != CBMap.end()){ //A hit from this tube has been seen before
-      CBMap.at(hit_ID)+=hit_charge;
-    } else {
-      CBMap.emplace(hit_ID,hit_charge);
-    }
-  }
-  for (std::pair<int,double> CBPair : CBMap) {
-    double tube_charge = CBPair.second;
-    total_Q+= tube_charge;
+  for (size_t i = 0; i < tube_charges.size();){
+    int hit_ID = tube_charges[i].first;
+    double tube_charge = 0;
+    for (; i < tube_charges.size() && tube_charges[i].first == hit_ID; i++) tube_charge += tube_charges[i].second;
+    total_Q += tube_charge;
     total_QSquared += (tube_charge * tube_charge);
   }
   //FIXME: Need a method to have the 1/N be equal to the number of operating detectors
   double charge_balance  = sqrt((total_QSquared)/(total_Q*total_Q) - (1./121.));
-  if(verbosity>4) std::cout << "ClusterClassifiers Tool: Calculated charge balance of " << charge_balance << std::endl;
-  return charge_balance;
-}
 
-double ClusterClassifiers::CalculateChargeBalanceMC(std::vector<MCHit> cluster_hits, std::vector<unsigned long> cluster_detkeys)
- {
-   double total_Q = 0;
-   double total_QSquared = 0;
-   std::map<int, double> CBMap;
-   for (int i = 0; i < (int) cluster_hits.size(); i++){
-     MCHit ahit = cluster_hits.at(i); 
-     double hit_charge = ahit.GetCharge();
-     int hit_ID = ahit.GetTubeId();
-     std::map<int, double>::iterator it = CBMap.find(hit_ID);
-     if(it != CBMap.end()){ //A hit from this tube has been seen before
-       CBMap.at(hit_ID)+=hit_charge;
-     } else {
-       CBMap.emplace(hit_ID,hit_charge);
-     }
-   }
-   for (std::pair<int,double> CBPair : CBMap) {
-     double tube_charge = CBPair.second;
-     total_Q+= tube_charge;
-     total_QSquared += (tube_charge * tube_charge);
-   }
-   //FIXME: Need a method to have the 1/N be equal to the number of operating detectors
-   double charge_balance  = sqrt((total_QSquared)/(total_Q*total_Q) - (1./121.));
-   if(verbosity>4) std::cout << "ClusterClassifiers Tool: Calculated charge balance of " << charge_balance << std::endl;
-   return charge_balance;
- }
-
-
-double ClusterClassifiers::CalculateMaxPE(std::vector<Hit> cluster_hits)
-{
-  double max_PE = 0;
-  for (int i = 0; i < (int) cluster_hits.size(); i++){
-    Hit ahit = cluster_hits.at(i); 
-    double hit_charge = ahit.GetCharge();
-    int channel_key = ahit.GetTubeId();
-    double hit_PE = 0;
-    std::map<int, double>::iterator it = ChannelKeyToSPEMap.find(channel_key);
-    if(it != ChannelKeyToSPEMap.end()){ //Charge to SPE conversion is available
-      hit_PE  = hit_charge / ChannelKeyToSPEMap.at(channel_key);
-      if(hit_PE > max_PE) max_PE = hit_PE;
-    }
+  Position charge_weight(x_weight,y_weight,z_weight);
+  clusters.SetFeatures(cluster_id,total_PE,max_PE,charge_balance,charge_weight);
+  if(verbosity>4){
+    std::cout << "ClusterClassifiers Tool: Calculated charge weight direction of  (" << charge_weight.X() << "," << charge_weight.Y() << "," << charge_weight.Z() << ")" << std::endl;
+    std::cout << "ClusterClassifiers Tool: Calculated charge balance of " << charge_balance << std::endl;
+    std::cout << "ClusterClassifiers Tool: Calculated max PE hit of " << max_PE << std::endl;
+    std::cout << "ClusterClassifiers Tool: Calculated total PE of " << total_PE << std::endl;
   }
-  if(verbosity>4) std::cout << "ClusterClassifiers Tool: Calculated max PE hit of " << max_PE << std::endl;
-  return max_PE;
 }
 
-double ClusterClassifiers::CalculateMaxPEMC(std::vector<MCHit> cluster_hits, std::vector<unsigned long> cluster_detkeys)
- {
-   double max_PE = 0;
-   for (int i = 0; i < (int) cluster_hits.size(); i++){
-     MCHit ahit = cluster_hits.at(i); 
-     double hit_charge = ahit.GetCharge();
-     //int channel_key = ahit.GetTubeId();
-     unsigned long detkey = cluster_detkeys.at(i);
-     int channel_key = (int) detkey;
-     int tubeid = ahit.GetTubeId();
-     unsigned long utubeid = (unsigned long) tubeid;
-     int wcsimid = channelkey_to_pmtid.at(utubeid);
-     unsigned long detkey_data = pmtid_to_channelkey[wcsimid];
-     int channel_key_data = (int) detkey_data;
-     std::map<int, double>::iterator it = ChannelKeyToSPEMap.find(channel_key_data);
-     if(it != ChannelKeyToSPEMap.end()){ //Charge to SPE conversion is available
-       if (hit_charge > max_PE) max_PE = hit_charge;
-     }
-   }
-   if(verbosity>4) std::cout << "ClusterClassifiers Tool: Calculated max PE hit of " << max_PE << std::endl;
-   return max_PE;
- }
-
-bool ClusterClassifiers::IdentifyPromptMuonCluster(std::map<double,double> cluster_totalq){
+bool ClusterClassifiers::IdentifyPromptMuonCluster(const ClusterTable& clusters){
  
   bool return_prompt = false;
-  int tmp_cluster_id = 0;
   int cluster_muon = -1;
   double max_pe = 0;
-  for (std::map<double,double>::iterator it = cluster_totalq.begin(); it!= cluster_totalq.end(); it++){
+  for (int cluster_id = 0; cluster_id < clusters.NClusters(); cluster_id++){
     //Check if the cluster charge is higher than the current maximum
     //Only consider clusters in the prompt window (time < 2000 ns)
-    if (it->second > max_pe && it->first < 2000){
-      max_pe = it->second;
-      cluster_muon = tmp_cluster_id;	//For now, associate the cluster with the highest charge with the muon
+    if (clusters.TotalPE(cluster_id) > max_pe && clusters.Time(cluster_id) < 2000){
+      max_pe = clusters.TotalPE(cluster_id);
+      cluster_muon = cluster_id;	//For now, associate the cluster with the highest charge with the muon
       return_prompt = true;
     }
-    tmp_cluster_id ++;
   }
 
   prompt_muon_index = cluster_muon; 
@@ -319,25 +243,23 @@ bool ClusterClassifiers::IdentifyPromptMuonCluster(std::map<double,double> clust
   return return_prompt;
 }
 
-bool ClusterClassifiers::IdentifyDelayedNeutronClusters(std::map<double,double> cluster_cb, std::map<double,double> cluster_totalq){
+bool ClusterClassifiers::IdentifyDelayedNeutronClusters(const ClusterTable& clusters){
 
   bool return_delayed = false;
-  int tmp_cluster_id = 0;
   std::vector<int> cluster_neutron;
-  for (std::map<double,double>::iterator it = cluster_totalq.begin(); it!= cluster_totalq.end(); it++){
+  for (int cluster_id = 0; cluster_id < clusters.NClusters(); cluster_id++){
     //Check if the cluster is in the delayed window and has a time > 10 us (exclude afterpulses)
     //The window should should be extended in the future after relevant exlusion cuts for afterpulsing have been implemented
     //check if the charge balance cut for neutrons is passed -> consider a neutron candidate
     //Improve the neutron selection cuts in the future, probably cutting more signal than necessary at the moment
-    if (it->first > 10000){
-      double current_cb = cluster_cb.at(it->first);
-      double current_q = cluster_totalq.at(it->first);
+    if (clusters.Time(cluster_id) > 10000){
+      double current_cb = clusters.ChargeBalance(cluster_id);
+      double current_q = clusters.TotalPE(cluster_id);
       if (current_cb < 0.4 && current_q < 150 && (current_cb <= (1. - current_q/150.)*0.5)){
-        cluster_neutron.push_back(tmp_cluster_id);
+        cluster_neutron.push_back(cluster_id);
         return_delayed = true;
       }
     }
-    tmp_cluster_id ++;
   }
 
   delayed_neutron_index = cluster_neutron;
@@ -345,45 +267,3 @@ bool ClusterClassifiers::IdentifyDelayedNeutronClusters(std::map<double,double>
   return return_delayed; 
 
 }
-
-double ClusterClassifiers::CalculateTotalPE(std::vector<Hit> cluster_hits)
-{ 
-  double total_PE = 0;
-  for (int i = 0; i < (int) cluster_hits.size(); i++){
-    Hit ahit = cluster_hits.at(i); 
-    double hit_charge = ahit.GetCharge();
-    int channel_key = ahit.GetTubeId();
-    double hit_PE = 0;
-    std::map<int, double>::iterator it = ChannelKeyToSPEMap.find(channel_key);
-    if(it != ChannelKeyToSPEMap.end()){ //Charge to SPE conversion is available
-      hit_PE  = hit_charge / ChannelKeyToSPEMap.at(channel_key);
-      total_PE += hit_PE;
-    }
-  }
-  if(verbosity>4) std::cout << "ClusterClassifiers Tool: Calculated total PE of " << total_PE << std::endl;
-  return total_PE;
-}
-
-double ClusterClassifiers::CalculateTotalPEMC(std::vector<MCHit> cluster_hits, std::vector<unsigned long> cluster_detkeys)
- {
-   double total_PE = 0;
-   for (int i = 0; i < (int) cluster_hits.size(); i++){
-     MCHit ahit = cluster_hits.at(i); 
-     double hit_charge = ahit.GetCharge();
-     //int channel_key = ahit.GetTubeId();
-     unsigned long detkey = cluster_detkeys.at(i);
-     int channel_key = (int) detkey;
-     int tubeid = ahit.GetTubeId();
-     unsigned long utubeid = (unsigned long) tubeid;
-     int wcsimid = channelkey_to_pmtid.at(utubeid);
-     unsigned long detkey_data = pmtid_to_channelkey[wcsimid];
-     int channel_key_data = (int) detkey_data;
-     std::map<int, double>::iterator it = ChannelKeyToSPEMap.find(channel_key_data);
-     if(it != ChannelKeyToSPEMap.end()){ //Charge to SPE conversion is available
-       total_PE += hit_charge;
-     }
-   }
-   if(verbosity>4) std::cout << "ClusterClassifiers Tool: Calculated total PE of " << total_PE << std::endl;
-   return total_PE;
- }
-
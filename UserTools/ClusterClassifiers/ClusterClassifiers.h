@@ -3,11 +3,13 @@
 
 #include <string>
 #include <iostream>
+#include <algorithm>
 
 #include "Tool.h"
 #include "Direction.h"
 #include "Position.h"
 #include "Geometry.h"
+#include "ClusterTable.h"
 
 /**
  * \class ClusterClassifiers
@@ -27,25 +29,28 @@ class ClusterClassifiers: public Tool {
   bool Initialise(std::string configfile,DataModel &data); ///< Initialise Function for setting up Tool resources. @param configfile The path and name of the dynamic configuration file to read in. @param data A reference to the transient data class used to pass information between Tools.
   bool Execute(); ///< Execute function used to perform Tool purpose.
   bool Finalise(); ///< Finalise function used to clean up resources.
-  Position CalculateChargePoint(std::vector<Hit> cluster_hits); ///< function to calculate the charge points for clusters (data)
-  double CalculateChargeBalance(std::vector<Hit> cluster_hits); ///< function to calculate the charge balance values for clusters (data)
-  double CalculateMaxPE(std::vector<Hit> cluster_hits); ///< function to identify the MaxPE value recorded by a single PMT in a cluster (data)
-  Position CalculateChargePointMC(std::vector<MCHit> cluster_hits, std::vector<unsigned long> cluster_detkeys); ///< function to calculate the charge points for clusters (MC)
-  double CalculateChargeBalanceMC(std::vector<MCHit> cluster_hits, std::vector<unsigned long> cluster_detkeys); ///< function to calculate the charge balance values for clusters (MC)
-  double CalculateMaxPEMC(std::vector<MCHit> cluster_hits, std::vector<unsigned long> cluster_detkeys); ///< function to calculate the MaxPE value recorded by a single PMT in a cluster (MC)
-  double CalculateTotalPE(std::vector<Hit> cluster_hits); ///< function to calculate the total PE recorded in a cluster (data)
-  double CalculateTotalPEMC(std::vector<MCHit> cluster_hits, std::vector<unsigned long> cluster_detkeys); ///< function to calculate the total PE recorded in a cluster (MC)
-  bool IdentifyPromptMuonCluster(std::map<double,double> cluster_totalq); ///< function to identify the prompt muon cluster
-  bool IdentifyDelayedNeutronClusters(std::map<double,double> cluster_cb, std::map<double,double> cluster_totalq); ///< function to identify delayed neutron clusters
+  void ClassifyCluster(ClusterTable& clusters, int cluster_id); ///< function to calculate the charge point, charge balance, max PE and total PE of a cluster in one pass over its hits
+  bool IdentifyPromptMuonCluster(const ClusterTable& clusters); ///< function to identify the prompt muon cluster
+  bool IdentifyDelayedNeutronClusters(const ClusterTable& clusters); ///< function to identify delayed neutron clusters
 
  private:
 
   std::map<int,double> ChannelKeyToSPEMap;
   bool isData;
 
-  std::map<double,std::vector<Hit>>* m_all_clusters = nullptr;  
-  std::map<double,std::vector<MCHit>>* m_all_clusters_MC = nullptr;
-  std::map<double,std::vector<unsigned long>>* m_all_clusters_detkey = nullptr;
+  bool ClustersFromMaps(); ///< Fill m_cluster_table from the cluster maps, if there is no cluster table in the CStore
+  void FillTubeInfo(); ///< Fill TubeInfos from the SPE calibration and the geometry
+
+  ClusterTable m_cluster_table;  //clusters read from the cluster maps
+
+  //per tube information needed for the cluster features
+  struct TubeInfo {
+    double spe_charge;
+    double dx, dy, dz;  //position relative to the tank centre
+    double pos_mag;
+  };
+  std::map<int,TubeInfo> TubeInfos;
+  std::vector<std::pair<int,double>> tube_charges;  //(tube ID, charge) of the hits of the current cluster
 
   Geometry *geom = nullptr;
 
@@ -1,4 +1,7 @@
 #include "ClusterDummy.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ClusterDummy);
 
 ClusterDummy::ClusterDummy():Tool(){}
 
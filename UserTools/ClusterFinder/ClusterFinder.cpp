@@ -1,4 +1,7 @@
 #include "ClusterFinder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ClusterFinder);
 
 ClusterFinder::ClusterFinder():Tool(){}
 
@@ -28,6 +31,7 @@ bool ClusterFinder::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("verbosity",verbose);
   m_variables.Get("end_of_window_time_cut",end_of_window_time_cut);
   m_variables.Get("MC_pulse_width",mc_pulse_width);
+  m_variables.Get("WriteClusterMaps",write_cluster_maps);
 
   //----------------------------------------------------------------------------
   //---------------Get basic geometry properties -------------------------------
@@ -133,6 +137,7 @@ bool ClusterFinder::Initialise(std::string configfile, DataModel &data){
   m_all_clusters = new std::map<double,std::vector<Hit>>;
   m_all_clusters_MC = new std::map<double,std::vector<MCHit>>;
   m_all_clusters_detkey = new std::map<double,std::vector<unsigned long>>;
+  m_cluster_table = new ClusterTable;
 
   return true;
 }
@@ -160,6 +165,7 @@ bool ClusterFinder::Execute(){
   m_all_clusters->clear();
   m_all_clusters_MC->clear();
   m_all_clusters_detkey->clear();
+  m_cluster_table->Clear();
 
   //----------------------------------------------------------------------------
   //---------------get the members of the ANNIEEvent----------------------------
@@ -328,9 +334,7 @@ bool ClusterFinder::Execute(){
   
   if (v_hittimes.size() == 0) {
     if (verbose > 1) cout << "No hits, event is skipped..." << endl;
-      if (HitStoreName == "Hits") m_data->CStore.Set("ClusterMap",m_all_clusters);
-      else if (HitStoreName == "MCHits") m_data->CStore.Set("ClusterMapMC",m_all_clusters_MC);
-      m_data->CStore.Set("ClusterMapDetkey",m_all_clusters_detkey);
+      this->StoreClusters();
       return true;
   }
 
@@ -450,16 +454,18 @@ bool ClusterFinder::Execute(){
   } while (true); 
   m_time_Nhits.clear();
 
-  // Now loop on the hit map again to get info about those local maxima, cluster per cluster
+  // Now loop on the hit map again to get info about those local maxima, cluster per cluster,
+  // and fill the hits of each cluster into the cluster table (to be passed through CStore)
   for (std::vector<double>::iterator it = v_clusters.begin(); it != v_clusters.end(); ++it) {
     double local_cluster_charge = 0;
     double local_cluster_time = 0;
     v_local_cluster_times.clear();
+    m_cluster_table->BeginCluster();
     if (HitStoreName == "Hits"){
       for(std::pair<unsigned long, std::vector<Hit>>&& apair : *Hits){
         unsigned long chankey = apair.first;
         Detector* thistube = geom->ChannelToDetector(chankey);
-        int detectorkey = thistube->GetDetectorID();
+        unsigned long detectorkey = thistube->GetDetectorID();
         if (thistube->GetDetectorElement()=="Tank"){
           std::vector<Hit>& ThisPMTHits = apair.second;
           PMT_ishit[detectorkey] = 1;
@@ -467,6 +473,7 @@ bool ClusterFinder::Execute(){
             if (ahit.GetTime() >= *it && ahit.GetTime() <= *it + ClusterFindingWindow) {
               local_cluster_charge += ahit.GetCharge();
               v_local_cluster_times.push_back(ahit.GetTime());
+              m_cluster_table->AddHit(ahit,detectorkey);
               if (verbose > 2) cout << "Local cluster at " << *it << " and hit is " << ahit.GetTime() << endl;
             }
           }
@@ -476,7 +483,7 @@ bool ClusterFinder::Execute(){
       for(std::pair<unsigned long, std::vector<MCHit>>&& apair : *MCHits){
         unsigned long chankey = apair.first;
         Detector* thistube = geom->ChannelToDetector(chankey);
-        int detectorkey = thistube->GetDetectorID();
+        unsigned long detectorkey = thistube->GetDetectorID();
         if (thistube->GetDetectorElement()=="Tank"){
           std::vector<MCHit>& ThisPMTHits = apair.second;
           PMT_ishit[detectorkey] = 1;
@@ -484,17 +491,20 @@ bool ClusterFinder::Execute(){
             if (ahit.GetTime() >= *it && ahit.GetTime() <= *it + ClusterFindingWindow) {
               local_cluster_charge += ahit.GetCharge();
               v_local_cluster_times.push_back(ahit.GetTime());
+              m_cluster_table->AddHit(ahit,detectorkey);
               if (verbose > 2) cout << "Local cluster at " << *it << " and hit is " << ahit.GetTime() << endl;
             }
           }
         }
       }
     }
+    if (v_local_cluster_times.empty()) continue;
     
     for (std::vector<double>::iterator itt = v_local_cluster_times.begin(); itt != v_local_cluster_times.end(); ++itt) {
      local_cluster_time += *itt;
     }
     local_cluster_time /= v_local_cluster_times.size();
+    m_cluster_table->EndCluster(local_cluster_time,local_cluster_charge);
     if (verbose > 0) cout << "Local cluster at " << local_cluster_time << " ns with a total charge of " << local_cluster_charge << " (" << v_local_cluster_times.size() << " hits)" << endl;
     h_Cluster_times->Fill(local_cluster_time);
     h_Cluster_charges->Fill(local_cluster_charge);
@@ -504,57 +514,11 @@ bool ClusterFinder::Execute(){
       if (draw_2D) h_Cluster_charge_deltaT->Fill(local_cluster_time - *std::min_element(v_clusters.begin(),v_clusters.end()),local_cluster_charge);
     }
     if (verbose > 2) cout << "Next cluster ..." << endl;
-
-    // Fills the map of clusters (to be passed through CStore)
-    if (HitStoreName == "Hits"){
-      for(std::pair<unsigned long, std::vector<Hit>>&& apair : *Hits) {   
-        unsigned long chankey = apair.first;
-        Detector* thistube = geom->ChannelToDetector(chankey);
-        unsigned long detectorkey = thistube->GetDetectorID();
-        if (thistube->GetDetectorElement()=="Tank"){
-          std::vector<Hit>& ThisPMTHits = apair.second;
-          PMT_ishit[detectorkey] = 1;
-          for (Hit &ahit : ThisPMTHits){
-            if (ahit.GetTime() >= *it && ahit.GetTime() <= *it + ClusterFindingWindow) { 
-              if(m_all_clusters->count(local_cluster_time)==0) {
-                m_all_clusters->emplace(local_cluster_time, std::vector<Hit>{ahit});
-                m_all_clusters_detkey->emplace(local_cluster_time, std::vector<unsigned long>{detectorkey});
-              } else { 
-                m_all_clusters->at(local_cluster_time).push_back(ahit);
-                m_all_clusters_detkey->at(local_cluster_time).push_back(detectorkey);
-              }
-            }
-          }  
-        }
-      }
-    } else if (HitStoreName == "MCHits"){
-      for(std::pair<unsigned long, std::vector<MCHit>>&& apair : *MCHits) {   
-        unsigned long chankey = apair.first;
-        Detector* thistube = geom->ChannelToDetector(chankey);
-        unsigned long detectorkey = thistube->GetDetectorID();
-        if (thistube->GetDetectorElement()=="Tank"){
-          std::vector<MCHit>& ThisPMTHits = apair.second;
-          PMT_ishit[detectorkey] = 1;
-          for (MCHit &ahit : ThisPMTHits){
-            if (ahit.GetTime() >= *it && ahit.GetTime() <= *it + ClusterFindingWindow) { 
-              if(m_all_clusters_MC->count(local_cluster_time)==0) {
-                m_all_clusters_MC->emplace(local_cluster_time, std::vector<MCHit>{ahit});
-                m_all_clusters_detkey->emplace(local_cluster_time, std::vector<unsigned long>{detectorkey});
-              } else { 
-                m_all_clusters_MC->at(local_cluster_time).push_back(ahit);
-                m_all_clusters_detkey->at(local_cluster_time).push_back(detectorkey);
-              }
-            }
-          }  
-        }
-      }
-    }
   }
 
-  // Load the cluster map in a CStore for use by a subsequent tool
-  if (HitStoreName == "Hits") m_data->CStore.Set("ClusterMap",m_all_clusters);
-  else if (HitStoreName == "MCHits") m_data->CStore.Set("ClusterMapMC",m_all_clusters_MC);
-  m_data->CStore.Set("ClusterMapDetkey",m_all_clusters_detkey);
+  // Load the clusters in the CStore for use by a subsequent tool
+  m_cluster_table->SortByTime();
+  this->StoreClusters();
 
   //check whether PMT_ishit is filled correctly
   for (int i_pmt = 0; i_pmt < n_tank_pmts ; i_pmt++){
@@ -605,6 +569,25 @@ bool ClusterFinder::Execute(){
 }
 
 
+void ClusterFinder::StoreClusters(){
+
+  // The table orders the clusters by time, like the maps, so the cluster
+  // IDs are the positions of the clusters in the maps. The table has no
+  // serialize(), so the store keeps the pointer only (persist=false)
+  m_data->CStore.Set("ClusterTable",m_cluster_table,false);
+
+  // The time-keyed maps are kept for the tools that do not read the table
+  if (!write_cluster_maps) return;
+  if (HitStoreName == "Hits"){
+    m_cluster_table->FillMaps(*m_all_clusters,*m_all_clusters_detkey);
+    m_data->CStore.Set("ClusterMap",m_all_clusters);
+  } else if (HitStoreName == "MCHits"){
+    m_cluster_table->FillMaps(*m_all_clusters_MC,*m_all_clusters_detkey);
+    m_data->CStore.Set("ClusterMapMC",m_all_clusters_MC);
+  }
+  m_data->CStore.Set("ClusterMapDetkey",m_all_clusters_detkey);
+}
+
 bool ClusterFinder::Finalise(){
 
   f_output->cd();
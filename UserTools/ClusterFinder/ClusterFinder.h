@@ -18,6 +18,7 @@
 #include "Position.h"
 #include "Direction.h"
 #include "Geometry.h"
+#include "ClusterTable.h"
 #include "TProfile.h"
 #include "TApplication.h"
 #include "TBox.h"
@@ -48,6 +49,7 @@ class ClusterFinder: public Tool {
   bool Initialise(std::string configfile,DataModel &data); ///< Initialise Function for setting up Tool resources. @param configfile The path and name of the dynamic configuration file to read in. @param data A reference to the transient data class used to pass information between Tools.
   bool Execute(); ///< Execute function used to perform Tool purpose.
   bool Finalise(); ///< Finalise function used to clean up resources.
+  void StoreClusters(); ///< Put the cluster table (and the cluster maps) into the CStore
 
 
  private:
@@ -68,6 +70,7 @@ class ClusterFinder: public Tool {
   bool draw_2D = false;
   double end_of_window_time_cut;
   double mc_pulse_width;
+  bool write_cluster_maps = true;
 
   // define ANNIEEvent variables
   int evnum;
@@ -121,6 +124,7 @@ class ClusterFinder: public Tool {
   std::map<double,std::vector<Hit>>* m_all_clusters;  
   std::map<double,std::vector<MCHit>>* m_all_clusters_MC;  
   std::map<double,std::vector<unsigned long>>* m_all_clusters_detkey; 
+  ClusterTable* m_cluster_table;
  
   // Other variables
   int max_Nhits = 0;
@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "DataSummary.h"
+#include "ToolRegistry.h"
 #include "RunTypeLabel.h"
 #include "TrigTypeLabel.h"
 
@@ -9,6 +10,8 @@
 #include <memory>
 #include <regex>
 
+#include <boost/filesystem.hpp>
+
 #include "TFile.h"
 #include "TTree.h"
 #include "TCanvas.h"
@@ -17,6 +20,8 @@
 #include "TGraphErrors.h"
 #include "TStyle.h"
 
+REGISTER_TOOL(DataSummary);
+
 DataSummary::DataSummary():Tool(){}
 
 bool DataSummary::Initialise(std::string configfile, DataModel &data){
@@ -43,6 +48,8 @@ bool DataSummary::Initialise(std::string configfile, DataModel &data){
 	OutputFileName="DataSummary.root";
 	FileFormat="CombinedStore";	//Other option: SeparateStores
 	FileList="None";	//Option to use filelist instead of regex matching
+	SummaryThreads=1;
+	SummaryCacheDir="";	//No caching of file summaries by default
 	
 	// read the user's preferences
 	m_variables.Get("verbosity",verbosity);
@@ -59,12 +66,18 @@ bool DataSummary::Initialise(std::string configfile, DataModel &data){
 	m_variables.Get("OutputFileDir",OutputFileDir);
 	m_variables.Get("OutputFileName",OutputFileName);
 	m_variables.Get("FileFormat",FileFormat);	
+	m_variables.Get("SummaryThreads",SummaryThreads);
+	m_variables.Get("SummaryCacheDir",SummaryCacheDir);
 
 	//Scan for wrong file format configuration
 	if (FileFormat != "SeparateStores" && FileFormat != "CombinedStore") {
 		Log("DataSummary tool: FileFormat option "+FileFormat+" not supported. Use SeparateStores",v_error,verbosity);
 		FileFormat = "SeparateStores";
 	}
+	if (SummaryThreads < 1) {
+		Log("DataSummary tool: SummaryThreads must be at least 1, using 1",v_warning,verbosity);
+		SummaryThreads = 1;
+	}
 
 	// scan for matching input files
 	int numfilesfound = 0;
@@ -75,20 +88,45 @@ bool DataSummary::Initialise(std::string configfile, DataModel &data){
 		return false;
 	}
 
-	std::cout << "List of matched filenames: "<<std::endl;
+	// one summary job per file (pair of files for separate stores), in RunSubrunPart order
+	std::vector<datasummary::FileJob> jobs;
+	Log("DataSummary tool: List of matched filenames:",v_message,verbosity);
 	for (std::map<std::string,std::string>::iterator it=filelist.begin(); it!=filelist.end(); it++){
-		std::cout <<it->first<<": "<<it->second<<std::endl;
+		datasummary::FileJob job;
+		job.key = it->first;
+		job.filename = it->second;
+		if (FileFormat == "SeparateStores"){
+			std::map<std::string,std::string>::iterator orphan_it = filelist_orphan.find(it->first);
+			if (orphan_it == filelist_orphan.end()){
+				Log("DataSummary tool error: No orphan file found for ANNIEEvent file "+it->second,v_error,verbosity);
+				return false;
+			}
+			job.orphan_filename = orphan_it->second;
+		}
+		std::map<std::string,std::vector<int>>::iterator rsp = filenumbers.find(it->first);
+		if (rsp != filenumbers.end()){
+			job.run = rsp->second.at(0);
+			job.subrun = rsp->second.at(1);
+			job.part = rsp->second.at(2);
+		}
+		Log(it->first+": "+job.filename+" "+job.orphan_filename,v_message,verbosity);
+		jobs.push_back(job);
 	}
 
-	if (FileFormat == "SeparateStores"){
-		for (std::map<std::string,std::string>::iterator it=filelist_orphan.begin(); it!=filelist_orphan.end(); it++){
-			std::cout <<it->first<<": "<<it->second<<std::endl;
+	if (!SummaryCacheDir.empty()){
+		boost::system::error_code ec;
+		boost::filesystem::create_directories(SummaryCacheDir,ec);
+		if (ec){
+			Log("DataSummary tool: Could not create SummaryCacheDir "+SummaryCacheDir+" ("+ec.message()+"), file summaries will not be cached",v_warning,verbosity);
+			SummaryCacheDir = "";
 		}
 	}
-
 	
 	// make the output file
 	CreateOutputFile();
+
+	// summarise the files in the background; Execute takes the summaries in file order
+	summarypool.Start(jobs,SummaryThreads,2*SummaryThreads,SummaryCacheDir);
 	
 	return true;
 }
@@ -96,175 +134,138 @@ bool DataSummary::Initialise(std::string configfile, DataModel &data){
 
 bool DataSummary::Execute(){
 	
-	// load next entry. Return of false indicates end of files: StopLoop will be set.
-	bool got_annieevent = LoadNextANNIEEventEntry();
-	bool got_orphan = LoadNextOrphanStoreEntry();
-	if(!got_annieevent && !got_orphan){
-		std::cout <<"no annie or orphan event"<<std::endl;
-		// i got nothin' ¯\_(ツ)_/¯
+	// get the summary of the next file. Return of false indicates end of files: StopLoop will be set.
+	datasummary::FileSummary summary;
+	if(!summarypool.Next(summary)){
+		m_data->vars.Set("StopLoop",1);
 		return true;
 	}
+	const datasummary::FileJob& job = summary.job;
+	if(!summary.error.empty()){
+		Log("DataSummary Tool: Error summarising file "+job.filename+": "+summary.error+". Skipping it",v_error,verbosity);
+		return true;
+	}
+	if(!summary.warning.empty()){
+		Log("DataSummary Tool: Warning! "+summary.warning+" for file "+job.filename,v_warning,verbosity);
+	}
+	Log("DataSummary Tool: "+std::string(summary.from_cache ? "Cached summary" : "Summary")+" of file "+job.filename
+		+": "+std::to_string(summary.events.size())+" events, "+std::to_string(summary.orphans.size())+" orphans",v_message,verbosity);
+
+	// run constants and sanity checks
+	RunNumber = summary.run_number;
+	if(job.run>=0 && (int)RunNumber!=job.run)
+		Log("DataSummary Tool: filename / entry mismatch for RunNumber!",v_error,verbosity);
+	SubrunNumber = summary.subrun_number;
+	if(job.subrun>=0 && (int)SubrunNumber!=job.subrun)
+		Log("DataSummary Tool: filename / entry mismatch for SubrunNumber!",v_error,verbosity);
+	// TODO... handle these errors? We should have an error log file.
+	PartNumber=job.part; // not stored so assume it's the same
+	RunStartTime = summary.run_start_time;
+	RunType = summary.run_type;
+	RunTypeString = runtype_to_string(RunTypeEnum(RunType));
 	
-	if(got_annieevent){
-		Log("DataSummary Tool: Getting information from ANNIEEvent",v_debug,verbosity);
-		
-		// variables we can directly retrieve
-		ANNIEEvent->Get("EventNumber",EventNumber);
-		ANNIEEvent->Get("EventTimeTank",PMTtimestamp);
-		ANNIEEvent->Get("EventTimeLAPPD",LAPPDtimestamp);
-		ANNIEEvent->Get("CTCTimestamp",CTCtimestamp);
-		ANNIEEvent->Get("EventTimeMRD",mrd_timeclass);       // convertme to MRDtimestamp
-		ANNIEEvent->Get("TriggerWord",TriggerWord);       // convert to TriggerTypeString
-		ANNIEEvent->Get("MRDLoopbackTDC",MRDLoopbackTDC); // convert to LoopbackTimestamp values
-		ANNIEEvent->Get("DataStreams",datastreams);  //DataStreams can be used to check which of the subdetectors is included in the data
-	        ANNIEEvent->Get("TriggerExtended",CTCWordExtended);
-
-        	// TODO optional sanity checks: consistency of RunNumber and other constants
-	
-		std::map<unsigned long, std::vector<Waveform<unsigned short>>> raw_waveform_map;
-		bool has_raw = ANNIEEvent->Get("RawADCData",raw_waveform_map);
-		
-		window_is_extended = false;
-		size_of_window = 2000;
-		window_sizes.clear();
-		window_chkeys.clear();
+	Log("DataSummary Tool: Filling Event tree",v_debug,verbosity);
+	for(const datasummary::EventRecord& event : summary.events) FillEvent(event);
+	Log("DataSummary Tool: Filling Orphan tree",v_debug,verbosity);
+	for(const datasummary::OrphanRecord& orphan : summary.orphans) FillOrphan(orphan);
 	
-		if (has_raw){
-			for (auto& temp_pair : raw_waveform_map) {
-				const auto& achannel_key = temp_pair.first;
-				auto& araw_waveforms = temp_pair.second;
-				for (unsigned int i=0; i< (int) araw_waveforms.size(); i++){
-					auto samples = araw_waveforms.at(i).GetSamples();
-        				int size_sample = 2*samples->size();
-					window_sizes.push_back(size_sample);
-					window_chkeys.push_back(achannel_key);
-					if (size_sample > size_of_window) {
-						size_of_window = size_sample;
-						window_is_extended = true;
-					}
-				}
-			}
-		}
+	return true;
+}
 
-		std::map<unsigned long, std::vector<int>> raw_acqsize_map;
-		bool has_raw_acqsize = ANNIEEvent->Get("RawAcqSize",raw_acqsize_map);
-		
-		if (has_raw_acqsize && !has_raw){
-			for (auto& temp_pair : raw_acqsize_map) {
-				const auto& achannel_key = temp_pair.first;
-				auto& araw_acqsize = temp_pair.second;
-				for (unsigned int i=0; i< (int) araw_acqsize.size(); i++){
-					int size_sample = 2*araw_acqsize.at(i);
-					window_sizes.push_back(size_sample);
-					window_chkeys.push_back(achannel_key);
-					if (size_sample > size_of_window){
-						size_of_window = size_sample;
-						window_is_extended = true;
-					}						
-				}
-			}
+void DataSummary::FillEvent(const datasummary::EventRecord& event){
+	
+	CTCtimestamp = event.ctc_timestamp;
+	PMTtimestamp = event.pmt_timestamp;
+	MRDtimestamp = event.mrd_timestamp;
+	LAPPDtimestamp = event.lappd_timestamp;
+	TriggerWord = event.trigger_word;
+	
+	window_is_extended = false;
+	size_of_window = 2000;
+	window_sizes = event.window_sizes;
+	window_chkeys = event.window_chkeys;
+	for (int size_sample : window_sizes){
+		if (size_sample > size_of_window){
+			size_of_window = size_sample;
+			window_is_extended = true;
 		}
-
-		if (!has_raw && !has_raw_acqsize) {
-   	 		Log("DataSummary tool: Did not find RawADCData or RawAcqSize in ANNIEEvent! Abort",v_error,verbosity);
-    			/*return false;*/
-  		}
-
-		// calculated variables
-		MRDtimestamp = (uint64_t) mrd_timeclass.GetNs();
-
-		PMTtimestamp_tree = (ULong64_t) PMTtimestamp;
-		CTCtimestamp_tree = (ULong64_t) CTCtimestamp;
-		MRDtimestamp_tree = (ULong64_t) MRDtimestamp;
-		LAPPDtimestamp_tree = (ULong64_t) LAPPDtimestamp;
-		PMTtimestamp_double = (double) PMTtimestamp_tree;
-		CTCtimestamp_double = (double) CTCtimestamp_tree;
-		MRDtimestamp_double = (double) MRDtimestamp_tree;
-		LAPPDtimestamp_double = (double) LAPPDtimestamp_tree;
-		PMTtimestamp_sec = (PMTtimestamp_double)/(1.E9);
-		MRDtimestamp_sec = (MRDtimestamp_double)/(1.E9);
-		CTCtimestamp_sec = (CTCtimestamp_double)/(1.E9);
-		LAPPDtimestamp_sec = (LAPPDtimestamp_double)/(1.E9);
-		trigword_ext = false;
-		trigword_ext_cc = false;
-		trigword_ext_nc = false;
-		if (CTCWordExtended > 0) trigword_ext = true;
-		if (CTCWordExtended == 1) trigword_ext_cc = true;
-		if (CTCWordExtended == 2) trigword_ext_nc = true;
-
-		std::cout <<"PMTtimestamp_tree: "<<PMTtimestamp_tree<<", MRDTimestamp_tree: "<<MRDtimestamp_tree<<std::endl;
-		// extract out the TDC vals
-		int beamloopbackTDCticks = MRDLoopbackTDC.at("BeamLoopbackTDC");
-		int cosmicloopbackTDCticks = MRDLoopbackTDC.at("CosmicLoopbackTDC");
-		// convert to ns
-		BeamLoopbackTimestamp = 4000. - 4.*(double)beamloopbackTDCticks;
-		CosmicLoopbackTimestamp = 4000. - 4.*(double)cosmicloopbackTDCticks;
-	
-		BeamLoopbackTimestamp_tree = (ULong64_t) BeamLoopbackTimestamp;
-		CosmicLoopbackTimestamp_tree = (ULong64_t) CosmicLoopbackTimestamp;
-		// FIXME to convert loopback TDC ticks to UTC time, we need to know the time difference
-		// between the loopback signal entering the TDC card and the loopback CTC event associated with it
-		// for now, i dunno, just neglect this
-		BeamLoopbackTimestamp += CTCtimestamp;
-		CosmicLoopbackTimestamp += CTCtimestamp;
-		// convert int word to enum class TriggerType, then convert enum class to string
-		TriggerTypeString = trigtype_to_string(TrigTypeEnum(TriggerWord));
-		SystemsPresent=0;
-		if(CTCtimestamp!=0) SystemsPresent |= 1;
-		if(PMTtimestamp!=0) SystemsPresent |= 2;
-		if(MRDtimestamp!=0) SystemsPresent |= 4;
-		LoopbacksPresent=0;
-		if(BeamLoopbackTimestamp!=0) LoopbacksPresent |= 1;
-		if(CosmicLoopbackTimestamp!=0) LoopbacksPresent |= 2;
-		
-		data_ctc = false;
-		data_tank = false;
-		data_mrd = false;
-		data_lappd = false;
-		if (datastreams["CTC"]==1) data_ctc = true;
-		if (datastreams["Tank"]==1) data_tank = true;
-		if (datastreams["MRD"]==1) data_mrd = true;
-		if (datastreams["LAPPD"]==1) data_lappd = true;
-
-		Log("DataSummary Tool: Filling Event tree",v_debug,verbosity);
-		outtree->Fill();
 	}
-	
-	if(got_orphan){
-		Log("DataSummary Tool: Getting information from OrphanStore",v_debug,verbosity);
-		// right now this is just a straight translation from BoostStore to ROOT =/
-		OrphanStore->Get("EventType",orphantype);
-		OrphanStore->Get("Timestamp",orphantimestamp);
-		OrphanStore->Get("TriggerWord",orphantrigword);
-		OrphanStore->Get("Reason",orphancause);
-		OrphanStore->Get("NumWaves",orphannumwaves);
-		OrphanStore->Get("WaveformChannels",orphanchannels);
-		OrphanStore->Get("WaveformChankeys",orphanchankeys);
-		OrphanStore->Get("MinTDiff",orphanmintdiff);	
-	
-		orphantimestamp_tree = (ULong64_t) orphantimestamp;
-		orphantimestamp_double = (double) orphantimestamp_tree;
-		orphantimestamp_sec = orphantimestamp_double/(1.E9);
-		orphanchankeys_int.clear();
-		orphanchannels_combined.clear();
-		for (int i_vec=0; i_vec < (int) orphanchankeys.size(); i_vec++){
-			orphanchankeys_int.push_back(int(orphanchankeys.at(i_vec)));
-		}
-		for (int i_vec=0; i_vec < (int) orphanchannels.size(); i_vec++){
-			std::vector<int> orphanchannels_single = orphanchannels.at(i_vec);
-			orphanchannels_combined.push_back(1000*orphanchannels_single.at(0)+10*orphanchannels_single.at(1)+orphanchannels_single.at(2));
-		}
 
-		Log("DataSummary Tool: Filling Orphan tree",v_debug,verbosity);
-		outtree2->Fill();
-	}
+	// calculated variables
+	PMTtimestamp_tree = (ULong64_t) PMTtimestamp;
+	CTCtimestamp_tree = (ULong64_t) CTCtimestamp;
+	MRDtimestamp_tree = (ULong64_t) MRDtimestamp;
+	LAPPDtimestamp_tree = (ULong64_t) LAPPDtimestamp;
+	PMTtimestamp_double = (double) PMTtimestamp_tree;
+	CTCtimestamp_double = (double) CTCtimestamp_tree;
+	MRDtimestamp_double = (double) MRDtimestamp_tree;
+	LAPPDtimestamp_double = (double) LAPPDtimestamp_tree;
+	PMTtimestamp_sec = (PMTtimestamp_double)/(1.E9);
+	MRDtimestamp_sec = (MRDtimestamp_double)/(1.E9);
+	CTCtimestamp_sec = (CTCtimestamp_double)/(1.E9);
+	LAPPDtimestamp_sec = (LAPPDtimestamp_double)/(1.E9);
+	trigword_ext = false;
+	trigword_ext_cc = false;
+	trigword_ext_nc = false;
+	if (event.trigger_extended > 0) trigword_ext = true;
+	if (event.trigger_extended == 1) trigword_ext_cc = true;
+	if (event.trigger_extended == 2) trigword_ext_nc = true;
+
+	Log("DataSummary Tool: PMTtimestamp_tree: "+std::to_string(PMTtimestamp_tree)+", MRDTimestamp_tree: "+std::to_string(MRDtimestamp_tree),v_debug,verbosity);
+	// convert the loopback TDC vals to ns
+	BeamLoopbackTimestamp = 4000. - 4.*(double)event.beam_loopback_tdc;
+	CosmicLoopbackTimestamp = 4000. - 4.*(double)event.cosmic_loopback_tdc;
+
+	BeamLoopbackTimestamp_tree = (ULong64_t) BeamLoopbackTimestamp;
+	CosmicLoopbackTimestamp_tree = (ULong64_t) CosmicLoopbackTimestamp;
+	// FIXME to convert loopback TDC ticks to UTC time, we need to know the time difference
+	// between the loopback signal entering the TDC card and the loopback CTC event associated with it
+	// for now, i dunno, just neglect this
+	BeamLoopbackTimestamp += CTCtimestamp;
+	CosmicLoopbackTimestamp += CTCtimestamp;
+	// convert int word to enum class TriggerType, then convert enum class to string
+	TriggerTypeString = trigtype_to_string(TrigTypeEnum(TriggerWord));
+	SystemsPresent=0;
+	if(CTCtimestamp!=0) SystemsPresent |= 1;
+	if(PMTtimestamp!=0) SystemsPresent |= 2;
+	if(MRDtimestamp!=0) SystemsPresent |= 4;
+	LoopbacksPresent=0;
+	if(BeamLoopbackTimestamp!=0) LoopbacksPresent |= 1;
+	if(CosmicLoopbackTimestamp!=0) LoopbacksPresent |= 2;
+	
+	data_ctc = event.data_ctc;
+	data_tank = event.data_tank;
+	data_mrd = event.data_mrd;
+	data_lappd = event.data_lappd;
+
+	outtree->Fill();
+}
+
+void DataSummary::FillOrphan(const datasummary::OrphanRecord& orphan){
 	
-	return true;
+	// right now this is just a straight translation from BoostStore to ROOT =/
+	orphantype = orphan.type;
+	orphantimestamp = orphan.timestamp;
+	orphantrigword = orphan.trigger_word;
+	orphancause = orphan.cause;
+	orphannumwaves = orphan.num_waves;
+	orphanchankeys_int = orphan.chankeys;
+	orphanchannels_combined = orphan.channels;
+	orphanmintdiff = orphan.min_tdiff;
+
+	orphantimestamp_tree = (ULong64_t) orphantimestamp;
+	orphantimestamp_double = (double) orphantimestamp_tree;
+	orphantimestamp_sec = orphantimestamp_double/(1.E9);
+
+	outtree2->Fill();
 }
 
 
 bool DataSummary::Finalise(){
 	
+	// stop any summaries still in flight if the loop ended early
+	summarypool.Stop();
+	
 	// ensure the ttree is fully written out
 	outfile->Write("*",TObject::kOverwrite);
 	
@@ -284,204 +285,66 @@ bool DataSummary::Finalise(){
 	return true;
 }
 
-int DataSummary::ScanForFiles(std::string inputdir, std::string filepattern, std::string filepattern_orphan){
-	// Scan the input directory for all files matching the specified pattern and run range
-	
-	// Step 1:
-	// first, find matching files
-	// TODO we should give booststores an extension: for now insist R*S*p* comes at the end of the filename
-	std::string slash = "/";
-	std::string lscommand = std::string("find ") + inputdir +std::string(" -regextype egrep -iregex '.*?")
-	   + InputFilePattern + std::string("R([0-9]+)S([0-9]+)[pP]([0-9]+)$'");
-	std::cout <<"lscommand: "<<lscommand<<std::endl;
-	std::string fileliststring = GetStdoutFromCommand(lscommand);
-
-	std::stringstream ssl;
-	ssl << fileliststring;
-	std::vector<std::string> flist;
-	std::string nextfilestring;
-	while(getline(ssl,nextfilestring)){
-		flist.push_back(nextfilestring);
-	}
-	
-	std::vector<std::string> flist_orphan;
-	if (FileFormat == "SeparateStores"){
-		std::string lscommand_orphan = std::string("find ")+inputdir+std::string(" -regextype egrep -iregex '.*?")
-	   	+ InputFilePatternOrphan + std::string("R([0-9]+)S([0-9]+)[pP]([0-9]+)$'");
-		std::cout <<"lscommand_orphan: "<<lscommand_orphan<<std::endl;
-		std::string fileliststring_orphan = GetStdoutFromCommand(lscommand_orphan);
-		std::cout <<"fileliststring_orphan: "<<fileliststring_orphan<<std::endl;
-	
-        	std::stringstream ssl_orphan;
-		ssl_orphan << fileliststring_orphan;
-		std::string nextfilestring_orphan;
-		while(getline(ssl_orphan,nextfilestring_orphan)){
-			flist_orphan.push_back(nextfilestring_orphan);
-		}
-		if (flist.size() != flist_orphan.size()) {
-			Log("DataSummary tool error: Did not find the same number of orphan files and ANNIEEvent files. # of ANNIEEvent files: "+std::to_string(flist_orphan.size())+", # of Orphan files: "+std::to_string(flist.size()),v_error,verbosity);
-			return 0;
-		}
-	}
-
+bool DataSummary::InRange(int run, int subrun, int part){
+	return (run>=StartRun || StartRun<0)
+		&& (subrun>=StartSubRun || StartSubRun<0)
+		&& (part>=StartPart || StartPart<0)
+		&& (run<=EndRun || EndRun<0)
+		&& (subrun<=EndSubRun || EndSubRun<0)
+		&& (part<=EndPart || EndPart<0);
+}
 
-	// now parse the list of files and extract those that the range of run/subrun numbers
-	std::cout <<"Filling filelist"<<std::endl;
-	filelist.clear();
-	int i=0;
-	for(auto afile : flist){
-		/*//try{
-			// extract run, subrun and part using a regex match
-			std::cout <<"afile: "<<afile<<std::endl;
+int DataSummary::FindFiles(std::string inputdir, std::string filepattern, std::map<std::string,std::string>& files){
+	// Walk inputdir and its subdirectories for files matching the pattern and run range
+	// TODO we should give booststores an extension: for now insist R*S*p* comes at the end of the filename
+	std::regex theexpression(".*?"+filepattern+"R([0-9]+)S([0-9]+)[pP]([0-9]+)$",std::regex::icase);
+	files.clear();
+	int nmatched = 0;
+	try {
+		boost::filesystem::recursive_directory_iterator it(inputdir,boost::filesystem::symlink_option::recurse), end;
+		for( ; it!=end; ++it){
+			if(boost::filesystem::is_directory(it->status())) continue;
+			std::string afile = it->path().string();
 			std::smatch submatches;
-			std::cout <<"regex theexpression"<<std::endl;
-			std::regex theexpression(".*?R([0-9]+)S([0-9]+)[pP]([0-9]+).*",std::regex::extended);
-			std::cout <<"regex_match"<<std::endl;
-			std::regex_match ((std::string)afile, submatches, theexpression);
-			std::cout <<"submatches.size(): "<<submatches.size()<<std::endl;
-			std::string runstring = (std::string)submatches[1];
-			std::string subrunstring = (std::string)submatches[2];
-			std::string partstring = (std::string)submatches[3];
-			run = stoi(runstring);
-			subrun = stoi(subrunstring);
-			part = stoi(partstring);
-		//} catch(const std::out_of_range& oor){continue;}
-		
-		// check within range
-		if(    (run>=StartRun || StartRun<0)
-			&& (subrun>=StartSubRun || StartSubRun<0)
-			&& (part>=StartPart || StartPart<0)
-			&& (run<EndRun || EndRun<0)
-			&& (subrun<EndSubRun || EndSubRun<0)
-			&& (part<EndPart || EndPart<0)
-		){
-			// ensure files are in the correct order by using a map with suitable key
-			// assume no more than 1000 parts per subrun, 1000 subruns per run, 1000000 runs
-			char buffer [13];
-			snprintf(buffer, 13, "%06d%03d%03d", run, subrun, part);
-			filelist.emplace(buffer,afile);
-		}*/
-
-		//Get run number
-		run = -1;
-		subrun = -1;
-		part = -1;
-		std::stringstream InputFilePatternR;
-		InputFilePatternR << InputFilePattern << "R";
-		size_t rawdata_pos = afile.find(InputFilePatternR.str().c_str());
-		if (rawdata_pos != std::string::npos){
-			std::string filenamerun = afile.substr(rawdata_pos+InputFilePattern.length()+1);
-			size_t pos_sub = filenamerun.find("S");
-			std::string run_str = filenamerun.substr(0,pos_sub);
-  			run = std::stoi(run_str);
-			std::string filenamesubrun = filenamerun.substr(pos_sub+1);
-			size_t pos_part = filenamesubrun.find("p");
-			std::string subrun_str = filenamesubrun.substr(0,pos_part);
-  			subrun = std::stoi(subrun_str);
-			std::string filenamepart = filenamesubrun.substr(pos_part+1);
-			part = std::stoi(filenamepart);
-		}
-		std::cout <<"Found run number: "<<run<<", subrun nr: "<<subrun<<", part nr: "<<part<<std::endl;
-		// check within range
-		if(    (run>=StartRun || StartRun<0)
-			&& (subrun>=StartSubRun || StartSubRun<0)
-			&& (part>=StartPart || StartPart<0)
-			&& (run<=EndRun || EndRun<0)
-			&& (subrun<=EndSubRun || EndSubRun<0)
-			&& (part<=EndPart || EndPart<0)
-		){
-			// ensure files are in the correct order by using a map with suitable key
-			// assume no more than 1000 parts per subrun, 1000 subruns per run, 1000000 runs
-			char buffer [13];
-			snprintf(buffer, 13, "%06d%03d%03d", run, subrun, part);
-			filelist.emplace(buffer,afile);
-		}
-/*
-		run=2282;
-		subrun=0;
-		char buffer [13];
-		snprintf(buffer,13,"%06d%03d%03d", 2282, 0, i);
-		filelist.emplace(buffer,afile);
-		i++;*/
-	}
-	
-	std::cout <<"Filling filelist_orphan"<<std::endl;
-	if (FileFormat == "SeparateStores"){
-		i=0;
-		filelist_orphan.clear();
-		for(auto afile : flist_orphan){
-		/*	//try{
-				// extract run, subrun and part using a regex match
-				std::smatch submatches;
-				std::regex theexpression (".*?R([0-9]+)S([0-9]+)[pP]([0-9]+).*");
-				std::regex_match ((std::string)afile, submatches, theexpression);
-				std::string runstring = (std::string)submatches[1];
-				std::string subrunstring = (std::string)submatches[2];
-				std::string partstring = (std::string)submatches[3];
-				run = stoi(runstring);
-				subrun = stoi(subrunstring);
-				part = stoi(partstring);
-			//} catch(const std::out_of_range& oor){continue;}
-			
+			if(!std::regex_match(afile,submatches,theexpression)) continue;
+			++nmatched;
+			int run = -1, subrun = -1, part = -1;
+			try {
+				run = std::stoi(submatches[1]);
+				subrun = std::stoi(submatches[2]);
+				part = std::stoi(submatches[3]);
+			} catch(const std::out_of_range& oor){
+				Log("DataSummary tool: Run numbers of file "+afile+" out of range, skipping it",v_warning,verbosity);
+				continue;
+			}
+			Log("DataSummary tool: Found "+afile+": run "+std::to_string(run)+", subrun "+std::to_string(subrun)+", part "+std::to_string(part),v_debug,verbosity);
 			// check within range
-			if(    (run>=StartRun || StartRun<0)
-				&& (subrun>=StartSubRun || StartSubRun<0)
-				&& (part>=StartPart || StartPart<0)
-				&& (run<=EndRun || EndRun<0)
-				&& (subrun<=EndSubRun || EndSubRun<0)
-				&& (part<=EndPart || EndPart<0)
-			){
+			if(InRange(run,subrun,part)){
 				// ensure files are in the correct order by using a map with suitable key
 				// assume no more than 1000 parts per subrun, 1000 subruns per run, 1000000 runs
 				char buffer [13];
 				snprintf(buffer, 13, "%06d%03d%03d", run, subrun, part);
-				filelist_orphan.emplace(buffer,afile);
-			}*/
-			
-			//Get run number
-                	run = -1;
-                	subrun = -1;
-                	part = -1;
-                	std::stringstream InputFilePatternOrphanR;
-                	InputFilePatternOrphanR << InputFilePatternOrphan << "R";
-                	size_t rawdata_pos = afile.find(InputFilePatternOrphanR.str().c_str());
-                	if (rawdata_pos != std::string::npos){
-                        	std::string filenamerun = afile.substr(rawdata_pos+InputFilePatternOrphan.length()+1);
-                        	size_t pos_sub = filenamerun.find("S");
-                        	std::string run_str = filenamerun.substr(0,pos_sub);
-                        	run = std::stoi(run_str);
-                        	std::string filenamesubrun = filenamerun.substr(pos_sub+1);
-                        	size_t pos_part = filenamesubrun.find("p");
-                        	std::string subrun_str = filenamesubrun.substr(0,pos_part);
-                        	subrun = std::stoi(subrun_str);
-                        	std::string filenamepart = filenamesubrun.substr(pos_part+1);
-                        	part = std::stoi(filenamepart);
-                	}
-                	std::cout <<"Found run number: "<<run<<", subrun nr: "<<subrun<<", part nr: "<<part<<std::endl;
-               		// check within range
-                	if(    (run>=StartRun || StartRun<0)
-                        	&& (subrun>=StartSubRun || StartSubRun<0)
-                        	&& (part>=StartPart || StartPart<0)
-                        	&& (run<=EndRun || EndRun<0)
-                       		&& (subrun<=EndSubRun || EndSubRun<0)
-                        	&& (part<=EndPart || EndPart<0)
-                	){
-                        	// ensure files are in the correct order by using a map with suitable key
-                        	// assume no more than 1000 parts per subrun, 1000 subruns per run, 1000000 runs
-                        	char buffer [13];
-                        	snprintf(buffer, 13, "%06d%03d%03d", run, subrun, part);
-                        	filelist_orphan.emplace(buffer,afile);
-                	}
-			/*
-			char buffer[13];
-			snprintf(buffer,13,"%06d%03d%03d",2282,0,i);
-			filelist_orphan.emplace(buffer,afile);
-			i++;*/
+				files.emplace(buffer,afile);
+				filenumbers[buffer] = std::vector<int>{run,subrun,part};
+			}
 		}
+	} catch(const boost::filesystem::filesystem_error& e){
+		Log("DataSummary tool: Error scanning "+inputdir+": "+e.what(),v_error,verbosity);
 	}
+	return nmatched;
+}
 
-	nextfile=filelist.begin();
-	if (FileFormat == "SeparateStores") nextfile_orphan=filelist_orphan.begin();
+int DataSummary::ScanForFiles(std::string inputdir, std::string filepattern, std::string filepattern_orphan){
+	// Scan the input directory for all files matching the specified pattern and run range
+	filenumbers.clear();
+	int nfiles = FindFiles(inputdir,filepattern,filelist);
+	if (FileFormat == "SeparateStores"){
+		int nfiles_orphan = FindFiles(inputdir,filepattern_orphan,filelist_orphan);
+		if (nfiles != nfiles_orphan) {
+			Log("DataSummary tool error: Did not find the same number of orphan files and ANNIEEvent files. # of ANNIEEvent files: "+std::to_string(nfiles)+", # of Orphan files: "+std::to_string(nfiles_orphan),v_error,verbosity);
+			return 0;
+		}
+	}
 	return filelist.size();
 }
 
@@ -509,170 +372,10 @@ int DataSummary::ReadInFileList(std::string filelist_user){
 		}
 	}
 
-	nextfile=filelist.begin();
-	if (FileFormat == "SeparateStores") nextfile_orphan=filelist_orphan.begin();
-
 	return i;
 
 }
 
-bool DataSummary::LoadNextANNIEEventEntry(){
-	// load next ANNIEEvent entry
-	localentry++;
-	globalentry++;
-	std::cout <<"Load localentry: "<<localentry<<" / "<<localentries<<" for ANNIEEvent"<<std::endl;
-	if((localentry>=localentries)&&(localorphan>=localorphans)){
-		// end of this file, try to load next file
-		bool load_ok = LoadNextFile();
-		if(not load_ok){
-			// failed to load any further files. Terminate.
-			m_data->vars.Set("StopLoop",1);
-			return false;
-		}
-		return ANNIEEvent->GetEntry(localentry);
-	} else if(localentry<localentries){
-		return ANNIEEvent->GetEntry(localentry);
-	} else {
-          // else no more ANNIEEvents, but we didn't load a new file
-	  // because there are still Orphans to process
-	  return false;
-	}
-	return false;  // dummy
-}
-
-bool DataSummary::LoadNextOrphanStoreEntry(){
-	// load next OrphanStore entry
-	localorphan++;
-	globalorphan++;
-	std::cout <<"Load local orphan: "<<localorphan<<" / "<<localorphans<<" for OrphanStore"<<std::endl;
-	// if we've run out of entries in both stores, load the next file
-	if((localorphan>=localorphans)&&(localentry>=localentries)){
-		bool load_ok = LoadNextFile();
-		std::cout <<"load_ok: "<<load_ok<<std::endl;
-		if(not load_ok){
-			// failed to load any further files. Terminate.
-			m_variables.Set("StopLoop",true);
-			return false;
-		}
-		return OrphanStore->GetEntry(localorphan);
-	} else if(localorphan<localorphans){
-		// not a new file, still entries to process
-		return OrphanStore->GetEntry(localorphan);
-	} else {
-	 // else no more orphans, but we didn't load a new file
-	  // because there are still ANNIEEvents to process
-	return false;
-	}
-}
-
-bool DataSummary::LoadNextFile(){
-	// get next filename
-	if(nextfile==filelist.end()){
-		// no more files
-		return false;
-	}
-	std::string nextfilename = nextfile->second;
-	
-	std::string nextfilename_orphan;
-	if (FileFormat=="SeparateStores"){
-		if (nextfile_orphan==filelist_orphan.end()){
-			return false;
-		}
-		nextfilename_orphan = nextfile_orphan->second;
-	}
-
-	// Delete the old file BoostStores if they exist
-	if(ProcessedFileStore){
-		ProcessedFileStore->Close();
-		ProcessedFileStore->Delete();
-		delete ProcessedFileStore;
-	}
-	if(ANNIEEvent){
-		ANNIEEvent->Close();
-		ANNIEEvent->Delete();
-		delete ANNIEEvent;
-	}
-	if(OrphanStore){
-		OrphanStore->Close();
-		OrphanStore->Delete();
-		delete OrphanStore;
-	}
-	
-	// create a store for the file contents
-        if (FileFormat == "CombinedStore") {
-		ProcessedFileStore = new BoostStore(false,BOOST_STORE_BINARY_FORMAT);
-		// Load the contents from the new input file into it
-		std::cout <<"Reading in current file "<<nextfilename<<std::endl;
-		int load_ok = ProcessedFileStore->Initialise(nextfilename);
-		if(not load_ok) return false;
-	}
-
-	// create an ANNIEEvent BoostStore and an OrphanStore BoostStore to load from it
-	ANNIEEvent = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
-	OrphanStore = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
-	
-	if (FileFormat == "CombinedStore"){
-
-	// retrieve the multi-event stores
-	ProcessedFileStore->Get("ANNIEEvent",*ANNIEEvent);
-	ANNIEEvent->Header->Get("TotalEntries", localentries);
-	
-	// same for Orphan Store
-	ProcessedFileStore->Get("OrphanStore",*OrphanStore);
-	OrphanStore->Header->Get("TotalEntries", localorphans);
-	}
-	else {
-
-		Log("DataSummary tool: Reading in current ANNIEEvent file "+nextfilename,v_message,verbosity);
-		ANNIEEvent->Initialise(nextfilename);
-		ANNIEEvent->Header->Get("TotalEntries",localentries);
-
-		Log("DataSummary tool: Reading in current Orphan file "+nextfilename_orphan,v_message,verbosity);
-		OrphanStore->Initialise(nextfilename_orphan);
-		OrphanStore->Header->Get("TotalEntries",localorphans);
-
-	}
-
-	nextfile++;
-	localentry = 0;
-	localorphan = 0;
-	
-	if (FileFormat == "SeparateStores") nextfile_orphan++;
-
-	// load run constants and sanity checks
-	get_ok = ANNIEEvent->GetEntry(0);
-	if(not get_ok){
-		Log("DataSummary Tool: Error getting ANNIEEvent entry 0 from new file "+nextfilename,v_error,verbosity);
-		return false;
-	}
-	ANNIEEvent->Get("RunNumber",RunNumber);
-	std::cout <<"RunNumber: "<<RunNumber<<", run: "<<run<<std::endl;
-	if((int)RunNumber!=run)
-		Log("DataSummary Tool: filename / entry mismatch for RunNumber!",v_error,verbosity);
-	ANNIEEvent->Get("SubrunNumber",SubrunNumber);
-	if((int)SubrunNumber!=subrun)
-		Log("DataSummary Tool: filename / entry mismatch for SubrunNumber!",v_error,verbosity);
-	// TODO... handle these errors? We should have an error log file.
-	PartNumber=part; // not stored so assume it's the same
-	
-	// we can read these just once at the start of the file
-	ANNIEEvent->Get("RunStartTime",RunStartTime);
-	ANNIEEvent->Get("RunType",RunType);
-	RunTypeString = runtype_to_string(RunTypeEnum(RunType));
-	
-	// TODO sanity checks to ensure these don't change between part files
-	
-	get_ok = OrphanStore->GetEntry(0);
-	if(not get_ok){
-		// I guess there aren't necessarily any orphans...
-		Log("DataSummary Tool: Warning! No orphans in OrphanStore for file "+nextfilename,v_warning,verbosity);
-		//Log("DataSummary Tool: Error getting OrphanStore entry 0 from new file "+nextfilename,v_error,verbosity);
-		//return false;
-	}
-	
-	return true;
-}
-
 bool DataSummary::CreateOutputFile(){
 	outfile = new TFile((OutputFileDir+"/"+OutputFileName).c_str(),"RECREATE");
 	outtree = new TTree("EventStats","EventStats Tree");
@@ -6,6 +6,7 @@
 #include <iostream>
 
 #include "Tool.h"
+#include "FileSummary.h"
 
 class TFile;
 class TTree;
@@ -45,20 +46,13 @@ class DataSummary: public Tool {
 	std::string FileFormat;	
 	// list of files to process, in order. key is RunSubrunPart, zero-padded to ensure order
 	std::map<std::string,std::string> filelist;
-	std::map<std::string,std::string>::iterator nextfile; // the next file to be loaded
 	std::map<std::string,std::string> filelist_orphan;
-	std::map<std::string,std::string>::iterator nextfile_orphan; // the next file to be loaded
+	std::map<std::string,std::vector<int>> filenumbers; // run, subrun, part of each key, from the filename
 
-	// BoostStore to read data into
-	BoostStore* ProcessedFileStore=nullptr;
-	BoostStore* ANNIEEvent=nullptr;
-	BoostStore* OrphanStore=nullptr;
-	uint64_t globalentry = 0;  // entry number across all processed BoostStores
-	uint64_t localentry = 0;   // entry number in the current BoostStore
-	uint64_t localentries = 0; // number of entries in the current BoostStore
-	uint64_t globalorphan = 0; // same as above but for orphan store
-	uint64_t localorphan = 0;
-	uint64_t localorphans = 0;
+	// files are summarised by worker threads, and optionally cached
+	int SummaryThreads;
+	std::string SummaryCacheDir;
+	datasummary::SummaryPool summarypool;
 	
 	// output file
 	std::string OutputFileDir;
@@ -75,20 +69,16 @@ class DataSummary: public Tool {
 	int RunType;                      // RunType
 	std::string RunTypeString;        // convert RunType from int
 	uint64_t RunStartTime;            // RunStartTime
-	int run,subrun,part;              // extracted from filename
 	
 	// used for making plots on time axis; first and last timestamp
 	double t0;
 	double tn;
 	
 	// event level
-	uint32_t EventNumber;             // EventNumber - or use global? local?
 	uint64_t CTCtimestamp;            // CTCTimestamp
 	uint64_t PMTtimestamp;            // EventTimeTank
 	uint64_t LAPPDtimestamp;            // EventTimeLAPPD
-	TimeClass mrd_timeclass;          // EventTime in ANNIEEvent
-	uint64_t MRDtimestamp;            // <need to convert from mrd_timeclass>
-	std::map<std::string,int> MRDLoopbackTDC; // map of loopback type string to TDCVal
+	uint64_t MRDtimestamp;            // EventTimeMRD, in ns
 	uint64_t BeamLoopbackTimestamp;   // <need to calculate from MRDLoopbackTDC TDCVal>
 	uint64_t CosmicLoopbackTimestamp; // <need to calculate from MRDLoopbackTDC TDCVal>
 	uint32_t TriggerWord;             // TriggerWord
@@ -96,7 +86,6 @@ class DataSummary: public Tool {
 	uint8_t SystemsPresent;           // <int of what readouts were present>
 	uint8_t LoopbacksPresent;         // <int of what loopbacks were present>
 	TimeClass EventTime;              // <should we make some official TimeClass object? e.g. from CTC?>
-	std::map<std::string,bool> datastreams; // DataStreams (which subdetectors saw a coincident timestamp?)
 	bool data_ctc;			// Does the event include CTC info?
 	bool data_tank;			// Does the event include Tank data?
 	bool data_mrd;			// Does the event include MRD data?
@@ -105,7 +94,6 @@ class DataSummary: public Tool {
 	int size_of_window = 2000;	//The size of the acquisition window (in us)
 	std::vector<int> window_sizes;	//ADC acquisition sizes for all recorded channels
 	std::vector<int> window_chkeys;	//Chankeys for ADC acquisition window sizes
-	int CTCWordExtended;  //Trigword information about extended windows
 
 	ULong64_t CTCtimestamp_tree;
 	ULong64_t PMTtimestamp_tree;
@@ -133,19 +121,18 @@ class DataSummary: public Tool {
 	uint64_t orphantimestamp;         // Timestamp
 	std::string orphancause;          // Reason
 	int orphannumwaves;		  // Number of waveforms in orphan event
-	std::vector<unsigned long> orphanchankeys;	//Chankeys that had a waveform in the orphaned event
 	std::vector<int> orphanchankeys_int;	//Chankeys that had a waveform in the orphaned event
 	double orphanmintdiff;		  // Time difference to closest CTC timestamp	
-	std::vector<std::vector<int>> orphanchannels; 	//Electronics channels that were hit & orphaned
 	std::vector<int> orphanchannels_combined;	//Combined electronics channel
 	int orphantrigword;		// Trigword of orphaned CTC timestamp
 
 	// functions
 	int ScanForFiles(std::string inputdir, std::string filepattern, std::string filepattern_orphan);
+	int FindFiles(std::string inputdir, std::string filepattern, std::map<std::string,std::string>& files);
+	bool InRange(int run, int subrun, int part);
 	int ReadInFileList(std::string filelist_user);
-	bool LoadNextANNIEEventEntry();
-	bool LoadNextOrphanStoreEntry();
-	bool LoadNextFile();
+	void FillEvent(const datasummary::EventRecord& event);
+	void FillOrphan(const datasummary::OrphanRecord& orphan);
 	bool CreateOutputFile();
 	bool CreatePlots();
 	bool AddRatePlots(int nbins);
@@ -0,0 +1,415 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#include "FileSummary.h"
+
+#include "ANNIEconstants.h"
+#include "BoostStore.h"
+#include "TimeClass.h"
+#include "Waveform.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+	const char cache_magic[8] = {'D','S','U','M','M','R','Y','1'};
+
+	struct FileStamp {
+		int64_t size = -1;
+		int64_t mtime = -1;
+	};
+
+	FileStamp Stamp(const std::string& filename){
+		FileStamp stamp;
+		struct stat st;
+		if(!filename.empty() && stat(filename.c_str(),&st)==0){
+			stamp.size = st.st_size;
+			stamp.mtime = st.st_mtime;
+		}
+		return stamp;
+	}
+
+	// plain binary (de)serialisation of the summary fields
+	struct Writer {
+		std::ofstream& out;
+		template<typename T> void Put(const T& value){ out.write(reinterpret_cast<const char*>(&value),sizeof(T)); }
+		void Put(const std::string& value){
+			Put<uint64_t>(value.size());
+			out.write(value.data(),value.size());
+		}
+		void Put(const std::vector<int>& values){
+			Put<uint64_t>(values.size());
+			out.write(reinterpret_cast<const char*>(values.data()),values.size()*sizeof(int));
+		}
+	};
+
+	struct Reader {
+		std::ifstream& in;
+		template<typename T> bool Get(T& value){ return bool(in.read(reinterpret_cast<char*>(&value),sizeof(T))); }
+		bool Get(std::string& value){
+			uint64_t size;
+			if(!Get(size) || size>(1u<<20)) return false;
+			value.resize(size);
+			return size==0 || bool(in.read(&value[0],size));
+		}
+		bool Get(std::vector<int>& values){
+			uint64_t size;
+			if(!Get(size) || size>(1u<<24)) return false;
+			values.resize(size);
+			return size==0 || bool(in.read(reinterpret_cast<char*>(values.data()),size*sizeof(int)));
+		}
+	};
+
+	void CloseStore(BoostStore*& store){
+		if(store==nullptr) return;
+		store->Close();
+		store->Delete();
+		delete store;
+		store = nullptr;
+	}
+
+	void ReadEvents(BoostStore* ANNIEEvent, uint64_t entries, datasummary::FileSummary& summary){
+
+		// like the tree variables they end up in, keys missing from an entry keep
+		// the value of the previous entry
+		uint64_t PMTtimestamp = 0, LAPPDtimestamp = 0, CTCtimestamp = 0;
+		TimeClass mrd_timeclass;
+		uint32_t TriggerWord = 0;
+		std::map<std::string,int> MRDLoopbackTDC;
+		std::map<std::string,bool> datastreams;
+		int CTCWordExtended = 0;
+		std::map<unsigned long, std::vector<int>> raw_acqsize_map;
+		std::map<unsigned long, std::vector<Waveform<unsigned short>>> raw_waveform_map;
+
+		summary.events.reserve(entries);
+		for(uint64_t entry=0; entry<entries; ++entry){
+			if(!ANNIEEvent->GetEntry(entry)){
+				summary.warning = "could not read ANNIEEvent entry "+std::to_string(entry)+" of "+std::to_string(entries);
+				return;
+			}
+			ANNIEEvent->Get("EventTimeTank",PMTtimestamp);
+			ANNIEEvent->Get("EventTimeLAPPD",LAPPDtimestamp);
+			ANNIEEvent->Get("CTCTimestamp",CTCtimestamp);
+			ANNIEEvent->Get("EventTimeMRD",mrd_timeclass);
+			ANNIEEvent->Get("TriggerWord",TriggerWord);
+			ANNIEEvent->Get("MRDLoopbackTDC",MRDLoopbackTDC);
+			ANNIEEvent->Get("DataStreams",datastreams);
+			ANNIEEvent->Get("TriggerExtended",CTCWordExtended);
+
+			datasummary::EventRecord event;
+			event.ctc_timestamp = CTCtimestamp;
+			event.pmt_timestamp = PMTtimestamp;
+			event.mrd_timestamp = (uint64_t) mrd_timeclass.GetNs();
+			event.lappd_timestamp = LAPPDtimestamp;
+			event.trigger_word = TriggerWord;
+			event.beam_loopback_tdc = MRDLoopbackTDC.at("BeamLoopbackTDC");
+			event.cosmic_loopback_tdc = MRDLoopbackTDC.at("CosmicLoopbackTDC");
+			event.data_ctc = datastreams["CTC"];
+			event.data_tank = datastreams["Tank"];
+			event.data_mrd = datastreams["MRD"];
+			event.data_lappd = datastreams["LAPPD"];
+			event.trigger_extended = CTCWordExtended;
+
+			// the acquisition sizes the event builder stores are enough; the
+			// waveforms themselves are only unpacked for files without them
+			if(ANNIEEvent->Get("RawAcqSize",raw_acqsize_map)){
+				for(auto& temp_pair : raw_acqsize_map){
+					for(int acqsize : temp_pair.second){
+						event.window_sizes.push_back(2*acqsize);
+						event.window_chkeys.push_back(temp_pair.first);
+					}
+				}
+			} else if(ANNIEEvent->Get("RawADCData",raw_waveform_map)){
+				for(auto& temp_pair : raw_waveform_map){
+					for(auto& waveform : temp_pair.second){
+						event.window_sizes.push_back(2*waveform.GetSamples()->size());
+						event.window_chkeys.push_back(temp_pair.first);
+					}
+				}
+			} else if(summary.warning.empty()){
+				summary.warning = "no RawADCData or RawAcqSize in ANNIEEvent entry "+std::to_string(entry);
+			}
+			summary.events.push_back(std::move(event));
+		}
+	}
+
+	void ReadOrphans(BoostStore* OrphanStore, uint64_t entries, datasummary::FileSummary& summary){
+
+		std::string orphantype, orphancause;
+		uint64_t orphantimestamp = 0;
+		int orphantrigword = 0;
+		int orphannumwaves = 0;
+		std::vector<std::vector<int>> orphanchannels;
+		std::vector<unsigned long> orphanchankeys;
+		double orphanmintdiff = 0;
+
+		summary.orphans.reserve(entries);
+		for(uint64_t entry=0; entry<entries; ++entry){
+			if(!OrphanStore->GetEntry(entry)){
+				summary.warning = "could not read OrphanStore entry "+std::to_string(entry)+" of "+std::to_string(entries);
+				return;
+			}
+			OrphanStore->Get("EventType",orphantype);
+			OrphanStore->Get("Timestamp",orphantimestamp);
+			OrphanStore->Get("TriggerWord",orphantrigword);
+			OrphanStore->Get("Reason",orphancause);
+			OrphanStore->Get("NumWaves",orphannumwaves);
+			OrphanStore->Get("WaveformChannels",orphanchannels);
+			OrphanStore->Get("WaveformChankeys",orphanchankeys);
+			OrphanStore->Get("MinTDiff",orphanmintdiff);
+
+			datasummary::OrphanRecord orphan;
+			orphan.type = orphantype;
+			orphan.cause = orphancause;
+			orphan.timestamp = orphantimestamp;
+			orphan.trigger_word = orphantrigword;
+			orphan.num_waves = orphannumwaves;
+			orphan.min_tdiff = orphanmintdiff;
+			orphan.chankeys.assign(orphanchankeys.begin(),orphanchankeys.end());
+			for(const std::vector<int>& channel : orphanchannels){
+				orphan.channels.push_back(1000*channel.at(0)+10*channel.at(1)+channel.at(2));
+			}
+			summary.orphans.push_back(std::move(orphan));
+		}
+	}
+
+}
+
+bool datasummary::Summarise(const FileJob& job, FileSummary& summary){
+
+	summary.job = job;
+	BoostStore* ProcessedFileStore = nullptr;
+	BoostStore* ANNIEEvent = nullptr;
+	BoostStore* OrphanStore = nullptr;
+
+	try {
+		ANNIEEvent = new BoostStore(false,BOOST_STORE_MULTIEVENT_FORMAT);
+		OrphanStore = new BoostStore(false,BOOST_STORE_MULTIEVENT_FORMAT);
+		uint64_t entries = 0, orphans = 0;
+		if(job.orphan_filename.empty()){
+			ProcessedFileStore = new BoostStore(false,BOOST_STORE_BINARY_FORMAT);
+			if(!ProcessedFileStore->Initialise(job.filename)){
+				summary.error = "could not read "+job.filename;
+			} else {
+				ProcessedFileStore->Get("ANNIEEvent",*ANNIEEvent);
+				ANNIEEvent->Header->Get("TotalEntries",entries);
+				ProcessedFileStore->Get("OrphanStore",*OrphanStore);
+				OrphanStore->Header->Get("TotalEntries",orphans);
+			}
+		} else {
+			ANNIEEvent->Initialise(job.filename);
+			ANNIEEvent->Header->Get("TotalEntries",entries);
+			OrphanStore->Initialise(job.orphan_filename);
+			OrphanStore->Header->Get("TotalEntries",orphans);
+		}
+
+		// run constants, from the first entry
+		if(summary.error.empty() && !ANNIEEvent->GetEntry(0)){
+			summary.error = "could not get ANNIEEvent entry 0 from "+job.filename;
+		}
+		if(summary.error.empty()){
+			ANNIEEvent->Get("RunNumber",summary.run_number);
+			ANNIEEvent->Get("SubrunNumber",summary.subrun_number);
+			ANNIEEvent->Get("RunStartTime",summary.run_start_time);
+			ANNIEEvent->Get("RunType",summary.run_type);
+			ReadEvents(ANNIEEvent,entries,summary);
+			if(orphans==0 && summary.warning.empty()) summary.warning = "no orphans in OrphanStore";
+			ReadOrphans(OrphanStore,orphans,summary);
+		}
+	} catch(std::exception& e){
+		summary.error = std::string("reading ")+job.filename+" failed: "+e.what();
+	}
+
+	CloseStore(ProcessedFileStore);
+	CloseStore(ANNIEEvent);
+	CloseStore(OrphanStore);
+	if(!summary.error.empty()){
+		summary.events.clear();
+		summary.orphans.clear();
+	}
+	return summary.error.empty();
+}
+
+std::string datasummary::SummaryCache::CacheFile(const FileJob& job) const {
+	std::stringstream name;
+	name << std::hex << std::hash<std::string>()(job.filename+"\n"+job.orphan_filename);
+	return cachedir+"/"+name.str()+".dsum";
+}
+
+bool datasummary::SummaryCache::Load(const FileJob& job, FileSummary& summary) const {
+
+	std::ifstream in(CacheFile(job),std::ios::binary);
+	if(!in.is_open()) return false;
+	Reader r{in};
+
+	char magic[sizeof(cache_magic)];
+	if(!in.read(magic,sizeof(magic)) || memcmp(magic,cache_magic,sizeof(magic))!=0) return false;
+	// the same files, unchanged since the summary was made
+	std::string filename, orphan_filename;
+	if(!r.Get(filename) || !r.Get(orphan_filename)) return false;
+	if(filename!=job.filename || orphan_filename!=job.orphan_filename) return false;
+	for(const std::string& file : {job.filename,job.orphan_filename}){
+		FileStamp stamp = Stamp(file), cached;
+		if(!r.Get(cached.size) || !r.Get(cached.mtime)) return false;
+		if(cached.size!=stamp.size || cached.mtime!=stamp.mtime) return false;
+	}
+
+	FileSummary cached;
+	cached.job = job;
+	cached.from_cache = true;
+	uint64_t nevents, norphans;
+	if(!r.Get(cached.run_number) || !r.Get(cached.subrun_number) || !r.Get(cached.run_type)
+	   || !r.Get(cached.run_start_time) || !r.Get(cached.warning) || !r.Get(nevents)) return false;
+	if(nevents>(1u<<26)) return false;
+	cached.events.resize(nevents);
+	for(EventRecord& event : cached.events){
+		if(!r.Get(event.ctc_timestamp) || !r.Get(event.pmt_timestamp) || !r.Get(event.mrd_timestamp)
+		   || !r.Get(event.lappd_timestamp) || !r.Get(event.trigger_word) || !r.Get(event.beam_loopback_tdc)
+		   || !r.Get(event.cosmic_loopback_tdc) || !r.Get(event.data_ctc) || !r.Get(event.data_tank)
+		   || !r.Get(event.data_mrd) || !r.Get(event.data_lappd) || !r.Get(event.trigger_extended)
+		   || !r.Get(event.window_sizes) || !r.Get(event.window_chkeys)) return false;
+	}
+	if(!r.Get(norphans) || norphans>(1u<<26)) return false;
+	cached.orphans.resize(norphans);
+	for(OrphanRecord& orphan : cached.orphans){
+		if(!r.Get(orphan.type) || !r.Get(orphan.cause) || !r.Get(orphan.timestamp) || !r.Get(orphan.trigger_word)
+		   || !r.Get(orphan.num_waves) || !r.Get(orphan.chankeys) || !r.Get(orphan.channels)
+		   || !r.Get(orphan.min_tdiff)) return false;
+	}
+	summary = std::move(cached);
+	return true;
+}
+
+bool datasummary::SummaryCache::Save(const FileSummary& summary) const {
+
+	std::string cachefile = CacheFile(summary.job);
+	// write to a temporary and rename, so a reader never sees half a summary.
+	// The pid and a counter keep other jobs sharing the cache directory and the
+	// other workers of the pool out of this file.
+	static std::atomic<unsigned> tmpcount(0);
+	std::string tmpfile = cachefile+".tmp"+std::to_string(getpid())+"."+std::to_string(tmpcount++);
+	{
+		std::ofstream out(tmpfile,std::ios::binary|std::ios::trunc);
+		if(!out.is_open()) return false;
+		Writer w{out};
+		out.write(cache_magic,sizeof(cache_magic));
+		w.Put(summary.job.filename);
+		w.Put(summary.job.orphan_filename);
+		for(const std::string& file : {summary.job.filename,summary.job.orphan_filename}){
+			FileStamp stamp = Stamp(file);
+			w.Put(stamp.size);
+			w.Put(stamp.mtime);
+		}
+		w.Put(summary.run_number);
+		w.Put(summary.subrun_number);
+		w.Put(summary.run_type);
+		w.Put(summary.run_start_time);
+		w.Put(summary.warning);
+		w.Put<uint64_t>(summary.events.size());
+		for(const EventRecord& event : summary.events){
+			w.Put(event.ctc_timestamp);
+			w.Put(event.pmt_timestamp);
+			w.Put(event.mrd_timestamp);
+			w.Put(event.lappd_timestamp);
+			w.Put(event.trigger_word);
+			w.Put(event.beam_loopback_tdc);
+			w.Put(event.cosmic_loopback_tdc);
+			w.Put(event.data_ctc);
+			w.Put(event.data_tank);
+			w.Put(event.data_mrd);
+			w.Put(event.data_lappd);
+			w.Put(event.trigger_extended);
+			w.Put(event.window_sizes);
+			w.Put(event.window_chkeys);
+		}
+		w.Put<uint64_t>(summary.orphans.size());
+		for(const OrphanRecord& orphan : summary.orphans){
+			w.Put(orphan.type);
+			w.Put(orphan.cause);
+			w.Put(orphan.timestamp);
+			w.Put(orphan.trigger_word);
+			w.Put(orphan.num_waves);
+			w.Put(orphan.chankeys);
+			w.Put(orphan.channels);
+			w.Put(orphan.min_tdiff);
+		}
+		out.close();
+		if(!out){
+			std::remove(tmpfile.c_str());
+			return false;
+		}
+	}
+	if(rename(tmpfile.c_str(),cachefile.c_str())!=0){
+		std::remove(tmpfile.c_str());
+		return false;
+	}
+	return true;
+}
+
+void datasummary::SummaryPool::Start(const std::vector<FileJob>& jobs_in, int nthreads, size_t max_ahead_in, const std::string& cachedir){
+	Stop();
+	jobs = jobs_in;
+	results.clear();
+	results.resize(jobs.size());
+	cache.reset(new SummaryCache(cachedir));
+	max_ahead = (max_ahead_in>0) ? max_ahead_in : 1;
+	next_job = 0;
+	next_result = 0;
+	stopping = false;
+	if(nthreads<1) nthreads = 1;
+	for(int i=0; i<nthreads; ++i) threads.emplace_back(&SummaryPool::Work,this);
+}
+
+void datasummary::SummaryPool::Work(){
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true){
+		work_cv.wait(lock,[this]{
+			return stopping || next_job>=jobs.size() || next_job<next_result+max_ahead;
+		});
+		if(stopping || next_job>=jobs.size()) return;
+		size_t index = next_job++;
+		const FileJob& job = jobs[index];
+		lock.unlock();
+
+		std::unique_ptr<FileSummary> summary(new FileSummary);
+		if(!(cache->Enabled() && cache->Load(job,*summary))){
+			*summary = FileSummary();
+			if(Summarise(job,*summary) && cache->Enabled() && !cache->Save(*summary)){
+				if(summary->warning.empty()) summary->warning = "could not write its summary to the cache";
+			}
+		}
+
+		lock.lock();
+		results[index] = std::move(summary);
+		done_cv.notify_all();
+	}
+}
+
+bool datasummary::SummaryPool::Next(FileSummary& summary){
+	std::unique_lock<std::mutex> lock(mutex);
+	if(next_result>=jobs.size() || threads.empty()) return false;
+	done_cv.wait(lock,[this]{ return stopping || results[next_result]!=nullptr; });
+	if(results[next_result]==nullptr) return false;
+	summary = std::move(*results[next_result]);
+	results[next_result].reset();
+	++next_result;
+	work_cv.notify_all();
+	return true;
+}
+
+void datasummary::SummaryPool::Stop(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	work_cv.notify_all();
+	done_cv.notify_all();
+	for(std::thread& thread : threads) thread.join();
+	threads.clear();
+}
@@ -0,0 +1,130 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#ifndef FileSummary_H
+#define FileSummary_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Per-file summaries for the DataSummary tool: the few keys of each ANNIEEvent
+// and OrphanStore entry that the summary trees and plots are made from. Files
+// are summarised on a pool of worker threads, handed back in file order, and
+// optionally cached on disk keyed by path, size and modification time.
+namespace datasummary {
+
+	// what DataSummary reads from one ANNIEEvent entry
+	struct EventRecord {
+		uint64_t ctc_timestamp = 0;
+		uint64_t pmt_timestamp = 0;
+		uint64_t mrd_timestamp = 0;
+		uint64_t lappd_timestamp = 0;
+		uint32_t trigger_word = 0;
+		int beam_loopback_tdc = 0;
+		int cosmic_loopback_tdc = 0;
+		bool data_ctc = false;
+		bool data_tank = false;
+		bool data_mrd = false;
+		bool data_lappd = false;
+		int trigger_extended = 0;
+		std::vector<int> window_sizes;      // ns, of every ADC acquisition
+		std::vector<int> window_chkeys;
+	};
+
+	// what DataSummary reads from one OrphanStore entry
+	struct OrphanRecord {
+		std::string type;
+		std::string cause;
+		uint64_t timestamp = 0;
+		int trigger_word = 0;
+		int num_waves = 0;
+		std::vector<int> chankeys;
+		std::vector<int> channels;          // 1000*crate + 10*slot + channel
+		double min_tdiff = 0;
+	};
+
+	// one input file (and its orphan file, for separate stores)
+	struct FileJob {
+		std::string key;                    // RunSubrunPart, orders the files
+		std::string filename;
+		std::string orphan_filename;        // empty for combined stores
+		int run = -1;                       // from the filename, -1 if not known
+		int subrun = -1;
+		int part = -1;
+	};
+
+	struct FileSummary {
+		FileJob job;
+		uint32_t run_number = 0;
+		uint32_t subrun_number = 0;
+		int run_type = 0;
+		uint64_t run_start_time = 0;
+		std::vector<EventRecord> events;
+		std::vector<OrphanRecord> orphans;
+		bool from_cache = false;
+		std::string error;                  // the file could not be summarised
+		std::string warning;
+	};
+
+	// Reads the file(s) of job; false, with summary.error set, on failure
+	bool Summarise(const FileJob& job, FileSummary& summary);
+
+	// Summaries stored as <cachedir>/<hash of the path>.dsum
+	class SummaryCache {
+
+		public:
+
+		explicit SummaryCache(const std::string& cachedir_in) : cachedir(cachedir_in) {}
+		bool Enabled() const { return !cachedir.empty(); }
+		// true if there is a summary of job made from its current files
+		bool Load(const FileJob& job, FileSummary& summary) const;
+		bool Save(const FileSummary& summary) const;
+
+		private:
+
+		std::string CacheFile(const FileJob& job) const;
+		std::string cachedir;
+
+	};
+
+	// Summarises jobs on nthreads worker threads, at most max_ahead files
+	// ahead of the one last taken, and hands the summaries out in job order
+	class SummaryPool {
+
+		public:
+
+		SummaryPool() = default;
+		SummaryPool(const SummaryPool&) = delete;
+		SummaryPool& operator=(const SummaryPool&) = delete;
+		~SummaryPool(){ Stop(); }
+
+		void Start(const std::vector<FileJob>& jobs, int nthreads, size_t max_ahead, const std::string& cachedir);
+		// the next summary in job order, waiting for it if need be; false when all were taken
+		bool Next(FileSummary& summary);
+		void Stop();
+
+		private:
+
+		void Work();
+
+		std::vector<FileJob> jobs;
+		std::vector<std::unique_ptr<FileSummary>> results;
+		std::unique_ptr<SummaryCache> cache;
+		size_t max_ahead = 1;
+		size_t next_job = 0;                // next job to start
+		size_t next_result = 0;             // next summary to hand out
+		bool stopping = false;
+		std::mutex mutex;
+		std::condition_variable work_cv;
+		std::condition_variable done_cv;
+		std::vector<std::thread> threads;
+
+	};
+
+}
+
+#endif
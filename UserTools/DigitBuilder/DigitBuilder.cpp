@@ -1,4 +1,5 @@
 #include "DigitBuilder.h"
+#include "ToolRegistry.h"
 
 
 static DigitBuilder* fgDigitBuilder = 0;
@@ -11,6 +12,8 @@ DigitBuilder* DigitBuilder::Instance()
   return fgDigitBuilder;
 }
 
+REGISTER_TOOL(DigitBuilder);
+
 DigitBuilder::DigitBuilder():Tool(){}
 DigitBuilder::~DigitBuilder() {
 }
@@ -135,14 +138,25 @@ bool DigitBuilder::Execute(){
       return false;
     }
   } else {
-    auto get_clusters =  m_data->CStore.Get("ClusterMap",m_all_clusters);
-    if (!get_clusters){
-      Log("DigitBuilder Tool: ERROR retrieving clustered hits (ClusterMap) in Data mode!",v_error,verbosity);
-      return false;
-    }
-    auto get_clusters_chankey = m_data->CStore.Get("ClusterMapDetkey",m_all_clusters_detkey);
-    if (!get_clusters_chankey){
-      Log("DigitBuilder Tool: ERROR retrieving clustered chankeys (ClusterMapDetkey) in Data mode!",v_error,verbosity);
+    auto get_table = m_data->CStore.Get("ClusterTable",m_clusters);
+    if (!get_table || !m_clusters){
+      /// no cluster table from the ClusterFinder tool, read the cluster maps
+      std::map<double,std::vector<Hit>>* all_clusters=nullptr;
+      std::map<double,std::vector<unsigned long>>* all_clusters_detkey=nullptr;
+      auto get_clusters =  m_data->CStore.Get("ClusterMap",all_clusters);
+      if (!get_clusters){
+        Log("DigitBuilder Tool: ERROR retrieving clustered hits (ClusterMap) in Data mode!",v_error,verbosity);
+        return false;
+      }
+      auto get_clusters_chankey = m_data->CStore.Get("ClusterMapDetkey",all_clusters_detkey);
+      if (!get_clusters_chankey){
+        Log("DigitBuilder Tool: ERROR retrieving clustered chankeys (ClusterMapDetkey) in Data mode!",v_error,verbosity);
+        return false;
+      }
+      fClustersFromMaps.FromMaps(*all_clusters,*all_clusters_detkey);
+      m_clusters = &fClustersFromMaps;
+    } else if (m_clusters->IsMC()){
+      Log("DigitBuilder Tool: ERROR the cluster table holds MC hits in Data mode!",v_error,verbosity);
       return false;
     }
   }
@@ -394,50 +408,39 @@ bool DigitBuilder::BuildDataPMTRecoDigit(){
 	int digitType = -999;
 	Detector* det=nullptr;
 	Position  pos_sim, pos_reco;
-	/// m_all_clusters is a std::map<double,std::vector<Hit>>
+	/// m_clusters is the cluster table of the ClusterFinder tool, clusters are read by cluster ID
         
-	if (m_all_clusters && m_all_clusters_detkey){
-          int clustersize = m_all_clusters->size();
-          std::cout <<"Clustersize of m_all_clusters: "<<clustersize<<std::endl;
+	if (m_clusters){
+          int clustersize = m_clusters->NClusters();
+          std::cout <<"Clustersize of m_clusters: "<<clustersize<<std::endl;
           bool clusters_available = false;
           bool muon_available = false;
           if (clustersize != 0) clusters_available = true;
           if (clusters_available){
 	  //determine the main cluster (max charge and in [0 ... 2000ns] time window)
-	  double max_cluster = 0;
+	  //the cluster time is the mean hit time, the cluster charge the summed hit charge
+	  int max_cluster = -1;
           double max_charge = 0;
-          for(std::pair<double,std::vector<Hit>>&& apair : *m_all_clusters){
-            std::vector<Hit>&Hits = apair.second;
-            double time = 0;
-            int hits=0;
-            double charge = 0;
-            for (unsigned int i_hit = 0; i_hit < Hits.size(); i_hit++){
-              hits++;
-              time+=Hits.at(i_hit).GetTime();
-              charge+=Hits.at(i_hit).GetCharge();
-          }
-          if (hits>0) {
-            time/=hits;
-          }
-          if (time > 2000.) continue;	//not a beam muon if not in primary window
-	  if (charge > max_charge) {
-            muon_available = true;
-            max_charge = charge;
-            max_cluster = apair.first;
-          }
-	}
+          for (int cluster_id = 0; cluster_id < clustersize; cluster_id++){
+            if (m_clusters->NHits(cluster_id) == 0) continue;
+            if (m_clusters->Time(cluster_id) > 2000.) continue;	//not a beam muon if not in primary window
+	    if (m_clusters->Charge(cluster_id) > max_charge) {
+              muon_available = true;
+              max_charge = m_clusters->Charge(cluster_id);
+              max_cluster = cluster_id;
+            }
+	  }
 	if (muon_available){
-	  std::vector<Hit>& Hits = m_all_clusters->at(max_cluster);
-          std::vector<unsigned long> detkeys = m_all_clusters_detkey->at(max_cluster);
+	  const std::vector<Hit>& Hits = m_clusters->Hits();
           int hits_pmt = 0;
 
           std::map<unsigned long,std::vector<double>> hitTimes;
           std::map<unsigned long,std::vector<double>> hitCharges;
 
-	  Log("DigitBuilder Tool: Num PMT Clustered Digits = "+to_string(Hits.size()),v_message, verbosity);
-	  for (unsigned int i_hit = 0; i_hit < Hits.size(); i_hit++){
-	    Hit ahit = Hits.at(i_hit);
-            unsigned long chankey = detkeys.at(i_hit);
+	  Log("DigitBuilder Tool: Num PMT Clustered Digits = "+to_string(m_clusters->NHits(max_cluster)),v_message, verbosity);
+	  for (uint32_t i_hit = m_clusters->HitBegin(max_cluster); i_hit < m_clusters->HitEnd(max_cluster); i_hit++){
+	    const Hit& ahit = Hits.at(i_hit);
+            unsigned long chankey = m_clusters->HitDetkey(i_hit);
 	    
 
 	    if (hitTimes.find(chankey)!=hitTimes.end()){
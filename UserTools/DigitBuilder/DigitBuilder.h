@@ -16,6 +16,7 @@
 #include "TTree.h"
 #include "ANNIEGeometry.h"
 #include "Detector.h"
+#include "ClusterTable.h"
 
 class DigitBuilder: public Tool {
 
@@ -106,8 +107,8 @@ class DigitBuilder: public Tool {
   std::map<unsigned long,std::vector<MCHit>>* fMCPMTHits=nullptr;             ///< PMT hits
   std::map<unsigned long,std::vector<MCLAPPDHit>>* fMCLAPPDHits=nullptr;   ///< LAPPD hits
   std::map<unsigned long,std::vector<MCHit>>* fTDCData=nullptr;            ///< MRD & veto hits
-  std::map<double,std::vector<Hit>>* m_all_clusters=nullptr;            ///< Clusters, from ClusterFinder tool
-  std::map<double,std::vector<unsigned long>>* m_all_clusters_detkey=nullptr;         ///< Chankeys corresponding to clusters, from ClusterFinder tool
+  ClusterTable* m_clusters=nullptr;            ///< Clusters and their chankeys, from ClusterFinder tool
+  ClusterTable fClustersFromMaps;              ///< Clusters read from the cluster maps, if there is no cluster table
 
   std::map<unsigned long, double> pmt_gains;
 
@@ -1,4 +1,5 @@
 #include "DigitBuilderDoE.h"
+#include "ToolRegistry.h"
 
 using namespace ROOT::Math;
 
@@ -12,6 +13,8 @@ DigitBuilderDoE* DigitBuilderDoE::Instance()
   return fgDigitBuilderDoE;
 }
 
+REGISTER_TOOL(DigitBuilderDoE);
+
 DigitBuilderDoE::DigitBuilderDoE():Tool(){}
 DigitBuilderDoE::~DigitBuilderDoE() {
 }
@@ -1,4 +1,7 @@
 #include "DigitBuilderROOT.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(DigitBuilderROOT);
 
 DigitBuilderROOT::DigitBuilderROOT():Tool(){}
 
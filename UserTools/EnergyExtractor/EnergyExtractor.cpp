@@ -1,4 +1,7 @@
 #include "EnergyExtractor.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(EnergyExtractor);
 
 EnergyExtractor::EnergyExtractor():Tool(){}
 
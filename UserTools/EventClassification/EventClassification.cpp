@@ -1,4 +1,7 @@
 #include "EventClassification.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(EventClassification);
 
 EventClassification::EventClassification():Tool(){}
 
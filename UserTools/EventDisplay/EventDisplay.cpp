@@ -1,4 +1,7 @@
 #include "EventDisplay.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(EventDisplay);
 
 EventDisplay::EventDisplay():Tool(){}
 
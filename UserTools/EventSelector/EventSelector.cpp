@@ -1,4 +1,7 @@
 #include "EventSelector.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(EventSelector);
 
 EventSelector::EventSelector():Tool(){}
 
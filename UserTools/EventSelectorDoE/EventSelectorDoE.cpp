@@ -1,4 +1,7 @@
 #include "EventSelectorDoE.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(EventSelectorDoE);
 
 EventSelectorDoE::EventSelectorDoE():Tool(){}
 
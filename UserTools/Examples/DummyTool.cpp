@@ -1,4 +1,7 @@
 #include "DummyTool.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(DummyTool);
 
 DummyTool::DummyTool():Tool(){}
 
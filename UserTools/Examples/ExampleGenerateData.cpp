@@ -1,4 +1,7 @@
 #include "ExampleGenerateData.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ExampleGenerateData);
 
 ExampleGenerateData::ExampleGenerateData():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "ExampleLoadRoot.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ExampleLoadRoot);
 
 ExampleLoadRoot::ExampleLoadRoot():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "ExampleOverTool.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ExampleOverTool);
 
 ExampleOverTool::ExampleOverTool():Tool(){}
 
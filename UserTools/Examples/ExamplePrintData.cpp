@@ -1,4 +1,7 @@
 #include "ExamplePrintData.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ExamplePrintData);
 
 ExamplePrintData::ExamplePrintData():Tool(){}
 
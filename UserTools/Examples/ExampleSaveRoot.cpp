@@ -1,4 +1,7 @@
 #include "ExampleSaveRoot.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ExampleSaveRoot);
 
 ExampleSaveRoot::ExampleSaveRoot():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "ExampleSaveStore.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ExampleSaveStore);
 
 ExampleSaveStore::ExampleSaveStore():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "ExampleloadStore.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ExampleloadStore);
 
 ExampleloadStore::ExampleloadStore():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "FMVEfficiency.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(FMVEfficiency);
 
 FMVEfficiency::FMVEfficiency():Tool(){}
 
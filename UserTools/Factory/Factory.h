@@ -4,10 +4,13 @@
 #include <string>
 #include "Tool.h"
 #include "Unity.h"
+#include "ToolRegistry.h"
 
 /**
  * Global Factory function for creating Tools.
+ * Looks the tool up in the ToolRegistry, loading plugin libraries if it is not built in.
  @param tool Name of the Tool class to create.
+ @return the new Tool, or 0 if no tool of that name is registered.
 */
 
 Tool* Factory(std::string tool);
@@ -0,0 +1,86 @@
+#include "ToolRegistry.h"
+
+#include <algorithm>
+#include <iostream>
+#include <dirent.h>
+#include <dlfcn.h>
+
+ToolRegistry& ToolRegistry::Instance(){
+  static ToolRegistry registry;
+  return registry;
+}
+
+bool ToolRegistry::Register(const std::string& name, ToolMaker maker){
+  if(makers.count(name)){
+    std::cerr<<"ToolRegistry: a tool named "<<name<<" is already registered, ignoring the new one"<<std::endl;
+    return false;
+  }
+  makers.emplace(name,maker);
+  return true;
+}
+
+bool ToolRegistry::Has(const std::string& name) const {
+  return makers.count(name)!=0;
+}
+
+std::vector<std::string> ToolRegistry::Names() const {
+  std::vector<std::string> names;
+  names.reserve(makers.size());
+  for(auto&& amaker : makers) names.push_back(amaker.first);
+  return names;
+}
+
+void ToolRegistry::SetPluginDirectory(const std::string& dir){
+  if(dir!=plugin_dir) plugins_loaded=false;
+  plugin_dir=dir;
+}
+
+int ToolRegistry::LoadPlugins(){
+  if(plugins_loaded || plugin_dir=="") return 0;
+  plugins_loaded=true;
+
+  DIR* dir = opendir(plugin_dir.c_str());
+  if(dir==nullptr){
+    std::cerr<<"ToolRegistry: could not open plugin directory "<<plugin_dir<<std::endl;
+    return 0;
+  }
+  // load in a fixed order so that duplicate names always resolve the same way
+  std::vector<std::string> libraries;
+  while(dirent* entry = readdir(dir)){
+    std::string filename = entry->d_name;
+    if(filename.size()>6 && filename.compare(0,3,"lib")==0 &&
+       filename.compare(filename.size()-3,3,".so")==0) libraries.push_back(filename);
+  }
+  closedir(dir);
+  std::sort(libraries.begin(),libraries.end());
+
+  int nloaded=0;
+  for(const std::string& library : libraries){
+    std::string path = plugin_dir+"/"+library;
+    // the tools in the library register themselves from their static initialisers.
+    // the handles are never closed, as the tools are used until the program exits
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if(handle==nullptr){
+      std::cerr<<"ToolRegistry: failed to load plugin "<<path<<": "<<dlerror()<<std::endl;
+      continue;
+    }
+    plugin_handles.push_back(handle);
+    ++nloaded;
+  }
+  return nloaded;
+}
+
+Tool* ToolRegistry::Create(const std::string& name){
+  auto it = makers.find(name);
+  if(it==makers.end() && !plugins_loaded && plugin_dir!=""){
+    LoadPlugins();
+    it = makers.find(name);
+  }
+  if(it!=makers.end()) return it->second();
+
+  std::cerr<<"ToolRegistry: unknown tool "<<name;
+  if(plugin_dir!="") std::cerr<<" (also searched plugin directory "<<plugin_dir<<")";
+  std::cerr<<". Available tools are:"<<std::endl;
+  for(auto&& amaker : makers) std::cerr<<"  "<<amaker.first<<std::endl;
+  return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef TOOLREGISTRY_H
+#define TOOLREGISTRY_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Tool.h"
+
+/**
+ * Registry of the Tools that can be created by name.
+ *
+ * Every Tool registers a function that creates it, under its class name, with
+ * REGISTER_TOOL in its own source file, so the tools in a library register
+ * themselves when the library is loaded. Groups of tools can be left out of
+ * libMyTools and built as separate shared libraries in a plugin directory
+ * instead: these are only loaded the first time a tool that is not built in
+ * is asked for.
+ */
+class ToolRegistry {
+
+ public:
+
+  typedef Tool* (*ToolMaker)();
+
+  static ToolRegistry& Instance();
+
+  /// Register a Tool; returns false (and keeps the first) if the name is taken
+  bool Register(const std::string& name, ToolMaker maker);
+
+  /// Create a Tool by name; returns 0 and prints the known names if there is none
+  Tool* Create(const std::string& name);
+
+  bool Has(const std::string& name) const;
+  std::vector<std::string> Names() const;
+
+  /// Directory to search for plugin libraries (lib*.so) for unknown tools
+  void SetPluginDirectory(const std::string& dir);
+
+  /// dlopen every lib*.so in the plugin directory now; returns the number loaded
+  int LoadPlugins();
+
+ private:
+
+  ToolRegistry(){}
+  ToolRegistry(const ToolRegistry&);
+  ToolRegistry& operator=(const ToolRegistry&);
+
+  std::map<std::string,ToolMaker> makers;
+  std::string plugin_dir;
+  bool plugins_loaded=false;
+  std::vector<void*> plugin_handles;
+
+};
+
+/**
+ * Register Tool class Type under its own name. Use once, at namespace scope,
+ * in a source file of the library the tool is built into:
+ *   REGISTER_TOOL(MyTool);
+ */
+#define REGISTER_TOOL(Type) \
+  static const bool toolregistry_##Type = \
+    ToolRegistry::Instance().Register(#Type, []() -> Tool* { return new Type; })
+
+#endif
@@ -1,4 +1,8 @@
 #include "FilterEvents.h"
+#include "ToolRegistry.h"
+#include "ANNIEEventKeys.h"
+
+REGISTER_TOOL(FilterEvents);
 
 FilterEvents::FilterEvents():Tool(){}
 
@@ -15,6 +19,21 @@ bool FilterEvents::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("verbosity",verbosity);
   m_variables.Get("FilteredFilesBasename",FilteredFilesBasename);
   m_variables.Get("SavePath",SavePath);
+  m_variables.Get("SkimMode",SkimMode);
+  int UseEventCutStatus = 1;
+  m_variables.Get("UseEventCutStatus",UseEventCutStatus);
+  use_cuts = (UseEventCutStatus != 0);
+  std::string selection_filename;
+  if (m_variables.Get("SelectedEventsFile",selection_filename)){
+    if (!this->ReadEventSelection(selection_filename)) return false;
+  }
+
+  if (SkimMode == "All") skim_keys = annieeventkeys::KnownKeys();
+  else {
+    if (SkimMode != "Standard") Log("FilterEvents: SkimMode "+SkimMode+" not known, using Standard",v_warning,verbosity);
+    SkimMode = "Standard";
+    skim_keys = {"AuxHits","BeamStatus","CTCTimestamp","DataStreams","EventNumber","EventTimeLAPPD","EventTimeMRD","EventTimeTank","Hits","LocalEventNumber","MRDLoopbackTDC","MRDTriggerType","PartNumber","RawAcqSize","RecoADCData","RecoAuxADCData","RunNumber","RunStartTime","RunType","SubrunNumber","TDCData","TriggerData","TriggerExtended","TriggerWord"};
+  }
 
   matched = 0;
     
@@ -23,9 +42,11 @@ bool FilterEvents::Initialise(std::string configfile, DataModel &data){
   std::string EventSelectorCutConfiguration;
   m_data->CStore.Get("CutConfiguration",EventSelectorCutConfiguration);
   FilterName = EventSelectorCutConfiguration;
+  if (FilterName.empty() && use_selection) FilterName = "SelectedEvents";
 
   FilteredEvents->Header->Set("FilteredEvent",true);
   FilteredEvents->Header->Set("FilterName",FilterName);
+  if (use_selection) FilteredEvents->Header->Set("SelectedEventsFile",selection_filename);
 
   return true;
 }
@@ -33,17 +54,21 @@ bool FilterEvents::Initialise(std::string configfile, DataModel &data){
 
 bool FilterEvents::Execute(){
 
-  std::map<std::string,bool> dataStreams;
-  int runNumber, eventNumber, localEventNumber, partNumber;
-  m_data->Stores["ANNIEEvent"]->Get("DataStreams",dataStreams);
-  m_data->Stores["ANNIEEvent"]->Get("RunNumber",runNumber);
-  m_data->Stores["ANNIEEvent"]->Get("EventNumber",eventNumber);
-  m_data->Stores["ANNIEEvent"]->Get("LocalEventNumber",localEventNumber);
-  m_data->Stores["ANNIEEvent"]->Get("PartNumber",partNumber);
-
+  bool pass_filter = true;
+  if (use_cuts){
+    pass_filter = false;
+    m_data->Stores.at("RecoEvent")->Get("EventCutStatus", pass_filter); 
+  }
 
-  bool pass_filter = false;
-  m_data->Stores.at("RecoEvent")->Get("EventCutStatus", pass_filter); 
+  if (pass_filter && use_selection){
+    int runNumber = -1, subrunNumber = -1, partNumber = -1;
+    uint32_t eventNumber = 0;
+    m_data->Stores["ANNIEEvent"]->Get("RunNumber",runNumber);
+    m_data->Stores["ANNIEEvent"]->Get("SubrunNumber",subrunNumber);
+    m_data->Stores["ANNIEEvent"]->Get("PartNumber",partNumber);
+    m_data->Stores["ANNIEEvent"]->Get("EventNumber",eventNumber);
+    pass_filter = selected_events.count(ANNIEEventKey(runNumber,subrunNumber,partNumber,eventNumber)) > 0;
+  }
 
   if (pass_filter){
     this->SetAndSaveEvent();
@@ -66,75 +91,34 @@ bool FilterEvents::Finalise(){
 
 void FilterEvents::SetAndSaveEvent(){
 
-  uint32_t RunNumber, SubrunNumber, EventNumber, TriggerWord;
-  size_t LocalEventNumber;
-  uint64_t RunStartTime, EventTimeTank, EventTimeLAPPD, CTCTimestamp, LAPPDOffset;
-  TimeClass EventTimeMRD;
-  int PartNumber, RunType, TriggerExtended;
-  std::map<std::string, bool> DataStreams;
-  std::string MRDTriggerType;
-  std::map<std::string, int> MRDLoopbackTDC;
-  TriggerClass TriggerData;
-  BeamStatus BeamStatus;
-  std::map<unsigned long, std::vector<Hit>>* TDCData;
-  std::map<unsigned long, std::vector<Hit>> *Hits, *AuxHits;
-  std::map<unsigned long, std::vector<int>> RawAcqSize;
-  std::map<unsigned long, std::vector<std::vector<ADCPulse>>> RecoADCData, RecoAuxADCData;
-  PsecData LAPPDData;
-
-  std::map<unsigned long, std::vector<Hit>> *NewTDCData = new std::map<unsigned long, std::vector<Hit>>;
-  std::map<unsigned long, std::vector<Hit>> *NewHits = new  std::map<unsigned long, std::vector<Hit>>;
-  std::map<unsigned long, std::vector<Hit>> *NewAuxHits = new std::map<unsigned long, std::vector<Hit>>;
-
-  // Get and Set all variables in the event to the new booststore
-  m_data->Stores["ANNIEEvent"]->Get("AuxHits",AuxHits);
-    for (auto&& entry : (*AuxHits)){
-        NewAuxHits->emplace(entry.first,entry.second);
-        }
-    FilteredEvents->Set("AuxHits",NewAuxHits,true);
-
-    m_data->Stores["ANNIEEvent"]->Get("BeamStatus",BeamStatus);  FilteredEvents->Set("BeamStatus",BeamStatus);
-    m_data->Stores["ANNIEEvent"]->Get("CTCTimestamp",CTCTimestamp);  FilteredEvents->Set("CTCTimestamp",CTCTimestamp);
-    m_data->Stores["ANNIEEvent"]->Get("DataStreams",DataStreams);  FilteredEvents->Set("DataStreams",DataStreams);
-    m_data->Stores["ANNIEEvent"]->Get("EventNumber",EventNumber);  FilteredEvents->Set("EventNumber",EventNumber);
-    m_data->Stores["ANNIEEvent"]->Get("EventTimeLAPPD",EventTimeLAPPD);  FilteredEvents->Set("EventTimeLAPPD",EventTimeLAPPD);
-    m_data->Stores["ANNIEEvent"]->Get("EventTimeMRD",EventTimeMRD);  FilteredEvents->Set("EventTimeMRD",EventTimeMRD);
-    m_data->Stores["ANNIEEvent"]->Get("EventTimeTank",EventTimeTank);  FilteredEvents->Set("EventTimeTank",EventTimeTank);
-    m_data->Stores["ANNIEEvent"]->Get("Hits",Hits);
-    for (auto&& entry : (*Hits)){
-        NewHits->emplace(entry.first,entry.second);
-        }
-    FilteredEvents->Set("Hits",NewHits,true);
- 
-/*   
-    m_data->Stores["ANNIEEvent"]->Get("LAPPDData",LAPPDData);  FilteredEvents->Set("LAPPDData",LAPPDData);
-    m_data->Stores["ANNIEEvent"]->Get("LAPPDOffset",LAPPDOffset);  FilteredEvents->Set("LAPPDOffset",LAPPDOffset);
-*/
-    m_data->Stores["ANNIEEvent"]->Get("LocalEventNumber",LocalEventNumber);  FilteredEvents->Set("LocalEventNumber",LocalEventNumber);
-    m_data->Stores["ANNIEEvent"]->Get("MRDLoopbackTDC",MRDLoopbackTDC);  FilteredEvents->Set("MRDLoopbackTDC",MRDLoopbackTDC);
-    m_data->Stores["ANNIEEvent"]->Get("MRDTriggerType",MRDTriggerType);  FilteredEvents->Set("MRDTriggerType",MRDTriggerType);
-    m_data->Stores["ANNIEEvent"]->Get("PartNumber",PartNumber);  FilteredEvents->Set("PartNumber",PartNumber);
-    m_data->Stores["ANNIEEvent"]->Get("RawAcqSize",RawAcqSize);  FilteredEvents->Set("RawAcqSize",RawAcqSize);
-    m_data->Stores["ANNIEEvent"]->Get("RecoADCData",RecoADCData);  FilteredEvents->Set("RecoADCData",RecoADCData);
-    m_data->Stores["ANNIEEvent"]->Get("RecoAuxADCData",RecoAuxADCData);  FilteredEvents->Set("RecoAuxADCData",RecoAuxADCData);
-    m_data->Stores["ANNIEEvent"]->Get("RunNumber",RunNumber);  FilteredEvents->Set("RunNumber",RunNumber);
-    m_data->Stores["ANNIEEvent"]->Get("RunStartTime",RunStartTime);  FilteredEvents->Set("RunStartTime",RunStartTime);
-    m_data->Stores["ANNIEEvent"]->Get("RunType",RunType);    FilteredEvents->Set("RunType",RunType);
-    m_data->Stores["ANNIEEvent"]->Get("SubrunNumber",SubrunNumber);  FilteredEvents->Set("SubrunNumber",SubrunNumber);
-    m_data->Stores["ANNIEEvent"]->Get("TDCData",TDCData);
-    for (auto&& entry : (*TDCData)){
-        NewTDCData->emplace(entry.first,entry.second);
-        }
-    
-    FilteredEvents->Set("TDCData",NewTDCData,true);
-    m_data->Stores["ANNIEEvent"]->Get("TriggerData",TriggerData);  FilteredEvents->Set("TriggerData",TriggerData);
-    m_data->Stores["ANNIEEvent"]->Get("TriggerExtended",TriggerExtended);  FilteredEvents->Set("TriggerExtended",TriggerExtended);
-    m_data->Stores["ANNIEEvent"]->Get("TriggerWord",TriggerWord);  FilteredEvents->Set("TriggerWord",TriggerWord);
+  // Copy the event keys as they are to the new booststore. CopyKey copies each
+  // stored object once rather than serializing it for a Get and a Set by value
+  BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+  bool mc_flag = annieeventkeys::IsMC(annie_event);
+  for (const std::string& key : skim_keys){
+    if (!annie_event->Has(key)) continue;
+    if (!annieeventkeys::CopyKey(annie_event,FilteredEvents,key,mc_flag) && failed_keys.insert(key).second){
+      Log("FilterEvents: Could not copy key "+key+" to the filtered events",v_warning,verbosity);
+    }
+  }
+
+  std::string Filename = SavePath + "/" + FilteredFilesBasename + "_" + FilterName;
+
+  if (verbosity>0) std::cout<<"Filename is "<<Filename<<std::endl;
+  FilteredEvents->Save(Filename);
+  FilteredEvents->Delete();
 
-    std::string Filename = SavePath + "/" + FilteredFilesBasename + "_" + FilterName;
+}
+
+bool FilterEvents::ReadEventSelection(std::string selection_filename){
 
-    if (verbosity>0) std::cout<<"Filename is "<<Filename<<std::endl;
-    FilteredEvents->Save(Filename);
-    FilteredEvents->Delete();
+  // the format LoadANNIEEvent reads
+  if (!ANNIEEventIndex::ReadEventSelection(selection_filename,selected_events)){
+    Log("FilterEvents: Could not open the SelectedEventsFile "+selection_filename,v_error,verbosity);
+    return false;
+  }
+  Log("FilterEvents: Selected "+std::to_string(selected_events.size())+" events from "+selection_filename,v_message,verbosity);
 
+  use_selection = true;
+  return true;
 }
@@ -3,12 +3,15 @@
 
 #include <string>
 #include <iostream>
+#include <set>
+#include <vector>
 
 #include "Tool.h"
 
 #include "ADCPulse.h"
 #include "PsecData.h"
 #include "Hit.h"
+#include "ANNIEEventIndex.h"
 
 /**
  * \class FilterEvents
@@ -30,6 +33,7 @@ class FilterEvents: public Tool {
   bool Finalise(); ///< Finalise function used to clean up resources.
 
   void SetAndSaveEvent();
+  bool ReadEventSelection(std::string selection_filename); ///< Reads the "run subrun part event" list of SelectedEventsFile
 
  private:
 
@@ -40,6 +44,13 @@ class FilterEvents: public Tool {
   BoostStore* FilteredEvents = nullptr;
   int matched;
 
+  std::string SkimMode = "Standard";      // Standard: the usual ANNIEEvent keys, All: every key known to annieeventkeys
+  std::vector<std::string> skim_keys;     // keys copied to the filtered store
+  std::set<std::string> failed_keys;      // keys that could not be copied, warned about once
+  bool use_cuts = true;                   // require EventCutStatus from the EventSelector
+  bool use_selection = false;             // require the event to be listed in SelectedEventsFile
+  std::set<ANNIEEventKey> selected_events;
+
   int v_error = 0;
   int v_warning = 1;
   int v_message = 2;
@@ -1,4 +1,7 @@
 #include "FilterLAPPDEvents.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(FilterLAPPDEvents);
 
 FilterLAPPDEvents::FilterLAPPDEvents():Tool(){}
 
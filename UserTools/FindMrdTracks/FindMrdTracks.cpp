@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "FindMrdTracks.h"
+#include "ToolRegistry.h"
 #include <numeric>      // std::iota
 // for drawing
 #include "TROOT.h"
@@ -11,6 +12,8 @@
 #include <thread>          // std::this_thread::sleep_for
 #include <chrono>          // std::chrono::seconds
 
+REGISTER_TOOL(FindMrdTracks);
+
 FindMrdTracks::FindMrdTracks():Tool(){}
 
 bool FindMrdTracks::Initialise(std::string configfile, DataModel &data){
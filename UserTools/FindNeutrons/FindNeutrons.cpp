@@ -1,4 +1,7 @@
 #include "FindNeutrons.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(FindNeutrons);
 
 FindNeutrons::FindNeutrons():Tool(){}
 
@@ -126,65 +129,90 @@ bool FindNeutrons::FindNeutronCandidates(std::string method){
 
 }
   
-bool FindNeutrons::FindNeutronsByCB(bool strict){
-
-  bool return_val=false;
+bool FindNeutrons::GetClusterFeatures(){
+
+  //Fill the general cluster information into vectors, indexed by cluster ID
+  //Take it from the cluster table if ClusterClassifiers ran in this toolchain
+  ClusterTable* clusters = nullptr;
+  bool get_ok = m_data->CStore.Get("ClusterTable",clusters);
+  if (get_ok && clusters && clusters->HasFeatures()){
+    for (int cluster_id = 0; cluster_id < clusters->NClusters(); cluster_id++){
+      cluster_times.push_back(clusters->Time(cluster_id));
+      cluster_charges.push_back(clusters->TotalPE(cluster_id));
+      cluster_cb.push_back(clusters->ChargeBalance(cluster_id));
+      cluster_nhits.push_back(clusters->NHits(cluster_id));
+    }
+    return true;
+  }
 
-  //Get cluster objects (filled in ClusterClassifiers tool)
+  //Otherwise use the cluster objects stored in the ANNIEEvent (filled in ClusterClassifiers tool)
   std::map<double,double> ClusterChargeBalances;
   std::map<double,double> ClusterTotalPEs;
   std::map<double,int> ClusterNHits;
-  bool get_ok;
+
+  bool return_val = true;
   get_ok = m_data->Stores.at("ANNIEEvent")->Get("ClusterChargeBalances", ClusterChargeBalances);
   if (!get_ok){
     Log("FindNeutrons tool: Did not find ClusterChargeBalances object! Please add ClusterClassifiers tool to your toolchain!",v_error,verbosity);
     m_variables.Set("StopLoop",1);
+    return_val = false;
   }
   get_ok = m_data->Stores.at("ANNIEEvent")->Get("ClusterTotalPEs", ClusterTotalPEs);
   if (!get_ok){
     Log("FindNeutrons tool: Did not find ClusterTotalPEs object! Please add ClusterClassifiers tool to your toolchain!",v_error,verbosity);
     m_variables.Set("StopLoop",1);
+    return_val = false;
   }
   get_ok = m_data->Stores.at("ANNIEEvent")->Get("ClusterNHits", ClusterNHits);
   if (!get_ok){
     Log("FindNeutrons tool: Did not find ClusterNHits object! Please add ClusterClassifiers tool to your toolchain!",v_error,verbosity);
     m_variables.Set("StopLoop",1);
+    return_val = false;
   }
+  if (!return_val) return false;
 
-  //Loop through clusters and find neutrons
-  int tmp_cluster_id = 0;
-  
   for (std::map<double,double>::iterator it = ClusterTotalPEs.begin(); it!= ClusterTotalPEs.end(); it++){
-    //First fill general cluster information into vectors
     cluster_times.push_back(it->first);
-    cluster_charges.push_back(ClusterTotalPEs.at(it->first));
+    cluster_charges.push_back(it->second);
     cluster_cb.push_back(ClusterChargeBalances.at(it->first));
     cluster_nhits.push_back(ClusterNHits.at(it->first));
+  }
+
+  return true;
+}
+
+bool FindNeutrons::FindNeutronsByCB(bool strict){
+
+  bool return_val=false;
+
+  if (!this->GetClusterFeatures()) return false;
+
+  //Loop through clusters and find neutrons
+  for (int cluster_id = 0; cluster_id < (int) cluster_times.size(); cluster_id++){
 
     //Check if the cluster is in the delayed window and has a time > 10 us (exclude afterpulses)
     //The window should should be extended in the future after relevant exlusion cuts for afterpulsing have been implemented
     //check if the charge balance cut for neutrons is passed -> consider a neutron candidate
     //Improve the neutron selection cuts in the future, probably cutting more signal than necessary at the moment
-    if (it->first > 10000){
-      double current_cb = ClusterChargeBalances.at(it->first);
-      double current_q = ClusterTotalPEs.at(it->first);
-      int current_nhits = ClusterNHits.at(it->first);
+    if (cluster_times[cluster_id] > 10000){
+      double current_cb = cluster_cb[cluster_id];
+      double current_q = cluster_charges[cluster_id];
+      int current_nhits = cluster_nhits[cluster_id];
       bool pass_cut = false;
       if (current_cb < 0.4 && current_q < 150){
         if (!strict) pass_cut = true;
         else if (current_cb <= (1. - current_q/150.)*0.5) pass_cut = true;
       }
       if (pass_cut){
-        Log("FindNeutrons tool: Found neutron candidate at cluster # "+std::to_string(tmp_cluster_id)+", time: "+std::to_string(it->first)+" ns!!!",v_message,verbosity);
-        cluster_neutron.push_back(tmp_cluster_id);
-        cluster_times_neutron.push_back(it->first);
+        Log("FindNeutrons tool: Found neutron candidate at cluster # "+std::to_string(cluster_id)+", time: "+std::to_string(cluster_times[cluster_id])+" ns!!!",v_message,verbosity);
+        cluster_neutron.push_back(cluster_id);
+        cluster_times_neutron.push_back(cluster_times[cluster_id]);
         cluster_charges_neutron.push_back(current_q);
         cluster_cb_neutron.push_back(current_cb);
         cluster_nhits_neutron.push_back(current_nhits);
         return_val = true;
       }
     }
-    tmp_cluster_id ++;
   }
 
   return return_val;
@@ -195,60 +223,31 @@ bool FindNeutrons::FindNeutronsByNHits(int nhits_thr){
 
   bool return_val=false;
 
-  //Get cluster objects (filled in ClusterClassifiers tool)
-  std::map<double,double> ClusterTotalPEs;
-  std::map<double,int> ClusterNHits;
-  std::map<double,double> ClusterChargeBalances;
-
-  bool get_ok;
-  get_ok = m_data->Stores.at("ANNIEEvent")->Get("ClusterTotalPEs", ClusterTotalPEs);
-  if (!get_ok){
-    Log("FindNeutrons tool: Did not find ClusterTotalPEs object! Please add ClusterClassifiers tool to your toolchain!",v_error,verbosity);
-    m_variables.Set("StopLoop",1);
-  }
-  get_ok = m_data->Stores.at("ANNIEEvent")->Get("ClusterChargeBalances", ClusterChargeBalances);
-  if (!get_ok){
-    Log("FindNeutrons tool: Did not find ClusterChargeBalances object! Please add ClusterClassifiers tool to your toolchain!",v_error,verbosity);
-    m_variables.Set("StopLoop",1);
-  }
-  get_ok = m_data->Stores.at("ANNIEEvent")->Get("ClusterNHits", ClusterNHits);
-  if (!get_ok){
-    Log("FindNeutrons tool: Did not find ClusterNHits object! Please add ClusterClassifiers tool to your toolchain!",v_error,verbosity);
-    m_variables.Set("StopLoop",1);
-  }
+  if (!this->GetClusterFeatures()) return false;
 
   //Loop through clusters and find neutrons
-  int tmp_cluster_id = 0;
-  
-  for (std::map<double,double>::iterator it = ClusterTotalPEs.begin(); it!= ClusterTotalPEs.end(); it++){
-    //First fill general cluster information into vectors
-    cluster_times.push_back(it->first);
-    cluster_charges.push_back(ClusterTotalPEs.at(it->first));
-    cluster_cb.push_back(ClusterChargeBalances.at(it->first));
-    cluster_nhits.push_back(ClusterNHits.at(it->first));
+  for (int cluster_id = 0; cluster_id < (int) cluster_times.size(); cluster_id++){
 
     //Check if the cluster is in the delayed window and has a time > 10 us (exclude afterpulses)
     //The window should should be extended in the future after relevant exlusion cuts for afterpulsing have been implemented
     //check if the nhits cut for neutrons is passed -> consider a neutron candidate
     //Improve the neutron selection cuts in the future, probably cutting more signal than necessary at the moment
-    if (it->first > 10000){
-      double current_cb = ClusterChargeBalances.at(it->first);
-      double current_q = ClusterTotalPEs.at(it->first);
-      int current_nhits = ClusterNHits.at(it->first);
+    if (cluster_times[cluster_id] > 10000){
+      double current_cb = cluster_cb[cluster_id];
+      double current_q = cluster_charges[cluster_id];
+      int current_nhits = cluster_nhits[cluster_id];
       if (current_nhits >= nhits_thr && current_q < 150){
-        Log("FindNeutrons tool: Found neutron candidate at cluster # "+std::to_string(tmp_cluster_id)+", time: "+std::to_string(it->first)+" ns!!!",v_message,verbosity);
-        cluster_neutron.push_back(tmp_cluster_id);
-        cluster_times_neutron.push_back(it->first);
+        Log("FindNeutrons tool: Found neutron candidate at cluster # "+std::to_string(cluster_id)+", time: "+std::to_string(cluster_times[cluster_id])+" ns!!!",v_message,verbosity);
+        cluster_neutron.push_back(cluster_id);
+        cluster_times_neutron.push_back(cluster_times[cluster_id]);
         cluster_charges_neutron.push_back(current_q);
         cluster_cb_neutron.push_back(current_cb);
         cluster_nhits_neutron.push_back(current_nhits);
         return_val = true;
       }
     }
-    tmp_cluster_id ++;
   }
 
-
   return return_val;
 
 }
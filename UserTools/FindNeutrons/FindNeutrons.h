@@ -6,6 +6,7 @@
 
 #include "Tool.h"
 #include "Particle.h"
+#include "ClusterTable.h"
 
 /**
  * \class FindNeutrons
@@ -27,6 +28,7 @@ class FindNeutrons: public Tool {
   bool Finalise(); ///< Finalise function used to clean up resources.
 
   bool FindNeutronCandidates(std::string method); ///< Neutron identification
+  bool GetClusterFeatures(); ///< Fill the cluster time, charge, charge balance and nhits vectors (by cluster ID)
   bool FindNeutronsByCB(bool strict); ///< Neutron identification by Charge Balance cut
   bool FindNeutronsByNHits(int nhits_thr); /// < Neutron identification by NHits
   bool FillRecoParticles(); ///< Fill reco particle object with neutron information
@@ -1,7 +1,10 @@
 #include "FindTrackLengthInWater.h"
+#include "ToolRegistry.h"
 #include <boost/filesystem.hpp>
 #include "TMath.h"
 
+REGISTER_TOOL(FindTrackLengthInWater);
+
 FindTrackLengthInWater::FindTrackLengthInWater():Tool(){}
 
 
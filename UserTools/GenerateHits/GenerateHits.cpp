@@ -1,7 +1,10 @@
 #include "GenerateHits.h"
+#include "ToolRegistry.h"
 #include <cstdlib>
 #include <time.h>
 
+REGISTER_TOOL(GenerateHits);
+
 GenerateHits::GenerateHits():Tool(){}
 
 
@@ -1,4 +1,7 @@
 #include "GetLAPPDEvents.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(GetLAPPDEvents);
 
 GetLAPPDEvents::GetLAPPDEvents():Tool(){}
 
@@ -1,5 +1,8 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "GracefulStop.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(GracefulStop);
 
 GracefulStop::GracefulStop():Tool(){}
 
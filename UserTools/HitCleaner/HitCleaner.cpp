@@ -1,4 +1,5 @@
 #include "HitCleaner.h"
+#include "ToolRegistry.h"
 
 static HitCleaner* fgHitCleaner = 0;
 
@@ -19,6 +20,8 @@ HitCleaner* HitCleaner::Instance()
   return fgHitCleaner;
 }
 
+REGISTER_TOOL(HitCleaner);
+
 HitCleaner::HitCleaner():Tool(){}
 	
 HitCleaner::~HitCleaner() {
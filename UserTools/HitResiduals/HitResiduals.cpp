@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "HitResiduals.h"
+#include "ToolRegistry.h"
 
 #include "TApplication.h"
 #include "TSystem.h"
@@ -11,6 +12,8 @@
 #include <thread>         // std::this_thread::sleep_for
 #include <chrono>         // std::chrono::seconds
 
+REGISTER_TOOL(HitResiduals);
+
 HitResiduals::HitResiduals():Tool(){}
 
 const double SPEED_OF_LIGHT=29.9792458; // cm/ns - match time and position units of PMT
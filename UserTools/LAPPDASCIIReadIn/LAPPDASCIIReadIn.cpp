@@ -1,4 +1,7 @@
 #include "LAPPDASCIIReadIn.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDASCIIReadIn);
 
 LAPPDASCIIReadIn::LAPPDASCIIReadIn():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "LAPPDAnalysis.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDAnalysis);
 
 LAPPDAnalysis::LAPPDAnalysis():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "LAPPDBaselineSubtract.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDBaselineSubtract);
 
 LAPPDBaselineSubtract::LAPPDBaselineSubtract():Tool(){}
 
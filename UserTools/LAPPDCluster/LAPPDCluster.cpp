@@ -1,4 +1,11 @@
 #include "LAPPDCluster.h"
+#include "ToolRegistry.h"
+
+#include <array>
+#include <cmath>
+#include <map>
+
+REGISTER_TOOL(LAPPDCluster);
 
 LAPPDCluster::LAPPDCluster():Tool(),_geom(nullptr){}
 
@@ -12,7 +19,11 @@ bool LAPPDCluster::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
-  m_data->Stores["ANNIEEvent"]->Header->Get("AnnieGeometry", _geom);
+  bool got_geom = m_data->Stores["ANNIEEvent"]->Header->Get("AnnieGeometry", _geom);
+  if(!got_geom || _geom==nullptr){
+    cerr<<"LAPPDCluster: no AnnieGeometry in the ANNIEEvent header"<<endl;
+    return false;
+  }
     //cout<<"loaded Geom"<<endl;
   TString SCL;
   m_variables.Get("SimpleClusterLabel",SCL);
@@ -28,6 +39,14 @@ bool LAPPDCluster::Initialise(std::string configfile, DataModel &data){
 
     m_variables.Get("ClusterVerbosity",ClusterVerbosity);
 
+    // pulses on neighbouring channels closer than this (ns) belong to the same hit
+    ClusterTimeWindow = 5.;
+    m_variables.Get("ClusterTimeWindow",ClusterTimeWindow);
+
+    BuildStripTable();
+    channelPulses.assign(stripTable.size(),nullptr);
+    firstPulse.assign(stripTable.size(),0);
+
 
     //cout<<ClusterLabel<<endl;
 
@@ -41,8 +60,6 @@ bool LAPPDCluster::Execute(){
   bool isCFD;
   m_data->Stores["ANNIEEvent"]->Get("isCFD",isCFD);
   std::map <unsigned long, vector<LAPPDPulse>> RecoLAPPDPulses;
-  //cout<< "ClusterLabel  "<<ClusterLabel<<endl;
-  //cout<<"hmmm "<<isCFD<<" "<<HitOutLabel<<endl;
   if(isCFD==true){
     m_data->Stores["ANNIEEvent"]->Get(CFDClusterLabel,RecoLAPPDPulses);
     if(ClusterVerbosity>0) cout<<"CFD "<<CFDClusterLabel<<" "<<HitOutLabel<<endl;
@@ -53,224 +70,177 @@ bool LAPPDCluster::Execute(){
   }
 
   if(ClusterVerbosity>0) cout<<"Number of Pulses: "<<RecoLAPPDPulses.size()<<endl;
-  //m_data->Stores["ANNIEEvent"]->Get("RecoLAPPDPulses",RecoLAPPDPulses);
-    //cout<<"We got "<< RecoLAPPDPulses.size()<< " Pulses" << endl;
-  std::map <unsigned long, vector<LAPPDPulse>> :: iterator pulseitr;
 
+  // index the pulses by ChannelKey, and give each one a flat index so the
+  // pulses already taken into a hit can be flagged
+  size_t npulses = 0;
+  for(auto& channel : RecoLAPPDPulses){
+    unsigned long chankey = channel.first;
+    if(chankey>=stripTable.size() || !stripTable[chankey].valid){
+      if(ClusterVerbosity>0) cout<<"channel "<<chankey<<" is not an LAPPD strip in the Geometry, skipping it"<<endl;
+      continue;
+    }
+    channelPulses[chankey] = &channel.second;
+    firstPulse[chankey] = npulses;
+    npulses += channel.second.size();
+  }
+  absorbed.assign(npulses,0);
 
-  //cout<<"Grabbed RecoLAPPDPulses "<<RecoLAPPDPulses.size()<<endl;
+  auto Pulses = [this](long chankey) -> std::vector<LAPPDPulse>* {
+    return (chankey<0) ? nullptr : channelPulses[chankey];
+  };
 
-  vector<unsigned long> chanhand;
   std::map <unsigned long, vector<LAPPDHit>> Hits;
 
-
-
-  //cout<<"!!!That is all pulses we have!!!"<<endl;
-  for (pulseitr = RecoLAPPDPulses.begin(); pulseitr != RecoLAPPDPulses.end(); ++pulseitr){
-    vector<LAPPDHit> thehits;
-    vector<double> localposition;
-    double sition=-5555;
-    double PerpPosition=-5555;
-    double ParaPosition=-5555;
-
-
-    unsigned long chankey = pulseitr->first;
-
-    bool handled = false;
-    for(int i=0; i<chanhand.size(); ++i)
-      {
-        unsigned long key = chanhand[i];
-        if(chankey==key)
-        {
-          handled = true;
+  for(auto& channel : RecoLAPPDPulses){
+    unsigned long chankey = channel.first;
+    if(chankey>=channelPulses.size() || channelPulses[chankey]!=&channel.second) continue;
+
+    const StripChannel& mystrip = stripTable[chankey];
+    const long neighbours[5] = {mystrip.partner, mystrip.same_side[0], mystrip.same_side[1],
+                                mystrip.other_side[0], mystrip.other_side[1]};
+    vector<LAPPDPulse>& vPulse = channel.second;
+
+    for(size_t ipulse=0; ipulse<vPulse.size(); ++ipulse){
+      if(absorbed[firstPulse[chankey]+ipulse]) continue;
+
+      LAPPDPulse& maxpulse = vPulse[ipulse];
+      double maxcharge = maxpulse.GetCharge();
+      double maxtime = maxpulse.GetTime();
+      if(maxcharge>=0) continue; // Pulses are negative
+
+      // the other end of the strip is needed for the position along it
+      std::vector<LAPPDPulse>* partnerpulses = Pulses(mystrip.partner);
+      long ipartner = Coincident(partnerpulses,maxtime);
+      if(ipartner<0) continue;
+
+      // only the largest of the coincident pulses on this and the adjacent strips seeds a hit
+      bool ismax = true;
+      for(long key : neighbours){
+        std::vector<LAPPDPulse>* pulses = Pulses(key);
+        if(pulses==nullptr) continue;
+        for(const LAPPDPulse& other : *pulses){
+          if(std::fabs(other.GetTime()-maxtime)<=ClusterTimeWindow && other.GetCharge()<maxcharge) ismax = false;
         }
       }
-      if (handled)
-      {
-        //cout<<chankey<<" is looped."<<endl;
-        continue;
-      }
-
-    //cout<<"!@##^&&%%$pulseitr chankey is "<<chankey<<endl;
-
-    vector<LAPPDPulse> vPulse = pulseitr->second;
-
-    // cout<<"iterating!!!   "<<chankey<<" "<<vPulse.size()<<endl;
-
-    //if(vPulse.size()>1) {cout<<"VPULSE HAS A SIZE OF: "<<vPulse.size()<<endl;}
-    for(int jj=0; jj<vPulse.size(); jj++){
-      LAPPDPulse apulse = vPulse.at(jj);
-      // cout<<"the charge of this pulse is: "<<apulse.GetCharge()<<endl;
-      //cout<< "The Time of this Pulse is " <<apulse.GetTime() <<endl;
-    }
-
-    Channel* mychannel= _geom->GetChannel(chankey);
-   // cout<<"the strip number is :"<<mychannel->GetStripNum()<<" and the side is: "<<mychannel->GetStripSide()<<endl;
-    std::map<unsigned long , LAPPDPulse> cPulse;
-    std::map <unsigned long, vector<LAPPDPulse>> :: iterator oppoitr;
-
-    for (oppoitr = RecoLAPPDPulses.begin(); oppoitr != RecoLAPPDPulses.end(); ++oppoitr){
-
-      unsigned long oppochankey = oppoitr->first;
-
-      //cout<<"oppochankey is "<<oppochankey<<endl;
-
-      vector<LAPPDPulse> oppovPulse = oppoitr->second;
-      Channel* oppochannel = _geom->GetChannel(oppochankey);
-      int mystripnum = mychannel->GetStripNum();
-      int oppostripnum = oppochannel->GetStripNum();
-
-      if(ClusterVerbosity>1) cout<<"mystripnum is "<<mystripnum<<endl;
-      if(ClusterVerbosity>1) cout<<"oppostripnum is "<<oppostripnum<<endl;
-
-
-
-      if( (oppochankey != chankey) && (mystripnum == oppostripnum) ){
-        if(ClusterVerbosity>2) cout<<"channel "<<chankey<<" and "<<oppochankey<<" are on the same strip."<<endl;
-        cPulse.insert(pair <unsigned long,LAPPDPulse> (chankey,vPulse.at(0)));
-        cPulse.insert(pair <unsigned long,LAPPDPulse> (oppochankey,oppovPulse.at(0)));
-        //chanhand.push_back(oppochankey);
-      }
-      if ( (oppochankey != chankey) && (std::abs(oppostripnum-mystripnum)==1) ){
-        if (mychannel->GetStripSide() == oppochannel->GetStripSide()){
-          if(ClusterVerbosity>2) cout<<"channel "<<chankey<<" and "<<oppochankey<<" are on the same sides of adjacent strips."<<endl;
-          cPulse.insert(pair <unsigned long,LAPPDPulse> (oppochankey,oppovPulse.at(0)));
-          //chanhand.push_back(oppochankey);
-        }
-        else {
-          if(ClusterVerbosity>2) cout<<"channel "<<chankey<<" and "<<oppochankey<<" are on the opposite sides of adjacent strips."<<endl;
-          cPulse.insert(pair <unsigned long,LAPPDPulse> (oppochankey,oppovPulse.at(0)));
-          //chanhand.push_back(oppochankey);
+      if(!ismax) continue;
+
+      absorbed[firstPulse[chankey]+ipulse] = 1;
+      for(long key : neighbours){
+        std::vector<LAPPDPulse>* pulses = Pulses(key);
+        if(pulses==nullptr) continue;
+        for(size_t iother=0; iother<pulses->size(); ++iother){
+          if(std::fabs(pulses->at(iother).GetTime()-maxtime)<=ClusterTimeWindow) absorbed[firstPulse[key]+iother] = 1;
         }
       }
 
-    }
-
-    //Finding the Maxpulse
-    //cout<<"Finding Maxpulse!!!"<<endl;
-    double maxcharge = 0;
-    unsigned long maxchankey=0;
-    LAPPDPulse maxpulse;
-
-    std::map<unsigned long , LAPPDPulse> :: iterator itr;
-
-    //cout<<"What is in cPulse???"<<endl;
-    //for (itr = cPulse.begin(); itr != cPulse.end(); ++itr){
-      //cout<< itr->first <<endl;
-      //cout<< itr->second.GetTime() <<endl;
-    //}
-
-    for (itr = cPulse.begin(); itr != cPulse.end(); ++itr){
-      unsigned long mychankey = itr->first;
-      LAPPDPulse mypulse = itr->second;
-      //cout<<"!!!mychankey is "<<mychankey<<" !!!"<<endl;
-      if (maxcharge>mypulse.GetCharge()){ // Pulses are negative
-        maxcharge=mypulse.GetCharge();
-        //cout<<"maxcharge "<<mypulse.GetCharge()<<endl;
-        maxchankey = mychankey;
-        maxpulse = mypulse;
+      // position along the strip from the arrival time difference of its two ends
+      double partnertime = partnerpulses->at(ipartner).GetTime();
+      double time0 = (mystrip.side==0) ? maxtime : partnertime;
+      double time1 = (mystrip.side==0) ? partnertime : maxtime;
+      double ParaPosition = ((time0 - time1) * 0.53 * (299.792458))/2.0;
+
+      // position across the strips from the peak weighted strip number, same side only
+      double SumAbove = mystrip.strip*maxpulse.GetPeak();
+      double SumBelow = maxpulse.GetPeak();
+      int nstrips = 1;
+      for(int i=0; i<2; ++i){
+        std::vector<LAPPDPulse>* pulses = Pulses(mystrip.same_side[i]);
+        long inext = Coincident(pulses,maxtime);
+        if(inext<0) continue;
+        int Strip = mystrip.strip + ((i==0) ? -1 : 1);
+        double Peak = pulses->at(inext).GetPeak();
+        SumAbove += ((double)Strip*Peak);
+        SumBelow += (Peak);
+        ++nstrips;
       }
+      double PerpPosition = -5555;
+      if(nstrips==1) PerpPosition = (double) mystrip.strip;
+      else if(SumBelow>0) PerpPosition = (SumAbove / SumBelow);
+
+      if(ClusterVerbosity>2) cout<<"channel "<<chankey<<" strip "<<mystrip.strip<<" side "<<mystrip.side
+                                 <<" time "<<maxtime<<" positions "<<ParaPosition<<" "<<PerpPosition<<endl;
+
+      vector<double> localposition{ParaPosition,PerpPosition};
+
+      //Putting information into LAPPDHit
+      LAPPDHit myhit;
+      myhit.SetTubeId(maxpulse.GetTubeId());
+      myhit.SetTime(maxtime);
+      myhit.SetCharge(maxcharge);
+      myhit.SetLocalPosition(localposition);
+      Hits[chankey].push_back(myhit);
     }
+  }
 
-    //cout<<maxchankey<<" is the maxchankey!!!!!!"<<endl;
-    //cout<<"chankey is "<<chankey<<" !!!!!!"<<endl;
-
+  for(auto& channel : RecoLAPPDPulses){
+    if(channel.first<channelPulses.size()) channelPulses[channel.first] = nullptr;
+  }
 
+  if(ClusterVerbosity>0) cout << "Ending LAPPDCluster: " << Hits.size()<< endl;
+  m_data->Stores["ANNIEEvent"]->Set(HitOutLabel,Hits);
 
-    if (maxchankey == chankey){
-      //cout<<chankey<<" is the maxchankey!!!!!!"<<endl;
-      for (itr = cPulse.begin(); itr != cPulse.end(); ++itr){
-        chanhand.push_back(itr->first);
-      }
-    }
-    else {
-      //cout<<chankey<<" is not the maxchankey LOOP BREAKS"<<endl;
-      continue;
-    }
+  return true;
+}
 
 
-    maxcharge = maxpulse.GetCharge();
+bool LAPPDCluster::Finalise(){
 
-    //cout<<"the maxchankey is "<<maxchankey<<endl;
-    //cout<<"Maxpulse is at "<<maxpulse.GetChannelID()<<endl;
+  return true;
+}
 
-    Channel* maxchannel= _geom->GetChannel(maxchankey);
-    std::map<int,double> neighbourpulses;
 
-    for (itr = cPulse.begin(); itr != cPulse.end(); ++itr){
-      unsigned long thechankey = itr->first;
-      LAPPDPulse mypulse = itr->second;
+void LAPPDCluster::BuildStripTable(){
 
-      Channel* mychannel = _geom->GetChannel(thechankey);
-      if(ClusterVerbosity>2) cout<<"thechankey "<<thechankey<<" maxchankey "<<maxchankey<<endl;
-      if(ClusterVerbosity>2) cout<<"MYStrip "<<mychannel->GetStripNum()<<" MAXStrip "<<maxchannel->GetStripNum()<<endl;
-      if(ClusterVerbosity>2) cout<<" "<<endl;
-      if( (thechankey != maxchankey) && (mychannel->GetStripNum() == maxchannel->GetStripNum()) ) {
-        if(ClusterVerbosity>2) cout<<"WERTWER "<<maxpulse.GetTime()<<" "<<mypulse.GetTime()<<endl;
-        if(ClusterVerbosity>2)cout<<mychannel->GetStripSide()<<" "<<maxchannel->GetStripSide()<<endl;
-        if(ClusterVerbosity>2) cout<<" "<<endl;
-        if ( (mychannel->GetStripSide()==0) && (maxchannel->GetStripSide()==1) ){
-          if(ClusterVerbosity>2) cout<<"case 1"<<endl;
-          ParaPosition = ((mypulse.GetTime() - maxpulse.GetTime()) * 0.53 * (299.792458))/2.0;
-        }
-        if ( (mychannel->GetStripSide()==1) && (maxchannel->GetStripSide()==0) ){
-          if(ClusterVerbosity>2) cout<<"case 2"<<endl;
-          ParaPosition = ((maxpulse.GetTime() - mypulse.GetTime()) * 0.53 * (299.792458))/2.0;
-        }
-        //cout<<leftpulse.GetTime()<<" "<<rightpulse.GetTime()<<endl;
-      }
-      if( (thechankey != maxchankey) && (abs(mychannel->GetStripNum() - maxchannel->GetStripNum()) == 1) && (mychannel->GetStripSide() == maxchannel->GetStripSide()) ) {
-        neighbourpulses.insert(pair <int,double> (mychannel->GetStripNum(),mypulse.GetPeak()));
-      }
-    }
-    neighbourpulses.insert(pair <int,double> (maxchannel->GetStripNum(),maxpulse.GetPeak()));
+  const std::vector<ChannelInfo>& channels = _geom->GetChannelInfos();
+  const std::vector<std::string>& elements = _geom->GetDetectorElements();
 
-    double SumAbove=0.;
-    double SumBelow=0.;
+  // per LAPPD: strip number -> ChannelKeys of its side 0 and side 1
+  std::map<unsigned long, std::map<int, std::array<long,2>>> lappds;
+  for(unsigned long chankey=0; chankey<channels.size(); ++chankey){
+    const ChannelInfo& info = channels[chankey];
+    if(!info.valid || info.element<0 || elements.at(info.element)!="LAPPD") continue;
+    if(info.strip_num<0 || (info.strip_side!=0 && info.strip_side!=1)) continue;
+    std::array<long,2>& ends = lappds[info.detector_key].emplace(info.strip_num,std::array<long,2>{{-1,-1}}).first->second;
+    ends[info.strip_side] = chankey;
+  }
 
-    if(neighbourpulses.size()>1){
-      std::map<int,double>::iterator neighbouritr;
-      for (neighbouritr = neighbourpulses.begin(); neighbouritr != neighbourpulses.end(); ++neighbouritr){
-        int Strip = neighbouritr->first;
-        double Peak = neighbouritr->second;
-        //cout<<"!!!!!!prepcalculation "<<Strip<<" "<<Peak<<endl;
-        SumAbove += ((double)Strip*Peak);
-        SumBelow += (Peak);
+  stripTable.assign(channels.size(),StripChannel());
+  for(auto& lappd : lappds){
+    std::map<int, std::array<long,2>>& strips = lappd.second;
+    for(auto& strip : strips){
+      for(int side=0; side<2; ++side){
+        long chankey = strip.second[side];
+        if(chankey<0) continue;
+        StripChannel& entry = stripTable[chankey];
+        entry.valid = true;
+        entry.strip = strip.first;
+        entry.side = side;
+        entry.partner = strip.second[1-side];
+        for(int i=0; i<2; ++i){
+          auto adjacent = strips.find(strip.first + ((i==0) ? -1 : 1));
+          if(adjacent==strips.end()) continue;
+          entry.same_side[i] = adjacent->second[side];
+          entry.other_side[i] = adjacent->second[1-side];
+        }
       }
-      if(SumBelow>0) {PerpPosition = (SumAbove / SumBelow);}
     }
-    else {
-      PerpPosition = (double) maxchannel->GetStripNum();
-    }
-
-    //cout<<"Positions: "<<ParaPosition<<" "<<PerpPosition<<endl;
-    localposition.push_back(ParaPosition);
-    localposition.push_back(PerpPosition);
-
-
-    //Putting information into LAPPDHit
-    LAPPDHit myhit;
-    myhit.SetTubeId(maxpulse.GetTubeId());
-    myhit.SetTime(maxpulse.GetTime());
-    myhit.SetCharge(maxcharge);
-    myhit.SetLocalPosition(localposition);
-    thehits.push_back(myhit);
-    Hits.insert(pair <unsigned long,vector<LAPPDHit>> (chankey,thehits));
-    chanhand.push_back(chankey);
-    //cout<< "HANDLED" << endl;
-
-
-
+    if(ClusterVerbosity>0) cout<<"LAPPD "<<lappd.first<<" has "<<strips.size()<<" strips"<<endl;
   }
-  if(ClusterVerbosity>0) cout << "Ending LAPPDCluster: " << Hits.size()<< endl;
-  //m_data->Stores["ANNIEEvent"]->Set("Clusters",Hits);
-  m_data->Stores["ANNIEEvent"]->Set(HitOutLabel,Hits);
-
-  return true;
 }
 
 
-bool LAPPDCluster::Finalise(){
+long LAPPDCluster::Coincident(const std::vector<LAPPDPulse>* pulses, double t) const {
 
-  return true;
+  if(pulses==nullptr) return -1;
+  long best = -1;
+  double bestdt = ClusterTimeWindow;
+  for(size_t i=0; i<pulses->size(); ++i){
+    double dt = std::fabs(pulses->at(i).GetTime()-t);
+    if(dt<bestdt || (best<0 && dt<=bestdt)){
+      best = i;
+      bestdt = dt;
+    }
+  }
+  return best;
 }
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 
 #include "Tool.h"
 #include "Geometry.h"
@@ -15,7 +16,12 @@
 /**
  * \class LAPPDCluster
  *
- * This is a blank template for a Tool used by the script to generate a new custom tool. Please fill out the description and author information.
+ * Pairs the pulses found at the two ends of each LAPPD strip into LAPPDHits.
+ * A hit is seeded by a pulse that has a coincident pulse at the other end of
+ * its strip and is the largest among the coincident pulses on its own and the
+ * adjacent strips; those pulses are then taken into the hit. The strip layout
+ * is read from the Geometry once, at Initialise, so each pulse only has to
+ * look at its five neighbouring channels.
 *
 * $Author: B.Richards $
 * $Date: 2019/05/28 10:44:00 $
@@ -34,8 +40,32 @@ class LAPPDCluster: public Tool {
 
  private:
 
+    // Where a channel sits on its LAPPD. Channel keys of the other end of the
+    // same strip and of the strips either side, or -1 where there is none.
+    struct StripChannel {
+      bool valid = false;
+      int strip = -1;
+      int side = -1;
+      long partner = -1;
+      long same_side[2] = {-1,-1};    // strip-1, strip+1
+      long other_side[2] = {-1,-1};   // strip-1, strip+1
+    };
+
+    void BuildStripTable();
+    // index of the pulse closest in time to t within the coincidence window, or -1
+    long Coincident(const std::vector<LAPPDPulse>* pulses, double t) const;
+
     Geometry* _geom;
 
+    // indexed by ChannelKey
+    std::vector<StripChannel> stripTable;
+    // per event: the pulses of each channel and the flat index of its first pulse
+    std::vector<std::vector<LAPPDPulse>*> channelPulses;
+    std::vector<size_t> firstPulse;
+    std::vector<char> absorbed;
+
+    double ClusterTimeWindow;
+
     string HitOutLabel;
     string SimpleClusterLabel;
     string CFDClusterLabel;
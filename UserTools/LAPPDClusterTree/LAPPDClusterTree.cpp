@@ -1,4 +1,7 @@
 #include "LAPPDClusterTree.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDClusterTree);
 
 LAPPDClusterTree::LAPPDClusterTree():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "LAPPDDataDecoder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDDataDecoder);
 
 LAPPDDataDecoder::LAPPDDataDecoder():Tool(){}
 
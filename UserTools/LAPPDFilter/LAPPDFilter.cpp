@@ -1,4 +1,7 @@
 #include "LAPPDFilter.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDFilter);
 
 LAPPDFilter::LAPPDFilter():Tool(){}
 
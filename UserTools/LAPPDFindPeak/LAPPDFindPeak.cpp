@@ -1,4 +1,7 @@
 #include "LAPPDFindPeak.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDFindPeak);
 
 LAPPDFindPeak::LAPPDFindPeak():Tool(){}
 
@@ -1,6 +1,9 @@
 #include "LAPPDFindT0.h"
+#include "ToolRegistry.h"
 #include "TGraph.h"
 
+REGISTER_TOOL(LAPPDFindT0);
+
 LAPPDFindT0::LAPPDFindT0():Tool(){}
 
 
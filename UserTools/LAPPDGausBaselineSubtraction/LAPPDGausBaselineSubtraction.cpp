@@ -1,4 +1,7 @@
 #include "LAPPDGausBaselineSubtraction.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDGausBaselineSubtraction);
 
 LAPPDGausBaselineSubtraction::LAPPDGausBaselineSubtraction():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "LAPPDIntegratePulse.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDIntegratePulse);
 
 LAPPDIntegratePulse::LAPPDIntegratePulse():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "LAPPDLocateHit.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDLocateHit);
 
 LAPPDLocateHit::LAPPDLocateHit():Tool(){}
 
@@ -46,20 +49,18 @@ bool LAPPDLocateHit::Initialise(std::string configfile, DataModel &data){
 
   m_data->Stores["ANNIEEvent"]->Header->Get("AnnieGeometry", geom);
 
-  std::map<int, int> event0Channel;
-  std::map<int, int> event1Channel;
-
-  for(int i =0; i<60;i++){ //fill the two strip number map, for finding the same strip later
-    Channel* c = geom->GetChannel(i);
-    int strip = c->GetStripNum();
-    int side = c->GetStripSide();
-    if(side==0) event0Channel.insert(pair<int,int>(strip,i));
-    if(side==1) event1Channel.insert(pair<int,int>(strip,i));
-  }
-
   EventItr=0;
   m_variables.Get("StripLength",StripLength);
   m_variables.Get("signalSpeed",signalSpeed);
+
+  locateSettings.low_threshold = peakLowThreshold;
+  locateSettings.high_threshold = peakHighThreshold;
+  locateSettings.time_step = nnlsTimeStep;
+  locateSettings.sigma = sigma;
+  locateSettings.strip_length = StripLength;
+  locateSettings.signal_speed = signalSpeed;
+  // largest time difference between the two ends of a strip, in ns; default StripLength/signalSpeed
+  m_variables.Get("maxPropagationDelay",locateSettings.max_delay);
   positionHistOff = new TH2D("PositionsOff","PositionsOff",200,-0.05,20.05 ,30,-0.5,29.5);
   positionHistIn = new TH2D("PositionsIn","PositionsIn",200,-0.05,20.05 ,30,-0.5,29.5);
   timeEventsTotal = new TH2D("EventsTimeTotal","EventsTimeTotal",(int)40/Timebinsize2D,-0.05,20.05 ,30,-0.5,29.5);
@@ -117,229 +118,47 @@ bool LAPPDLocateHit::Execute(){
   m_data->Stores["ANNIEEvent"]->Get(InputWavLabel, nnlsResultInWaveform);
   m_data->Stores["ANNIEEvent"]->Get(RawInputWavLabel, RawnnlsWaveform);
   //cout<<"nnls size "<<nnlsResultInWaveform.size()<<endl;
-  // loop over all channels
-  std::map<unsigned long, vector<Waveform<double>>> :: iterator itr;
-
-  std::map<int, vector<vector<double>>> PeaksOnSide0; //pairs of pulses on int-strip number, vector [time, height]
-  std::map<int, vector<vector<double>>> PeaksOnSide1;
-  std::map<int,int> eventsOnChannel;
-  eventsOnChannel.insert(pair<int,int>(1000,0)); //fill a ramdom pair, incase there is no signal on this channel
-
-  for (itr = nnlsResultInWaveform.begin(); itr != nnlsResultInWaveform.end(); ++itr){
-
-      unsigned long channelno = itr->first;
-      vector<Waveform<double>> Vwavs = itr->second;
-      vector<Waveform<double>> RVwavs = RawnnlsWaveform.find(channelno)->second;
-
-      Channel* mychannel = geom->GetChannel(channelno);
-      //figure out the stripline number
-      int stripno1 = mychannel->GetStripNum();
-      //figure out the side of the stripline
-      int stripside1 = mychannel->GetStripSide();
-      vector<double> PeakHeight;
-      vector<int> PeakTimeLoc;
-      vector<double> PeakArea;
-      vector<double> PulseArea;
-      vector<double> PulseHeight;
-
-      //loop over all waveforms in this channel, find the local peaks
-      for (int i = 0; i<Vwavs.size(); i++){
-        //vector<double> LocalPeak = FindlocalPeak(Vwavs.at(i));
-        if(channelno == 1005 || channelno == 1035) break;
-        int eventN = 0;
-        bool loopR = FindlocalPeaks(Vwavs.at(i),RVwavs.at(i),PeakHeight,PeakTimeLoc,PeakArea,PulseArea,PulseHeight,stripno1,peakLowThreshold,peakHighThreshold,nnlsTimeStep);
-        if (LAPPDLocateHitVerbosity>1) cout<<"finding on "<<channelno<<endl;
-        if(loopR == true){ //normal means no peak higher than high threshold, some unknown error from nnls. should be removed in the future
-          if(stripside1 == 0){  // push samples to side 0
-            if(LAPPDLocateHitVerbosity>1) cout<<"side0 "<<endl;
-              vector<vector<double>> x;
-              vector<double> loc;
-              vector<double> hei;
-              vector<double> nnlsA;
-              vector<double> pulseA;
-              vector<double> phei;
-              //cout<<"peakheight size "<<PeakHeight.size()<<endl;
-              for (int i=0;i<PeakHeight.size();i++) {
-                  //x = [peak time on this strip, peak heights on this strip]
-
-                loc.push_back(PeakTimeLoc.at(i));
-                hei.push_back(PeakHeight.at(i));
-                nnlsA.push_back(PeakArea.at(i));
-                pulseA.push_back(PulseArea.at(i));
-                phei.push_back(PulseHeight.at(i));
-              }
-                x.push_back(loc);
-                x.push_back(hei);
-                x.push_back(nnlsA);
-                x.push_back(pulseA);
-                x.push_back(phei);
-                PeaksOnSide0.insert(pair<int,vector<vector<double>>>(stripno1,x));
-                //for (int kkk=0;kkk<loc.size();kkk++) cout<<"0element "<<loc.at(kkk)<<endl;
-                eventN += loc.size();
-                loc.clear();
-                hei.clear();
-                nnlsA.clear();
-                pulseA.clear();
-                phei.clear();
-                x.clear();
-
-                if(LAPPDLocateHitVerbosity>1) cout<<"In side 0 strip "<<stripno1<<" "<<eventsOnChannel.count(stripno1)<<" size "<<PeakHeight.size()<<endl;
-
-          }else if(stripside1 == 1){ // push samples to side 1
-            if(LAPPDLocateHitVerbosity>1) cout<<"side1"<<endl;
-            vector<vector<double>> x;
-            vector<double> loc;
-            vector<double> hei;
-            vector<double> nnlsA;
-            vector<double> pulseA;
-            vector<double> phei;
-            for (int i=0;i<PeakHeight.size();i++) {
-                //x = [peak time on this strip, peak heights on this strip]
-              loc.push_back(PeakTimeLoc.at(i));
-              hei.push_back(PeakHeight.at(i));
-              nnlsA.push_back(PeakArea.at(i));
-              pulseA.push_back(PulseArea.at(i));
-              phei.push_back(PulseHeight.at(i));
-            }
-              x.push_back(loc);
-              x.push_back(hei);
-              x.push_back(nnlsA);
-              x.push_back(pulseA);
-              x.push_back(phei);
-              PeaksOnSide1.insert(pair<int,vector<vector<double>>>(stripno1,x));
-              //for (int kkk=0;kkk<loc.size();kkk++) cout<<"1element "<<loc.at(kkk)<<endl;
-              eventN += loc.size();
-              loc.clear();
-              hei.clear();
-              nnlsA.clear();
-              pulseA.clear();
-              phei.clear();
-              x.clear();
-
-              if(LAPPDLocateHitVerbosity>1) cout<<"In side 1 strip "<<stripno1<<" "<<eventsOnChannel.count(stripno1)<<" size "<<PeakHeight.size()<<endl;
-          }else{cout<<"pulse not fill in side 0 or 1 at channel "<<channelno<<" on event "<<EventItr<<endl;}
-
-        }
-        if(LAPPDLocateHitVerbosity>0) cout<<"strip "<<stripno1<<" "<<eventsOnChannel.count(stripno1)<<" pulse number "<<PeakHeight.size()<<endl;
-        if (eventsOnChannel.count(stripno1)==0){
-          eventsOnChannel.insert(pair<int,int>(stripno1,eventN));
-        }else{
-          int prev = eventsOnChannel.find(stripno1)->second;
-          if (prev > eventN) eventsOnChannel.find(stripno1)->second = eventN;
-        }
-      }//end looping all waveforms
-      //cout<<"finish looping"<<endl;
-
-
-  }
 
-  //now we have fill the peaks on side 1 and side 0. start to match them
-    map<int, vector<vector<double>>> OrderedPeaks; //use to save all matched peaks as pair (strip number, vector of all position)
-
-  if(PeaksOnSide0.size()!=PeaksOnSide1.size()){
-    if(LAPPDLocateHitVerbosity>0) cout<<"find "<<PeaksOnSide0.size()<<"on side0, "<<PeaksOnSide1.size()<<"on side1."<<endl;
+  // put the first waveform of every strip end into the locator, then find the
+  // peaks of all of them and pair the two ends of each strip in one go
+  locator.clear();
+  for (auto& channel : nnlsResultInWaveform){
+      unsigned long channelno = channel.first;
+      if(channelno == 1005 || channelno == 1035) continue;
+      vector<Waveform<double>>& Vwavs = channel.second;
+      if(Vwavs.empty()) continue;
+
+      const ChannelInfo* mychannel = geom->GetChannelInfo(channelno);
+      if(mychannel==nullptr){
+        if(LAPPDLocateHitVerbosity>0) cout<<"channel "<<channelno<<" is not in the geometry"<<endl;
+        continue;
+      }
+      const vector<double>* raw = nullptr;
+      auto rawitr = RawnnlsWaveform.find(channelno);
+      if(rawitr != RawnnlsWaveform.end() && !rawitr->second.empty()) raw = rawitr->second.at(0).GetSamples();
+      if (LAPPDLocateHitVerbosity>1) cout<<"finding on "<<channelno<<" strip "<<mychannel->strip_num<<" side "<<mychannel->strip_side<<endl;
+      locator.AddChannel(mychannel->strip_num,mychannel->strip_side,*Vwavs.at(0).GetSamples(),raw);
   }
-
-  //looping all strips
-  //**************!!!really stupid factorial, need to be optimized
-
-  for (int strip = 1; strip<28 ;strip++){
-    if(LAPPDLocateHitVerbosity>1) cout<<"strip "<<strip<<", event "<<eventsOnChannel.find(strip)->second<<endl;
-    if (eventsOnChannel.find(strip)->second !=0){
-
-    vector<vector<double>> e0 = PeaksOnSide0.find(strip)->second;
-    vector<vector<double>> e1 = PeaksOnSide1.find(strip)->second;
-    if(LAPPDLocateHitVerbosity>0) cout<<"ordering strip "<<strip<<" side0 "<<e0.at(1).size()<<" side1 "<<e1.at(1).size()<<endl;
-    vector<int> permute0;
-    vector<int> permute1;
-    for(int k = 0;k<e0.at(1).size();k++){  //we already have e0 size = e1 size
-        permute0.push_back(k);}
-    for(int k = 0;k<e1.at(1).size();k++){
-        permute1.push_back(k);}
-    vector<int> MaxOrder0 = permute0;
-    vector<int> MaxOrder1 = permute1;
-    double Maxsum = 0.;
-    int MaxLoop = permute0.size();
-    if (permute1.size()<permute0.size()) {MaxLoop = permute1.size();}
-
-    if(LAPPDLocateHitVerbosity>0) cout<<"MaxLoop "<<MaxLoop<<endl;
-    if (MaxLoop > 0){
-//cout<<"problem here 0"<<endl;
-    if (permute1.size()<permute0.size()) MaxLoop = permute1.size();
-  for(int j=0;j<MaxLoop;j++){  //1st
-    double pr = MatchingProduct(e0.at(1).at(j), e1.at(1).at(j), sigma); //vector [time, height]
-    Maxsum = Maxsum + pr;
+  locator.Locate(locateSettings,locatedHits);
+  if(LAPPDLocateHitVerbosity>0) cout<<"found "<<locator.NumPeaks()<<" peaks, "<<locatedHits.size()<<" hits"<<endl;
+
+  //the matched peaks of each strip as (strip number, vector of all positions, heights...)
+  map<int, vector<vector<double>>> OrderedPeaks;
+  for (const lappdlocate::Hit& hit : locatedHits){
+    vector<vector<double>>& PandH = OrderedPeaks[hit.strip];
+    if(PandH.empty()) PandH.resize(10);
+    PandH[0].push_back(hit.parallel);
+    PandH[1].push_back(hit.height);
+    PandH[2].push_back(hit.time);
+    PandH[3].push_back(hit.nnls_area_sum);
+    PandH[4].push_back(hit.nnls_area_diff);
+    PandH[5].push_back(hit.pulse_area_sum);
+    PandH[6].push_back(hit.pulse_area_diff);
+    PandH[7].push_back(hit.pulse_height);
+    PandH[8].push_back(hit.parallel_error);
+    PandH[9].push_back(hit.transverse_error);
+    if (LAPPDLocateHitVerbosity>0) cout<<"saving positions on "<<hit.strip<<" position "<<hit.parallel<<" +- "<<hit.parallel_error<<endl;
   }
-//cout<<"problem here 1"<<endl;
-  do {
-    do{
-    double Sum = 0.;
-    for(int j=0;j<MaxLoop;j++){
-      Sum+=MatchingProduct(e0.at(1).at(permute0.at(j)), e1.at(1).at(permute1.at(j)), sigma);
-    }
-    if(Sum>Maxsum){
-      MaxOrder0 = permute0;
-      MaxOrder1 = permute1;
-      Maxsum = Sum;
-    }
-    //cout<<"problem here in0"<<endl;
-  }while(next_permutation(permute0.begin(),permute0.end()));
-  //cout<<"problem here in1"<<endl;
-}while(next_permutation(permute1.begin(),permute1.end()));
-//  //now, use the max order to pair pulse;
-  vector<double> Position;
-  vector<double> Height;
-  vector<double> AbsTime;
-  vector<double> nnlsAreaS;
-  vector<double> nnlsAreaD;
-  vector<double> pulseAreaS;
-  vector<double> pulseAreaD;
-  vector<double> pulseHeight;
-  vector<vector<double>> PandH;
-//int Num = MaxOrder0.size();
-//if (MaxOrder1.size()<MaxOrder0.size()) Num = MaxOrder1.size();
-//cout<<"position "<<Position.size()<<" "<<MaxOrder0.size()<<" "<<MaxOrder1.size()<<endl;
-
-for (int p = 0; p<MaxLoop;p++){
-  double dT = e0.at(0).at(MaxOrder0.at(p)) - e1.at(0).at(MaxOrder1.at(p));    //**** add height number here
-  double SumHeight = e0.at(1).at(MaxOrder0.at(p)) + e1.at(1).at(MaxOrder1.at(p));
-  double absTimeIn = (e0.at(0).at(MaxOrder0.at(p)) + e1.at(0).at(MaxOrder1.at(p)))/2/1000*nnlsTimeStep - 0.5 ;
-  double nnlsArS = e0.at(2).at(MaxOrder0.at(p)) + e1.at(2).at(MaxOrder1.at(p));
-  double nnlsArD = e0.at(2).at(MaxOrder0.at(p)) - e1.at(2).at(MaxOrder1.at(p));
-  double pulseArS = e0.at(3).at(MaxOrder0.at(p)) + e1.at(3).at(MaxOrder1.at(p));
-  double pulseArD = e0.at(3).at(MaxOrder0.at(p)) - e1.at(3).at(MaxOrder1.at(p));
-  double SumpulseHei = e0.at(4).at(MaxOrder0.at(p)) + e1.at(4).at(MaxOrder1.at(p));
-  dT = dT * nnlsTimeStep / 1000;
-  if(LAPPDLocateHitVerbosity>1) cout<<"dT= "<<dT<<", StripLength "<<StripLength<<", signalspeed"<<signalSpeed<<endl;
-  double pos = (dT * signalSpeed + StripLength)/2*100;
-  Position.push_back(pos);
-  Height.push_back(SumHeight);
-  AbsTime.push_back(absTimeIn);
-  nnlsAreaS.push_back(nnlsArS);
-  nnlsAreaD.push_back(nnlsArD);
-  pulseAreaS.push_back(pulseArS);
-  pulseAreaD.push_back(pulseArD);
-  pulseHeight.push_back(SumpulseHei);
-  if (LAPPDLocateHitVerbosity>0) cout<<"saving positions on "<<strip<<" position "<<pos<<endl;
-}
-  PandH.push_back(Position);
-  PandH.push_back(Height);
-  PandH.push_back(AbsTime);
-  PandH.push_back(nnlsAreaS);
-  PandH.push_back(nnlsAreaD);
-  PandH.push_back(pulseAreaS);
-  PandH.push_back(pulseAreaD);
-  PandH.push_back(pulseHeight);
-  OrderedPeaks.insert(pair<int,vector<vector<double>>>(strip,PandH));
-
-e0.clear();
-e1.clear();
-permute0.clear();
-permute1.clear();
-
-}
-}
-}
   //end else
 if (LAPPDLocateHitVerbosity>0) cout<<"Itr "<<OrderedPeaks.size()<<endl;
 
@@ -353,18 +172,22 @@ vector<double> DISnnlsAreaD;
 vector<double> DISpulseAreaS;
 vector<double> DISpulseAreaD;
 vector<double> DISpulseHeight;
+vector<double> DISpositionErr;
+vector<double> DISstripErr;
 
 
   for (itrPlot = OrderedPeaks.begin(); itrPlot != OrderedPeaks.end(); ++itrPlot){
     int stripNo = itrPlot->first;
-    vector<double> position = itrPlot->second.at(0);
-    vector<double> height = itrPlot->second.at(1);
-    vector<double> time = itrPlot->second.at(2);
-    vector<double> nnlsAS = itrPlot->second.at(3);
-    vector<double> nnlsAD = itrPlot->second.at(4);
-    vector<double> pulseAS = itrPlot->second.at(5);
-    vector<double> pulseAD = itrPlot->second.at(6);
-    vector<double> rawheight = itrPlot->second.at(7);
+    const vector<double>& position = itrPlot->second.at(0);
+    const vector<double>& height = itrPlot->second.at(1);
+    const vector<double>& time = itrPlot->second.at(2);
+    const vector<double>& nnlsAS = itrPlot->second.at(3);
+    const vector<double>& nnlsAD = itrPlot->second.at(4);
+    const vector<double>& pulseAS = itrPlot->second.at(5);
+    const vector<double>& pulseAD = itrPlot->second.at(6);
+    const vector<double>& rawheight = itrPlot->second.at(7);
+    const vector<double>& positionErr = itrPlot->second.at(8);
+    const vector<double>& stripErr = itrPlot->second.at(9);
     for (int f=0; f<position.size();f++){
       if (BeamTime> 7.5 && BeamTime< 9.5){
         positionHistIn->Fill(position.at(f),stripNo);
@@ -393,6 +216,8 @@ vector<double> DISpulseHeight;
       DISposition.push_back(position.at(f));
       DISamp.push_back(height.at(f));
       DISarvTime.push_back(time.at(f));
+      DISpositionErr.push_back(positionErr.at(f));
+      DISstripErr.push_back(stripErr.at(f));
     }
     //fill the event display TCanvas
   }
@@ -404,6 +229,8 @@ for (int i=0;i<DISposition.size();i++){
         DISposition.erase(DISposition.begin()+i-a);
         DISamp.erase(DISamp.begin()+i-a);
         DISarvTime.erase(DISarvTime.begin()+i-a);
+        DISpositionErr.erase(DISpositionErr.begin()+i-a);
+        DISstripErr.erase(DISstripErr.begin()+i-a);
         a++;
     }
 }
@@ -412,7 +239,7 @@ double peak1, peak2;
 // insert the reconstructed positions to the map
 std::map<unsigned long,vector<double>> NNLSLocatedHitsMap;
 for(int i =0; i <DISposition.size();i++){
-  vector<double> info = {DISposition.at(i),DISstripNO.at(i),DISarvTime.at(i),-DISamp.at(i)};
+  vector<double> info = {DISposition.at(i),DISstripNO.at(i),DISarvTime.at(i),-DISamp.at(i),DISpositionErr.at(i),DISstripErr.at(i)};
   NNLSLocatedHitsMap.insert(pair<unsigned long,vector<double>>(i,info));
 
 }
@@ -622,63 +449,3 @@ bool LAPPDLocateHit::Finalise(){
   if(LAPPDLocateHitVerbosity>0) cout<<"LAPPD LocateHit has "<<AbnormalEvents<<" hits outside of the range"<<endl;
   return true;
 }
-
-double LAPPDLocateHit::MatchingProduct(double a, double b, double sigma){
-  double result = -1./sigma *exp(pow(a-b,2)/2/pow(sigma,2));
-  return result;
-}
-
-
-bool LAPPDLocateHit::FindlocalPeaks(Waveform<double> &wav,Waveform<double> &pwav, vector<double> &peakHeight, vector<int> &peakTimeLoc, vector<double> &peakArea ,vector<double> &pulseArea, vector<double> &pulseHeight, int strip, double lowT, double highT,int samplingFactor){
-  bool normal = true;
-  bool nonzero = false;
-  for (int i=3;i<(wav.GetSamples()->size())-3;i++){//ignore the first bin to avoid possible errorflags
-    //cout<<wav.GetSample(i)<<" at "<<i<<endl;
-    //cout<<i<<endl;
-    if(wav.GetSample(i)<wav.GetSample(i-1) && wav.GetSample(i)<wav.GetSample(i+1) && wav.GetSample(i)<wav.GetSample(i-2) && wav.GetSample(i)<wav.GetSample(i+2) && wav.GetSample(i)<lowT){  //less than lowT becaue the nnls output is negative
-      if (LAPPDLocateHitVerbosity > 2) cout<<"peak at "<<i<<endl;
-      peakHeight.push_back(wav.GetSample(i));
-      peakTimeLoc.push_back(i);
-      double Area=0.;
-
-      for (int j=i; j>3; j--){
-        if (wav.GetSample(j)>wav.GetSample(i) && wav.GetSample(j<0)) Area+=wav.GetSample(j);
-        if (wav.GetSample(j) == 0) break;
-      }
-      for (int j=i+1; j<(wav.GetSamples()->size())-3; j++){
-        if (wav.GetSample(j)>wav.GetSample(i) && wav.GetSample(j<0)) Area+=wav.GetSample(j);
-        if (wav.GetSample(j) == 0) break;
-      }
-      peakArea.push_back(Area);
-      //find pulse in raw data
-      double pArea;
-      int pIndex = (int) ((i*samplingFactor/1000)*10);
-      int pStart = pIndex;
-      int pEnd = pIndex;
-      for (int j = pIndex; j>3; j--){
-        if(pwav.GetSample(j)>-0.4) {
-          pStart = j;
-          break;}
-      }
-      for (int j =pIndex; j<pwav.GetSamples()->size(); j++){
-        if(pwav.GetSample(j)>-0.4) {
-          pEnd = j;
-          break;}
-      }
-      double pHeight = pwav.GetSample(pStart);
-      for (int j = pStart; j<pEnd; j++){
-        pArea+=pwav.GetSample(j);
-        if(pwav.GetSample(j)<pHeight) pHeight = pwav.GetSample(j);
-      }
-      pulseArea.push_back(pArea);
-      pulseHeight.push_back(pHeight);
-      nonzero = true;
-      if(wav.GetSample(i)< highT){  //less than highT becaue the nnls output is negative
-        normal=false;}
-    }
-  }
-  bool r = normal && nonzero;
-  //cout<<"peak height size in is "<<peakHeight.size()<<endl;
-
-  return r;
-}
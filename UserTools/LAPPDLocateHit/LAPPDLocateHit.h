@@ -20,11 +20,16 @@
 #include "TH3D.h"
 #include "TTree.h"
 
+#include "LocateEngine.h"
+
 
 /**
  * \class LAPPDLocateHit
  *
- * This is a blank template for a Tool used by the script to generate a new custom tool. Please fill out the description and author information.
+ * Locates hits on an LAPPD from the nnls deconvolved strip waveforms: the local
+ * peaks of both ends of every strip are paired by amplitude, and each pair gives
+ * a position along the strip (with its uncertainty) and an arrival time.
+ * The peak finding and pairing are done by lappdlocate::Locator.
 *
 * $Author: B.Richards $
 * $Date: 2019/05/28 10:44:00 $
@@ -39,9 +44,6 @@ class LAPPDLocateHit: public Tool {
   bool Initialise(std::string configfile,DataModel &data); ///< Initialise Function for setting up Tool resources. @param configfile The path and name of the dynamic configuration file to read in. @param data A reference to the transient data class used to pass information between Tools.
   bool Execute(); ///< Execute function used to perform Tool purpose.
   bool Finalise(); ///< Finalise function used to clean up resources.
-  bool FindlocalPeak();
-  bool FindlocalPeaks(Waveform<double> &wav,Waveform<double> &pwav, vector<double> &peakHeight, vector<int> &peakTimeLoc, vector<double> &peakArea ,vector<double> &pulseArea, vector<double> &pulseHeight, int strip, double lowT, double highT,int samplingFactor);
-  double MatchingProduct(double a, double b, double sigma);
 
  private:
    //TH3D *positionHist3D;
@@ -70,6 +72,9 @@ class LAPPDLocateHit: public Tool {
   string RawInputWavLabel;
   string DisplayPDFSuffix;
        Geometry* geom;
+       lappdlocate::Locator locator;
+       lappdlocate::Settings locateSettings;
+       std::vector<lappdlocate::Hit> locatedHits;
        int miter;
        double peakLowThreshold;
        double peakHighThreshold;
@@ -0,0 +1,233 @@
+#include "LocateEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void lappdlocate::Locator::clear(){
+  samples.clear();
+  rows.clear();
+  strip_rows.clear();
+  peaks.clear();
+}
+
+void lappdlocate::Locator::AddChannel(int strip, int side, const std::vector<double>& nnls, const std::vector<double>* raw){
+  if(strip<0 || side<0 || side>1) return;
+  Row row;
+  row.strip = strip;
+  row.side = side;
+  row.offset = samples.size();
+  row.length = nnls.size();
+  row.raw = raw;
+  samples.insert(samples.end(),nnls.begin(),nnls.end());
+  if((size_t)strip>=strip_rows.size()) strip_rows.resize(strip+1,std::array<long,2>{{-1,-1}});
+  // only the first waveform of each strip end is used
+  if(strip_rows[strip][side]<0) strip_rows[strip][side] = rows.size();
+  rows.push_back(row);
+}
+
+void lappdlocate::Locator::Locate(const Settings& settings, std::vector<Hit>& hits){
+  hits.clear();
+  FindPeaks(settings);
+  for(const std::array<long,2>& ends : strip_rows){
+    if(ends[0]<0 || ends[1]<0) continue;
+    const Row& row0 = rows[ends[0]];
+    const Row& row1 = rows[ends[1]];
+    // both ends need peaks, and neither may have an nnls failure (a peak below the high threshold)
+    if(!row0.normal || !row1.normal || row0.npeaks==0 || row1.npeaks==0) continue;
+    MatchStrip(row0,row1,settings,hits);
+  }
+}
+
+// Peaks are samples below the low threshold and below their two neighbours on
+// either side, away from the first and last 3 samples of a row.
+void lappdlocate::Locator::FindPeaks(const Settings& settings){
+
+  const size_t total = samples.size();
+  is_peak.assign(total,0);
+  const double* w = samples.data();
+  unsigned char* flag = is_peak.data();
+  const double low = settings.low_threshold;
+  // one branch-free pass over the whole matrix; flags near the row edges are ignored below
+  for(size_t k=2; k+2<total; ++k){
+    const double x = w[k];
+    flag[k] = (x<w[k-1]) & (x<w[k+1]) & (x<w[k-2]) & (x<w[k+2]) & (x<low);
+  }
+
+  peaks.clear();
+  for(Row& row : rows){
+    row.first_peak = peaks.size();
+    row.normal = true;
+    const double* rw = w + row.offset;
+    const unsigned char* rflag = flag + row.offset;
+    // nnls output is zero between pulses: the area of a peak is the sum of its zero-bounded region
+    size_t region_first_peak = peaks.size();
+    double region_area = 0;
+    for(size_t i=3; i+3<row.length; ++i){
+      const double x = rw[i];
+      if(x==0.){
+        for(size_t ipeak=region_first_peak; ipeak<peaks.size(); ++ipeak) peaks[ipeak].area = region_area;
+        region_first_peak = peaks.size();
+        region_area = 0;
+        continue;
+      }
+      if(x<0.) region_area += x;
+      if(rflag[i]){
+        Peak peak;
+        peak.sample = i;
+        peak.height = x;
+        RawPulse(row,settings,peak);
+        if(x<settings.high_threshold) row.normal = false;
+        peaks.push_back(peak);
+      }
+    }
+    for(size_t ipeak=region_first_peak; ipeak<peaks.size(); ++ipeak) peaks[ipeak].area = region_area;
+    row.npeaks = peaks.size() - row.first_peak;
+  }
+}
+
+// The raw pulse around the peak: the samples below -0.4 that contain its time
+void lappdlocate::Locator::RawPulse(const Row& row, const Settings& settings, Peak& peak) const {
+  if(row.raw==nullptr || row.raw->empty()) return;
+  const std::vector<double>& raw = *row.raw;
+  long n = raw.size();
+  long index = (long)(peak.sample*settings.time_step/settings.raw_sample);
+  if(index>=n) return;
+  long start = index, end = index;
+  for(long j=index; j>3; --j){
+    if(raw[j]>-0.4){ start = j; break; }
+  }
+  for(long j=index; j<n; ++j){
+    if(raw[j]>-0.4){ end = j; break; }
+  }
+  double area = 0;
+  double height = raw[start];
+  for(long j=start; j<end; ++j){
+    area += raw[j];
+    height = std::min(height,raw[j]);
+  }
+  peak.pulse_area = area;
+  peak.pulse_height = height;
+}
+
+void lappdlocate::Locator::MatchStrip(const Row& row0, const Row& row1, const Settings& settings, std::vector<Hit>& hits){
+
+  const Peak* peaks0 = peaks.data() + row0.first_peak;
+  const Peak* peaks1 = peaks.data() + row1.first_peak;
+  const double step_ns = settings.time_step/1000.;
+  const double max_delay = (settings.max_delay<0) ? settings.strip_length/settings.signal_speed : settings.max_delay;
+
+  // a pulse can't reach the two ends further apart than the strip is long:
+  // only the peaks with a partner within max_delay take part
+  auto Feasible = [&](int i0, int i1){
+    return std::fabs((peaks0[i0].sample - peaks1[i1].sample)*step_ns) <= max_delay;
+  };
+  cand0.clear();
+  cand1.clear();
+  for(size_t i0=0; i0<row0.npeaks; ++i0){
+    for(size_t i1=0; i1<row1.npeaks; ++i1){
+      if(Feasible(i0,i1)){ cand0.push_back(i0); break; }
+    }
+  }
+  for(size_t i1=0; i1<row1.npeaks; ++i1){
+    for(int i0 : cand0){
+      if(Feasible(i0,i1)){ cand1.push_back(i1); break; }
+    }
+  }
+  if(cand0.empty() || cand1.empty()) return;
+
+  // the cost of a pair is how badly the amplitudes of the two ends agree.
+  // Infeasible pairs cost more than all feasible ones together, so the
+  // assignment first pairs as many peaks as it can.
+  bool transpose = cand0.size()>cand1.size();
+  const std::vector<int>& rowcand = transpose ? cand1 : cand0;
+  const std::vector<int>& colcand = transpose ? cand0 : cand1;
+  int n = rowcand.size(), m = colcand.size();
+  cost.assign((size_t)n*m,0.);
+  double feasible_sum = 0;
+  for(int r=0; r<n; ++r){
+    for(int c=0; c<m; ++c){
+      int i0 = transpose ? colcand[c] : rowcand[r];
+      int i1 = transpose ? rowcand[r] : colcand[c];
+      if(!Feasible(i0,i1)){ cost[r*m+c] = -1; continue; }
+      double d = (peaks0[i0].height - peaks1[i1].height)/settings.sigma;
+      cost[r*m+c] = std::exp(std::min(0.5*d*d,50.))/settings.sigma;
+      feasible_sum += cost[r*m+c];
+    }
+  }
+  for(double& c : cost) if(c<0) c = 1. + 2.*feasible_sum;
+  Assign(cost,n,m,match);
+
+  // partner of each side 0 peak, so the hits come out in side 0 order
+  partner.assign(row0.npeaks,-1);
+  for(int r=0; r<n; ++r){
+    int c = match[r];
+    if(c<0) continue;
+    int i0 = transpose ? colcand[c] : rowcand[r];
+    int i1 = transpose ? rowcand[r] : colcand[c];
+    if(Feasible(i0,i1)) partner[i0] = i1;
+  }
+
+  const double sigma_dt = step_ns/std::sqrt(6.);   // two independent sample quantisations
+  for(size_t i0=0; i0<row0.npeaks; ++i0){
+    if(partner[i0]<0) continue;
+    const Peak& p0 = peaks0[i0];
+    const Peak& p1 = peaks1[partner[i0]];
+    Hit hit;
+    hit.strip = row0.strip;
+    double dt = (p0.sample - p1.sample)*step_ns;
+    hit.parallel = (dt*settings.signal_speed + settings.strip_length)/2*100;
+    hit.parallel_error = settings.signal_speed*sigma_dt/2*100;
+    hit.transverse = row0.strip;
+    hit.transverse_error = 1./std::sqrt(12.);
+    hit.time = (p0.sample + p1.sample)/2.*step_ns - 0.5;
+    hit.height = p0.height + p1.height;
+    hit.nnls_area_sum = p0.area + p1.area;
+    hit.nnls_area_diff = p0.area - p1.area;
+    hit.pulse_area_sum = p0.pulse_area + p1.pulse_area;
+    hit.pulse_area_diff = p0.pulse_area - p1.pulse_area;
+    hit.pulse_height = p0.pulse_height + p1.pulse_height;
+    hits.push_back(hit);
+  }
+}
+
+// Hungarian algorithm with row and column potentials, O(n^2 m)
+void lappdlocate::Locator::Assign(const std::vector<double>& cost_in, int n, int m, std::vector<int>& row_to_col){
+
+  const double inf = std::numeric_limits<double>::infinity();
+  u.assign(n+1,0.);
+  v.assign(m+1,0.);
+  p.assign(m+1,0);
+  way.assign(m+1,0);
+  for(int i=1; i<=n; ++i){
+    p[0] = i;
+    int j0 = 0;
+    minv.assign(m+1,inf);
+    used.assign(m+1,0);
+    do{
+      used[j0] = 1;
+      int i0 = p[j0], j1 = 0;
+      double delta = inf;
+      for(int j=1; j<=m; ++j){
+        if(used[j]) continue;
+        double cur = cost_in[(size_t)(i0-1)*m + (j-1)] - u[i0] - v[j];
+        if(cur<minv[j]){ minv[j] = cur; way[j] = j0; }
+        if(minv[j]<delta){ delta = minv[j]; j1 = j; }
+      }
+      for(int j=0; j<=m; ++j){
+        if(used[j]){ u[p[j]] += delta; v[j] -= delta; }
+        else minv[j] -= delta;
+      }
+      j0 = j1;
+    } while(p[j0]!=0);
+    do{
+      int j1 = way[j0];
+      p[j0] = p[j1];
+      j0 = j1;
+    } while(j0);
+  }
+  row_to_col.assign(n,-1);
+  for(int j=1; j<=m; ++j){
+    if(p[j]) row_to_col[p[j]-1] = j-1;
+  }
+}
@@ -0,0 +1,92 @@
+#ifndef LocateEngine_H
+#define LocateEngine_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Hit localisation on the nnls deconvolved strip waveforms of one LAPPD event.
+// All waveforms are copied into one contiguous sample matrix, the local peaks
+// of every row are flagged in a single branch-free pass over it, and the peaks
+// at the two ends of each strip are paired by solving an assignment problem.
+namespace lappdlocate {
+
+  struct Settings {
+    double low_threshold = -0.3;    // a peak must be below this (nnls output is negative)
+    double high_threshold = -10.;   // a waveform with a peak below this is not used
+    double time_step = 20.;         // ps per nnls sample
+    double raw_sample = 100.;       // ps per raw sample
+    double sigma = 0.1;             // amplitude matching width
+    double strip_length = 0.2;      // m
+    double signal_speed = 0.2;      // m/ns
+    double max_delay = -1.;         // ns, largest time difference of the two ends; <0: strip_length/signal_speed
+  };
+
+  struct Peak {
+    int sample = 0;                 // nnls sample of the peak
+    double height = 0;
+    double area = 0;                // nnls samples between the zeros either side of the peak
+    double pulse_area = 0;          // raw pulse containing the peak
+    double pulse_height = 0;
+  };
+
+  // A pair of matched peaks. The parallel position is along the strip in cm,
+  // from the side 0 end; the transverse position is the strip number. Errors
+  // are the RMS of the sample quantisation (time) and of the strip width.
+  struct Hit {
+    int strip = 0;
+    double parallel = 0, parallel_error = 0;
+    double transverse = 0, transverse_error = 0;
+    double time = 0;                // ns
+    double height = 0;              // sum of the two nnls peak heights
+    double nnls_area_sum = 0, nnls_area_diff = 0;
+    double pulse_area_sum = 0, pulse_area_diff = 0;
+    double pulse_height = 0;        // sum of the two raw pulse heights
+  };
+
+  class Locator {
+
+   public:
+
+    void clear();
+    // one row of the sample matrix; raw is the undeconvolved waveform of the
+    // same channel, which must stay alive until Locate has been called
+    void AddChannel(int strip, int side, const std::vector<double>& nnls, const std::vector<double>* raw);
+    // hits in order of strip number, and of the side 0 peak on each strip
+    void Locate(const Settings& settings, std::vector<Hit>& hits);
+
+    size_t NumPeaks() const { return peaks.size(); }
+
+   private:
+
+    struct Row {
+      int strip, side;
+      size_t offset, length;
+      const std::vector<double>* raw;
+      size_t first_peak = 0, npeaks = 0;
+      bool normal = true;           // no peak below the high threshold
+    };
+
+    void FindPeaks(const Settings& settings);
+    void RawPulse(const Row& row, const Settings& settings, Peak& peak) const;
+    void MatchStrip(const Row& row0, const Row& row1, const Settings& settings, std::vector<Hit>& hits);
+    // min cost assignment of each of n rows to a different one of m>=n columns
+    void Assign(const std::vector<double>& cost, int n, int m, std::vector<int>& row_to_col);
+
+    std::vector<double> samples;               // rows back to back
+    std::vector<unsigned char> is_peak;        // same layout as samples
+    std::vector<Row> rows;
+    std::vector<std::array<long,2>> strip_rows; // strip number -> row of side 0 and side 1
+    std::vector<Peak> peaks;
+
+    // assignment scratch
+    std::vector<int> cand0, cand1, match, partner;
+    std::vector<double> cost, u, v, minv;
+    std::vector<int> p, way;
+    std::vector<unsigned char> used;
+
+  };
+
+}
+
+#endif
@@ -1,4 +1,7 @@
 #include "LAPPDMakePeds.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDMakePeds);
 
 LAPPDMakePeds::LAPPDMakePeds():Tool(){}
 
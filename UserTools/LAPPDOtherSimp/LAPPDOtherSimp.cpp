@@ -1,4 +1,7 @@
 #include "LAPPDOtherSimp.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDOtherSimp);
 
 LAPPDOtherSimp::LAPPDOtherSimp():Tool(){}
 
@@ -1,7 +1,10 @@
 #include "LAPPDParseACC.h"
+#include "ToolRegistry.h"
 #include "Geometry.h"
 
 
+REGISTER_TOOL(LAPPDParseACC);
+
 LAPPDParseACC::LAPPDParseACC():Tool(){}
 
 using namespace std;
@@ -1,7 +1,10 @@
 #include "LAPPDParseScope.h"
+#include "ToolRegistry.h"
 #include <stdlib.h>
 #include <TF1.h>
 
+REGISTER_TOOL(LAPPDParseScope);
+
 LAPPDParseScope::LAPPDParseScope():Tool(){}
 
 
@@ -1,4 +1,7 @@
 #include "LAPPDPlotWaveForms.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDPlotWaveForms);
 
 LAPPDPlotWaveForms::LAPPDPlotWaveForms():Tool(){}
 
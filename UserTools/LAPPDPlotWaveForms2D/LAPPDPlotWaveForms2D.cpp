@@ -1,4 +1,7 @@
 #include "LAPPDPlotWaveForms2D.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDPlotWaveForms2D);
 
 LAPPDPlotWaveForms2D::LAPPDPlotWaveForms2D():Tool(){}
 
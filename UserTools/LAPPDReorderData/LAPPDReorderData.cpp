@@ -1,4 +1,7 @@
 #include "LAPPDReorderData.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDReorderData);
 
 LAPPDReorderData::LAPPDReorderData():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "LAPPDSaveROOT.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDSaveROOT);
 
 LAPPDSaveROOT::LAPPDSaveROOT():Tool(){}
 
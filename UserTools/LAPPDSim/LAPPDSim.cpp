@@ -1,6 +1,9 @@
 #include "LAPPDSim.h"
+#include "ToolRegistry.h"
 #include <unistd.h>
 
+REGISTER_TOOL(LAPPDSim);
+
 LAPPDSim::LAPPDSim():Tool(),myTR(nullptr),_tf(nullptr),_event_counter(0),_file_number(0),_display_config(0),_is_artificial(false),_display(nullptr),_geom(nullptr),LAPPDWaveforms(nullptr)
 {
 }
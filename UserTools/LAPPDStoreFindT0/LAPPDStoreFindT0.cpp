@@ -1,6 +1,9 @@
 #include "LAPPDStoreFindT0.h"
+#include "ToolRegistry.h"
 #include "TGraph.h"
 
+REGISTER_TOOL(LAPPDStoreFindT0);
+
 LAPPDStoreFindT0::LAPPDStoreFindT0():Tool(){}
 
 
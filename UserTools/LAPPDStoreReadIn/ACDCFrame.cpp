@@ -0,0 +1,209 @@
+#include "ACDCFrame.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+  const char cache_magic[8] = {'A','C','D','C','P','E','D','1'};
+
+  std::string AtWord(size_t index){
+    return " at word "+std::to_string(index);
+  }
+
+}
+
+bool acdc::FrameView::Parse(const unsigned short* words, size_t nwords){
+
+  error.clear();
+  size_t pos = 0;
+  for(int chip=0; chip<kChips; ++chip){
+    while(pos<nwords && words[pos]!=kDataStart) ++pos;
+    if(pos==nwords){
+      error = "no data start marker for PSEC chip "+std::to_string(chip);
+      return false;
+    }
+    // samples are 12 bit ADC counts, so can never be mistaken for a marker
+    size_t data = pos+1;
+    size_t meta = data + kChannelsPerChip*kSamples;
+    size_t end = meta + 1 + kInfoWords;
+    if(end>=nwords || words[meta]!=kMetaStart){
+      error = "PSEC chip "+std::to_string(chip)+" has no metadata start marker after its samples"+AtWord(meta);
+      return false;
+    }
+    if(words[end]!=kMetaEnd){
+      error = "PSEC chip "+std::to_string(chip)+" has no metadata end marker"+AtWord(end);
+      return false;
+    }
+    chip_data[chip] = words + data;
+    chip_info[chip] = words + meta + 1;
+    pos = end + 1;
+  }
+
+  if(pos + kChannels >= nwords){
+    error = "frame of "+std::to_string(nwords)+" words ends before the trigger information";
+    return false;
+  }
+  trigger = words + pos;
+  combined_trigger = words[pos + kChannels];
+  return true;
+}
+
+void acdc::FrameView::AppendMeta(int board, std::vector<unsigned short>& meta) const {
+  meta.push_back(board);
+  for(int chip=0; chip<kChips; ++chip){
+    meta.push_back(0xDCB0 | chip);
+    meta.insert(meta.end(),Info(chip),Info(chip)+kInfoWords);
+    meta.insert(meta.end(),Trigger(chip),Trigger(chip)+kChannelsPerChip);
+  }
+  meta.push_back(combined_trigger);
+  meta.push_back(0xeeee);
+}
+
+void acdc::PedestalTable::Resize(int nboards_in){
+  nboards = nboards_in;
+  values.assign((size_t)nboards*kChannels*kSamples,0);
+}
+
+void acdc::PedestalTable::FromMap(const std::map<unsigned long, std::vector<int>>& peds){
+  int nboards_in = 0;
+  for(const auto& channel : peds) nboards_in = std::max(nboards_in,(int)(channel.first/kChannels)+1);
+  Resize(nboards_in);
+  for(const auto& channel : peds){
+    int* ped = values.data() + (size_t)channel.first*kSamples;
+    size_t n = std::min(channel.second.size(),(size_t)kSamples);
+    std::copy(channel.second.begin(),channel.second.begin()+n,ped);
+  }
+}
+
+bool acdc::PedestalTable::LoadText(const std::string& prefix, int nboards_in, const std::string& cachefile,
+                                   bool& from_cache, std::string& error){
+
+  std::vector<FileStamp> stamps(nboards_in);
+  for(int board=0; board<nboards_in; ++board){
+    struct stat st;
+    std::string filename = prefix + std::to_string(board) + ".txt";
+    if(stat(filename.c_str(),&st)==0){
+      stamps[board].size = st.st_size;
+      stamps[board].mtime = st.st_mtime;
+    }
+  }
+
+  from_cache = !cachefile.empty() && ReadCache(cachefile,stamps);
+  if(from_cache) return true;
+
+  Resize(nboards_in);
+  for(int board=0; board<nboards; ++board){
+    if(!ReadText(board,prefix + std::to_string(board) + ".txt",error)) return false;
+  }
+  if(!cachefile.empty() && !WriteCache(cachefile,stamps)){
+    error = "could not write the pedestal cache "+cachefile;
+  }
+  return true;
+}
+
+bool acdc::PedestalTable::ReadText(int board, const std::string& filename, std::string& error){
+
+  std::ifstream in(filename,std::ios::binary);
+  if(!in.is_open()){
+    error = "Failed to open "+filename+"!";
+    return false;
+  }
+  std::string text((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+
+  int* ped = values.data() + (size_t)board*kChannels*kSamples;
+  const char* p = text.c_str();
+  int sample = 0;
+  // one line per sample, columns are the channels of the board
+  for(; *p!='\0' && sample<kSamples; ++sample){
+    int channel = 0;
+    while(true){
+      while(*p==' ' || *p=='\t' || *p=='\r') ++p;
+      if(*p=='\n' || *p=='\0') break;
+      char* end;
+      long value = strtol(p,&end,10);
+      if(end==p){
+        error = filename+": not a number on line "+std::to_string(sample+1);
+        return false;
+      }
+      if(channel<kChannels) ped[channel*kSamples+sample] = value;
+      ++channel;
+      p = end;
+    }
+    if(*p=='\n') ++p;
+    if(channel<kChannels){
+      error = filename+": "+std::to_string(channel)+" pedestals on line "+std::to_string(sample+1)
+              +", expected "+std::to_string(kChannels);
+      return false;
+    }
+  }
+  if(sample<kSamples){
+    error = filename+": "+std::to_string(sample)+" samples, expected "+std::to_string(kSamples);
+    return false;
+  }
+  return true;
+}
+
+bool acdc::PedestalTable::ReadCache(const std::string& cachefile, const std::vector<FileStamp>& stamps){
+
+  std::ifstream in(cachefile,std::ios::binary);
+  if(!in.is_open()) return false;
+
+  char magic[sizeof(cache_magic)];
+  int32_t shape[3];
+  in.read(magic,sizeof(magic));
+  in.read(reinterpret_cast<char*>(shape),sizeof(shape));
+  if(!in || memcmp(magic,cache_magic,sizeof(magic))!=0) return false;
+  if(shape[0]!=(int32_t)stamps.size() || shape[1]!=kChannels || shape[2]!=kSamples) return false;
+
+  for(const FileStamp& stamp : stamps){
+    int64_t cached[2];
+    in.read(reinterpret_cast<char*>(cached),sizeof(cached));
+    if(!in || stamp.size<0 || cached[0]!=stamp.size || cached[1]!=stamp.mtime) return false;
+  }
+
+  std::vector<int32_t> cached_values((size_t)stamps.size()*kChannels*kSamples);
+  in.read(reinterpret_cast<char*>(cached_values.data()),cached_values.size()*sizeof(int32_t));
+  if(!in) return false;
+
+  nboards = stamps.size();
+  values.assign(cached_values.begin(),cached_values.end());
+  return true;
+}
+
+bool acdc::PedestalTable::WriteCache(const std::string& cachefile, const std::vector<FileStamp>& stamps) const {
+
+  // write to a temporary and rename, so a reader never sees half a cache;
+  // the pid keeps jobs sharing the cache directory out of each other's file
+  std::string tmpfile = cachefile + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream out(tmpfile,std::ios::binary|std::ios::trunc);
+    if(!out.is_open()) return false;
+    int32_t shape[3] = {(int32_t)nboards,kChannels,kSamples};
+    out.write(cache_magic,sizeof(cache_magic));
+    out.write(reinterpret_cast<const char*>(shape),sizeof(shape));
+    for(const FileStamp& stamp : stamps){
+      int64_t cached[2] = {stamp.size,stamp.mtime};
+      out.write(reinterpret_cast<const char*>(cached),sizeof(cached));
+    }
+    std::vector<int32_t> cached_values(values.begin(),values.end());
+    out.write(reinterpret_cast<const char*>(cached_values.data()),cached_values.size()*sizeof(int32_t));
+    out.close();
+    if(!out){
+      std::remove(tmpfile.c_str());
+      return false;
+    }
+  }
+  if(rename(tmpfile.c_str(),cachefile.c_str())!=0){
+    std::remove(tmpfile.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,99 @@
+#ifndef ACDCFrame_H
+#define ACDCFrame_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// Readout of one ACDC board, as held in PsecData::RawWaveform, and the
+// pedestals to subtract from it.
+//
+// A data frame holds, for each of the 5 PSEC chips: 0xF005, 6 channels x 256
+// samples, 0xBA11, 13 info words, 0xFACE. After the last chip come 6 trigger
+// words per chip and the combined trigger rate count.
+namespace acdc {
+
+  const int kChips = 5;
+  const int kChannels = 30;
+  const int kChannelsPerChip = kChannels/kChips;
+  const int kSamples = 256;
+  const int kInfoWords = 13;
+
+  const unsigned short kDataStart = 0xF005;
+  const unsigned short kMetaStart = 0xBA11;
+  const unsigned short kMetaEnd = 0xFACE;
+
+  // Read-only view of a data frame. Parse finds each chip by its marker words
+  // and checks that the blocks between them have the expected lengths. Nothing
+  // is copied, so the buffer must outlive the view.
+  class FrameView {
+
+   public:
+
+    // false, with Error() set, if the frame does not have the layout above
+    bool Parse(const unsigned short* words, size_t nwords);
+    const std::string& Error() const { return error; }
+
+    // kSamples ADC counts of each channel 0..kChannels-1. The kChannelsPerChip
+    // channels of a chip are contiguous.
+    const unsigned short* Samples(int channel) const {
+      return chip_data[channel/kChannelsPerChip] + (channel%kChannelsPerChip)*kSamples;
+    }
+    const unsigned short* Info(int chip) const { return chip_info[chip]; }
+    const unsigned short* Trigger(int chip) const { return trigger + chip*kChannelsPerChip; }
+    unsigned short CombinedTrigger() const { return combined_trigger; }
+
+    // Appends the ACDCmetadata block of this board: the board id, then per chip
+    // 0xDCB0|chip, its info and trigger words, then the combined trigger and 0xEEEE
+    void AppendMeta(int board, std::vector<unsigned short>& meta) const;
+
+   private:
+
+    const unsigned short* chip_data[kChips] = {};
+    const unsigned short* chip_info[kChips] = {};
+    const unsigned short* trigger = nullptr;
+    unsigned short combined_trigger = 0;
+    std::string error;
+
+  };
+
+  // Pedestals of all boards in one dense [board][channel][sample] array
+  class PedestalTable {
+
+   public:
+
+    int NumBoards() const { return nboards; }
+    bool Empty() const { return nboards==0; }
+    const int* Board(int board) const { return values.data() + (size_t)board*kChannels*kSamples; }
+
+    // Reads <prefix><board>.txt for boards 0..nboards-1 (one line per sample,
+    // one column per channel). They are cached in cachefile, which is used
+    // instead as long as the size and modification time of every text file
+    // match the ones it was made from, and rewritten otherwise. If only the
+    // cache could not be written, error is set but true is returned.
+    bool LoadText(const std::string& prefix, int nboards, const std::string& cachefile,
+                  bool& from_cache, std::string& error);
+    // from the channel-keyed map of a pedestal BoostStore, channel = board*kChannels + channel on board
+    void FromMap(const std::map<unsigned long, std::vector<int>>& peds);
+
+   private:
+
+    struct FileStamp {
+      long long size = -1;
+      long long mtime = -1;
+    };
+
+    void Resize(int nboards);
+    bool ReadText(int board, const std::string& filename, std::string& error);
+    bool ReadCache(const std::string& cachefile, const std::vector<FileStamp>& stamps);
+    bool WriteCache(const std::string& cachefile, const std::vector<FileStamp>& stamps) const;
+
+    int nboards = 0;
+    std::vector<int> values;
+
+  };
+
+}
+
+#endif
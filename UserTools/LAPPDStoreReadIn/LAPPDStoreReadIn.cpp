@@ -1,6 +1,9 @@
 #include "LAPPDStoreReadIn.h"
+#include "ToolRegistry.h"
 #include "PsecData.h"
 
+REGISTER_TOOL(LAPPDStoreReadIn);
+
 LAPPDStoreReadIn::LAPPDStoreReadIn():Tool(){}
 
 
@@ -60,8 +63,7 @@ bool LAPPDStoreReadIn::Initialise(std::string configfile, DataModel &data){
     bool isCFD=false;
     m_data->Stores["ANNIEEvent"]->Set("isCFD",isCFD);
 
-    //Grab all pedestal files and prepare the map channel|pedestal-vector for substraction
-    PedestalValues = new std::map<unsigned long, vector<int>>;
+    //Grab all pedestal files and prepare the dense board|channel|sample pedestal table for substraction
     m_variables.Get("DoPedSubtraction", DoPedSubtract);
     m_variables.Get("Nboards", Nboards);
     m_variables.Get("Pedinputfile",PedFileName);
@@ -81,17 +83,23 @@ bool LAPPDStoreReadIn::Initialise(std::string configfile, DataModel &data){
             long Pedentries;
             m_data->Stores["PedestalFile"]->Header->Get("TotalEntries",Pedentries);
             if(LAPPDStoreReadInVerbosity>0) cout << PedFileName << " got " << Pedentries << endl;
+            std::map<unsigned long, vector<int>> *PedestalValues = nullptr;
             m_data->Stores["PedestalFile"]->Get("PedestalMap",PedestalValues);
+            if(PedestalValues!=nullptr) Pedestals.FromMap(*PedestalValues);
         }else
         {
             m_variables.Get("PedinputfileTXT", PedFileNameTXT);
-            for(int i=0; i<Nboards; i++)
-            {
-                ReadPedestals(i);
-            }
+            PedCacheFile = PedFileNameTXT + "_cache.bin";
+            m_variables.Get("PedCacheFile", PedCacheFile);
+            if(!ReadPedestals()) return false;
+        }
+        if(Pedestals.Empty())
+        {
+            cout << "No pedestals were loaded, but DoPedSubtraction is set!" << endl;
+            return false;
         }
     }
-    if(DoPedSubtract==1 && LAPPDStoreReadInVerbosity>1) cout<<"PEDSIZES: "<<PedestalValues->size()<<" "<<PedestalValues->at(0).size()<<" "<<PedestalValues->at(4).at(5)<<endl;
+    if(DoPedSubtract==1 && LAPPDStoreReadInVerbosity>1) cout<<"PEDSIZES: "<<Pedestals.NumBoards()<<" "<<acdc::kChannels<<" "<<acdc::kSamples<<endl;
 
     //parameters (potentially) used by the whole ToolChain
     m_variables.Get("Nsamples", Nsamples);
@@ -127,16 +135,14 @@ bool LAPPDStoreReadIn::Execute(){
     if(LAPPDStoreReadInVerbosity>2) cout << "Got entry " << i_entry << endl;
 
     ReadBoards = dat.BoardIndex;
-    Raw_buffer = dat.RawWaveform;
-
-    /*
-    cout<<InputWavLabel<<" "<<BoardIndexLabel<<endl;
-    bool test1 = m_data->Stores["LAPPDData"]->Get(InputWavLabel,Raw_buffer);
-    bool test2 = m_data->Stores["LAPPDData"]->Get(BoardIndexLabel,ReadBoards);
-    cout<<"find em?"<<test1<<" "<<test2<<" "<<BoardIndex.size()<<endl;
-*/
+    const std::vector<unsigned short>& Raw_buffer = dat.RawWaveform;
 
     if(LAPPDStoreReadInVerbosity>2) cout << "Number of boards was " << ReadBoards.size() << endl;
+    if(ReadBoards.empty())
+    {
+        cout << "Entry " << i_entry << " has no ACDC boards!" << endl;
+        return false;
+    }
 
     int frametype = Raw_buffer.size()/ReadBoards.size();
     //cout<<"FRAMETYPE: "<<frametype<<endl;
@@ -185,68 +191,57 @@ bool LAPPDStoreReadIn::Execute(){
         }
     }
 
+    if(LAPPDStoreReadInVerbosity>0) cout<<"BEGIN LAPPDStoreReadIn "<< endl;
+
+    std::map<unsigned long, vector<Waveform<double>>> LAPPDWaveforms;
     for(int bi: ParaBoards)
     {
-        Parse_buffer.clear();
-        if(LAPPDStoreReadInVerbosity>2) std::cout << "Starting with board " << ReadBoards[bi] << std::endl;
-        //Go over all ACDC board data frames by seperating them
-        for(int c=bi*frametype; c<(bi+1)*frametype; c++)
+        //each ACDC board data frame is a frametype long slice of the raw buffer
+        if((size_t)(bi+1)*frametype>Raw_buffer.size() || bi>=nbi)
         {
-            Parse_buffer.push_back(Raw_buffer[c]);
+            cout << "There is no data frame " << bi << " in a buffer of " << nbi << " boards!" << endl;
+            return false;
         }
-        if(LAPPDStoreReadInVerbosity>2) std::cout << "Data for board " << ReadBoards[bi] << " was grabbed!" << std::endl;
-
+        int board = ReadBoards[bi];
+        if(LAPPDStoreReadInVerbosity>2) std::cout << "Starting with board " << board << std::endl;
+        if(!frame.Parse(Raw_buffer.data() + (size_t)bi*frametype, frametype))
+        {
+            std::cout << "Parsing went wrong for board " << board << ": " << frame.Error() << endl;
+            return false;
+        }
+        if(LAPPDStoreReadInVerbosity>2) std::cout << "Data for board " << board << " was parsed!" << std::endl;
+        frame.AppendMeta(board,meta);
 
-        //Grab the parsed data and give it to a global variable 'data'
-        retval = getParsedData(Parse_buffer,ReadBoards[bi]*NUM_CH);
-        if(retval == 0)
+        const int* boardpeds = nullptr;
+        if(DoPedSubtract==1)
         {
-            if(LAPPDStoreReadInVerbosity>2) std::cout << "Data for board " << ReadBoards[bi] << " was parsed!" << std::endl;
-            //Grab the parsed metadata and give it to a global variable 'meta'
-            retval = getParsedMeta(Parse_buffer,ReadBoards[bi]);
-            if(retval!=0)
+            if(board<0 || board>=Pedestals.NumBoards())
             {
-                std::cout << "Meta parsing went wrong! " << retval << endl;
-            }else
-            {
-                if(LAPPDStoreReadInVerbosity>2) std::cout << "Meta for board " << ReadBoards[bi] << " was parsed!" << std::endl;
+                cout << "There are no pedestals for board " << board << "!" << endl;
+                return false;
             }
-        }else
-        {
-            std::cout << "Parsing went wrong! " << retval << endl;
-            return false;
+            boardpeds = Pedestals.Board(board);
         }
-    }
-
-    if(LAPPDStoreReadInVerbosity>0) cout<<"BEGIN LAPPDStoreReadIn "<< endl;
 
-    std::map<unsigned long, vector<Waveform<double>>> LAPPDWaveforms;
-    Waveform<double> tmpWave;
-    vector<Waveform<double>> VecTmpWave;
-    int pedval,val;
-    //Loop over data stream
-    for(std::map<int, vector<unsigned short>>::iterator it=data.begin(); it!=data.end(); ++it)
-    {
-        for(int kvec=0; kvec<it->second.size(); kvec++)
+        //one pass over the samples of the board, channel by channel
+        for(int ch=0; ch<acdc::kChannels; ch++)
         {
-            if(DoPedSubtract==1)
+            vector<Waveform<double>>& VecTmpWave = LAPPDWaveforms[(unsigned long)(board*acdc::kChannels + ch)];
+            VecTmpWave.resize(1);
+            std::vector<double>& samples = *VecTmpWave[0].GetSamples();
+            samples.resize(acdc::kSamples);
+            const unsigned short* adc = frame.Samples(ch);
+            if(boardpeds!=nullptr)
             {
-                pedval = ((PedestalValues->find(it->first))->second).at(kvec);
+                const int* peds = boardpeds + ch*acdc::kSamples;
+                for(int kvec=0; kvec<acdc::kSamples; kvec++) samples[kvec] = 0.3*(double)((int)adc[kvec]-peds[kvec]);
             }else
             {
-                pedval = 0;
+                for(int kvec=0; kvec<acdc::kSamples; kvec++) samples[kvec] = 0.3*(double)adc[kvec];
             }
-            val = it->second.at(kvec);
-            tmpWave.PushSample(0.3*(double)(val-pedval));
         }
-        VecTmpWave.push_back(tmpWave);
-        LAPPDWaveforms.insert(pair<unsigned long, vector<Waveform<double>>>((unsigned long)it->first,VecTmpWave));
-        tmpWave.ClearSamples();
-        VecTmpWave.clear();
     }
 
-
-
     if(LAPPDStoreReadInVerbosity>0) cout<<"*************************END LAPPDStoreReadIn************************************"<<endl;
 
     m_data->Stores["ANNIEEvent"]->Set(OutputWavLabel,LAPPDWaveforms);
@@ -255,11 +250,7 @@ bool LAPPDStoreReadIn::Execute(){
     m_data->Stores["ANNIEEvent"]->Set("TriggerChannelBase",TrigChannel);
 
     meta.clear();
-    LAPPDWaveforms.clear();
-    data.clear();
-    Raw_buffer.clear();
     ReadBoards.clear();
-    Parse_buffer.clear();
 
     eventNo++;
     return true;
@@ -273,73 +264,24 @@ bool LAPPDStoreReadIn::Finalise(){
 }
 
 
-bool LAPPDStoreReadIn::ReadPedestals(int boardNo){
+bool LAPPDStoreReadIn::ReadPedestals(){
 
-    if(LAPPDStoreReadInVerbosity>0) cout<<"Getting Pedestals "<<boardNo<<endl;
+    if(LAPPDStoreReadInVerbosity>0) cout<<"Getting Pedestals of "<<Nboards<<" boards"<<endl;
 
-    std::string LoadName = PedFileNameTXT;
-    string nextLine; //temp line to parse
-    double finalsampleNo;
-    std::string ext = std::to_string(boardNo);
-    ext += ".txt";
-    LoadName += ext;
-    PedFile.open(LoadName);
-    if(!PedFile.is_open())
+    bool from_cache = false;
+    std::string error;
+    if(!Pedestals.LoadText(PedFileNameTXT, Nboards, PedCacheFile, from_cache, error))
     {
-        cout<<"Failed to open "<<LoadName<<"!"<<endl;
+        cout<<error<<endl;
         return false;
     }
-    if(LAPPDStoreReadInVerbosity>0) cout<<"Opened file: "<<LoadName<<endl;
-
-    int sampleNo=0; //sample number
-    while(getline(PedFile, nextLine))
+    if(!error.empty()) cout<<"Warning: "<<error<<endl;
+    if(LAPPDStoreReadInVerbosity>0)
     {
-        istringstream iss(nextLine); //copies the current line in the file
-        int location=-1; //counts the current perameter in the line
-        string stempValue; //current string in the line
-        int tempValue; //current int in the line
-
-        unsigned long channelNo=boardNo*30; //channel number
-        //cout<<"NEW BOARD "<<channelNo<<" "<<sampleNo<<endl;
-
-        //starts the loop at the beginning of the line
-        while(iss >> stempValue)
-        {
-            location++;
-
-            int tempValue = stoi(stempValue, 0, 10);
-
-            if(sampleNo==0){
-                vector<int> tempPed;
-                tempPed.push_back(tempValue);
-                //cout<<"First time: "<<channelNo<<" "<<tempValue<<endl;
-                PedestalValues->insert(pair <unsigned long,vector<int>> (channelNo,tempPed));
-                //newboard=false;
-            }
-            else{
-                //cout<<"Following time: "<<channelNo<<" "<<tempValue<<"    F    "<<PedestalValues->count(channelNo)<<endl;
-                (((PedestalValues->find(channelNo))->second)).push_back(tempValue);
-            }
-
-            channelNo++;
-        }
-
-        sampleNo++;
-        //when the sampleNo gets to ff
-        //it is at sample 256 and needs to go to the next event
-        //if(sampleNo=='ff')
-        //if(sampleNo==255)
-        //{
-            //cout<<"DID THIS HAPPEN "<<sampleNo<<" "<<eventNo<<endl;
-        //    eventNo++;
-        //    break;
-        //}
-
-        //cout<<"at the end"<<endl;
+        if(from_cache) cout<<"Read pedestals from cache "<<PedCacheFile<<endl;
+        else cout<<"Read pedestals from "<<PedFileNameTXT<<"*.txt"<<endl;
     }
 
-    if(LAPPDStoreReadInVerbosity>0) cout<<"FINAL SAMPLE NUMBER: "<<PedestalValues->size()<<" "<<(((PedestalValues->find(0))->second)).size()<<endl;
-    PedFile.close();
   return true;
 }
 
@@ -350,140 +292,3 @@ bool LAPPDStoreReadIn::MakePedestals(){
 
   return true;
 }
-
-int LAPPDStoreReadIn::getParsedMeta(std::vector<unsigned short> buffer, int BoardId)
-{
-    //Catch empty buffers
-    if(buffer.size() == 0)
-    {
-        std::cout << "You tried to parse ACDC data without pulling/setting an ACDC buffer" << std::endl;
-        return -1;
-    }
-
-    //Prepare the Metadata vector
-    //meta.clear();
-
-    //Helpers
-    int chip_count = 0;
-
-    //Indicator words for the start/end of the metadata
-    const unsigned short startword = 0xBA11;
-    unsigned short endword = 0xFACE;
-    unsigned short endoffile = 0x4321;
-
-    //Empty metadata map for each Psec chip <PSEC #, vector with information>
-    map<int, vector<unsigned short>> PsecInfo;
-
-    //Empty trigger metadata map for each Psec chip <PSEC #, vector with trigger>
-    map<int, vector<unsigned short>> PsecTriggerInfo;
-    unsigned short CombinedTriggerRateCount;
-
-    //Empty vector with positions of aboves startword
-    vector<int> start_indices=
-    {
-        1539, 3091, 4643, 6195, 7747
-    };
-
-    //Fill the psec info map
-    vector<unsigned short>::iterator bit;
-    for(int i: start_indices)
-    {
-        //Write the first word after the startword
-        bit = buffer.begin() + (i+1);
-
-        //As long as the endword isn't reached copy metadata words into a vector and add to map
-        vector<unsigned short> InfoWord;
-        while(*bit != endword && *bit != endoffile && InfoWord.size() < 14)
-        {
-            InfoWord.push_back(*bit);
-            ++bit;
-        }
-        PsecInfo.insert(pair<int, vector<unsigned short>>(chip_count, InfoWord));
-        chip_count++;
-    }
-
-    //Fill the psec trigger info map
-    for(int chip=0; chip<NUM_PSEC; chip++)
-    {
-        for(int ch=0; ch<NUM_CH/NUM_PSEC; ch++)
-        {
-            //Find the trigger data at begin + last_metadata_start + 13_info_words + 1_end_word + 1
-            bit = buffer.begin() + start_indices[4] + 13 + 1 + 1 + ch + (chip*(NUM_CH/NUM_PSEC));
-            PsecTriggerInfo[chip].push_back(*bit);
-        }
-    }
-
-    //Fill the combined trigger
-    CombinedTriggerRateCount = buffer[7792];
-
-    //----------------------------------------------------------
-    //Start the metadata parsing
-
-    meta.push_back(BoardId);
-    for(int CHIP=0; CHIP<NUM_PSEC; CHIP++)
-    {
-        meta.push_back((0xDCB0 | CHIP));
-        for(int INFOWORD=0; INFOWORD<13; INFOWORD++)
-        {
-            meta.push_back(PsecInfo[CHIP][INFOWORD]);
-        }
-        for(int TRIGGERWORD=0; TRIGGERWORD<6; TRIGGERWORD++)
-        {
-            meta.push_back(PsecTriggerInfo[CHIP][TRIGGERWORD]);
-        }
-    }
-
-    meta.push_back(CombinedTriggerRateCount);
-    meta.push_back(0xeeee);
-    return 0;
-}
-
-
-int LAPPDStoreReadIn::getParsedData(std::vector<unsigned short> buffer, int ch_start)
-{
-    //Catch empty buffers
-    if(buffer.size() == 0)
-    {
-        std::cout << "You tried to parse ACDC data without pulling/setting an ACDC buffer" << std::endl;
-        return -1;
-    }
-
-    //Helpers
-    int DistanceFromZero;
-    channel_count=0;
-
-    //Indicator words for the start/end of the metadata
-    const unsigned short startword = 0xF005;
-    unsigned short endword = 0xBA11;
-    unsigned short endoffile = 0x4321;
-
-    //Empty vector with positions of aboves startword
-    vector<int> start_indices=
-    {
-        2, 1554, 3106, 4658, 6210
-    };
-
-    //Fill data map
-    vector<unsigned short>::iterator bit;
-    for(int i: start_indices)
-    {
-        //Write the first word after the startword
-        bit = buffer.begin() + (i+1);
-
-        //As long as the endword isn't reached copy metadata words into a vector and add to map
-        vector<unsigned short> InfoWord;
-        while(*bit != endword && *bit != endoffile)
-        {
-            InfoWord.push_back((unsigned short)*bit);
-            if(InfoWord.size()==NUM_SAMP)
-            {
-                data.insert(pair<int, vector<unsigned short>>(ch_start + channel_count, InfoWord));
-                InfoWord.clear();
-                channel_count++;
-            }
-            ++bit;
-        }
-    }
-
-    return 0;
-}
@@ -7,6 +7,7 @@
 #include <bitset>
 #include <fstream>
 #include "Tool.h"
+#include "ACDCFrame.h"
 
 #define NUM_CH 30
 #define NUM_PSEC 5
@@ -16,7 +17,10 @@ using namespace std;
 /**
  * \class LAPPDStoreReadIn
  *
- * This is a blank template for a Tool used by the script to generate a new custom tool. Please fill out the description and author information.
+ * Reads the ACDC board frames of PsecData entries from a BoostStore file,
+ * subtracts the pedestals and puts the waveforms of each channel into the
+ * ANNIEEvent. The frames are parsed in place through acdc::FrameView, and the
+ * pedestals are kept in a dense acdc::PedestalTable.
 *
 * $Author: B.Richards $
 * $Date: 2019/05/28 10:44:00 $
@@ -31,23 +35,17 @@ class LAPPDStoreReadIn: public Tool {
   bool Initialise(std::string configfile,DataModel &data); ///< Initialise Function for setting up Tool resources. @param configfile The path and name of the dynamic configuration file to read in. @param data A reference to the transient data class used to pass information between Tools.
   bool Execute(); ///< Execute function used to perform Tool purpose.
   bool Finalise(); ///< Finalise function used to clean up resources.
-  bool ReadPedestals(int boardNo); ///< Read in the Pedestal Files
+  bool ReadPedestals(); ///< Read in the Pedestal Files, through the binary pedestal cache
   bool MakePedestals(); ///< Make a Pedestal File
 
-  int getParsedData(vector<unsigned short> buffer, int ch_start);
-  int getParsedMeta(vector<unsigned short> buffer, int BoardId);
-
 
  private:
 
     int Nboards;
-    int channel_count;
-    int retval;
     long entries;
     ifstream DataFile;
-    ifstream PedFile;
     string NewFileName;
-    string PedFileName, PedFileNameTXT;
+    string PedFileName, PedFileNameTXT, PedCacheFile;
     string OutputWavLabel;
     string InputWavLabel;
     string BoardIndexLabel;
@@ -59,17 +57,15 @@ class LAPPDStoreReadIn: public Tool {
     int TrigChannel;
     int LAPPDStoreReadInVerbosity=0;
     int eventNo;
-    std::map<unsigned long, vector<int>> *PedestalValues;
+    acdc::PedestalTable Pedestals;
     streampos dataPosition;
 
     double SampleSize;
     int LAPPDchannelOffset;
 
-    //temp maps for data parsing
-    std::vector<unsigned short> Raw_buffer;
-    std::vector<unsigned short> Parse_buffer;
+    //data parsing
+    acdc::FrameView frame;
     std::vector<int> ReadBoards;
-    std::map<int, vector<unsigned short>> data;
     vector<unsigned short> meta;
     vector<unsigned short> pps;
 
@@ -1,4 +1,7 @@
 #include "LAPPDStoreReorderData.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDStoreReorderData);
 
 LAPPDStoreReorderData::LAPPDStoreReorderData():Tool(){}
 
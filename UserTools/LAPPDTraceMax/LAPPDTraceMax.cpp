@@ -1,4 +1,7 @@
 #include "LAPPDTraceMax.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDTraceMax);
 
 LAPPDTraceMax::LAPPDTraceMax():Tool(){}
 
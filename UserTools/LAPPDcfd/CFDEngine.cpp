@@ -0,0 +1,175 @@
+#include "CFDEngine.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  // Solve p(u)==level for u in [0,1], given p(0)<=level<p(1) and p increasing
+  // through the bracket on average. Newton steps, falling back to bisection
+  // whenever a step would leave the bracket.
+  template<typename Poly> double SolveSegment(const Poly& p, double level, double u){
+    double lo = 0., hi = 1.;
+    for(int iter=0; iter<50; ++iter){
+      double value = p.Value(u) - level;
+      if(value>0) hi = u; else lo = u;
+      double slope = p.Slope(u);
+      double next = (slope!=0.) ? u - value/slope : 0.5*(lo+hi);
+      if(!(next>lo && next<hi)) next = 0.5*(lo+hi);
+      if(std::fabs(next-u)<1e-9) return next;
+      u = next;
+    }
+    return u;
+  }
+
+  // cubic a + b u + c u^2 + d u^3
+  struct Cubic {
+    double a, b, c, d;
+    double Value(double u) const { return a + u*(b + u*(c + u*d)); }
+    double Slope(double u) const { return b + u*(2.*c + u*3.*d); }
+  };
+
+  // Lagrange cubic through (-1,w0) (0,w1) (1,w2) (2,w3)
+  Cubic LagrangeCubic(double w0, double w1, double w2, double w3){
+    Cubic p;
+    p.a = w1;
+    p.b = -w0/3. - w1/2. + w2 - w3/6.;
+    p.c = w0/2. - w1 + w2/2.;
+    p.d = -w0/6. + w1/2. - w2/2. + w3/6.;
+    return p;
+  }
+
+  // Catmull-Rom segment between w1 and w2
+  Cubic CatmullRom(double w0, double w1, double w2, double w3){
+    Cubic p;
+    p.a = w1;
+    p.b = 0.5*(w2 - w0);
+    p.c = 0.5*(2.*w0 - 5.*w1 + 4.*w2 - w3);
+    p.d = 0.5*(-w0 + 3.*w1 - 3.*w2 + w3);
+    return p;
+  }
+
+  // Fraction (0..1) of the way from sample k to sample k+1 at which the
+  // interpolant reaches level. w[k]<=level<w[k+1] (or the reverse for falling).
+  double Crossing(const double* w, size_t n, size_t k, double level, lappdcfd::Interpolation interpolation){
+    double w1 = w[k], w2 = w[k+1];
+    double u = (w2!=w1) ? (level-w1)/(w2-w1) : 0.;
+    if(interpolation==lappdcfd::Interpolation::Linear) return u;
+    double w0 = (k>0) ? w[k-1] : w1;
+    double w3 = (k+2<n) ? w[k+2] : w2;
+    Cubic p = (interpolation==lappdcfd::Interpolation::Cubic) ? LagrangeCubic(w0,w1,w2,w3) : CatmullRom(w0,w1,w2,w3);
+    if(w2<w1){
+      // falling crossing: solve the negated polynomial
+      p.a = -p.a; p.b = -p.b; p.c = -p.c; p.d = -p.d;
+      level = -level;
+    }
+    return SolveSegment(p,level,u);
+  }
+
+}
+
+bool lappdcfd::ParseMode(const std::string& name, Mode& mode){
+  if(name=="FractionOfPeak") mode = Mode::FractionOfPeak;
+  else if(name=="DelayedInverted") mode = Mode::DelayedInverted;
+  else return false;
+  return true;
+}
+
+bool lappdcfd::ParseInterpolation(const std::string& name, Interpolation& interpolation){
+  if(name=="Linear") interpolation = Interpolation::Linear;
+  else if(name=="Cubic") interpolation = Interpolation::Cubic;
+  else if(name=="Spline") interpolation = Interpolation::Spline;
+  else return false;
+  return true;
+}
+
+void lappdcfd::Batch::clear(){
+  samples.clear();
+  offsets.assign(1,0);
+  peak_bin.clear();
+  pulse_waveform.clear();
+  pulse_amplitude.clear();
+  pulse_lowrange.clear();
+  pulse_hirange.clear();
+}
+
+size_t lappdcfd::Batch::AddWaveform(const std::vector<double>& trace){
+  size_t start = samples.size();
+  samples.resize(start+trace.size());
+  size_t peak = 0;
+  for(size_t i=0; i<trace.size(); ++i){
+    samples[start+i] = -trace[i];
+    if(samples[start+i]>samples[start+peak]) peak = i;
+  }
+  offsets.push_back(samples.size());
+  peak_bin.push_back(peak);
+  return peak_bin.size()-1;
+}
+
+void lappdcfd::Batch::AddPulse(size_t waveform, double amplitude, double lowrange, double hirange){
+  pulse_waveform.push_back(waveform);
+  pulse_amplitude.push_back(amplitude);
+  pulse_lowrange.push_back(lowrange);
+  pulse_hirange.push_back(hirange);
+}
+
+void lappdcfd::Batch::Run(const Settings& settings, std::vector<double>& times){
+  times.resize(NumPulses());
+  for(size_t ipulse=0; ipulse<NumPulses(); ++ipulse){
+    if(settings.mode==Mode::FractionOfPeak) times[ipulse] = FractionTime(ipulse,settings);
+    else times[ipulse] = DelayedTime(ipulse,settings);
+  }
+}
+
+// The leading edge crossing of fraction*amplitude between the start of the
+// pulse window and the waveform maximum, as CFD_Discriminator1 finds by
+// bisection, including its results when there is no crossing in that range.
+double lappdcfd::Batch::FractionTime(size_t ipulse, const Settings& settings) const {
+  size_t iwav = pulse_waveform[ipulse];
+  const double* w = samples.data() + offsets[iwav];
+  size_t n = offsets[iwav+1] - offsets[iwav];
+  double width = settings.sample_width;
+  double th = settings.fraction * pulse_amplitude[ipulse];
+  double xlow = (pulse_lowrange[ipulse]-5.)*width;
+  if(n==0) return xlow;
+
+  size_t peak = peak_bin[iwav];
+  double xhigh = (peak+0.5)*width;
+  if(xhigh-xlow<1e-2) return xlow;
+  if(w[peak]<=th) return xhigh;
+
+  for(size_t k=peak; k-- > 0; ){
+    // everything from here to the peak is above threshold
+    if((k+1.5)*width<xlow) return xlow;
+    if(w[k]<=th){
+      double t = (k+0.5+Crossing(w,n,k,th,settings.interpolation))*width;
+      return std::max(t,xlow);
+    }
+  }
+  return xlow;
+}
+
+// The zero crossing of w(t) - fraction*w(t+delay) that follows its minimum
+// within the pulse window (widened by 5 samples each side)
+double lappdcfd::Batch::DelayedTime(size_t ipulse, const Settings& settings){
+  size_t iwav = pulse_waveform[ipulse];
+  const double* w = samples.data() + offsets[iwav];
+  long n = offsets[iwav+1] - offsets[iwav];
+  long first = std::max(0L,(long)std::floor(pulse_lowrange[ipulse]-5.));
+  long last = std::min(n-1,(long)std::ceil(pulse_hirange[ipulse]+5.));
+  if(last-first<1) return 0.;
+
+  cfd.resize(last-first+1);
+  for(long i=first; i<=last; ++i){
+    double delayed = (i+settings.delay_samples<n) ? w[i+settings.delay_samples] : 0.;
+    cfd[i-first] = w[i] - settings.fraction*delayed;
+  }
+  size_t minimum = std::min_element(cfd.begin(),cfd.end()) - cfd.begin();
+  for(size_t k=minimum; k+1<cfd.size(); ++k){
+    if(cfd[k]<0. && cfd[k+1]>=0.){
+      double u = Crossing(cfd.data(),cfd.size(),k,0.,settings.interpolation);
+      return (first+k+0.5+u)*settings.sample_width;
+    }
+  }
+  return 0.;
+}
@@ -0,0 +1,73 @@
+#ifndef CFDEngine_H
+#define CFDEngine_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Constant fraction timing directly on the sample arrays, without ROOT objects.
+// The waveforms are held inverted (pulses positive, as in the histograms the
+// old CFD_Discriminator1 built), sample i centred at (i+0.5)*sample_width ps.
+// The threshold crossing is found by walking from the peak to the nearest
+// bracketing pair of samples and solving the interpolant between them.
+namespace lappdcfd {
+
+  enum class Mode {
+    FractionOfPeak,    // waveform crosses Fraction*pulse amplitude (CFD_Discriminator1)
+    DelayedInverted    // w(t) - Fraction*w(t+delay) crosses zero (CFD_Discriminator2)
+  };
+
+  enum class Interpolation {
+    Linear,            // straight line between the two bracketing samples
+    Cubic,             // cubic through the two samples and their outer neighbours
+    Spline             // Catmull-Rom (local C1 cubic spline) segment
+  };
+
+  struct Settings {
+    Mode mode = Mode::FractionOfPeak;
+    Interpolation interpolation = Interpolation::Linear;
+    double fraction = 0.15;
+    double sample_width = 100.;   // ps
+    int delay_samples = 0;        // DelayedInverted only
+  };
+
+  bool ParseMode(const std::string& name, Mode& mode);
+  bool ParseInterpolation(const std::string& name, Interpolation& interpolation);
+
+  // All the pulses of an event (a board, or several), timed in one pass
+  class Batch {
+
+   public:
+
+    void clear();
+    // returns the index of the waveform in the batch
+    size_t AddWaveform(const std::vector<double>& samples);
+    // lowrange and hirange in samples, as set by LAPPDFindPeak
+    void AddPulse(size_t waveform, double amplitude, double lowrange, double hirange);
+    size_t NumPulses() const { return pulse_waveform.size(); }
+
+    // pulse times in ps, in the order the pulses were added
+    void Run(const Settings& settings, std::vector<double>& times);
+
+   private:
+
+    double FractionTime(size_t ipulse, const Settings& settings) const;
+    double DelayedTime(size_t ipulse, const Settings& settings);
+
+    // inverted samples of all waveforms, back to back
+    std::vector<double> samples;
+    std::vector<size_t> offsets{0};
+    std::vector<size_t> peak_bin;     // first maximum of each waveform
+
+    std::vector<size_t> pulse_waveform;
+    std::vector<double> pulse_amplitude;
+    std::vector<double> pulse_lowrange;
+    std::vector<double> pulse_hirange;
+
+    std::vector<double> cfd;          // scratch for the delayed-inverted sum
+
+  };
+
+}
+
+#endif
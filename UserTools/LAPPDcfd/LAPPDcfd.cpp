@@ -1,4 +1,7 @@
 #include "LAPPDcfd.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LAPPDcfd);
 
 LAPPDcfd::LAPPDcfd():Tool(){}
 
@@ -29,6 +32,32 @@ bool LAPPDcfd::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("Fraction_CFD", Fraction_CFD);
   //std::cout<<"Fraction_CFD="<<Fraction_CFD<<std::endl;
 
+  // CFD variant and interpolation between samples. "Histogram" uses the
+  // original TH1D bisection in CFD_Discriminator1
+  std::string CFDMode = "FractionOfPeak";
+  m_variables.Get("CFDMode",CFDMode);
+  std::string CFDInterpolation = "Linear";
+  m_variables.Get("CFDInterpolation",CFDInterpolation);
+  useHistogramCFD = (CFDInterpolation=="Histogram");
+  if(!lappdcfd::ParseMode(CFDMode,cfdSettings.mode)){
+    cout<<"LAPPDcfd: unknown CFDMode "<<CFDMode<<", use FractionOfPeak or DelayedInverted"<<endl;
+    return false;
+  }
+  if(!useHistogramCFD && !lappdcfd::ParseInterpolation(CFDInterpolation,cfdSettings.interpolation)){
+    cout<<"LAPPDcfd: unknown CFDInterpolation "<<CFDInterpolation<<", use Linear, Cubic, Spline or Histogram"<<endl;
+    return false;
+  }
+  if(useHistogramCFD && cfdSettings.mode!=lappdcfd::Mode::FractionOfPeak){
+    cout<<"LAPPDcfd: CFDInterpolation Histogram only supports CFDMode FractionOfPeak"<<endl;
+    return false;
+  }
+  cfdSettings.fraction = Fraction_CFD;
+  // samples are 100 ps apart, as assumed by CFD_Discriminator1
+  cfdSettings.sample_width = 100.;
+  double Delay_CFD = 0.;
+  m_variables.Get("Delay_CFD",Delay_CFD);
+  cfdSettings.delay_samples = (int)std::round(Delay_CFD/cfdSettings.sample_width);
+
   isSim=false;
   // Check in the Boost Store whether this is a simulated event or not
   m_data->Stores["ANNIEEvent"]->Header->Get("isSim",isSim);
@@ -83,21 +112,34 @@ bool LAPPDcfd::Execute(){
   // Place to store the reconstructed pulses
   std::map<unsigned long,vector<LAPPDPulse>> CFDRecoLAPPDPulses;
 
-  // Loop over all channels
-  map<unsigned long, vector<LAPPDPulse>>:: iterator p;
+  // Collect every candidate pulse on every waveform of the event, and time them all
+  // in one pass. As before, each pulse of a channel is timed on each of its waveforms
+  cfdBatch.clear();
+  if(!useHistogramCFD) for(auto&& p : SimpleRecoLAPPDPulses){
+    auto itr = lappddata.find(p.first);
+    if(itr==lappddata.end()){
+      if(CFDVerbosity>0) cout<<"LAPPDcfd: no waveform for channel "<<p.first<<endl;
+      continue;
+    }
+    for(Waveform<double>& bwav : itr->second){
+      size_t iwav = cfdBatch.AddWaveform(*bwav.GetSamples());
+      for(LAPPDPulse& pulse : p.second){
+        cfdBatch.AddPulse(iwav,pulse.GetPeak(),pulse.GetLowRange(),pulse.GetHiRange());
+      }
+    }
+  }
+  if(!useHistogramCFD) cfdBatch.Run(cfdSettings,cfdTimes);
 
-  for (p = SimpleRecoLAPPDPulses.begin(); p != SimpleRecoLAPPDPulses.end(); ++p){
-   // cout<<"In loop of channels"<<endl;
+  // Loop over all channels
+  size_t ipulse = 0;
+  for(auto&& p : SimpleRecoLAPPDPulses){
     // Get the channel number and a vector of pulses
-    unsigned long channelno = p->first;
-    vector<LAPPDPulse> Vpulses = p->second;
-     // cout<<"still in loop "<<SimpleRecoLAPPDPulses.size() <<" " << channelno<<endl;
+    unsigned long channelno = p.first;
+    vector<LAPPDPulse>& Vpulses = p.second;
     // get the vector of waveforms correseponding to the channel
-    map <unsigned long, vector<Waveform<double>>> :: iterator itr;
-    itr = lappddata.find(channelno);
-    //cout<<"Is it here? "<<endl;
-    vector<Waveform<double>> Vwavs = itr->second;
-    //cout<<"or here?"<<endl;
+    auto itr = lappddata.find(channelno);
+    if(itr==lappddata.end()) continue;
+    vector<Waveform<double>>& Vwavs = itr->second;
     if(CFDVerbosity>0){
         std::cout<<"************************************************"<<std::endl;
         std::cout<<"IN LAPPDCFD:: channel: "<<channelno<<std::endl;
@@ -124,15 +166,11 @@ bool LAPPDcfd::Execute(){
     //loop over all Waveforms
     for(int i=0; i<(int)Vwavs.size(); i++){
 
-        Waveform<double> bwav = Vwavs.at(i);
-
-        //std::cout<<"reconstructed pulses: "<<std::endl;;
-
         // loop over all candidate pulses on each waveform, as determined by the LAPPDFindPeak Tool
-        for(int j=0; j<(int)Vpulses.size(); j++){
+        for(int j=0; j<(int)Vpulses.size(); j++, ipulse++){
 
-          // for each pulse on the Waveform find the time using CFD1 algorithm
-          double cfdtime = CFD_Discriminator1(bwav.GetSamples(),Vpulses.at(j));
+          // for each pulse on the Waveform find the time using the CFD
+          double cfdtime = useHistogramCFD ? CFD_Discriminator1(Vwavs.at(i).GetSamples(),Vpulses.at(j)) : cfdTimes.at(ipulse);
           if(CFDVerbosity>0){
               std::cout<<"for pulse #"<<j<<" (Q="<<(Vpulses.at(j)).GetCharge()<<",Amp="<<(Vpulses.at(j)).GetPeak()<<",LowRange="<<(Vpulses.at(j)).GetLowRange()<<",HiRange="<<(Vpulses.at(j)).GetHiRange()<<") "<<"  cfd_time="<<cfdtime<<std::endl;
           }
@@ -142,7 +180,6 @@ bool LAPPDcfd::Execute(){
         }
       }
 
-        //std::cout<<" "<<std::endl;
         // Put the newly reconsructed LAPPDPulses into a map, by channel
         CFDRecoLAPPDPulses.insert(pair <unsigned long,vector<LAPPDPulse>> (channelno,thepulses));
     }
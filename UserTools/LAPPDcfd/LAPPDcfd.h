@@ -3,12 +3,14 @@
 
 #include <string>
 #include <iostream>
+#include <cmath>
 #include "TSplineFit.h"
 #include "TPoly3.h"
 #include "LAPPDPulse.h"
 #include "LAPPDHit.h"
 #include "Waveform.h"
 #include "TH1D.h"
+#include "CFDEngine.h"
 
 #include "Tool.h"
 
@@ -32,6 +34,10 @@ class LAPPDcfd: public Tool {
    string RawCFDInputWavLabel;
    string BLSCFDInputWavLabel;
    int CFDVerbosity;
+   bool useHistogramCFD;         // time with CFD_Discriminator1 instead of the CFDEngine
+   lappdcfd::Settings cfdSettings;
+   lappdcfd::Batch cfdBatch;
+   std::vector<double> cfdTimes;
 
 };
 
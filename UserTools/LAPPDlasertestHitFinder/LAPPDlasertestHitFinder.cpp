@@ -1,4 +1,5 @@
 #include "LAPPDlasertestHitFinder.h"
+#include "ToolRegistry.h"
 
 
 const double c = 29.98; //cm/ns
@@ -6,6 +7,8 @@ const int side = 1;
 
 
 
+REGISTER_TOOL(LAPPDlasertestHitFinder);
+
 LAPPDlasertestHitFinder::LAPPDlasertestHitFinder():Tool(){}
 
 
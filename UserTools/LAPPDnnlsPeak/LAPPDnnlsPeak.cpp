@@ -40,6 +40,7 @@ resample the rawdata to the template timestep
 
 
 #include "LAPPDnnlsPeak.h"
+#include "ToolRegistry.h"
 #include <TCanvas.h>
 #include <math.h>
 #include <string>
@@ -52,6 +53,8 @@ resample the rawdata to the template timestep
 
 
 
+REGISTER_TOOL(LAPPDnnlsPeak);
+
 LAPPDnnlsPeak::LAPPDnnlsPeak():Tool(){}
 
 
@@ -1,6 +1,9 @@
 #include "LikelihoodFitterCheck.h"
+#include "ToolRegistry.h"
 #include "TVector3.h"
 
+REGISTER_TOOL(LikelihoodFitterCheck);
+
 LikelihoodFitterCheck::LikelihoodFitterCheck():Tool(){}
 
 
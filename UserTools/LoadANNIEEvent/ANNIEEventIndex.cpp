@@ -0,0 +1,261 @@
+// standard library includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+#include <sys/stat.h>
+
+// ToolAnalysis includes
+#include "ANNIEEventIndex.h"
+#include "ANNIEconstants.h"
+#include "BoostStore.h"
+
+namespace {
+  const char index_magic[8] = {'A','N','N','I','E','I','D','X'};
+  const uint32_t index_version = 2;
+
+  // The sidecar is written field by field as little-endian fixed-width
+  // integers, so it does not depend on struct padding or the byte order of
+  // the machine that wrote it
+  template <typename T> void WriteField(std::ostream& out, T value) {
+    typename std::make_unsigned<T>::type bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); ++i) bytes[i] = char((bits >> (8*i)) & 0xff);
+    out.write(bytes, sizeof(T));
+  }
+
+  template <typename T> bool ReadField(std::istream& in, T& value) {
+    unsigned char bytes[sizeof(T)];
+    if (!in.read(reinterpret_cast<char*>(bytes), sizeof(T))) return false;
+    typename std::make_unsigned<T>::type bits = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) bits |= decltype(bits)(bytes[i]) << (8*i);
+    std::memcpy(&value, &bits, sizeof(T));
+    return true;
+  }
+
+  void WriteEntry(std::ostream& out, const ANNIEEventIndexEntry& row) {
+    WriteField(out, row.entry);
+    WriteField(out, row.run);
+    WriteField(out, row.subrun);
+    WriteField(out, row.part);
+    WriteField(out, row.event_number);
+    WriteField(out, row.timestamp);
+    WriteField(out, row.trigger_word);
+  }
+
+  bool ReadEntry(std::istream& in, ANNIEEventIndexEntry& row) {
+    return ReadField(in, row.entry) && ReadField(in, row.run)
+      && ReadField(in, row.subrun) && ReadField(in, row.part)
+      && ReadField(in, row.event_number) && ReadField(in, row.timestamp)
+      && ReadField(in, row.trigger_word);
+  }
+}
+
+ANNIEEventIndex::ANNIEEventIndex() : valid_(false), datafile_size_(0),
+  datafile_mtime_(0) {}
+
+std::string ANNIEEventIndex::SidecarName(const std::string& datafile,
+  const std::string& index_dir)
+{
+  if (index_dir.empty()) return datafile + ".evidx";
+  std::string basename = datafile.substr(datafile.find_last_of('/') + 1);
+  return index_dir + "/" + basename + ".evidx";
+}
+
+bool ANNIEEventIndex::StatFile(const std::string& filename, uint64_t& size,
+  int64_t& mtime)
+{
+  struct stat file_stat;
+  if (stat(filename.c_str(), &file_stat) != 0) return false;
+  size = file_stat.st_size;
+  mtime = file_stat.st_mtime;
+  return true;
+}
+
+bool ANNIEEventIndex::Load(const std::string& datafile,
+  const std::string& index_dir)
+{
+  valid_ = false;
+  entries_.clear();
+  time_order_.clear();
+  event_order_.clear();
+  datafile_ = datafile;
+  if (!StatFile(datafile, datafile_size_, datafile_mtime_)) return false;
+
+  std::ifstream infile(SidecarName(datafile, index_dir), std::ios::binary);
+  if (!infile.good()) return false;
+
+  char magic[8];
+  uint32_t version = 0;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  uint64_t n_entries = 0;
+  if (!infile.read(magic, sizeof(magic)) || !ReadField(infile, version)
+    || std::memcmp(magic, index_magic, sizeof(magic)) != 0
+    || version != index_version) return false;
+  if (!ReadField(infile, size) || !ReadField(infile, mtime)
+    || !ReadField(infile, n_entries)) return false;
+
+  // the data file changed since the index was written
+  if (size != datafile_size_ || mtime != datafile_mtime_) return false;
+
+  ANNIEEventIndexEntry row;
+  for (uint64_t i_entry = 0; i_entry < n_entries; ++i_entry) {
+    if (!ReadEntry(infile, row)) {
+      entries_.clear();
+      return false;
+    }
+    entries_.push_back(row);
+  }
+
+  BuildLookups();
+  valid_ = true;
+  return true;
+}
+
+bool ANNIEEventIndex::Build(const std::string& datafile,
+  const std::string& file_format)
+{
+  valid_ = false;
+  entries_.clear();
+  time_order_.clear();
+  event_order_.clear();
+  datafile_ = datafile;
+  if (!StatFile(datafile, datafile_size_, datafile_mtime_)) return false;
+
+  BoostStore* processed_store = nullptr;
+  BoostStore* annie_event = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+  bool ok = false;
+  if (file_format == "CombinedStore") {
+    processed_store = new BoostStore(false, BOOST_STORE_BINARY_FORMAT);
+    ok = processed_store->Initialise(datafile);
+    if (ok) ok = processed_store->Get("ANNIEEvent", *annie_event);
+  }
+  else ok = annie_event->Initialise(datafile);
+
+  unsigned long total_entries = 0;
+  if (ok) ok = annie_event->Header->Get("TotalEntries", total_entries);
+
+  for (unsigned long i_entry = 0; ok && i_entry < total_entries; ++i_entry) {
+    if (!annie_event->GetEntry(i_entry)) break;
+
+    ANNIEEventIndexEntry row;
+    row.entry = i_entry;
+    row.run = row.subrun = row.part = -1;
+    row.event_number = i_entry;
+    row.timestamp = 0;
+    row.trigger_word = 0;
+
+    annie_event->Get("RunNumber", row.run);
+    annie_event->Get("SubrunNumber", row.subrun);
+    annie_event->Get("PartNumber", row.part);
+    annie_event->Get("EventNumber", row.event_number);
+    if (!annie_event->Get("EventTimeTank", row.timestamp))
+      annie_event->Get("CTCTimestamp", row.timestamp);
+    annie_event->Get("TriggerWord", row.trigger_word);
+
+    entries_.push_back(row);
+    annie_event->Delete();
+  }
+
+  annie_event->Close();
+  delete annie_event;
+  if (processed_store) {
+    processed_store->Close();
+    delete processed_store;
+  }
+
+  if (!ok) return false;
+  BuildLookups();
+  valid_ = true;
+  return true;
+}
+
+bool ANNIEEventIndex::Write(const std::string& index_dir) const
+{
+  if (!valid_) return false;
+  std::ofstream outfile(SidecarName(datafile_, index_dir),
+    std::ios::binary | std::ios::trunc);
+  if (!outfile.good()) return false;
+
+  outfile.write(index_magic, sizeof(index_magic));
+  WriteField(outfile, index_version);
+  WriteField(outfile, datafile_size_);
+  WriteField(outfile, datafile_mtime_);
+  WriteField(outfile, uint64_t(entries_.size()));
+  for (const auto& row : entries_) WriteEntry(outfile, row);
+  return outfile.good();
+}
+
+void ANNIEEventIndex::BuildLookups()
+{
+  time_order_.resize(entries_.size());
+  for (uint32_t i = 0; i < time_order_.size(); ++i) time_order_[i] = i;
+  std::stable_sort(time_order_.begin(), time_order_.end(),
+    [this](uint32_t a, uint32_t b) {
+      return entries_[a].timestamp < entries_[b].timestamp;
+    });
+
+  // stable, so a duplicated event is found at its first entry
+  event_order_.resize(entries_.size());
+  for (uint32_t i = 0; i < event_order_.size(); ++i) event_order_[i] = i;
+  std::stable_sort(event_order_.begin(), event_order_.end(),
+    [this](uint32_t a, uint32_t b) {
+      return entries_[a].Key() < entries_[b].Key();
+    });
+}
+
+long ANNIEEventIndex::FindEvent(int run, int subrun, int part,
+  uint32_t event_number) const
+{
+  ANNIEEventKey key(run, subrun, part, event_number);
+  auto it = std::lower_bound(event_order_.begin(), event_order_.end(), key,
+    [this](uint32_t i, const ANNIEEventKey& value) {
+      return entries_[i].Key() < value;
+    });
+  if (it == event_order_.end() || entries_[*it].Key() != key) return -1;
+  return entries_[*it].entry;
+}
+
+bool ANNIEEventIndex::ReadEventSelection(const std::string& filename,
+  std::set<ANNIEEventKey>& events)
+{
+  std::ifstream selection_file(filename);
+  if (!selection_file.good()) return false;
+
+  std::string line;
+  while (std::getline(selection_file, line)) {
+    line = line.substr(0, line.find('#'));
+    std::stringstream ss(line);
+    int32_t run, subrun, part;
+    uint32_t event_number;
+    if (ss >> run >> subrun >> part >> event_number) {
+      events.emplace(run, subrun, part, event_number);
+    }
+  }
+  return true;
+}
+
+long ANNIEEventIndex::FindTimestamp(uint64_t t) const
+{
+  auto it = std::lower_bound(time_order_.begin(), time_order_.end(), t,
+    [this](uint32_t i, uint64_t value) {
+      return entries_[i].timestamp < value;
+    });
+  if (it == time_order_.end()) return -1;
+  return entries_[*it].entry;
+}
+
+uint64_t ANNIEEventIndex::FirstTimestamp() const
+{
+  if (time_order_.empty()) return 0;
+  return entries_[time_order_.front()].timestamp;
+}
+
+uint64_t ANNIEEventIndex::LastTimestamp() const
+{
+  if (time_order_.empty()) return 0;
+  return entries_[time_order_.back()].timestamp;
+}
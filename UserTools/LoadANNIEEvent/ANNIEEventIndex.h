@@ -0,0 +1,92 @@
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// @brief (run, subrun, part, event_number) of an event
+typedef std::tuple<int32_t, int32_t, int32_t, uint32_t> ANNIEEventKey;
+
+/// @brief One row of the sidecar index: where an event lives in its file
+/// and the header quantities that can be used to look it up
+struct ANNIEEventIndexEntry {
+  uint32_t entry;          ///< Entry number in the ANNIEEvent multi-event store
+  int32_t run;             ///< RunNumber
+  int32_t subrun;          ///< SubrunNumber
+  int32_t part;            ///< PartNumber
+  uint32_t event_number;   ///< EventNumber
+  uint64_t timestamp;      ///< EventTimeTank (or CTCTimestamp if no tank time is present) [ns]
+  uint32_t trigger_word;   ///< TriggerWord
+
+  ANNIEEventKey Key() const { return ANNIEEventKey(run, subrun, part, event_number); }
+};
+
+/// @brief Sidecar event index for a single ANNIEEvent input file
+///
+/// The index is stored next to the data file (or in a dedicated index
+/// directory) as <filename>.evidx. It records the size and modification
+/// time of the data file it was built from, so a stale index is detected
+/// and rebuilt automatically.
+class ANNIEEventIndex {
+
+  public:
+
+    ANNIEEventIndex();
+
+    /// @brief Try to read an up-to-date sidecar index for datafile
+    /// @return false if there is no sidecar or it does not match datafile
+    bool Load(const std::string& datafile, const std::string& index_dir);
+
+    /// @brief Scan datafile entry by entry and fill the index
+    /// @param file_format "SeparateStores" or "CombinedStore"
+    bool Build(const std::string& datafile, const std::string& file_format);
+
+    /// @brief Write the index to its sidecar file
+    bool Write(const std::string& index_dir) const;
+
+    /// @brief Name of the sidecar file belonging to datafile
+    static std::string SidecarName(const std::string& datafile,
+      const std::string& index_dir);
+
+    /// @brief Read an event list (SelectedEventsFile): one "run subrun part event"
+    /// per line, # starts a comment
+    /// @return false if the file cannot be opened
+    static bool ReadEventSelection(const std::string& filename,
+      std::set<ANNIEEventKey>& events);
+
+    /// @brief Entry number of the event (run, subrun, part, event_number), -1 if absent
+    long FindEvent(int run, int subrun, int part, uint32_t event_number) const;
+
+    /// @brief Entry number of the first event with timestamp >= t, -1 if there is none
+    long FindTimestamp(uint64_t t) const;
+
+    /// @brief Earliest and latest timestamp in the file
+    uint64_t FirstTimestamp() const;
+    uint64_t LastTimestamp() const;
+
+    bool IsValid() const { return valid_; }
+    size_t NumEntries() const { return entries_.size(); }
+    const std::vector<ANNIEEventIndexEntry>& Entries() const { return entries_; }
+
+  private:
+
+    /// @brief Fill time_order_ and event_order_ from entries_
+    void BuildLookups();
+
+    static bool StatFile(const std::string& filename, uint64_t& size,
+      int64_t& mtime);
+
+    bool valid_;
+    std::string datafile_;
+    uint64_t datafile_size_;
+    int64_t datafile_mtime_;
+    std::vector<ANNIEEventIndexEntry> entries_;
+    /// @brief Positions into entries_ in ascending timestamp order
+    std::vector<uint32_t> time_order_;
+    /// @brief Positions into entries_ in ascending (run, subrun, part, event) order
+    std::vector<uint32_t> event_order_;
+
+};
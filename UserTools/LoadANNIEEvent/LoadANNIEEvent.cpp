@@ -1,9 +1,17 @@
 // standard library includes
+#include <algorithm>
 #include <fstream>
+#include <set>
+#include <sstream>
 #include <string>
+#include <tuple>
 
 // ToolAnalysis includes
 #include "LoadANNIEEvent.h"
+#include "ToolRegistry.h"
+#include "ANNIEEventKeys.h"
+
+REGISTER_TOOL(LoadANNIEEvent);
 
 LoadANNIEEvent::LoadANNIEEvent():Tool() {}
 
@@ -71,7 +79,37 @@ bool LoadANNIEEvent::Initialise(std::string config_filename, DataModel &data) {
   current_file_ = 0u;
   need_new_file_ = true;
 
+  std::string key_groups;
+  if (m_variables.Get("LoadKeyGroups", key_groups)) {
+    std::stringstream ss(key_groups);
+    std::string group;
+    while (std::getline(ss, group, ',')) {
+      if (group == "all") load_all_key_groups_ = true;
+      else if (!group.empty()) load_key_groups_.push_back(group);
+    }
+  }
+
+  m_variables.Get("IndexDirectory", index_directory_);
+  int prefetch_files = 0;
+  m_variables.Get("PrefetchFiles", prefetch_files);
+  if (prefetch_files > 0) prefetch_files_ = prefetch_files;
+
+  event_indices_.resize(input_filenames_.size());
+  event_index_loaded_.assign(input_filenames_.size(), false);
+
+  std::string selection_filename;
+  if (m_variables.Get("SelectedEventsFile", selection_filename)) {
+    if (!LoadEventSelection(selection_filename)) return false;
+  }
+
+  if (prefetch_files_ > 0) {
+    stop_prefetch_ = false;
+    prefetch_thread_ = std::thread(&LoadANNIEEvent::PrefetchLoop, this);
+  }
+
   m_data->CStore.Set("UserEvent",false);
+  m_data->CStore.Set("SeekEvent",false);
+  m_data->CStore.Set("SeekTime",false);
 
   current_entry_ += offset_evnum;
   if (offset_evnum != 0)  {
@@ -96,110 +134,55 @@ bool LoadANNIEEvent::Execute() {
     return false;
   }
 
-  if (need_new_file_) {
-    need_new_file_=false;
-
-    if (FileFormat == "CombinedStore"){
-      // Delete the old file BoostStore if there is one
-      if(m_data->Stores.count("ProcessedFileStore")){
-        BoostStore* ProcessedFileStore = m_data->Stores.at("ProcessedFileStore");
-        delete ProcessedFileStore;
-      }
-    }
-
-    // also close and cleanup the associated contained stores
-    if ( m_data->Stores.count("ANNIEEvent") ) {
-      auto* annie_event = m_data->Stores.at("ANNIEEvent");
-      if (annie_event){
-        delete annie_event;
-      }
+  // Other tools can request a specific event or a point in time
+  bool seek_event = false;
+  bool seek_time = false;
+  m_data->CStore.Get("SeekEvent",seek_event);
+  m_data->CStore.Get("SeekTime",seek_time);
+  if (seek_event || seek_time) {
+    m_data->CStore.Set("SeekEvent",false);
+    m_data->CStore.Set("SeekTime",false);
+    EventTarget target;
+    bool found = false;
+    if (seek_event) {
+      int run = -1, subrun = -1, part = -1;
+      uint32_t event_number = 0;
+      m_data->CStore.Get("SeekRunNumber",run);
+      m_data->CStore.Get("SeekSubrunNumber",subrun);
+      m_data->CStore.Get("SeekPartNumber",part);
+      m_data->CStore.Get("SeekEventNumber",event_number);
+      found = FindEvent(run, subrun, part, event_number, target);
+      if (!found) Log("LoadANNIEEvent error! Requested event R"+std::to_string(run)+"S"
+        +std::to_string(subrun)+"p"+std::to_string(part)+" event "
+        +std::to_string(event_number)+" is not in the input files",v_error,verbosity_);
+    } else {
+      uint64_t timestamp = 0;
+      m_data->CStore.Get("SeekTimestamp",timestamp);
+      found = FindTimestamp(timestamp, target);
+      if (!found) Log("LoadANNIEEvent error! No event at or after timestamp "
+        +std::to_string(timestamp)+" in the input files",v_error,verbosity_);
     }
-
-    if (load_orphan_store){
-      if(m_data->Stores.count("OrphanStore")){
-        auto* annie_orphans = m_data->Stores.at("OrphanStore");
-        if (annie_orphans){
-        delete annie_orphans;
-        }
-      }
+    if (!found) return false;
+    JumpTo(target);
+  }
+  else if (use_event_selection_) {
+    if (!HaveSelectedEvent()) {
+      m_data->vars.Set("StopLoop", 1);
+      return true;
     }
+    JumpTo(selected_events_.at(next_selected_));
+    ++next_selected_;
+  }
 
-    if (FileFormat == "CombinedStore"){
-      // create a store for the file contents
-      BoostStore* ProcessedFileStore = new BoostStore(false,BOOST_STORE_BINARY_FORMAT);
-      // Load the contents from the new input file into it
-      std::string input_filename = input_filenames_.at(current_file_);
-      std::cout <<"Reading in current file "<<current_file_<<std::endl;
-      bool filename_valid = false;
-      filename_valid = ProcessedFileStore->Initialise(input_filename);
-      if (!filename_valid){
-        Log("LoadANNIEEvent: Filename "+input_filename+" not found! Proceed to next file",v_error,verbosity_);
-        current_file_++;
-        return true;
-      }
-      m_data->Stores["ProcessedFileStore"]=ProcessedFileStore;
-    
-      // create an ANNIEEvent BoostStore and an OrphanStore BoostStore to load from it
-      BoostStore* theANNIEEvent = new BoostStore(false,
-        BOOST_STORE_MULTIEVENT_FORMAT);
-    
-      // retrieve the multi-event stores
-      ProcessedFileStore->Get("ANNIEEvent",*theANNIEEvent);
-      // set a pointer into the Stores map
-      m_data->Stores["ANNIEEvent"]=theANNIEEvent;
-
-      // get the number of entries
-      m_data->Stores.at("ANNIEEvent")->Header->Get("TotalEntries",
-        total_entries_in_file_);
-        
-      if (current_file_==0) {
-        global_events.push_back(total_entries_in_file_);
-        global_events_start.push_back(0);
-      }
-      else {
-        global_events.push_back(global_events.at(current_file_-1)+total_entries_in_file_);
-        global_events_start.push_back(global_events.at(current_file_-1));
-      }
-    
-      if (load_orphan_store){
-        // same for Orphan Store
-        BoostStore* theOrphanStore = new BoostStore(false,
-          BOOST_STORE_MULTIEVENT_FORMAT);
-        ProcessedFileStore->Get("OrphanStore",*theOrphanStore);
-        m_data->Stores["OrphanStore"] = theOrphanStore;
-        m_data->Stores.at("OrphanStore")->Header->Get("TotalEntries",
-        total_orphans_in_file_);
-      }
-    } else if (FileFormat == "SeparateStores"){
-      BoostStore *theANNIEEvent = new BoostStore(false,
-        BOOST_STORE_MULTIEVENT_FORMAT);
-      std::string input_filename = input_filenames_.at(current_file_);
-      bool filename_valid = false;
-      filename_valid = theANNIEEvent->Initialise(input_filename);
-      if (!filename_valid){
-        Log("LoadANNIEEvent: Filename "+input_filename+" not found! Proceed to next file",v_error,verbosity_);
-        current_file_++;
-	return true;	
-      }
-      m_data->Stores["ANNIEEvent"] = theANNIEEvent;
-      m_data->Stores.at("ANNIEEvent")->Header->Get("TotalEntries",total_entries_in_file_);
-      if (current_file_==0) {
-        global_events.push_back(total_entries_in_file_);
-        global_events_start.push_back(0);
-      }
-      else {
-        global_events.push_back(global_events.at(current_file_-1)+total_entries_in_file_);
-        global_events_start.push_back(global_events.at(current_file_-1));
-      }
-      if (load_orphan_store){
-        BoostStore *theOrphanStore = new BoostStore(false,
-          BOOST_STORE_MULTIEVENT_FORMAT);
-        std::string input_filename_orphan = input_filenames_orphan_.at(current_file_);
-        theOrphanStore->Initialise(input_filename_orphan);
-        m_data->Stores["OrphanStore"] = theOrphanStore;
-        m_data->Stores.at("OrphanStore")->Header->Get("TotalEntries",
-          total_orphans_in_file_);
-      }
+  if (need_new_file_) {
+    need_new_file_=false;
+    if (!LoadFile(current_file_)) {
+      Log("LoadANNIEEvent: Filename "+input_filenames_.at(current_file_)+" not found! Proceed to next file",v_error,verbosity_);
+      current_file_++;
+      current_entry_ = 0u;
+      need_new_file_ = true;
+      if (current_file_ >= input_filenames_.size()) m_data->vars.Set("StopLoop", 1);
+      return true;
     }
   }
 
@@ -237,37 +220,14 @@ bool LoadANNIEEvent::Execute() {
            }
            
            current_entry_ = 0u;
-           if ( m_data->Stores.count("ANNIEEvent") ) {
-             auto* annie_event = m_data->Stores.at("ANNIEEvent");
-             if (annie_event) delete annie_event;
+           if (!LoadFile(current_file_)) {
+             Log("LoadANNIEEvent: Filename "+input_filenames_.at(current_file_)+" not found! Skipping it",v_error,verbosity_);
+             continue;
            }
-           m_data->Stores["ANNIEEvent"] = new BoostStore(false,
-             BOOST_STORE_MULTIEVENT_FORMAT);
-           std::string input_filename = input_filenames_.at(current_file_);
-           std::cout <<"Reading in current file "<<current_file_<<std::endl;
-           m_data->Stores["ANNIEEvent"]->Initialise(input_filename);
-           m_data->Stores["ANNIEEvent"]->Header->Get("TotalEntries",
-             total_entries_in_file_);
-           global_events.push_back(global_events.at(current_file_-1)+total_entries_in_file_);
-           global_events_start.push_back(global_events.at(current_file_-1));
            if (user_evnum >= global_events_start.at(current_file_) && user_evnum < global_events.at(current_file_)){
              current_entry_ = user_evnum-global_events_start.at(current_file_);
              global_ev = user_evnum;
-             
-             if (load_orphan_store){
-                 // new file, new oprhan store. Delete any existing one
-                 if(m_data->Stores.count("OrphanStore")){
-                   auto* annie_orphans = m_data->Stores.at("OrphanStore");
-                   if (annie_orphans) delete annie_orphans;
-                 }
-                 // make and populate a new one
-                 BoostStore *theOrphanStore = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
-                 std::string input_filename_orphan = input_filenames_orphan_.at(current_file_);
-                 theOrphanStore->Initialise(input_filename_orphan);
-                 m_data->Stores["OrphanStore"] = theOrphanStore;
-                 m_data->Stores.at("OrphanStore")->Header->Get("TotalEntries", total_orphans_in_file_);
-             }
-             
+
              break;
            } // end if this file contains the user's requested event
          } // end while loop over files to scan for user's requested global event number
@@ -283,6 +243,8 @@ bool LoadANNIEEvent::Execute() {
   if ((int)current_entry_ != offset_evnum) m_data->Stores["ANNIEEvent"]->Delete();	//ensures that we can access pointers without problems
 
   m_data->Stores["ANNIEEvent"]->GetEntry(current_entry_);  
+  last_loaded_entry_ = current_entry_;
+  LoadKeyGroupEntry(current_entry_);
   bool has_local = (m_data->Stores["ANNIEEvent"]->Has("LocalEventNumber"));
   bool has_global = (m_data->Stores["ANNIEEvent"]->Has("EventNumber"));
   if (!has_local){ m_data->Stores["ANNIEEvent"]->Set("LocalEventNumber",current_entry_);}
@@ -293,7 +255,11 @@ bool LoadANNIEEvent::Execute() {
   if (global_evnr && !has_local){ m_data->Stores["ANNIEEvent"]->Set("EventNumber",global_ev); }
   global_ev++; 
 
-  if ( current_entry_ >= total_entries_in_file_ ) {
+  if (use_event_selection_) {
+    // the next selected event decides which file to read
+    if (!HaveSelectedEvent()) m_data->vars.Set("StopLoop", 1);
+  }
+  else if ( current_entry_ >= total_entries_in_file_ ) {
     ++current_file_;
     if ( current_file_ >= input_filenames_.size() ) {
       m_data->vars.Set("StopLoop", 1);
@@ -310,5 +276,405 @@ bool LoadANNIEEvent::Execute() {
 
 
 bool LoadANNIEEvent::Finalise() {
+  StopPrefetch();
+  for (auto& group : key_group_stores_) delete group.second;
+  key_group_stores_.clear();
+  return true;
+}
+
+bool LoadANNIEEvent::OpenFile(size_t file_index, OpenedFile& opened) const {
+
+  opened.file_index = file_index;
+  opened.valid = false;
+  std::string input_filename = input_filenames_.at(file_index);
+
+  if (FileFormat == "CombinedStore"){
+    // create a store for the file contents and load the new input file into it
+    opened.processed_store = new BoostStore(false,BOOST_STORE_BINARY_FORMAT);
+    if (!opened.processed_store->Initialise(input_filename)) return false;
+
+    // retrieve the multi-event stores
+    opened.annie_event = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+    opened.processed_store->Get("ANNIEEvent",*opened.annie_event);
+    opened.annie_event->Header->Get("TotalEntries",opened.total_entries);
+
+    if (load_orphan_store){
+      opened.orphan_store = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+      opened.processed_store->Get("OrphanStore",*opened.orphan_store);
+      opened.orphan_store->Header->Get("TotalEntries",opened.total_orphans);
+    }
+  } else if (FileFormat == "SeparateStores"){
+    opened.annie_event = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+    if (!opened.annie_event->Initialise(input_filename)) return false;
+    opened.annie_event->Header->Get("TotalEntries",opened.total_entries);
+
+    if (load_orphan_store){
+      opened.orphan_store = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+      opened.orphan_store->Initialise(input_filenames_orphan_.at(file_index));
+      opened.orphan_store->Header->Get("TotalEntries",opened.total_orphans);
+    }
+  } else return false;
+
+  // Heavy keys may have been split off into one file per key group
+  // (see SaveANNIEEvent); only open the groups that were asked for
+  std::map<std::string, std::vector<std::string>> file_key_groups;
+  if (opened.annie_event->Header->Get("KeyGroups", file_key_groups)) {
+    for (const auto& group : file_key_groups) {
+      if (!load_all_key_groups_ && std::find(load_key_groups_.begin(),
+        load_key_groups_.end(), group.first) == load_key_groups_.end()) continue;
+      BoostStore* group_store = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+      if (!group_store->Initialise(input_filename + "." + group.first)) {
+        delete group_store;
+        continue;
+      }
+      opened.key_group_stores[group.first] = group_store;
+    }
+  }
+
+  opened.valid = true;
+  return true;
+}
+
+void LoadANNIEEvent::CloseFile(OpenedFile& opened) const {
+  for (auto& group : opened.key_group_stores) delete group.second;
+  opened.key_group_stores.clear();
+  if (opened.orphan_store) delete opened.orphan_store;
+  if (opened.annie_event) delete opened.annie_event;
+  if (opened.processed_store) delete opened.processed_store;
+  opened.orphan_store = nullptr;
+  opened.annie_event = nullptr;
+  opened.processed_store = nullptr;
+  opened.valid = false;
+}
+
+bool LoadANNIEEvent::LoadFile(size_t file_index) {
+
+  Log("LoadANNIEEvent: Reading in file "+std::to_string(file_index)+": "
+    +input_filenames_.at(file_index),v_message,verbosity_);
+
+  OpenedFile opened;
+  if (!TakePrefetched(file_index, opened)) OpenFile(file_index, opened);
+
+  // keep the global event numbering consistent, even for unreadable files
+  FillGlobalEvents(file_index, (opened.valid) ? opened.total_entries : 0);
+
+  if (!opened.valid) {
+    CloseFile(opened);
+    return false;
+  }
+
+  // Delete the old file BoostStores if there are any
+  if (m_data->Stores.count("ProcessedFileStore")){
+    delete m_data->Stores.at("ProcessedFileStore");
+    m_data->Stores.erase("ProcessedFileStore");
+  }
+  if (m_data->Stores.count("ANNIEEvent")){
+    auto* annie_event = m_data->Stores.at("ANNIEEvent");
+    if (annie_event) delete annie_event;
+  }
+  if (load_orphan_store && m_data->Stores.count("OrphanStore")){
+    auto* annie_orphans = m_data->Stores.at("OrphanStore");
+    if (annie_orphans) delete annie_orphans;
+  }
+
+  if (opened.processed_store) m_data->Stores["ProcessedFileStore"] = opened.processed_store;
+  m_data->Stores["ANNIEEvent"] = opened.annie_event;
+  if (opened.orphan_store) m_data->Stores["OrphanStore"] = opened.orphan_store;
+  for (auto& group : key_group_stores_) delete group.second;
+  key_group_stores_ = opened.key_group_stores;
+  total_entries_in_file_ = opened.total_entries;
+  total_orphans_in_file_ = opened.total_orphans;
+  loaded_file_ = file_index;
+  last_loaded_entry_ = -1;
+
+  SchedulePrefetch();
+
+  return true;
+}
+
+void LoadANNIEEvent::LoadKeyGroupEntry(size_t entry) {
+
+  // the key groups don't hold MCFlag, it comes with the ANNIEEvent entry
+  BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+  bool mc_flag = annieeventkeys::IsMC(annie_event);
+  for (auto& group : key_group_stores_) {
+    BoostStore* group_store = group.second;
+    if (!group_store->GetEntry(entry)) {
+      Log("LoadANNIEEvent warning: Could not read entry "+std::to_string(entry)
+        +" of key group "+group.first,v_warning,verbosity_);
+      continue;
+    }
+    std::vector<std::string> key_directory;
+    group_store->Get("KeyDirectory", key_directory);
+    for (const auto& key : key_directory) {
+      if (!annieeventkeys::CopyKey(group_store, annie_event, key, mc_flag)) {
+        Log("LoadANNIEEvent warning: Could not copy key "+key+" of key group "
+          +group.first,v_warning,verbosity_);
+      }
+    }
+    group_store->Delete();
+  }
+}
+
+void LoadANNIEEvent::FillGlobalEvents(size_t file_index, size_t n_entries) {
+
+  // files skipped over by a seek were never loaded, take their sizes from
+  // their indices (unreadable files count as empty)
+  while (global_events.size() < file_index) {
+    size_t i_file = global_events.size();
+    const ANNIEEventIndex& index = GetIndex(i_file);
+    size_t n_skipped = (index.IsValid()) ? index.NumEntries() : 0;
+    global_events_start.push_back((i_file==0) ? 0 : global_events.back());
+    global_events.push_back(global_events_start.back()+n_skipped);
+  }
+  if (global_events.size() == file_index) {
+    global_events_start.push_back((file_index==0) ? 0 : global_events.back());
+    global_events.push_back(global_events_start.back()+n_entries);
+  }
+}
+
+const ANNIEEventIndex& LoadANNIEEvent::GetIndex(size_t file_index) {
+
+  ANNIEEventIndex& index = event_indices_.at(file_index);
+  if (event_index_loaded_.at(file_index)) return index;
+  event_index_loaded_.at(file_index) = true;
+
+  std::string input_filename = input_filenames_.at(file_index);
+  if (index.Load(input_filename, index_directory_)) {
+    Log("LoadANNIEEvent: Read event index "+ANNIEEventIndex::SidecarName(input_filename,
+      index_directory_),v_debug,verbosity_);
+    return index;
+  }
+
+  Log("LoadANNIEEvent: Building event index for "+input_filename,v_message,verbosity_);
+  if (!index.Build(input_filename, FileFormat)) {
+    Log("LoadANNIEEvent error! Could not build the event index for "+input_filename,
+      v_error,verbosity_);
+    return index;
+  }
+  if (!index.Write(index_directory_)) {
+    Log("LoadANNIEEvent warning: Could not write event index "+ANNIEEventIndex::SidecarName(
+      input_filename,index_directory_)+", it will be rebuilt next time",v_warning,verbosity_);
+  }
+  return index;
+}
+
+bool LoadANNIEEvent::FindEvent(int run, int subrun, int part,
+  uint32_t event_number, EventTarget& target) {
+
+  for (size_t i_file = 0; i_file < input_filenames_.size(); ++i_file) {
+    const ANNIEEventIndex& index = GetIndex(i_file);
+    if (!index.IsValid()) continue;
+    long entry = index.FindEvent(run, subrun, part, event_number);
+    if (entry < 0) continue;
+    target.file = i_file;
+    target.entry = entry;
+    return true;
+  }
+  return false;
+}
+
+bool LoadANNIEEvent::FindTimestamp(uint64_t timestamp, EventTarget& target) {
+
+  // the files are not necessarily ordered in time, so take the earliest
+  // matching event over all of them
+  bool found = false;
+  uint64_t best_timestamp = 0;
+  for (size_t i_file = 0; i_file < input_filenames_.size(); ++i_file) {
+    const ANNIEEventIndex& index = GetIndex(i_file);
+    if (!index.IsValid() || index.LastTimestamp() < timestamp) continue;
+    long entry = index.FindTimestamp(timestamp);
+    if (entry < 0) continue;
+    uint64_t entry_timestamp = index.Entries().at(entry).timestamp;
+    if (!found || entry_timestamp < best_timestamp) {
+      found = true;
+      best_timestamp = entry_timestamp;
+      target.file = i_file;
+      target.entry = entry;
+    }
+  }
+  return found;
+}
+
+void LoadANNIEEvent::JumpTo(const EventTarget& target) {
+
+  // BoostStore multi-event files can only be read forwards, so going back
+  // within the loaded file means reopening it
+  if ((long)target.file != loaded_file_ || (long)target.entry <= last_loaded_entry_) {
+    need_new_file_ = true;
+  }
+  else need_new_file_ = false;
+  current_file_ = target.file;
+  current_entry_ = target.entry;
+
+  // global event number of the target, if the sizes of all preceding files are known
+  size_t start = 0;
+  bool known = true;
+  for (size_t i_file = 0; i_file < target.file; ++i_file) {
+    if (i_file < global_events.size()) {
+      start = global_events.at(i_file);
+      continue;
+    }
+    if (!event_index_loaded_.at(i_file) || !event_indices_.at(i_file).IsValid()) {
+      known = false;
+      break;
+    }
+    start += event_indices_.at(i_file).NumEntries();
+  }
+  if (known) global_ev = start + target.entry;
+}
+
+bool LoadANNIEEvent::LoadEventSelection(const std::string& selection_filename) {
+
+  wanted_events_.clear();
+  if (!ANNIEEventIndex::ReadEventSelection(selection_filename, wanted_events_)) {
+    Log("LoadANNIEEvent error! Could not open the SelectedEventsFile "+selection_filename,
+      v_error,verbosity_);
+    return false;
+  }
+  Log("LoadANNIEEvent: Will load the "+std::to_string(wanted_events_.size())
+    +" selected events",v_message,verbosity_);
+
+  // the files are indexed when the loop reaches them, not here
+  selected_events_.clear();
+  use_event_selection_ = true;
+  next_selected_ = 0;
+  selection_files_resolved_ = (wanted_events_.empty()) ? input_filenames_.size() : 0;
+  return true;
+}
+
+bool LoadANNIEEvent::ResolveNextSelectionFile() {
+
+  if (selection_files_resolved_ >= input_filenames_.size()) return false;
+  size_t i_file = selection_files_resolved_++;
+  const ANNIEEventIndex& index = GetIndex(i_file);
+  if (index.IsValid()) {
+    size_t first = selected_events_.size();
+    for (const auto& row : index.Entries()) {
+      if (wanted_events_.count(row.Key())) {
+        selected_events_.push_back({i_file, row.entry});
+      }
+    }
+    std::sort(selected_events_.begin()+first, selected_events_.end());
+  }
+
+  if (selection_files_resolved_ == input_filenames_.size()
+    && selected_events_.size() < wanted_events_.size()) {
+    Log("LoadANNIEEvent warning: only found "+std::to_string(selected_events_.size())
+      +" of the "+std::to_string(wanted_events_.size())+" selected events in the input files",
+      v_warning,verbosity_);
+  }
+  return true;
+}
+
+bool LoadANNIEEvent::HaveSelectedEvent() {
+
+  while (next_selected_ >= selected_events_.size()) {
+    if (!ResolveNextSelectionFile()) return false;
+  }
   return true;
 }
+
+std::vector<size_t> LoadANNIEEvent::UpcomingFiles() const {
+
+  std::vector<size_t> upcoming;
+  if (use_event_selection_) {
+    for (size_t i_sel = next_selected_; i_sel < selected_events_.size()
+      && upcoming.size() < prefetch_files_; ++i_sel) {
+      size_t file_index = selected_events_.at(i_sel).file;
+      if ((long)file_index == loaded_file_) continue;
+      if (upcoming.empty() || upcoming.back() != file_index) upcoming.push_back(file_index);
+    }
+  } else {
+    for (size_t file_index = current_file_+1; file_index < input_filenames_.size()
+      && upcoming.size() < prefetch_files_; ++file_index) {
+      upcoming.push_back(file_index);
+    }
+  }
+  return upcoming;
+}
+
+void LoadANNIEEvent::SchedulePrefetch() {
+
+  if (!prefetch_thread_.joinable()) return;
+  if (use_event_selection_) {
+    // index only as many files ahead as it takes to find the files to prefetch
+    while (UpcomingFiles().size() < prefetch_files_ && ResolveNextSelectionFile()) {}
+  }
+  std::vector<size_t> upcoming = UpcomingFiles();
+
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  // drop files we no longer need, e.g. after a seek
+  for (auto it = prefetched_files_.begin(); it != prefetched_files_.end(); ) {
+    if (std::find(upcoming.begin(), upcoming.end(), it->first) == upcoming.end()) {
+      CloseFile(it->second);
+      it = prefetched_files_.erase(it);
+    }
+    else ++it;
+  }
+  prefetch_queue_.clear();
+  for (size_t file_index : upcoming) {
+    if (prefetched_files_.count(file_index)) continue;
+    if (prefetch_inflight_ && prefetch_inflight_file_ == file_index) continue;
+    prefetch_queue_.push_back(file_index);
+  }
+  prefetch_cv_.notify_all();
+}
+
+bool LoadANNIEEvent::TakePrefetched(size_t file_index, OpenedFile& opened) {
+
+  if (!prefetch_thread_.joinable()) return false;
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+
+  // not started yet: cheaper to open it here than to wait for the queue
+  auto queued = std::find(prefetch_queue_.begin(), prefetch_queue_.end(), file_index);
+  if (queued != prefetch_queue_.end()) prefetch_queue_.erase(queued);
+
+  prefetch_cv_.wait(lock, [this, file_index]{
+    return !(prefetch_inflight_ && prefetch_inflight_file_ == file_index);
+  });
+
+  auto it = prefetched_files_.find(file_index);
+  if (it == prefetched_files_.end()) return false;
+  opened = it->second;
+  prefetched_files_.erase(it);
+  return true;
+}
+
+void LoadANNIEEvent::PrefetchLoop() {
+
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this]{ return stop_prefetch_ || !prefetch_queue_.empty(); });
+    if (stop_prefetch_) break;
+
+    size_t file_index = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    prefetch_inflight_ = true;
+    prefetch_inflight_file_ = file_index;
+    lock.unlock();
+
+    OpenedFile opened;
+    OpenFile(file_index, opened);
+
+    lock.lock();
+    prefetch_inflight_ = false;
+    prefetched_files_[file_index] = opened;
+    prefetch_cv_.notify_all();
+  }
+}
+
+void LoadANNIEEvent::StopPrefetch() {
+
+  if (!prefetch_thread_.joinable()) return;
+  {
+    std::unique_lock<std::mutex> lock(prefetch_mutex_);
+    stop_prefetch_ = true;
+    prefetch_queue_.clear();
+  }
+  prefetch_cv_.notify_all();
+  prefetch_thread_.join();
+
+  for (auto& prefetched : prefetched_files_) CloseFile(prefetched.second);
+  prefetched_files_.clear();
+}
@@ -1,11 +1,18 @@
 #pragma once
 
 // standard library includes
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 // ToolAnalysis includes
 #include "Tool.h"
+#include "ANNIEEventIndex.h"
 
 class LoadANNIEEvent: public Tool {
 
@@ -17,7 +24,70 @@ class LoadANNIEEvent: public Tool {
     bool Finalise();
 
   private:
-  
+
+    /// @brief The stores belonging to one opened input file
+    struct OpenedFile {
+      size_t file_index = 0;
+      BoostStore* processed_store = nullptr;
+      BoostStore* annie_event = nullptr;
+      BoostStore* orphan_store = nullptr;
+      /// @brief Stores of the key groups that were split off by SaveANNIEEvent
+      std::map<std::string, BoostStore*> key_group_stores;
+      size_t total_entries = 0;
+      size_t total_orphans = 0;
+      bool valid = false;
+    };
+
+    /// @brief A (file, entry) pair to be loaded
+    struct EventTarget {
+      size_t file;
+      size_t entry;
+      bool operator<(const EventTarget& other) const {
+        return (file < other.file) || (file == other.file && entry < other.entry);
+      }
+    };
+
+    /// @brief Open the stores of an input file. Only touches its arguments,
+    /// so it is safe to call from the prefetch thread.
+    bool OpenFile(size_t file_index, OpenedFile& opened) const;
+    void CloseFile(OpenedFile& opened) const;
+
+    /// @brief Replace the stores in m_data->Stores by those of file_index,
+    /// using a prefetched copy if there is one
+    bool LoadFile(size_t file_index);
+
+    /// @brief Extend global_events and global_events_start up to file_index,
+    /// which has n_entries entries
+    void FillGlobalEvents(size_t file_index, size_t n_entries);
+
+    /// @brief Get the sidecar index of a file, loading or building it on first use
+    const ANNIEEventIndex& GetIndex(size_t file_index);
+
+    /// @brief Seek API: find the file and entry of an event
+    bool FindEvent(int run, int subrun, int part, uint32_t event_number,
+      EventTarget& target);
+    bool FindTimestamp(uint64_t timestamp, EventTarget& target);
+    void JumpTo(const EventTarget& target);
+
+    /// @brief Read the (run subrun part event) list; it is resolved to entries
+    /// one file at a time, as the files are reached
+    bool LoadEventSelection(const std::string& selection_filename);
+    /// @brief Resolve the selection in the next file not yet looked at
+    /// (false once every file has been)
+    bool ResolveNextSelectionFile();
+    /// @brief Resolve files until there is a selected event left to load
+    bool HaveSelectedEvent();
+
+    /// @brief Read the current entry of the loaded key groups into the ANNIEEvent
+    void LoadKeyGroupEntry(size_t entry);
+
+    /// @brief Background opening of the files that will be needed next
+    std::vector<size_t> UpcomingFiles() const;
+    void SchedulePrefetch();
+    bool TakePrefetched(size_t file_index, OpenedFile& opened);
+    void PrefetchLoop();
+    void StopPrefetch();
+
     int v_error = 0;
     int v_warning = 1;
     int v_message = 2;
@@ -69,4 +139,43 @@ class LoadANNIEEvent: public Tool {
     std::stringstream logmessage;
     std::vector<int> global_events, global_events_start;
 
+    /// @brief Index of the file whose stores are currently in m_data->Stores (-1: none)
+    long loaded_file_ = -1;
+
+    /// @brief Last entry read from the currently loaded file (-1: none)
+    long last_loaded_entry_ = -1;
+
+    /// @brief Per-file sidecar event indices, built lazily
+    std::vector<ANNIEEventIndex> event_indices_;
+    std::vector<bool> event_index_loaded_;
+
+    /// @brief Directory for the sidecar indices (empty: next to the data files)
+    std::string index_directory_;
+
+    /// @brief Events selected via SelectedEventsFile, and those of them found
+    /// so far, sorted by file and entry
+    std::set<ANNIEEventKey> wanted_events_;
+    std::vector<EventTarget> selected_events_;
+    size_t next_selected_ = 0;
+    size_t selection_files_resolved_ = 0;
+    bool use_event_selection_ = false;
+
+    /// @brief Key groups to load from split files ("all" for every group in the file)
+    std::vector<std::string> load_key_groups_;
+    bool load_all_key_groups_ = false;
+
+    /// @brief Key group stores of the currently loaded file
+    std::map<std::string, BoostStore*> key_group_stores_;
+
+    /// @brief Number of upcoming files to open in the background (0: no prefetching)
+    size_t prefetch_files_ = 0;
+    std::thread prefetch_thread_;
+    std::mutex prefetch_mutex_;
+    std::condition_variable prefetch_cv_;
+    std::deque<size_t> prefetch_queue_;
+    std::map<size_t, OpenedFile> prefetched_files_;
+    bool prefetch_inflight_ = false;
+    size_t prefetch_inflight_file_ = 0;
+    bool stop_prefetch_ = false;
+
 };
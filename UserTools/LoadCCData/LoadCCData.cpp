@@ -1,6 +1,7 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 
 #include "LoadCCData.h"
+#include "ToolRegistry.h"
 #include "PMTData.h"
 #include "MRDTree.h"
 
@@ -16,6 +17,8 @@
 //#include <unordered_map>
 //#include <algorithm>
 
+REGISTER_TOOL(LoadCCData);
+
 LoadCCData::LoadCCData():Tool(){}
 
 // The MRDTimeStamp is a timestamp of when the TDC readout for that trigger
@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=2 wrap */
 #include "LoadGenieEvent.h"
+#include "ToolRegistry.h"
 
 #include "TChain.h"
 #include "TFile.h"
@@ -56,6 +57,8 @@ Genie 3.0.4.ub3 GNTP files: /pnfs/annie/persistent/simulation/genie3/G1810a0211a
 - input event information is passed to a genie::flux::GSimpleNtpEntry and genie::flux::GSimpleNtpNuMI object
 */
 
+REGISTER_TOOL(LoadGenieEvent);
+
 LoadGenieEvent::LoadGenieEvent():Tool(){}
 
 Position TVector3ToPosition(TVector3 tvecin);
@@ -81,6 +84,15 @@ bool LoadGenieEvent::Initialise(std::string configfile, DataModel &data){
 	m_variables.Get("ManualFileMatching",manualmatch);
 	m_variables.Get("EventOffset",evoffset);
 	m_variables.Get("FileEvents",fileevents);
+	m_variables.Get("LockstepWithWCSim",lockstep);
+	
+	int cachesizemb=0, cachelearnentries=0, parallelunzip=0;
+	m_variables.Get("TreeCacheSizeMB",cachesizemb);
+	m_variables.Get("CacheLearnEntries",cachelearnentries);
+	m_variables.Get("ParallelUnzip",parallelunzip);
+	treecache.cache_bytes = (long long)cachesizemb*1024*1024;
+	treecache.learn_entries = cachelearnentries;
+	treecache.parallel_unzip = parallelunzip;
 
 	// create a store for holding Genie information to pass to downstream Tools
 	// will be a single entry BoostStore containing a vector of single entry BoostStores
@@ -101,7 +113,11 @@ bool LoadGenieEvent::Initialise(std::string configfile, DataModel &data){
 		Log("Tool LoadGenieEvent: Read "+to_string(numbytes)+" bytes loading TChain "+inputfiles,v_debug,verbosity);
 		Log("Tool LoadGenieEvent: Genie TChain has "+to_string(flux->GetEntries())+" entries",v_message,verbosity);
 		SetBranchAddresses();
+		SetupReadCache();
 		tchainentrynum = evoffset;
+		// the GENIE and WCSim chains both start at entry 0; EventOffset matches
+		// LoadWCSim's FileStartOffset, which MCEventNum already includes
+		lockstepoffset = 0;
 		Log("LoadGenieEvent tool: # of flux entries: "+std::to_string(flux->GetEntries()),v_message,verbosity);
 	}
 
@@ -127,7 +143,9 @@ bool LoadGenieEvent::Initialise(std::string configfile, DataModel &data){
 		curf=TFile::Open(inputfile.c_str());
                 flux=(TChain*)curf->Get("gtree");
                 SetBranchAddresses();
+		SetupReadCache();
 		tchainentrynum = wcsimevnumber*fileevents;
+		lockstepoffset = wcsimevnumber*fileevents;
 	}
 
 	return true;
@@ -165,7 +183,28 @@ bool LoadGenieEvent::Execute(){
                         curf=TFile::Open(inputfiles.c_str());
                         flux=(TChain*)curf->Get("gtree");
                         SetBranchAddresses();
+                        SetupReadCache();
                 }
+        } else if(manualmatch || lockstep){
+		uint16_t MCTriggernum=0;
+		m_data->Stores["ANNIEEvent"]->Get("MCTriggernum",MCTriggernum);
+		if (MCTriggernum != 0){
+			m_data->CStore.Set("NewGENIEEntry",false);
+			return true;	//Don't evaluate new GENIE event for dealyed WCSim triggers
+		} else {
+			m_data->CStore.Set("NewGENIEEntry",true);
+		}
+		if(lockstep){
+			// follow the WCSim entry rather than counting executions, so that
+			// entries skipped or selected by LoadWCSim stay aligned
+			uint64_t MCEventNum=0;
+			get_ok = m_data->Stores["ANNIEEvent"]->Get("MCEventNum",MCEventNum);
+			if(!get_ok){
+				Log("Tool LoadGenieEvent: LockstepWithWCSim set but no MCEventNum in ANNIEEvent",v_error,verbosity);
+				return false;
+			}
+			tchainentrynum = lockstepoffset + MCEventNum;
+		}
         }
 	
 	Log("Tool LoadGenieEvent: Loading tchain entry "+to_string(tchainentrynum),v_message,verbosity);
@@ -184,16 +223,6 @@ bool LoadGenieEvent::Execute(){
 		curflast=curf;
 		Log("Tool LoadGenieEvent: Opening new file \""+currentfilestring+"\"",v_debug,verbosity);
 	}
-	if (manualmatch){
-		uint16_t MCTriggernum;
-		m_data->Stores["ANNIEEvent"]->Get("MCTriggernum",MCTriggernum);
-		if (MCTriggernum != 0){
-			m_data->CStore.Set("NewGENIEEntry",false);
-			return true;	//Don't evaluate new GENIE event for dealyed WCSim triggers
-		} else {
-			m_data->CStore.Set("NewGENIEEntry",true);
-		}
-	}
 	
 	// Expand out the neutrino event info
 	// =======================================================
@@ -510,6 +539,12 @@ void LoadGenieEvent::SetBranchAddresses(){
 	}
 }
 
+void LoadGenieEvent::SetupReadCache(){
+	if(not mctreecache::Configure(flux,treecache)){
+		Log("Tool LoadGenieEvent: Failed to set up the read cache, reading uncached",v_warning,verbosity);
+	}
+}
+
 void LoadGenieEvent::GetGenieEntryInfo(genie::EventRecord* gevtRec, genie::Interaction* genieint, GenieInfo &thegenieinfo, bool printneutrinoevent){
 	// process information:
 	/*TString*/ thegenieinfo.procinfostring = genieint->ProcInfo().AsString();
@@ -15,6 +15,7 @@
 
 #include "Tool.h"
 #include "GenieInfo.h"
+#include "MCTreeCache.h"
 #include "CLHEP/Random/RandGaussQ.h"
 #include "CLHEP/Random/JamesRandom.h"
 #include "Framework/Conventions/KineVar.h"
@@ -64,6 +65,8 @@ class LoadGenieEvent: public Tool {
 	
 	// function to load the branch addresses
 	void SetBranchAddresses();
+	// function to apply the configured read cache to the flux tree
+	void SetupReadCache();
 
 	// function to fill the info into the handy genieinfostruct
 	void GetGenieEntryInfo(genie::EventRecord* gevtRec, genie::Interaction* genieint,
@@ -105,6 +108,9 @@ class LoadGenieEvent: public Tool {
 	int tchainentrynum=0;         // 
 	bool manualmatch=0;			//to be used when GENIE information is not stored properly in file
 	int fileevents=0;
+	bool lockstep=false;			// take the entry from the WCSim MCEventNum
+	int lockstepoffset=0;			// GENIE entry of WCSim entry 0
+	mctreecache::Config treecache;
 
 	// common input/output variables to both Robert/Zarko filesets
 	int parentpdg;
@@ -0,0 +1,384 @@
+#include "GeometrySnapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+  const char snapshot_magic[8] = {'A','N','N','I','E','G','E','O'};
+  // increment whenever the snapshot layout changes
+  const uint32_t snapshot_version = 1;
+  const size_t header_size = sizeof(snapshot_magic) + sizeof(uint32_t) + 2*sizeof(uint64_t);
+
+  const uint64_t fnv_offset = 14695981039346656037ull;
+  const uint64_t fnv_prime = 1099511628211ull;
+
+  inline void HashBytes(uint64_t& hash, const char* data, size_t size){
+    for(size_t i=0; i<size; ++i){
+      hash ^= static_cast<unsigned char>(data[i]);
+      hash *= fnv_prime;
+    }
+  }
+
+  // Values are stored in native byte order: snapshots are a cache for the
+  // machine that made them, the CSVs remain the portable format
+  class SnapshotWriter {
+   public:
+    template<typename T> void Put(const T& value){
+      static_assert(std::is_trivially_copyable<T>::value, "SnapshotWriter::Put needs a plain value");
+      buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void Put(const std::string& value){
+      Put<uint32_t>(value.size());
+      buffer.append(value);
+    }
+    template<typename T> void Put(const std::vector<T>& values){
+      Put<uint32_t>(values.size());
+      for(const T& value : values) Put(value);
+    }
+    template<typename K, typename V> void Put(const std::map<K,V>& values){
+      Put<uint32_t>(values.size());
+      for(const auto& pair : values){ Put(pair.first); Put(pair.second); }
+    }
+    void Put(Position pos){ Put(pos.X()); Put(pos.Y()); Put(pos.Z()); }
+
+    std::string buffer;
+  };
+
+  class SnapshotReader {
+   public:
+    SnapshotReader(const char* data, size_t size) : ok(true), pos(data), end(data+size) {}
+
+    template<typename T> void Get(T& value){
+      static_assert(std::is_trivially_copyable<T>::value, "SnapshotReader::Get needs a plain value");
+      if(!Have(sizeof(T))) return;
+      std::memcpy(&value, pos, sizeof(T));
+      pos += sizeof(T);
+    }
+    void Get(std::string& value){
+      uint32_t size = 0;
+      Get(size);
+      if(!Have(size)) return;
+      value.assign(pos, size);
+      pos += size;
+    }
+    template<typename T> void Get(std::vector<T>& values){
+      uint32_t size = 0;
+      Get(size);
+      values.clear();
+      for(uint32_t i=0; i<size && ok; ++i){
+        T value;
+        Get(value);
+        values.push_back(value);
+      }
+    }
+    template<typename K, typename V> void Get(std::map<K,V>& values){
+      uint32_t size = 0;
+      Get(size);
+      values.clear();
+      for(uint32_t i=0; i<size && ok; ++i){
+        K key;
+        V value;
+        Get(key);
+        Get(value);
+        values.emplace(key, value);
+      }
+    }
+    Position GetPosition(){
+      double x = 0., y = 0., z = 0.;
+      Get(x); Get(y); Get(z);
+      return Position(x, y, z);
+    }
+    bool AtEnd() const { return pos==end; }
+
+    bool ok;
+
+   private:
+    bool Have(size_t size){
+      if(ok && static_cast<size_t>(end-pos)<size) ok = false;
+      return ok;
+    }
+    const char* pos;
+    const char* end;
+  };
+
+  void WriteGeometry(SnapshotWriter& out, Geometry* geometry){
+    out.Put(geometry->GetVersion());
+    out.Put(geometry->GetStatus());
+    out.Put(geometry->GetTankCentre());
+    out.Put(geometry->GetTankRadius());
+    out.Put(geometry->GetTankHalfheight());
+    out.Put(geometry->GetPMTEnclosedRadius());
+    out.Put(geometry->GetPMTEnclosedHalfheight());
+    out.Put(geometry->GetMrdWidth());
+    out.Put(geometry->GetMrdHeight());
+    out.Put(geometry->GetMrdDepth());
+    out.Put(geometry->GetMrdStart());
+
+    uint32_t num_detectors = 0;
+    for(auto&& aset : *geometry->GetDetectors()) num_detectors += aset.second.size();
+    out.Put(num_detectors);
+    for(auto&& aset : *geometry->GetDetectors()){
+      for(auto&& apair : aset.second){
+        Detector* adet = apair.second;
+        out.Put<int32_t>(adet->GetDetectorID());
+        out.Put(adet->GetDetectorElement());
+        out.Put(adet->GetTankLocation());
+        out.Put(adet->GetDetectorPosition());
+        Direction dir = adet->GetDetectorDirection();
+        out.Put(dir.X()); out.Put(dir.Y()); out.Put(dir.Z());
+        out.Put(adet->GetDetectorType());
+        out.Put(adet->GetStatus());
+        out.Put<uint32_t>(adet->GetChannels()->size());
+        for(auto&& achannelpair : *adet->GetChannels()){
+          Channel& achannel = achannelpair.second;
+          out.Put<uint64_t>(achannel.GetChannelID());
+          out.Put(achannel.GetChannelPosition());
+          out.Put<int32_t>(achannel.GetStripSide());
+          out.Put<int32_t>(achannel.GetStripNum());
+          out.Put<uint32_t>(achannel.GetSignalCrate());
+          out.Put<uint32_t>(achannel.GetSignalCard());
+          out.Put<uint32_t>(achannel.GetSignalChannel());
+          out.Put<uint32_t>(achannel.GetLevel2Crate());
+          out.Put<uint32_t>(achannel.GetLevel2Card());
+          out.Put<uint32_t>(achannel.GetLevel2Channel());
+          out.Put<uint32_t>(achannel.GetHvCrate());
+          out.Put<uint32_t>(achannel.GetHvCard());
+          out.Put<uint32_t>(achannel.GetHvChannel());
+          out.Put(achannel.GetStatus());
+        }
+      }
+    }
+
+    out.Put<uint32_t>(geometry->GetPaddles()->size());
+    for(auto&& apair : *geometry->GetPaddles()){
+      Paddle& apaddle = apair.second;
+      out.Put<uint64_t>(apair.first);
+      out.Put<int32_t>(apaddle.GetPaddleX());
+      out.Put<int32_t>(apaddle.GetPaddleY());
+      out.Put<int32_t>(apaddle.GetPaddleZ());
+      out.Put<int32_t>(apaddle.GetOrientation());
+      out.Put(apaddle.GetOrigin());
+      out.Put(apaddle.GetXmin()); out.Put(apaddle.GetXmax());
+      out.Put(apaddle.GetYmin()); out.Put(apaddle.GetYmax());
+      out.Put(apaddle.GetZmin()); out.Put(apaddle.GetZmax());
+    }
+  }
+
+  Geometry* ReadGeometry(SnapshotReader& in){
+    double version = 0.;
+    geostatus status = geostatus::FULLY_OPERATIONAL;
+    double tank_radius = 0., tank_halfheight = 0., pmt_enclosed_radius = 0., pmt_enclosed_halfheight = 0.;
+    double mrd_width = 0., mrd_height = 0., mrd_depth = 0., mrd_start = 0.;
+    in.Get(version);
+    in.Get(status);
+    Position tank_centre = in.GetPosition();
+    in.Get(tank_radius);
+    in.Get(tank_halfheight);
+    in.Get(pmt_enclosed_radius);
+    in.Get(pmt_enclosed_halfheight);
+    in.Get(mrd_width);
+    in.Get(mrd_height);
+    in.Get(mrd_depth);
+    in.Get(mrd_start);
+    if(!in.ok) return nullptr;
+
+    // the PMT and LAPPD counts are filled in from the detector sets on first use, as with LoadGeometry
+    Geometry* geometry = new Geometry(version, tank_centre, tank_radius, tank_halfheight,
+      pmt_enclosed_radius, pmt_enclosed_halfheight, mrd_width, mrd_height, mrd_depth, mrd_start,
+      0, 0, 0, 0, status);
+
+    uint32_t num_detectors = 0;
+    in.Get(num_detectors);
+    for(uint32_t i=0; i<num_detectors && in.ok; ++i){
+      int32_t detector_id = 0;
+      std::string element, location, type;
+      double dir_x = 0., dir_y = 0., dir_z = 0.;
+      detectorstatus detstatus = detectorstatus::OFF;
+      uint32_t num_channels = 0;
+      in.Get(detector_id);
+      in.Get(element);
+      in.Get(location);
+      Position detector_position = in.GetPosition();
+      in.Get(dir_x); in.Get(dir_y); in.Get(dir_z);
+      in.Get(type);
+      in.Get(detstatus);
+      in.Get(num_channels);
+      Detector adet(detector_id, element, location, detector_position,
+        Direction(dir_x, dir_y, dir_z), type, detstatus, 0.);
+
+      for(uint32_t j=0; j<num_channels && in.ok; ++j){
+        uint64_t channel_id = 0;
+        int32_t strip_side = 0, strip_num = 0;
+        uint32_t electronics[9] = {0};
+        channelstatus chanstatus = channelstatus::OFF;
+        in.Get(channel_id);
+        Position channel_position = in.GetPosition();
+        in.Get(strip_side);
+        in.Get(strip_num);
+        for(uint32_t& value : electronics) in.Get(value);
+        in.Get(chanstatus);
+        adet.AddChannel(Channel(channel_id, channel_position, strip_side, strip_num,
+          electronics[0], electronics[1], electronics[2],
+          electronics[3], electronics[4], electronics[5],
+          electronics[6], electronics[7], electronics[8], chanstatus));
+      }
+      if(in.ok && !geometry->AddDetector(adet)) in.ok = false;
+    }
+
+    uint32_t num_paddles = 0;
+    in.Get(num_paddles);
+    for(uint32_t i=0; i<num_paddles && in.ok; ++i){
+      uint64_t detector_key = 0;
+      int32_t x = 0, y = 0, z = 0, orientation = 0;
+      double xmin = 0., xmax = 0., ymin = 0., ymax = 0., zmin = 0., zmax = 0.;
+      in.Get(detector_key);
+      in.Get(x); in.Get(y); in.Get(z);
+      in.Get(orientation);
+      Position origin = in.GetPosition();
+      in.Get(xmin); in.Get(xmax);
+      in.Get(ymin); in.Get(ymax);
+      in.Get(zmin); in.Get(zmax);
+      if(!in.ok) break;
+      Paddle apaddle(detector_key, x, y, z, orientation, origin,
+        std::pair<double,double>{xmin, xmax}, std::pair<double,double>{ymin, ymax},
+        std::pair<double,double>{zmin, zmax});
+      if(!geometry->SetDetectorPaddle(detector_key, apaddle)) in.ok = false;
+    }
+
+    if(!in.ok){
+      delete geometry;
+      return nullptr;
+    }
+    return geometry;
+  }
+
+}
+
+namespace geometrysnapshot {
+
+  bool Checksum(const std::vector<std::string>& files, int lappd_channel_count,
+    uint64_t& checksum){
+    checksum = fnv_offset;
+    for(const std::string& filename : files){
+      std::ifstream infile(filename, std::ios::binary);
+      if(!infile.good()) return false;
+      std::string contents((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+      // include the length so content can't move between files unnoticed
+      uint64_t length = contents.size();
+      HashBytes(checksum, reinterpret_cast<const char*>(&length), sizeof(length));
+      HashBytes(checksum, contents.data(), contents.size());
+    }
+    HashBytes(checksum, reinterpret_cast<const char*>(&lappd_channel_count), sizeof(lappd_channel_count));
+    return true;
+  }
+
+  bool Write(const std::string& filename, uint64_t checksum, Geometry* geometry,
+    const GeometryChannelMaps& maps){
+    SnapshotWriter payload;
+    WriteGeometry(payload, geometry);
+    payload.Put(*maps.MRDCrateSpaceToChannelNumMap);
+    payload.Put(*maps.MRDChannelNumToCrateSpaceMap);
+    payload.Put(*maps.TankPMTCrateSpaceToChannelNumMap);
+    payload.Put(*maps.AuxCrateSpaceToChannelNumMap);
+    payload.Put(*maps.ChannelNumToTankPMTCrateSpaceMap);
+    payload.Put(*maps.AuxChannelNumToCrateSpaceMap);
+    payload.Put(*maps.ChannelNumToTankPMTSPEChargeMap);
+    payload.Put(*maps.ChannelNumToTankPMTTimingOffsetMap);
+    payload.Put(*maps.AuxChannelNumToTypeMap);
+    payload.Put(*maps.LAPPDCrateSpaceToChannelNumMap);
+
+    // write to a temporary file and move it into place, so concurrent jobs
+    // never see a partly written snapshot
+    std::string tempname = filename + ".tmp" + std::to_string(getpid());
+    std::ofstream outfile(tempname, std::ios::binary | std::ios::trunc);
+    if(!outfile.good()) return false;
+    uint64_t payload_size = payload.buffer.size();
+    outfile.write(snapshot_magic, sizeof(snapshot_magic));
+    outfile.write(reinterpret_cast<const char*>(&snapshot_version), sizeof(snapshot_version));
+    outfile.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    outfile.write(reinterpret_cast<const char*>(&payload_size), sizeof(payload_size));
+    outfile.write(payload.buffer.data(), payload.buffer.size());
+    outfile.close();
+    if(!outfile.good() || std::rename(tempname.c_str(), filename.c_str())!=0){
+      std::remove(tempname.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  Geometry* Read(const std::string& filename, uint64_t checksum,
+    GeometryChannelMaps& maps){
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd<0) return nullptr;
+    struct stat file_stat;
+    if(fstat(fd, &file_stat)!=0 || static_cast<size_t>(file_stat.st_size)<header_size){
+      close(fd);
+      return nullptr;
+    }
+    size_t file_size = file_stat.st_size;
+    void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped==MAP_FAILED) return nullptr;
+
+    const char* data = static_cast<const char*>(mapped);
+    SnapshotReader header(data, header_size);
+    char magic[sizeof(snapshot_magic)];
+    uint32_t version = 0;
+    uint64_t file_checksum = 0, payload_size = 0;
+    for(char& c : magic) header.Get(c);
+    header.Get(version);
+    header.Get(file_checksum);
+    header.Get(payload_size);
+
+    Geometry* geometry = nullptr;
+    if(std::memcmp(magic, snapshot_magic, sizeof(magic))==0 && version==snapshot_version
+      && file_checksum==checksum && payload_size==file_size-header_size){
+      SnapshotReader in(data+header_size, payload_size);
+      geometry = ReadGeometry(in);
+      // read the maps into temporaries, so the tool's maps are untouched if the snapshot is bad
+      std::map<std::vector<int>,int> mrd_crate_to_channel, tank_crate_to_channel, aux_crate_to_channel;
+      std::map<int,std::vector<int>> mrd_channel_to_crate, tank_channel_to_crate, aux_channel_to_crate;
+      std::map<int,double> spe_charges;
+      std::map<unsigned long,double> timing_offsets;
+      std::map<int,std::string> aux_types;
+      std::map<std::vector<unsigned int>,int> lappd_crate_to_channel;
+      in.Get(mrd_crate_to_channel);
+      in.Get(mrd_channel_to_crate);
+      in.Get(tank_crate_to_channel);
+      in.Get(aux_crate_to_channel);
+      in.Get(tank_channel_to_crate);
+      in.Get(aux_channel_to_crate);
+      in.Get(spe_charges);
+      in.Get(timing_offsets);
+      in.Get(aux_types);
+      in.Get(lappd_crate_to_channel);
+      if(geometry!=nullptr && in.ok && in.AtEnd()){
+        maps.MRDCrateSpaceToChannelNumMap->swap(mrd_crate_to_channel);
+        maps.MRDChannelNumToCrateSpaceMap->swap(mrd_channel_to_crate);
+        maps.TankPMTCrateSpaceToChannelNumMap->swap(tank_crate_to_channel);
+        maps.AuxCrateSpaceToChannelNumMap->swap(aux_crate_to_channel);
+        maps.ChannelNumToTankPMTCrateSpaceMap->swap(tank_channel_to_crate);
+        maps.AuxChannelNumToCrateSpaceMap->swap(aux_channel_to_crate);
+        maps.ChannelNumToTankPMTSPEChargeMap->swap(spe_charges);
+        maps.ChannelNumToTankPMTTimingOffsetMap->swap(timing_offsets);
+        maps.AuxChannelNumToTypeMap->swap(aux_types);
+        maps.LAPPDCrateSpaceToChannelNumMap->swap(lappd_crate_to_channel);
+      } else {
+        delete geometry;
+        geometry = nullptr;
+      }
+    }
+
+    munmap(mapped, file_size);
+    return geometry;
+  }
+
+}
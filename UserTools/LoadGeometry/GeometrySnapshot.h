@@ -0,0 +1,51 @@
+#ifndef GeometrySnapshot_H
+#define GeometrySnapshot_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Geometry.h"
+
+// The electronics maps LoadGeometry puts in the CStore alongside the Geometry
+struct GeometryChannelMaps {
+  std::map<std::vector<int>,int>* MRDCrateSpaceToChannelNumMap = nullptr;
+  std::map<int,std::vector<int>>* MRDChannelNumToCrateSpaceMap = nullptr;
+  std::map<std::vector<int>,int>* TankPMTCrateSpaceToChannelNumMap = nullptr;
+  std::map<std::vector<int>,int>* AuxCrateSpaceToChannelNumMap = nullptr;
+  std::map<int,std::vector<int>>* ChannelNumToTankPMTCrateSpaceMap = nullptr;
+  std::map<int,std::vector<int>>* AuxChannelNumToCrateSpaceMap = nullptr;
+  std::map<int,double>* ChannelNumToTankPMTSPEChargeMap = nullptr;
+  std::map<unsigned long,double>* ChannelNumToTankPMTTimingOffsetMap = nullptr;
+  std::map<int,std::string>* AuxChannelNumToTypeMap = nullptr;
+  std::map<std::vector<unsigned int>,int>* LAPPDCrateSpaceToChannelNumMap = nullptr;
+};
+
+// Binary snapshot of everything LoadGeometry builds from its CSV files.
+//
+// The file starts with a magic string, a format version and a checksum of the
+// source CSV files (and the settings that affect how they are read). A snapshot
+// whose checksum does not match the current CSVs is ignored, so the geometry is
+// reparsed and the snapshot rewritten whenever a CSV changes.
+namespace geometrysnapshot {
+
+  // FNV-1a checksum of the contents of the given files, plus the LAPPD channel
+  // count used to group LAPPD channels into detectors. Returns false if a file
+  // can't be read.
+  bool Checksum(const std::vector<std::string>& files, int lappd_channel_count,
+    uint64_t& checksum);
+
+  // Write the geometry and channel maps to filename
+  bool Write(const std::string& filename, uint64_t checksum, Geometry* geometry,
+    const GeometryChannelMaps& maps);
+
+  // Memory-map filename and rebuild the geometry and channel maps from it.
+  // Returns nullptr if the file is missing, was made from different CSVs, or
+  // is corrupt. The maps must already be allocated; they are filled in.
+  Geometry* Read(const std::string& filename, uint64_t checksum,
+    GeometryChannelMaps& maps);
+
+}
+
+#endif
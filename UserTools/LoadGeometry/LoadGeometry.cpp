@@ -1,4 +1,7 @@
 #include "LoadGeometry.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LoadGeometry);
 
 LoadGeometry::LoadGeometry():Tool(),adet(nullptr),AnnieGeometry(nullptr),LAPPD_channel_count(0){}
 
@@ -25,6 +28,7 @@ bool LoadGeometry::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("LAPPDGeoFile", fLAPPDGeoFile);
   m_variables.Get("DetectorGeoFile", fDetectorGeoFile);
   m_variables.Get("LAPPDChannelCount", LAPPD_channel_count);
+  m_variables.Get("GeometrySnapshotFile", fGeometrySnapshotFile);
 
   std::cout << "Filepath was... " << fDetectorGeoFile << std::endl;
   std::cout << "Filepath was... " << fLAPPDGeoFile << std::endl;
@@ -83,6 +87,64 @@ bool LoadGeometry::Initialise(std::string configfile, DataModel &data){
   AuxChannelNumToCrateSpaceMap = new std::map<int,std::vector<int>>;
   LAPPDCrateSpaceToChannelNumMap = new std::map<std::vector<unsigned int>,int>;
 
+  GeometryChannelMaps channel_maps;
+  channel_maps.MRDCrateSpaceToChannelNumMap = MRDCrateSpaceToChannelNumMap;
+  channel_maps.MRDChannelNumToCrateSpaceMap = MRDChannelNumToCrateSpaceMap;
+  channel_maps.TankPMTCrateSpaceToChannelNumMap = TankPMTCrateSpaceToChannelNumMap;
+  channel_maps.AuxCrateSpaceToChannelNumMap = AuxCrateSpaceToChannelNumMap;
+  channel_maps.ChannelNumToTankPMTCrateSpaceMap = ChannelNumToTankPMTCrateSpaceMap;
+  channel_maps.AuxChannelNumToCrateSpaceMap = AuxChannelNumToCrateSpaceMap;
+  channel_maps.ChannelNumToTankPMTSPEChargeMap = ChannelNumToTankPMTSPEChargeMap;
+  channel_maps.ChannelNumToTankPMTTimingOffsetMap = ChannelNumToTankPMTTimingOffsetMap;
+  channel_maps.AuxChannelNumToTypeMap = AuxChannelNumToTypeMap;
+  channel_maps.LAPPDCrateSpaceToChannelNumMap = LAPPDCrateSpaceToChannelNumMap;
+
+  //Use the binary snapshot if it was made from the current CSV files
+  uint64_t csv_checksum = 0;
+  bool use_snapshot = false;
+  if(fGeometrySnapshotFile!=""){
+    use_snapshot = geometrysnapshot::Checksum({fDetectorGeoFile, fFACCMRDGeoFile, fTankPMTGeoFile,
+                                               fTankPMTGainFile, fTankPMTTimingOffsetFile,
+                                               fAuxChannelFile, fLAPPDGeoFile},
+                                              LAPPD_channel_count, csv_checksum);
+    if(use_snapshot) AnnieGeometry = geometrysnapshot::Read(fGeometrySnapshotFile, csv_checksum, channel_maps);
+  }
+
+  if(AnnieGeometry!=nullptr){
+    Log("LoadGeometry tool: Loaded geometry from snapshot "+fGeometrySnapshotFile,v_message,verbosity);
+  } else {
+    this->LoadFromCSVFiles();
+    if(use_snapshot){
+      if(geometrysnapshot::Write(fGeometrySnapshotFile, csv_checksum, AnnieGeometry, channel_maps)){
+        Log("LoadGeometry tool: Wrote geometry snapshot "+fGeometrySnapshotFile,v_message,verbosity);
+      } else {
+        Log("LoadGeometry tool: Could not write geometry snapshot "+fGeometrySnapshotFile,v_warning,verbosity);
+      }
+    }
+  }
+
+  //Fill the dense channel/detector lookup tables now, rather than on the first hit
+  AnnieGeometry->BuildLookupTables();
+
+  m_data->Stores.at("ANNIEEvent")->Header->Set("AnnieGeometry",AnnieGeometry,true);
+
+  m_data->CStore.Set("MRDCrateSpaceToChannelNumMap",MRDCrateSpaceToChannelNumMap);
+  m_data->CStore.Set("MRDChannelNumToCrateSpaceMap",MRDChannelNumToCrateSpaceMap);
+  m_data->CStore.Set("TankPMTCrateSpaceToChannelNumMap",TankPMTCrateSpaceToChannelNumMap);
+  m_data->CStore.Set("ChannelNumToTankPMTCrateSpaceMap",ChannelNumToTankPMTCrateSpaceMap);
+  m_data->CStore.Set("ChannelNumToTankPMTSPEChargeMap",ChannelNumToTankPMTSPEChargeMap);
+  m_data->CStore.Set("ChannelNumToTankPMTTimingOffsetMap",ChannelNumToTankPMTTimingOffsetMap);
+  m_data->CStore.Set("AuxCrateSpaceToChannelNumMap",AuxCrateSpaceToChannelNumMap);
+  m_data->CStore.Set("AuxChannelNumToCrateSpaceMap",AuxChannelNumToCrateSpaceMap);
+  m_data->CStore.Set("AuxChannelNumToTypeMap",AuxChannelNumToTypeMap);
+  m_data->CStore.Set("LAPPDCrateSpaceToChannelNumMap",LAPPDCrateSpaceToChannelNumMap);
+   //AnnieGeometry->GetChannel(0); // trigger InitChannelMap
+
+  return true;
+}
+
+
+void LoadGeometry::LoadFromCSVFiles(){
   //Initialize the geometry using the geometry CSV file entries
   this->InitializeGeometry();
 
@@ -103,22 +165,6 @@ bool LoadGeometry::Initialise(std::string configfile, DataModel &data){
 
   //Load LAPPD Geometry Information
   this->LoadLAPPDs();
-
-  m_data->Stores.at("ANNIEEvent")->Header->Set("AnnieGeometry",AnnieGeometry,true);
-
-  m_data->CStore.Set("MRDCrateSpaceToChannelNumMap",MRDCrateSpaceToChannelNumMap);
-  m_data->CStore.Set("MRDChannelNumToCrateSpaceMap",MRDChannelNumToCrateSpaceMap);
-  m_data->CStore.Set("TankPMTCrateSpaceToChannelNumMap",TankPMTCrateSpaceToChannelNumMap);
-  m_data->CStore.Set("ChannelNumToTankPMTCrateSpaceMap",ChannelNumToTankPMTCrateSpaceMap);
-  m_data->CStore.Set("ChannelNumToTankPMTSPEChargeMap",ChannelNumToTankPMTSPEChargeMap);
-  m_data->CStore.Set("ChannelNumToTankPMTTimingOffsetMap",ChannelNumToTankPMTTimingOffsetMap);
-  m_data->CStore.Set("AuxCrateSpaceToChannelNumMap",AuxCrateSpaceToChannelNumMap);
-  m_data->CStore.Set("AuxChannelNumToCrateSpaceMap",AuxChannelNumToCrateSpaceMap);
-  m_data->CStore.Set("AuxChannelNumToTypeMap",AuxChannelNumToTypeMap);
-  m_data->CStore.Set("LAPPDCrateSpaceToChannelNumMap",LAPPDCrateSpaceToChannelNumMap);
-   //AnnieGeometry->GetChannel(0); // trigger InitChannelMap
-
-  return true;
 }
 
 
@@ -6,6 +6,7 @@
 
 #include "Tool.h"
 #include "Geometry.h"
+#include "GeometrySnapshot.h"
 #include <boost/algorithm/string.hpp>
 
 class LoadGeometry: public Tool {
@@ -37,6 +38,7 @@ class LoadGeometry: public Tool {
                                std::vector<std::string> AuxChannelLegendEntries);
   void LoadTankPMTGains();
   void LoadTankPMTTimingOffsets();
+  void LoadFromCSVFiles();
 
   Geometry* AnnieGeometry;
 
@@ -54,6 +56,7 @@ class LoadGeometry: public Tool {
   std::string fAuxChannelFile;
   std::string fLAPPDGeoFile;
   std::string fDetectorGeoFile;
+  std::string fGeometrySnapshotFile;
 
   //Labels used in Geometry files to mark the legend and data entries
   std::string LegendLineLabel = "LEGEND_LINE";
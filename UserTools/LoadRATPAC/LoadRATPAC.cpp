@@ -1,4 +1,7 @@
 #include "LoadRATPAC.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LoadRATPAC);
 
 LoadRATPAC::LoadRATPAC():Tool(){}
 
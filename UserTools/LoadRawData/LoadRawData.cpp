@@ -1,4 +1,7 @@
 #include "LoadRawData.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LoadRawData);
 
 LoadRawData::LoadRawData():Tool(){}
 
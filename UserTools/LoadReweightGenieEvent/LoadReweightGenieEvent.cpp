@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=2 wrap */
 #include "LoadReweightGenieEvent.h"
+#include "ToolRegistry.h"
 
 #include "TChain.h"
 #include "TFile.h"
@@ -56,6 +57,8 @@ Genie 3.0.4.ub3 GNTP files: /pnfs/annie/persistent/simulation/genie3/G1810a0211a
 - input event information is passed to a genie::flux::GSimpleNtpEntry and genie::flux::GSimpleNtpNuMI object
 */
 
+REGISTER_TOOL(LoadReweightGenieEvent);
+
 LoadReweightGenieEvent::LoadReweightGenieEvent():Tool(){}
 
 Position TVector3ToPositionRW(TVector3 tvecin);
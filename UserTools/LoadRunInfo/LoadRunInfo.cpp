@@ -1,4 +1,7 @@
 #include "LoadRunInfo.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LoadRunInfo);
 
 LoadRunInfo::LoadRunInfo():Tool(){}
 
@@ -1,6 +1,9 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 
 #include "LoadWCSim.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(LoadWCSim);
 
 LoadWCSim::LoadWCSim():Tool(){}
 
@@ -145,6 +148,16 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 	MCEventNum=0;
 	get_ok = m_variables.Get("FileStartOffset",MCEventNum);
 	
+	// read cache for the wcsimT chain; each tree basket is otherwise read
+	// and decompressed separately when GetEntry is called
+	int cachesizemb=0, cachelearnentries=0, parallelunzip=0;
+	m_variables.Get("TreeCacheSizeMB",cachesizemb);
+	m_variables.Get("CacheLearnEntries",cachelearnentries);
+	m_variables.Get("ParallelUnzip",parallelunzip);
+	treecache.cache_bytes = (long long)cachesizemb*1024*1024;
+	treecache.learn_entries = cachelearnentries;
+	treecache.parallel_unzip = parallelunzip;
+	
 	// put version in the CStore for downstream tools
 	m_data->CStore.Set("WCSimVersion", WCSimVersion);
 	
@@ -180,6 +193,9 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 //	wcsimtree= (TTree*) file->Get("wcsimT");
 //	WCSimEntry= new wcsimT(wcsimtree);
 	WCSimEntry= new wcsimT(MCFile.c_str(),verbosity);
+	if(not mctreecache::Configure(WCSimEntry->fChain,treecache)){
+		Log("LoadWCSim Tool: Failed to set up the read cache, reading uncached",v_warning,verbosity);
+	}
 	
 	gROOT->cd();
 	wcsimrootgeom = WCSimEntry->wcsimrootgeom;
@@ -10,6 +10,7 @@
 #include "TFile.h"
 #include "TTree.h"
 #include "wcsimT.h"
+#include "MCTreeCache.h"
 #include "Particle.h"
 #include "Hit.h"
 #include "Waveform.h"
@@ -77,6 +78,7 @@ class LoadWCSim: public Tool {
 	//TFile* file;
 	//TTree* wcsimtree;
 	wcsimT* WCSimEntry; // from makeclass
+	mctreecache::Config treecache;
 	WCSimRootTrigger* atrigt, *atrigm, *atrigv;
 	WCSimRootTrigger* firsttrigt, *firsttrigm, *firsttrigv;
 	WCSimRootGeom* wcsimrootgeom;
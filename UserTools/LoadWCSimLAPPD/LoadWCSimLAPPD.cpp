@@ -1,6 +1,7 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 
 #include "LoadWCSimLAPPD.h"
+#include "ToolRegistry.h"
 #include "LAPPDTree.h"
 
 // for drawing
@@ -19,6 +20,8 @@
 #include <chrono>          // std::chrono::seconds
 #include <time.h>          // clock_t, clock, CLOCKS_PER_SEC
 
+REGISTER_TOOL(LoadWCSimLAPPD);
+
 LoadWCSimLAPPD::LoadWCSimLAPPD():Tool(){}
 
 bool LoadWCSimLAPPD::Initialise(std::string configfile, DataModel &data){
@@ -1,4 +1,7 @@
 #include "MCHitToHitComparer.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MCHitToHitComparer);
 
 MCHitToHitComparer::MCHitToHitComparer():Tool(){}
 
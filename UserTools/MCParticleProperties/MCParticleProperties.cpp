@@ -1,11 +1,15 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "MCParticleProperties.h"
+#include "ToolRegistry.h"
 #include "MRDSubEventClass.hh"      // a class for defining subevents
 #include "MRDTrackClass.hh"         // a class for defining MRD tracks  - needed for cMRDTrack EnergyLoss TF1
 
 #include "Position.h"
+#include "PdgTable.h"
 #include "TF1.h"
 
+REGISTER_TOOL(MCParticleProperties);
+
 MCParticleProperties::MCParticleProperties():Tool(){}
 
 bool MCParticleProperties::Initialise(std::string configfile, DataModel &data){
@@ -78,6 +82,11 @@ bool MCParticleProperties::Execute(){
 		return false;
 	}
 	
+	// Find the tank and MRD intercepts of all particles in one pass
+	// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	Log("MCParticleProperties Tool: Calculating tank and MRD intercepts",v_debug,verbosity);
+	CalculateIntercepts();
+	
 	// Loop over reconstructed tracks and calculate additional properties
 	// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 	Log("MCParticleProperties Tool: Looping over MCParticles",v_debug,verbosity);
@@ -91,10 +100,8 @@ bool MCParticleProperties::Execute(){
 			nextparticle->Print();
 			cout<<"<<<<<<<<<<<<<<<<"<<endl;
 		}
-		Position startvertex = nextparticle->GetStartVertex();
-		startvertex.UnitToCentimeter();
-		Position stopvertex = nextparticle->GetStopVertex();
-		stopvertex.UnitToCentimeter();
+		Position startvertex(tracks.start_x[tracki],tracks.start_y[tracki],tracks.start_z[tracki]);
+		Position stopvertex(tracks.stop_x[tracki],tracks.stop_y[tracki],tracks.stop_z[tracki]);
 		
 		Position differencevector = (stopvertex-startvertex);
 		double atracklengthtotal = differencevector.Mag();
@@ -162,21 +169,16 @@ bool MCParticleProperties::Execute(){
 		// Calculate whether the extended (projected) particle trajectory would hit the MRD (first layer)
 		//======================================================================================================
 
-		atrackprojectedhitmrd  =  CheckProjectedMRDHit(startvertex, stopvertex, MRDSpecs::MRD_width, MRDSpecs::MRD_height,MRDSpecs::MRD_start);
+		atrackprojectedhitmrd = projectedhitsmrd.at(tracki);
 		
-		//new version based on external function calls
-		///////////////////////////////////////////////
-		// bool CheckLineBox( Position L1, Position L2, Position B1, Position B2, 
-		//					  Position &Hit, Position &Hit2, bool &error)
-		// returns true if line (L1, L2) intersects with the box (B1, B2)
-		// returns intersection with smaller Z in Hit
-		// if 2 interceptions are found, returns interception with larger Z,
-		// if 1 interception is found, returns L2 (stopping point).
-		// error returns true if >2 intercepts are found, or other error.
-		atrackentersmrd  =  CheckLineBox(startvertex, stopvertex, 
-										Position(-MRDSpecs::MRD_width,-MRDSpecs::MRD_height,MRDSpecs::MRD_start), 
-										Position(MRDSpecs::MRD_width,MRDSpecs::MRD_height,MRDSpecs::MRD_end),
-										MRDentrypoint, MRDexitpoint, checkboxlinerror);
+		// MRD entry and exit as found by CheckLineBox (batched in CalculateIntercepts):
+		// entry is the intersection with smaller Z, exit the one with larger Z,
+		// or the start/stop vertex if the track starts/stops in the MRD.
+		// error is true if >2 intercepts are found.
+		atrackentersmrd = mrdintercepts.hit.at(tracki);
+		MRDentrypoint = mrdintercepts.Entry(tracki);
+		MRDexitpoint = mrdintercepts.Exit(tracki);
+		checkboxlinerror = mrdintercepts.flag.at(tracki);
 		// sanity check: DISABLE TO ALLOW TRACKS STARTING IN THE MRD
 		//assert(MRDentrypoint!=startvertex&&"track starts in MRD!?");
 		// check if MRD stops in the MRD
@@ -286,32 +288,14 @@ bool MCParticleProperties::Execute(){
 		Log("MCParticleProperties Tool: Estimating track length in tank",v_debug,verbosity);
 		double atracklengthintank=0;
 		bool interceptstank=true;
-		bool hastrueexitvtx=false;
 		Position tankentryvtx, tankexitvtx, truetankexitvtx;
 		
-		bool trackstartsintank = ( sqrt(pow(startvertex.X(),2.) +
-										pow(startvertex.Z()-tank_start-tank_radius,2.))
-										 < tank_radius ) &&
-								 ( abs(startvertex.Y()-tank_yoffset)
-										 < tank_halfheight );
-		bool trackstopsintank = ( sqrt(pow(stopvertex.X(),2.) +
-										pow(stopvertex.Z()-tank_start-tank_radius,2.))
-										 < tank_radius ) &&
-								 ( abs(stopvertex.Y()-tank_yoffset)
-										 < tank_halfheight );
-		
-//		// if TankExitPoint is not close to either the tank caps or tank walls,
-//		// we probably don't have one. So project it instead.
-//		double tankexitradius = sqrt(pow(nextparticle->GetTankExitPoint().X(),2.) +
-//		                             pow(nextparticle->GetTankExitPoint().Z(),2.));
-//		double tankexitheight = abs(nextparticle->GetTankExitPoint().Y());
-//		if((tankexitradius<(tank_radius*0.8))&&(tankexitheight<(tank_height*0.8))){
-//			
-		if(nextparticle->GetTankExitPoint().Mag()>0.2){ // cover rounding errors
+		bool trackstartsintank = startsintank.at(tracki);
+		bool trackstopsintank = stopsintank.at(tracki);
+		bool hastrueexitvtx = hastrueexit.at(tracki);
+		if(hastrueexitvtx){
 			// Later versions of WCSim record the tank exit point explicitly
-			truetankexitvtx = nextparticle->GetTankExitPoint();
-			truetankexitvtx.UnitToCentimeter();
-			hastrueexitvtx=true;
+			truetankexitvtx = Position(tanktracks.stop_x[tracki],tanktracks.stop_y[tracki],tanktracks.stop_z[tracki]);
 		}
 		
 		if(trackstartsintank&&(trackstopsintank||hastrueexitvtx)){
@@ -334,8 +318,15 @@ bool MCParticleProperties::Execute(){
 			// If we have a recorded truth exit point we can use it as the endpoint for CheckTankIntercepts
 			// to get a more accurate estimate
 			
-			Position theendvertex = (hastrueexitvtx) ? truetankexitvtx : stopvertex;
-			interceptstank = CheckTankIntercepts(startvertex, theendvertex, trackstartsintank, trackstopsintank, tankexitvtx, tankentryvtx);
+			if(tankintercepts.flag.at(tracki)){
+				// the batch only handles tracks that are not in the z plane
+				Position theendvertex = (hastrueexitvtx) ? truetankexitvtx : stopvertex;
+				interceptstank = CheckTankIntercepts(startvertex, theendvertex, trackstartsintank, trackstopsintank, tankexitvtx, tankentryvtx);
+			} else {
+				interceptstank = tankintercepts.hit.at(tracki);
+				tankexitvtx = tankintercepts.Exit(tracki);
+				tankentryvtx = tankintercepts.Entry(tracki);
+			}
 			if(verbosity>3){
 				cout<<"checktankintercepts returned "<<interceptstank<<endl;
 				cout<<"and set tankexitvtx to: ("<<tankexitvtx.X()
@@ -396,7 +387,10 @@ bool MCParticleProperties::Execute(){
 		} else {
 			// exit projection only makes sense for tracks starting in tank
 			if(trackstartsintank && trackstopsintank){
-			bool projectok = ProjectTankIntercepts(startvertex, stopvertex, projectedexitvertex);
+			bool projectok = projectedexits.hit.at(tracki);
+			projectedexitvertex = projectedexits.Exit(tracki);
+			// tracks in the z plane are not handled by the batch
+			if(projectedexits.flag.at(tracki)) projectok = ProjectTankIntercepts(startvertex, stopvertex, projectedexitvertex);
 				if(not projectok){
 					cerr<<"MCParticleProperties Tool: ProjectTankIntercepts returned false?!"<<std::endl;
 				} else {
@@ -445,6 +439,46 @@ bool MCParticleProperties::Finalise(){
 	return true;
 }
 
+void MCParticleProperties::CalculateIntercepts(){
+	
+	tracks.clear();
+	tanktracks.clear();
+	hastrueexit.clear();
+	tracks.reserve(MCParticles->size());
+	tanktracks.reserve(MCParticles->size());
+	for(MCParticle& aparticle : *MCParticles){
+		Position startvertex = aparticle.GetStartVertex();
+		startvertex.UnitToCentimeter();
+		Position stopvertex = aparticle.GetStopVertex();
+		stopvertex.UnitToCentimeter();
+		tracks.push_back(startvertex, stopvertex);
+		
+		// if WCSim recorded the tank exit point, use it as the end of the track for the tank intercepts
+		bool hastrueexitvtx = (aparticle.GetTankExitPoint().Mag()>0.2); // cover rounding errors
+		Position theendvertex = stopvertex;
+		if(hastrueexitvtx){
+			theendvertex = aparticle.GetTankExitPoint();
+			theendvertex.UnitToCentimeter();
+		}
+		tanktracks.push_back(startvertex, theendvertex);
+		hastrueexit.push_back(hastrueexitvtx);
+	}
+	
+	// MRD: projected hit on the first layer, and the intercepts with the MRD box
+	trackgeometry::ProjectedPlaneHits(tracks, MRDSpecs::MRD_width, MRDSpecs::MRD_height,
+									  MRDSpecs::MRD_start, projectedhitsmrd);
+	trackgeometry::BoxGeometry mrdbox{-MRDSpecs::MRD_width, -MRDSpecs::MRD_height, MRDSpecs::MRD_start,
+									   MRDSpecs::MRD_width, MRDSpecs::MRD_height, MRDSpecs::MRD_end};
+	trackgeometry::BoxIntercepts(tracks, mrdbox, mrdintercepts);
+	
+	// tank: containment of the start and stop vertices, entry/exit points, and projected exits
+	trackgeometry::TankGeometry tank{tank_radius, tank_start, tank_yoffset, tank_halfheight};
+	trackgeometry::InTank(tracks.start_x, tracks.start_y, tracks.start_z, tank, startsintank);
+	trackgeometry::InTank(tracks.stop_x, tracks.stop_y, tracks.stop_z, tank, stopsintank);
+	trackgeometry::TankIntercepts(tanktracks, startsintank, stopsintank, tank, tankintercepts);
+	trackgeometry::ProjectTankExits(tracks, tank, projectedexits);
+}
+
 
 //============================================================================
 
@@ -1143,9 +1177,9 @@ bool MCParticleProperties::ProjectTankIntercepts(Position startvertex, Position
 
 
 std::string MCParticleProperties::PdgToString(int code){
-	if(pdgcodetoname.size()==0) GeneratePdgMap();
-	if(pdgcodetoname.count(code)!=0){
-		return pdgcodetoname.at(code);
+	const pdgtable::PdgEntry* entry = pdgtable::Find(code);
+	if(entry!=nullptr){
+		return entry->name;
 	} else {
 		cerr<<"unknown pdg code "<<code<<endl;
 		return std::to_string(code);
@@ -1153,81 +1187,14 @@ std::string MCParticleProperties::PdgToString(int code){
 }
 
 std::map<int,std::string>* MCParticleProperties::GeneratePdgMap(){
-	if(pdgcodetoname.size()!=0) return &pdgcodetoname;
-	pdgcodetoname.emplace(2212,"Proton");
-	pdgcodetoname.emplace(-2212,"Anti Proton");
-	pdgcodetoname.emplace(11,"Electron");
-	pdgcodetoname.emplace(-11,"Positron");
-	pdgcodetoname.emplace(12,"Electron Neutrino");
-	pdgcodetoname.emplace(-12,"Anti Electron Neutrino");
-	pdgcodetoname.emplace(22,"Gamma");
-	pdgcodetoname.emplace(2112,"Neutron");
-	pdgcodetoname.emplace(-2112,"Anti Neutron");
-	pdgcodetoname.emplace(-13,"Muon+");
-	pdgcodetoname.emplace(13,"Muon-");
-	pdgcodetoname.emplace(130,"Kaonlong");
-	pdgcodetoname.emplace(211,"Pion+");
-	pdgcodetoname.emplace(-211,"Pion-");
-	pdgcodetoname.emplace(321,"Kaon+");
-	pdgcodetoname.emplace(-321,"Kaon-");
-	pdgcodetoname.emplace(3122,"Lambda");
-	pdgcodetoname.emplace(-3122,"Antilambda");
-	pdgcodetoname.emplace(310,"Kaonshort");
-	pdgcodetoname.emplace(3112,"Sigma-");
-	pdgcodetoname.emplace(3222,"Sigma+");
-	pdgcodetoname.emplace(3212,"Sigma0");
-	pdgcodetoname.emplace(111,"Pion0");
-	pdgcodetoname.emplace(311,"Kaon0");
-	pdgcodetoname.emplace(-311,"Antikaon0");
-	pdgcodetoname.emplace(14,"Muon Neutrino");
-	pdgcodetoname.emplace(-14,"Anti Muon Neutrino");
-	pdgcodetoname.emplace(-3222,"Anti Sigma-");
-	pdgcodetoname.emplace(-3212,"Anti Sigma0");
-	pdgcodetoname.emplace(-3112,"Anti Sigma+");
-	pdgcodetoname.emplace(3322,"Xsi0");
-	pdgcodetoname.emplace(-3322,"Anti Xsi0");
-	pdgcodetoname.emplace(3312,"Xsi-");
-	pdgcodetoname.emplace(-3312,"Xsi+");
-	pdgcodetoname.emplace(3334,"Omega-");
-	pdgcodetoname.emplace(-3334,"Omega+");
-	pdgcodetoname.emplace(-15,"Tau+");
-	pdgcodetoname.emplace(15,"Tau-");
-	pdgcodetoname.emplace(100,"OpticalPhoton");
-	pdgcodetoname.emplace(3328,"Alpha");
-	pdgcodetoname.emplace(3329,"Deuteron");
-	pdgcodetoname.emplace(3330,"Triton");
-	pdgcodetoname.emplace(3351,"Li7");
-	pdgcodetoname.emplace(3331,"C10");
-	pdgcodetoname.emplace(3345,"B11");
-	pdgcodetoname.emplace(3332,"C12");
-	pdgcodetoname.emplace(3350,"C13");
-	pdgcodetoname.emplace(3349,"N13");
-	pdgcodetoname.emplace(3340,"N14");
-	pdgcodetoname.emplace(3333,"N15");
-	pdgcodetoname.emplace(3334,"N16");
-	pdgcodetoname.emplace(3335,"O16");
-	pdgcodetoname.emplace(3346,"Al27");
-	pdgcodetoname.emplace(3341,"Fe54");
-	pdgcodetoname.emplace(3348,"Mn54");
-	pdgcodetoname.emplace(3342,"Mn55");
-	pdgcodetoname.emplace(3352,"Mn56");
-	pdgcodetoname.emplace(3343,"Fe56");
-	pdgcodetoname.emplace(3344,"Fe57");
-	pdgcodetoname.emplace(3347,"Fe58");
-	pdgcodetoname.emplace(3353,"Eu154");
-	pdgcodetoname.emplace(3336,"Gd158");
-	pdgcodetoname.emplace(3337,"Gd156");
-	pdgcodetoname.emplace(3338,"Gd157");
-	pdgcodetoname.emplace(3339,"Gd155");
+	if(pdgcodetoname.size()==0) pdgtable::FillNameMap(pdgcodetoname);
 	return &pdgcodetoname;
 }
 
-
-
 double MCParticleProperties::PdgToMass(int code){
-	if(pdgcodetomass.size()==0) GeneratePdgMassMap();
-	if(pdgcodetomass.count(code)!=0){
-		return pdgcodetomass.at(code);
+	const pdgtable::PdgEntry* entry = pdgtable::Find(code);
+	if(entry!=nullptr && entry->hasmass){
+		return entry->mass;
 	} else {
 		cerr<<"unknown pdg code "<<code<<endl;
 		return double(code);
@@ -1236,45 +1203,6 @@ double MCParticleProperties::PdgToMass(int code){
 
 std::map<int,double>* MCParticleProperties::GeneratePdgMassMap(){
 	//all masses in MeV
-	if(pdgcodetomass.size()!=0) return &pdgcodetomass;
-	pdgcodetomass.emplace(2212,938.272);
-	pdgcodetomass.emplace(-2212,938.272);
-	pdgcodetomass.emplace(11,0.511);
-	pdgcodetomass.emplace(-11,0.511);
-	pdgcodetomass.emplace(12,0.000);
-	pdgcodetomass.emplace(-12,0.000);
-	pdgcodetomass.emplace(22,0.000);
-	pdgcodetomass.emplace(2112,939.565);
-	pdgcodetomass.emplace(-2112,939.485);
-	pdgcodetomass.emplace(-13,105.658);
-	pdgcodetomass.emplace(13,105.658);
-	pdgcodetomass.emplace(211,139.571);
-	pdgcodetomass.emplace(-211,139.571);
-	pdgcodetomass.emplace(321,493.666);
-	pdgcodetomass.emplace(-321,493.666);
-	pdgcodetomass.emplace(3122,1115.683);
-	pdgcodetomass.emplace(-3122,1115.683);
-	pdgcodetomass.emplace(3112,1197.449);
-	pdgcodetomass.emplace(3222,1189.37);
-	pdgcodetomass.emplace(3212,1192.642);
-	pdgcodetomass.emplace(111,134.977);
-	pdgcodetomass.emplace(311,497.611);
-	pdgcodetomass.emplace(-311,497.611);
-	pdgcodetomass.emplace(14,0.000);
-	pdgcodetomass.emplace(-14,0.000);
-	pdgcodetomass.emplace(-3222,1189.37);
-	pdgcodetomass.emplace(-3212,1192.642);
-	pdgcodetomass.emplace(-3112,1197.449);
-	pdgcodetomass.emplace(3322,1314.86);
-	pdgcodetomass.emplace(-3322,1314.86);
-	pdgcodetomass.emplace(3312,1321.71);
-	pdgcodetomass.emplace(-3312,1321.71);
-	pdgcodetomass.emplace(3334,1672.45);
-	pdgcodetomass.emplace(-3334,1672.45);
-	pdgcodetomass.emplace(-15,1776.86);
-	pdgcodetomass.emplace(15,1776.86);
-	pdgcodetomass.emplace(100,0.000);
-	//masses of nuclei not specified since they won't be able to generate Cherenkov light
+	if(pdgcodetomass.size()==0) pdgtable::FillMassMap(pdgcodetomass);
 	return &pdgcodetomass;
 }
-
@@ -8,9 +8,13 @@
 #include "Tool.h"
 #include "MRDspecs.hh"
 #include "TMath.h"
+#include "TrackGeometryBatch.h"
 
 class MCParticleProperties: public Tool {
-	
+
+	// tests/MCParticleProperties: compares the batched geometry with the helper functions
+	friend class TrackGeometryValidation;
+
 	public:
 	
 	MCParticleProperties();
@@ -41,6 +45,18 @@ class MCParticleProperties: public Tool {
 	Geometry* anniegeom=nullptr;
 	std::vector<MCParticle>* MCParticles=nullptr;
 	
+	// tank and MRD intercepts of all particles in the event, calculated as a batch
+	trackgeometry::TrackBatch tracks;       // start -> stop vertex, cm
+	trackgeometry::TrackBatch tanktracks;   // start -> true tank exit if known, else stop vertex
+	std::vector<uint8_t> hastrueexit;
+	std::vector<uint8_t> startsintank;
+	std::vector<uint8_t> stopsintank;
+	std::vector<uint8_t> projectedhitsmrd;
+	trackgeometry::InterceptBatch mrdintercepts;
+	trackgeometry::InterceptBatch tankintercepts;
+	trackgeometry::InterceptBatch projectedexits;
+	void CalculateIntercepts();
+	
 	// helper functions to find the MRD intersection points
 	bool CheckProjectedMRDHit(Position startvertex, Position stopvertex, double mrdwidth, double mrdheight, double mrdstart);
 	bool CheckLineBox( Position L1, Position L2, Position B1, Position B2, Position &Hit, Position &Hit2, bool &error, int verbose=0);
@@ -0,0 +1,134 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#include "PdgTable.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace pdgtable {
+
+namespace {
+
+const PdgEntry pdg_entries[] = {
+	{2212, "Proton", 938.272, true},
+	{-2212, "Anti Proton", 938.272, true},
+	{11, "Electron", 0.511, true},
+	{-11, "Positron", 0.511, true},
+	{12, "Electron Neutrino", 0.000, true},
+	{-12, "Anti Electron Neutrino", 0.000, true},
+	{22, "Gamma", 0.000, true},
+	{2112, "Neutron", 939.565, true},
+	{-2112, "Anti Neutron", 939.485, true},
+	{-13, "Muon+", 105.658, true},
+	{13, "Muon-", 105.658, true},
+	{130, "Kaonlong", 0., false},
+	{211, "Pion+", 139.571, true},
+	{-211, "Pion-", 139.571, true},
+	{321, "Kaon+", 493.666, true},
+	{-321, "Kaon-", 493.666, true},
+	{3122, "Lambda", 1115.683, true},
+	{-3122, "Antilambda", 1115.683, true},
+	{310, "Kaonshort", 0., false},
+	{3112, "Sigma-", 1197.449, true},
+	{3222, "Sigma+", 1189.37, true},
+	{3212, "Sigma0", 1192.642, true},
+	{111, "Pion0", 134.977, true},
+	{311, "Kaon0", 497.611, true},
+	{-311, "Antikaon0", 497.611, true},
+	{14, "Muon Neutrino", 0.000, true},
+	{-14, "Anti Muon Neutrino", 0.000, true},
+	{-3222, "Anti Sigma-", 1189.37, true},
+	{-3212, "Anti Sigma0", 1192.642, true},
+	{-3112, "Anti Sigma+", 1197.449, true},
+	{3322, "Xsi0", 1314.86, true},
+	{-3322, "Anti Xsi0", 1314.86, true},
+	{3312, "Xsi-", 1321.71, true},
+	{-3312, "Xsi+", 1321.71, true},
+	{3334, "Omega-", 1672.45, true},
+	{-3334, "Omega+", 1672.45, true},
+	{-15, "Tau+", 1776.86, true},
+	{15, "Tau-", 1776.86, true},
+	{100, "OpticalPhoton", 0.000, true},
+	{3328, "Alpha", 0., false},
+	{3329, "Deuteron", 0., false},
+	{3330, "Triton", 0., false},
+	{3351, "Li7", 0., false},
+	{3331, "C10", 0., false},
+	{3345, "B11", 0., false},
+	{3332, "C12", 0., false},
+	{3350, "C13", 0., false},
+	{3349, "N13", 0., false},
+	{3340, "N14", 0., false},
+	{3333, "N15", 0., false},
+	// N16 shares code 3334 with Omega-, which takes precedence
+	{3335, "O16", 0., false},
+	{3346, "Al27", 0., false},
+	{3341, "Fe54", 0., false},
+	{3348, "Mn54", 0., false},
+	{3342, "Mn55", 0., false},
+	{3352, "Mn56", 0., false},
+	{3343, "Fe56", 0., false},
+	{3344, "Fe57", 0., false},
+	{3347, "Fe58", 0., false},
+	{3353, "Eu154", 0., false},
+	{3336, "Gd158", 0., false},
+	{3337, "Gd156", 0., false},
+	{3338, "Gd157", 0., false},
+	{3339, "Gd155", 0., false},
+};
+const int num_entries = sizeof(pdg_entries)/sizeof(PdgEntry);
+
+// Multiplicative hash into a table of 2^table_bits slots. The multiplier is
+// searched for when the table is first used, so entries can be added freely.
+const int table_bits = 8;
+
+class PdgHashTable {
+	public:
+	PdgHashTable(){
+		for(multiplier=2654435769u; ; multiplier+=2){
+			slots.assign(1<<table_bits,0);
+			bool collision=false;
+			for(int i=0; i<num_entries && !collision; ++i){
+				uint8_t& slot = slots[Slot(pdg_entries[i].code)];
+				collision = (slot!=0);
+				slot = i+1;
+			}
+			if(!collision) break;
+		}
+	}
+	
+	inline const PdgEntry* Find(int code) const {
+		int entry = slots[Slot(code)];
+		if(entry==0 || pdg_entries[entry-1].code!=code) return nullptr;
+		return &pdg_entries[entry-1];
+	}
+	
+	private:
+	inline uint32_t Slot(int code) const {
+		return (static_cast<uint32_t>(code)*multiplier) >> (32-table_bits);
+	}
+	uint32_t multiplier;
+	std::vector<uint8_t> slots;   // index+1 into pdg_entries, 0 if empty
+};
+
+const PdgHashTable& HashTable(){
+	static const PdgHashTable table;
+	return table;
+}
+
+} // namespace
+
+const PdgEntry* Find(int code){
+	return HashTable().Find(code);
+}
+
+void FillNameMap(std::map<int,std::string>& names){
+	for(int i=0; i<num_entries; ++i) names.emplace(pdg_entries[i].code,pdg_entries[i].name);
+}
+
+void FillMassMap(std::map<int,double>& masses){
+	for(int i=0; i<num_entries; ++i){
+		if(pdg_entries[i].hasmass) masses.emplace(pdg_entries[i].code,pdg_entries[i].mass);
+	}
+}
+
+} // namespace pdgtable
@@ -0,0 +1,28 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#ifndef PdgTable_H
+#define PdgTable_H
+// Static table of particle names and masses, looked up by pdg code
+// through a collision-free (perfect) hash built once on first use.
+
+#include <map>
+#include <string>
+
+namespace pdgtable {
+
+struct PdgEntry {
+	int code;
+	const char* name;
+	double mass;      // MeV
+	bool hasmass;     // masses of nuclei are not specified, since they won't generate Cherenkov light
+};
+
+// the entry for a pdg code, or nullptr if the code is unknown
+const PdgEntry* Find(int code);
+
+// fill code -> name and code -> mass maps, as stored in the CStore for downstream tools
+void FillNameMap(std::map<int,std::string>& names);
+void FillMassMap(std::map<int,double>& masses);
+
+} // namespace pdgtable
+
+#endif
@@ -0,0 +1,262 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#include "TrackGeometryBatch.h"
+#include "Position.h"
+
+#include <cmath>
+
+namespace trackgeometry {
+
+void TrackBatch::clear(){
+	start_x.clear(); start_y.clear(); start_z.clear();
+	stop_x.clear(); stop_y.clear(); stop_z.clear();
+}
+
+void TrackBatch::reserve(size_t n){
+	start_x.reserve(n); start_y.reserve(n); start_z.reserve(n);
+	stop_x.reserve(n); stop_y.reserve(n); stop_z.reserve(n);
+}
+
+void TrackBatch::push_back(const Position& start, const Position& stop){
+	start_x.push_back(start.X()); start_y.push_back(start.Y()); start_z.push_back(start.Z());
+	stop_x.push_back(stop.X()); stop_y.push_back(stop.Y()); stop_z.push_back(stop.Z());
+}
+
+void InterceptBatch::resize(size_t n){
+	// every element is reset, as the functions only write the points they find
+	entry_x.assign(n,0.); entry_y.assign(n,0.); entry_z.assign(n,0.);
+	exit_x.assign(n,0.); exit_y.assign(n,0.); exit_z.assign(n,0.);
+	hit.assign(n,0);
+	flag.assign(n,0);
+}
+
+Position InterceptBatch::Entry(size_t i) const {
+	return Position(entry_x[i],entry_y[i],entry_z[i]);
+}
+
+Position InterceptBatch::Exit(size_t i) const {
+	return Position(exit_x[i],exit_y[i],exit_z[i]);
+}
+
+//============================================================================
+
+void BoxIntercepts(const TrackBatch& tracks, const BoxGeometry& box, InterceptBatch& out){
+	const size_t n = tracks.size();
+	out.resize(n);
+	const double b1[3] = {box.min_x, box.min_y, box.min_z};
+	const double b2[3] = {box.max_x, box.max_y, box.max_z};
+
+	for(size_t i=0; i<n; ++i){
+		const double l1[3] = {tracks.start_x[i], tracks.start_y[i], tracks.start_z[i]};
+		const double l2[3] = {tracks.stop_x[i], tracks.stop_y[i], tracks.stop_z[i]};
+
+		// misses the box entirely by being on one side of a plane over the entire track
+		bool misses = false;
+		bool startsin = true, stopsin = true;
+		for(int axis=0; axis<3; ++axis){
+			misses |= (l2[axis]<=b1[axis] && l1[axis]<=b1[axis]) || (l2[axis]>=b2[axis] && l1[axis]>=b2[axis]);
+			startsin &= (l1[axis]>b1[axis] && l1[axis]<b2[axis]);
+			stopsin &= (l2[axis]>b1[axis] && l2[axis]<b2[axis]);
+		}
+		// points inside the box count as an interception. CheckLineBox compares
+		// its outputs against L1 and L2, which also matches a start (or stop)
+		// point that happens to sit at the origin.
+		const bool hitisstart = startsin || (l1[0]==0. && l1[1]==0. && l1[2]==0.);
+		const bool hit2isstop = stopsin || (l2[0]==0. && l2[1]==0. && l2[2]==0.);
+
+		// interceptions with the six faces, in the order CheckLineBox tests them
+		int ninterceptions = 0;
+		double first[3] = {0.,0.,0.}, second[3] = {0.,0.,0.};
+		for(int face=0; face<6; ++face){
+			const int axis = face%3;
+			const double plane = (face<3) ? b1[axis] : b2[axis];
+			// distances are truncated to float as in GetIntersection
+			const float d1 = l1[axis]-plane;
+			const float d2 = l2[axis]-plane;
+			const bool crosses = !((d1*d2)>=0.0f) && !(d1==d2);
+			const double frac = -d1/(d2-d1);
+			double point[3];
+			for(int j=0; j<3; ++j) point[j] = l1[j] + (frac*(l2[j]-l1[j]));
+			// the two coordinates other than the face normal must be within the box
+			const int a = (axis==2) ? 0 : 2;
+			const int b = (axis==1) ? 0 : 1;
+			const bool inbox = point[a]>b1[a] && point[a]<b2[a] && point[b]>b1[b] && point[b]<b2[b];
+			if(crosses && inbox){
+				double* dest = (ninterceptions==0) ? first : second;
+				if(ninterceptions<2){ dest[0]=point[0]; dest[1]=point[1]; dest[2]=point[2]; }
+				++ninterceptions;
+			}
+		}
+
+		double entry[3] = {0.,0.,0.}, exit[3] = {0.,0.,0.};
+		if(startsin){ entry[0]=l1[0]; entry[1]=l1[1]; entry[2]=l1[2]; }
+		if(stopsin){ exit[0]=l2[0]; exit[1]=l2[1]; exit[2]=l2[2]; }
+		bool hit = false, error = false;
+		if(misses){
+			entry[0]=entry[1]=entry[2]=0.;
+			exit[0]=exit[1]=exit[2]=0.;
+		} else if(hitisstart && hit2isstop){
+			hit = true;
+		} else if(ninterceptions>2){
+			error = true;
+		} else if(ninterceptions==2){
+			const bool inorder = first[2]<second[2];
+			for(int j=0; j<3; ++j){
+				entry[j] = inorder ? first[j] : second[j];
+				exit[j] = inorder ? second[j] : first[j];
+			}
+			hit = true;
+		} else if(ninterceptions==1){
+			double* dest = (hitisstart) ? exit : entry;
+			dest[0]=first[0]; dest[1]=first[1]; dest[2]=first[2];
+			hit = true;
+		}
+
+		out.entry_x[i]=entry[0]; out.entry_y[i]=entry[1]; out.entry_z[i]=entry[2];
+		out.exit_x[i]=exit[0]; out.exit_y[i]=exit[1]; out.exit_z[i]=exit[2];
+		out.hit[i]=hit;
+		out.flag[i]=error;
+	}
+}
+
+void ProjectedPlaneHits(const TrackBatch& tracks, double width, double height, double zplane,
+	std::vector<uint8_t>& out){
+	const size_t n = tracks.size();
+	out.resize(n);
+	const double* sx = tracks.start_x.data(); const double* sy = tracks.start_y.data();
+	const double* sz = tracks.start_z.data(); const double* ex = tracks.stop_x.data();
+	const double* ey = tracks.stop_y.data(); const double* ez = tracks.stop_z.data();
+	uint8_t* result = out.data();
+	for(size_t i=0; i<n; ++i){
+		const double projection = (zplane-sz[i])/(ez[i]-sz[i]);
+		const double xatplane = sx[i] + projection*(ex[i]-sx[i]);
+		const double yatplane = sy[i] + projection*(ey[i]-sy[i]);
+		result[i] = !(std::fabs(xatplane)>width) && !(std::fabs(yatplane)>height) && !(projection<0.);
+	}
+}
+
+void InTank(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+	const TankGeometry& tank, std::vector<uint8_t>& out){
+	const size_t n = x.size();
+	out.resize(n);
+	for(size_t i=0; i<n; ++i){
+		out[i] = (std::sqrt(std::pow(x[i],2.) + std::pow(z[i]-tank.start-tank.radius,2.)) < tank.radius) &&
+				 (std::abs(y[i]-tank.yoffset) < tank.halfheight);
+	}
+}
+
+//============================================================================
+
+namespace {
+
+// the cylinder intercepts shared by CheckTankIntercepts and ProjectTankIntercepts.
+// Returns false if the track misses the tank radius.
+inline bool CylinderIntercepts(double sx, double sy, double sz, double ex, double ey, double ez,
+	const TankGeometry& tank, double& startx, double& starty, double& startz,
+	double& endx, double& endy, double& endz){
+
+	const double oppx = ex - sx;
+	const double adj = ez - sz;
+	const double avgtrackgradx = (adj!=0) ? (oppx/adj) : 1000000;
+	const double oppy = ey - sy;
+	const double avgtrackgrady = (adj!=0) ? (oppy/adj) : 1000000;
+
+	// parameterize the track by its z position, and find the
+	// z values where the track crosses the radius of the tank
+	const double xattankcentre = sx - (sz-tank.start-tank.radius)*avgtrackgradx;
+	const double firstterm = -avgtrackgradx*xattankcentre;
+	const double thirdterm = 1+std::pow(avgtrackgradx,2.);
+	const double secondterm = (std::pow(tank.radius,2.)*thirdterm) - std::pow(xattankcentre,2.);
+	const bool hits = !(secondterm<=0);
+	const double root = std::sqrt(hits ? secondterm : 0.);
+	const double solution1 = (firstterm + root)/thirdterm;
+	const double solution2 = (firstterm - root)/thirdterm;
+	const bool forward = (ez > sz);
+	endz = (forward ? solution1 : solution2) + (tank.start+tank.radius);
+	startz = (forward ? solution2 : solution1) + (tank.start+tank.radius);
+	endx = sx + (endz-sz)*avgtrackgradx;
+	startx = sx + (startz-sz)*avgtrackgradx;
+	endy = sy + (endz-sz)*avgtrackgrady;
+	starty = sy + (startz-sz)*avgtrackgrady;
+
+	// if the track started within the caps but crosses the radius outside them,
+	// it left (or entered) through a cap instead
+	const bool startwithincaps = std::abs(sy-tank.yoffset)<(tank.halfheight);
+	const double capy = (ey>sy) ? (tank.halfheight+tank.yoffset) : (-tank.halfheight+tank.yoffset);
+	if(std::abs(endy-tank.yoffset)>(tank.halfheight) && startwithincaps){
+		endy = capy;
+		endz = sz + (endy-sy)/avgtrackgrady;
+		endx = sx + (endz-sz)*avgtrackgradx;
+	}
+	if(std::abs(starty-tank.yoffset)>(tank.halfheight) && startwithincaps){
+		starty = capy;
+		startz = sz + (starty-sy)/avgtrackgrady;
+		startx = sx + (startz-sz)*avgtrackgradx;
+	}
+	return hits;
+}
+
+// the z component of the unit vector along the track
+inline double UnitDz(double sx, double sy, double sz, double ex, double ey, double ez){
+	const double dx = ex-sx, dy = ey-sy, dz = ez-sz;
+	return dz/std::sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+} // namespace
+
+void TankIntercepts(const TrackBatch& tracks, const std::vector<uint8_t>& startsintank,
+	const std::vector<uint8_t>& stopsintank, const TankGeometry& tank, InterceptBatch& out){
+	const size_t n = tracks.size();
+	out.resize(n);
+	const double tank_end = tank.start+2.*tank.radius;
+	for(size_t i=0; i<n; ++i){
+		const double sx = tracks.start_x[i], sy = tracks.start_y[i], sz = tracks.start_z[i];
+		const double ex = tracks.stop_x[i], ey = tracks.stop_y[i], ez = tracks.stop_z[i];
+
+		// start and endpoints are both on the same side outside of the tank bounds
+		const bool outside =
+			( (sx > tank.radius) && (ex > tank.radius) ) ||
+			( (sx < -tank.radius) && (ex < -tank.radius) ) ||
+			( ((sy-tank.yoffset) > tank.halfheight) && ((ey-tank.yoffset) > tank.halfheight) ) ||
+			( ((sy-tank.yoffset) < -tank.halfheight) && ((ey-tank.yoffset) < -tank.halfheight) ) ||
+			( (sz < tank.start) && (ez < tank.start) ) ||
+			( (sz > tank_end) && (ez > tank_end) );
+		const bool inzplane = std::abs(UnitDz(sx,sy,sz,ex,ey,ez))<0.001;
+
+		double startx, starty, startz, endx, endy, endz;
+		const bool hits = CylinderIntercepts(sx,sy,sz,ex,ey,ez,tank,startx,starty,startz,endx,endy,endz);
+		const bool found = !outside && !inzplane && hits;
+		const bool setexit = found && !stopsintank[i];
+		const bool setentry = found && !startsintank[i];
+
+		out.exit_x[i] = setexit ? endx : 0.;
+		out.exit_y[i] = setexit ? endy : 0.;
+		out.exit_z[i] = setexit ? endz : 0.;
+		out.entry_x[i] = setentry ? startx : 0.;
+		out.entry_y[i] = setentry ? starty : 0.;
+		out.entry_z[i] = setentry ? startz : 0.;
+		out.hit[i] = found;
+		out.flag[i] = !outside && inzplane;
+	}
+}
+
+void ProjectTankExits(const TrackBatch& tracks, const TankGeometry& tank, InterceptBatch& out){
+	const size_t n = tracks.size();
+	out.resize(n);
+	for(size_t i=0; i<n; ++i){
+		const double sx = tracks.start_x[i], sy = tracks.start_y[i], sz = tracks.start_z[i];
+		const double ex = tracks.stop_x[i], ey = tracks.stop_y[i], ez = tracks.stop_z[i];
+
+		const bool inzplane = std::abs(UnitDz(sx,sy,sz,ex,ey,ez))<0.1;
+		double startx, starty, startz, endx, endy, endz;
+		const bool hits = CylinderIntercepts(sx,sy,sz,ex,ey,ez,tank,startx,starty,startz,endx,endy,endz);
+		const bool found = !inzplane && hits;
+
+		out.exit_x[i] = found ? endx : 0.;
+		out.exit_y[i] = found ? endy : 0.;
+		out.exit_z[i] = found ? endz : 0.;
+		out.hit[i] = found;
+		out.flag[i] = inzplane;
+	}
+}
+
+} // namespace trackgeometry
@@ -0,0 +1,77 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#ifndef TrackGeometryBatch_H
+#define TrackGeometryBatch_H
+// Batched versions of the MCParticleProperties tank and MRD intercept functions.
+// Tracks are held as one array per coordinate, and every function loops over the
+// whole batch with the same arithmetic (same operations, same order, same float
+// truncations) as the per-particle functions, so the results agree bit for bit.
+// The loops are branch-free where possible so the compiler can vectorise them.
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class Position;
+
+namespace trackgeometry {
+
+// start and stop points of a batch of tracks, in cm
+struct TrackBatch {
+	std::vector<double> start_x, start_y, start_z;
+	std::vector<double> stop_x, stop_y, stop_z;
+
+	void clear();
+	void reserve(size_t n);
+	void push_back(const Position& start, const Position& stop);
+	size_t size() const { return start_x.size(); }
+};
+
+// a pair of points per track, plus flags
+struct InterceptBatch {
+	std::vector<double> entry_x, entry_y, entry_z;
+	std::vector<double> exit_x, exit_y, exit_z;
+	std::vector<uint8_t> hit;       // return value of the per-particle function
+	std::vector<uint8_t> flag;      // box: CheckLineBox error; tank: needs the scalar function
+
+	void resize(size_t n);
+	Position Entry(size_t i) const;
+	Position Exit(size_t i) const;
+};
+
+struct BoxGeometry {
+	double min_x, min_y, min_z;
+	double max_x, max_y, max_z;
+};
+
+struct TankGeometry {
+	double radius;
+	double start;
+	double yoffset;
+	double halfheight;
+};
+
+// MCParticleProperties::CheckLineBox: entry in entry_*, exit in exit_*,
+// error flag in flag. Points not found are left at (0,0,0).
+void BoxIntercepts(const TrackBatch& tracks, const BoxGeometry& box, InterceptBatch& out);
+
+// MCParticleProperties::CheckProjectedMRDHit
+void ProjectedPlaneHits(const TrackBatch& tracks, double width, double height, double zplane,
+	std::vector<uint8_t>& out);
+
+// whether each start (or stop) point is inside the tank cylinder
+void InTank(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+	const TankGeometry& tank, std::vector<uint8_t>& out);
+
+// MCParticleProperties::CheckTankIntercepts, for tracks that do not run in the z plane.
+// Tracks within the z plane are flagged, and must be passed to the scalar function.
+// Tank entry goes in entry_*, exit in exit_*; as with the scalar function, only the
+// points outside the tank (startsintank / stopsintank false) are set, others are (0,0,0).
+void TankIntercepts(const TrackBatch& tracks, const std::vector<uint8_t>& startsintank,
+	const std::vector<uint8_t>& stopsintank, const TankGeometry& tank, InterceptBatch& out);
+
+// MCParticleProperties::ProjectTankIntercepts; projected exit in exit_*, z plane tracks flagged
+void ProjectTankExits(const TrackBatch& tracks, const TankGeometry& tank, InterceptBatch& out);
+
+} // namespace trackgeometry
+
+#endif
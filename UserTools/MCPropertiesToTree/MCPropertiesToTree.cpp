@@ -1,4 +1,7 @@
 #include "MCPropertiesToTree.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MCPropertiesToTree);
 
 MCPropertiesToTree::MCPropertiesToTree():Tool(){}
 
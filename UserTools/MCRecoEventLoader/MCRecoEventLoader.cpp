@@ -1,4 +1,7 @@
 #include "MCRecoEventLoader.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MCRecoEventLoader);
 
 MCRecoEventLoader::MCRecoEventLoader():Tool(){}
 
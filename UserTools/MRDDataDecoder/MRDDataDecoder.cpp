@@ -1,4 +1,7 @@
 #include "MRDDataDecoder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MRDDataDecoder);
 
 MRDDataDecoder::MRDDataDecoder():Tool(){}
 
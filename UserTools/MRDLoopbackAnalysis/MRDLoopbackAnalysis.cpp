@@ -1,4 +1,7 @@
 #include "MRDLoopbackAnalysis.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MRDLoopbackAnalysis);
 
 MRDLoopbackAnalysis::MRDLoopbackAnalysis():Tool(){}
 
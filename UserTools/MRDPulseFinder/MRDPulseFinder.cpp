@@ -1,4 +1,7 @@
 #include "MRDPulseFinder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MRDPulseFinder);
 
 MRDPulseFinder::MRDPulseFinder():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "MaxPEPlots.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MaxPEPlots);
 
 MaxPEPlots::MaxPEPlots():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "MeanTimeCheck.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MeanTimeCheck);
 
 MeanTimeCheck::MeanTimeCheck():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "MonitorDAQ.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorDAQ);
 
 MonitorDAQ::MonitorDAQ():Tool(){}
 
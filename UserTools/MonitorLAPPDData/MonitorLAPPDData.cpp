@@ -1,4 +1,7 @@
 #include "MonitorLAPPDData.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorLAPPDData);
 
 MonitorLAPPDData::MonitorLAPPDData() :
 		Tool() {
@@ -1,4 +1,7 @@
 #include "MonitorLAPPDSC.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorLAPPDSC);
 
 MonitorLAPPDSC::MonitorLAPPDSC() :
 		Tool() {
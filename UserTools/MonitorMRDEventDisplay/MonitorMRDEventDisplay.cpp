@@ -1,4 +1,7 @@
 #include "MonitorMRDEventDisplay.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorMRDEventDisplay);
 
 MonitorMRDEventDisplay::MonitorMRDEventDisplay():Tool(){}
 
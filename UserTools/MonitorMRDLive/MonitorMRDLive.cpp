@@ -1,4 +1,7 @@
 #include "MonitorMRDLive.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorMRDLive);
 
 MonitorMRDLive::MonitorMRDLive():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "MonitorMRDTime.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorMRDTime);
 
 MonitorMRDTime::MonitorMRDTime():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "MonitorReceive.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorReceive);
 
 MonitorReceive::MonitorReceive():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "MonitorSimReceive.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorSimReceive);
 
 MonitorSimReceive::MonitorSimReceive():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "MonitorSimReceiveLAPPD.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorSimReceiveLAPPD);
 
 MonitorSimReceiveLAPPD::MonitorSimReceiveLAPPD():Tool(){}
 
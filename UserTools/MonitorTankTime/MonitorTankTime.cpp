@@ -1,4 +1,7 @@
 #include "MonitorTankTime.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorTankTime);
 
 MonitorTankTime::MonitorTankTime():Tool(){}
 
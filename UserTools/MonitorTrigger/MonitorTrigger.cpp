@@ -1,4 +1,7 @@
 #include "MonitorTrigger.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MonitorTrigger);
 
 MonitorTrigger::MonitorTrigger():Tool(){}
 
@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "MrdDiscriminatorScan.h"
+#include "ToolRegistry.h"
 
 #include <boost/algorithm/string.hpp>   // for trim
 #include <sys/types.h>     // for stat() test to see if file or folder
@@ -19,6 +20,8 @@
 #include "TApplication.h"
 
 
+REGISTER_TOOL(MrdDiscriminatorScan);
+
 MrdDiscriminatorScan::MrdDiscriminatorScan():Tool(){}
 
 bool MrdDiscriminatorScan::Initialise(std::string configfile, DataModel &data){
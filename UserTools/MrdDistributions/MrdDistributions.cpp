@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "MrdDistributions.h"
+#include "ToolRegistry.h"
 
 #include "TFile.h"
 #include "TTree.h"
@@ -16,6 +17,8 @@
 #include <sys/stat.h>
 //#include <unistd.h>
 
+REGISTER_TOOL(MrdDistributions);
+
 MrdDistributions::MrdDistributions():Tool(){}
 
 // TODO combine the trees, record all info; muon energy. For all muons - were they primary/secondary,
@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "MrdEfficiency.h"
+#include "ToolRegistry.h"
 #include "TH1.h"
 #include "TH3.h"
 #include "TGraphErrors.h"
@@ -12,6 +13,8 @@
 #include <sys/stat.h>
 //#include <unistd.h>
 
+REGISTER_TOOL(MrdEfficiency);
+
 MrdEfficiency::MrdEfficiency():Tool(){}
 
 bool MrdEfficiency::Initialise(std::string configfile, DataModel &data){
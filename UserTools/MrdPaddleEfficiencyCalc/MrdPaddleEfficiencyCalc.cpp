@@ -1,4 +1,7 @@
 #include "MrdPaddleEfficiencyCalc.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MrdPaddleEfficiencyCalc);
 
 MrdPaddleEfficiencyCalc::MrdPaddleEfficiencyCalc():Tool(){}
 
@@ -1,6 +1,9 @@
 #include "MrdPaddleEfficiencyPreparer.h"
+#include "ToolRegistry.h"
 
 
+REGISTER_TOOL(MrdPaddleEfficiencyPreparer);
+
 MrdPaddleEfficiencyPreparer::MrdPaddleEfficiencyPreparer():Tool(){}
 
 
@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "MrdPaddlePlot.h"
+#include "ToolRegistry.h"
 #include "MCParticleProperties.h" // to steal tank projection function
 #include "TCanvas.h"
 #define GOT_EVE 1
@@ -14,6 +15,8 @@
 #include <time.h>         // clock_t, clock, CLOCKS_PER_SEC
 #include <algorithm>      // for std::replace
 
+REGISTER_TOOL(MrdPaddlePlot);
+
 MrdPaddlePlot::MrdPaddlePlot():Tool(){}
 
 bool MrdPaddlePlot::Initialise(std::string configfile, DataModel &data){
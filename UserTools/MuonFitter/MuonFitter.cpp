@@ -1,4 +1,5 @@
 #include "MuonFitter.h"
+#include "ToolRegistry.h"
 
 /* *****************************************************************
  * tool name: MuonFitter
@@ -29,6 +30,8 @@
  * *****************************************************************
  */
 
+REGISTER_TOOL(MuonFitter);
+
 MuonFitter::MuonFitter():Tool(){}
 
 
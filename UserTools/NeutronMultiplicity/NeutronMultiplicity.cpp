@@ -1,4 +1,7 @@
 #include "NeutronMultiplicity.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(NeutronMultiplicity);
 
 NeutronMultiplicity::NeutronMultiplicity():Tool(){}
 
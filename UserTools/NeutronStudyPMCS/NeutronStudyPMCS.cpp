@@ -1,4 +1,7 @@
 #include "NeutronStudyPMCS.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(NeutronStudyPMCS);
 
 NeutronStudyPMCS::NeutronStudyPMCS():Tool(){}
 
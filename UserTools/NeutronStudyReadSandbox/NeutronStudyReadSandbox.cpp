@@ -1,4 +1,7 @@
 #include "NeutronStudyReadSandbox.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(NeutronStudyReadSandbox);
 
 NeutronStudyReadSandbox::NeutronStudyReadSandbox():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "NeutronStudyWriteTree.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(NeutronStudyWriteTree);
 
 NeutronStudyWriteTree::NeutronStudyWriteTree():Tool(){}
 
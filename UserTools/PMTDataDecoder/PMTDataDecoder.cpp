@@ -1,4 +1,7 @@
 #include "PMTDataDecoder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PMTDataDecoder);
 
 PMTDataDecoder::PMTDataDecoder():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "ParseDataMonitoring.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ParseDataMonitoring);
 
 ParseDataMonitoring::ParseDataMonitoring():Tool(){}
 
@@ -17,6 +17,9 @@
 
 // ToolAnalysis includes
 #include "PhaseIIADCCalibrator.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PhaseIIADCCalibrator);
 
 PhaseIIADCCalibrator::PhaseIIADCCalibrator() : Tool() {}
 
@@ -1,5 +1,8 @@
 // ToolAnalysis includes
 #include "PhaseIIADCHitFinder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PhaseIIADCHitFinder);
 
 PhaseIIADCHitFinder::PhaseIIADCHitFinder() : Tool() {}
 
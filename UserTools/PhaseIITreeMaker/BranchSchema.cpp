@@ -0,0 +1,62 @@
+#include "BranchSchema.h"
+
+#include "TObjArray.h"
+
+namespace {
+
+  // split object branches (vectors of classes, maps) have sub-branches of their own
+  void SetCompression(TBranch* branch, int settings){
+    branch->SetCompressionSettings(settings);
+    TObjArray* subbranches = branch->GetListOfBranches();
+    for(int i=0; i<subbranches->GetEntriesFast(); ++i){
+      SetCompression(static_cast<TBranch*>(subbranches->At(i)),settings);
+    }
+  }
+
+}
+
+void phaseiitree::Schema::Add(const std::string& group, unsigned trees, const std::string& name,
+                              std::function<TBranch*(TTree*,int)> branch, std::function<void()> reset){
+  Entry entry;
+  entry.group = group;
+  entry.trees = trees;
+  entry.name = name;
+  entry.branch = branch;
+  entry.reset = reset;
+  entries.push_back(entry);
+}
+
+int phaseiitree::Schema::Book(TTree* ttree, Tree tree, const std::map<std::string,bool>& groups, const WriteSettings& settings){
+
+  int nbranches = 0;
+  for(size_t i=0; i<entries.size(); ++i){
+    Entry& entry = entries[i];
+    if(!(entry.trees & tree)) continue;
+    if(!entry.group.empty()){
+      std::map<std::string,bool>::const_iterator enabled = groups.find(entry.group);
+      if(enabled==groups.end() || !enabled->second) continue;
+    }
+
+    // the tool fills the variables of an enabled group whether or not their
+    // branches are written, so dropped ones are reset as well
+    if(!entry.reset_added){
+      entry.reset_added = true;
+      if(entry.reset) to_reset.push_back(i);
+    }
+    if(settings.dropped.count(entry.name) || settings.dropped.count(entry.group)) continue;
+
+    TBranch* branch = entry.branch(ttree,settings.basket_size);
+    if(branch==nullptr) continue;
+    ++nbranches;
+
+    // a branch setting wins over one for its group
+    std::map<std::string,int>::const_iterator compression = settings.compression.find(entry.name);
+    if(compression==settings.compression.end()) compression = settings.compression.find(entry.group);
+    if(compression!=settings.compression.end()) SetCompression(branch,compression->second);
+  }
+  return nbranches;
+}
+
+void phaseiitree::Schema::Reset(){
+  for(size_t i : to_reset) entries[i].reset();
+}
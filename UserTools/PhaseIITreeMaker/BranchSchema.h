@@ -0,0 +1,100 @@
+#ifndef BranchSchema_H
+#define BranchSchema_H
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "TTree.h"
+
+// The branches of the PhaseIITreeMaker trees, declared once in a table. Each
+// entry is one branch: the trees it goes on, the group (the config flag that
+// enables it), its leaf type and what its variable is reset to before every
+// entry. Creating the branches and resetting the variables are both done
+// from the table, so adding a variable is a single line.
+namespace phaseiitree {
+
+  enum Tree { kTankClusterTree = 1<<0, kMRDClusterTree = 1<<1, kTriggerTree = 1<<2 };
+  const unsigned kAllTrees = kTankClusterTree | kMRDClusterTree | kTriggerTree;
+
+  struct WriteSettings {
+    int basket_size = 32000;                  // bytes of each branch buffer
+    std::map<std::string,int> compression;    // branch or group name -> ROOT compression settings
+    std::set<std::string> dropped;            // branch or group names not to write
+  };
+
+  class Schema {
+
+   public:
+
+    // A scalar with leaf type leaf ('I','i','l','D',...), which is not reset,
+    // or is reset to value before each entry
+    template<typename T>
+    void Scalar(const std::string& group, unsigned trees, const std::string& name, T* var, char leaf){
+      Add(group,trees,name,
+          [name,var,leaf](TTree* tree, int basket){
+            return tree->Branch(name.c_str(),var,(name+"/"+leaf).c_str(),basket);
+          },
+          std::function<void()>());
+    }
+    template<typename T, typename V>
+    void Scalar(const std::string& group, unsigned trees, const std::string& name, T* var, char leaf, V value){
+      Scalar(group,trees,name,var,leaf);
+      const T reset = static_cast<T>(value);
+      entries.back().reset = [var,reset](){ *var = reset; };
+    }
+
+    // A std::vector, or a pointer to one, cleared before each entry
+    template<typename T>
+    void Vector(const std::string& group, unsigned trees, const std::string& name, std::vector<T>* var){
+      Add(group,trees,name,
+          [name,var](TTree* tree, int basket){ return tree->Branch(name.c_str(),var,basket); },
+          [var](){ var->clear(); });
+    }
+    template<typename T>
+    void Vector(const std::string& group, unsigned trees, const std::string& name, std::vector<T>** var){
+      Add(group,trees,name,
+          [name,var](TTree* tree, int basket){ return tree->Branch(name.c_str(),var,basket); },
+          [var](){ (*var)->clear(); });
+    }
+
+    // Any other class with a dictionary; not reset
+    template<typename T>
+    void Object(const std::string& group, unsigned trees, const std::string& name, T* var){
+      Add(group,trees,name,
+          [name,var](TTree* tree, int basket){ return tree->Branch(name.c_str(),var,basket); },
+          std::function<void()>());
+    }
+
+    // Creates the branches of tree whose group is enabled in groups and that
+    // are not dropped. Returns the number of branches created.
+    int Book(TTree* ttree, Tree tree, const std::map<std::string,bool>& groups, const WriteSettings& settings);
+    // Resets the variables of all entries of the enabled groups, dropped or not
+    void Reset();
+
+    size_t NumEntries() const { return entries.size(); }
+
+   private:
+
+    struct Entry {
+      std::string group;
+      unsigned trees;
+      std::string name;
+      std::function<TBranch*(TTree*,int)> branch;
+      std::function<void()> reset;
+      bool reset_added = false;
+    };
+
+    void Add(const std::string& group, unsigned trees, const std::string& name,
+             std::function<TBranch*(TTree*,int)> branch, std::function<void()> reset);
+
+    std::vector<Entry> entries;
+    std::vector<size_t> to_reset;   // entries to reset, each once
+
+  };
+
+}
+
+#endif
@@ -1,4 +1,7 @@
 #include "PhaseIITreeMaker.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PhaseIITreeMaker);
 
 PhaseIITreeMaker::PhaseIITreeMaker():Tool(){}
 
@@ -40,12 +43,64 @@ bool PhaseIITreeMaker::Initialise(std::string configfile, DataModel &data){
 
   m_variables.Get("MuonFitter_fill", MuonFitter_fill);
 
+  // Output tuning: branch buffer size, compression (for the file, and per
+  // branch or group), how often the trees are flushed and saved, branches
+  // or groups to leave out, and threads to compress baskets on
+  int compression_settings = -1;
+  long long auto_flush_entries = 0;
+  long long auto_save_entries = 0;
+  int writer_threads = 0;
+  bool enable_implicit_mt = false;
+  std::string branch_compression;
+  std::string drop_branches;
+  m_variables.Get("BasketSize",write_settings.basket_size);
+  m_variables.Get("CompressionSettings",compression_settings);
+  m_variables.Get("BranchCompression",branch_compression);
+  m_variables.Get("AutoFlushEntries",auto_flush_entries);
+  m_variables.Get("AutoSaveEntries",auto_save_entries);
+  m_variables.Get("DropBranches",drop_branches);
+  m_variables.Get("WriterThreads",writer_threads);
+  m_variables.Get("EnableImplicitMT",enable_implicit_mt);
+
+  boost::char_separator<char> sep(", ");
+  boost::tokenizer<boost::char_separator<char>> drop_tokens(drop_branches,sep);
+  for(const std::string& name : drop_tokens) write_settings.dropped.insert(name);
+  // name:settings pairs, e.g. hitT:404,MCTruth_fill:505
+  boost::tokenizer<boost::char_separator<char>> compression_tokens(branch_compression,sep);
+  for(const std::string& token : compression_tokens){
+    size_t colon = token.find(':');
+    std::string settings = (colon==std::string::npos) ? "" : token.substr(colon+1);
+    if(colon==0 || settings.empty() || settings.find_first_not_of("0123456789")!=std::string::npos){
+      Log("PhaseIITreeMaker Tool: BranchCompression entry "+token+" is not name:settings",v_error,verbosity);
+      return false;
+    }
+    write_settings.compression[token.substr(0,colon)] = std::stoi(settings);
+  }
+
+  if(writer_threads>0 && !enable_implicit_mt){
+    Log("PhaseIITreeMaker Tool: WriterThreads needs EnableImplicitMT 1, writing on one thread",v_warning,verbosity);
+  } else if(writer_threads>0){
+#ifdef R__USE_IMT
+    // with implicit multi-threading TTree::Fill compresses the baskets of a
+    // cluster on a thread pool when it flushes them
+    ROOT::EnableImplicitMT(writer_threads);
+    Log("PhaseIITreeMaker Tool: Compressing baskets on "+std::to_string(writer_threads)+" threads",v_message,verbosity);
+#else
+    Log("PhaseIITreeMaker Tool: ROOT was built without implicit multi-threading, WriterThreads ignored",v_warning,verbosity);
+#endif
+  }
+
   std::string output_filename;
   m_variables.Get("OutputFile", output_filename);
   fOutput_tfile = new TFile(output_filename.c_str(), "recreate");
+  if(compression_settings>=0) fOutput_tfile->SetCompressionSettings(compression_settings);
   fPhaseIITankClusterTree = new TTree("phaseIITankClusterTree", "ANNIE Phase II Tank Cluster Tree");
   fPhaseIIMRDClusterTree = new TTree("phaseIIMRDClusterTree", "ANNIE Phase II MRD Cluster Tree");
   fPhaseIITrigTree = new TTree("phaseIITriggerTree", "ANNIE Phase II Ntuple Trigger Tree");
+  for(TTree* tree : {fPhaseIITankClusterTree,fPhaseIIMRDClusterTree,fPhaseIITrigTree}){
+    if(auto_flush_entries>0) tree->SetAutoFlush(auto_flush_entries);
+    if(auto_save_entries>0) tree->SetAutoSave(auto_save_entries);
+  }
 
   m_data->CStore.Get("AuxChannelNumToTypeMap",AuxChannelNumToTypeMap);
   m_data->CStore.Get("ChannelNumToTankPMTSPEChargeMap",ChannelKeyToSPEMap);
@@ -61,449 +116,42 @@ bool PhaseIITreeMaker::Initialise(std::string configfile, DataModel &data){
   	return false; 
   }
  
-  if(TankClusterProcessing){
-    fPhaseIITankClusterTree->Branch("runNumber",&fRunNumber,"runNumber/I");
-    fPhaseIITankClusterTree->Branch("subrunNumber",&fSubrunNumber,"subrunNumber/I");
-    fPhaseIITankClusterTree->Branch("runType",&fRunType,"runType/I");
-    fPhaseIITankClusterTree->Branch("startTime",&fStartTime_Tree,"startTime/l");
-
-    //Some lower level information to save
-    fPhaseIITankClusterTree->Branch("eventNumber",&fEventNumber,"eventNumber/I");
-    fPhaseIITankClusterTree->Branch("eventTimeTank",&fEventTimeTank_Tree,"eventTimeTank/l");
-    fPhaseIITankClusterTree->Branch("clusterNumber",&fClusterNumber,"clusterNumber/I");
-    fPhaseIITankClusterTree->Branch("clusterTime",&fClusterTime,"clusterTime/D");
-    fPhaseIITankClusterTree->Branch("clusterCharge",&fClusterCharge,"clusterCharge/D");
-    fPhaseIITankClusterTree->Branch("clusterPE",&fClusterPE,"clusterPE/D");
-    fPhaseIITankClusterTree->Branch("clusterMaxPE",&fClusterMaxPE,"clusterMaxPE/D");
-    fPhaseIITankClusterTree->Branch("clusterChargePointX",&fClusterChargePointX,"clusterChargePointX/D");
-    fPhaseIITankClusterTree->Branch("clusterChargePointY",&fClusterChargePointY,"clusterChargePointY/D");
-    fPhaseIITankClusterTree->Branch("clusterChargePointZ",&fClusterChargePointZ,"clusterChargePointZ/D");
-    fPhaseIITankClusterTree->Branch("clusterChargeBalance",&fClusterChargeBalance,"clusterChargeBalance/D");
-    fPhaseIITankClusterTree->Branch("clusterHits",&fClusterHits,"clusterHits/i");
-    fPhaseIITankClusterTree->Branch("trigword",&fTriggerword);
-    fPhaseIITankClusterTree->Branch("TankMRDCoinc",&fTankMRDCoinc);
-    fPhaseIITankClusterTree->Branch("NoVeto",&fNoVeto);
-    fPhaseIITankClusterTree->Branch("ADCSamples",&fADCWaveformSamples);
-    fPhaseIITankClusterTree->Branch("ADCChankeys",&fADCWaveformChankeys);
-    fPhaseIITankClusterTree->Branch("Extended",&fExtended);
-    fPhaseIITankClusterTree->Branch("beam_pot",&fPot);
-    fPhaseIITankClusterTree->Branch("beam_ok",&fBeamok);
-    if(TankHitInfo_fill){
-      fPhaseIITankClusterTree->Branch("filter",&fIsFiltered);
-      fPhaseIITankClusterTree->Branch("hitX",&fHitX);
-      fPhaseIITankClusterTree->Branch("hitY",&fHitY);
-      fPhaseIITankClusterTree->Branch("hitZ",&fHitZ);
-      fPhaseIITankClusterTree->Branch("hitT",&fHitT);
-      fPhaseIITankClusterTree->Branch("hitQ",&fHitQ);
-      fPhaseIITankClusterTree->Branch("hitPE",&fHitPE);
-      fPhaseIITankClusterTree->Branch("hitType", &fHitType);
-      fPhaseIITankClusterTree->Branch("hitDetID", &fHitDetID);
-      fPhaseIITankClusterTree->Branch("hitChankey",&fHitChankey);
-      fPhaseIITankClusterTree->Branch("hitChankeyMC",&fHitChankeyMC);
-    }
-    //SiPM Pulse Info; load into both trees for now...
-    if(SiPMPulseInfo_fill){
-      fPhaseIITankClusterTree->Branch("SiPMhitQ",&fSiPMHitQ);
-      fPhaseIITankClusterTree->Branch("SiPMhitT",&fSiPMHitT);
-      fPhaseIITankClusterTree->Branch("SiPMhitAmplitude",&fSiPMHitAmplitude);
-      fPhaseIITankClusterTree->Branch("SiPMNum",&fSiPMNum);
-      fPhaseIITankClusterTree->Branch("SiPM1NPulses",&fSiPM1NPulses,"SiPM1NPulses/I");
-      fPhaseIITankClusterTree->Branch("SiPM2NPulses",&fSiPM2NPulses,"SiPM2NPulses/I");
-    }
-    //MuonFitter reco track length, vtx, energy; juju
-    if (MuonFitter_fill)
-    {
-      fPhaseIITankClusterTree->Branch("recoMuonVtxX", &fRecoMuonVtxX, "recoMuonVtxX/D");
-      fPhaseIITankClusterTree->Branch("recoMuonVtxY", &fRecoMuonVtxY, "recoMuonVtxY/D");
-      fPhaseIITankClusterTree->Branch("recoMuonVtxZ", &fRecoMuonVtxZ, "recoMuonVtxZ/D");
-      fPhaseIITankClusterTree->Branch("recoTankTrack", &fRecoTankTrack, "recoTankTrack/D");
-      fPhaseIITankClusterTree->Branch("recoMuonKE", &fRecoMuonKE, "recoMuonKE/D");
-    }
-    // MC BNB spill structure timing - AssignBunchTimingMC tool
-    if(hasBNBtimingMC){
-      fPhaseIITankClusterTree->Branch("bunchTimes",&fbunchTimes,"bunchTimes/D");
-    }
-  } 
+  //MC truth vectors are branched through their pointers
+  if (MCTruth_fill){
+    fTrueNeutCapVtxX = new std::vector<double>;
+    fTrueNeutCapVtxY = new std::vector<double>;
+    fTrueNeutCapVtxZ = new std::vector<double>;
+    fTrueNeutCapNucleus = new std::vector<double>;
+    fTrueNeutCapTime = new std::vector<double>;
+    fTrueNeutCapGammas = new std::vector<double>;
+    fTrueNeutCapE = new std::vector<double>;
+    fTrueNeutCapGammaE = new std::vector<double>;
+    fTruePrimaryPdgs = new std::vector<int>;
+  }
 
+  // Branches come from the table in DeclareBranches; each is created on the
+  // trees it belongs to if its group flag is set
+  this->DeclareBranches();
+  std::map<std::string,bool> groups = {
+    {"TankHitInfo_fill",TankHitInfo_fill}, {"MRDHitInfo_fill",MRDHitInfo_fill},
+    {"fillCleanEventsOnly",fillCleanEventsOnly}, {"MCTruth_fill",MCTruth_fill},
+    {"MRDReco_fill",MRDReco_fill}, {"TankReco_fill",TankReco_fill},
+    {"Reweight_fill",Reweight_fill}, {"RecoDebug_fill",RecoDebug_fill},
+    {"SimpleReco_fill",SimpleReco_fill}, {"RingCounting_fill",RingCounting_fill},
+    {"muonTruthRecoDiff_fill",muonTruthRecoDiff_fill}, {"SiPMPulseInfo_fill",SiPMPulseInfo_fill},
+    {"Digit_fill",Digit_fill}, {"MuonFitter_fill",MuonFitter_fill}, {"HasBNBtimingMC",hasBNBtimingMC}
+  };
+  if(TankClusterProcessing){
+    int nbranches = branch_schema.Book(fPhaseIITankClusterTree,phaseiitree::kTankClusterTree,groups,write_settings);
+    Log("PhaseIITreeMaker Tool: "+std::to_string(nbranches)+" branches in the tank cluster tree",v_message,verbosity);
+  }
   if(MRDClusterProcessing){
-    fPhaseIIMRDClusterTree->Branch("runNumber",&fRunNumber,"runNumber/I");
-    fPhaseIIMRDClusterTree->Branch("subrunNumber",&fSubrunNumber,"subrunNumber/I");
-    fPhaseIIMRDClusterTree->Branch("runType",&fRunType,"runType/I");
-    fPhaseIIMRDClusterTree->Branch("startTime",&fStartTime_Tree,"startTime/l");
-
-
-    //Some lower level information to save
-    fPhaseIIMRDClusterTree->Branch("eventNumber",&fEventNumber,"eventNumber/I");
-    fPhaseIIMRDClusterTree->Branch("eventTimeMRD",&fEventTimeMRD_Tree,"eventTimeMRD/l");
-    fPhaseIIMRDClusterTree->Branch("eventTimeTank",&fEventTimeTank_Tree,"eventTimeTank/l");
-    fPhaseIIMRDClusterTree->Branch("clusterNumber",&fMRDClusterNumber,"clusterNumber/I");
-    fPhaseIIMRDClusterTree->Branch("clusterTime",&fMRDClusterTime,"clusterTime/D");
-    fPhaseIIMRDClusterTree->Branch("clusterTimeSigma",&fMRDClusterTimeSigma,"clusterTimeSigma/D");
-    fPhaseIIMRDClusterTree->Branch("clusterHits",&fMRDClusterHits,"clusterHits/i");
-    fPhaseIIMRDClusterTree->Branch("trigword",&fTriggerword);
-    fPhaseIIMRDClusterTree->Branch("TankMRDCoinc",&fTankMRDCoinc);
-    fPhaseIIMRDClusterTree->Branch("NoVeto",&fNoVeto);
-    fPhaseIIMRDClusterTree->Branch("Extended",&fExtended);
-    fPhaseIIMRDClusterTree->Branch("beam_pot",&fPot);
-    fPhaseIIMRDClusterTree->Branch("beam_ok",&fBeamok);
-
-    if(MRDHitInfo_fill){
-      fPhaseIIMRDClusterTree->Branch("MRDhitT",&fMRDHitT);
-      fPhaseIIMRDClusterTree->Branch("MRDhitDetID", &fMRDHitDetID);
-      fPhaseIIMRDClusterTree->Branch("MRDhitChankey", &fMRDHitChankey);
-      fPhaseIIMRDClusterTree->Branch("MRDhitChankeyMC", &fMRDHitChankeyMC);
-      fPhaseIIMRDClusterTree->Branch("FMVhitT",&fFMVHitT);
-      fPhaseIIMRDClusterTree->Branch("FMVhitDetID",&fFMVHitDetID);
-      fPhaseIIMRDClusterTree->Branch("FMVhitChankey",&fFMVHitChankey);
-      fPhaseIIMRDClusterTree->Branch("FMVhitChankeyMC",&fFMVHitChankeyMC);
-      fPhaseIIMRDClusterTree->Branch("vetoHit",&fVetoHit,"vetoHit/I");
-    }
-    if(MRDReco_fill){
-      fPhaseIIMRDClusterTree->Branch("numClusterTracks",&fNumClusterTracks,"numClusterTracks/I");
-    //Push back some properties
-      fPhaseIIMRDClusterTree->Branch("MRDTrackAngle",&fMRDTrackAngle);
-      fPhaseIIMRDClusterTree->Branch("MRDTrackAngleError",&fMRDTrackAngleError);
-      fPhaseIIMRDClusterTree->Branch("MRDPenetrationDepth",&fMRDPenetrationDepth);
-      fPhaseIIMRDClusterTree->Branch("MRDTrackLength",&fMRDTrackLength);
-      fPhaseIIMRDClusterTree->Branch("MRDEntryPointRadius",&fMRDEntryPointRadius);
-      fPhaseIIMRDClusterTree->Branch("MRDEnergyLoss",&fMRDEnergyLoss);
-      fPhaseIIMRDClusterTree->Branch("MRDEnergyLossError",&fMRDEnergyLossError);
-      fPhaseIIMRDClusterTree->Branch("MRDTrackStartX",&fMRDTrackStartX);
-      fPhaseIIMRDClusterTree->Branch("MRDTrackStartY",&fMRDTrackStartY);
-      fPhaseIIMRDClusterTree->Branch("MRDTrackStartZ",&fMRDTrackStartZ);
-      fPhaseIIMRDClusterTree->Branch("MRDTrackStopX",&fMRDTrackStopX);
-      fPhaseIIMRDClusterTree->Branch("MRDTrackStopY",&fMRDTrackStopY);
-      fPhaseIIMRDClusterTree->Branch("MRDTrackStopZ",&fMRDTrackStopZ);
-      fPhaseIIMRDClusterTree->Branch("MRDSide",&fMRDSide);
-      fPhaseIIMRDClusterTree->Branch("MRDStop",&fMRDStop);
-      fPhaseIIMRDClusterTree->Branch("MRDThrough",&fMRDThrough);
-    }
-
+    int nbranches = branch_schema.Book(fPhaseIIMRDClusterTree,phaseiitree::kMRDClusterTree,groups,write_settings);
+    Log("PhaseIITreeMaker Tool: "+std::to_string(nbranches)+" branches in the MRD cluster tree",v_message,verbosity);
   }
-
   if(TriggerProcessing){
-    //Metadata for standard Events
-    fPhaseIITrigTree->Branch("runNumber",&fRunNumber,"runNumber/I");
-    fPhaseIITrigTree->Branch("subrunNumber",&fSubrunNumber,"subrunNumber/I");
-    fPhaseIITrigTree->Branch("runType",&fRunType,"runType/I");
-    fPhaseIITrigTree->Branch("startTime",&fStartTime_Tree,"startTime/l");
-    
-    
- //DIGITS   
-  if(Digit_fill){
-      fPhaseIITrigTree->Branch("digitX",&fdigitX);
-      fPhaseIITrigTree->Branch("digitY",&fdigitY);
-      fPhaseIITrigTree->Branch("digitZ",&fdigitZ);
-      fPhaseIITrigTree->Branch("digitT",&fdigitT);
-      fPhaseIITrigTree->Branch("NDigitsPMTs",&fNDigitsPMTs);
-      fPhaseIITrigTree->Branch("NDigitsLAPPDs",&fNDigitsLAPPDs);
-      
-    }
- //DIGITS   
-
-    //Some lower level information to save
-    fPhaseIITrigTree->Branch("eventNumber",&fEventNumber,"eventNumber/I");
-    fPhaseIITrigTree->Branch("eventTimeTank",&fEventTimeTank_Tree,"eventTimeTank/l");
-    fPhaseIITrigTree->Branch("eventTimeMRD",&fEventTimeMRD_Tree,"eventTimeMRD/l");
-    fPhaseIITrigTree->Branch("nhits",&fNHits,"nhits/I");
-
-    //CTC & event selection related variables
-    fPhaseIITrigTree->Branch("trigword",&fTriggerword);
-    fPhaseIITrigTree->Branch("HasTank",&fHasTank);
-    fPhaseIITrigTree->Branch("HasMRD",&fHasMRD);
-    fPhaseIITrigTree->Branch("TankMRDCoinc",&fTankMRDCoinc);
-    fPhaseIITrigTree->Branch("NoVeto",&fNoVeto);
-
-    //Extended window information
-    fPhaseIITrigTree->Branch("Extended",&fExtended);
-    
-    //Beam information
-    fPhaseIITrigTree->Branch("beam_pot",&fPot);
-    fPhaseIITrigTree->Branch("beam_ok",&fBeamok);
-
-    //Event Staus Flag Information
-    if(fillCleanEventsOnly){
-      fPhaseIITrigTree->Branch("eventStatusApplied",&fEventStatusApplied,"eventStatusApplied/I");
-      fPhaseIITrigTree->Branch("eventStatusFlagged",&fEventStatusFlagged,"eventStatusFlagged/I");
-    }
-    //Hit information (PMT and LAPPD)
-    if(SiPMPulseInfo_fill){
-      fPhaseIITrigTree->Branch("SiPM1NPulses",&fSiPM1NPulses,"SiPM1NPulses/I");
-      fPhaseIITrigTree->Branch("SiPM2NPulses",&fSiPM2NPulses,"SiPM2NPulses/I");
-      fPhaseIITrigTree->Branch("SiPMhitQ",&fSiPMHitQ);
-      fPhaseIITrigTree->Branch("SiPMhitT",&fSiPMHitT);
-      fPhaseIITrigTree->Branch("SiPMhitAmplitude",&fSiPMHitAmplitude);
-      fPhaseIITrigTree->Branch("SiPMNum",&fSiPMNum);
-    }
-
-    if(TankHitInfo_fill){
-      fPhaseIITrigTree->Branch("filter",&fIsFiltered);
-      fPhaseIITrigTree->Branch("hitX",&fHitX);
-      fPhaseIITrigTree->Branch("hitY",&fHitY);
-      fPhaseIITrigTree->Branch("hitZ",&fHitZ);
-      fPhaseIITrigTree->Branch("hitT",&fHitT);
-      fPhaseIITrigTree->Branch("hitQ",&fHitQ);
-      fPhaseIITrigTree->Branch("hitPE",&fHitPE);
-      fPhaseIITrigTree->Branch("hitType", &fHitType);
-      fPhaseIITrigTree->Branch("hitDetID", &fHitDetID);
-      fPhaseIITrigTree->Branch("hitChankey", &fHitChankey);
-      fPhaseIITrigTree->Branch("hitChankeyMC",&fHitChankeyMC);
-    }
-
-    if(MRDHitInfo_fill){
-      fPhaseIITrigTree->Branch("MRDhitT",&fMRDHitT);
-      fPhaseIITrigTree->Branch("MRDhitDetID", &fMRDHitDetID);
-      fPhaseIITrigTree->Branch("MRDhitChankey", &fMRDHitChankey);
-      fPhaseIITrigTree->Branch("MRDhitChankeyMC", &fMRDHitChankeyMC);
-      fPhaseIITrigTree->Branch("FMVhitT",&fFMVHitT);
-      fPhaseIITrigTree->Branch("FMVhitDetID",&fFMVHitDetID);
-      fPhaseIITrigTree->Branch("FMVhitChankey",&fFMVHitChankey);
-      fPhaseIITrigTree->Branch("FMVhitChankeyMC",&fFMVHitChankeyMC);
-      fPhaseIITrigTree->Branch("vetoHit",&fVetoHit,"vetoHit/I");
-    }
-    if(MRDReco_fill){
-      fPhaseIITrigTree->Branch("numMRDTracks",&fNumClusterTracks,"numMRDTracks/I");
-    //Push back some properties
-      fPhaseIITrigTree->Branch("MRDTrackAngle",&fMRDTrackAngle);
-      fPhaseIITrigTree->Branch("MRDTrackAngleError",&fMRDTrackAngleError);
-      fPhaseIITrigTree->Branch("MRDPenetrationDepth",&fMRDPenetrationDepth);
-      fPhaseIITrigTree->Branch("MRDTrackLength",&fMRDTrackLength);
-      fPhaseIITrigTree->Branch("MRDEntryPointRadius",&fMRDEntryPointRadius);
-      fPhaseIITrigTree->Branch("MRDEnergyLoss",&fMRDEnergyLoss);
-      fPhaseIITrigTree->Branch("MRDEnergyLossError",&fMRDEnergyLossError);
-      fPhaseIITrigTree->Branch("MRDTrackStartX",&fMRDTrackStartX);
-      fPhaseIITrigTree->Branch("MRDTrackStartY",&fMRDTrackStartY);
-      fPhaseIITrigTree->Branch("MRDTrackStartZ",&fMRDTrackStartZ);
-      fPhaseIITrigTree->Branch("MRDTrackStopX",&fMRDTrackStopX);
-      fPhaseIITrigTree->Branch("MRDTrackStopY",&fMRDTrackStopY);
-      fPhaseIITrigTree->Branch("MRDTrackStopZ",&fMRDTrackStopZ);
-      fPhaseIITrigTree->Branch("MRDSide",&fMRDSide);
-      fPhaseIITrigTree->Branch("MRDStop",&fMRDStop);
-      fPhaseIITrigTree->Branch("MRDThrough",&fMRDThrough);
-    }
-
-    //Reconstructed variables after full Muon Reco Analysis
-    if(TankReco_fill){
-      fPhaseIITrigTree->Branch("recoVtxX",&fRecoVtxX,"recoVtxX/D");
-      fPhaseIITrigTree->Branch("recoVtxY",&fRecoVtxY,"recoVtxY/D");
-      fPhaseIITrigTree->Branch("recoVtxZ",&fRecoVtxZ,"recoVtxZ/D");
-      fPhaseIITrigTree->Branch("recoVtxTime",&fRecoVtxTime,"recoVtxTime/D");
-      fPhaseIITrigTree->Branch("recoDirX",&fRecoDirX,"recoDirX/D");
-      fPhaseIITrigTree->Branch("recoDirY",&fRecoDirY,"recoDirY/D");
-      fPhaseIITrigTree->Branch("recoDirZ",&fRecoDirZ,"recoDirZ/D");
-      fPhaseIITrigTree->Branch("recoAngle",&fRecoAngle,"recoAngle/D");
-      fPhaseIITrigTree->Branch("recoPhi",&fRecoPhi,"recoPhi/D");
-      fPhaseIITrigTree->Branch("recoVtxFOM",&fRecoVtxFOM,"recoVtxFOM/D");
-      fPhaseIITrigTree->Branch("recoStatus",&fRecoStatus,"recoStatus/I");
-    }
-
-    //Michael's Simple Reconstruction
-    if(SimpleReco_fill){
-      fPhaseIITrigTree->Branch("simpleRecoFlag",&fSimpleFlag,"simpleRecoFlag/I");
-      fPhaseIITrigTree->Branch("simpleRecoEnergy",&fSimpleEnergy,"simpleRecoEnergy/D");
-      fPhaseIITrigTree->Branch("simpleRecoVtxX",&fSimpleVtxX,"simpleRecoVtxX/D");
-      fPhaseIITrigTree->Branch("simpleRecoVtxY",&fSimpleVtxY,"simpleRecoVtxY/D");
-      fPhaseIITrigTree->Branch("simpleRecoVtxZ",&fSimpleVtxZ,"simpleRecoVtxZ/D");
-      fPhaseIITrigTree->Branch("simpleRecoStopVtxX",&fSimpleStopVtxX,"simpleRecoStopVtxX/D");
-      fPhaseIITrigTree->Branch("simpleRecoStopVtxY",&fSimpleStopVtxY,"simpleRecoStopVtxY/D");
-      fPhaseIITrigTree->Branch("simpleRecoStopVtxZ",&fSimpleStopVtxZ,"simpleRecoStopVtxZ/D");
-      fPhaseIITrigTree->Branch("simpleRecoCosTheta",&fSimpleCosTheta,"simpleRecoCosTheta/D");
-      fPhaseIITrigTree->Branch("simpleRecoPt",&fSimplePt,"simpleRecoPt/D");
-      fPhaseIITrigTree->Branch("simpleRecoFV",&fSimpleFV,"simpleRecoFV/I");
-      fPhaseIITrigTree->Branch("simpleRecoMrdEnergyLoss",&fSimpleMrdEnergyLoss,"simpleRecoMrdEnergyLoss/D");
-      fPhaseIITrigTree->Branch("simpleRecoTrackLengthInMRD",&fSimpleTrackLengthInMRD,"simpleRecoTrackLengthInMRD/D");
-      fPhaseIITrigTree->Branch("simpleRecoMRDStartX",&fSimpleMRDStartX,"simpleRecoMRDStartX/D");
-      fPhaseIITrigTree->Branch("simpleRecoMRDStartY",&fSimpleMRDStartY,"simpleRecoMRDStartY/D");
-      fPhaseIITrigTree->Branch("simpleRecoMRDStartZ",&fSimpleMRDStartZ,"simpleRecoMRDStartZ/D");
-      fPhaseIITrigTree->Branch("simpleRecoMRDStopX",&fSimpleMRDStopX,"simpleRecoMRDStopX/D");
-      fPhaseIITrigTree->Branch("simpleRecoMRDStopY",&fSimpleMRDStopY,"simpleRecoMRDStopY/D");
-      fPhaseIITrigTree->Branch("simpleRecoMRDStopZ",&fSimpleMRDStopZ,"simpleRecoMRDStopZ/D");
-      fPhaseIITrigTree->Branch("simpleRecoTrackLengthInTank",&fSimpleTrackLengthInTank,"simpleRecoTrackLengthInTank/D");
-    }
- 
-    //Ring Counting
-    if(RingCounting_fill){
-      fPhaseIITrigTree->Branch("RCSRPred",&fRCSRPred,"RCSRPred/D");
-      fPhaseIITrigTree->Branch("RCMRPred",&fRCMRPred,"RCMRPred/D");
-    }
- 
-    //MC truth information for muons
-    //Output to tree when MCTruth_fill = 1 in config
-    if (MCTruth_fill){
-      fTrueNeutCapVtxX = new std::vector<double>;
-      fTrueNeutCapVtxY = new std::vector<double>;
-      fTrueNeutCapVtxZ = new std::vector<double>;
-      fTrueNeutCapNucleus = new std::vector<double>;
-      fTrueNeutCapTime = new std::vector<double>;
-      fTrueNeutCapGammas = new std::vector<double>;
-      fTrueNeutCapE = new std::vector<double>;
-      fTrueNeutCapGammaE = new std::vector<double>;
-      fTruePrimaryPdgs = new std::vector<int>;
-      fPhaseIITrigTree->Branch("triggerNumber",&fiMCTriggerNum,"triggerNumber/I");
-      fPhaseIITrigTree->Branch("mcEntryNumber",&fMCEventNum,"mcEntryNumber/I");
-      fPhaseIITrigTree->Branch("trueVtxX",&fTrueVtxX,"trueVtxX/D");
-      fPhaseIITrigTree->Branch("trueVtxY",&fTrueVtxY,"trueVtxY/D");
-      fPhaseIITrigTree->Branch("trueVtxZ",&fTrueVtxZ,"trueVtxZ/D");
-      fPhaseIITrigTree->Branch("trueVtxTime",&fTrueVtxTime,"trueVtxTime/D");
-      fPhaseIITrigTree->Branch("trueDirX",&fTrueDirX,"trueDirX/D");
-      fPhaseIITrigTree->Branch("trueDirY",&fTrueDirY,"trueDirY/D");
-      fPhaseIITrigTree->Branch("trueDirZ",&fTrueDirZ,"trueDirZ/D");
-      fPhaseIITrigTree->Branch("trueAngle",&fTrueAngle,"trueAngle/D");
-      fPhaseIITrigTree->Branch("truePhi",&fTruePhi,"truePhi/D");
-      fPhaseIITrigTree->Branch("trueMuonEnergy",&fTrueMuonEnergy,"trueMuonEnergy/D");
-      fPhaseIITrigTree->Branch("truePrimaryPdg",&fTruePrimaryPdg,"truePrimaryPdg/I");
-      fPhaseIITrigTree->Branch("trueTrackLengthInWater",&fTrueTrackLengthInWater,"trueTrackLengthInWater/D");
-      fPhaseIITrigTree->Branch("trueTrackLengthInMRD",&fTrueTrackLengthInMRD,"trueTrackLengthInMRD/D");
-      fPhaseIITrigTree->Branch("trueMultiRing",&fTrueMultiRing,"trueMultiRing/I");
-      fPhaseIITrigTree->Branch("Pi0Count",&fPi0Count,"Pi0Count/I");
-      fPhaseIITrigTree->Branch("PiPlusCount",&fPiPlusCount,"PiPlusCount/I");
-      fPhaseIITrigTree->Branch("PiMinusCount",&fPiMinusCount,"PiMinusCount/I");
-      fPhaseIITrigTree->Branch("K0Count",&fK0Count,"K0Count/I");
-      fPhaseIITrigTree->Branch("KPlusCount",&fKPlusCount,"KPlusCount/I");
-      fPhaseIITrigTree->Branch("KMinusCount",&fKMinusCount,"KMinusCount/I");
-      fPhaseIITrigTree->Branch("truePrimaryPdgs",&fTruePrimaryPdgs);
-      fPhaseIITrigTree->Branch("trueNeutCapVtxX",&fTrueNeutCapVtxX);
-      fPhaseIITrigTree->Branch("trueNeutCapVtxY",&fTrueNeutCapVtxY);
-      fPhaseIITrigTree->Branch("trueNeutCapVtxZ",&fTrueNeutCapVtxZ);
-      fPhaseIITrigTree->Branch("trueNeutCapNucleus",&fTrueNeutCapNucleus);
-      fPhaseIITrigTree->Branch("trueNeutCapTime",&fTrueNeutCapTime);
-      fPhaseIITrigTree->Branch("trueNeutCapGammas",&fTrueNeutCapGammas);
-      fPhaseIITrigTree->Branch("trueNeutCapE",&fTrueNeutCapE);
-      fPhaseIITrigTree->Branch("trueNeutCapGammaE",&fTrueNeutCapGammaE);
-      fPhaseIITrigTree->Branch("trueNeutrinoEnergy",&fTrueNeutrinoEnergy,"trueNeutrinoEnergy/D");
-      fPhaseIITrigTree->Branch("trueNeutrinoMomentum_X",&fTrueNeutrinoMomentum_X,"trueNeutrinoMomentum_X/D");
-      fPhaseIITrigTree->Branch("trueNeutrinoMomentum_Y",&fTrueNeutrinoMomentum_Y,"trueNeutrinoMomentum_Y/D");
-      fPhaseIITrigTree->Branch("trueNeutrinoMomentum_Z",&fTrueNeutrinoMomentum_Z,"trueNeutrinoMomentum_Z/D");
-      fPhaseIITrigTree->Branch("trueNuIntxVtx_X",&fTrueNuIntxVtx_X,"trueNuIntxVtx_X/D");
-      fPhaseIITrigTree->Branch("trueNuIntxVtx_Y",&fTrueNuIntxVtx_Y,"trueNuIntxVtx_Y/D");
-      fPhaseIITrigTree->Branch("trueNuIntxVtx_Z",&fTrueNuIntxVtx_Z,"trueNuIntxVtx_Z/D");
-      fPhaseIITrigTree->Branch("trueNuIntxVtx_T",&fTrueNuIntxVtx_T,"trueNuIntxVtx_T/D");
-      fPhaseIITrigTree->Branch("trueFSLVtx_X",&fTrueFSLVtx_X,"trueFSLVtx_X/D");
-      fPhaseIITrigTree->Branch("trueFSLVtx_Y",&fTrueFSLVtx_Y,"trueFSLVtx_Y/D");
-      fPhaseIITrigTree->Branch("trueFSLVtx_Z",&fTrueFSLVtx_Z,"trueFSLVtx_Z/D");
-      fPhaseIITrigTree->Branch("trueFSLMomentum_X",&fTrueFSLMomentum_X,"trueFSLMomentum_X/D");
-      fPhaseIITrigTree->Branch("trueFSLMomentum_Y",&fTrueFSLMomentum_Y,"trueFSLMomentum_Y/D");
-      fPhaseIITrigTree->Branch("trueFSLMomentum_Z",&fTrueFSLMomentum_Z,"trueFSLMomentum_Z/D");
-      fPhaseIITrigTree->Branch("trueFSLTime",&fTrueFSLTime,"trueFSLTime/D");
-      fPhaseIITrigTree->Branch("trueFSLMass",&fTrueFSLMass,"trueFSLMass/D");
-      fPhaseIITrigTree->Branch("trueFSLPdg",&fTrueFSLPdg,"trueFSLPdg/I");
-      fPhaseIITrigTree->Branch("trueFSLEnergy",&fTrueFSLEnergy,"trueFSLEnergy/D");
-      fPhaseIITrigTree->Branch("trueQ2",&fTrueQ2,"trueQ2/D");
-      fPhaseIITrigTree->Branch("trueCC",&fTrueCC,"trueCC/I");
-      fPhaseIITrigTree->Branch("trueNC",&fTrueNC,"trueNC/I");
-      fPhaseIITrigTree->Branch("trueQEL",&fTrueQEL,"trueQEL/I");
-      fPhaseIITrigTree->Branch("trueRES",&fTrueRES,"trueRES/I");
-      fPhaseIITrigTree->Branch("trueDIS",&fTrueDIS,"trueDIS/I");
-      fPhaseIITrigTree->Branch("trueCOH",&fTrueCOH,"trueCOH/I");
-      fPhaseIITrigTree->Branch("trueMEC",&fTrueMEC,"trueMEC/I");
-      fPhaseIITrigTree->Branch("trueNeutrons",&fTrueNeutrons,"trueNeutrons/I");
-      fPhaseIITrigTree->Branch("trueProtons",&fTrueProtons,"trueProtons/I");
-      fPhaseIITrigTree->Branch("truePi0",&fTruePi0,"truePi0/I");
-      fPhaseIITrigTree->Branch("truePiPlus",&fTruePiPlus,"truePiPlus/I");
-      fPhaseIITrigTree->Branch("truePiPlusCher",&fTruePiPlusCher,"truePiPlusCher/I");
-      fPhaseIITrigTree->Branch("truePiMinus",&fTruePiMinus,"truePiMinus/I");
-      fPhaseIITrigTree->Branch("truePiMinusCher",&fTruePiMinusCher,"truePiMinusCher/I");
-      fPhaseIITrigTree->Branch("trueKPlus",&fTrueKPlus,"trueKPlus/I");
-      fPhaseIITrigTree->Branch("trueKPlusCher",&fTrueKPlusCher,"trueKPlusCher/I"); 
-      fPhaseIITrigTree->Branch("trueKMinus",&fTrueKMinus,"trueKMinus/I");
-      fPhaseIITrigTree->Branch("trueKMinusCher",&fTrueKMinusCher,"trueKMinusCher/I"); 
-      fPhaseIITrigTree->Branch("trueBJx",&fTrueBJx,"trueBJx/D");
-      fPhaseIITrigTree->Branch("truey",&fTruey,"truey/D");
-      fPhaseIITrigTree->Branch("trueq0",&fTrueq0,"trueq0/D");
-      fPhaseIITrigTree->Branch("trueq3",&fTrueq3,"trueq3/D");
-      fPhaseIITrigTree->Branch("trueTargetZ",&fTrueTarget,"trueTargetZ/I");
-      fPhaseIITrigTree->Branch("trueW2",&fTrueW2,"trueW2/D");
-    }
-
-    if (Reweight_fill){
-      fPhaseIITrigTree->Branch("XSecWeights",&fxsec_weights);
-      fPhaseIITrigTree->Branch("FluxWeights",&fflux_weights);
-      fPhaseIITrigTree->Branch("weight_All_UBGenie",&fAll);
-      fPhaseIITrigTree->Branch("weight_AxFFCCQEshape_UBGenie",&fAxFFCCQEshape);
-      fPhaseIITrigTree->Branch("weight_DecayAngMEC_UBGenie",&fDecayAngMEC);
-      fPhaseIITrigTree->Branch("weight_NormCCCOH_UBGenie",&fNormCCCOH);
-      fPhaseIITrigTree->Branch("weight_Norm_NCCOH_UBGenie",&fNorm_NCCOH);
-      fPhaseIITrigTree->Branch("weight_RPA_CCQE_UBGenie",&fRPA_CCQE);
-      fPhaseIITrigTree->Branch("weight_RootinoFix_UBGenie",&fRootinoFix);
-      fPhaseIITrigTree->Branch("weight_ThetaDelta2NRad_UBGenie",&fThetaDelta2NRad);
-      fPhaseIITrigTree->Branch("weight_Theta_Delta2Npi_UBGenie",&fTheta_Delta2Npi);
-      fPhaseIITrigTree->Branch("weight_TunedCentralValue_UBGenie",&fTunedCentralValue);
-      fPhaseIITrigTree->Branch("weight_VecFFCCQEshape_UBGenie",&fVecFFCCQEshape);
-      fPhaseIITrigTree->Branch("weight_XSecShape_CCMEC_UBGenie",&fXSecShape_CCMEC); 
-      fPhaseIITrigTree->Branch("weight_horncurrent_FluxUnisim",&fhorncurrent);
-      fPhaseIITrigTree->Branch("weight_expskin_FluxUnisim",&fexpskin);
-      fPhaseIITrigTree->Branch("weight_piplus_PrimaryHadronSWCentralSplineVariation",&fpiplus);
-      fPhaseIITrigTree->Branch("weight_piminus_PrimaryHadronSWCentralSplineVariation",&fpiminus);
-      fPhaseIITrigTree->Branch("weight_kplus_PrimaryHadronFeynmanScaling",&fkplus);
-      fPhaseIITrigTree->Branch("weight_kzero_PrimaryHadronSanfordWang",&fkzero);
-      fPhaseIITrigTree->Branch("weight_kminus_PrimaryHadronNormalization",&fkminus);
-      fPhaseIITrigTree->Branch("weight_pioninexsec_FluxUnisim",&fpioninexsec);
-      fPhaseIITrigTree->Branch("weight_pionqexsec_FluxUnisim",&fpionqexsec);
-      fPhaseIITrigTree->Branch("weight_piontotxsec_FluxUnisim",&fpiontotxsec);
-      fPhaseIITrigTree->Branch("weight_nucleoninexsec_FluxUnisim",&fnucleoninexsec);
-      fPhaseIITrigTree->Branch("weight_nucleonqexsec_FluxUnisim",&fnucleonqexsec);
-      fPhaseIITrigTree->Branch("weight_nucleontotxsec_FluxUnisim",&fnucleontotxsec);
-    } 
-
-    //MuonFitter reco track length, vtx, energy; juju
-    if (MuonFitter_fill)
-    {
-      fPhaseIITrigTree->Branch("recoMuonVtxX", &fRecoMuonVtxX, "recoMuonVtxX/D");
-      fPhaseIITrigTree->Branch("recoMuonVtxY", &fRecoMuonVtxY, "recoMuonVtxY/D");
-      fPhaseIITrigTree->Branch("recoMuonVtxZ", &fRecoMuonVtxZ, "recoMuonVtxZ/D");
-      fPhaseIITrigTree->Branch("recoTankTrack", &fRecoTankTrack, "recoTankTrack/D");
-      fPhaseIITrigTree->Branch("recoMuonKE", &fRecoMuonKE, "recoMuonKE/D");
-      fPhaseIITrigTree->Branch("numMrdLayers", &fNumMrdLayers, "numMrdLayers/I");
-    }
-  
-    // Reconstructed variables from each step in Muon Reco Analysis
-    // Currently output when RecoDebug_fill = 1 in config 
-    if (RecoDebug_fill){
-      fPhaseIITrigTree->Branch("seedVtxX",&fSeedVtxX); 
-      fPhaseIITrigTree->Branch("seedVtxY",&fSeedVtxY); 
-      fPhaseIITrigTree->Branch("seedVtxZ",&fSeedVtxZ);
-      fPhaseIITrigTree->Branch("seedVtxFOM",&fSeedVtxFOM); 
-      fPhaseIITrigTree->Branch("seedVtxTime",&fSeedVtxTime,"seedVtxTime/D");
-    
-      fPhaseIITrigTree->Branch("pointPosX",&fPointPosX,"pointPosX/D");
-      fPhaseIITrigTree->Branch("pointPosY",&fPointPosY,"pointPosY/D");
-      fPhaseIITrigTree->Branch("pointPosZ",&fPointPosZ,"pointPosZ/D");
-      fPhaseIITrigTree->Branch("pointPosTime",&fPointPosTime,"pointPosTime/D");
-      fPhaseIITrigTree->Branch("pointPosFOM",&fPointPosFOM,"pointPosFOM/D");
-      fPhaseIITrigTree->Branch("pointPosStatus",&fPointPosStatus,"pointPosStatus/I");
-      
-      fPhaseIITrigTree->Branch("pointDirX",&fPointDirX,"pointDirX/D");
-      fPhaseIITrigTree->Branch("pointDirY",&fPointDirY,"pointDirY/D");
-      fPhaseIITrigTree->Branch("pointDirZ",&fPointDirZ,"pointDirZ/D");
-      fPhaseIITrigTree->Branch("pointDirTime",&fPointDirTime,"pointDirTime/D");
-      fPhaseIITrigTree->Branch("pointDirStatus",&fPointDirStatus,"pointDirStatus/I");
-      fPhaseIITrigTree->Branch("pointDirFOM",&fPointDirFOM,"pointDirFOM/D");
-    
-      fPhaseIITrigTree->Branch("pointVtxPosX",&fPointVtxPosX,"pointVtxPosX/D");
-      fPhaseIITrigTree->Branch("pointVtxPosY",&fPointVtxPosY,"pointVtxPosY/D");
-      fPhaseIITrigTree->Branch("pointVtxPosZ",&fPointVtxPosZ,"pointVtxPosZ/D");
-      fPhaseIITrigTree->Branch("pointVtxTime",&fPointVtxTime,"pointVtxTime/D");
-      fPhaseIITrigTree->Branch("pointVtxDirX",&fPointVtxDirX,"pointVtxDirX/D");
-      fPhaseIITrigTree->Branch("pointVtxDirY",&fPointVtxDirY,"pointVtxDirY/D");
-      fPhaseIITrigTree->Branch("pointVtxDirZ",&fPointVtxDirZ,"pointVtxDirZ/D");
-      fPhaseIITrigTree->Branch("pointVtxFOM",&fPointVtxFOM,"pointVtxFOM/D");
-      fPhaseIITrigTree->Branch("pointVtxStatus",&fPointVtxStatus,"pointVtxStatus/I");
-    } 
-
-    // Difference in MC Truth and Muon Reconstruction Analysis
-    // Output to tree when muonTruthRecoDiff_fill = 1 in config
-    if (muonTruthRecoDiff_fill){
-      fPhaseIITrigTree->Branch("deltaVtxX",&fDeltaVtxX,"deltaVtxX/D");
-      fPhaseIITrigTree->Branch("deltaVtxY",&fDeltaVtxY,"deltaVtxY/D");
-      fPhaseIITrigTree->Branch("deltaVtxZ",&fDeltaVtxZ,"deltaVtxZ/D");
-      fPhaseIITrigTree->Branch("deltaVtxR",&fDeltaVtxR,"deltaVtxR/D");
-      fPhaseIITrigTree->Branch("deltaVtxT",&fDeltaVtxT,"deltaVtxT/D");
-      fPhaseIITrigTree->Branch("deltaParallel",&fDeltaParallel,"deltaParallel/D");
-      fPhaseIITrigTree->Branch("deltaPerpendicular",&fDeltaPerpendicular,"deltaPerpendicular/D");
-      fPhaseIITrigTree->Branch("deltaAzimuth",&fDeltaAzimuth,"deltaAzimuth/D");
-      fPhaseIITrigTree->Branch("deltaZenith",&fDeltaZenith,"deltaZenith/D");
-      fPhaseIITrigTree->Branch("deltaAngle",&fDeltaAngle,"deltaAngle/D");
-    } 
+    int nbranches = branch_schema.Book(fPhaseIITrigTree,phaseiitree::kTriggerTree,groups,write_settings);
+    Log("PhaseIITreeMaker Tool: "+std::to_string(nbranches)+" branches in the trigger tree",v_message,verbosity);
   }
   return true;
 }
@@ -974,311 +622,333 @@ bool PhaseIITreeMaker::Execute(){
 bool PhaseIITreeMaker::Finalise(){
   
   fOutput_tfile->cd();
-  fPhaseIITrigTree->Write();
-  fPhaseIIMRDClusterTree->Write();
-  fPhaseIITankClusterTree->Write();
+  // replace the tree headers written by AutoSave
+  fPhaseIITrigTree->Write("",TObject::kOverwrite);
+  fPhaseIIMRDClusterTree->Write("",TObject::kOverwrite);
+  fPhaseIITankClusterTree->Write("",TObject::kOverwrite);
   fOutput_tfile->Close();
   if(verbosity>0) cout<<"PhaseIITreeMaker exitting"<<endl;
 
   return true;
 }
 
-void PhaseIITreeMaker::ResetVariables() {
-  // tree variables
-  fStartTime_Tree = 9999;
-  fEventNumber = -9999;
-  fEventTimeTank_Tree = 9999;
-  fNHits = -9999;
-  fNDigitsPMTs = -9999;
-  fNDigitsLAPPDs = -9999;
-  fVetoHit = -9999;
-  fEventTimeMRD_Tree = 9999;
-  fTriggerword = -1;
-  fTankMRDCoinc = -99999;
-  fNoVeto = -99999;
-  fHasTank = -99999;
-  fHasMRD = -99999;
-  fPot = -99999;
-  fBeamok = -99999;
-  fExtended = -99999;
-
-  if(SiPMPulseInfo_fill){
-    fSiPM1NPulses = -9999;
-    fSiPM2NPulses = -9999;
-    fSiPMHitQ.clear();
-    fSiPMHitT.clear();
-    fSiPMHitAmplitude.clear();
-    fSiPMNum.clear();
-  }
-
-  if(hasBNBtimingMC){
-      fbunchTimes = -9999;
-  }
+void PhaseIITreeMaker::DeclareBranches() {
+  // One line per branch: group (config flag enabling it, "" always), trees,
+  // branch name, variable, leaf type and the value it is reset to before
+  // each entry (none: keeps its value). Vectors are cleared before each entry.
+  using namespace phaseiitree;
+  const unsigned kTank = kTankClusterTree, kMRD = kMRDClusterTree, kTrig = kTriggerTree;
+  Schema& s = branch_schema;
+
+  //Run level information
+  s.Scalar("",kAllTrees,"runNumber",&fRunNumber,'I');
+  s.Scalar("",kAllTrees,"subrunNumber",&fSubrunNumber,'I');
+  s.Scalar("",kAllTrees,"runType",&fRunType,'I');
+  s.Scalar("",kAllTrees,"startTime",&fStartTime_Tree,'l',9999);
+
+  //Some lower level information to save
+  s.Scalar("",kAllTrees,"eventNumber",&fEventNumber,'I',-9999);
+  s.Scalar("",kMRD|kTrig,"eventTimeMRD",&fEventTimeMRD_Tree,'l',9999);
+  s.Scalar("",kAllTrees,"eventTimeTank",&fEventTimeTank_Tree,'l',9999);
+  s.Scalar("",kTrig,"nhits",&fNHits,'I',-9999);
+
+  //Tank cluster
+  s.Scalar("",kTank,"clusterNumber",&fClusterNumber,'I',-9999);
+  s.Scalar("",kTank,"clusterTime",&fClusterTime,'D',-9999);
+  s.Scalar("",kTank,"clusterCharge",&fClusterCharge,'D',-9999);
+  s.Scalar("",kTank,"clusterPE",&fClusterPE,'D');
+  s.Scalar("",kTank,"clusterMaxPE",&fClusterMaxPE,'D',-9999);
+  s.Scalar("",kTank,"clusterChargePointX",&fClusterChargePointX,'D',-9999);
+  s.Scalar("",kTank,"clusterChargePointY",&fClusterChargePointY,'D',-9999);
+  s.Scalar("",kTank,"clusterChargePointZ",&fClusterChargePointZ,'D',-9999);
+  s.Scalar("",kTank,"clusterChargeBalance",&fClusterChargeBalance,'D',-9999);
+  s.Scalar("",kTank,"clusterHits",&fClusterHits,'i');
+
+  //MRD cluster
+  s.Scalar("",kMRD,"clusterNumber",&fMRDClusterNumber,'I',-9999);
+  s.Scalar("",kMRD,"clusterTime",&fMRDClusterTime,'D',-9999);
+  s.Scalar("",kMRD,"clusterTimeSigma",&fMRDClusterTimeSigma,'D',-9999);
+  s.Scalar("",kMRD,"clusterHits",&fMRDClusterHits,'i',-9999);
+
+  //CTC & event selection related variables
+  s.Scalar("",kAllTrees,"trigword",&fTriggerword,'I',-1);
+  s.Scalar("",kTrig,"HasTank",&fHasTank,'I',-99999);
+  s.Scalar("",kTrig,"HasMRD",&fHasMRD,'I',-99999);
+  s.Scalar("",kAllTrees,"TankMRDCoinc",&fTankMRDCoinc,'I',-99999);
+  s.Scalar("",kAllTrees,"NoVeto",&fNoVeto,'I',-99999);
+  s.Vector("",kTank,"ADCSamples",&fADCWaveformSamples);
+  s.Vector("",kTank,"ADCChankeys",&fADCWaveformChankeys);
+
+  //Extended window and beam information
+  s.Scalar("",kAllTrees,"Extended",&fExtended,'I',-99999);
+  s.Scalar("",kAllTrees,"beam_pot",&fPot,'D',-99999);
+  s.Scalar("",kAllTrees,"beam_ok",&fBeamok,'I',-99999);
+
+  //Event Staus Flag Information
+  s.Scalar("fillCleanEventsOnly",kTrig,"eventStatusApplied",&fEventStatusApplied,'I');
+  s.Scalar("fillCleanEventsOnly",kTrig,"eventStatusFlagged",&fEventStatusFlagged,'I');
 
-  if(TankClusterProcessing){
-    fClusterMaxPE = -9999;
-    fClusterChargePointX = -9999;
-    fClusterChargePointY = -9999;
-    fClusterChargePointZ = -9999;
-    fClusterChargeBalance = -9999;
-    fClusterTime = -9999;
-    fClusterCharge = -9999;
-    fClusterNumber = -9999;
-    fADCWaveformSamples.clear();
-    fADCWaveformChankeys.clear();
-  } 
-  if(MCTruth_fill){ 
-    fMCEventNum = -9999;
-    fMCTriggerNum = -9999;
-    fTrueVtxX = -9999;
-    fTrueVtxY = -9999;
-    fTrueVtxZ = -9999;
-    fTrueVtxTime = -9999;
-    fTrueMuonEnergy = -9999;
-    fTrueTrackLengthInWater = -9999;
-    fTrueTrackLengthInMRD = -9999;
-    fTrueDirX = -9999;
-    fTrueDirY = -9999;
-    fTrueDirZ = -9999;
-    fTrueAngle = -9999;
-    fTruePhi = -9999;
-    fPi0Count = -9999;
-    fPiPlusCount = -9999;
-    fPiMinusCount = -9999;
-    fK0Count = -9999;
-    fKPlusCount = -9999;
-    fKMinusCount = -9999;
-    fTrueMultiRing = -9999;
-    fTruePrimaryPdgs->clear();
-    fTrueNeutCapVtxX->clear();
-    fTrueNeutCapVtxY->clear();
-    fTrueNeutCapVtxZ->clear();
-    fTrueNeutCapNucleus->clear();
-    fTrueNeutCapTime->clear();
-    fTrueNeutCapGammas->clear();
-    fTrueNeutCapE->clear();
-    fTrueNeutCapGammaE->clear();
-    fTrueNeutrinoEnergy = -9999;
-    fTrueNeutrinoMomentum_X = -9999;
-    fTrueNeutrinoMomentum_Y = -9999;
-    fTrueNeutrinoMomentum_Z = -9999;
-    fTrueNuIntxVtx_X = -9999;
-    fTrueNuIntxVtx_Y = -9999;
-    fTrueNuIntxVtx_Z = -9999;
-    fTrueNuIntxVtx_T = -9999;
-    fTrueFSLVtx_X = -9999;
-    fTrueFSLVtx_Y = -9999;
-    fTrueFSLVtx_Z = -9999;
-    fTrueFSLMomentum_X = -9999;
-    fTrueFSLMomentum_Y = -9999;
-    fTrueFSLMomentum_Z = -9999;
-    fTrueFSLTime = -9999;
-    fTrueFSLMass = -9999;
-    fTrueFSLPdg = -9999;
-    fTrueFSLEnergy = -9999;
-    fTrueQ2 = -9999;
-    fTrueCC = -9999;
-    fTrueNC = -9999;
-    fTrueQEL = -9999;
-    fTrueRES = -9999;
-    fTrueDIS = -9999;
-    fTrueCOH = -9999;
-    fTrueMEC = -9999;
-    fTrueProtons = -9999;
-    fTrueNeutrons = -9999;
-    fTruePi0 = -9999;
-    fTruePiPlus = -9999;
-    fTruePiPlusCher = -9999;
-    fTruePiMinus = -9999;
-    fTruePiMinusCher = -9999;
-    fTrueKPlus = -9999;
-    fTrueKPlusCher = -9999;
-    fTrueKMinus = -9999;
-    fTrueKMinusCher = -9999;
-    fTrueW2 = -9999;
-    fTrueBJx = -9999;
-    fTruey = -9999;
-    fTrueTarget = -9999;
-    fTrueq0 = -9999;
-    fTrueq3 = -9999;
-  }
-
-  if (Reweight_fill){
-    fAll.clear();
-    fAxFFCCQEshape.clear();
-    fDecayAngMEC.clear();
-    fNormCCCOH.clear();
-    fNorm_NCCOH.clear();
-    fRPA_CCQE.clear();
-    fRootinoFix.clear();
-    fThetaDelta2NRad.clear();
-    fTheta_Delta2Npi.clear();
-    fTunedCentralValue.clear();
-    fVecFFCCQEshape.clear();
-    fXSecShape_CCMEC.clear();
-    fpiplus.clear();
-    fpiminus.clear();
-    fkplus.clear();
-    fkzero.clear();
-    fkminus.clear();
-    fhorncurrent.clear();
-    fpioninexsec.clear();
-    fpionqexsec.clear();
-    fpiontotxsec.clear();
-    fexpskin.clear();
-    fnucleoninexsec.clear();
-    fnucleonqexsec.clear();
-    fnucleontotxsec.clear();
-  }
-
-  if (RecoDebug_fill){ 
-    fSeedVtxX.clear();
-    fSeedVtxY.clear();
-    fSeedVtxZ.clear();
-    fSeedVtxFOM.clear();
-    fSeedVtxTime = -9999;
-    fPointPosX = -9999;
-    fPointPosY = -9999;
-    fPointPosZ = -9999;
-    fPointPosTime = -9999;
-    fPointPosFOM = -9999;
-    fPointPosStatus = -9999;
-    fPointDirX = -9999;
-    fPointDirY = -9999;
-    fPointDirZ = -9999;
-    fPointDirTime = -9999;
-    fPointDirFOM = -9999;
-    fPointDirStatus = -9999;
-    fPointVtxPosX = -9999;
-    fPointVtxPosY = -9999;
-    fPointVtxPosZ = -9999;
-    fPointVtxDirX = -9999;
-    fPointVtxDirY = -9999;
-    fPointVtxDirZ = -9999;
-    fPointVtxTime = -9999;
-    fPointVtxStatus = -9999;
-    fPointVtxFOM = -9999;
-  }
+  //DIGITS
+  s.Vector("Digit_fill",kTrig,"digitX",&fdigitX);
+  s.Vector("Digit_fill",kTrig,"digitY",&fdigitY);
+  s.Vector("Digit_fill",kTrig,"digitZ",&fdigitZ);
+  s.Vector("Digit_fill",kTrig,"digitT",&fdigitT);
+  s.Scalar("Digit_fill",kTrig,"NDigitsPMTs",&fNDigitsPMTs,'I',-9999);
+  s.Scalar("Digit_fill",kTrig,"NDigitsLAPPDs",&fNDigitsLAPPDs,'I',-9999);
+
+  //SiPM Pulse Info
+  s.Vector("SiPMPulseInfo_fill",kTank|kTrig,"SiPMhitQ",&fSiPMHitQ);
+  s.Vector("SiPMPulseInfo_fill",kTank|kTrig,"SiPMhitT",&fSiPMHitT);
+  s.Vector("SiPMPulseInfo_fill",kTank|kTrig,"SiPMhitAmplitude",&fSiPMHitAmplitude);
+  s.Vector("SiPMPulseInfo_fill",kTank|kTrig,"SiPMNum",&fSiPMNum);
+  s.Scalar("SiPMPulseInfo_fill",kTank|kTrig,"SiPM1NPulses",&fSiPM1NPulses,'I',-9999);
+  s.Scalar("SiPMPulseInfo_fill",kTank|kTrig,"SiPM2NPulses",&fSiPM2NPulses,'I',-9999);
+
+  //Hit information (PMT and LAPPD)
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"filter",&fIsFiltered);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitX",&fHitX);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitY",&fHitY);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitZ",&fHitZ);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitT",&fHitT);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitQ",&fHitQ);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitPE",&fHitPE);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitType",&fHitType);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitDetID",&fHitDetID);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitChankey",&fHitChankey);
+  s.Vector("TankHitInfo_fill",kTank|kTrig,"hitChankeyMC",&fHitChankeyMC);
+
+  //MRD and FMV hits
+  s.Vector("MRDHitInfo_fill",kMRD|kTrig,"MRDhitT",&fMRDHitT);
+  s.Vector("MRDHitInfo_fill",kMRD|kTrig,"MRDhitDetID",&fMRDHitDetID);
+  s.Vector("MRDHitInfo_fill",kMRD|kTrig,"MRDhitChankey",&fMRDHitChankey);
+  s.Vector("MRDHitInfo_fill",kMRD|kTrig,"MRDhitChankeyMC",&fMRDHitChankeyMC);
+  s.Vector("MRDHitInfo_fill",kMRD|kTrig,"FMVhitT",&fFMVHitT);
+  s.Vector("MRDHitInfo_fill",kMRD|kTrig,"FMVhitDetID",&fFMVHitDetID);
+  s.Vector("MRDHitInfo_fill",kMRD|kTrig,"FMVhitChankey",&fFMVHitChankey);
+  s.Vector("MRDHitInfo_fill",kMRD|kTrig,"FMVhitChankeyMC",&fFMVHitChankeyMC);
+  s.Scalar("MRDHitInfo_fill",kMRD|kTrig,"vetoHit",&fVetoHit,'I',-9999);
+
+  //MRD tracks
+  s.Scalar("MRDReco_fill",kMRD,"numClusterTracks",&fNumClusterTracks,'I');
+  s.Scalar("MRDReco_fill",kTrig,"numMRDTracks",&fNumClusterTracks,'I');
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackAngle",&fMRDTrackAngle);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackAngleError",&fMRDTrackAngleError);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDPenetrationDepth",&fMRDPenetrationDepth);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackLength",&fMRDTrackLength);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDEntryPointRadius",&fMRDEntryPointRadius);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDEnergyLoss",&fMRDEnergyLoss);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDEnergyLossError",&fMRDEnergyLossError);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackStartX",&fMRDTrackStartX);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackStartY",&fMRDTrackStartY);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackStartZ",&fMRDTrackStartZ);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackStopX",&fMRDTrackStopX);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackStopY",&fMRDTrackStopY);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDTrackStopZ",&fMRDTrackStopZ);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDSide",&fMRDSide);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDStop",&fMRDStop);
+  s.Vector("MRDReco_fill",kMRD|kTrig,"MRDThrough",&fMRDThrough);
+
+  //Reconstructed variables after full Muon Reco Analysis
+  s.Scalar("TankReco_fill",kTrig,"recoVtxX",&fRecoVtxX,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoVtxY",&fRecoVtxY,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoVtxZ",&fRecoVtxZ,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoVtxTime",&fRecoVtxTime,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoDirX",&fRecoDirX,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoDirY",&fRecoDirY,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoDirZ",&fRecoDirZ,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoAngle",&fRecoAngle,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoPhi",&fRecoPhi,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoVtxFOM",&fRecoVtxFOM,'D',-9999);
+  s.Scalar("TankReco_fill",kTrig,"recoStatus",&fRecoStatus,'I',-9999);
+
+  //Michael's Simple Reconstruction
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoFlag",&fSimpleFlag,'I',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoEnergy",&fSimpleEnergy,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoVtxX",&fSimpleVtxX,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoVtxY",&fSimpleVtxY,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoVtxZ",&fSimpleVtxZ,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoStopVtxX",&fSimpleStopVtxX,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoStopVtxY",&fSimpleStopVtxY,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoStopVtxZ",&fSimpleStopVtxZ,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoCosTheta",&fSimpleCosTheta,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoPt",&fSimplePt,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoFV",&fSimpleFV,'I',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoMrdEnergyLoss",&fSimpleMrdEnergyLoss,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoTrackLengthInMRD",&fSimpleTrackLengthInMRD,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoMRDStartX",&fSimpleMRDStartX,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoMRDStartY",&fSimpleMRDStartY,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoMRDStartZ",&fSimpleMRDStartZ,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoMRDStopX",&fSimpleMRDStopX,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoMRDStopY",&fSimpleMRDStopY,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoMRDStopZ",&fSimpleMRDStopZ,'D',-9999);
+  s.Scalar("SimpleReco_fill",kTrig,"simpleRecoTrackLengthInTank",&fSimpleTrackLengthInTank,'D',-9999);
+
+  //Ring Counting
+  s.Scalar("RingCounting_fill",kTrig,"RCSRPred",&fRCSRPred,'D',-9999);
+  s.Scalar("RingCounting_fill",kTrig,"RCMRPred",&fRCMRPred,'D',-9999);
+
+  //MC truth information for muons
+  s.Scalar("MCTruth_fill",kTrig,"triggerNumber",&fiMCTriggerNum,'I');
+  s.Scalar("MCTruth_fill",kTrig,"mcEntryNumber",&fMCEventNum,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueVtxX",&fTrueVtxX,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueVtxY",&fTrueVtxY,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueVtxZ",&fTrueVtxZ,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueVtxTime",&fTrueVtxTime,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueDirX",&fTrueDirX,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueDirY",&fTrueDirY,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueDirZ",&fTrueDirZ,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueAngle",&fTrueAngle,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"truePhi",&fTruePhi,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueMuonEnergy",&fTrueMuonEnergy,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"truePrimaryPdg",&fTruePrimaryPdg,'I');
+  s.Scalar("MCTruth_fill",kTrig,"trueTrackLengthInWater",&fTrueTrackLengthInWater,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueTrackLengthInMRD",&fTrueTrackLengthInMRD,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueMultiRing",&fTrueMultiRing,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"Pi0Count",&fPi0Count,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"PiPlusCount",&fPiPlusCount,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"PiMinusCount",&fPiMinusCount,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"K0Count",&fK0Count,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"KPlusCount",&fKPlusCount,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"KMinusCount",&fKMinusCount,'I',-9999);
+  s.Vector("MCTruth_fill",kTrig,"truePrimaryPdgs",&fTruePrimaryPdgs);
+  s.Vector("MCTruth_fill",kTrig,"trueNeutCapVtxX",&fTrueNeutCapVtxX);
+  s.Vector("MCTruth_fill",kTrig,"trueNeutCapVtxY",&fTrueNeutCapVtxY);
+  s.Vector("MCTruth_fill",kTrig,"trueNeutCapVtxZ",&fTrueNeutCapVtxZ);
+  s.Vector("MCTruth_fill",kTrig,"trueNeutCapNucleus",&fTrueNeutCapNucleus);
+  s.Vector("MCTruth_fill",kTrig,"trueNeutCapTime",&fTrueNeutCapTime);
+  s.Vector("MCTruth_fill",kTrig,"trueNeutCapGammas",&fTrueNeutCapGammas);
+  s.Vector("MCTruth_fill",kTrig,"trueNeutCapE",&fTrueNeutCapE);
+  s.Vector("MCTruth_fill",kTrig,"trueNeutCapGammaE",&fTrueNeutCapGammaE);
+  s.Scalar("MCTruth_fill",kTrig,"trueNeutrinoEnergy",&fTrueNeutrinoEnergy,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNeutrinoMomentum_X",&fTrueNeutrinoMomentum_X,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNeutrinoMomentum_Y",&fTrueNeutrinoMomentum_Y,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNeutrinoMomentum_Z",&fTrueNeutrinoMomentum_Z,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNuIntxVtx_X",&fTrueNuIntxVtx_X,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNuIntxVtx_Y",&fTrueNuIntxVtx_Y,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNuIntxVtx_Z",&fTrueNuIntxVtx_Z,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNuIntxVtx_T",&fTrueNuIntxVtx_T,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLVtx_X",&fTrueFSLVtx_X,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLVtx_Y",&fTrueFSLVtx_Y,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLVtx_Z",&fTrueFSLVtx_Z,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLMomentum_X",&fTrueFSLMomentum_X,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLMomentum_Y",&fTrueFSLMomentum_Y,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLMomentum_Z",&fTrueFSLMomentum_Z,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLTime",&fTrueFSLTime,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLMass",&fTrueFSLMass,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLPdg",&fTrueFSLPdg,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueFSLEnergy",&fTrueFSLEnergy,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueQ2",&fTrueQ2,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueCC",&fTrueCC,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNC",&fTrueNC,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueQEL",&fTrueQEL,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueRES",&fTrueRES,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueDIS",&fTrueDIS,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueCOH",&fTrueCOH,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueMEC",&fTrueMEC,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueNeutrons",&fTrueNeutrons,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueProtons",&fTrueProtons,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"truePi0",&fTruePi0,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"truePiPlus",&fTruePiPlus,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"truePiPlusCher",&fTruePiPlusCher,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"truePiMinus",&fTruePiMinus,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"truePiMinusCher",&fTruePiMinusCher,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueKPlus",&fTrueKPlus,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueKPlusCher",&fTrueKPlusCher,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueKMinus",&fTrueKMinus,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueKMinusCher",&fTrueKMinusCher,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueBJx",&fTrueBJx,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"truey",&fTruey,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueq0",&fTrueq0,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueq3",&fTrueq3,'D',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueTargetZ",&fTrueTarget,'I',-9999);
+  s.Scalar("MCTruth_fill",kTrig,"trueW2",&fTrueW2,'D',-9999);
+
+  //Flux and cross section weights
+  s.Object("Reweight_fill",kTrig,"XSecWeights",&fxsec_weights);
+  s.Object("Reweight_fill",kTrig,"FluxWeights",&fflux_weights);
+  s.Vector("Reweight_fill",kTrig,"weight_All_UBGenie",&fAll);
+  s.Vector("Reweight_fill",kTrig,"weight_AxFFCCQEshape_UBGenie",&fAxFFCCQEshape);
+  s.Vector("Reweight_fill",kTrig,"weight_DecayAngMEC_UBGenie",&fDecayAngMEC);
+  s.Vector("Reweight_fill",kTrig,"weight_NormCCCOH_UBGenie",&fNormCCCOH);
+  s.Vector("Reweight_fill",kTrig,"weight_Norm_NCCOH_UBGenie",&fNorm_NCCOH);
+  s.Vector("Reweight_fill",kTrig,"weight_RPA_CCQE_UBGenie",&fRPA_CCQE);
+  s.Vector("Reweight_fill",kTrig,"weight_RootinoFix_UBGenie",&fRootinoFix);
+  s.Vector("Reweight_fill",kTrig,"weight_ThetaDelta2NRad_UBGenie",&fThetaDelta2NRad);
+  s.Vector("Reweight_fill",kTrig,"weight_Theta_Delta2Npi_UBGenie",&fTheta_Delta2Npi);
+  s.Vector("Reweight_fill",kTrig,"weight_TunedCentralValue_UBGenie",&fTunedCentralValue);
+  s.Vector("Reweight_fill",kTrig,"weight_VecFFCCQEshape_UBGenie",&fVecFFCCQEshape);
+  s.Vector("Reweight_fill",kTrig,"weight_XSecShape_CCMEC_UBGenie",&fXSecShape_CCMEC);
+  s.Vector("Reweight_fill",kTrig,"weight_horncurrent_FluxUnisim",&fhorncurrent);
+  s.Vector("Reweight_fill",kTrig,"weight_expskin_FluxUnisim",&fexpskin);
+  s.Vector("Reweight_fill",kTrig,"weight_piplus_PrimaryHadronSWCentralSplineVariation",&fpiplus);
+  s.Vector("Reweight_fill",kTrig,"weight_piminus_PrimaryHadronSWCentralSplineVariation",&fpiminus);
+  s.Vector("Reweight_fill",kTrig,"weight_kplus_PrimaryHadronFeynmanScaling",&fkplus);
+  s.Vector("Reweight_fill",kTrig,"weight_kzero_PrimaryHadronSanfordWang",&fkzero);
+  s.Vector("Reweight_fill",kTrig,"weight_kminus_PrimaryHadronNormalization",&fkminus);
+  s.Vector("Reweight_fill",kTrig,"weight_pioninexsec_FluxUnisim",&fpioninexsec);
+  s.Vector("Reweight_fill",kTrig,"weight_pionqexsec_FluxUnisim",&fpionqexsec);
+  s.Vector("Reweight_fill",kTrig,"weight_piontotxsec_FluxUnisim",&fpiontotxsec);
+  s.Vector("Reweight_fill",kTrig,"weight_nucleoninexsec_FluxUnisim",&fnucleoninexsec);
+  s.Vector("Reweight_fill",kTrig,"weight_nucleonqexsec_FluxUnisim",&fnucleonqexsec);
+  s.Vector("Reweight_fill",kTrig,"weight_nucleontotxsec_FluxUnisim",&fnucleontotxsec);
+
+  //MuonFitter reco track length, vtx, energy
+  s.Scalar("MuonFitter_fill",kTank|kTrig,"recoMuonVtxX",&fRecoMuonVtxX,'D',-9999);
+  s.Scalar("MuonFitter_fill",kTank|kTrig,"recoMuonVtxY",&fRecoMuonVtxY,'D',-9999);
+  s.Scalar("MuonFitter_fill",kTank|kTrig,"recoMuonVtxZ",&fRecoMuonVtxZ,'D',-9999);
+  s.Scalar("MuonFitter_fill",kTank|kTrig,"recoTankTrack",&fRecoTankTrack,'D',-9999);
+  s.Scalar("MuonFitter_fill",kTank|kTrig,"recoMuonKE",&fRecoMuonKE,'D',-9999);
+  s.Scalar("MuonFitter_fill",kTrig,"numMrdLayers",&fNumMrdLayers,'I',-9999);
+
+  // MC BNB spill structure timing - AssignBunchTimingMC tool
+  s.Scalar("HasBNBtimingMC",kTank,"bunchTimes",&fbunchTimes,'D',-9999);
+
+  // Reconstructed variables from each step in Muon Reco Analysis
+  s.Vector("RecoDebug_fill",kTrig,"seedVtxX",&fSeedVtxX);
+  s.Vector("RecoDebug_fill",kTrig,"seedVtxY",&fSeedVtxY);
+  s.Vector("RecoDebug_fill",kTrig,"seedVtxZ",&fSeedVtxZ);
+  s.Vector("RecoDebug_fill",kTrig,"seedVtxFOM",&fSeedVtxFOM);
+  s.Scalar("RecoDebug_fill",kTrig,"seedVtxTime",&fSeedVtxTime,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointPosX",&fPointPosX,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointPosY",&fPointPosY,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointPosZ",&fPointPosZ,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointPosTime",&fPointPosTime,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointPosFOM",&fPointPosFOM,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointPosStatus",&fPointPosStatus,'I',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointDirX",&fPointDirX,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointDirY",&fPointDirY,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointDirZ",&fPointDirZ,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointDirTime",&fPointDirTime,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointDirStatus",&fPointDirStatus,'I',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointDirFOM",&fPointDirFOM,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxPosX",&fPointVtxPosX,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxPosY",&fPointVtxPosY,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxPosZ",&fPointVtxPosZ,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxTime",&fPointVtxTime,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxDirX",&fPointVtxDirX,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxDirY",&fPointVtxDirY,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxDirZ",&fPointVtxDirZ,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxFOM",&fPointVtxFOM,'D',-9999);
+  s.Scalar("RecoDebug_fill",kTrig,"pointVtxStatus",&fPointVtxStatus,'I',-9999);
+
+  // Difference in MC Truth and Muon Reconstruction Analysis
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaVtxX",&fDeltaVtxX,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaVtxY",&fDeltaVtxY,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaVtxZ",&fDeltaVtxZ,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaVtxR",&fDeltaVtxR,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaVtxT",&fDeltaVtxT,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaParallel",&fDeltaParallel,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaPerpendicular",&fDeltaPerpendicular,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaAzimuth",&fDeltaAzimuth,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaZenith",&fDeltaZenith,'D',-9999);
+  s.Scalar("muonTruthRecoDiff_fill",kTrig,"deltaAngle",&fDeltaAngle,'D',-9999);
+}
 
-  if(TankReco_fill){
-    fRecoVtxX = -9999;
-    fRecoVtxY = -9999;
-    fRecoVtxZ = -9999;
-    fRecoStatus = -9999;
-    fRecoVtxTime = -9999;
-    fRecoVtxFOM = -9999;
-    fRecoDirX = -9999;
-    fRecoDirY = -9999;
-    fRecoDirZ = -9999;
-    fRecoAngle = -9999;
-    fRecoPhi = -9999;
-  }
+void PhaseIITreeMaker::ResetVariables() {
+  // tree variables, as given in DeclareBranches
+  branch_schema.Reset();
 
-  if(MRDClusterProcessing){
-    fMRDClusterNumber = -9999;
-    fMRDClusterTime = -9999;
-    fMRDClusterTimeSigma = -9999;
-    fMRDClusterHits = -9999;
-  }
-  if(MRDHitInfo_fill){
-    fMRDHitT.clear();
-    fMRDHitDetID.clear();
-    fMRDHitChankey.clear();
-    fMRDHitChankeyMC.clear();
-    fFMVHitT.clear();
-    fFMVHitDetID.clear();
-    fFMVHitChankey.clear();
-    fFMVHitChankeyMC.clear();
-  }
-  if(MRDReco_fill){
-    fMRDTrackAngle.clear();
-    fMRDTrackAngleError.clear();
-    fMRDPenetrationDepth.clear();
-    fMRDTrackLength.clear();
-    fMRDEntryPointRadius.clear();
-    fMRDEnergyLoss.clear();
-    fMRDEnergyLossError.clear();
-    fMRDTrackStartX.clear();
-    fMRDTrackStartY.clear();
-    fMRDTrackStartZ.clear();
-    fMRDTrackStopX.clear();
-    fMRDTrackStopY.clear();
-    fMRDTrackStopZ.clear();
-    fMRDSide.clear();
-    fMRDStop.clear();
-    fMRDThrough.clear();
-  }
-  if(SimpleReco_fill){
-    fSimpleFlag = -9999;
-    fSimpleEnergy = -9999;
-    fSimpleVtxX = -9999;
-    fSimpleVtxY = -9999;
-    fSimpleVtxZ = -9999;
-    fSimpleStopVtxX = -9999;
-    fSimpleStopVtxY = -9999;
-    fSimpleStopVtxZ = -9999;
-    fSimpleCosTheta = -9999;
-    fSimplePt = -9999;
-    fSimpleFV = -9999;
-    fSimpleMrdEnergyLoss = -9999;
-    fSimpleTrackLengthInMRD = -9999;
-    fSimpleTrackLengthInTank = -9999;
-    fSimpleMRDStartX = -9999;
-    fSimpleMRDStartY = -9999;
-    fSimpleMRDStartZ = -9999;
-    fSimpleMRDStopX = -9999;
-    fSimpleMRDStopY = -9999;
-    fSimpleMRDStopZ = -9999;
-  }
-  if(RingCounting_fill){
-    fRCSRPred = -9999;
-    fRCMRPred = -9999;
-  }
-  if(TankHitInfo_fill){
-    fIsFiltered.clear();
-    fHitX.clear();
-    fHitY.clear();
-    fHitZ.clear();
-    fHitT.clear();
-    fHitQ.clear();
-    fHitPE.clear();
-    fHitType.clear();
-    fHitDetID.clear();
-    fHitChankey.clear();
-    fHitChankeyMC.clear();
-  }
-  
-  if (muonTruthRecoDiff_fill){ 
-    fDeltaVtxX = -9999;
-    fDeltaVtxY = -9999;
-    fDeltaVtxZ = -9999;
-    fDeltaVtxR = -9999;
-    fDeltaVtxT = -9999;
-    fDeltaParallel = -9999;
-    fDeltaPerpendicular = -9999;
-    fDeltaAzimuth = -9999;
-    fDeltaZenith = -9999;
-    fDeltaAngle = -9999;
-  }
-  
-  //DIGITS
-  if (Digit_fill){
-    fdigitX.clear();
-    fdigitY.clear();
-    fdigitZ.clear();
-    fdigitT.clear();
-    }
-   //DIGITS 
-
-  if (MuonFitter_fill)
-  {
-    fRecoMuonVtxX = -9999;
-    fRecoMuonVtxY = -9999;
-    fRecoMuonVtxZ = -9999;
-    fRecoTankTrack = -9999;
-    fRecoMuonKE = -9999;
-    fNumMrdLayers = -9999;
-  }  
+  if(MCTruth_fill) fMCTriggerNum = -9999;
 }
 
 bool PhaseIITreeMaker::LoadTankClusterClassifiers(double cluster_time){
@@ -4,6 +4,8 @@
 #include <string>
 #include <iostream>
 
+#include <boost/tokenizer.hpp>
+
 #include "Tool.h"
 // ROOT includes
 #include "TApplication.h"
@@ -11,6 +13,7 @@
 #include <Math/LorentzVector.h>
 #include "TFile.h"
 #include "TTree.h"
+#include "TROOT.h"
 #include "TH1D.h"
 #include "TMath.h"
 #include "ADCPulse.h"
@@ -46,6 +49,8 @@
 #include "TVector3.h"
 #include "TLorentzVector.h"
 
+#include "BranchSchema.h"
+
 class PhaseIITreeMaker: public Tool {
 
 
@@ -98,8 +103,14 @@ class PhaseIITreeMaker: public Tool {
   std::map<unsigned long, int> channelkey_to_faccpmtid;
   std::map<int, unsigned long> faccpmtid_to_channelkey_data;
 
+  /// \brief Declares every branch of the three trees in branch_schema
+  void DeclareBranches();
+
   /// \brief Reset all variables. 
   void ResetVariables();	
+
+  phaseiitree::Schema branch_schema;
+  phaseiitree::WriteSettings write_settings;
  	
   /// \brief ROOT TFile that will be used to store the output from this tool
   TFile* fOutput_tfile = nullptr;
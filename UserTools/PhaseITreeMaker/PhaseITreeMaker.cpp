@@ -9,6 +9,7 @@
 #include "HeftyInfo.h"
 //#include "MinibufferLabel.h"
 #include "PhaseITreeMaker.h"
+#include "ToolRegistry.h"
 #include "TimeClass.h"
 
 constexpr int UNKNOWN_NCV_POSITION = 0;
@@ -43,6 +44,8 @@ int PhaseITreeMaker::get_NCV_position(uint32_t run_number) const {
   else return UNKNOWN_NCV_POSITION;
 }
 
+REGISTER_TOOL(PhaseITreeMaker);
+
 PhaseITreeMaker::PhaseITreeMaker() : Tool() {}
 
 bool PhaseITreeMaker::Initialise(std::string config_filename, DataModel& data)
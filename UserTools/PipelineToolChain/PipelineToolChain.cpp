@@ -0,0 +1,500 @@
+#include "PipelineToolChain.h"
+#include "ToolRegistry.h"
+
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <algorithm>
+
+#include "TROOT.h"
+
+#include "Factory.h"
+#include "ANNIEEventKeys.h"
+
+REGISTER_TOOL(PipelineToolChain);
+
+PipelineToolChain::PipelineToolChain():Tool(){}
+
+
+bool PipelineToolChain::Initialise(std::string configfile, DataModel &data){
+
+  /////////////////// Useful header ///////////////////////
+  if(configfile!="") m_variables.Initialise(configfile); // loading config file
+  //m_variables.Print();
+
+  m_data= &data; //assigning transient data pointer
+  /////////////////////////////////////////////////////////////////
+
+  m_variables.Get("verbosity",verbosity);
+  std::string toolsfile;
+  if(!m_variables.Get("ToolsFile",toolsfile)){
+    Log("PipelineToolChain Tool: No ToolsFile given!",v_error,verbosity);
+    return false;
+  }
+  int use_pipeline = 0;
+  m_variables.Get("Pipelined",use_pipeline);
+  m_variables.Get("MaxEventsInFlight",max_events_in_flight);
+  if(max_events_in_flight<1) max_events_in_flight = 1;
+  execute_failures = 0;
+
+  int profile = 0;
+  m_variables.Get("Profile",profile);
+  if(profile){
+    profiler = new ToolProfiler();
+    m_variables.Get("ProfileJSONFile",profile_json_file);
+    std::string tracefile;
+    if(m_variables.Get("ProfileTraceFile",tracefile) && !profiler->OpenTrace(tracefile)){
+      Log("PipelineToolChain Tool: Could not open ProfileTraceFile "+tracefile,v_warning,verbosity);
+    }
+  }
+
+  if(!LoadTools(toolsfile,data)) return false;
+
+  if(use_pipeline) BuildStages();
+  if(use_pipeline && !pipelined){
+    Log("PipelineToolChain Tool: No tool can be pipelined, running the sub-chain serially",v_warning,verbosity);
+  }
+
+  return true;
+}
+
+
+bool PipelineToolChain::Execute(){
+
+  if(pipelined){
+    // the first call runs every event through the pipeline
+    if(pipeline_done) return true;
+    pipeline_done = true;
+    return RunPipeline();
+  }
+
+  bool ok = true;
+  for(size_t itool=0; itool<chain_tools.size(); ++itool){
+    ChainTool& chaintool = chain_tools.at(itool);
+    ToolProfiler::Call call(profiler,itool,ToolProfiler::kExecute);
+    if(!chaintool.tool->Execute()){
+      Log("PipelineToolChain Tool: "+chaintool.name+" failed in Execute",v_error,verbosity);
+      ok = false;
+    }
+  }
+  ++events_read;
+  return ok;
+}
+
+
+bool PipelineToolChain::Finalise(){
+
+  bool ok = true;
+  for(size_t itool=0; itool<chain_tools.size(); ++itool){
+    ChainTool& chaintool = chain_tools.at(itool);
+    {
+      ToolProfiler::Call call(profiler,itool,ToolProfiler::kFinalise);
+      if(!chaintool.tool->Finalise()){
+        Log("PipelineToolChain Tool: "+chaintool.name+" failed in Finalise",v_error,verbosity);
+        ok = false;
+      }
+    }
+    delete chaintool.tool;
+    chaintool.tool = nullptr;
+  }
+  chain_tools.clear();
+  stages.clear();
+
+  if(profiler){
+    // the summary is printed whenever profiling was asked for
+    Log("PipelineToolChain Tool: Profile of "+std::to_string(events_read)+" events:\n"+profiler->Table(),v_error,verbosity);
+    if(profile_json_file!="" && !profiler->WriteJSON(profile_json_file)){
+      Log("PipelineToolChain Tool: Could not write ProfileJSONFile "+profile_json_file,v_warning,verbosity);
+    }
+    delete profiler;
+    profiler = nullptr;
+  }
+
+  if(execute_failures>0){
+    Log("PipelineToolChain Tool: "+std::to_string(execute_failures.load())+" tool Execute calls failed",v_warning,verbosity);
+  }
+
+  return ok;
+}
+
+
+bool PipelineToolChain::LoadTools(std::string toolsfile, DataModel& data){
+
+  std::ifstream file(toolsfile);
+  if(!file.is_open()){
+    Log("PipelineToolChain Tool: Could not open ToolsFile "+toolsfile,v_error,verbosity);
+    return false;
+  }
+
+  // same format as a ToolChain's ToolsConfig: name ToolClass configfile
+  std::string line;
+  while(getline(file,line)){
+    if(line.find('#')!=std::string::npos) line.erase(line.find('#'));
+    std::stringstream ss(line);
+    std::string name, classname, toolconfig;
+    ss >> name >> classname >> toolconfig;
+    if(classname=="") continue;
+
+    ChainTool chaintool;
+    chaintool.name = name;
+    if(profiler) profiler->AddTool(name);
+    chaintool.tool = Factory(classname);
+    if(chaintool.tool==nullptr){
+      Log("PipelineToolChain Tool: Could not create tool "+name+" of type "+classname,v_error,verbosity);
+      return false;
+    }
+    ReadDeclarations(toolconfig,chaintool);
+    chain_tools.push_back(chaintool);
+
+    Log("PipelineToolChain Tool: Initialising "+name,v_message,verbosity);
+    ToolProfiler::Call call(profiler,chain_tools.size()-1,ToolProfiler::kInitialise);
+    if(!chaintool.tool->Initialise(toolconfig,data)){
+      Log("PipelineToolChain Tool: "+name+" failed to initialise",v_error,verbosity);
+      return false;
+    }
+  }
+
+  if(chain_tools.empty()){
+    Log("PipelineToolChain Tool: No tools in ToolsFile "+toolsfile,v_error,verbosity);
+    return false;
+  }
+  return true;
+}
+
+
+void PipelineToolChain::ReadDeclarations(std::string toolconfig, ChainTool& chaintool){
+
+  Store config;
+  if(toolconfig!="") config.Initialise(toolconfig);
+
+  // comma separated lists of Store:key, e.g. ANNIEEvent:Hits,CStore:ClusterMap.
+  // PipelineRunConstants lists the values in other stores that are set up in
+  // Initialise and stay the same for the whole run, e.g. CStore:ChannelNumToTankPMTSPEChargeMap
+  std::string lists[3];
+  const char* names[3] = {"PipelineReads","PipelineWrites","PipelineRunConstants"};
+  chaintool.declared = false;
+  for(int ilist=0; ilist<3; ++ilist){
+    if(config.Get(names[ilist],lists[ilist])) chaintool.declared = true;
+  }
+  if(!chaintool.declared) return;
+
+  chaintool.pipelinable = true;
+  for(int ilist=0; ilist<3; ++ilist){
+    std::stringstream ss(lists[ilist]);
+    std::string entry;
+    while(getline(ss,entry,',')){
+      if(entry=="") continue;
+      std::string store = entry, key = "*";
+      size_t colon = entry.find(':');
+      if(colon!=std::string::npos){
+        store = entry.substr(0,colon);
+        key = entry.substr(colon+1);
+      }
+      if(store=="ANNIEEvent"){
+        if(ilist==1) chaintool.event_writes.insert(key);
+        else chaintool.event_reads.insert(key);
+      } else if(ilist!=2){
+        // other stores are shared by all events in flight: while a pipelined
+        // stage works on one event the head already sets the next event's
+        // values there (e.g. the ClusterMap in the CStore)
+        chaintool.pipelinable = false;
+      }
+    }
+  }
+
+  if(!chaintool.pipelinable){
+    Log("PipelineToolChain Tool: "+chaintool.name+" reads per-event values from or writes to a store other than"
+        " the ANNIEEvent, it will run serially",v_message,verbosity);
+  }
+}
+
+
+void PipelineToolChain::BuildStages(){
+
+  stages.clear();
+  pipelined = false;
+
+  // the first tool produces the events, so it and everything up to the first
+  // pipelinable tool run serially on the real ANNIEEvent
+  Stage head;
+  size_t itool = 0;
+  do {
+    head.tools.push_back(itool);
+    ++itool;
+  } while(itool<chain_tools.size() && !chain_tools.at(itool).pipelinable);
+  stages.push_back(std::move(head));
+
+  // after the head each pipelinable tool is a stage of its own,
+  // and each run of other tools is a serial stage
+  std::set<std::string> written;
+  std::set<std::string> needed;
+  bool need_all = false;
+  for(; itool<chain_tools.size(); ++itool){
+    ChainTool& chaintool = chain_tools.at(itool);
+    if(chaintool.pipelinable){
+      Stage stage;
+      stage.tools.push_back(itool);
+      stage.serial = false;
+      stages.push_back(std::move(stage));
+      pipelined = true;
+      for(const std::string& key : chaintool.event_reads){
+        if(key=="*") need_all = true;
+        else if(!written.count(key)) needed.insert(key);
+      }
+      written.insert(chaintool.event_writes.begin(),chaintool.event_writes.end());
+    } else {
+      // tools that did not declare what they read may need anything
+      if(!chaintool.declared) need_all = true;
+      else for(const std::string& key : chaintool.event_reads){
+        if(key=="*") need_all = true;
+        else if(!written.count(key)) needed.insert(key);
+      }
+      if(stages.back().serial && stages.size()>1) stages.back().tools.push_back(itool);
+      else {
+        Stage stage;
+        stage.tools.push_back(itool);
+        stages.push_back(std::move(stage));
+      }
+    }
+  }
+
+  if(!pipelined){
+    stages.clear();
+    return;
+  }
+
+  // the serial tools may use per-event values the head leaves in other
+  // stores (e.g. the ClusterMap in the CStore), so the head waits for each
+  // event to pass the last of them before it reads the next one
+  last_serial_stage = 0;
+  for(size_t istage=1; istage<stages.size(); ++istage){
+    if(stages.at(istage).serial) last_serial_stage = istage;
+  }
+
+  // each event in flight gets a copy of the keys the later stages read. Only
+  // keys whose type is known to annieeventkeys::CopyKey can be copied
+  copy_keys.clear();
+  if(need_all){
+    copy_keys = annieeventkeys::KnownKeys();
+  } else {
+    for(const std::string& key : needed){
+      if(!annieeventkeys::IsKnownKey(key)){
+        Log("PipelineToolChain Tool: ANNIEEvent key "+key+" is read after the first pipelined tool"
+            " but can not be copied between events (see DataModel/ANNIEEventKeys.cpp);"
+            " running the sub-chain serially",v_warning,verbosity);
+        stages.clear();
+        pipelined = false;
+        return;
+      }
+      copy_keys.push_back(key);
+    }
+  }
+
+  if(verbosity>=v_message){
+    std::stringstream ss;
+    ss << "PipelineToolChain Tool: Running " << stages.size() << " stages:";
+    for(const Stage& stage : stages){
+      ss << " [";
+      for(size_t i=0; i<stage.tools.size(); ++i) ss << (i ? " " : "") << chain_tools.at(stage.tools.at(i)).name;
+      ss << (stage.serial ? "]" : "]*");
+    }
+    Log(ss.str(),v_message,verbosity);
+  }
+}
+
+
+bool PipelineToolChain::RunTools(const Stage& stage){
+
+  bool ok = true;
+  for(size_t itool : stage.tools){
+    ChainTool& chaintool = chain_tools.at(itool);
+    ToolProfiler::Call call(profiler,itool,ToolProfiler::kExecute);
+    if(!chaintool.tool->Execute()){
+      Log("PipelineToolChain Tool: "+chaintool.name+" failed in Execute",v_error,verbosity);
+      ++execute_failures;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+
+PipelineToolChain::PipelineEvent PipelineToolChain::NewEvent(){
+
+  // called on the calling thread, where the ANNIEEvent is the real one
+  BoostStore* annie_event = m_data->Stores.at("ANNIEEvent");
+  bool mc_flag = annieeventkeys::IsMC(annie_event);
+  PipelineEvent event;
+  event.store = new BoostStore(false,BOOST_STORE_BINARY_FORMAT);
+  for(const std::string& key : copy_keys){
+    if(annie_event->Has(key)) annieeventkeys::CopyKey(annie_event,event.store,key,mc_flag);
+  }
+  // the header holds per-run information (geometry, ...), share it rather than copy it
+  event.own_header = event.store->Header;
+  event.store->Header = annie_event->Header;
+  return event;
+}
+
+
+void PipelineToolChain::ShareHeader(){
+
+  // a serial tool may have replaced the ANNIEEvent (LoadANNIEEvent does so
+  // for every new file) and deleted the Header the events in flight share
+  BoostStore* header = m_data->Stores.at("ANNIEEvent")->Header;
+  std::lock_guard<std::mutex> lock(pipeline_mutex);
+  for(BoostStore* store : live_events) store->Header = header;
+}
+
+
+void PipelineToolChain::DeleteEvent(PipelineEvent& event){
+
+  live_events.erase(std::find(live_events.begin(),live_events.end(),event.store));
+  event.store->Header = event.own_header;
+  delete event.store;
+  event.store = nullptr;
+}
+
+
+void PipelineToolChain::ForwardEvent(size_t istage, PipelineEvent event){
+
+  if(istage==last_serial_stage && last_serial_stage>0) --events_before_serial_end;
+  if(istage+1<stages.size()){
+    stages.at(istage+1).input.push_back(event);
+  } else {
+    DeleteEvent(event);
+    --events_in_flight;
+  }
+}
+
+
+void PipelineToolChain::RunStage(size_t istage){
+
+  Stage& stage = stages.at(istage);
+  while(true){
+    PipelineEvent event;
+    {
+      std::unique_lock<std::mutex> lock(pipeline_mutex);
+      pipeline_cv.wait(lock,[&]{ return stopping || !stage.input.empty(); });
+      if(stage.input.empty()) return;
+      event = stage.input.front();
+      stage.input.pop_front();
+    }
+
+    {
+      std::shared_lock<std::shared_timed_mutex> tools_lock(tools_mutex);
+      m_data->Stores.BindThreadStore("ANNIEEvent",event.store);
+      RunTools(stage);
+      m_data->Stores.UnbindThreadStore("ANNIEEvent");
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(pipeline_mutex);
+      ForwardEvent(istage,event);
+    }
+    pipeline_cv.notify_all();
+  }
+}
+
+
+bool PipelineToolChain::RunPipeline(){
+
+  // the tools on the stage threads may use ROOT (histograms, fits, ...)
+  ROOT::EnableThreadSafety();
+
+  int failures_before = execute_failures;
+  stopping = false;
+  events_in_flight = 0;
+  events_before_serial_end = 0;
+  for(size_t istage=1; istage<stages.size(); ++istage){
+    if(!stages.at(istage).serial) stages.at(istage).worker = std::thread(&PipelineToolChain::RunStage,this,istage);
+  }
+
+  // the serial stages all run on this thread: the head reads the next event,
+  // the later serial stages take events in order from the stage before them
+  bool source_done = false;
+  auto can_produce = [&]{
+    return !source_done && events_in_flight<max_events_in_flight && events_before_serial_end==0;
+  };
+  auto serial_work = [&]{
+    if(can_produce()) return true;
+    for(size_t istage=1; istage<stages.size(); ++istage){
+      if(stages.at(istage).serial && !stages.at(istage).input.empty()) return true;
+    }
+    return false;
+  };
+
+  while(true){
+    bool worked = false;
+
+    // let finished events leave the pipeline before new ones enter it
+    for(size_t istage=stages.size()-1; istage>0; --istage){
+      Stage& stage = stages.at(istage);
+      if(!stage.serial) continue;
+      PipelineEvent event;
+      {
+        std::lock_guard<std::mutex> lock(pipeline_mutex);
+        if(stage.input.empty()) continue;
+        event = stage.input.front();
+        stage.input.pop_front();
+      }
+      {
+        std::unique_lock<std::shared_timed_mutex> tools_lock(tools_mutex);
+        m_data->Stores.BindThreadStore("ANNIEEvent",event.store);
+        RunTools(stage);
+        m_data->Stores.UnbindThreadStore("ANNIEEvent");
+        ShareHeader();
+      }
+      {
+        std::lock_guard<std::mutex> lock(pipeline_mutex);
+        ForwardEvent(istage,event);
+      }
+      pipeline_cv.notify_all();
+      worked = true;
+    }
+
+    bool produce = false;
+    {
+      std::lock_guard<std::mutex> lock(pipeline_mutex);
+      produce = can_produce();
+    }
+    if(produce){
+      PipelineEvent event;
+      {
+        std::unique_lock<std::shared_timed_mutex> tools_lock(tools_mutex);
+        RunTools(stages.front());
+        event = NewEvent();
+        ShareHeader();
+      }
+      ++events_read;
+      // as in the ToolChain, the event during which StopLoop is set still goes through every tool
+      int stoploop = 0;
+      m_data->vars.Get("StopLoop",stoploop);
+      if(stoploop) source_done = true;
+      {
+        std::lock_guard<std::mutex> lock(pipeline_mutex);
+        live_events.push_back(event.store);
+        ++events_in_flight;
+        if(last_serial_stage>0) ++events_before_serial_end;
+        ForwardEvent(0,event);
+      }
+      pipeline_cv.notify_all();
+      worked = true;
+    }
+
+    if(worked) continue;
+    std::unique_lock<std::mutex> lock(pipeline_mutex);
+    if(source_done && events_in_flight==0) break;
+    pipeline_cv.wait(lock,[&]{ return (source_done && events_in_flight==0) || serial_work(); });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    stopping = true;
+  }
+  pipeline_cv.notify_all();
+  for(Stage& stage : stages){
+    if(stage.worker.joinable()) stage.worker.join();
+  }
+
+  return execute_failures==failures_before;
+}
@@ -0,0 +1,112 @@
+#ifndef PipelineToolChain_H
+#define PipelineToolChain_H
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "Tool.h"
+#include "ToolProfiler.h"
+
+/**
+ * \class PipelineToolChain
+ *
+ * Runs a list of tools (in ToolsConfig format) as a sub-chain, optionally pipelined:
+ * tools that declare in their config which stores and keys they read and write
+ * (PipelineReads / PipelineWrites / PipelineRunConstants) and only use per-event
+ * values from the ANNIEEvent each run on
+ * their own thread, working on successive events at the same time. Every event
+ * in flight gets its own copy of the ANNIEEvent, which each stage binds as
+ * m_data->Stores["ANNIEEvent"] for its thread. Tools without declarations run
+ * serially on the calling thread, in the order of the events, and the next
+ * event is only read once the current one has passed the last of them. The
+ * serial tools never run at the same time as a pipelined one.
+ * With Profile set, every tool call is timed and counted by a ToolProfiler.
+*/
+class PipelineToolChain: public Tool {
+
+
+ public:
+
+  PipelineToolChain(); ///< Simple constructor
+  bool Initialise(std::string configfile,DataModel &data); ///< Create and initialise the tools of the sub-chain and set up the pipeline stages
+  bool Execute(); ///< Run the sub-chain once, or in pipelined mode over all events until the chain is told to stop
+  bool Finalise(); ///< Finalise and delete the tools of the sub-chain
+
+
+ private:
+
+  struct ChainTool {
+    std::string name;
+    Tool* tool = nullptr;
+    bool declared = false;                 // config has PipelineReads, PipelineWrites or PipelineRunConstants
+    bool pipelinable = false;              // declared, and writes only to the ANNIEEvent
+    std::set<std::string> event_reads;     // ANNIEEvent keys read, "*" for all
+    std::set<std::string> event_writes;    // ANNIEEvent keys written
+  };
+
+  struct PipelineEvent {
+    BoostStore* store = nullptr;           // this event's ANNIEEvent
+    BoostStore* own_header = nullptr;      // store's own Header, while it borrows the ANNIEEvent's
+  };
+
+  struct Stage {
+    std::vector<size_t> tools;             // indices into chain_tools
+    bool serial = true;                    // run on the calling thread
+    std::deque<PipelineEvent> input;
+    std::thread worker;
+  };
+
+  bool LoadTools(std::string toolsfile, DataModel& data);
+  void ReadDeclarations(std::string toolconfig, ChainTool& chaintool);
+  void BuildStages();
+  bool RunPipeline();
+  bool RunTools(const Stage& stage);
+  void RunStage(size_t istage);
+  PipelineEvent NewEvent();
+  void ShareHeader();                      // call with tools_mutex held exclusively
+  void ForwardEvent(size_t istage, PipelineEvent event);  // call with the lock held
+  void DeleteEvent(PipelineEvent& event);
+
+  std::vector<ChainTool> chain_tools;
+  std::vector<Stage> stages;
+  std::vector<std::string> copy_keys;      // ANNIEEvent keys copied into each event in flight
+  size_t last_serial_stage = 0;            // last serial stage after the head, 0 if there is none
+
+  bool pipelined = false;
+  int max_events_in_flight = 8;
+  bool pipeline_done = false;
+
+  std::mutex pipeline_mutex;
+  std::condition_variable pipeline_cv;
+  int events_in_flight = 0;
+  int events_before_serial_end = 0;        // events that have not passed last_serial_stage yet
+  std::vector<BoostStore*> live_events;    // stores of the events in flight
+  // held shared by the stage threads while they run tools, and exclusively
+  // while the serial stages run: these may replace the ANNIEEvent and its
+  // Header, or change the CStore, which the stage threads read
+  std::shared_timed_mutex tools_mutex;
+  bool stopping = false;
+  std::atomic<int> execute_failures;
+
+  ToolProfiler* profiler = nullptr;
+  std::string profile_json_file;
+  uint64_t events_read = 0;
+
+  int verbosity = 1;
+  int v_error = 0;
+  int v_warning = 1;
+  int v_message = 2;
+  int v_debug = 3;
+
+};
+
+
+#endif
@@ -0,0 +1,174 @@
+#include "ToolProfiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <dlfcn.h>
+#include <iomanip>
+#include <sstream>
+#include <time.h>
+
+#include "StoreMap.h"
+
+namespace {
+
+  const char* phase_names[ToolProfiler::kNumPhases] = {"Initialise","Execute","Finalise"};
+
+  double WallSeconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // CPU time of the calling thread, so stages running in parallel are not mixed up
+  double ThreadCPUSeconds(){
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+    return ts.tv_sec + 1e-9*ts.tv_nsec;
+  }
+
+  // small, stable thread ids for the trace
+  std::atomic<int> next_thread_id(0);
+  int TraceThreadId(){
+    static thread_local int thread_id = next_thread_id++;
+    return thread_id;
+  }
+
+  std::string JSONString(const std::string& in){
+    std::string out = "\"";
+    for(char c : in){
+      if(c=='"' || c=='\\') out += '\\';
+      out += c;
+    }
+    return out+"\"";
+  }
+
+}
+
+ToolProfiler::Call::Call(ToolProfiler* profiler_in, size_t tool_in, Phase phase_in) :
+  profiler(profiler_in), tool(tool_in), phase(phase_in) {
+  if(profiler==nullptr) return;
+  if(profiler->allocation_counts) profiler->allocation_counts(&allocations_start,&bytes_start);
+  lookups_start = StoreMap::ThreadLookups();
+  cpu_start = ThreadCPUSeconds();
+  wall_start = WallSeconds();
+}
+
+ToolProfiler::Call::~Call(){
+  if(profiler==nullptr) return;
+  double wall_end = WallSeconds();
+  double cpu_end = ThreadCPUSeconds();
+  uint64_t allocations_end = allocations_start, bytes_end = bytes_start;
+  if(profiler->allocation_counts) profiler->allocation_counts(&allocations_end,&bytes_end);
+
+  Counters& counters = profiler->tools.at(tool).phases[phase];
+  ++counters.calls;
+  counters.wall_s += wall_end - wall_start;
+  counters.cpu_s += cpu_end - cpu_start;
+  counters.allocations += allocations_end - allocations_start;
+  counters.alloc_bytes += bytes_end - bytes_start;
+  counters.store_lookups += StoreMap::ThreadLookups() - lookups_start;
+  profiler->Trace(tool,phase,wall_start,wall_end);
+}
+
+ToolProfiler::ToolProfiler(){
+  wall_origin = WallSeconds();
+  // the allocation counter replaces operator new for the whole process, so it
+  // is a library of its own, only there when it is preloaded
+  allocation_enable = reinterpret_cast<void(*)(int)>(dlsym(RTLD_DEFAULT,"allocationcounter_enable"));
+  allocation_counts = reinterpret_cast<void(*)(uint64_t*,uint64_t*)>(dlsym(RTLD_DEFAULT,"allocationcounter_thread_counts"));
+  if(allocation_enable==nullptr || allocation_counts==nullptr){
+    allocation_enable = nullptr;
+    allocation_counts = nullptr;
+  }
+  if(allocation_enable) allocation_enable(1);
+}
+
+ToolProfiler::~ToolProfiler(){
+  CloseTrace();
+  if(allocation_enable) allocation_enable(0);
+}
+
+size_t ToolProfiler::AddTool(const std::string& name){
+  ToolEntry entry;
+  entry.name = name;
+  tools.push_back(entry);
+  return tools.size()-1;
+}
+
+bool ToolProfiler::OpenTrace(const std::string& filename){
+  trace.open(filename);
+  if(!trace.is_open()) return false;
+  trace << "{\"traceEvents\":[\n";
+  return true;
+}
+
+void ToolProfiler::CloseTrace(){
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  if(!trace.is_open()) return;
+  trace << "\n]}\n";
+  trace.close();
+}
+
+void ToolProfiler::Trace(size_t tool, Phase phase, double wall_start, double wall_end){
+  if(!trace.is_open()) return;
+  // complete ("X") events, times in microseconds, one row per thread
+  char line[128];
+  snprintf(line,sizeof(line),"\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}",
+           phase_names[phase],1e6*(wall_start-wall_origin),1e6*(wall_end-wall_start),
+           TraceThreadId());
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  if(!first_trace_event) trace << ",\n";
+  first_trace_event = false;
+  trace << "{\"name\":" << JSONString(tools.at(tool).name) << "," << line;
+}
+
+std::string ToolProfiler::Table() const {
+  std::stringstream ss;
+  ss << std::left << std::setw(24) << "Tool" << std::setw(11) << "Phase"
+     << std::right << std::setw(9) << "Calls" << std::setw(12) << "Wall [s]" << std::setw(12) << "CPU [s]"
+     << std::setw(12) << "ms/call" << std::setw(11) << "events/s" << std::setw(12) << "Allocs"
+     << std::setw(12) << "Alloc [MB]" << std::setw(14) << "Store lookups" << "\n";
+  ss << std::fixed;
+  for(const ToolEntry& entry : tools){
+    for(int phase=0; phase<kNumPhases; ++phase){
+      const Counters& counters = entry.phases[phase];
+      if(counters.calls==0) continue;
+      // throughput only means something for Execute, which is called once per event
+      double rate = (phase==kExecute && counters.wall_s>0) ? counters.calls/counters.wall_s : 0;
+      ss << std::left << std::setw(24) << entry.name << std::setw(11) << phase_names[phase] << std::right
+         << std::setw(9) << counters.calls
+         << std::setw(12) << std::setprecision(3) << counters.wall_s
+         << std::setw(12) << counters.cpu_s
+         << std::setw(12) << 1e3*counters.wall_s/counters.calls
+         << std::setw(11) << std::setprecision(1) << rate;
+      if(CountsAllocations()){
+        ss << std::setw(12) << counters.allocations
+           << std::setw(12) << std::setprecision(2) << counters.alloc_bytes/1048576.;
+      } else {
+        ss << std::setw(12) << "-" << std::setw(12) << "-";
+      }
+      ss << std::setw(14) << counters.store_lookups << "\n";
+    }
+  }
+  if(!CountsAllocations()) ss << "Heap allocations are only counted with LD_PRELOAD=lib/libAllocationCounter.so\n";
+  return ss.str();
+}
+
+bool ToolProfiler::WriteJSON(const std::string& filename) const {
+  std::ofstream out(filename);
+  if(!out.is_open()) return false;
+  out << "{\"allocations_counted\":" << (CountsAllocations() ? "true" : "false") << ",\"tools\":[";
+  for(size_t itool=0; itool<tools.size(); ++itool){
+    const ToolEntry& entry = tools.at(itool);
+    out << (itool ? ",\n" : "\n") << " {\"name\":" << JSONString(entry.name);
+    for(int phase=0; phase<kNumPhases; ++phase){
+      const Counters& counters = entry.phases[phase];
+      out << ",\"" << phase_names[phase] << "\":{\"calls\":" << counters.calls
+          << ",\"wall_s\":" << counters.wall_s << ",\"cpu_s\":" << counters.cpu_s
+          << ",\"allocations\":" << counters.allocations << ",\"alloc_bytes\":" << counters.alloc_bytes
+          << ",\"store_lookups\":" << counters.store_lookups << "}";
+    }
+    out << "}";
+  }
+  out << "\n],\"elapsed_s\":" << WallSeconds()-wall_origin << "}\n";
+  return out.good();
+}
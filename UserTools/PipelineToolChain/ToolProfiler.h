@@ -0,0 +1,87 @@
+#ifndef ToolProfiler_H
+#define ToolProfiler_H
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * \class ToolProfiler
+ *
+ * Per-tool timing and allocation counters for the PipelineToolChain. Each
+ * Initialise/Execute/Finalise call is wrapped in a ToolProfiler::Call, which
+ * records the wall and CPU time of the call, the heap allocations made (when
+ * lib/libAllocationCounter.so is preloaded, see src/AllocationCounter) and the
+ * number of m_data->Stores lookups. Each tool is
+ * only ever called from one thread at a time, so the counters need no locks.
+ * Optionally every call is also written to a trace file in the Chrome trace
+ * event format, which flame graph viewers such as Perfetto or speedscope load.
+ */
+class ToolProfiler {
+
+ public:
+
+  enum Phase { kInitialise=0, kExecute, kFinalise, kNumPhases };
+
+  struct Counters {
+    uint64_t calls = 0;
+    double wall_s = 0;
+    double cpu_s = 0;
+    uint64_t allocations = 0;
+    uint64_t alloc_bytes = 0;
+    uint64_t store_lookups = 0;
+  };
+
+  /// Measures one call of a tool from construction to destruction
+  class Call {
+   public:
+    Call(ToolProfiler* profiler, size_t tool, Phase phase);
+    ~Call();
+   private:
+    ToolProfiler* profiler;
+    size_t tool;
+    Phase phase;
+    double wall_start = 0;
+    double cpu_start = 0;
+    uint64_t allocations_start = 0;
+    uint64_t bytes_start = 0;
+    unsigned long lookups_start = 0;
+  };
+
+  ToolProfiler();
+  ~ToolProfiler();
+
+  size_t AddTool(const std::string& name);
+  bool OpenTrace(const std::string& filename);
+  void CloseTrace();
+
+  /// Whether heap allocations are counted, i.e. lib/libAllocationCounter.so is loaded
+  bool CountsAllocations() const { return allocation_counts!=nullptr; }
+
+  /// Summary table, one line per tool and phase that was called
+  std::string Table() const;
+  bool WriteJSON(const std::string& filename) const;
+
+ private:
+
+  struct ToolEntry {
+    std::string name;
+    Counters phases[kNumPhases];
+  };
+
+  void Trace(size_t tool, Phase phase, double wall_start, double wall_end);
+
+  std::vector<ToolEntry> tools;
+  double wall_origin;
+  // entry points of lib/libAllocationCounter.so, null if it is not loaded
+  void (*allocation_enable)(int) = nullptr;
+  void (*allocation_counts)(uint64_t*, uint64_t*) = nullptr;
+  std::ofstream trace;
+  std::mutex trace_mutex;
+  bool first_trace_event = true;
+
+};
+
+#endif
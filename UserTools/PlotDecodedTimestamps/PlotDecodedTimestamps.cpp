@@ -1,4 +1,7 @@
 #include "PlotDecodedTimestamps.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PlotDecodedTimestamps);
 
 PlotDecodedTimestamps::PlotDecodedTimestamps():Tool(){}
 
@@ -1,6 +1,7 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 
 #include "PlotLAPPDTimesFromStore.h"
+#include "ToolRegistry.h"
 
 // for drawing
 #include "TROOT.h"
@@ -10,6 +11,8 @@
 #include "TPolyMarker3D.h"
 #include "TSystem.h"
 
+REGISTER_TOOL(PlotLAPPDTimesFromStore);
+
 PlotLAPPDTimesFromStore::PlotLAPPDTimesFromStore():Tool(){}
 
 bool PlotLAPPDTimesFromStore::Initialise(std::string configfile, DataModel &data){
@@ -1,6 +1,7 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 
 #include "PlotWaveforms.h"
+#include "ToolRegistry.h"
 
 // for drawing
 #include "TROOT.h"
@@ -12,6 +13,8 @@
 #include <future>
 #include <thread>
 
+REGISTER_TOOL(PlotWaveforms);
+
 PlotWaveforms::PlotWaveforms():Tool(){}
 
 
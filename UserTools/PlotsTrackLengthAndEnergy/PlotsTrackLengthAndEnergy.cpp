@@ -1,4 +1,5 @@
 #include "PlotsTrackLengthAndEnergy.h"
+#include "ToolRegistry.h"
 #include "TCanvas.h"
 #include "TMath.h"
 #include "TH2F.h"
@@ -6,6 +7,8 @@
 #include "TAxis.h"
 #include "TLine.h"
 
+REGISTER_TOOL(PlotsTrackLengthAndEnergy);
+
 PlotsTrackLengthAndEnergy::PlotsTrackLengthAndEnergy():Tool(){}
 
 
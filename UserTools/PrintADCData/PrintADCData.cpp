@@ -1,4 +1,7 @@
 #include "PrintADCData.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PrintADCData);
 
 PrintADCData::PrintADCData():Tool(){}
 
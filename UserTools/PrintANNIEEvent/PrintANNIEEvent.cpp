@@ -1,5 +1,8 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "PrintANNIEEvent.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PrintANNIEEvent);
 
 PrintANNIEEvent::PrintANNIEEvent():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "PrintDQ.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PrintDQ);
 
 PrintDQ::PrintDQ():Tool(){}
 
@@ -1,9 +1,12 @@
 #include "PrintGenieEvent.h"
+#include "ToolRegistry.h"
 #include "GenieInfo.h"
 
 /// legacy
 #define LOADED_GENIE 1
 
+REGISTER_TOOL(PrintGenieEvent);
+
 PrintGenieEvent::PrintGenieEvent():Tool(){}
 
 bool PrintGenieEvent::Initialise(std::string configfile, DataModel &data){
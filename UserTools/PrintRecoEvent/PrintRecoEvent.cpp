@@ -1,4 +1,7 @@
 #include "PrintRecoEvent.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(PrintRecoEvent);
 
 PrintRecoEvent::PrintRecoEvent():Tool(){}
 
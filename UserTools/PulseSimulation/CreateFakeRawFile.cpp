@@ -190,10 +190,8 @@ void PulseSimulation::FillInitialFileInfo(){
 	Log("PulseSimulation Tool: Constructing CardData entries",v_debug,verbosity);
 	// fill all the non-minibuffer info and reset the minibuffers
 	if((int)emulated_pmtdata_readout.size()<num_adc_cards){
-//		cout<<"constructing vector of "<<num_adc_cards<<" CardData objects"
-//			<<" and temp databuffer vector with "<<full_buffer_size<<" element data arrays"<<endl;
+//		cout<<"constructing vector of "<<num_adc_cards<<" CardData objects"<<endl;
 		emulated_pmtdata_readout= std::vector<MCCardData>(num_adc_cards);
-		temporary_databuffers = std::vector< std::vector<uint16_t> >(num_adc_cards);
 	}
 	// In order for downstream tools to be able to retrieve the waveform vector pointers just
 	// once in Initialize, we need to set up those vectors now. This is done in Card::Reset().
@@ -0,0 +1,52 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#include "NoiseGenerator.h"
+
+#include <cmath>
+
+void NoiseGenerator::Initialise(uint64_t seed_in, double sigma_in){
+	seed = Mix(seed_in);
+	
+	// The noise added to a sample is static_cast<int>(Gaus(0,sigma)), i.e. rounded towards zero.
+	// Value k>0 covers [k,k+1), k<0 covers (k-1,k] and 0 covers (-1,1).
+	// cdf(k) is the probability of a value <= k.
+	auto cdf = [sigma_in](int k){
+		double x = (k<0) ? k : k+1;
+		return 0.5*std::erfc(-x/(sigma_in*std::sqrt(2.)));
+	};
+	gaus_table.resize(65536);
+	int k = -static_cast<int>(std::ceil(10*sigma_in)) - 1;
+	for(int u=0; u<65536; u++){
+		double p = (u+0.5)/65536.;
+		while(cdf(k)<p) k++;
+		gaus_table[u] = static_cast<int16_t>(k);
+	}
+}
+
+uint64_t NoiseGenerator::Mix(uint64_t x){
+	// splitmix64 finaliser
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+int NoiseGenerator::UniformInt(uint64_t stream, uint64_t& counter, int low, int high) const {
+	uint64_t range = static_cast<uint64_t>(high-low);
+	// top 32 bits times range: multiply-shift instead of a modulo
+	return low + static_cast<int>(((Random(stream,counter++)>>32)*range)>>32);
+}
+
+void NoiseGenerator::AddNoise(uint16_t* samples, int n, uint16_t offset, uint64_t stream,
+	uint64_t& counter) const {
+	int samplei=0;
+	for(; samplei+4<=n; samplei+=4){
+		uint64_t r = Random(stream,counter++);
+		samples[samplei]   += offset + gaus_table[r & 0xFFFF];
+		samples[samplei+1] += offset + gaus_table[(r >> 16) & 0xFFFF];
+		samples[samplei+2] += offset + gaus_table[(r >> 32) & 0xFFFF];
+		samples[samplei+3] += offset + gaus_table[r >> 48];
+	}
+	if(samplei<n){
+		uint64_t r = Random(stream,counter++);
+		for(; samplei<n; samplei++, r>>=16) samples[samplei] += offset + gaus_table[r & 0xFFFF];
+	}
+}
@@ -0,0 +1,33 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#ifndef NOISEGENERATOR_H
+#define NOISEGENERATOR_H
+
+#include <stdint.h>
+#include <vector>
+
+// Counter-based random numbers for the ADC trace noise.
+// Every draw is a hash of (seed, stream, counter), so a trace's noise only depends on
+// the seed and on which card and readout it belongs to, not on how many other random
+// numbers were drawn before it. Gaussian noise is read from an inverse-CDF lookup table
+// of the already truncated (integer) values, four samples per 64-bit draw.
+class NoiseGenerator{
+	public:
+	NoiseGenerator(){}
+	void Initialise(uint64_t seed_in, double sigma_in);
+	
+	// uniformly distributed integer in [low, high)
+	int UniformInt(uint64_t stream, uint64_t& counter, int low, int high) const;
+	// add offset + truncated gaussian noise to n samples
+	void AddNoise(uint16_t* samples, int n, uint16_t offset, uint64_t stream, uint64_t& counter) const;
+	
+	private:
+	static uint64_t Mix(uint64_t x);
+	inline uint64_t Random(uint64_t stream, uint64_t counter) const {
+		return Mix(seed ^ Mix(stream + 0x9E3779B97F4A7C15ULL*(counter+1)));
+	}
+	uint64_t seed=0;
+	std::vector<int16_t> gaus_table;  // indexed by a 16-bit uniform random number
+	
+};
+
+#endif
@@ -1,10 +1,13 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "PulseSimulation.h"
+#include "ToolRegistry.h"
 //#include "CreateFakeRawFile.cpp"/
 //#include "GetTemplateRunInfo.cpp"
 //#include "FillEmulatedTriggerdata.cpp"
 //#include "FillEmulatedCCData.cpp"
 
+REGISTER_TOOL(PulseSimulation);
+
 PulseSimulation::PulseSimulation():Tool(){}
 
 bool PulseSimulation::Initialise(std::string configfile, DataModel &data){
@@ -22,6 +25,8 @@ bool PulseSimulation::Initialise(std::string configfile, DataModel &data){
 	m_variables.Get("PhaseOneRiffleShuffle",DoPhaseOneRiffle);
 	m_variables.Get("GenerateFakeRootFiles",GenerateFakeRootFiles);
 	m_variables.Get("PutOutputsIntoStore",PutOutputsIntoStore);
+	int noiseseed=4357;
+	m_variables.Get("NoiseSeed",noiseseed);
 	if((!GenerateFakeRootFiles)&&(!PutOutputsIntoStore)){
 		logmessage = "PulseSimulation Tool: Both GenerateFakeRootFiles and PutOutputsIntoStore"
 			" were false! Nowhere to put outputs!";
@@ -55,6 +60,11 @@ bool PulseSimulation::Initialise(std::string configfile, DataModel &data){
 	LoadOutputFiles();
 	Log("Files made",v_debug,verbosity);
 	
+	// buffer sizes are known now: set up the pulse and noise generation
+	BuildPulseShape();
+	BuildNoiseRuns();
+	noise.Initialise(noiseseed,2.);
+	
 	// if we're putting stuff into BoostStores, make those
 	if(PutOutputsIntoStore){
 		Log("Creating Output Stores",v_debug,verbosity);
@@ -386,138 +396,53 @@ void PulseSimulation::AddPMTDataEntry(MCHit* digihit){
 		+ ", area calculated to be: " + to_string(adjusted_digit_q);
 	Log(logmessage,v_debug,verbosity);
 	
-	// construct a suitable pulse waveform using the position and charge of the digit
-	pulsevector.assign(minibuffer_datapoints_per_channel,0);  // clear the temporary pulse vector
-	// fill it with a pulse waveform with suitable form and size
-	Log("PulseSimulation Tool: Generating Waveform for this pulse",v_debug,verbosity);
-	GenerateMinibufferPulse(digits_time_index, adjusted_digit_q, pulsevector);
-	
-	// calculate the offset of the minibuffer, for this channel, within the full buffer for the readout
-	int channeloffset = channelnum * (full_buffer_size / channels_per_adc_card);
-	int minibufferoffset = minibuffer_id*minibuffer_datapoints_per_channel;
-//	cout<<"channeloffset="<<channeloffset<<", minibufferoffset="<<minibufferoffset
-//		<<", digitoffset="<<digits_time_index<<" : pulse should be at "
-//		<<(channeloffset+minibufferoffset+digits_time_index)<<" in the full buffer"<<endl;
-	
-	// get the full data array for this card, and an iterator to the appropriate start point
-	std::vector<uint16_t>* thiscards_fullbuffer = &temporary_databuffers.at(cardid);
-	std::vector<uint16_t>::iterator minibuffer_start = thiscards_fullbuffer->begin() + channeloffset + minibufferoffset;
-	
-	// add the generated pulse to the minibuffer at the appropriate location
+	// construct a pulse waveform using the position and charge of the digit,
+	// and add it to the current minibuffer of this channel in the card's data array
 	Log("PulseSimulation Tool: Adding pulse to full trace",v_debug,verbosity);
-	std::transform(minibuffer_start, minibuffer_start+minibuffer_datapoints_per_channel, pulsevector.begin(),
-		minibuffer_start, std::plus<uint16_t>() );
-	
-//	int pulsepeakindex=(channeloffset+minibufferoffset+digits_time_index);
-//	cout<<"non-zero section of trace (from sample "<<std::max(0,pulsepeakindex-10)
-//		<<" to "<<std::min(full_buffer_size,pulsepeakindex+100)
-//		<<") : {";
-//	for(int samplei=std::max(0,pulsepeakindex-10);
-//			samplei<std::min(minibuffer_datapoints_per_channel,pulsepeakindex+100);
-//			samplei++){
-//		cout<<"("<<samplei<<","<<(*(minibuffer_start+samplei))<<"), ";
-//	}
-//	cout<<"}"<<endl;
-	
-//	// ==============
-//	// draw for debug
-//	if(DRAW_DEBUG_PLOTS){
-//		cout<<"making graph of this channel's buffer of size "<<(full_buffer_size/channels_per_adc_card)<<endl;
-//		// make the graph+canvas if we haven't
-//		if(gROOT->FindObject("buffercanvas")==nullptr){
-//			buffercanvas = new TCanvas("buffercanvas","buffercanvas",canvwidth,canvheight);
-//			buffergraph  = new TGraph(full_buffer_size/channels_per_adc_card);
-//			buffergraph->SetName("buffergraph");
-//		}
-//		cout<<"adding hit at "<<digihit->GetTime()<<"ns, index "<<digits_time_index<<endl;
-//		cout<<"non-zero values of the buffer: {";
-//		for(int i=0; i<(full_buffer_size/channels_per_adc_card); i++){
-//			uint16_t theval = thiscards_fullbuffer->at(channeloffset+i);
-//			buffergraph->SetPoint(i,i,theval);
-//			if(theval!=0) cout<<"("<<i<<","<<theval<<")";
-//		}
-//		cout<<"}"<<endl;
-//		buffercanvas->cd();
-//		buffergraph->Draw("alp");
-//		buffercanvas->Update();
-//		//gPad->WaitPrimitive();
-//		do{
-//			gSystem->ProcessEvents();
-//			std::this_thread::sleep_for (std::chrono::milliseconds(100));
-//		} while(gROOT->FindObject("buffercanvas"));
-//	}
-//	// ===============
+	GenerateMinibufferPulse(digits_time_index, adjusted_digit_q, emulated_pmtdata_readout.at(cardid), channelnum);
 	
 }
 
-void PulseSimulation::GenerateMinibufferPulse(int digit_index, double adjusted_digit_q, std::vector<uint16_t> &pulsevector){
-	// Construct a waveform representing the pulse from a single digit
-	// ===============================================================
-	// we need to construct a waveform which crosses a Hefty threshold at digit_index
-	// (actually we position it centred at digit_index, it should be shifted according to threshold crossing)
-	// and has an integral of adjusted_digit_q. A landau function has approximately the right shape.
-	//Log("PulseSimulation Tool: Generating pulse waveform",v_debug,verbosity);
-	
-	if(fLandau==nullptr){
-		fLandau = new TF1("fLandau","[2]*TMath::Landau(x,[0],[1],1)",digit_index-10,digit_index+100);
-	}
-	// [0] is ~position of maximum, [1] is width (sigma), [2] is a scaling.
-	// the last parameter (fixed to 1 above) is 'normalise by dividing by sigma'.
-	// with 1, the integral is fixed to 1 and the maximum is varied
-	// (with 0 the maximum is fixed to ~0.18 and the integral varies)
-	// by choosing 1 we can always get the desired integral (Q). How should we vary height vs width?
-	// that's given by the typical aspect ratio of a PMT pulse: 
+void PulseSimulation::BuildPulseShape(){
+	// Tabulate the pulse shape used for every digit
+	// =============================================
+	// we need to construct a waveform which crosses a Hefty threshold at the digit time
+	// (actually we position it centred there, it should be shifted according to threshold crossing)
+	// and has an integral of the digit charge. A landau function has approximately the right shape.
+	// TMath::Landau(x,mpv,sigma,true) is normalised by dividing by sigma: the integral is fixed to 1
+	// and the maximum varies. Scaling by the charge then always gives the desired integral (Q).
+	// How should we vary height vs width? That's given by the typical aspect ratio of a PMT pulse:
 	// Looking at data: with X scale in samples (8ns) fitting a landau gives a sigma of ~2
 	// typical digit Qs are 0-30. (PEs?)
+	// The landau function is interesting in region -5*sigma -> 50*sigma, or for sigma=2, -10 to 100.
+	// Pulses are always centred on a sample, so the shape only ever needs evaluating at integer
+	// offsets from the peak and can be tabulated once.
 	
 	// TODO improve this by trading off the width vs height based on the time between the first and last
 	// photons within the digit XXX
 	
-	//cout<<"making pulse with integral "<<adjusted_digit_q<<" and peak "<<digit_index<<endl;
-	fLandau->SetParameters(digit_index, 2., adjusted_digit_q);
-	
-//	if(DRAW_DEBUG_PLOTS){
-//		// make the graph+canvas if we haven't
-//		if(gROOT->FindObject("landaucanvas")==nullptr){
-//			landaucanvas = new TCanvas("landaucanvas","landaucanvas",canvwidth,canvheight);
-//		}
-//		landaucanvas->cd();
-//		fLandau->Draw();
-//		landaucanvas->Update();
-//		gSystem->ProcessEvents();
-//	}
-	
-	// landau function is interesting in region -5*sigma -> 50*sigma, or for sigma=2, -10 to 100
-	//fLandau->SetRange(-10,100); only set in creation as fixed
-	for(int i=(digit_index-10); i<(digit_index+100); i++){
-		// pulses very close to the front/end of the minibuffer: get tructated.
-		if( (i<0) || (i>((int)pulsevector.size()-1)) ) continue;
-		pulsevector.at(i)=fLandau->Eval(i);
+	pulse_shape_start = -10;
+	pulse_shape.resize(110);
+	for(int i=0; i<(int)pulse_shape.size(); i++){
+		pulse_shape.at(i) = TMath::Landau(pulse_shape_start+i, 0., 2., true);
 	}
+}
+
+void PulseSimulation::GenerateMinibufferPulse(int digit_index, double adjusted_digit_q, MCCardData& card, int channelnum){
+	// Add the waveform from a single digit to the current minibuffer of a channel
+	// ===========================================================================
+	//Log("PulseSimulation Tool: Generating pulse waveform",v_debug,verbosity);
 	
-	// ==============
-//	// draw for debug
-//	if(DRAW_DEBUG_PLOTS){
-//		cout<<"making graph of the new pulse of size "<<pulsevector.size()<<endl;
-//		// make the graph+canvas if we haven't
-//		if(gROOT->FindObject("pulsecanvas")==nullptr){
-//			pulsecanvas = new TCanvas("pulsecanvas","pulsecanvas",canvwidth,canvheight);
-//			pulsegraph  = new TGraph(pulsevector.size());
-//			pulsegraph->SetName("pulsegraph");
-//		}
-//		for(int i=0; i<pulsevector.size(); i++) pulsegraph->SetPoint(i,(float)i,(float)pulsevector.at(i));
-//		// for validation, read back the datapoint values
-//		cout<<"non-zero values of pulsevector: {";
-//		for(auto&& aval : pulsevector){ if(aval!=0) cout<<aval<<", "; }
-//		cout<<"}"<<endl;
-//		pulsecanvas->cd();
-//		pulsegraph->Draw("alp");
-//		pulsecanvas->Update();
-//		gSystem->ProcessEvents();
-//		//std::this_thread::sleep_for (std::chrono::seconds(5));
-//		//gPad->WaitPrimitive();
-//	}
-//	// ===============
+	//cout<<"making pulse with integral "<<adjusted_digit_q<<" and peak "<<digit_index<<endl;
+	// pulses very close to the front/end of the minibuffer: get tructated.
+	int first = std::max(digit_index+pulse_shape_start, 0);
+	int last = std::min(digit_index+pulse_shape_start+(int)pulse_shape.size(), minibuffer_datapoints_per_channel);
+	int minibufferoffset = minibuffer_id*minibuffer_datapoints_per_channel;
+	uint16_t* data = card.Data.data();
+	for(int i=first; i<last; i++){
+		uint16_t sample = adjusted_digit_q*pulse_shape[i-digit_index-pulse_shape_start];
+		data[DataIndex(channelnum, minibufferoffset+i)] += sample;
+	}
 	
 }
 
@@ -609,8 +534,7 @@ void PulseSimulation::ConstructEmulatedPmtDataReadout(){
 		// actually set per event
 		//Log("PulseSimulation Tool: Allocating trace memory",v_debug,verbosity);
 		acard.SequenceID = sequence_id;
-		//acard.Data.assign(full_buffer_size,0); not necessary since we're using the temporary buffers
-		temporary_databuffers.at(cardi).assign(full_buffer_size,0);
+		acard.Data.assign(full_buffer_size,0);
 		
 		//	Remaining event data to be filled while processing triggers:
 		//	-----------------------------------------------------------
@@ -632,12 +556,10 @@ bool PulseSimulation::FillEmulatedPMTData(){
 	// 0,1,2... (there are 16 cards, numbered up to 21). Each readout has a unique SequenceID.
 	// Data[] arrays are waveforms of 40,000 datapoints per minibuffer
 	
-	// first, add noise to the temporary waveforms
+	// first, add noise to the waveforms. Pulses have already been written in the
+	// final (phase 1 interleaved, if requested) sample order.
 	AddNoiseToWaveforms();
 	
-	// next, shuffle your library. this also copies temporary_databuffers into emulated_pmtdata_readout
-	RiffleShuffle(DoPhaseOneRiffle); // pass true for phase 1 shuffle, needed for either
-	
 	//cout<<"Filling PMTData tree"<<endl;
 	// loop over all cards and fill the PMTData tree with the constructed data
 	Log("PulseSimulation Tool: Loading traces into TTree branch variables",v_debug,verbosity);
@@ -812,78 +734,46 @@ bool PulseSimulation::FillEmulatedPMTData(){
 	return true;
 }
 
-void PulseSimulation::AddNoiseToWaveforms(){
-	Log("PulseSimulation Tool: Adding noise to traces",v_debug,verbosity);
-	// add noise to the temporary buffers
-	for(int cardi=0; cardi<num_adc_cards; cardi++){
-		// get the temporary Data array for this card, which currently only has pulses in
-		auto& temp_card_buffer = temporary_databuffers.at(cardi);
-		
-		// loop over all the minibuffers in the full buffer
-		int16_t mboffset=0;
-		for(int samplei=0; samplei<(int)temp_card_buffer.size(); samplei++){
-			// Each minibuffer has an offset of ~330 +- 20 ADC counts, distributed... well..
-			// there may be an underlying sine wave of varying amplitude, which is sorta kinda uniform..?
-			if((samplei%(full_buffer_size/minibuffers_per_fullbuffer))==0){
-				// if new minibuffer, generate a new minibuffer offset
-				mboffset = static_cast<uint16_t>(R.Uniform(310,350));
-			}
-			
-			// within the minibuffer there's a spread of gaussian noise +-5 ADC counts
-			int16_t currentsamplei = static_cast<int32_t>(temp_card_buffer.at(samplei));
-			currentsamplei += mboffset + static_cast<int32_t>(R.Gaus(0,2));
-			temp_card_buffer.at(samplei) = static_cast<uint32_t>(currentsamplei);
+void PulseSimulation::BuildNoiseRuns(){
+	// Each minibuffer has its own pedestal offset. Work out once which stretches of the card
+	// Data array share an offset, so that noise can be added in array order.
+	// Offsets change every (full_buffer_size/minibuffers_per_fullbuffer) samples of the
+	// un-interleaved array.
+	int channel_buffer_size = (full_buffer_size / channels_per_adc_card);
+	int block_size = (full_buffer_size / minibuffers_per_fullbuffer);
+	std::vector<int> sample_block(full_buffer_size,0);
+	for(int samplei=0; samplei<full_buffer_size; samplei++){
+		int channelnum = samplei / channel_buffer_size;
+		sample_block.at(DataIndex(channelnum, samplei%channel_buffer_size)) = samplei / block_size;
+	}
+	noise_runs.clear();
+	for(int samplei=0; samplei<full_buffer_size; samplei++){
+		if(noise_runs.empty() || noise_runs.back().block!=sample_block[samplei]){
+			noise_runs.push_back(NoiseRun{samplei,0,sample_block[samplei]});
 		}
+		noise_runs.back().length++;
 	}
+	noise_block_offsets.resize((full_buffer_size-1)/block_size+1);
 }
 
-void PulseSimulation::RiffleShuffle(bool do_shuffle){
-	Log("PulseSimulation Tool: Performing phase 1 interleaving",v_debug,verbosity);
-/*
-	4 channels are separate and isolated within the full buffer:
-	[chan 1][chan 2][chan 3][chan 4]
-	within each channel, there are 40 minibuffers concatenated:
-	[{ch1:mb1}{ch1:mb2}...{ch1:mb40}][{ch2:mb1}{ch2:mb2}...{ch2:mb40}] --- [{ch4:mb1}{ch4:mb2}...{ch4:mb40}]
-	but wait! within each channel section, each subarray is split in half and pairs are interleaved:
-	so if a channel subarray had indices:
-	[0, 1, 2, 3, 4 ... 40k]
-	then the actual sample ordering should be:
-	[0, 1, 4, 5, 8, 9 ... 20k, 2, 3, 6, 7, 10, 11 ... 40k]
-	
-	So let's shuffle!
-*/
-	//cout<<"Shuffling Data arrays"<<endl;
-	
-	int channel_buffer_size = (full_buffer_size / channels_per_adc_card);
+void PulseSimulation::AddNoiseToWaveforms(){
+	Log("PulseSimulation Tool: Adding noise to traces",v_debug,verbosity);
 	for(int cardi=0; cardi<num_adc_cards; cardi++){
 		auto& acard = emulated_pmtdata_readout.at(cardi);
-		auto& card_buffer = acard.Data;
-		auto& temp_card_buffer = temporary_databuffers.at(cardi);
+		// random numbers are counted from 0 for each card in each readout,
+		// so the noise for a given seed doesn't depend on anything else in the run
+		uint64_t stream = (static_cast<uint64_t>(sequence_id) << 16) | cardi;
+		uint64_t counter = 0;
 		
-		if(do_shuffle){
-			// split the deck into four piles
-			for(int channeli=0; channeli<channels_per_adc_card; channeli++){
-				auto channel_buffer_start = card_buffer.begin() + (channel_buffer_size * channeli);
-				auto temp_channel_buffer_start = temp_card_buffer.begin() + (channel_buffer_size * channeli);
-				// split each pile into two, then interleave pairs in the two piles
-				for(int samplei=0, samplej=0; samplei<channel_buffer_size; samplei+=4, samplej+=2){
-					//0 = 0
-					*(channel_buffer_start + samplej) = 
-						*(temp_channel_buffer_start + samplei);
-					//1 = 1
-					*(channel_buffer_start + samplej + 1) = 
-						*(temp_channel_buffer_start + samplei + 1);
-					//20,000 = 2
-					*(channel_buffer_start + (channel_buffer_size/2) + samplej ) 
-						= *(temp_channel_buffer_start + samplei + 2);
-					//20,001 = 3
-					*(channel_buffer_start + (channel_buffer_size/2) + samplej + 1) 
-						= *(temp_channel_buffer_start + samplei + 3);
-				}
-			}
-		} else {
-			for(int i=0; i<(int)temp_card_buffer.size(); i++) card_buffer.at(i)=temp_card_buffer.at(i);
+		// Each minibuffer has an offset of ~330 +- 20 ADC counts, distributed... well..
+		// there may be an underlying sine wave of varying amplitude, which is sorta kinda uniform..?
+		for(auto& anoffset : noise_block_offsets){
+			anoffset = noise.UniformInt(stream, counter, 310, 350);
+		}
+		// within the minibuffer there's a spread of gaussian noise +-5 ADC counts
+		for(auto& arun : noise_runs){
+			noise.AddNoise(acard.Data.data()+arun.start, arun.length,
+				noise_block_offsets[arun.block], stream, counter);
 		}
 	}
-	// finally, ask a player to cut the deck
 }
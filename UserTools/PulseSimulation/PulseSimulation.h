@@ -18,6 +18,7 @@
 #include <stdlib.h>
 
 #include "MCCardData.h"
+#include "NoiseGenerator.h"
 
 #include "TTree.h"
 #include "TFile.h"
@@ -27,7 +28,7 @@
 #include "TCanvas.h"
 #include "TGraph.h"
 #include "TRandom3.h"
-#include "TF1.h"
+#include "TMath.h"
 
 // for drawing
 class TApplication;
@@ -98,12 +99,14 @@ class PulseSimulation: public Tool {
 	// Internal Functions
 	// ------------------
 	void AddPMTDataEntry(MCHit* digihit);
-	void GenerateMinibufferPulse(int digit_index, double adjusted_digit_q, std::vector<uint16_t> &pulsevector);
+	void BuildPulseShape();
+	void GenerateMinibufferPulse(int digit_index, double adjusted_digit_q, MCCardData& card, int channelnum);
 	void AddMinibufferStartTime(bool droppingremainingsubtriggers);
 	void ConstructEmulatedPmtDataReadout();
 	bool FillEmulatedPMTData();
+	void BuildNoiseRuns();
 	void AddNoiseToWaveforms();
-	void RiffleShuffle(bool do_shuffle);
+	inline int DataIndex(int channelnum, int channel_sample) const;
 	void LoadOutputFiles();
 	void FillInitialFileInfo();
 	void FillEmulatedRunInformation();
@@ -125,15 +128,25 @@ class PulseSimulation: public Tool {
 	int minibuffer_datapoints_per_channel;   // num datapoints per channel per minibuffer *
 	int minibuffers_per_fullbuffer;          // 
 	int emulated_event_size;                 // just (minibuffer_datapoints_per_channel / 4) *
-	bool DoPhaseOneRiffle;                   // whether or not to shuffle data in vectors
+	bool DoPhaseOneRiffle;                   // whether or not to write data in the interleaved order
 	// * = member of MCCardData
 	
 	// Members used in waveform generation
 	// ------------------------------------
-	TF1* fLandau{nullptr};
-	std::vector<uint16_t> pulsevector;
+	// unit-area landau (sigma 2 samples) at integer sample offsets from the digit
+	std::vector<double> pulse_shape;
+	int pulse_shape_start;                   // sample offset of pulse_shape[0]
 	double PULSE_HEIGHT_FUDGE_FACTOR;        // because we always need to fudge it
 	
+	// Members used in noise generation
+	// --------------------------------
+	NoiseGenerator noise;
+	// stretches of a card Data array sharing one minibuffer pedestal offset,
+	// in the order they appear in the (possibly interleaved) array
+	struct NoiseRun{ int start; int length; int block; };
+	std::vector<NoiseRun> noise_runs;
+	std::vector<uint16_t> noise_block_offsets;
+	
 	// variables for connecting events into a run and filling the other file variables
 	// -------------------------------------------------------------------------------
 	TRandom3 R;
@@ -150,7 +163,6 @@ class PulseSimulation: public Tool {
 	// variables to go into the fake raw files
 	// ---------------------------------------
 	std::vector<MCCardData> emulated_pmtdata_readout;
-	std::vector<std::vector<uint16_t>> temporary_databuffers; // temp buffers while creating waveforms
 	std::vector<int64_t> StartCountVals;
 	std::vector<uint64_t> StartTimeNSecVals;
 	
@@ -213,5 +225,15 @@ class PulseSimulation: public Tool {
 	
 };
 
+inline int PulseSimulation::DataIndex(int channelnum, int channel_sample) const {
+	// position of a sample of a channel in the card Data array
+	int channel_buffer_size = (full_buffer_size / channels_per_adc_card);
+	int index = channelnum * channel_buffer_size;
+	if(not DoPhaseOneRiffle) return index + channel_sample;
+	// phase 1 interleaving: pairs of samples alternate between the two halves of the channel section
+	index += 2*(channel_sample/4) + (channel_sample%2);
+	if(channel_sample%4>=2) index += channel_buffer_size/2;
+	return index;
+}
 
 #endif
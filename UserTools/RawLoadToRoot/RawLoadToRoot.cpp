@@ -1,4 +1,7 @@
 #include "RawLoadToRoot.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(RawLoadToRoot);
 
 RawLoadToRoot::RawLoadToRoot():Tool(){}
 
@@ -2,6 +2,7 @@
 //#include "ANNIEconstants.h"
 //#include "MinibufferLabel.h"
 #include "RawLoader.h"
+#include "ToolRegistry.h"
 //#include "Waveform.h"
 
 // recoANNIE includes
@@ -48,6 +49,8 @@ namespace {
   constexpr int HEFTY_LED_TRIGGER_MASK = 0x1 << 30;
 }
 
+REGISTER_TOOL(RawLoader);
+
 RawLoader::RawLoader() : Tool()
 {}
 
@@ -1,4 +1,7 @@
 #include "ReadConfigInfo.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ReadConfigInfo);
 
 ReadConfigInfo::ReadConfigInfo():Tool(){}
 
@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <string>
+#include <map>
+#include <cstdint>
 
 namespace evwgh {
   struct MCEventWeight
@@ -71,5 +73,57 @@ namespace evwgh {
     double ppdydz;
     double pppz;
   };
+
+  // The flux kinematics of a block of events, one column per event field
+  struct EventBlock{
+    std::vector<int> run, entryno, evtno, tptype, ptype, ntype;
+    std::vector<double> tpx, tpy, tpz, vx, vy, vz;
+    std::vector<double> nimpwt, nenergyn, nenergyf, ndecay, ppmedium;
+    std::vector<double> pdpx, pdpy, pdpz, ppdxdz, ppdydz, pppz;
+
+    size_t size() const { return run.size(); }
+
+    void push_back(const event& e){
+      run.push_back(e.run); entryno.push_back(e.entryno); evtno.push_back(e.evtno);
+      tptype.push_back(e.tptype); ptype.push_back(e.ptype); ntype.push_back(e.ntype);
+      tpx.push_back(e.tpx); tpy.push_back(e.tpy); tpz.push_back(e.tpz);
+      vx.push_back(e.vx); vy.push_back(e.vy); vz.push_back(e.vz);
+      nimpwt.push_back(e.nimpwt); nenergyn.push_back(e.nenergyn); nenergyf.push_back(e.nenergyf);
+      ndecay.push_back(e.ndecay); ppmedium.push_back(e.ppmedium);
+      pdpx.push_back(e.pdpx); pdpy.push_back(e.pdpy); pdpz.push_back(e.pdpz);
+      ppdxdz.push_back(e.ppdxdz); ppdydz.push_back(e.ppdydz); pppz.push_back(e.pppz);
+    }
+
+    event at(size_t i) const{
+      event e;
+      e.run = run[i]; e.entryno = entryno[i]; e.evtno = evtno[i];
+      e.tptype = tptype[i]; e.ptype = ptype[i]; e.ntype = ntype[i];
+      e.tpx = tpx[i]; e.tpy = tpy[i]; e.tpz = tpz[i];
+      e.vx = vx[i]; e.vy = vy[i]; e.vz = vz[i];
+      e.nimpwt = nimpwt[i]; e.nenergyn = nenergyn[i]; e.nenergyf = nenergyf[i];
+      e.ndecay = ndecay[i]; e.ppmedium = ppmedium[i];
+      e.pdpx = pdpx[i]; e.pdpy = pdpy[i]; e.pdpz = pdpz[i];
+      e.ppdxdz = ppdxdz[i]; e.ppdydz = ppdydz[i]; e.pppz = pppz[i];
+      return e;
+    }
+
+    void clear(){ *this = EventBlock(); }
+  };
+
+  // The weights of one calculator for a block of events, in one contiguous
+  // array. The weights of event i are weights[offsets[i]] ... weights[offsets[i+1]-1]
+  struct WeightBlock{
+    std::vector<uint32_t> offsets = std::vector<uint32_t>(1, 0);
+    std::vector<float> weights;
+
+    size_t size() const { return offsets.size() - 1; }
+
+    template<typename Iterator> void Append(Iterator begin, Iterator end){
+      weights.insert(weights.end(), begin, end);
+      offsets.push_back(weights.size());
+    }
+
+    void clear(){ offsets.assign(1, 0); weights.clear(); }
+  };
 }
 #endif //_MCFLUXEVENTWEIGHT_H_
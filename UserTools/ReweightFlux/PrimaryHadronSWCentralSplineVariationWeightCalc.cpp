@@ -16,6 +16,7 @@
 #include "CLHEP/Random/JamesRandom.h"
 #include "CLHEP/Random/RandGaussQ.h"
 
+#include <algorithm>
 #include <vector>
 #include "TH1.h"
 #include "TArrayD.h"
@@ -40,12 +41,31 @@ namespace evwgh {
   public:
     PrimaryHadronSWCentralSplineVariationWeightCalc();
     void Configure(fluxconfig pset);
-    std::pair< bool, double > MiniBooNEWeightCalc(event& e, std::vector<double> rand);
-    std::pair< bool, double > MicroBooNEWeightCalc(event& e,std::vector<double> rand);
+    double MiniBooNEWeightCalc(double RW, double CV);
+    double MicroBooNEWeightCalc(double RW, double CV);
     virtual std::vector<std::vector<double> > GetWeight(event& e);
+    virtual void GetWeightBlock(EventBlock const& block, WeightBlock& weights);
     std::vector< std::vector< double > > MiniBooNERandomNumbers(std::string);
     
   private:
+    //
+    // A "b2e2" TSpline3 through fixed knots is linear in the knot values, so
+    // its value at x is the dot product of the knot values with a basis
+    // vector that only depends on x. The segment coefficients of that
+    // basis are taken from splines through each unit vector.
+    //
+    struct SplineBasis {
+      std::vector<double> knots;
+      std::vector< std::vector<double> > b, c, d; // [segment][knot]
+      void Build(TH1F* hist);
+      void Eval(double x, std::vector<double>& basis) const;
+    };
+
+    void EventWeights(int tptype, double tpx, double tpy, double tpz, std::vector<double>& weight);
+    void HadronKinematics(double tpx, double tpy, double tpz, double& HadronP, double& ThetaOfInterest);
+    double SanfordWangCV(double HadronP, double ThetaOfInterest, bool floatGuard);
+    double SmearedCrossSection(unsigned int universe);
+
     CLHEP::RandGaussQ *fGaussRandom;
     std::vector<double> ConvertToVector(TArrayD const* array);
     std::string fGenieModuleLabel;
@@ -68,8 +88,17 @@ namespace evwgh {
     TMatrixD* HARPCov;    
     TMatrixD* HARPLowerTriangluarCov;    
     TMatrixD* HARPXSec;    
-    std::vector< TH1F > fMomentumBins;
-    TH1F* fThetaBins;
+
+    // Smeared HARP cross section of each universe, [tbin*Npbins + pbin],
+    // and whether none of its bins came out negative
+    std::vector< std::vector< double > > fSmearedXSec;
+    std::vector< bool > fUniversePasses;
+
+    SplineBasis fMomentumSpline;
+    SplineBasis fThetaSpline;
+    std::vector< double > fMomentumBasis;
+    std::vector< double > fThetaBasis;
+    std::vector< double > fEventWeights;
 
     std::vector<double> HARPmomentumBounds;
     std::vector<double> HARPthetaBounds;
@@ -227,17 +256,145 @@ namespace evwgh {
     fIsDecomposed = true;
     HARPLowerTriangluarCov = new TMatrixD(dc.GetU());  
 
-    //create histograms used for splining
+    //
+    // Everything that only depends on the universe is done here once, instead
+    // of for every event and universe:
+    //
+    // Important notes of the HARP data: 
+    //  The cross section matrix has 13 momentum bins and 6 theta bins 
+    //  The covariance matrix contains the correlated uncertainties across
+    //  all 78 cross section measurements. 
+    //
+    //  The covariance matrix encodes the uncertainty on a given HARP 
+    //  ANALYSIS BIN instead of being a 3D matrix. 
+    //
+    //  A HARP analysis bin is defined as 
+    //  bin = momentum[theta[]] meaning that:
+    //      analysis bin 0 is the zeroth theta and zeroth momentum bin
+    //  but analysis bin 27 is the 3rd theta and 5th momentum bin
+    // 
+    // The first thing to do is convert our cross section matrix into 
+    // an std::vector for the analysis bins
+    //
     int Ntbins = int(HARPthetaBounds.size()) - 1;
     int Npbins = int(HARPmomentumBounds.size()) - 1;
+
+    std::vector< double > HARPCrossSectionAnalysisBins;
+    HARPCrossSectionAnalysisBins.resize(int(Ntbins*Npbins));
+
+    int anaBin = 0;
+    for(int pbin = 0; pbin < Npbins; pbin++){
+      for(int tbin = 0; tbin < Ntbins; tbin++){	
+	HARPCrossSectionAnalysisBins[anaBin] = HARPXSec[0][pbin][tbin];
+	anaBin++;
+      }
+    }
+
+    //
+    // Now using this we can vary the cross section based on the HARP covariance matrix 
+    // this will allow us to reweigh each cross section measurement based on
+    // the multigaussian smearing of this matrix. 
+    //
+    //   Check all the smeared cross sections, if any come out to be negative then 
+    //   we will not pass this given parameter set.
+    //
+    //   The smeared cross sections are stored per theta slice, rounded to
+    //   float as they were when they went through the TH1F bins
+    //
+    fSmearedXSec.resize(fWeightArray.size());
+    fUniversePasses.resize(fWeightArray.size());
+    for(unsigned int i = 0; i < fWeightArray.size(); i++){
+      std::vector< double > smearedHARPCrossSectionAnalysisBins = 
+	WeightCalc::MultiGaussianSmearing(HARPCrossSectionAnalysisBins, HARPLowerTriangluarCov, fIsDecomposed, fWeightArray[i]); 
+
+      fUniversePasses[i] = true;
+      fSmearedXSec[i].resize(Ntbins*Npbins);
+      anaBin = 0;
+      for(int pbin = 0; pbin < Npbins; pbin++){
+	for(int tbin = 0; tbin < Ntbins; tbin++){
+	  if(smearedHARPCrossSectionAnalysisBins[anaBin] < 0){ fUniversePasses[i] = false;}
+	  fSmearedXSec[i][tbin*Npbins + pbin] = float(smearedHARPCrossSectionAnalysisBins[anaBin]);
+	  anaBin++;
+	}
+      }
+    }
+
+    //
+    // We do a 2D interpolation across the full parameter space using cubic
+    // spline fits: first along momentum in each theta slice, then along theta
+    // through the values at the meson's momentum. The knots are the bin
+    // centers of the HARP binning.
+    //
+    // Important note about Splines, MiniBooNE used constraints on the
+    // second derivative of the first and final knot point and required 
+    // that they both equal to zero, this is not naturally the case in 
+    // in TSpline3 but it is default in DCSPLC (the Fortran CERN library spline function)
+    // this helps to control the smoothness of the spline and minimizes the variation bin to bin
+    // For TSpine3 this is controlled by "b2e2" (see SplineBasis::Build)
+    //
     double* HARPmomentumBins = HARPmomentumBounds.data(); // Convert std::vector to array
     double* HARPthetaBins = HARPthetaBounds.data();       // Convert std::vector to array
-    fMomentumBins.resize(Ntbins);
-    for(int bin = 0; bin < Ntbins; bin++)
-      fMomentumBins[bin] = TH1F(Form("HARPp_%i",bin),";;;", Npbins, HARPmomentumBins);
-    fThetaBins = new TH1F("HARPt",";;;", Ntbins, HARPthetaBins);  
+    TH1F MomentumBins(Form("HARPp_%s",HadronAbriviation.c_str()),";;;", Npbins, HARPmomentumBins);
+    TH1F ThetaBins(Form("HARPt_%s",HadronAbriviation.c_str()),";;;", Ntbins, HARPthetaBins);
+    MomentumBins.SetDirectory(0);
+    ThetaBins.SetDirectory(0);
+    fMomentumSpline.Build(&MomentumBins);
+    fThetaSpline.Build(&ThetaBins);
   }//End Configure
 
+  ////
+  //   Build the basis from splines through each unit vector
+  ////
+  void PrimaryHadronSWCentralSplineVariationWeightCalc::SplineBasis::Build(TH1F* hist)
+  {
+    int n = hist->GetNbinsX();
+    knots.resize(n);
+    b.assign(n, std::vector<double>(n, 0.));
+    c.assign(n, std::vector<double>(n, 0.));
+    d.assign(n, std::vector<double>(n, 0.));
+
+    for(int knot = 0; knot < n; knot++){
+      hist->Reset();
+      hist->SetBinContent(knot+1, 1.);
+      //
+      //  b1 = constrain first knot 1st derivative 
+      //  b2 = constrain first knot 2nd derivative 
+      //  e1 = constrain final knot 1st derivative 
+      //  e2 = constrain final knot 2nd derivative 
+      //
+      //  the numbers that follow are the values you constrain those conditions to
+      //
+      TSpline3 spline(hist,"b2e2",0,0);
+      for(int segment = 0; segment < n; segment++){
+	double x, y;
+	spline.GetCoeff(segment, x, y, b[segment][knot], c[segment][knot], d[segment][knot]);
+	knots[segment] = x;
+      }
+    }
+  }
+
+  ////
+  //   Basis vector at x, using the same segment as TSpline3::Eval
+  ////
+  void PrimaryHadronSWCentralSplineVariationWeightCalc::SplineBasis::Eval(double x, std::vector<double>& basis) const
+  {
+    int n = int(knots.size());
+    basis.assign(n, 0.);
+    if(n == 0) return;
+
+    // The last knot below x; outside of the knots the first or last
+    // segment polynomial is extrapolated
+    int segment = int(std::lower_bound(knots.begin(), knots.end(), x) - knots.begin()) - 1;
+    if(segment > n - 2) segment = n - 2;
+    if(segment < 0) segment = 0;
+
+    double dx = x - knots[segment];
+    for(int knot = 0; knot < n; knot++){
+      basis[knot] = dx*(b[segment][knot] + dx*(c[segment][knot] + dx*d[segment][knot]));
+    }
+    basis[segment] += 1.;
+  }
+
   std::vector<std::vector<double> > PrimaryHadronSWCentralSplineVariationWeightCalc::GetWeight(event & e)
   {
     //Create a vector of weights for each neutrino 
@@ -247,65 +404,118 @@ namespace evwgh {
        
     // Let's start by iterating through each of the neutrino interactions 
     for(unsigned int inu = 0; inu < 1; inu++){
-      // First let's check that the parent of the neutrino we are looking for is 
-      //  the particle we intended it to be, if not set all weights to 1
-      if (e.tptype != fprimaryHad){
-	weight[inu].resize(fNmultisims);
-	std::fill(weight[inu].begin(), weight[inu].end(), 1);
-	continue; //now move on to the next neutrino
-      }// Hadronic parent check
-          
-      //Let's make a weights based on the calculator you have requested       
-      
-      if(fMode.find("multisim") != std::string::npos){       
-	for (unsigned int i = 0; int(weight[inu].size()) < fNmultisims; i++) {
-
-	  if(fWeightCalc.find("MicroBooNE") != std::string::npos){
-
-	    //
-	    //This way we only have to call the WeightCalc once
-	    // 
-	    std::pair<bool, double> test_weight =
-	      MicroBooNEWeightCalc(e, fWeightArray[i]);
-	    if(test_weight.first){
-	      weight[inu].push_back(test_weight.second);
-	    }
-	  }
-	  if(fWeightCalc.find("MiniBooNE") != std::string::npos){
-
-	    //
-	    //This way we only have to call the WeightCalc once
-	    // 
-	    std::pair<bool, double> test_weight =
-	      MiniBooNEWeightCalc(e, fWeightArray[i]);
-
-	    if(test_weight.first){
-	      weight[inu].push_back(test_weight.second);
-	    }
-	  }
-	}//Iterate through the number of universes      
-      } // make sure we are multisiming
+      EventWeights(e.tptype, e.tpx, e.tpy, e.tpz, weight[inu]);
     }//Iterating through each neutrino 
 
     return weight;
   }
 
+  void PrimaryHadronSWCentralSplineVariationWeightCalc::GetWeightBlock(EventBlock const& block, WeightBlock& weights)
+  {
+    weights.clear();
+    for(size_t i = 0; i < block.size(); i++){
+      EventWeights(block.tptype[i], block.tpx[i], block.tpy[i], block.tpz[i], fEventWeights);
+      weights.Append(fEventWeights.begin(), fEventWeights.end());
+    }
+  }
+
+  //// 
+  //   Weights of all universes for one neutrino, from the parent type and
+  //   momentum at the target exit
+  ////
+  void PrimaryHadronSWCentralSplineVariationWeightCalc::EventWeights(int tptype, double tpx, double tpy, double tpz, std::vector<double>& weight)
+  {
+    weight.clear();
+
+    // First let's check that the parent of the neutrino we are looking for is 
+    //  the particle we intended it to be, if not set all weights to 1
+    if (tptype != fprimaryHad){
+      weight.resize(fNmultisims, 1);
+      return;
+    }// Hadronic parent check
+          
+    //Let's make a weights based on the calculator you have requested       
+      
+    if(fMode.find("multisim") != std::string::npos){       
+      bool useMicroBooNE = fWeightCalc.find("MicroBooNE") != std::string::npos;
+      bool useMiniBooNE = fWeightCalc.find("MiniBooNE") != std::string::npos;
+
+      //
+      // The kinematics, the central value and the spline basis vectors
+      // are the same in every universe, so get them once per event
+      //
+      double HadronP, ThetaOfInterest;
+      HadronKinematics(tpx, tpy, tpz, HadronP, ThetaOfInterest);
+      double MicroBooNECV = SanfordWangCV(HadronP, ThetaOfInterest, false);
+      double MiniBooNECV = SanfordWangCV(HadronP, ThetaOfInterest, true);
+      fMomentumSpline.Eval(HadronP, fMomentumBasis);
+      fThetaSpline.Eval(ThetaOfInterest, fThetaBasis);
+
+      for (unsigned int i = 0; int(weight.size()) < fNmultisims; i++) {
+	if(!fUniversePasses.at(i)) continue;
+
+	double RW = SmearedCrossSection(i);
+	if(useMicroBooNE){
+	  weight.push_back(MicroBooNEWeightCalc(RW, MicroBooNECV));
+	}
+	if(useMiniBooNE){
+	  weight.push_back(MiniBooNEWeightCalc(RW, MiniBooNECV));
+	}
+      }//Iterate through the number of universes      
+    } // make sure we are multisiming
+  }
+
   //////////////////////////////
   ////////       Auxilary Functions
   //////////////////////////////
 
   //// 
-  //   Use the MiniBooNE Implementation to determine the weight 
+  //   Meson momentum and the angle used in the Sanford-Wang and spline evaluation
   ////
-  std::pair< bool, double> PrimaryHadronSWCentralSplineVariationWeightCalc::MiniBooNEWeightCalc(event& e, std::vector<double> rand){
-    
-    bool parameters_pass = true;
-    
-    ///////////////////////////////
+  void PrimaryHadronSWCentralSplineVariationWeightCalc::HadronKinematics(double tpx, double tpy, double tpz, double& HadronP, double& ThetaOfInterest){
+
+    //  Lay out the event kinimatics 
+    double HadronMass;
+      
+    if(fabs(fprimaryHad) == 211) HadronMass = 0.13957010; //Charged Pion
+    else{ 
+      throw std::invalid_argument(" sanford-wang is only configured for charged pions ");
+    }
+
+    TLorentzVector HadronVec; 
+    double HadronPx = tpx;
+    double HadronPy = tpy;
+    double HadronPz = tpz;
+    double HadronE  = sqrt(HadronPx*HadronPx + 
+			   HadronPy*HadronPy + 
+			   HadronPz*HadronPz + 
+			   HadronMass*HadronMass);
+    HadronVec.SetPxPyPzE(HadronPx,HadronPy,HadronPz,HadronE);
+    HadronP = HadronVec.P();
+
+    ////////
+    //  
+    //   Based on MiniBooNE code to evaluate the theta value within below the maximum 
+    //    HARP theta coverage. This helps keep the splines well formed and constrains  
+    //    the uncertainties at very low neutrino energy
     //
-    // We now know that we have the hadronic parent that we want so we need to
-    // prepare the kinematic information about the iteraction to go into the Sanford-Wang
-    // calculation
+    ////////
+
+    if(HadronVec.Theta() > 0.195){
+      ThetaOfInterest = 0.195;
+    }
+    else{
+      ThetaOfInterest = HadronVec.Theta();
+    }
+  }
+
+  //// 
+  //   Sanford-Wang central value. MiniBooNE compared the meson and proton
+  //   momenta in single precision, MicroBooNE in double precision
+  ////
+  double PrimaryHadronSWCentralSplineVariationWeightCalc::SanfordWangCV(double HadronP, double ThetaOfInterest, bool floatGuard){
+
+    ///////////////////////////////
     //
     // Computations are based on MiniBooNE code that can be found here:
     // 
@@ -314,8 +524,6 @@ namespace evwgh {
     //
     //  >>> Based on MiniBooNE function MultisimMatrix_RawMesonProd
     //
-    //
-    //
     //   Useful references:
     //       MiniBooNE Collaboration, PhysRevD.79.072002
     //       D.Schmitz Thesis; http://lss.fnal.gov/archive/thesis/2000/fermilab-thesis-2008-26.pdf
@@ -331,225 +539,69 @@ namespace evwgh {
     double c7 = SWParam[6];
     double c8 = SWParam[7];
     double c9 = 1.0; // This isn't in the table but it is described in the text
-    
-    //  Lay out the event kinimatics 
-    double HadronMass;
-      
-      if(fabs(fprimaryHad) == 211) HadronMass = 0.13957010; //Charged Pion
-      else{ 
-	throw std::invalid_argument(" sanford-wang is only configured for charged pions ");
-      }
-
-      TLorentzVector HadronVec; 
-      double HadronPx = e.tpx;
-      double HadronPy = e.tpy;
-      double HadronPz = e.tpz;
-      double HadronE  = sqrt(HadronPx*HadronPx + 
-			     HadronPy*HadronPy + 
-			     HadronPz*HadronPz + 
-			     HadronMass*HadronMass);
-      HadronVec.SetPxPyPzE(HadronPx,HadronPy,HadronPz,HadronE);
 
-      ////////
-      //  
-      //   Based on MiniBooNE code to evaluate the theta value within below the maximum 
-      //    HARP theta coverage. This helps keep the splines well formed and constrains  
-      //    the uncertainties at very low neutrino energy
-      //
-      ////////
-
-      double ThetaOfInterest;
-      if(HadronVec.Theta() > 0.195){
-	ThetaOfInterest = 0.195;
-      }
-      else{
-	ThetaOfInterest = HadronVec.Theta();
-      }
-
-
-      // Get Initial Proton Kinitmatics 
-      //   CURRENTLY GSimple flux files drop information about 
-      //   the initial state proton, but that this 
-      TLorentzVector ProtonVec;
-      double ProtonMass = 0.9382720;
-      double ProtonPx = 0;
-      double ProtonPy = 0;
-      double ProtonPz = 8.89; //GeV
-      double ProtonE  = sqrt(ProtonPx*ProtonPx +
-                             ProtonPy*ProtonPy +
-                             ProtonPz*ProtonPz +
-                             ProtonMass*ProtonMass);
-      ProtonVec.SetPxPyPzE(ProtonPx,ProtonPy,ProtonPz,ProtonE);
+    // Get Initial Proton Kinitmatics 
+    //   CURRENTLY GSimple flux files drop information about 
+    //   the initial state proton, but that this 
+    TLorentzVector ProtonVec;
+    double ProtonMass = 0.9382720;
+    double ProtonPx = 0;
+    double ProtonPy = 0;
+    double ProtonPz = 8.89; //GeV
+    double ProtonE  = sqrt(ProtonPx*ProtonPx +
+			   ProtonPy*ProtonPy +
+			   ProtonPz*ProtonPz +
+			   ProtonMass*ProtonMass);
+    ProtonVec.SetPxPyPzE(ProtonPx,ProtonPy,ProtonPz,ProtonE);
       
-      //Sanford-Wang Parameterization 
-      //  Eq 11 from PhysRevD.79.072002
+    //Sanford-Wang Parameterization 
+    //  Eq 11 from PhysRevD.79.072002
 
-      double CV = c1 * pow(HadronVec.P(), c2) * 
-	(1. - HadronVec.P()/(ProtonVec.P() - c9)) *
-	exp(-1. * c3 * pow(HadronVec.P(), c4) / pow(ProtonVec.P(), c5)) *
-	exp(-1. * c6 * ThetaOfInterest *(HadronVec.P() - c7 * ProtonVec.P() * pow(cos(ThetaOfInterest), c8)));
+    double CV = c1 * pow(HadronP, c2) * 
+      (1. - HadronP/(ProtonVec.P() - c9)) *
+      exp(-1. * c3 * pow(HadronP, c4) / pow(ProtonVec.P(), c5)) *
+      exp(-1. * c6 * ThetaOfInterest *(HadronP - c7 * ProtonVec.P() * pow(cos(ThetaOfInterest), c8)));
 
-      // Check taken from MiniBooNE code
-      if(float(HadronVec.P()) > (float(ProtonVec.P()) - float(c9))){
+    // Check taken from MiniBooNE code
+    if(floatGuard){
+      if(float(HadronP) > (float(ProtonVec.P()) - float(c9))){
 	CV = 0;} 
+    }
+    else{
+      //  JZ (6/2017) : Changed guards on c9 to be double point precision 
+      if((HadronP) > ((ProtonVec.P()) - (c9))){
+	CV = 0;} 
+    }
 
-      //////
-      //
-      // Now that we have our central value based on the Sanford-Wang parameterization we 
-      // need to create variations around this value. MiniBooNE did this by performing 
-      // spline fits to the HARP data. This is a reproduction of that code:
-      // 
-      ////
-
-      double* HARPmomentumBins = HARPmomentumBounds.data(); // Convert std::vector to array
-      double* HARPthetaBins = HARPthetaBounds.data();       // Convert std::vector to array
-
-      int Ntbins = int(HARPthetaBounds.size()) - 1;
-      int Npbins = int(HARPmomentumBounds.size()) - 1;
-      
-      //
-      //  Using the HARP cross section and covariance matrices 
-      //  we will now create variations around the measured HARP
-      //  meson production cross sections. 
-      //
-      
-      // Important notes of the HARP data: 
-      //  The cross section matrix has 13 momentum bins and 6 theta bins 
-      //  The covariance matrix contains the correlated uncertainties across
-      //  all 78 cross section measurements. 
-      //
-      //  The covariance matrix encodes the uncertainty on a given HARP 
-      //  ANALYSIS BIN instead of being a 3D matrix. 
-      //
-      //  A HARP analysis bin is defined as 
-      //  bin = momentum[theta[]] meaning that:
-      //      analysis bin 0 is the zeroth theta and zeroth momentum bin
-      //  but analysis bin 27 is the 3rd theta and 5th momentum bin
-      // 
-      // The first thing to do is convert our cross section matrix into 
-      // an std::vector for the analysis bins
-      //
-      std::vector< double > HARPCrossSectionAnalysisBins;
-      HARPCrossSectionAnalysisBins.resize(int(Ntbins*Npbins));
-
-      int anaBin = 0;
-      for(int pbin = 0; pbin < Npbins; pbin++){
-	for(int tbin = 0; tbin < Ntbins; tbin++){	
-	  HARPCrossSectionAnalysisBins[anaBin] = HARPXSec[0][pbin][tbin];
-	  anaBin++;
-	}
-      }
-      
-      //
-      // Now using this we can vary the cross section based on the HARP covariance matrix 
-      // this will allow us to reweigh each cross section measurement based on
-      // the multigaussian smearing of this matrix. 
-      //
-
-      std::vector< double > smearedHARPCrossSectionAnalysisBins = 
-	WeightCalc::MultiGaussianSmearing(HARPCrossSectionAnalysisBins, HARPLowerTriangluarCov, fIsDecomposed,rand); 
-      HARPCrossSectionAnalysisBins.clear();
-
-      //
-      //   Check all the smeared cross sections, if any come out to be negative then 
-      //   we will not pass this given parameter set.
-      //
-
-      for(int check = 0; check < int(smearedHARPCrossSectionAnalysisBins.size()); check++){
-	if(smearedHARPCrossSectionAnalysisBins[check] < 0){ parameters_pass = false;}
-      }
+    return CV;
+  }
 
-      //  
-      // With a checked set of smeared cross sections we can convert our analysis bin
-      // std::vector back into a TMatrixD, though this is a bit annoying since TMatrices 
-      // are an annoying format. 
-      //
-      TMatrixD*  smearedHARPXSec = new TMatrixD(Npbins,Ntbins);
-      
-      anaBin = 0;
+  //// 
+  //   Smeared HARP cross section of a universe at the meson's kinematics,
+  //   from the basis vectors computed for this event
+  ////
+  double PrimaryHadronSWCentralSplineVariationWeightCalc::SmearedCrossSection(unsigned int universe){
+    const std::vector<double>& xsec = fSmearedXSec.at(universe);
+    int Npbins = int(fMomentumBasis.size());
+    int Ntbins = int(fThetaBasis.size());
+
+    double RW = 0;
+    for(int tbin = 0; tbin < Ntbins; tbin++){
+      const double* slice = &xsec[tbin*Npbins];
+      double sliceAtP = 0;
       for(int pbin = 0; pbin < Npbins; pbin++){
-	  for(int tbin = 0; tbin < Ntbins; tbin++){
-	  smearedHARPXSec[0][pbin][tbin] = smearedHARPCrossSectionAnalysisBins[anaBin];	  
-	  anaBin++;
-	}
-      }
-
-      //
-      // We want to now make a vector of histograms that are 
-      //  projections across the cross section matrix, 
-      //  this means we want to have vectors where one histogram 
-      //  is made for each bin on variable X where the histogram
-      //  then contains bins for variable Y. 
-      //
-      //  This will allow us to do a 2D interpolation across the
-      //  full parameter space using cubic spline fits 
-      //
-
-      //Setup vectors of splines for fitting
-      std::vector< TSpline3 > SplinesVsMomentum; 
-      SplinesVsMomentum.resize(Ntbins);
-
-      for(int tbin = 0; tbin < Ntbins; tbin++){
-	  for(int pbin = 0; pbin < Npbins; pbin++){
-	
-	    //
-	    // We want to create spline at fixed theta values, that way we can 
-	    // study the cross section at the given meson momentum
-	    fMomentumBins[tbin].SetBinContent(pbin+1, smearedHARPXSec[0][pbin][tbin]);		    
-	    // This will give us the cross section in discreet slices of theta (tbin)
-	    // but each histogram in the vector will be the cross section in bins of
-	    // momentum that can then be cublic splined  
-	    //
-	  }
-	
-	  //
-	  // in a given theta slice we can now spline over the cross section entries
-	  // in bins of momentum
-	  //
-	  // Important note about Splines, MiniBooNE used constraints on the
-	  // second derivative of the first and final knot point and required 
-	  // that they both equal to zero, this is not naturally the case in 
-	  // in TSpline3 but it is default in DCSPLC (the Fortran CERN library spline function)
-	  // this helps to control the smoothness of the spline and minimizes the variation bin to bin
-	  // For TSpine3 this is controlled by:
-	  //
-	  //  b1 = constrain first knot 1st derivative 
-	  //  b2 = constrain first knot 2nd derivative 
-	  //  e1 = constrain final knot 1st derivative 
-	  //  e2 = constrain final knot 2nd derivative 
-	  //
-	  //  the numbers that follow are the values you constrain those conditions to
-	  //
-	  SplinesVsMomentum[tbin] = TSpline3(&(fMomentumBins[tbin]),"b2e2",0,0); 
-
+	sliceAtP += fMomentumBasis[pbin]*slice[pbin];
       }
+      // The theta spline was fit to a TH1F, which stores floats
+      RW += fThetaBasis[tbin]*float(sliceAtP);
+    }
+    return RW;
+  }
 
-      delete smearedHARPXSec;
-      //
-      // Now that we have the 1D Splines over momentum we want to know
-      // what the cross section is for the meson's momentum in bins of
-      // theta that way we can extract the cross section at the meson's
-      // theta. 
-      //
-      for(int tbin = 0; tbin < Ntbins; tbin++){
-	fThetaBins->SetBinContent(tbin+1, SplinesVsMomentum[tbin].Eval(HadronVec.P()));
-      } 
-
-      ////      
-      // Now we can spline across the theta bins and we can extract the exact value of the 
-      // cross section for the meson's theta value
-      //
-      //  Options described above.
-      /////
-
-      TSpline3* FinalSpline = new TSpline3(fThetaBins,"b2e2",0,0);
-
-      double RW = FinalSpline->Eval(ThetaOfInterest);
-
-      SplinesVsMomentum.clear();
-
-      delete FinalSpline;
-
+  //// 
+  //   Use the MiniBooNE Implementation to determine the weight 
+  ////
+  double PrimaryHadronSWCentralSplineVariationWeightCalc::MiniBooNEWeightCalc(double RW, double CV){
       //
       // These guards are inherited from MiniBooNE code
       //
@@ -559,16 +611,13 @@ namespace evwgh {
       //              miniboone/AnalysisFramework/MultisimMatrix/src/MultisimMatrix.inc    
       //
       //  This forces any negative spline fit to be 1     
-
       ////////
       //  Possible Bug.
       ////////     
       // This seems to be a feature in the MiniBooNE code
       //  It looks like the intension is to set this to zero
       //  but it is set to 1 before it is set to zero  
-
       double weight = 1; 
-
       if(RW < 0 || CV < 0){
 	weight = 1;
       }
@@ -578,281 +627,26 @@ namespace evwgh {
       else{
 	weight *= RW/CV;
       }
-
       if(weight < 0) weight = 0; 
       if(weight > 30) weight = 30;
       if(!(std::isfinite(weight))) weight = 30;//From MiniBooNE; in Fortran Nan > 30
-     
-      std::pair<bool, double> output(parameters_pass, weight);
-
-      return output; 
-
+      return weight; 
   }// Done with the MiniBooNE function
 
-
   //// 
   //   Use the MicroBooNE Implementation to determine the weight 
   ////
-  std::pair<bool, double> PrimaryHadronSWCentralSplineVariationWeightCalc::MicroBooNEWeightCalc(event& e, std::vector<double> rand){
-
-    // 
-    //  Largely built off the MiniBooNE code 
-    //  but this is intended to expand beyond it
-    //
-    //  Edits from MiniBooNE code:
-    //
-    //  JZ (6/2017) : Remove max weight, set to max_limit of a double
-    //  JZ (6/2017) : Changed guards on c9 to be double point precision 
-    //   
-    
-    bool parameters_pass = true;
-    
-    double c1 = SWParam[0];
-    double c2 = SWParam[1];
-    double c3 = SWParam[2];
-    double c4 = SWParam[3];
-    double c5 = SWParam[4];
-    double c6 = SWParam[5];
-    double c7 = SWParam[6];
-    double c8 = SWParam[7];
-    double c9 = 1.0; // This isn't in the table but it is described in the text
-    
-    //  Lay out the event kinimatics 
-    double HadronMass;
-      
-      if(fabs(fprimaryHad) == 211) HadronMass = 0.13957010; //Charged Pion
-      else{ 
-	throw std::invalid_argument(" sanford-wang is only configured for charged pions ");
-      }
-
-      TLorentzVector HadronVec; 
-      double HadronPx = e.tpx;
-      double HadronPy = e.tpy;
-      double HadronPz = e.tpz;
-      double HadronE  = sqrt(HadronPx*HadronPx + 
-			     HadronPy*HadronPy + 
-			     HadronPz*HadronPz + 
-			     HadronMass*HadronMass);
-      HadronVec.SetPxPyPzE(HadronPx,HadronPy,HadronPz,HadronE);
-
-      ////////
-      //  
-      //   Based on MiniBooNE code to evaluate the theta value within below the maximum 
-      //    HARP theta coverage. This helps keep the splines well formed and constrains  
-      //    the uncertainties at very low neutrino energy
-      //
-      ////////
-
-      double ThetaOfInterest;
-      if(HadronVec.Theta() > 0.195){
-	ThetaOfInterest = 0.195;
-      }
-      else{
-	ThetaOfInterest = HadronVec.Theta();
-      }
-
-
-      // Get Initial Proton Kinitmatics 
-      //   CURRENTLY GSimple flux files drop information about 
-      //   the initial state proton, but that this 
-      TLorentzVector ProtonVec;
-      double ProtonMass = 0.9382720;
-      double ProtonPx = 0;
-      double ProtonPy = 0;
-      double ProtonPz = 8.89; //GeV
-      double ProtonE  = sqrt(ProtonPx*ProtonPx +
-                             ProtonPy*ProtonPy +
-                             ProtonPz*ProtonPz +
-                             ProtonMass*ProtonMass);
-      ProtonVec.SetPxPyPzE(ProtonPx,ProtonPy,ProtonPz,ProtonE);
-      
-      //Sanford-Wang Parameterization 
-      //  Eq 11 from PhysRevD.79.072002
-
-      double CV = c1 * pow(HadronVec.P(), c2) * 
-	(1. - HadronVec.P()/(ProtonVec.P() - c9)) *
-	exp(-1. * c3 * pow(HadronVec.P(), c4) / pow(ProtonVec.P(), c5)) *
-	exp(-1. * c6 * ThetaOfInterest *(HadronVec.P() - c7 * ProtonVec.P() * pow(cos(ThetaOfInterest), c8)));
-
-      // Check taken from MiniBooNE code
-      if((HadronVec.P()) > ((ProtonVec.P()) - (c9))){
-	CV = 0;} 
-
-      //////
-      //
-      // Now that we have our central value based on the Sanford-Wang parameterization we 
-      // need to create variations around this value. MiniBooNE did this by performing 
-      // spline fits to the HARP data. This is a reproduction of that code:
+  double PrimaryHadronSWCentralSplineVariationWeightCalc::MicroBooNEWeightCalc(double RW, double CV){
       // 
-      ////
-
-      double* HARPmomentumBins = HARPmomentumBounds.data(); // Convert std::vector to array
-      double* HARPthetaBins = HARPthetaBounds.data();       // Convert std::vector to array
-
-      int Ntbins = int(HARPthetaBounds.size()) - 1;
-      int Npbins = int(HARPmomentumBounds.size()) - 1;
-      
-      //
-      //  Using the HARP cross section and covariance matrices 
-      //  we will now create variations around the measured HARP
-      //  meson production cross sections. 
-      //
-      
-      // Important notes of the HARP data: 
-      //  The cross section matrix has 13 momentum bins and 6 theta bins 
-      //  The covariance matrix contains the correlated uncertainties across
-      //  all 78 cross section measurements. 
-      //
-      //  The covariance matrix encodes the uncertainty on a given HARP 
-      //  ANALYSIS BIN instead of being a 3D matrix. 
-      //
-      //  A HARP analysis bin is defined as 
-      //  bin = momentum[theta[]] meaning that:
-      //      analysis bin 0 is the zeroth theta and zeroth momentum bin
-      //  but analysis bin 27 is the 3rd theta and 5th momentum bin
-      // 
-      // The first thing to do is convert our cross section matrix into 
-      // an std::vector for the analysis bins
-      //
-
-      std::vector< double > HARPCrossSectionAnalysisBins;
-      HARPCrossSectionAnalysisBins.resize(int(Ntbins*Npbins));
-
-      int anaBin = 0;
-      for(int pbin = 0; pbin < Npbins; pbin++){
-	for(int tbin = 0; tbin < Ntbins; tbin++){	
-	  HARPCrossSectionAnalysisBins[anaBin] = HARPXSec[0][pbin][tbin];
-	  anaBin++;
-	}
-      }
-      
-      //
-      // Now using this we can vary the cross section based on the HARP covariance matrix 
-      // this will allow us to reweigh each cross section measurement based on
-      // the multigaussian smearing of this matrix. 
-      //
-      std::vector< double > smearedHARPCrossSectionAnalysisBins = 
-	WeightCalc::MultiGaussianSmearing(HARPCrossSectionAnalysisBins, HARPLowerTriangluarCov, fIsDecomposed,rand); 
-      HARPCrossSectionAnalysisBins.clear();
-
-      //
-      //   Check all the smeared cross sections, if any come out to be negative then 
-      //   we will not pass this given parameter set.
-      //
-
-      for(int check = 0; check < int(smearedHARPCrossSectionAnalysisBins.size()); check++){
-	if(smearedHARPCrossSectionAnalysisBins[check] < 0){ parameters_pass = false;}
-      }
-
-      //  
-      // With a checked set of smeared cross sections we can convert our analysis bin
-      // std::vector back into a TMatrixD, though this is a bit annoying since TMatrices 
-      // are an annoying format. 
-      //
-      TMatrixD*  smearedHARPXSec = new TMatrixD(Npbins,Ntbins);
-      
-      anaBin = 0;
-      for(int pbin = 0; pbin < Npbins; pbin++){
-	  for(int tbin = 0; tbin < Ntbins; tbin++){
-	  smearedHARPXSec[0][pbin][tbin] = smearedHARPCrossSectionAnalysisBins[anaBin];	  
-	  anaBin++;
-	}
-      }
-
-      //
-      // We want to now make a vector of histograms that are 
-      //  projections across the cross section matrix, 
-      //  this means we want to have vectors where one histogram 
-      //  is made for each bin on variable X where the histogram
-      //  then contains bins for variable Y. 
+      //  Largely built off the MiniBooNE code 
+      //  but this is intended to expand beyond it
       //
-      //  This will allow us to do a 2D interpolation across the
-      //  full parameter space using cubic spline fits 
+      //  Edits from MiniBooNE code:
       //
-      
-      //Setup vectors of splines for fitting
-      std::vector< TSpline3 > SplinesVsMomentum; 
-      SplinesVsMomentum.resize(Ntbins);
-
-      for(int tbin = 0; tbin < Ntbins; tbin++){
-	  for(int pbin = 0; pbin < Npbins; pbin++){
-	
-	    //
-	    // We want to create spline at fixed theta values, that way we can 
-	    // study the cross section at the given meson momentum
-	    fMomentumBins[tbin].SetBinContent(pbin+1, smearedHARPXSec[0][pbin][tbin]);		    
-	    // This will give us the cross section in discreet slices of theta (tbin)
-	    // but each histogram in the vector will be the cross section in bins of
-	    // momentum that can then be cublic splined  
-	    //
-	  }
-	
-	  //
-	  // in a given theta slice we can now spline over the cross section entries
-	  // in bins of momentum
-	  //
-	  // Important note about Splines, MiniBooNE used constraints on the
-	  // second derivative of the first and final knot point and required 
-	  // that they both equal to zero, this is not naturally the case in 
-	  // in TSpline3 but it is default in DCSPLC (the Fortran CERN library spline function)
-	  // this helps to control the smoothness of the spline and minimizes the variation bin to bin
-	  // For TSpine3 this is controlled by:
-	  //
-	  //  b1 = constrain first knot 1st derivative 
-	  //  b2 = constrain first knot 2nd derivative 
-	  //  e1 = constrain final knot 1st derivative 
-	  //  e2 = constrain final knot 2nd derivative 
-	  //
-	  //  the numbers that follow are the values you constrain those conditions to
-	  //
-	  SplinesVsMomentum[tbin] = TSpline3(&(fMomentumBins[tbin]),"b2e2",0,0); 
-
-      }
-      //      fMomentumBins.clear();
-      delete smearedHARPXSec;
-      //
-      // Now that we have the 1D Splines over momentum we want to know
-      // what the cross section is for the meson's momentum in bins of
-      // theta that way we can extract the cross section at the meson's
-      // theta. 
-      //
-      for(int tbin = 0; tbin < Ntbins; tbin++){
-	fThetaBins->SetBinContent(tbin+1, SplinesVsMomentum[tbin].Eval(HadronVec.P()));
-      } 
-
-      ////      
-      // Now we can spline across the theta bins and we can extract the exact value of the 
-      // cross section for the meson's theta value
-      //
-      //  Options described above.
-      /////
-      TSpline3* FinalSpline = new TSpline3(fThetaBins,"b2e2",0,0);
-
-      double RW = FinalSpline->Eval(ThetaOfInterest);
-
-      SplinesVsMomentum.clear();
-
-      delete FinalSpline;
-
-      //
-      // These guards are inherited from MiniBooNE code
-      //
-      // These were defined here: 
-      // 
-      //   cdcvs0.fnal.gov/cgi-bin/public-cvs/cvsweb-public.cgi/~checkout~/ ... 
-      //              miniboone/AnalysisFramework/MultisimMatrix/src/MultisimMatrix.inc    
-      //
-      //  This forces any negative spline fit to be 1     
-
-      ////////
-      //  Possible Bug.
-      ////////     
-      // This seems to be a feature in the MiniBooNE code
-      //  It looks like the intension is to set this to zero
-      //  but it is set to 1 before it is set to zero  
-
+      //  JZ (6/2017) : Remove max weight, set to max_limit of a double
+      //  JZ (6/2017) : Changed guards on c9 to be double point precision 
+      //   
       double weight = 1; 
-
       if(RW < 0 || CV < 0){
 	weight = 1;
       }
@@ -862,21 +656,15 @@ namespace evwgh {
       else{
 	weight *= RW/CV;
       }
-
       if(weight < 0) weight = 0; 
       if(weight > 30) weight = 30; 
       if(!(std::isfinite(weight))){
 	std::cout << "SW+Splines : Failed to get a finite weight" << std::endl; 	
 	weight = 30;
       }
-
-      std::pair<bool, double> output(parameters_pass, weight);
-
-      return output; 
-
+      return weight; 
   }// Done with the MicroBooNE function
 
-
   //// 
   //  This converts TArrayD to std::vector< double > 
   ///
@@ -1,4 +1,7 @@
 #include "ReweightFlux.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(ReweightFlux);
 
 ReweightFlux::ReweightFlux():Tool(){}
 
@@ -14,6 +17,22 @@ bool ReweightFlux::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("Verbosity",verbosity);
   m_variables.Get("weight_functions_flux",weight_options);
 
+  fBatchSize = 1;
+  m_variables.Get("BatchSize",fBatchSize);
+  if(fBatchSize > 1){
+    if(!m_variables.Get("WeightsOutputFile",fWeightsFileName)){
+      logmessage = "ReweightFlux: BatchSize > 1 needs a WeightsOutputFile to write the weights to";
+      Log(logmessage,v_error,verbosity);
+      return false;
+    }
+    fWeightsFile.open(fWeightsFileName, std::ios::binary | std::ios::trunc);
+    if(!fWeightsFile.good()){
+      logmessage = "ReweightFlux: could not open WeightsOutputFile "+fWeightsFileName;
+      Log(logmessage,v_error,verbosity);
+      return false;
+    }
+  }
+
   //parse and tokenize array of strings that list weights
   std::stringstream weights_in(weight_options);
   std::string temp;
@@ -171,7 +190,7 @@ bool ReweightFlux::Initialise(std::string configfile, DataModel &data){
 }
 
 
-bool ReweightFlux::Execute(){
+void ReweightFlux::FillEvent(evwgh::event &e){
   // Get the flux info
   // =======================================================
 
@@ -183,33 +202,33 @@ bool ReweightFlux::Execute(){
   int fluxrun, fluxentryno, fluxevtno, fluxntype;
   double fluxnimpwt, fluxnenergyn, fluxnenergyf;
 
-  bool get_pdg = m_data->Stores["GenieInfo"]->Get("ParentPdg",parentpdg);
-  bool get_decay_mode = m_data->Stores["GenieInfo"]->Get("ParentDecayMode",parentdecaymode);
-  bool get_decay_vx = m_data->Stores["GenieInfo"]->Get("ParentDecayVtx_X",parentdecayvtx_x);
-  bool get_decay_vy = m_data->Stores["GenieInfo"]->Get("ParentDecayVtx_Y",parentdecayvtx_y);
-  bool get_decay_vz = m_data->Stores["GenieInfo"]->Get("ParentDecayVtx_Z",parentdecayvtx_z);
-  bool get_decay_px = m_data->Stores["GenieInfo"]->Get("ParentDecayMom_X",parentdecaymom_x);
-  bool get_decay_py = m_data->Stores["GenieInfo"]->Get("ParentDecayMom_Y",parentdecaymom_y);
-  bool get_decay_pz = m_data->Stores["GenieInfo"]->Get("ParentDecayMom_Z",parentdecaymom_z);
-  bool get_prod_px = m_data->Stores["GenieInfo"]->Get("ParentProdMom_X",parentprodmom_x);
-  bool get_prod_py = m_data->Stores["GenieInfo"]->Get("ParentProdMom_Y",parentprodmom_y);
-  bool get_prod_pz = m_data->Stores["GenieInfo"]->Get("ParentProdMom_Z",parentprodmom_z);
-  bool get_medium = m_data->Stores["GenieInfo"]->Get("ParentProdMedium",parentprodmedium);
-  bool get_tgt_pdg = m_data->Stores["GenieInfo"]->Get("ParentPdgAtTgtExit",parentpdgattgtexit);
-  bool get_tgt_px = m_data->Stores["GenieInfo"]->Get("ParentTgtExitMom_X",parenttgtexitmom_x);
-  bool get_tgt_py = m_data->Stores["GenieInfo"]->Get("ParentTgtExitMom_Y",parenttgtexitmom_y);
-  bool get_tgt_pz = m_data->Stores["GenieInfo"]->Get("ParentTgtExitMom_Z",parenttgtexitmom_z);
-  bool get_entryno = m_data->Stores["GenieInfo"]->Get("ParentEntryNo",fluxentryno);
-  bool get_run = m_data->Stores["GenieInfo"]->Get("ParentRunNo",fluxrun);
-  bool get_energyn = m_data->Stores["GenieInfo"]->Get("ParentNEnergyN",fluxnenergyn);
-  bool get_energyf = m_data->Stores["GenieInfo"]->Get("ParentNEnergyF",fluxnenergyf);
-  bool get_evtno = m_data->Stores["GenieInfo"]->Get("ParentEventNo",fluxevtno);
-  bool get_ntype = m_data->Stores["GenieInfo"]->Get("ParentNType",fluxntype);
-  bool get_wgt = m_data->Stores["GenieInfo"]->Get("ParentWgt",fluxnimpwt);
+  BoostStore* GenieInfo = m_data->Stores["GenieInfo"];
+  bool get_pdg = GenieInfo->Get("ParentPdg",parentpdg);
+  bool get_decay_mode = GenieInfo->Get("ParentDecayMode",parentdecaymode);
+  bool get_decay_vx = GenieInfo->Get("ParentDecayVtx_X",parentdecayvtx_x);
+  bool get_decay_vy = GenieInfo->Get("ParentDecayVtx_Y",parentdecayvtx_y);
+  bool get_decay_vz = GenieInfo->Get("ParentDecayVtx_Z",parentdecayvtx_z);
+  bool get_decay_px = GenieInfo->Get("ParentDecayMom_X",parentdecaymom_x);
+  bool get_decay_py = GenieInfo->Get("ParentDecayMom_Y",parentdecaymom_y);
+  bool get_decay_pz = GenieInfo->Get("ParentDecayMom_Z",parentdecaymom_z);
+  bool get_prod_px = GenieInfo->Get("ParentProdMom_X",parentprodmom_x);
+  bool get_prod_py = GenieInfo->Get("ParentProdMom_Y",parentprodmom_y);
+  bool get_prod_pz = GenieInfo->Get("ParentProdMom_Z",parentprodmom_z);
+  bool get_medium = GenieInfo->Get("ParentProdMedium",parentprodmedium);
+  bool get_tgt_pdg = GenieInfo->Get("ParentPdgAtTgtExit",parentpdgattgtexit);
+  bool get_tgt_px = GenieInfo->Get("ParentTgtExitMom_X",parenttgtexitmom_x);
+  bool get_tgt_py = GenieInfo->Get("ParentTgtExitMom_Y",parenttgtexitmom_y);
+  bool get_tgt_pz = GenieInfo->Get("ParentTgtExitMom_Z",parenttgtexitmom_z);
+  bool get_entryno = GenieInfo->Get("ParentEntryNo",fluxentryno);
+  bool get_run = GenieInfo->Get("ParentRunNo",fluxrun);
+  bool get_energyn = GenieInfo->Get("ParentNEnergyN",fluxnenergyn);
+  bool get_energyf = GenieInfo->Get("ParentNEnergyF",fluxnenergyf);
+  bool get_evtno = GenieInfo->Get("ParentEventNo",fluxevtno);
+  bool get_ntype = GenieInfo->Get("ParentNType",fluxntype);
+  bool get_wgt = GenieInfo->Get("ParentWgt",fluxnimpwt);
 	
 
   // ======== flux info ========
-  evwgh::event e;
   e.entryno = fluxentryno;
   e.run = fluxrun;
   e.nenergyn = fluxnenergyn;
@@ -239,6 +258,18 @@ bool ReweightFlux::Execute(){
 
   //Fill Ndecay (check parent type, neutrino type and if it is a 2 or 3 body decay)
   e.ndecay = parentdecaymode;
+}
+
+
+bool ReweightFlux::Execute(){
+  evwgh::event e;
+  FillEvent(e);
+
+  if(fBatchSize > 1){
+    fEventBlock.push_back(e);
+    if(int(fEventBlock.size()) >= fBatchSize) return WriteBlock();
+    return true;
+  }
 
   //Run flux reweighting
   evwgh::MCEventWeight wght=wm.Run(e,0);
@@ -249,7 +280,52 @@ bool ReweightFlux::Execute(){
 }
 
 
+bool ReweightFlux::WriteBlock(){
+  if(fEventBlock.size() == 0) return true;
+
+  //Run flux reweighting for the whole block
+  wm.RunBlock(fEventBlock,fWeightBlocks);
+
+  // The first block starts with the file header: the calculator names, in
+  // the order their weight arrays appear in every block
+  if(fWeightsFile.tellp() == 0){
+    fWeightsFile.write("FLUXWGT1",8);
+    uint32_t ncalcs = fWeightBlocks.size();
+    fWeightsFile.write(reinterpret_cast<const char*>(&ncalcs),sizeof(ncalcs));
+    for(auto const& calc : fWeightBlocks){
+      uint32_t length = calc.first.size();
+      fWeightsFile.write(reinterpret_cast<const char*>(&length),sizeof(length));
+      fWeightsFile.write(calc.first.data(),length);
+    }
+  }
+
+  uint32_t nevents = fEventBlock.size();
+  fWeightsFile.write(reinterpret_cast<const char*>(&nevents),sizeof(nevents));
+  fWeightsFile.write(reinterpret_cast<const char*>(fEventBlock.run.data()),nevents*sizeof(int));
+  fWeightsFile.write(reinterpret_cast<const char*>(fEventBlock.evtno.data()),nevents*sizeof(int));
+  fWeightsFile.write(reinterpret_cast<const char*>(fEventBlock.entryno.data()),nevents*sizeof(int));
+  for(auto const& calc : fWeightBlocks){
+    const evwgh::WeightBlock& block = calc.second;
+    fWeightsFile.write(reinterpret_cast<const char*>(block.offsets.data()),block.offsets.size()*sizeof(uint32_t));
+    fWeightsFile.write(reinterpret_cast<const char*>(block.weights.data()),block.weights.size()*sizeof(float));
+  }
+
+  fEventBlock.clear();
+
+  if(!fWeightsFile.good()){
+    logmessage = "ReweightFlux: failed to write weights to "+fWeightsFileName;
+    Log(logmessage,v_error,verbosity);
+    return false;
+  }
+  return true;
+}
+
+
 bool ReweightFlux::Finalise(){
+  if(fBatchSize > 1){
+    WriteBlock();
+    fWeightsFile.close();
+  }
   if(verbosity > 0) std::cout << "Completed Flux Reweighting" << std::endl;
   return true;
 }
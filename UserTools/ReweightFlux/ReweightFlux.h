@@ -106,6 +106,9 @@ class ReweightFlux: public Tool {
   bool Execute(); ///< Execute function used to perform Tool purpose.
   bool Finalise(); ///< Finalise function used to clean up resources.
 
+  void FillEvent(evwgh::event &e); ///< Get the flux info of this event from the GenieInfo store
+  bool WriteBlock(); ///< Reweight the collected block of events and write the weights to the output file
+
   // verbosity levels: if 'verbosity' < this level, the message type will be logged.
   int verbosity;
   int v_error=0;
@@ -124,6 +127,14 @@ class ReweightFlux: public Tool {
   vector<evwgh::fluxconfig> fconfig_funcs;
   evwgh::WeightManager wm;
 
+  // Batched mode: events are collected into blocks of fBatchSize and
+  // their weights written to fWeightsFileName, one float array per calculator
+  int fBatchSize;
+  std::string fWeightsFileName;
+  std::ofstream fWeightsFile;
+  evwgh::EventBlock fEventBlock;
+  std::map<std::string, evwgh::WeightBlock> fWeightBlocks;
+
 };
 
 
@@ -11,6 +11,18 @@
 #include "CLHEP/Random/RandGaussQ.h"
 
 namespace evwgh { 
+  void WeightCalc::GetWeightBlock(EventBlock const& block, WeightBlock& weights)
+  {
+    weights.clear();
+    for(size_t i = 0; i < block.size(); ++i)
+      {
+	event e = block.at(i);
+	std::vector<std::vector<double> > w = GetWeight(e);
+	if(w.empty()) weights.offsets.push_back(weights.weights.size());
+	else weights.Append(w[0].begin(), w[0].end());
+      }
+  }
+
   std::vector<std::vector<double> > WeightCalc::MultiGaussianSmearing(std::vector<double> const& centralValue,std::vector< std::vector<double> > const& inputCovarianceMatrix,int n_multisims,CLHEP::RandGaussQ& GaussRandom)
   {
 
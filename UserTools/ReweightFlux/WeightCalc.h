@@ -23,6 +23,16 @@ namespace evwgh {
   public:
     virtual void                Configure(fluxconfig p) = 0;
     virtual std::vector<std::vector<double> > GetWeight(event & e) = 0; 
+
+    /**
+     * @brief Weights of the first neutrino for every event in a block
+     * @param block the flux kinematics of the events
+     * @param weights cleared and filled with one entry per event
+     *
+     * The default calls GetWeight for each event. Calculators can override
+     * it to work through the columns directly.
+     */
+    virtual void                GetWeightBlock(EventBlock const& block, WeightBlock& weights);
     void                        SetName(std::string name) {fName=name;}
     std::string                 GetName() {return fName;}
     
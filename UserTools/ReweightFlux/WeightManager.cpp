@@ -93,6 +93,20 @@ namespace evwgh {
 
 
 
+  void WeightManager::RunBlock(EventBlock const& block, std::map<std::string, WeightBlock>& weights)
+  {
+
+    if (!_configured) {
+      std::cerr<< "WeightManager was not configured!"<<std::endl;
+      throw std::exception();
+    }
+
+    for (auto it = fWeightCalcMap.begin() ;it != fWeightCalcMap.end(); it++) {
+      it->second->GetWeightBlock(block, weights[it->first+"_"+it->second->fWeightCalcType]);
+    }
+  }
+
+
   void WeightManager::PrintConfig() {
     
     return; 
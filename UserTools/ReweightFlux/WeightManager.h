@@ -61,6 +61,14 @@ namespace evwgh {
      */
     MCEventWeight Run(event &e, const int inu);
 
+    /**
+      * @brief Batched version of Run for the first neutrino of each event
+      * @param block the flux kinematics of a block of events
+      * @param weights filled with one WeightBlock per calculator, keyed like
+      * the MCEventWeight map of Run ("title_type")
+     */
+    void RunBlock(EventBlock const& block, std::map<std::string, WeightBlock>& weights);
+
     /**
       * @brief Returns the map between calculator name and Weight_t product
       */
@@ -31,6 +31,20 @@ namespace evwgh {
       
       return wgh;
     }
+
+    void GetWeightBlock(EventBlock const& block, WeightBlock& weights) {
+      fWeightCalc->GetWeightBlock(block, weights);
+      for (size_t i=0;i<weights.size();i++) {
+	auto begin=weights.weights.begin()+weights.offsets[i];
+	auto end=weights.weights.begin()+weights.offsets[i+1];
+	if (begin==end) continue;
+	double avgwgh=std::accumulate(begin,end,0.0)/(end-begin);
+	fAvgWeight=(fAvgWeight*fNcalls+avgwgh)/float(fNcalls+1);
+	fMinWeight=std::min(fMinWeight,double(*std::min_element(begin,end)));
+	fMaxWeight=std::max(fMaxWeight,double(*std::max_element(begin,end)));
+	fNcalls++;
+      }
+    }
     std::string fName;
     WeightCalc* fWeightCalc;
     std::string fWeightCalcType;
@@ -1,4 +1,7 @@
 #include "RunValidation.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(RunValidation);
 
 RunValidation::RunValidation():Tool(){}
 
@@ -1,4 +1,11 @@
 #include "SaveANNIEEvent.h"
+#include "ToolRegistry.h"
+#include "ANNIEEventKeys.h"
+
+#include <fstream>
+#include <sstream>
+
+REGISTER_TOOL(SaveANNIEEvent);
 
 SaveANNIEEvent::SaveANNIEEvent():Tool(){}
 
@@ -13,14 +20,41 @@ bool SaveANNIEEvent::Initialise(std::string configfile, DataModel &data){
   /////////////////////////////////////////////////////////////////
 
   m_variables.Get("path", path);
+  m_variables.Get("verbose", verbosity);
+
+  std::string key_groups_file;
+  if(m_variables.Get("KeyGroupsFile", key_groups_file)){
+    if(!ReadKeyGroups(key_groups_file)) return false;
+  }
+
   return true;
 }
 
 
 bool SaveANNIEEvent::Execute(){
 
-  m_data->Stores["ANNIEEvent"]->Save(path);
-  m_data->Stores["ANNIEEvent"]->Delete();
+  BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+  bool mc_flag = annieeventkeys::IsMC(annie_event);
+
+  // Move the keys of each group into their own file, so that readers can
+  // skip them without decompressing them. Every group file gets one entry
+  // per ANNIEEvent entry to keep the entry numbers aligned.
+  for(auto& group : key_groups){
+    BoostStore* group_store = key_group_stores.at(group.first);
+    std::vector<std::string> key_directory;
+    for(auto& key : group.second){
+      if(!annieeventkeys::CopyKey(annie_event,group_store,key,mc_flag)) continue;
+      annie_event->Remove(key);
+      key_directory.push_back(key);
+    }
+    group_store->Set("KeyDirectory",key_directory);
+    group_store->Save(path+"."+group.first);
+    group_store->Delete();
+  }
+  if(key_groups.size()) annie_event->Header->Set("KeyGroups",key_groups);
+
+  annie_event->Save(path);
+  annie_event->Delete();
 
   return true;
 }
@@ -31,5 +65,48 @@ bool SaveANNIEEvent::Finalise(){
 
   m_data->Stores["ANNIEEvent"]->Close();
 
+  for(auto& group : key_group_stores){
+    group.second->Close();
+    delete group.second;
+  }
+  key_group_stores.clear();
+
+  return true;
+}
+
+bool SaveANNIEEvent::ReadKeyGroups(std::string key_groups_file){
+
+  // one group per line: groupname key1 key2 ...
+  std::ifstream infile(key_groups_file);
+  if(!infile.good()){
+    Log("SaveANNIEEvent: Could not open KeyGroupsFile "+key_groups_file,0,verbosity);
+    return false;
+  }
+
+  std::string line;
+  while(std::getline(infile,line)){
+    line = line.substr(0,line.find('#'));
+    std::stringstream ss(line);
+    std::string group, key;
+    if(!(ss >> group)) continue;
+    while(ss >> key){
+      if(!annieeventkeys::IsKnownKey(key)){
+        Log("SaveANNIEEvent: Key "+key+" of group "+group+" has no known type and can't be split off",0,verbosity);
+        return false;
+      }
+      if(key=="MCFlag"){
+        // readers need it in the ANNIEEvent to know the type of TDCData
+        Log("SaveANNIEEvent: Key MCFlag has to stay in the ANNIEEvent, it can't be part of group "+group,0,verbosity);
+        return false;
+      }
+      key_groups[group].push_back(key);
+    }
+  }
+
+  for(auto& group : key_groups){
+    key_group_stores[group.first] = new BoostStore(false,BOOST_STORE_MULTIEVENT_FORMAT);
+    Log("SaveANNIEEvent: Writing key group "+group.first+" to "+path+"."+group.first,1,verbosity);
+  }
+
   return true;
 }
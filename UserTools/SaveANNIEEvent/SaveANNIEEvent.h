@@ -3,6 +3,8 @@
 
 #include <string>
 #include <iostream>
+#include <map>
+#include <vector>
 
 #include "Tool.h"
 
@@ -20,7 +22,12 @@ class SaveANNIEEvent: public Tool {
  private:
   std::string path;
 
+  /// Optional split of heavy keys into separate files, one per group
+  bool ReadKeyGroups(std::string key_groups_file);
+  std::map<std::string,std::vector<std::string>> key_groups;
+  std::map<std::string,BoostStore*> key_group_stores;
 
+  int verbosity=0;
 
 
 };
@@ -1,4 +1,7 @@
 #include "SaveConfigInfo.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(SaveConfigInfo);
 
 SaveConfigInfo::SaveConfigInfo():Tool(){}
 
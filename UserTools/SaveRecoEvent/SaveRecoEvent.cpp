@@ -1,4 +1,7 @@
 #include "SaveRecoEvent.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(SaveRecoEvent);
 
 SaveRecoEvent::SaveRecoEvent():Tool(){}
 
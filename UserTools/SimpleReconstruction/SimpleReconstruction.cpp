@@ -1,4 +1,7 @@
 #include "SimpleReconstruction.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(SimpleReconstruction);
 
 SimpleReconstruction::SimpleReconstruction():Tool(){}
 
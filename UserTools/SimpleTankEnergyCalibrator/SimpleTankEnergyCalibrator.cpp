@@ -1,4 +1,7 @@
 #include "SimpleTankEnergyCalibrator.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(SimpleTankEnergyCalibrator);
 
 SimpleTankEnergyCalibrator::SimpleTankEnergyCalibrator():Tool(){}
 
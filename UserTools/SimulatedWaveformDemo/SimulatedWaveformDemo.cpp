@@ -1,5 +1,8 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "SimulatedWaveformDemo.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(SimulatedWaveformDemo);
 
 SimulatedWaveformDemo::SimulatedWaveformDemo():Tool(){}
 
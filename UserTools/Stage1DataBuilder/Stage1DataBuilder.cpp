@@ -1,4 +1,7 @@
 #include "Stage1DataBuilder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(Stage1DataBuilder);
 
 Stage1DataBuilder::Stage1DataBuilder():Tool(){}
 
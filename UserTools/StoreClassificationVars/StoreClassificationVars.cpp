@@ -1,4 +1,7 @@
 #include "StoreClassificationVars.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(StoreClassificationVars);
 
 StoreClassificationVars::StoreClassificationVars():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "StoreDecodedTimestamps.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(StoreDecodedTimestamps);
 
 StoreDecodedTimestamps::StoreDecodedTimestamps():Tool(){}
 
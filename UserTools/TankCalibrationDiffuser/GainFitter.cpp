@@ -0,0 +1,302 @@
+#include "GainFitter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+  typedef double Matrix[gainfit::kMaxPar][gainfit::kMaxPar];
+
+  // in-place Cholesky decomposition a = L L^T of the leading n x n block; false if not positive definite
+  bool Cholesky(Matrix a, int n){
+    for(int j=0; j<n; ++j){
+      double d = a[j][j];
+      for(int k=0; k<j; ++k) d -= a[j][k]*a[j][k];
+      if(!(d>0.)) return false;
+      a[j][j] = std::sqrt(d);
+      for(int i=j+1; i<n; ++i){
+        double s = a[i][j];
+        for(int k=0; k<j; ++k) s -= a[i][k]*a[j][k];
+        a[i][j] = s/a[j][j];
+      }
+    }
+    return true;
+  }
+
+  // solves L L^T x = b for a decomposed matrix, b is overwritten with x
+  void CholeskySolve(const Matrix l, int n, double* b){
+    for(int i=0; i<n; ++i){
+      for(int k=0; k<i; ++k) b[i] -= l[i][k]*b[k];
+      b[i] /= l[i][i];
+    }
+    for(int i=n-1; i>=0; --i){
+      for(int k=i+1; k<n; ++k) b[i] -= l[k][i]*b[k];
+      b[i] /= l[i][i];
+    }
+  }
+
+  struct Bins {
+    std::vector<double> x;
+    std::vector<double> y;
+  };
+
+  Bins SelectBins(const gainfit::Histogram& data, double xmin, double xmax, bool filled_only){
+    Bins bins;
+    for(size_t i=0; i<data.x.size() && i<data.y.size(); ++i){
+      if(data.x[i]<xmin || data.x[i]>xmax) continue;
+      if(filled_only && !(data.y[i]>0.)) continue;
+      bins.x.push_back(data.x[i]);
+      bins.y.push_back(data.y[i]);
+    }
+    return bins;
+  }
+
+  // chi2 of par, with J^T W J and J^T W r if jtj is given
+  double Chi2(gainfit::Model model, const gainfit::Parameters& par, const Bins& bins, Matrix jtj = nullptr, double* jtr = nullptr){
+    const int npar = model;
+    double grad[gainfit::kMaxPar];
+    if(jtj){
+      for(int i=0; i<npar; ++i){
+        jtr[i] = 0.;
+        for(int j=0; j<npar; ++j) jtj[i][j] = 0.;
+      }
+    }
+    double chi2 = 0.;
+    for(size_t b=0; b<bins.x.size(); ++b){
+      const double w = 1./bins.y[b];          // sigma^2 = content
+      const double r = bins.y[b]-gainfit::Evaluate(model,par,bins.x[b],jtj ? grad : nullptr);
+      chi2 += w*r*r;
+      if(!jtj) continue;
+      for(int i=0; i<npar; ++i){
+        jtr[i] += w*grad[i]*r;
+        for(int j=0; j<=i; ++j) jtj[i][j] += w*grad[i]*grad[j];
+      }
+    }
+    if(jtj){
+      for(int i=0; i<npar; ++i) for(int j=0; j<i; ++j) jtj[j][i] = jtj[i][j];
+    }
+    return chi2;
+  }
+
+  // the highest point of r in [first,last), its half-maximum width and the mean around it
+  void FindPeak(const std::vector<double>& x, const std::vector<double>& r, size_t first, size_t last,
+                double& height, double& mean, double& sigma){
+    height = 0.;
+    mean = 0.;
+    sigma = 0.;
+    if(first>=last) return;
+    size_t peak = first;
+    for(size_t i=first; i<last; ++i) if(r[i]>r[peak]) peak = i;
+    height = r[peak];
+    if(!(height>0.)) return;
+    size_t left = peak, right = peak;
+    while(left>first && r[left-1]>0.5*height) --left;
+    while(right+1<last && r[right+1]>0.5*height) ++right;
+    double sum = 0., sumx = 0.;
+    for(size_t i=left; i<=right; ++i){
+      sum += r[i];
+      sumx += r[i]*x[i];
+    }
+    const double width = (x.size()>1) ? std::fabs(x[1]-x[0]) : 1.;
+    mean = sumx/sum;
+    // FWHM of a Gaussian is 2.355 sigma, a peak narrower than a bin is one bin wide
+    sigma = std::max((x[right]-x[left]+width)/2.355,width/2.);
+  }
+
+}
+
+bool gainfit::ModelFromName(const std::string& name, Model& model){
+  if(name=="Gaus") model = kGaus;
+  else if(name=="Gaus2") model = kGaus2;
+  else if(name=="Gaus2Exp") model = kGaus2Exp;
+  else return false;
+  return true;
+}
+
+double gainfit::Evaluate(Model model, const Parameters& par, double x, double* grad){
+  double value = 0.;
+  const int ngaus = (model==kGaus) ? 1 : 2;
+  for(int g=0; g<ngaus; ++g){
+    const double c = par[3*g], m = par[3*g+1], s = par[3*g+2];
+    double e = 0., u = 0.;
+    if(s!=0.){
+      u = (x-m)/s;
+      e = std::exp(-0.5*u*u);
+    }
+    value += c*e;
+    if(grad){
+      grad[3*g] = e;
+      grad[3*g+1] = (s!=0.) ? c*e*u/s : 0.;
+      grad[3*g+2] = (s!=0.) ? c*e*u*u/s : 0.;
+    }
+  }
+  if(model==kGaus2Exp){
+    const double ex = std::exp(par[6]+par[7]*x);
+    value += ex;
+    if(grad){
+      grad[6] = ex;
+      grad[7] = x*ex;
+    }
+  }
+  return value;
+}
+
+gainfit::Parameters gainfit::Seed(Model model, const Histogram& data, double xmin, double xmax){
+
+  Parameters par{};
+  const Bins bins = SelectBins(data,xmin,xmax,false);
+  const size_t n = bins.x.size();
+  if(n==0){
+    par[2] = par[5] = 1.;
+    return par;
+  }
+
+  // first Gaussian: the highest peak
+  std::vector<double> r(bins.y);
+  FindPeak(bins.x,r,0,n,par[0],par[1],par[2]);
+  if(!(par[2]>0.)) par[2] = 1.;
+  if(model==kGaus) return par;
+
+  // second Gaussian: the highest peak of what the first leaves, above it
+  size_t above = 0;
+  for(size_t i=0; i<n; ++i){
+    r[i] -= Evaluate(kGaus,par,bins.x[i]);
+    if(bins.x[i]<par[1]+2.*par[2]) above = i+1;
+  }
+  FindPeak(bins.x,r,above,n,par[3],par[4],par[5]);
+  if(!(par[3]>0.)){
+    par[3] = 0.1*par[0];
+    par[4] = par[1]+3.*par[2];
+    par[5] = par[2];
+  }
+  if(model==kGaus2) return par;
+
+  // exponential: weighted log-linear fit of the rest, var(log y) ~ 1/y
+  double sw = 0., swx = 0., swy = 0., swxx = 0., swxy = 0.;
+  Parameters gaus2 = par;
+  for(size_t i=0; i<n; ++i){
+    const double rest = bins.y[i]-Evaluate(kGaus2,gaus2,bins.x[i]);
+    if(!(rest>0.)) continue;
+    const double ly = std::log(rest);
+    sw += rest;
+    swx += rest*bins.x[i];
+    swy += rest*ly;
+    swxx += rest*bins.x[i]*bins.x[i];
+    swxy += rest*bins.x[i]*ly;
+  }
+  const double det = sw*swxx-swx*swx;
+  if(sw>0. && std::fabs(det)>1e-12*sw*swxx){
+    par[7] = (sw*swxy-swx*swy)/det;
+    par[6] = (swy-par[7]*swx)/sw;
+  } else {
+    par[7] = (xmax>xmin) ? -1./(xmax-xmin) : -1.;
+    par[6] = std::log(std::max(bins.y.front(),1.))-par[7]*bins.x.front();
+  }
+  return par;
+}
+
+gainfit::Result gainfit::Fit(Model model, const Histogram& data, double xmin, double xmax, const Parameters& seed){
+
+  const int npar = model;
+  const int max_iterations = 200;
+  Result result;
+  result.npar = npar;
+  result.par = seed;
+
+  const Bins bins = SelectBins(data,xmin,xmax,true);
+  result.ndf = int(bins.x.size())-npar;
+  if(int(bins.x.size())<npar){
+    result.status = kTooFewBins;
+    return result;
+  }
+
+  Matrix jtj, a;
+  double jtr[kMaxPar], step[kMaxPar];
+  Parameters& par = result.par;
+  double chi2 = Chi2(model,par,bins,jtj,jtr);
+  double lambda = 1e-3;
+  bool converged = false;
+
+  while(!converged && result.iterations<max_iterations && std::isfinite(chi2)){
+    ++result.iterations;
+    // damped normal equations, (J^T W J + lambda diag(J^T W J)) step = J^T W r
+    for(int i=0; i<npar; ++i){
+      for(int j=0; j<npar; ++j) a[i][j] = jtj[i][j];
+      a[i][i] += lambda*std::max(jtj[i][i],1e-12);
+      step[i] = jtr[i];
+    }
+    if(!Cholesky(a,npar)){
+      lambda *= 10.;
+      if(lambda>1e12) break;
+      continue;
+    }
+    CholeskySolve(a,npar,step);
+
+    Parameters trial = par;
+    bool small_step = true;
+    for(int i=0; i<npar; ++i){
+      trial[i] += step[i];
+      if(std::fabs(step[i])>1e-8*(std::fabs(par[i])+1e-8)) small_step = false;
+    }
+    const double trial_chi2 = Chi2(model,trial,bins);
+    if(std::isfinite(trial_chi2) && trial_chi2<=chi2){
+      const double decrease = chi2-trial_chi2;
+      par = trial;
+      chi2 = Chi2(model,par,bins,jtj,jtr);
+      lambda = std::max(lambda/10.,1e-12);
+      if(small_step || decrease<=1e-9*std::max(chi2,1e-12)) converged = true;
+    } else {
+      lambda *= 10.;
+      // no downhill step left even along the gradient: at the minimum
+      if(lambda>1e12 || small_step) converged = true;
+    }
+  }
+
+  result.chi2 = chi2;
+  bool finite = std::isfinite(chi2);
+  for(int i=0; i<npar; ++i) finite = finite && std::isfinite(par[i]);
+  if(!finite){
+    result.status = kInvalid;
+    return result;
+  }
+  if(!converged){
+    result.status = kNotConverged;
+    return result;
+  }
+
+  // covariance of a chi2 fit: (J^T W J)^-1
+  for(int i=0; i<npar; ++i) for(int j=0; j<npar; ++j) a[i][j] = jtj[i][j];
+  if(!Cholesky(a,npar)){
+    result.status = kBadCovariance;
+    return result;
+  }
+  for(int j=0; j<npar; ++j){
+    double column[kMaxPar] = {0.};
+    column[j] = 1.;
+    CholeskySolve(a,npar,column);
+    for(int i=0; i<npar; ++i) result.cov[i*npar+j] = column[i];
+  }
+  for(int i=0; i<npar; ++i) result.err[i] = std::sqrt(result.cov[i*npar+i]);
+  result.status = kOk;
+  return result;
+}
+
+void gainfit::FitAll(std::vector<Job>& jobs, int nthreads){
+
+  std::atomic<size_t> next(0);
+  auto work = [&jobs,&next](){
+    for(size_t i=next++; i<jobs.size(); i=next++){
+      Job& job = jobs[i];
+      if(job.auto_seed) job.seed = Seed(job.model,job.data,job.xmin,job.xmax);
+      job.result = Fit(job.model,job.data,job.xmin,job.xmax,job.seed);
+    }
+  };
+
+  nthreads = std::max(1,std::min(nthreads,int(jobs.size())));
+  std::vector<std::thread> threads;
+  for(int i=1; i<nthreads; ++i) threads.emplace_back(work);
+  work();
+  for(std::thread& thread : threads) thread.join();
+}
@@ -0,0 +1,80 @@
+#ifndef GainFitter_H
+#define GainFitter_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+// Binned chi2 fits of the single tube charge and time distributions of the
+// TankCalibrationDiffuser tool. The models are the ones the tool used to fit
+// with TF1 formulas ("gaus", "gaus(0)+gaus(3)", "gaus(0)+gaus(3)+expo(6)"),
+// with the same parameter order, so results can be put back into a TF1. The
+// fit is a fixed-size Levenberg-Marquardt with analytic derivatives; start
+// values come either from the configuration or from the histogram itself.
+namespace gainfit {
+
+  const int kMaxPar = 8;
+
+  enum Model { kGaus = 3, kGaus2 = 6, kGaus2Exp = 8 };   // value is the number of parameters
+
+  enum Status {
+    kOk = 0,                // converged, covariance positive definite
+    kTooFewBins = 1,        // fewer filled bins in range than parameters
+    kNotConverged = 2,      // iteration limit reached
+    kBadCovariance = 3,     // converged, but the covariance could not be computed
+    kInvalid = 4            // parameters or chi2 not finite
+  };
+
+  typedef std::array<double,kMaxPar> Parameters;
+
+  // bin centres and contents of a histogram
+  struct Histogram {
+    std::vector<double> x;
+    std::vector<double> y;
+  };
+
+  struct Result {
+    int status = kTooFewBins;
+    int npar = 0;
+    Parameters par{};
+    Parameters err{};                             // sqrt of the covariance diagonal
+    std::array<double,kMaxPar*kMaxPar> cov{};     // row-major, npar x npar used
+    double chi2 = 0.;
+    int ndf = 0;
+    int iterations = 0;
+  };
+
+  // One fit: the data, the model, the range, and optionally start values
+  struct Job {
+    Histogram data;
+    Model model = kGaus;
+    double xmin = 0.;
+    double xmax = 0.;
+    bool auto_seed = true;                        // seeds from the histogram, else use seed
+    Parameters seed{};
+    Result result;
+  };
+
+  // the fit reached a minimum, whether or not its covariance is usable
+  inline bool Converged(const Result& result){ return result.status==kOk || result.status==kBadCovariance; }
+
+  // FitMethod name of the tool ("Gaus", "Gaus2", "Gaus2Exp"); false if unknown
+  bool ModelFromName(const std::string& name, Model& model);
+
+  // Model value at x, and its derivatives with respect to the parameters if grad is given
+  double Evaluate(Model model, const Parameters& par, double x, double* grad = nullptr);
+
+  // Start values from peak finding and moments of the bins in [xmin,xmax]:
+  // the highest peak seeds the first Gaussian, the highest peak of what is
+  // left above it the second, and a log-linear fit of the rest the exponential
+  Parameters Seed(Model model, const Histogram& data, double xmin, double xmax);
+
+  // Chi2 fit of the filled bins in [xmin,xmax], errors sqrt(content) as for a TH1 fit
+  Result Fit(Model model, const Histogram& data, double xmin, double xmax, const Parameters& seed);
+
+  // Fits all jobs, nthreads at a time
+  void FitAll(std::vector<Job>& jobs, int nthreads);
+
+}
+
+#endif
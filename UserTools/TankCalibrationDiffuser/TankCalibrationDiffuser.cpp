@@ -1,4 +1,7 @@
 #include "TankCalibrationDiffuser.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(TankCalibrationDiffuser);
 
 TankCalibrationDiffuser::TankCalibrationDiffuser():Tool(){}
 
@@ -91,6 +94,9 @@ bool TankCalibrationDiffuser::Initialise(std::string configfile, DataModel &data
   m_variables.Get("Gaus2Sigma",gaus2Sigma);
   m_variables.Get("ExpConstant",expConstant);
   m_variables.Get("ExpDecay",expDecay);
+  FitThreads = std::max(1u,std::thread::hardware_concurrency());
+  m_variables.Get("FitSeeds",FitSeeds);
+  m_variables.Get("FitThreads",FitThreads);
   m_variables.Get("TApplication",use_tapplication);
   m_variables.Get("verbose",verbose);
 
@@ -589,6 +595,41 @@ bool TankCalibrationDiffuser::Finalise(){
   //---------------Perform fits for PMT distributions---------------------------
   //----------------------------------------------------------------------------
 
+  gainfit::Model charge_model;
+  if (!gainfit::ModelFromName(FitMethod,charge_model)){
+    std::cout <<"ERROR (TankCalibrationDiffuser): FitFunction is not part of the options, please extend the options Using standard Gaus."<<std::endl;
+    charge_model = gainfit::kGaus;
+  }
+  gainfit::Parameters charge_seed = {gaus1Constant,gaus1Mean,gaus1Sigma,gaus2Constant,gaus2Mean,gaus2Sigma,expConstant,expDecay};    //old default: {10,0.3,0.1,10,1.0,0.5,1,-1}
+
+  //copy the histograms out first, then fit the charge and time distributions of all tubes in parallel
+  //charge: the FitMethod model in [ChargeMin,ChargeMax], time: a Gaussian over the whole histogram
+  std::vector<gainfit::Job> fit_jobs(2*n_tank_pmts);
+  for (int i_tube=0;i_tube<n_tank_pmts;i_tube++){
+    unsigned long detkey = pmt_detkeys[i_tube];
+    TH1F *hists[2] = {hist_charge_singletube[detkey],hist_time_singletube[detkey]};
+    for (int i_hist=0; i_hist<2; i_hist++){
+      gainfit::Job &job = fit_jobs.at(2*i_tube+i_hist);
+      for (int i_bin=1; i_bin<=hists[i_hist]->GetNbinsX(); i_bin++){
+        job.data.x.push_back(hists[i_hist]->GetBinCenter(i_bin));
+        job.data.y.push_back(hists[i_hist]->GetBinContent(i_bin));
+      }
+    }
+    fit_jobs.at(2*i_tube).model = charge_model;
+    fit_jobs.at(2*i_tube).xmin = chargeMin;
+    fit_jobs.at(2*i_tube).xmax = chargeMax;
+    fit_jobs.at(2*i_tube).auto_seed = (FitSeeds != "Config");
+    fit_jobs.at(2*i_tube).seed = charge_seed;
+    fit_jobs.at(2*i_tube+1).model = gainfit::kGaus;
+    fit_jobs.at(2*i_tube+1).xmin = timeMin;
+    fit_jobs.at(2*i_tube+1).xmax = timeMax;
+  }
+  gainfit::FitAll(fit_jobs,FitThreads);
+
+  std::string filename_quality = outputdir+outputfile+filename_pre+newRunNumber+"_fit_quality"+filename_post;
+  ofstream quality_file(filename_quality.c_str());
+  quality_file << "detkey"<<"    "<<"histogram"<<"    "<<"status"<<"    "<<"chi2"<<"    "<<"ndf"<<"    "<<"iterations"<<"    "<<"parameters"<<"    "<<"errors"<<"    "<<"covariance (upper triangle, row by row)"<<std::endl;
+
   for (int i_tube=0;i_tube<n_tank_pmts;i_tube++){
 
     unsigned long detkey = pmt_detkeys[i_tube];
@@ -609,44 +650,29 @@ bool TankCalibrationDiffuser::Finalise(){
     }
     nentries_hist[detkey] = nentries;
 
-    Double_t par_gaus2exp[8] = {gaus1Constant,gaus1Mean,gaus1Sigma,gaus2Constant,gaus2Mean,gaus2Sigma,expConstant,expDecay};    //old default: {10,0.3,0.1,10,1.0,0.5,1,-1}
-    Double_t par_gaus2[6] = {gaus1Constant,gaus1Mean,gaus1Sigma,gaus2Constant,gaus2Mean,gaus2Sigma};  //old default: {10,0.3,0.1,10,1.0,0.5}
-    Double_t par_gaus[3] = {gaus1Constant,gaus1Mean,gaus1Sigma};    //old default: {10,1.0,0.5}
+    const gainfit::Result &charge_result = fit_jobs.at(2*i_tube).result;
+    const gainfit::Result &time_result = fit_jobs.at(2*i_tube+1).result;
+    charge_fit_result[detkey] = charge_result;
+    time_fit_result[detkey] = time_result;
 
     TF1 *total;
-    if (FitMethod == "Gaus2Exp") total = new TF1("total","gaus(0)+gaus(3)+expo(6)",chargeMin,chargeMax);
-    else if (FitMethod == "Gaus2") total = new TF1("total","gaus(0)+gaus(3)",chargeMin,chargeMax);
-    else if (FitMethod == "Gaus") total = new TF1("total","gaus",chargeMin,chargeMax);
-    else {
-      std::cout <<"ERROR (TankCalibrationDiffuser): FitFunction is not part of the options, please extend the options Using standard Gaus."<<std::endl;
-      total = new TF1("total","gaus",chargeMin,chargeMax);
-    }
+    if (charge_model == gainfit::kGaus2Exp) total = new TF1("total","gaus(0)+gaus(3)+expo(6)",chargeMin,chargeMax);
+    else if (charge_model == gainfit::kGaus2) total = new TF1("total","gaus(0)+gaus(3)",chargeMin,chargeMax);
+    else total = new TF1("total","gaus",chargeMin,chargeMax);
     total->SetLineColor(2);
-    if (FitMethod == "Gaus2Exp") total->SetParameters(par_gaus2exp);
-    else if (FitMethod == "Gaus2") total->SetParameters(par_gaus2);
-    else total->SetParameters(par_gaus2);
-
-    //total = new TF1("total",total_value,0,10,8);
-    //total->SetParameters(10,0.3,0.1,10,1.,0.3,1,1);
-    TFitResultPtr FitResult = hist_charge_singletube[detkey]->Fit(total,"QR+");
-    Int_t FitResult_int = FitResult;
+    total->SetParameters(charge_result.par.data());
+    total->SetParErrors(charge_result.err.data());
+    total->SetChisquare(charge_result.chi2);
+    total->SetNDF(charge_result.ndf);
 
-    //hist_charge_singletube[i_tube]->Fit("gaus[0]+gaus[3]+exp[6]");
+    //attach a copy to the histogram, as a fit with option "+" would
+    if (gainfit::Converged(charge_result)) hist_charge_singletube[detkey]->GetListOfFunctions()->Add(total->Clone("total"));
     hist_charge_singletube[detkey]->Write();
-    if (FitResult_int ==0){
-      TF1 *fit_result_charge=hist_charge_singletube[detkey]->GetFunction("total");
-      if (FitMethod == "Gaus2Exp") {
-        charge_mean_fit[detkey] = fit_result_charge->GetParameter(4);
-        charge_rms_fit[detkey] = fit_result_charge->GetParameter(5);
-      } 
-      else if (FitMethod == "Gaus2") {
-        charge_mean_fit[detkey]=fit_result_charge->GetParameter(4);
-        charge_rms_fit[detkey]=fit_result_charge->GetParameter(5);
-      }
-      else {
-      charge_mean_fit[detkey]=fit_result_charge->GetParameter(1);
-      charge_rms_fit[detkey]=fit_result_charge->GetParameter(2);
-      }
+    if (gainfit::Converged(charge_result)){
+      //the single p.e. peak is the second Gaussian of the two-Gaussian models
+      int i_mean = (charge_model == gainfit::kGaus) ? 1 : 4;
+      charge_mean_fit[detkey] = charge_result.par[i_mean];
+      charge_rms_fit[detkey] = charge_result.par[i_mean+1];
     } else {
       charge_mean_fit[detkey] = 0.;
       charge_rms_fit[detkey] = 0.;
@@ -661,13 +687,19 @@ bool TankCalibrationDiffuser::Finalise(){
       std::cout <<"Mean charge for detkey "<<detkey<<": "<<charge_mean[detkey]<<std::endl;
     }
 
-    TFitResultPtr FitResultTime = hist_time_singletube[detkey]->Fit("gaus","Q");      //time fit is always the same for now, assume simple Gaussian
-    Int_t FitResultTime_int = FitResultTime;
+    //time fit is always the same for now, assume simple Gaussian
+    if (gainfit::Converged(time_result)) { //fit was okay and has a result
+      TF1 *fit_result_time = new TF1("gaus","gaus",timeMin,timeMax);
+      fit_result_time->SetParameters(time_result.par.data());
+      fit_result_time->SetParErrors(time_result.err.data());
+      fit_result_time->SetChisquare(time_result.chi2);
+      fit_result_time->SetNDF(time_result.ndf);
+      hist_time_singletube[detkey]->GetListOfFunctions()->Add(fit_result_time);    //owned by the histogram
+    }
     hist_time_singletube[detkey]->Write();
-    if (FitResultTime_int == 0) { //fit was okay and has a result
-      TF1 *fit_result_time=hist_time_singletube[detkey]->GetFunction("gaus");
-      time_mean_fit[detkey]=fit_result_time->GetParameter(1);
-      time_rms_fit[detkey]=fit_result_time->GetParameter(2);
+    if (gainfit::Converged(time_result)) {
+      time_mean_fit[detkey]=time_result.par[1];
+      time_rms_fit[detkey]=time_result.par[2];
     }
     else {
       time_mean_fit[detkey] = 0.;
@@ -691,6 +723,20 @@ bool TankCalibrationDiffuser::Finalise(){
       charge_rms_fit[detkey] = 0.;
     }
 
+    if (verbose > 0 && !gainfit::Converged(charge_result)) std::cout <<"TankCalibrationDiffuser: Charge fit for detkey "<<detkey<<" failed with status "<<charge_result.status<<std::endl;
+    if (verbose > 0 && !gainfit::Converged(time_result)) std::cout <<"TankCalibrationDiffuser: Time fit for detkey "<<detkey<<" failed with status "<<time_result.status<<std::endl;
+    const gainfit::Result *results[2] = {&charge_result,&time_result};
+    for (int i_hist=0; i_hist<2; i_hist++){
+      const gainfit::Result &result = *results[i_hist];
+      quality_file << detkey<<"  "<<(i_hist==0 ? "charge" : "time")<<"  "<<result.status<<"  "<<result.chi2<<"  "<<result.ndf<<"  "<<result.iterations;
+      for (int i_par=0; i_par<result.npar; i_par++) quality_file<<"  "<<result.par[i_par];
+      for (int i_par=0; i_par<result.npar; i_par++) quality_file<<"  "<<result.err[i_par];
+      for (int i_par=0; i_par<result.npar; i_par++){
+        for (int j_par=i_par; j_par<result.npar; j_par++) quality_file<<"  "<<result.cov[i_par*result.npar+j_par];
+      }
+      quality_file<<endl;
+    }
+
     //
     //write ADCRecoPulse histograms to file as well
     //
@@ -792,6 +838,7 @@ bool TankCalibrationDiffuser::Finalise(){
   }
   result_file<<1000<<"  "<<hist_charge_fit->GetMean()<<"  "<<hist_charge_fit->GetRMS()<<"  "<<hist_charge_mean->GetMean()<<"  "<<hist_charge_mean->GetRMS()<<"  "<<hist_time_fit->GetMean()<<"  "<<hist_time_fit->GetRMS()<<"  "<<hist_time_mean->GetMean()<<"  "<<hist_time_mean->GetRMS()<<"  "<<0<<"  "<<hist_time_dev_fit->GetMean()<<"  "<<hist_time_dev_mean->GetMean()<<"  "<<hist_charge->GetEntries()<<endl; //1000 is identifier key for average value
   result_file.close();
+  quality_file.close();
 
   hist_time_fit->GetXaxis()->SetTitle("t_{arrival} [ns]");
   hist_time_dev_fit->GetXaxis()->SetTitle("t_{arrival} - t_{expected} [ns]");
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <cmath>
 #include <fstream>
+#include <thread>
 
 #include "TObjectTable.h"
 
@@ -28,6 +29,8 @@
 #include "TH2F.h"
 #include "TFile.h"
 
+#include "GainFitter.h"
+
 /**
  * \class MonitorTankLive
 *
@@ -117,6 +120,8 @@ class TankCalibrationDiffuser: public Tool {
       double gaus2Sigma;
       double expConstant;
       double expDecay;
+      std::string FitSeeds = "Auto";     //Auto: seeds from the histograms, Config: the values above
+      int FitThreads = 1;
       bool use_tapplication;
       int verbose;
 
@@ -241,6 +246,10 @@ class TankCalibrationDiffuser: public Tool {
       //container for TF1s used to fit the distributions
       std::vector<TF1*> vector_tf1;
 
+      //fit results (status, chi2, covariance) of the single tube distributions
+      std::map<unsigned long, gainfit::Result> charge_fit_result;
+      std::map<unsigned long, gainfit::Result> time_fit_result;
+
       //define graphs for stability plots
       TGraphErrors *gr_stability_charge_fit = nullptr;
       TGraphErrors *gr_stability_time_fit = nullptr;
@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "TimeClustering.h"
+#include "ToolRegistry.h"
 
 #include <numeric>
 // for sleeping
@@ -14,6 +15,8 @@
 #include "TCanvas.h"
 #include "TApplication.h"
 
+REGISTER_TOOL(TimeClustering);
+
 TimeClustering::TimeClustering():Tool(){}
 
 
@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=2 wrap */
 #include "TotalLightMap.h"
+#include "ToolRegistry.h"
 
 // ROOT
 //#include "TPointSet3D.h"
@@ -36,6 +37,8 @@ Then make plots of hits on walls from each species:
 // Much Code stolen / adapted from Michael Nieslony's EventDisplay tool
 ///////////////////////////////////////////////////////////////////////
 
+REGISTER_TOOL(TotalLightMap);
+
 TotalLightMap::TotalLightMap():Tool(){}
 
 // ##############################################################
@@ -1,11 +1,14 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "TrackCombiner.h"
+#include "ToolRegistry.h"
 #include "MRDTrackClass.hh"
 #include "MRDSubEventClass.hh"
 #include "StubCluster.h"
 #include "MrdStub.h"
 #include "TClonesArray.h"
 
+REGISTER_TOOL(TrackCombiner);
+
 TrackCombiner::TrackCombiner():Tool(){}
 
 
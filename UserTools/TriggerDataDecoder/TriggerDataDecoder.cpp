@@ -1,4 +1,7 @@
 #include "TriggerDataDecoder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(TriggerDataDecoder);
 
 TriggerDataDecoder::TriggerDataDecoder():Tool(){}
 
@@ -181,3 +181,4 @@
 #include "BackTracker.h"
 #include "PrintDQ.h"
 #include "AssignBunchTimingMC.h"
+#include "PipelineToolChain.h"
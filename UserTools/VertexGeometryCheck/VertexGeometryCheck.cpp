@@ -1,4 +1,7 @@
 #include "VertexGeometryCheck.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(VertexGeometryCheck);
 
 VertexGeometryCheck::VertexGeometryCheck():Tool(){}
 
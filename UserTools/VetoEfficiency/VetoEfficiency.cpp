@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "VetoEfficiency.h"
+#include "ToolRegistry.h"
 
 #include "TROOT.h"
 #include "TSystem.h"
@@ -33,6 +34,8 @@ constexpr std::array<uint32_t, 56> water_tank_pmt_IDs = {
   44, 45, 46, 47, 48, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60
 };
 
+REGISTER_TOOL(VetoEfficiency);
+
 VetoEfficiency::VetoEfficiency():Tool(){}
 
 bool VetoEfficiency::Initialise(std::string configfile, DataModel &data){
@@ -1,4 +1,7 @@
 #include "VtxExtendedVertexFinder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(VtxExtendedVertexFinder);
 
 VtxExtendedVertexFinder::VtxExtendedVertexFinder():Tool(){}
 
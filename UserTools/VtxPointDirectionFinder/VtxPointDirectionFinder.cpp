@@ -1,4 +1,7 @@
 #include "VtxPointDirectionFinder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(VtxPointDirectionFinder);
 
 VtxPointDirectionFinder::VtxPointDirectionFinder():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "VtxPointPositionFinder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(VtxPointPositionFinder);
 
 VtxPointPositionFinder::VtxPointPositionFinder():Tool(){}
 VtxPointPositionFinder::~VtxPointPositionFinder(){}
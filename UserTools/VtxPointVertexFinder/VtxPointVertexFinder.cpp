@@ -1,4 +1,7 @@
 #include "VtxPointVertexFinder.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(VtxPointVertexFinder);
 
 VtxPointVertexFinder::VtxPointVertexFinder():Tool(){}
 
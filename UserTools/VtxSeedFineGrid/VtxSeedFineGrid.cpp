@@ -1,4 +1,7 @@
 #include "VtxSeedFineGrid.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(VtxSeedFineGrid);
 
 VtxSeedFineGrid::VtxSeedFineGrid():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "VtxSeedGenerator.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(VtxSeedGenerator);
 
 VtxSeedGenerator::VtxSeedGenerator():Tool(){}
 
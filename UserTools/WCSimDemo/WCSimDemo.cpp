@@ -1,5 +1,8 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "WCSimDemo.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(WCSimDemo);
 
 WCSimDemo::WCSimDemo():Tool(){}
 
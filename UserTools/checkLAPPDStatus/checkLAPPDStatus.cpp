@@ -1,4 +1,7 @@
 #include "checkLAPPDStatus.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(checkLAPPDStatus);
 
 checkLAPPDStatus::checkLAPPDStatus():Tool(){}
 
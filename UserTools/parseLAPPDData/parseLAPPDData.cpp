@@ -1,4 +1,7 @@
 #include "parseLAPPDData.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(parseLAPPDData);
 
 parseLAPPDData::parseLAPPDData():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "saveLAPPDInfo.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(saveLAPPDInfo);
 
 saveLAPPDInfo::saveLAPPDInfo():Tool(){}
 
@@ -1,4 +1,7 @@
 #include "MyTool.h"
+#include "ToolRegistry.h"
+
+REGISTER_TOOL(MyTool);
 
 MyTool::MyTool():Tool(){}
 
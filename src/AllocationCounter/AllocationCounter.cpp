@@ -0,0 +1,57 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+  std::atomic<bool> counting(false);
+  // plain thread_local integers need no initialisation, so they can be used
+  // from operator new at any time, including during thread startup
+  thread_local uint64_t thread_allocations = 0;
+  thread_local uint64_t thread_bytes = 0;
+
+  inline void* CountedAlloc(std::size_t size){
+    if(counting.load(std::memory_order_relaxed)){
+      ++thread_allocations;
+      thread_bytes += size;
+    }
+    return std::malloc(size ? size : 1);
+  }
+}
+
+void allocationcounter_enable(int enable){
+  counting.store(enable!=0);
+}
+
+void allocationcounter_thread_counts(uint64_t* allocations, uint64_t* bytes){
+  *allocations = thread_allocations;
+  *bytes = thread_bytes;
+}
+
+void* operator new(std::size_t size){
+  void* ptr = CountedAlloc(size);
+  if(ptr==nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size){
+  void* ptr = CountedAlloc(size);
+  if(ptr==nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
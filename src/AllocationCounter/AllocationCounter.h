@@ -0,0 +1,24 @@
+#ifndef AllocationCounter_H
+#define AllocationCounter_H
+
+#include <stdint.h>
+
+// Counts of heap allocations made through operator new, per thread, for the
+// Profile mode of the PipelineToolChain. Built on its own as
+// lib/libAllocationCounter.so (make lib/libAllocationCounter.so) and loaded
+// only when asked for:
+//   LD_PRELOAD=lib/libAllocationCounter.so ./Analyse configfiles/...
+// It replaces the global operator new and delete of the whole process, which
+// then count while counting is enabled. malloc calls (from C libraries) are
+// not counted. ToolProfiler looks these functions up at run time, so nothing
+// else links against the library.
+extern "C" {
+
+  void allocationcounter_enable(int enable);
+
+  // allocations and bytes allocated on the calling thread while counting was enabled
+  void allocationcounter_thread_counts(uint64_t* allocations, uint64_t* bytes);
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include <string>
 #include "ToolChain.h"
 #include "DummyTool.h"
+#include "ToolRegistry.h"
 
 int main(int argc, char* argv[]){
 
@@ -8,6 +9,13 @@ int main(int argc, char* argv[]){
   if (argc==1)conffile="configfiles/Dummy/ToolChainConfig";
   else conffile=argv[1];
 
+  // tools that are not built into libMyTools are looked for in plugin libraries
+  // in the directory given by 'plugin_dir' in the ToolChain config
+  Store chainconfig;
+  chainconfig.Initialise(conffile);
+  std::string plugin_dir;
+  if(chainconfig.Get("plugin_dir",plugin_dir)) ToolRegistry::Instance().SetPluginDirectory(plugin_dir);
+
   ToolChain tools(conffile);
 
   //DummyTool dummytool;
@@ -0,0 +1,352 @@
+// Runs BackTracker on random MC events and compares, cluster by cluster, the
+// best matched particle ID and PDG, efficiency, purity and total charge with
+// a copy of the per-hit code it replaced (ReferenceMatch below, kept as it was
+// apart from the logging). They have to be equal, not just close: the charges
+// are summed in the same order. The events have
+//  * several track IDs pointing to the same particle, and particles no ID
+//    points to
+//  * hits with no parent or two parents, and parents with no track ID
+//  * whole-number charges, so that two particles often tie for a cluster,
+//    and hits without charge
+//  * clusters without any matched hit, and events without particles
+// The IDs point into the MCParticles vector, as LoadWCSim writes them.
+// BackTracker logs through the ToolChain, so the comparison runs as a tool in
+// a ToolChain of its own.
+// Run from the top directory after make:
+//   tests/BackTracker/BackTrackerComparison [events, default 5000]
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "BackTracker.h"
+#include "Hit.h"
+#include "Particle.h"
+#include "ToolChain.h"
+#include "ToolRegistry.h"
+
+namespace {
+
+  int n_events = 5000;
+  std::string directory;
+  bool ran = false;
+  int failures = 0;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "BackTrackerComparison: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  std::string WriteFile(const std::string& name, const std::string& content){
+    std::string path = directory+"/"+name;
+    std::ofstream file(path);
+    file << content;
+    return path;
+  }
+
+  // what BackTracker stores for one cluster
+  struct Match {
+    int id = -5;
+    int pdg = -5;
+    double eff = -5;
+    double pur = -5;
+    double charge = 0;
+    bool operator==(const Match& other) const {
+      return id==other.id && pdg==other.pdg && eff==other.eff && pur==other.pur && charge==other.charge;
+    }
+  };
+
+  std::string Print(const Match& match){
+    char buffer[160];
+    std::snprintf(buffer,sizeof(buffer),"ID %d, PDG %d, eff %.17g, pur %.17g, charge %.17g",
+                  match.id,match.pdg,match.eff,match.pur,match.charge);
+    return buffer;
+  }
+
+}
+
+
+// Fills the ANNIEEvent and the CStore with random events, runs a BackTracker
+// initialised in the same chain and compares its maps with ReferenceMatch
+class BackTrackerComparison: public Tool {
+ public:
+  bool Initialise(std::string, DataModel& data);
+  bool Execute();
+  bool Finalise(){
+    tracker.Finalise();
+    if(m_data->Stores.count("ANNIEEvent")) delete m_data->Stores["ANNIEEvent"];
+    m_data->Stores.erase("ANNIEEvent");
+    return true;
+  }
+ private:
+  void ReferenceSumParticleTankCharge();
+  void ReferenceMatch(std::vector<MCHit> const &mchits, int &prtId, int &prtPdg, double &eff, double &pur, double &totalCharge);
+
+  BackTracker tracker;
+  // the event, owned by the stores
+  std::map<unsigned long, std::vector<MCHit>> *fMCHitsMap = nullptr;
+  std::map<double, std::vector<MCHit>>        *fClusterMapMC = nullptr;
+  std::vector<MCParticle>                     *fMCParticles = nullptr;
+  std::map<int, int>                          *fMCParticleIndexMap = nullptr;
+  std::map<int, double> fParticleToTankTotalCharge;
+};
+REGISTER_TOOL(BackTrackerComparison);
+
+
+bool BackTrackerComparison::Initialise(std::string, DataModel& data){
+
+  m_data = &data;
+  BoostStore* annie_event = new BoostStore(false,2);
+  fMCHitsMap = new std::map<unsigned long, std::vector<MCHit>>;
+  fMCParticles = new std::vector<MCParticle>;
+  fMCParticleIndexMap = new std::map<int, int>;
+  annie_event->Set("MCHits",fMCHitsMap,false);
+  annie_event->Set("MCParticles",fMCParticles,false);
+  annie_event->Set("TrackId_to_MCParticleIndex",fMCParticleIndexMap,false);
+  m_data->Stores["ANNIEEvent"] = annie_event;
+  fClusterMapMC = new std::map<double, std::vector<MCHit>>;
+  m_data->CStore.Set("ClusterMapMC",fClusterMapMC,false);
+
+  return tracker.Initialise(WriteFile("BackTrackerConfig","verbosity 0\n"),data);
+}
+
+
+bool BackTrackerComparison::Execute(){
+
+  std::mt19937 random(30);
+  std::uniform_real_distribution<double> uniform(0.,1.);
+  const int pdg_codes[] = {13,-13,11,22,211,-211,111,2112,2212};
+
+  long n_clusters = 0, n_matched = 0, n_ties = 0;
+  for(int i_event=0; i_event<n_events; ++i_event){
+
+    // particles, and the track IDs pointing to them
+    int n_particles = (i_event%50==0) ? 0 : 1+int(25*uniform(random));
+    fMCParticles->assign(n_particles,MCParticle());
+    for(MCParticle& particle : *fMCParticles) particle.SetPdgCode(pdg_codes[int(9*uniform(random))%9]);
+    fMCParticleIndexMap->clear();
+    int track_id = 1;
+    for(int i_particle=0; i_particle<n_particles; ++i_particle){
+      track_id += 1+int(3*uniform(random));
+      if(uniform(random)<0.1) continue;                           // no ID points to it
+      (*fMCParticleIndexMap)[track_id] = i_particle;
+      if(uniform(random)<0.1) (*fMCParticleIndexMap)[track_id+1000] = i_particle; // a second ID
+    }
+
+    // hits on the tubes, most of them with one parent
+    bool whole_charges = (i_event%2==0);
+    fMCHitsMap->clear();
+    std::vector<MCHit> all_hits;
+    int n_hits = int(200*uniform(random));
+    for(int i_hit=0; i_hit<n_hits; ++i_hit){
+      std::vector<int> parents;
+      double kind = uniform(random);
+      if(kind<0.9) parents.push_back(int((n_particles+2)*uniform(random)));   // may have no ID
+      else if(kind<0.95) parents = {int(n_particles*uniform(random)),int(n_particles*uniform(random))};
+      double charge = (whole_charges) ? double(int(4*uniform(random))) : 10.*uniform(random);
+      int tube = 1+int(60*uniform(random));
+      MCHit hit(tube,10.*i_hit,charge,parents);
+      (*fMCHitsMap)[tube].push_back(hit);
+      all_hits.push_back(hit);
+    }
+
+    // clusters of some of the hits, in their order
+    fClusterMapMC->clear();
+    int n_event_clusters = 1+int(6*uniform(random));
+    for(const MCHit& hit : all_hits){
+      double which = uniform(random);
+      if(which<0.2) continue;
+      (*fClusterMapMC)[100.*int(n_event_clusters*which)].push_back(hit);
+    }
+    if(i_event%7==0) (*fClusterMapMC)[-10.].push_back(MCHit(1,0.,2.,std::vector<int>{n_particles+5}));
+
+    // the old code
+    std::map<double,Match> reference;
+    fParticleToTankTotalCharge.clear();
+    ReferenceSumParticleTankCharge();
+    for(const auto& cluster : *fClusterMapMC){
+      Match match;
+      ReferenceMatch(cluster.second,match.id,match.pdg,match.eff,match.pur,match.charge);
+      reference[cluster.first] = match;
+    }
+
+    if(!tracker.Execute()){
+      Check(false,"event "+std::to_string(i_event)+": BackTracker::Execute failed");
+      break;
+    }
+    std::map<double,int> *ids = nullptr, *pdgs = nullptr;
+    std::map<double,double> *effs = nullptr, *purs = nullptr, *charges = nullptr;
+    BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+    if(!annie_event->Get("ClusterToBestParticleID",ids) || !annie_event->Get("ClusterToBestParticlePDG",pdgs)
+       || !annie_event->Get("ClusterEfficiency",effs) || !annie_event->Get("ClusterPurity",purs)
+       || !annie_event->Get("ClusterTotalCharge",charges)){
+      Check(false,"event "+std::to_string(i_event)+": BackTracker did not store its cluster maps");
+      break;
+    }
+
+    Check(ids->size()==reference.size(),"event "+std::to_string(i_event)+": "+std::to_string(ids->size())
+          +" clusters matched, expected "+std::to_string(reference.size()));
+    for(const auto& expected : reference){
+      std::string what = "event "+std::to_string(i_event)+", cluster at "+std::to_string(expected.first);
+      if(!ids->count(expected.first)){
+        Check(false,what+": missing");
+        continue;
+      }
+      Match got;
+      got.id = ids->at(expected.first);
+      got.pdg = pdgs->at(expected.first);
+      got.eff = effs->at(expected.first);
+      got.pur = purs->at(expected.first);
+      got.charge = charges->at(expected.first);
+      Check(got==expected.second,what+": "+Print(got)+" instead of "+Print(expected.second));
+      ++n_clusters;
+      if(expected.second.id!=-5) ++n_matched;
+    }
+
+    // clusters where two particles tie, to check that the tie-breaking is exercised
+    for(const auto& cluster : *fClusterMapMC){
+      std::map<int,double> charge;
+      for(const MCHit& hit : cluster.second){
+        if(hit.GetParents()->size()!=1) continue;
+        for(const auto& id : *fMCParticleIndexMap) if(id.second==hit.GetParents()->at(0)) charge[id.first] += hit.GetCharge();
+      }
+      double highest = 0;
+      int n_highest = 0;
+      for(const auto& particle : charge){
+        if(particle.second>highest){ highest = particle.second; n_highest = 1; }
+        else if(particle.second==highest && highest>0) ++n_highest;
+      }
+      if(n_highest>1) ++n_ties;
+    }
+    if(failures>20) break;
+  }
+
+  std::cout << "BackTrackerComparison: " << n_clusters << " clusters compared, " << n_matched
+            << " matched to a particle, " << n_ties << " with a tie" << std::endl;
+  Check(n_matched>0 && n_matched<n_clusters,"the sample has no matched or no unmatched clusters");
+  Check(n_ties>0,"the sample has no ties");
+
+  ran = true;
+  m_data->vars.Set("StopLoop",1);
+  return true;
+}
+
+
+// BackTracker::SumParticleTankCharge before the reverse particle index
+void BackTrackerComparison::ReferenceSumParticleTankCharge()
+{
+  for (auto mcHitsIt : *fMCHitsMap) {
+    std::vector<MCHit> mcHits = mcHitsIt.second;
+    for (uint mcHitIdx = 0; mcHitIdx < mcHits.size(); ++mcHitIdx) {
+
+      // technically a MCHit could have multiple parents, but they don't appear to in practice
+      // skip any cases we come across
+      std::vector<int> parentIdxs = *(mcHits[mcHitIdx].GetParents());
+      if (parentIdxs.size() != 1) continue;
+
+      int particleId = -5;
+      for (auto it : *fMCParticleIndexMap) {
+	if (it.second == parentIdxs[0]) particleId = it.first;
+      }
+      if (particleId == -5) continue;
+
+      double depositedCharge = mcHits[mcHitIdx].GetCharge();
+      if (!fParticleToTankTotalCharge.count(particleId))
+	fParticleToTankTotalCharge.emplace(particleId, depositedCharge);
+      else
+	fParticleToTankTotalCharge.at(particleId) += depositedCharge;
+    }
+  }
+}
+
+// BackTracker::MatchMCParticle before the reverse particle index, without the logging
+void BackTrackerComparison::ReferenceMatch(std::vector<MCHit> const &mchits, int &prtId, int &prtPdg, double &eff, double &pur, double &totalCharge)
+{
+  // Loop over the hits and get all of their parents and the energy that each one contributed
+  //  be sure to bunch up all neutronic contributions
+  std::map<int, double> mapParticleToTotalClusterCharge;
+  totalCharge = 0;
+
+  for (auto mchit : mchits) {
+    std::vector<int> parentIdxs = *(mchit.GetParents());
+    if (parentIdxs.size() != 1) {
+      continue;
+    }
+
+    int particleId = -5;
+    for (auto it : *fMCParticleIndexMap) {
+      if (it.second == parentIdxs[0]) particleId = it.first;
+    }
+    if (particleId == -5) continue;
+
+    double depositedCharge = mchit.GetCharge();
+    totalCharge += depositedCharge;
+
+    if (mapParticleToTotalClusterCharge.count(particleId) == 0)
+      mapParticleToTotalClusterCharge.emplace(particleId, depositedCharge);
+    else
+      mapParticleToTotalClusterCharge[particleId] += depositedCharge;
+  }
+
+  // Loop over the particleIds to find the primary contributer to the cluster
+  double maxCharge = 0;
+  for (auto apair : mapParticleToTotalClusterCharge) {
+    if (apair.second > maxCharge) {
+      maxCharge = apair.second;
+      prtId = apair.first;
+    }
+  }
+
+  // Check that we have some charge, if not then something is wrong so pass back all -5
+  if (totalCharge > 0) {
+    eff = maxCharge/fParticleToTankTotalCharge.at(prtId);
+    pur = maxCharge/totalCharge;
+    prtPdg = (fMCParticles->at(fMCParticleIndexMap->at(prtId))).GetPdgCode();
+  } else {
+    prtId = -5;
+    eff = -5;
+    pur = -5;
+    totalCharge = -5;
+  }
+}
+
+
+int main(int argc, char** argv){
+
+  if(argc>1) n_events = atoi(argv[1]);
+
+  char dirname[] = "/tmp/BackTrackerComparisonXXXXXX";
+  if(mkdtemp(dirname)==nullptr){
+    std::cout << "BackTrackerComparison: could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  directory = dirname;
+
+  std::string chain_tools = "BackTrackerComparison BackTrackerComparison\n";
+  std::string chain_config = "verbose 0\nerror_level 0\nattempt_recover 1\nlog_mode Interactive\n"
+    "log_local_path ./log\nlog_service LogStore\nservice_publish_sec -1\nservice_kick_sec -1\n"
+    "Tools_File "+WriteFile("ToolsConfig",chain_tools)+"\nInline -1\nInteractive 0\n";
+  {
+    ToolChain chain(WriteFile("ToolChainConfig",chain_config));
+  }
+  Check(ran,"the comparison did not run, BackTracker could not be initialised");
+
+  for(const char* name : {"BackTrackerConfig","ToolsConfig","ToolChainConfig"}){
+    std::remove((directory+"/"+name).c_str());
+  }
+  rmdir(dirname);
+
+  if(failures){
+    std::cout << "BackTrackerComparison: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "BackTrackerComparison: OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,243 @@
+// Checks BeamDBCache against a local stand-in for the IF beam database: a
+// small HTTP server on 127.0.0.1 that answers every span query with a line
+// naming the device and interval it was asked for, and counts the queries.
+//  * Get and Prefetch return the response of the right chunk, each chunk is
+//    queried once
+//  * the prefetched downloads waiting for Get are bounded, and the ones the
+//    requests have passed are dropped
+//  * responses are stored on disk and read back by a later cache, except
+//    for chunks that end less than an hour ago
+//  * a failed query is rethrown by Get
+//  * destroying the cache does not wait for downloads that have not started
+// Run from the top directory after make: tests/BeamFetcherV2/BeamDBCacheTest
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <stdlib.h>
+
+#include "BeamDBCache.h"
+#include "IFBeamDBInterfaceV2.h"
+
+namespace {
+
+  // The stand-in database server
+  class DBStandIn {
+   public:
+    DBStandIn(){
+      fSocket = socket(AF_INET,SOCK_STREAM,0);
+      sockaddr_in address = {};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address.sin_port = 0;
+      socklen_t length = sizeof(address);
+      if(bind(fSocket,reinterpret_cast<sockaddr*>(&address),length)!=0 || listen(fSocket,64)!=0 ||
+         getsockname(fSocket,reinterpret_cast<sockaddr*>(&address),&length)!=0){
+        throw std::runtime_error("could not open a local socket");
+      }
+      fPort = ntohs(address.sin_port);
+      fThread = std::thread(&DBStandIn::Serve,this);
+    }
+    ~DBStandIn(){
+      fStop = true;
+      shutdown(fSocket,SHUT_RDWR);
+      close(fSocket);
+      fThread.join();
+    }
+    std::string URL() const { return "http://127.0.0.1:"+std::to_string(fPort)+"/ifbeam/data/data"; }
+    // number of queries for a device, and in total
+    int Queries(const std::string& device){ std::lock_guard<std::mutex> lock(fMutex); return fQueries[device]; }
+    int Queries(){ std::lock_guard<std::mutex> lock(fMutex); return fTotal; }
+    void SetDelay(int msec){ fDelay = msec; }
+
+   private:
+    void Serve(){
+      while(!fStop){
+        int connection = accept(fSocket,nullptr,nullptr);
+        if(connection<0) continue;
+        std::string request;
+        char buffer[4096];
+        while(request.find("\r\n\r\n")==std::string::npos){
+          ssize_t n = read(connection,buffer,sizeof(buffer));
+          if(n<=0) break;
+          request.append(buffer,n);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(int(fDelay)));
+
+        // GET /ifbeam/data/data?e=e,1d&v=E:TOR875&t0=...&t1=...&f=csv HTTP/1.1
+        std::string device = Parameter(request,"v=");
+        if(device.empty()) device = Parameter(request,"b=");
+        {
+          std::lock_guard<std::mutex> lock(fMutex);
+          ++fQueries[device];
+          ++fTotal;
+        }
+        std::string status = (device=="FAIL") ? "500 Internal Server Error" : "200 OK";
+        std::string body = device+","+Parameter(request,"t0=")+","+Parameter(request,"t1=")+"\n";
+        std::string response = "HTTP/1.1 "+status+"\r\nContent-Type: text/csv\r\nContent-Length: "
+          +std::to_string(body.size())+"\r\nConnection: close\r\n\r\n"+body;
+        ssize_t written = write(connection,response.data(),response.size());
+        (void)written;
+        close(connection);
+      }
+    }
+    static std::string Parameter(const std::string& request, const std::string& name){
+      size_t start = request.find(name);
+      if(start==std::string::npos) return "";
+      start += name.size();
+      size_t end = request.find_first_of("& ",start);
+      return request.substr(start,end-start);
+    }
+
+    int fSocket = -1;
+    int fPort = 0;
+    std::atomic<bool> fStop{false};
+    std::atomic<int> fDelay{0};
+    std::thread fThread;
+    std::mutex fMutex;
+    std::map<std::string,int> fQueries;
+    int fTotal = 0;
+  };
+
+  int failures = 0;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "BeamDBCacheTest: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  const uint64_t kChunk = 3600000;                 // ms
+  const uint64_t kStart = 1650000000000ull;        // long enough ago to be stored
+
+  // what the stand-in answers for a chunk, with the padding the span query adds
+  std::string Expected(const std::string& device, uint64_t t0, uint64_t t1){
+    char buffer[128];
+    std::snprintf(buffer,sizeof(buffer),"%s,%.3f,%.3f\n",device.c_str(),(t0-1)/1000.,(t1+1)/1000.);
+    return buffer;
+  }
+
+  bool FileExists(const std::string& name){
+    std::ifstream file(name);
+    return file.good();
+  }
+
+}
+
+
+int main(){
+
+  DBStandIn server;
+  IFBeamDBInterfaceV2::SetServerURL(server.URL());
+
+  // Get without a cache directory queries every time
+  {
+    BeamDBCache cache("",false);
+    std::string response = cache.Get("E:TOR875",kStart,kStart+kChunk);
+    Check(response==Expected("E:TOR875",kStart,kStart+kChunk),"Get returned "+response);
+    Check(server.Queries("E:TOR875")==1,"Get queried the database "+std::to_string(server.Queries("E:TOR875"))+" times");
+    Check(cache.NumQueries()==1 && cache.NumCacheHits()==0,"Get was not counted as a query");
+  }
+
+  // prefetched chunks come back in order, each queried once
+  {
+    BeamDBCache cache("",false,2,16);
+    for(uint64_t i=0; i<4; ++i) cache.Prefetch("E:THCURR",kStart+i*kChunk,kStart+(i+1)*kChunk);
+    cache.Prefetch("E:THCURR",kStart,kStart+kChunk);
+    Check(cache.NumPending()==4,"prefetching a chunk twice queued it twice");
+    for(uint64_t i=0; i<4; ++i){
+      uint64_t t0 = kStart+i*kChunk;
+      std::string response = cache.Get("E:THCURR",t0,t0+kChunk);
+      Check(response==Expected("E:THCURR",t0,t0+kChunk),"prefetched chunk "+std::to_string(i)+" returned "+response);
+    }
+    Check(server.Queries("E:THCURR")==4,"4 prefetched chunks took "+std::to_string(server.Queries("E:THCURR"))+" queries");
+    Check(cache.NumPending()==0,"prefetched chunks still pending after Get");
+  }
+
+  // the downloads waiting for Get are bounded, and passed ones are dropped
+  {
+    BeamDBCache cache("",true,2,5);
+    for(uint64_t i=0; i<20; ++i) cache.Prefetch("BNBBPMTOR",kStart+i*kChunk,kStart+(i+1)*kChunk);
+    Check(cache.NumPending()==5,std::to_string(cache.NumPending())+" downloads pending with max_pending 5");
+    uint64_t t0 = kStart+10*kChunk;
+    std::string response = cache.Get("BNBBPMTOR",t0,t0+kChunk);
+    Check(response==Expected("BNBBPMTOR",t0,t0+kChunk),"bundle chunk returned "+response);
+    Check(cache.NumPending()==0,std::to_string(cache.NumPending())+" passed downloads still pending");
+  }
+
+  // responses are kept on disk, except for chunks that are too recent
+  char dirname[] = "/tmp/BeamDBCacheTestXXXXXX";
+  if(mkdtemp(dirname)==nullptr){
+    std::cout << "BeamDBCacheTest: could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  std::string directory = dirname;
+  std::string stored_file = directory+"/E_TOR860_"+std::to_string(kStart)+"_"+std::to_string(kStart+kChunk)+".csv";
+  uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  std::string recent_file = directory+"/E_TOR860_"+std::to_string(now-kChunk)+"_"+std::to_string(now)+".csv";
+  {
+    BeamDBCache cache(directory,false);
+    cache.Get("E:TOR860",kStart,kStart+kChunk);
+    cache.Get("E:TOR860",now-kChunk,now);
+  }
+  Check(FileExists(stored_file),"response was not stored in "+stored_file);
+  Check(!FileExists(recent_file),"response of a recent chunk was stored");
+  {
+    int queries_before = server.Queries("E:TOR860");
+    BeamDBCache cache(directory,false);
+    cache.Prefetch("E:TOR860",kStart,kStart+kChunk);
+    Check(cache.NumPending()==0,"a chunk stored on disk was prefetched");
+    std::string response = cache.Get("E:TOR860",kStart,kStart+kChunk);
+    Check(response==Expected("E:TOR860",kStart,kStart+kChunk),"stored chunk returned "+response);
+    Check(cache.NumCacheHits()==1 && server.Queries("E:TOR860")==queries_before,"stored chunk was queried again");
+  }
+  std::remove(stored_file.c_str());
+  rmdir(dirname);
+
+  // failed queries are rethrown, prefetched or not
+  {
+    BeamDBCache cache("",false);
+    cache.Prefetch("FAIL",kStart,kStart+kChunk);
+    bool thrown = false;
+    try { cache.Get("FAIL",kStart,kStart+kChunk); } catch(const std::runtime_error&){ thrown = true; }
+    Check(thrown,"a failed prefetched query did not throw");
+    thrown = false;
+    try { cache.Get("FAIL",kStart+kChunk,kStart+2*kChunk); } catch(const std::runtime_error&){ thrown = true; }
+    Check(thrown,"a failed query did not throw");
+  }
+
+  // destroying the cache only waits for the downloads that are running
+  {
+    server.SetDelay(50);
+    int queries_before = server.Queries();
+    auto start = std::chrono::steady_clock::now();
+    {
+      BeamDBCache cache("",false,1,64);
+      for(uint64_t i=0; i<20; ++i) cache.Prefetch("E:TOR875",kStart+i*kChunk,kStart+(i+1)*kChunk);
+    }
+    double msec = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    Check(server.Queries()-queries_before<=2,std::to_string(server.Queries()-queries_before)+" queued downloads ran after the cache was destroyed");
+    Check(msec<500.,"destroying the cache took "+std::to_string(msec)+" ms");
+    server.SetDelay(0);
+  }
+
+  if(failures){
+    std::cout << "BeamDBCacheTest: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "BeamDBCacheTest: OK" << std::endl;
+  return 0;
+}
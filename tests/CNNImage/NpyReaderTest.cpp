@@ -0,0 +1,210 @@
+// Writes the same random event images through CNNImage's csv writer and
+// through the .npy tensor writer, reads the .npy file back the way numpy.load
+// does, and checks that
+//  * the header is a valid NPY 1.0 header of float32 data with shape
+//    (events, channels, y, x), its length a multiple of 64
+//  * every pixel, printed the way the csv writer prints it, is the csv value
+//  * the event count is right when the number of events is not a multiple of
+//    the chunk size, and the file is readable up to the last full chunk
+//    before it is closed
+// Run from the top directory after make: tests/CNNImage/NpyReaderTest
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "CNNImage.h"
+#include "TensorWriter.h"
+
+namespace {
+
+  const size_t kNX = 16;
+  const size_t kNY = 10;
+  const size_t kPixels = kNX*kNY;
+  const size_t kEvents = 50;
+  const size_t kChunk = 7;
+
+  int failures = 0;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "NpyReaderTest: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  // what numpy.load needs from the file: the shape and the data
+  struct Npy {
+    std::vector<size_t> shape;
+    std::vector<float> data;
+  };
+
+  bool ReadNpy(const std::string& filename, Npy& npy, bool complete = true){
+    std::ifstream file(filename, std::ios::binary);
+    char preamble[10];
+    if(!file.read(preamble,10) || std::memcmp(preamble,"\x93NUMPY\x01\x00",8)!=0){
+      Check(false,filename+": not an NPY 1.0 file");
+      return false;
+    }
+    size_t dict_size = (unsigned char)preamble[8] | ((unsigned char)preamble[9] << 8);
+    Check((10+dict_size)%64==0,filename+": header length "+std::to_string(10+dict_size)+" is not a multiple of 64");
+    std::string dict(dict_size,' ');
+    if(!file.read(&dict[0],dict_size) || dict.back()!='\n'){
+      Check(false,filename+": header is not terminated by a newline");
+      return false;
+    }
+    Check(dict.find("'descr': '<f4'")!=std::string::npos,filename+": data are not little endian float32: "+dict);
+    Check(dict.find("'fortran_order': False")!=std::string::npos,filename+": data are not in C order: "+dict);
+
+    size_t start = dict.find("'shape': (");
+    size_t end = dict.find(')',start);
+    if(start==std::string::npos || end==std::string::npos){
+      Check(false,filename+": no shape in the header: "+dict);
+      return false;
+    }
+    std::stringstream shape(dict.substr(start+10,end-start-10));
+    std::string dim;
+    size_t size = 1;
+    npy.shape.clear();
+    while(std::getline(shape,dim,',')){
+      if(dim.find_first_not_of(' ')==std::string::npos) continue;
+      npy.shape.push_back(std::stoul(dim));
+      size *= npy.shape.back();
+    }
+
+    npy.data.assign(size,0.f);
+    file.read(reinterpret_cast<char*>(npy.data.data()),size*sizeof(float));
+    Check(bool(file),filename+": shorter than its shape says");
+    if(complete) Check(file.peek()==EOF,filename+": longer than its shape says");
+    return bool(file);
+  }
+
+  std::vector<std::string> Split(const std::string& line){
+    std::vector<std::string> values;
+    std::stringstream ss(line);
+    std::string value;
+    while(std::getline(ss,value,',')) values.push_back(value);
+    return values;
+  }
+
+}
+
+
+int main(){
+
+  char dirname[] = "/tmp/NpyReaderTestXXXXXX";
+  if(mkdtemp(dirname)==nullptr){
+    std::cout << "NpyReaderTest: could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  std::string directory = dirname;
+  std::string npy_name = directory+"/images_pmt.npy";
+  std::vector<std::string> csv_names;
+  for(int i_channel=0; i_channel<cnnimage::kNumChannels; ++i_channel){
+    csv_names.push_back(directory+"/images_"+cnnimage::ChannelName(i_channel)+".csv");
+  }
+
+  // charges summed over several PMTs per pixel, times set per pixel, with
+  // values of very different sizes so that the csv rounding matters
+  CNNImage tool;
+  cnnimage::Image image;
+  image.Resize(kPixels);
+  cnnimage::NpyWriter writer;
+  std::string error;
+  if(!writer.Open(npy_name,{size_t(cnnimage::kNumChannels),kNY,kNX},kChunk,error)){
+    std::cout << "NpyReaderTest: " << error << std::endl;
+    return 1;
+  }
+  std::vector<std::ofstream> csv_files(cnnimage::kNumChannels);
+  for(int i_channel=0; i_channel<cnnimage::kNumChannels; ++i_channel) csv_files.at(i_channel).open(csv_names.at(i_channel));
+
+  std::mt19937 random(3);
+  std::uniform_real_distribution<double> uniform(0.,1.);
+  for(size_t i_event=0; i_event<kEvents; ++i_event){
+    image.Reset();
+    for(int i_hit=0; i_hit<200; ++i_hit){
+      int pixel = random()%kPixels;
+      double charge = std::pow(10.,6.*uniform(random)-3.);
+      image.Add(cnnimage::kCharge,pixel,charge/1000.);
+      image.Add(cnnimage::kChargeAbs,pixel,charge);
+      image.Set(cnnimage::kTime,pixel,uniform(random));
+      image.Set(cnnimage::kTimeFirst,pixel,uniform(random));
+      image.Set(cnnimage::kTimeAbs,pixel,2000.*uniform(random)-500.);
+      image.Set(cnnimage::kTimeFirstAbs,pixel,2000.*uniform(random)-500.);
+    }
+    for(int i_channel=0; i_channel<cnnimage::kNumChannels; ++i_channel){
+      tool.WriteImageCSV(csv_files.at(i_channel),image.Plane(i_channel),kPixels);
+    }
+    float* event = writer.NewEvent();
+    if(event==nullptr){
+      std::cout << "NpyReaderTest: writing event " << i_event << " failed" << std::endl;
+      return 1;
+    }
+    for(int i_channel=0; i_channel<cnnimage::kNumChannels; ++i_channel){
+      std::copy(image.Plane(i_channel),image.Plane(i_channel)+kPixels,event+i_channel*kPixels);
+    }
+
+    // an interrupted job leaves a file with the full chunks written so far
+    if(i_event==2*kChunk){
+      Npy partial;
+      if(ReadNpy(npy_name,partial,false)){
+        size_t n_partial = (partial.shape.empty()) ? 0 : partial.shape.at(0);
+        Check(n_partial==2*kChunk,"unclosed file has "+std::to_string(n_partial)+" events instead of "+std::to_string(2*kChunk));
+      }
+    }
+  }
+  Check(writer.Close(),"closing the npy file failed");
+  for(auto& csv_file : csv_files) csv_file.close();
+
+  Npy npy;
+  if(ReadNpy(npy_name,npy)){
+    std::vector<size_t> expected_shape = {kEvents,size_t(cnnimage::kNumChannels),kNY,kNX};
+    Check(npy.shape==expected_shape,"npy shape has "+std::to_string(npy.shape.size())+" dimensions, or wrong sizes");
+    for(int i_channel=0; i_channel<cnnimage::kNumChannels && npy.shape==expected_shape; ++i_channel){
+      std::ifstream csv_file(csv_names.at(i_channel));
+      std::string line;
+      size_t i_event = 0;
+      bool same = true;
+      while(same && std::getline(csv_file,line)){
+        std::vector<std::string> values = Split(line);
+        if(i_event>=kEvents || values.size()!=kPixels){
+          Check(false,std::string(cnnimage::ChannelName(i_channel))+" csv line "+std::to_string(i_event)
+                +" has "+std::to_string(values.size())+" values");
+          same = false;
+          break;
+        }
+        const float* event = npy.data.data() + (i_event*cnnimage::kNumChannels + i_channel)*kPixels;
+        for(size_t i_pixel=0; i_pixel<kPixels; ++i_pixel){
+          std::stringstream printed;
+          printed << event[i_pixel];
+          if(printed.str()!=values.at(i_pixel)){
+            Check(false,std::string(cnnimage::ChannelName(i_channel))+" event "+std::to_string(i_event)+" pixel "
+                  +std::to_string(i_pixel)+": npy "+printed.str()+", csv "+values.at(i_pixel));
+            same = false;
+            break;
+          }
+        }
+        ++i_event;
+      }
+      Check(i_event==kEvents,std::string(cnnimage::ChannelName(i_channel))+" csv has "+std::to_string(i_event)+" events");
+    }
+  }
+
+  std::remove(npy_name.c_str());
+  for(const std::string& name : csv_names) std::remove(name.c_str());
+  rmdir(dirname);
+
+  if(failures){
+    std::cout << "NpyReaderTest: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "NpyReaderTest: OK" << std::endl;
+  return 0;
+}
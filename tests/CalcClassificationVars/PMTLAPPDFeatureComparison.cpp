@@ -0,0 +1,830 @@
+// Computes the PMT/LAPPD classification variables of random events with
+// CalcClassificationVars::ClassificationVarsPMTLAPPD and with a copy of the
+// per-digit code it replaced (ReferenceFeatures below, kept as it was apart
+// from the logging), and checks that
+//  * the int variables are equal and the double variables and vectors agree
+//    to 1e-9 relative, with the same keys
+//  * the PMTLAPPDFeatures row in the Classification store holds the values
+//    of the maps, in the order of classvars::FeatureName
+// Both versions take the likelihoods from TH1::Chi2Test of their event
+// histograms against toy pdfs, written to ROOT files and read by
+// InitialisePDFs, so the likelihoods check that the tool bins the digits as
+// the old code filled its histograms. The events are data and MC, with and without single PE gains, with no hits, one hit,
+// LAPPD hits, and tubes that move between events.
+// The tool logs through the ToolChain, so the comparison runs as a tool in a
+// ToolChain of its own.
+// Run from the top directory after make:
+//   tests/CalcClassificationVars/PMTLAPPDFeatureComparison [events, default 3000]
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "TError.h"
+#include "TFile.h"
+#include "TH1F.h"
+#include "TMath.h"
+
+#include "CalcClassificationVars.h"
+#include "ToolChain.h"
+#include "ToolRegistry.h"
+
+namespace {
+
+  int n_events = 3000;
+  std::string directory;
+  bool ran = false;
+  int failures = 0;
+
+  const double kTolerance = 1e-9;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "PMTLAPPDFeatureComparison: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  // events with one hit have some 0/0 and x/0 variables, in both versions
+  bool Same(double a, double b){ return (a==b) || (std::isnan(a) && std::isnan(b)); }
+  bool Close(double a, double b){
+    if(Same(a,b)) return true;
+    return std::fabs(a-b) <= kTolerance*std::max(std::fabs(a),std::fabs(b));
+  }
+
+  struct Features {
+    std::map<std::string,int> ints;
+    std::map<std::string,double> doubles;
+    std::map<std::string,std::vector<double>> vectors;
+  };
+
+  std::string WriteFile(const std::string& name, const std::string& content){
+    std::string path = directory+"/"+name;
+    std::ofstream file(path);
+    file << content;
+    return path;
+  }
+
+  // toy pdfs with the names and binning InitialisePDFs expects; the charge
+  // pdfs are rebinned by 50 when they are read
+  std::string WritePDFs(const std::string& name, const std::vector<std::string>& samples, std::mt19937& random){
+    std::string path = directory+"/"+name;
+    TFile file(path.c_str(),"RECREATE");
+    std::uniform_real_distribution<double> weight(0.2,1.2);
+    for(size_t i_sample=0; i_sample<samples.size(); ++i_sample){
+      const std::string& sample = samples.at(i_sample);
+      TH1F charge(("pdf_"+sample+"_charge").c_str(),"charge",1000,0.,200.);
+      TH1F time(("pdf_"+sample+"_time").c_str(),"time",100,-10.,40.);
+      TH1F theta(("pdf_"+sample+"_thetaB").c_str(),"theta",100,-3.2,3.2);
+      TH1F phi(("pdf_"+sample+"_phiB").c_str(),"phi",100,-3.2,3.2);
+      std::normal_distribution<double> q(40.+5.*i_sample,30.), t(5.+0.5*i_sample,5.), angle(0.,0.6+0.1*i_sample);
+      for(TH1F* hist : {&charge,&time,&theta,&phi}) hist->Sumw2();
+      for(int i=0; i<20000; ++i){
+        charge.Fill(q(random),weight(random));
+        time.Fill(t(random),weight(random));
+        theta.Fill(angle(random),weight(random));
+        phi.Fill(angle(random),weight(random));
+      }
+      for(TH1F* hist : {&charge,&time,&theta,&phi}){
+        hist->Scale(1./hist->Integral());
+        hist->Write();
+      }
+    }
+    file.Close();
+    return path;
+  }
+
+}
+
+
+// Sets the inputs of a CalcClassificationVars for random events and compares
+// its PMT/LAPPD variables with ReferenceFeatures. A friend of CalcClassificationVars.
+class PMTLAPPDFeatureComparison: public Tool {
+ public:
+  bool Initialise(std::string, DataModel& data);
+  bool Execute();
+  bool Finalise(){
+    for(TH1F* hist : {event_charge,event_time,event_theta,event_phi}) delete hist;
+    if(m_data->Stores.count("Classification")) delete m_data->Stores["Classification"];
+    m_data->Stores.erase("Classification");
+    return true;
+  }
+ private:
+  void ReferenceFeatures(Features& out);
+  void Compare(const Features& reference, const std::string& what);
+
+  CalcClassificationVars features;
+  TH1F* event_charge = nullptr;
+  TH1F* event_time = nullptr;
+  TH1F* event_theta = nullptr;
+  TH1F* event_phi = nullptr;
+};
+REGISTER_TOOL(PMTLAPPDFeatureComparison);
+
+
+bool PMTLAPPDFeatureComparison::Initialise(std::string, DataModel& data){
+
+  m_data = &data;
+  m_data->Stores["Classification"] = new BoostStore(false,0);
+
+  std::mt19937 random(11);
+  features.m_data = &data;
+  features.verbosity = 0;
+  features.isData = false;
+  features.charge_conversion = 1.375;
+  features.pdf_emu = WritePDFs("pdf_emu.root",{"beamlike_muon","beamlike_electron"},random);
+  features.pdf_rings = WritePDFs("pdf_rings.root",{"beam_single","beam_multi"},random);
+  features.InitialisePDFs();
+
+  // the histograms of the old code, binned like the tool's
+  event_charge = static_cast<TH1F*>(features.event_charge->Clone("reference_charge"));
+  event_time = static_cast<TH1F*>(features.event_time->Clone("reference_time"));
+  event_theta = static_cast<TH1F*>(features.event_theta->Clone("reference_theta"));
+  event_phi = static_cast<TH1F*>(features.event_phi->Clone("reference_phi"));
+  for(TH1F* hist : {event_charge,event_time,event_theta,event_phi}) hist->SetDirectory(nullptr);
+  return true;
+}
+
+
+bool PMTLAPPDFeatureComparison::Execute(){
+
+  std::mt19937 random(7);
+  std::uniform_real_distribution<double> uniform(0.,1.);
+
+  // tank PMTs 1-130 on a cylinder around the tank center (cm), LAPPDs 1000-1004
+  std::vector<Position> tubes(131,Position(0,0,0));
+  for(int i_tube=1; i_tube<=130; ++i_tube){
+    double phi = 2*TMath::Pi()*uniform(random);
+    tubes.at(i_tube) = Position(130.*cos(phi),300.*(uniform(random)-0.5),130.*sin(phi));
+  }
+  std::map<unsigned long,double> gains;
+  for(int i_tube=1; i_tube<=130; ++i_tube) if(i_tube%3) gains[i_tube] = 0.8+0.4*uniform(random);
+  std::vector<RecoCluster*> clusters(3,nullptr);
+  features.fHitCleaningClusters = &clusters;
+
+  for(int i_event=0; i_event<n_events; ++i_event){
+
+    // first half MC, second half data with gains; the tool is set up for one
+    // or the other, so the per-tube cache starts again when it changes
+    bool is_data = (2*i_event >= n_events);
+    if(is_data != features.isData) features.tube_angles.clear();
+    features.isData = is_data;
+    features.pmt_gains = (is_data) ? gains : std::map<unsigned long,double>();
+    if(i_event%250 == 249) tubes.at(1+(i_event/250)%130).SetY(tubes.at(1+(i_event/250)%130).Y()+1.);
+
+    features.pos = Position(uniform(random)-0.5,uniform(random)-0.5,uniform(random)-0.5);
+    features.pos_x = features.pos.X();
+    features.pos_y = features.pos.Y();
+    features.pos_z = features.pos.Z();
+    double theta = 0.5*uniform(random), phi = 2*TMath::Pi()*uniform(random);
+    features.dir_x = sin(theta)*cos(phi);
+    features.dir_y = sin(theta)*sin(phi);
+    features.dir_z = cos(theta);
+
+    std::vector<RecoDigit> digits;
+    int n_pmt = (i_event%17 == 0) ? ((i_event%34 == 0) ? 0 : 1) : 1+int(120*uniform(random));
+    for(int i_hit=0; i_hit<n_pmt; ++i_hit){
+      int tube = 1+int(130*uniform(random))%130;
+      RecoDigit digit(0,tubes.at(tube),-5.+30.*uniform(random),150.*uniform(random),0,tube);
+      digit.SetFilter(uniform(random) < 0.6);
+      digits.push_back(digit);
+    }
+    int n_lappd = (i_event%5) ? int(20*uniform(random)) : 0;
+    for(int i_hit=0; i_hit<n_lappd; ++i_hit){
+      Position strip(100.*uniform(random)-50.,100.*uniform(random)-50.,-30.);
+      digits.push_back(RecoDigit(0,strip,20.*uniform(random),3.*uniform(random),1,1000+i_hit%5));
+    }
+    features.RecoDigits = &digits;
+
+    Features reference;
+    ReferenceFeatures(reference);
+    features.classification_map_int.clear();
+    features.classification_map_double.clear();
+    features.classification_map_vector.clear();
+    features.ClassificationVarsPMTLAPPD();
+    Compare(reference,std::string((is_data) ? "data" : "MC")+" event "+std::to_string(i_event)
+            +" ("+std::to_string(n_pmt)+" PMT, "+std::to_string(n_lappd)+" LAPPD hits)");
+    if(failures > 20) break;
+  }
+
+  features.RecoDigits = nullptr;
+  features.fHitCleaningClusters = nullptr;
+  ran = true;
+  m_data->vars.Set("StopLoop",1);
+  return true;
+}
+
+
+void PMTLAPPDFeatureComparison::Compare(const Features& reference, const std::string& what){
+
+  Check(reference.ints == features.classification_map_int,what+": int variables differ");
+  Check(reference.doubles.size() == features.classification_map_double.size(),
+        what+": "+std::to_string(features.classification_map_double.size())+" double variables, expected "
+        +std::to_string(reference.doubles.size()));
+  for(const auto& variable : reference.doubles){
+    auto found = features.classification_map_double.find(variable.first);
+    if(found == features.classification_map_double.end()){
+      Check(false,what+": "+variable.first+" is missing");
+    } else if(!Close(variable.second,found->second)){
+      char values[128];
+      std::snprintf(values,sizeof(values),"%.17g instead of %.17g",found->second,variable.second);
+      Check(false,what+": "+variable.first+" is "+values);
+    }
+  }
+  Check(reference.vectors.size() == features.classification_map_vector.size(),what+": vector variables differ");
+  for(const auto& variable : reference.vectors){
+    auto found = features.classification_map_vector.find(variable.first);
+    if(found == features.classification_map_vector.end() || found->second.size() != variable.second.size()){
+      Check(false,what+": "+variable.first+" is missing or has the wrong size");
+      continue;
+    }
+    for(size_t i=0; i<variable.second.size(); ++i){
+      if(!Close(variable.second.at(i),found->second.at(i))){
+        Check(false,what+": "+variable.first+" differs at "+std::to_string(i));
+        break;
+      }
+    }
+  }
+
+  std::vector<double> row;
+  if(!m_data->Stores["Classification"]->Get("PMTLAPPDFeatures",row) || row.size() != classvars::kNFeatures){
+    Check(false,what+": no PMTLAPPDFeatures row");
+    return;
+  }
+  int n_features = (features.isData) ? classvars::kFirstMCFeature : classvars::kNFeatures;
+  for(int i_feature=0; i_feature<n_features; ++i_feature){
+    std::string name = classvars::FeatureName(i_feature);
+    bool same = (classvars::IsIntFeature(i_feature)) ? (features.classification_map_int.count(name) && features.classification_map_int.at(name) == int(row.at(i_feature)))
+      : (features.classification_map_double.count(name) && Same(features.classification_map_double.at(name),row.at(i_feature)));
+    Check(same,what+": PMTLAPPDFeatures entry "+std::to_string(i_feature)+" is not "+name);
+  }
+}
+
+
+// CalcClassificationVars::ClassificationVarsPMTLAPPD before the features were
+// computed in one pass over digit columns, without the logging
+void PMTLAPPDFeatureComparison::ReferenceFeatures(Features& out){
+
+	// the tool's inputs and outputs, under the names the old code used
+	std::vector<RecoDigit>* RecoDigits = features.RecoDigits;
+	std::vector<RecoCluster*>* fHitCleaningClusters = features.fHitCleaningClusters;
+	const bool isData = features.isData;
+	const std::map<unsigned long,double>& pmt_gains = features.pmt_gains;
+	const double charge_conversion = features.charge_conversion;
+	const double pos_x = features.pos_x, pos_y = features.pos_y, pos_z = features.pos_z;
+	const double dir_x = features.dir_x, dir_y = features.dir_y, dir_z = features.dir_z;
+	Position pos = features.pos;
+	const double cherenkov_angle = features.cherenkov_angle;
+	TH1F *pdf_mu_charge = features.pdf_mu_charge, *pdf_mu_time = features.pdf_mu_time;
+	TH1F *pdf_mu_theta = features.pdf_mu_theta, *pdf_mu_phi = features.pdf_mu_phi;
+	TH1F *pdf_e_charge = features.pdf_e_charge, *pdf_e_time = features.pdf_e_time;
+	TH1F *pdf_e_theta = features.pdf_e_theta, *pdf_e_phi = features.pdf_e_phi;
+	TH1F *pdf_single_charge = features.pdf_single_charge, *pdf_single_time = features.pdf_single_time;
+	TH1F *pdf_single_theta = features.pdf_single_theta, *pdf_single_phi = features.pdf_single_phi;
+	TH1F *pdf_multi_charge = features.pdf_multi_charge, *pdf_multi_time = features.pdf_multi_time;
+	TH1F *pdf_multi_theta = features.pdf_multi_theta, *pdf_multi_phi = features.pdf_multi_phi;
+	std::map<std::string,int>& classification_map_int = out.ints;
+	std::map<std::string,double>& classification_map_double = out.doubles;
+	std::map<std::string,std::vector<double>>& classification_map_vector = out.vectors;
+
+	event_charge->Reset();
+	event_time->Reset();
+	event_theta->Reset();
+	event_phi->Reset();
+
+	// Information available both in data & MC
+	double pmt_QDownstream=0.;
+	double pmt_avgT=0.;
+	double pmt_varT=0.;
+	Position pmtBaryQ(0.,0.,0.);
+	Position pmtBaryQ_Clustered(0.,0.,0.);
+	Position pmtBaryQ_NonClustered(0.,0.,0.);
+	double pmt_totalQ=0.;
+	double pmt_totalQ_Clustered=0.;
+	double pmt_totalQ_NonClustered=0.;
+	double pmt_highestQ=0.;
+	int pmt_hits=0;
+	int pmt_hits_late=0;
+	int pmt_hits_early=0;
+	int pmt_hits_lowq=0;
+	Position lappdBaryQ(0.,0.,0.);
+	double lappd_totalQ=0.;
+	double lappd_avgT=0.;
+	double lappd_varT=0.;
+	int lappd_hits=0;
+	std::vector<double> pmtQ, lappdQ, pmtT, pmtT_tof, lappdT, lappdT_tof, pmtID, lappdID;
+	std::vector<Position> pmtPos, lappdPos;
+	std::vector<double> pmtDist, pmtTheta, pmtPhi, pmtThetaBary, pmtPhiBary, pmtY, lappdDist, lappdTheta, lappdThetaBary, pmtThetaMC, pmtThetaBaryMC, lappdThetaMC, lappdThetaBaryMC;
+	double pmt_rmsTheta=0.;
+	double pmt_rmsThetaMC=0.;
+	double pmt_rmsPhi=0.;
+	double pmt_avgDist=0.;
+	double lappd_rmsTheta=0.;
+	double lappd_rmsThetaMC=0.;
+	double lappd_avgDist=0.;
+
+ 	// Information only available when using mctruth information
+	double pmt_QRing=0.;
+	int pmt_hitsRing=0;
+	double lappd_QRing=0.;
+	int lappd_hitsRing=0;
+
+	for (unsigned int i_digit = 0; i_digit < RecoDigits->size(); i_digit++){
+		RecoDigit thisdigit = RecoDigits->at(i_digit);
+		Position detector_pos = thisdigit.GetPosition();
+		detector_pos.UnitToMeter();
+		Direction detector_dir(detector_pos.X()-pos_x,detector_pos.Y()-pos_y,detector_pos.Z()-pos_z);
+		double detector_dirX = detector_pos.X()-pos_x;
+		double detector_dirY = detector_pos.Y()-pos_y;
+		double detector_dirZ = detector_pos.Z()-pos_z;
+		int digittype = thisdigit.GetDigitType();		//0 - PMTs, 1 - LAPPDs
+		double digitQ = thisdigit.GetCalCharge();
+		double digitT = thisdigit.GetCalTime();
+		double detDist, detTheta, detPhi;
+		double MCdetDist=0.;
+		double MCdetTheta;
+		int digitID = thisdigit.GetDetectorID();
+
+		if (isData){
+			if (pmt_gains.find(digitID)!=pmt_gains.end()) digitQ /= pmt_gains.at(digitID);
+			digitQ/=charge_conversion;
+		}
+
+		//Standard calculations with respect to the center of the tank
+		detDist = sqrt(pow(detector_pos.X(),2)+pow(detector_pos.Y(),2)+pow(detector_pos.Z(),2));
+		detTheta = acos((detector_pos.Z()*1.)/detDist);
+		detPhi = features.CalcArcTan(detector_pos.X(), detector_pos.Z());
+
+		if (!isData){
+			//For MC, do additional calculations with respect to interaction vertex
+			MCdetDist = sqrt(pow(detector_dirX,2)+pow(detector_dirY,2)+pow(detector_dirZ,2));
+			MCdetTheta = acos((detector_dirX*dir_x+detector_dirY*dir_y+detector_dirZ*dir_z)/MCdetDist);
+		}
+
+		if (digittype == 0){   //PMT hit
+
+			// Time/charge variables
+			pmtQ.push_back(digitQ);
+			pmtT.push_back(digitT);
+			pmtID.push_back(digitID);
+			event_charge->Fill(digitQ);
+			event_time->Fill(digitT);
+			pmtPos.push_back(detector_pos);
+			pmt_totalQ+=digitQ;
+			pmt_avgT+=digitT;
+			pmt_hits++;
+			pmtBaryQ += digitQ*detector_pos;
+			pmt_avgDist+=detDist;
+
+			// Early/late/lowQ classification
+			if (digitQ < 30) pmt_hits_lowq++;
+			if (digitT > 10) pmt_hits_late++;
+			else if (digitT < 4) pmt_hits_early++;
+			if (digitQ > pmt_highestQ) pmt_highestQ = digitQ;
+			if (detTheta < TMath::Pi()/2.) pmt_QDownstream+=digitQ;
+
+			// Angular variables
+			pmt_rmsTheta+=(detTheta*detTheta);
+			pmt_rmsPhi+=(detPhi*detPhi);
+			pmtDist.push_back(detDist);
+			pmtTheta.push_back(detTheta);
+			pmtPhi.push_back(detPhi);
+			pmtY.push_back(detector_dirY);
+			if (!isData) {
+				pmtThetaMC.push_back(MCdetTheta);
+				pmt_rmsThetaMC+=(MCdetTheta)*(MCdetTheta);
+			}
+
+			// HitCleaner filter status
+			if (thisdigit.GetFilterStatus() == 1) {
+				pmt_totalQ_Clustered+=digitQ;
+				pmtBaryQ_Clustered += digitQ*detector_pos;
+			} else {
+				pmt_totalQ_NonClustered+=digitQ;
+				pmtBaryQ_NonClustered += digitQ*detector_pos;
+			}
+
+			// Cherenkov angle-related variables
+			if (!isData){
+
+				double tof = MCdetDist/3.0e8*1e9;
+				double t_tof = digitT-tof;
+				pmtT_tof.push_back(t_tof);
+
+				if (MCdetTheta < cherenkov_angle) {
+					pmt_QRing+=digitQ;
+					pmt_hitsRing++;
+				}
+			}
+
+
+		} else if (digittype == 1){		//LAPPD hit
+
+			// Time/charge variables
+			lappdQ.push_back(digitQ);
+			lappdT.push_back(digitT);
+			lappdID.push_back(digitID);
+			lappdPos.push_back(detector_pos);
+			lappdBaryQ += digitQ*detector_pos;
+			lappd_totalQ+=digitQ;
+			lappd_hits++;
+			lappd_avgT+=digitT;
+			lappd_avgDist+=detDist;
+
+			// Angular variables
+			lappd_rmsTheta+=(detTheta*detTheta);
+			lappdDist.push_back(detDist);
+			lappdTheta.push_back(detTheta);
+			if (!isData){
+				lappd_rmsThetaMC+=(MCdetTheta)*(MCdetTheta);
+				lappdThetaMC.push_back(MCdetTheta);
+			}
+			// Cherenkov-angle related variables
+			if (!isData){
+				double tof = MCdetDist/3.0e8*1e9;
+				double t_tof = digitT-tof;
+				lappdT_tof.push_back(t_tof);
+
+				if (MCdetTheta < cherenkov_angle) {
+					lappd_QRing+=digitQ;
+					lappd_hitsRing++;
+				}
+			}
+
+		}
+
+	}
+
+	//-----------------------------------------------------------------------
+	//--------------- Calculate classification variables --------------------
+	//-----------------------------------------------------------------------
+
+	double pmt_fracRing=0.;
+	double pmt_fracRingNoWeight=0.;
+	double pmt_frachighestQ=0.;
+	double pmt_fracQDownstream=0.;
+	double pmt_fracClustered=0.;
+	double pmt_fracLowQ=0.;
+	double pmt_fracLate=0.;
+	double pmt_fracEarly=0.;
+	double lappd_fracRing=0.;
+	double pmt_ellip = 0.;
+	double pmt_qpmt=0.;
+
+	if (pmtQ.size()!=0) {
+
+		// Average PMT charge/time/barycenter
+		pmt_avgT /= pmtQ.size();
+		pmt_avgDist /= pmtQ.size();
+		pmt_rmsTheta = sqrt(pmt_rmsTheta/pmtQ.size());
+		pmt_rmsPhi = sqrt(pmt_rmsPhi/pmtQ.size());
+		pmtBaryQ = (1./pmt_totalQ)*pmtBaryQ;
+		if (pmt_totalQ_Clustered > 0.) pmtBaryQ_Clustered = (1./pmt_totalQ_Clustered)*pmtBaryQ_Clustered;
+		if (pmt_totalQ_NonClustered > 0.) pmtBaryQ_NonClustered = (1./pmt_totalQ_NonClustered)*pmtBaryQ_NonClustered;
+		pmt_qpmt = pmt_totalQ/pmtQ.size();
+
+		// PMT fractions
+		pmt_fracQDownstream = pmt_QDownstream/pmt_totalQ;
+		pmt_frachighestQ = pmt_highestQ/pmt_totalQ;
+		pmt_fracClustered = pmt_totalQ_Clustered/pmt_totalQ;
+		pmt_fracLowQ = double(pmt_hits_lowq)/pmt_hits;
+		pmt_fracLate = double(pmt_hits_late)/pmt_hits;
+		pmt_fracEarly = double(pmt_hits_early)/pmt_hits;
+
+		// PMT fractions related to Cherenkov ring
+		if (!isData){
+			pmt_fracRing = pmt_QRing/pmt_totalQ;
+			pmt_fracRingNoWeight = double(pmt_hitsRing)/pmt_hits;
+			pmt_rmsThetaMC = sqrt(pmt_rmsThetaMC/pmtQ.size());
+		}
+	}
+	if (lappdQ.size()!=0){
+
+		// Average LAPPD charge/time/barycenter
+		lappd_avgT /= lappdQ.size();
+		lappd_avgDist /= lappdQ.size();
+		lappd_rmsTheta = sqrt(lappd_rmsTheta/lappdQ.size());
+		lappdBaryQ = (1./lappd_totalQ)*lappdBaryQ;
+
+		// LAPPD fractions related to Cherenkov ring
+		if (!isData){
+			lappd_fracRing = lappd_QRing/lappd_totalQ;
+			lappd_rmsThetaMC = sqrt(lappd_rmsThetaMC/lappdQ.size());
+		}
+	}
+
+	double pmtBaryDist, pmtBaryTheta, pmtBaryPhi, pmtBaryY, lappdBaryDist, lappdBaryTheta;
+	double pmtBaryDist_Clustered, pmtBaryDist_NonClustered, pmtBaryTheta_Clustered, pmtBaryTheta_NonClustered;
+	double pmtBaryDistMC, pmtBaryThetaMC, lappdBaryDistMC, lappdBaryThetaMC;
+
+	if (!isData){
+
+		// Angle and distance of barycenter calculated with respect to interaction point and primary particle direction
+		Position dirBaryQ = pmtBaryQ-pos;
+		pmtBaryDistMC = dirBaryQ.Mag();
+		pmtBaryThetaMC = acos((dirBaryQ.X()*dir_x+dirBaryQ.Y()*dir_y+dirBaryQ.Z()*dir_z)/pmtBaryDistMC);
+		Position lappd_dirBaryQ = lappdBaryQ-pos;
+		lappdBaryDistMC = lappd_dirBaryQ.Mag();
+		lappdBaryThetaMC = acos((lappd_dirBaryQ.X()*dir_x+lappd_dirBaryQ.Y()*dir_y+lappd_dirBaryQ.Z()*dir_z)/lappdBaryDistMC);
+
+	}
+
+	// Angle and distance of barycenter calculated with respect to (0,0,0)-position and (0,0,1)-direction
+	pmtBaryDist = pmtBaryQ.Mag();
+	pmtBaryDist_Clustered = pmtBaryQ_Clustered.Mag();
+	pmtBaryDist_NonClustered = pmtBaryQ_NonClustered.Mag();
+	if (fabs(pmtBaryDist)<0.0001) {
+		pmtBaryTheta = 0;
+		pmtBaryPhi = 0.;
+		pmtBaryY = 0.;
+	} else {
+		pmtBaryTheta = acos(pmtBaryQ.Z()/pmtBaryDist);
+		pmtBaryPhi = features.CalcArcTan(pmtBaryQ.X(),pmtBaryQ.Z());
+		pmtBaryY = pmtBaryQ.Y();
+	}
+	if (fabs(pmtBaryDist_Clustered)<0.0001){
+		pmtBaryTheta_Clustered = 0.;
+	} else {
+		pmtBaryTheta_Clustered = acos(pmtBaryQ_Clustered.Z()/pmtBaryDist_Clustered);
+	}
+	if (fabs(pmtBaryDist_NonClustered)<0.0001){
+		pmtBaryTheta_NonClustered = 0.;
+	}
+	else {
+		pmtBaryTheta_NonClustered = acos(pmtBaryQ_NonClustered.Z()/pmtBaryDist_NonClustered);
+	}
+	lappdBaryDist = lappdBaryQ.Mag();
+	if (fabs(lappdBaryDist)<0.001) lappdBaryTheta=0.;
+	else lappdBaryTheta = acos(lappdBaryQ.Z()/lappdBaryDist);
+
+	double diff_barycenter_clustered = fabs(pmtBaryTheta_Clustered-pmtBaryTheta_NonClustered);
+
+	// Calculate variance/RMS of variables
+	double pmt_varTheta=0.;
+	double pmt_varThetaBary=0.;
+	double pmt_varThetaMC=0.;
+	double pmt_varThetaBaryMC=0.;
+	double pmt_varPhi=0.;
+	double pmt_varPhiBary = 0.;
+	double pmt_theta_bary = 0.;
+	double pmt_theta_baryMC = 0.;
+	double lappd_theta_bary = 0.;
+	double lappd_theta_baryMC = 0.;
+	double lappd_varTheta=0.;
+	double lappd_varThetaBary=0.;
+	double lappd_varThetaMC=0.;
+	double lappd_varThetaBaryMC=0.;
+	double pmt_rmsThetaBary=0.;
+	double pmt_rmsThetaBaryMC=0.;
+	double pmt_rmsPhiBary = 0.;
+	double lappd_rmsThetaBary=0.;
+	double lappd_rmsThetaBaryMC=0.;
+	double pmt_fracLargeAnglePhi=0.;
+	double pmt_fracLargeAngleTheta=0.;
+	int pmt_hits_largeangle_theta=0;
+	int pmt_hits_largeangle_phi=0;
+
+	// Variances and RMS of angles/times with respect to barycenter
+	for (unsigned int i_pmt=0; i_pmt < pmtQ.size(); i_pmt++){
+
+		pmt_varT+=pow(pmtT.at(i_pmt)-pmt_avgT,2);
+		pmt_varTheta+=(pow(pmtTheta.at(i_pmt),2)*pmtQ.at(i_pmt)/pmt_totalQ);
+		pmt_theta_bary = pmtTheta.at(i_pmt) - pmtBaryTheta;
+		event_theta->Fill(pmt_theta_bary);
+		pmtThetaBary.push_back(pmt_theta_bary);
+		pmt_rmsThetaBary+=pow(pmt_theta_bary,2);
+		pmt_varThetaBary+=(pow(pmt_theta_bary,2)*pmtQ.at(i_pmt)/pmt_totalQ);
+		if (!isData){
+			pmt_varThetaMC+=(pow(pmtThetaMC.at(i_pmt),2)*pmtQ.at(i_pmt)/pmt_totalQ);
+			pmt_theta_baryMC = pmtThetaMC.at(i_pmt) - pmtBaryThetaMC;
+			pmtThetaBaryMC.push_back(pmt_theta_baryMC);
+			pmt_rmsThetaBaryMC+=pow(pmt_theta_baryMC,2);
+			pmt_varThetaBaryMC+=(pow(pmt_theta_bary,2)*pmtQ.at(i_pmt)/pmt_totalQ);
+		}
+
+		pmt_varPhi+=(pow(pmtPhi.at(i_pmt),2)*pmtQ.at(i_pmt)/pmt_totalQ);
+		double pmt_phi_bary = (pmtPhi.at(i_pmt)-pmtBaryPhi);
+		if (pmt_phi_bary > TMath::Pi()) pmt_phi_bary = -(2*TMath::Pi()-pmt_phi_bary);
+		else if (pmt_phi_bary < -TMath::Pi()) pmt_phi_bary = 2*TMath::Pi()+pmt_phi_bary;
+		event_phi->Fill(pmt_phi_bary);
+		pmtPhiBary.push_back(pmt_phi_bary);
+		pmt_rmsPhiBary+=(pow(pmt_phi_bary,2));
+		pmt_varPhiBary+=(pow(pmt_phi_bary,2)*pmtQ.at(i_pmt)/pmt_totalQ);
+
+		if (fabs(pmt_theta_bary) > 0.9) pmt_hits_largeangle_theta++;
+		if (fabs(pmt_phi_bary) > 1.) pmt_hits_largeangle_phi++;
+	}
+
+	if (pmtQ.size()>0) {
+
+		pmt_varT = sqrt(pmt_varT/pmtQ.size());
+		pmt_rmsThetaBary = sqrt(pmt_rmsThetaBary/pmtQ.size());
+		pmt_rmsPhiBary = sqrt(pmt_rmsPhiBary/pmtQ.size());
+		pmt_ellip = pmt_rmsPhiBary/pmt_rmsThetaBary;
+		pmt_fracLargeAngleTheta = double(pmt_hits_largeangle_theta)/pmtQ.size();
+		pmt_fracLargeAnglePhi = double(pmt_hits_largeangle_phi)/pmtQ.size();
+		pmt_varTheta = sqrt(pmt_varTheta);
+		pmt_varPhi = sqrt(pmt_varPhi);
+		if (!isData){
+			pmt_rmsThetaBaryMC = sqrt(pmt_rmsThetaBaryMC/pmtQ.size());
+			pmt_varThetaMC = sqrt(pmt_varThetaMC);
+		}
+	}
+
+	for (unsigned int i_lappd=0; i_lappd< lappdQ.size(); i_lappd++){
+
+		lappd_varT+=pow(lappdT.at(i_lappd)-lappd_avgT,2);
+		lappd_varTheta+=(pow(lappdTheta.at(i_lappd),2)*lappdQ.at(i_lappd)/lappd_totalQ);
+		lappd_theta_bary = lappdTheta.at(i_lappd)-lappdBaryTheta;
+		lappd_rmsThetaBary+=pow(lappd_theta_bary,2);
+		lappd_varThetaBary+=(pow(lappd_theta_bary,2)*lappdQ.at(i_lappd)/lappd_totalQ);
+		lappdThetaBary.push_back(lappd_theta_bary);
+		if (!isData){
+			lappd_varThetaMC+=(pow(lappdThetaMC.at(i_lappd),2)*lappdQ.at(i_lappd)/lappd_totalQ);
+			lappd_theta_baryMC = lappdThetaMC.at(i_lappd)-lappdBaryThetaMC;
+			lappd_rmsThetaBaryMC+=pow(lappd_theta_baryMC,2);
+			lappd_varThetaBaryMC+=(pow(lappd_theta_baryMC,2)*lappdQ.at(i_lappd)/lappd_totalQ);
+			lappdThetaBaryMC.push_back(lappd_theta_baryMC);
+		}
+	}
+	if (lappdQ.size()>0) {
+		lappd_varT = sqrt(lappd_varT/lappdQ.size());
+		lappd_rmsThetaBary = sqrt(lappd_rmsThetaBary/lappdQ.size());
+		lappd_varTheta = sqrt(lappd_varTheta);
+		if (!isData){
+			lappd_rmsThetaBaryMC = sqrt(lappd_rmsThetaBaryMC/lappdQ.size());
+			lappd_varThetaMC = sqrt(lappd_varThetaMC);
+		}
+	}
+
+	// Calculate likelihood variables
+	double pmt_charge_mu = pdf_mu_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
+	double pmt_time_mu = pdf_mu_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
+	double pmt_theta_mu = pdf_mu_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
+	double pmt_phi_mu = pdf_mu_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
+	double pmt_charge_e = pdf_e_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
+	double pmt_time_e = pdf_e_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
+	double pmt_theta_e = pdf_e_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
+	double pmt_phi_e = pdf_e_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
+	double pmt_charge_likelihood = pmt_charge_e - pmt_charge_mu;
+	double pmt_time_likelihood = pmt_time_e - pmt_time_mu;
+	double pmt_theta_likelihood = pmt_theta_e - pmt_theta_mu;
+	double pmt_phi_likelihood = pmt_phi_e - pmt_phi_mu;
+
+	double pmt_charge_single = pdf_single_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
+	double pmt_time_single = pdf_single_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
+	double pmt_theta_single = pdf_single_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
+	double pmt_phi_single = pdf_single_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
+	double pmt_charge_multi = pdf_multi_charge->Chi2Test(event_charge,"UUNORMCHI2/NDF");
+	double pmt_time_multi = pdf_multi_time->Chi2Test(event_time,"UUNORMCHI2/NDF");
+	double pmt_theta_multi = pdf_multi_theta->Chi2Test(event_theta,"UUNORMCHI2/NDF");
+	double pmt_phi_multi = pdf_multi_phi->Chi2Test(event_phi,"UUNORMCHI2/NDF");
+	double pmt_charge_likelihood_rings = pmt_charge_multi - pmt_charge_single;
+	double pmt_time_likelihood_rings = pmt_time_multi - pmt_time_single;
+	double pmt_theta_likelihood_rings = pmt_theta_multi - pmt_theta_single;
+	double pmt_phi_likelihood_rings = pmt_phi_multi - pmt_phi_single;
+
+
+	// Obtain number of clusters from HitCleaner
+	int pmt_hitcleaning_clusters = fHitCleaningClusters->size();
+
+	// PMT variables
+	classification_map_double.emplace("PMTBaryTheta",pmtBaryTheta);
+	classification_map_double.emplace("PMTAvgDist",pmt_avgDist);
+	classification_map_double.emplace("PMTAvgT",pmt_avgT);
+	classification_map_double.emplace("PMTVarT",pmt_varT);
+	classification_map_double.emplace("PMTQtotal",pmt_totalQ);
+	classification_map_double.emplace("PMTQtotalClustered",pmt_totalQ_Clustered);
+	classification_map_int.emplace("PMTHits",pmt_hits);
+	classification_map_double.emplace("PMTQPerPMT",pmt_qpmt);
+	classification_map_double.emplace("PMTFracQmax",pmt_frachighestQ);
+	classification_map_double.emplace("PMTFracQdownstream",pmt_fracQDownstream);
+	classification_map_double.emplace("PMTFracClustered",pmt_fracClustered);
+	classification_map_double.emplace("PMTFracLowQ",pmt_fracLowQ);
+	classification_map_double.emplace("PMTFracEarly",pmt_fracEarly);
+	classification_map_double.emplace("PMTFracLate",pmt_fracLate);
+	classification_map_double.emplace("PMTRMSTheta",pmt_rmsTheta);
+	classification_map_double.emplace("PMTVarTheta",pmt_varTheta);
+	classification_map_double.emplace("PMTRMSThetaBary",pmt_rmsThetaBary);
+	classification_map_double.emplace("PMTVarThetaBary",pmt_varThetaBary);
+	classification_map_double.emplace("PMTRMSPhi",pmt_rmsPhi);
+	classification_map_double.emplace("PMTVarPhi",pmt_varPhi);
+	classification_map_double.emplace("PMTRMSPhiBary",pmt_rmsPhiBary);
+	classification_map_double.emplace("PMTVarPhiBary",pmt_varPhiBary);
+	classification_map_double.emplace("PMTFracLargeAnglePhi",pmt_fracLargeAnglePhi);
+	classification_map_double.emplace("PMTFracLargeAngleTheta",pmt_fracLargeAngleTheta);
+	classification_map_int.emplace("PMTHitsLargeAngleTheta",pmt_hits_largeangle_theta);
+	classification_map_int.emplace("PMTHitsLargeAnglePhi",pmt_hits_largeangle_phi);
+	classification_map_double.emplace("PMTEllip",pmt_ellip);
+	classification_map_double.emplace("PMTBaryTheta_Clustered",pmtBaryTheta_Clustered);
+	classification_map_double.emplace("PMTBaryTheta_NonClustered",pmtBaryTheta_NonClustered);
+	classification_map_double.emplace("PMTDeltaBarycenter_Clustered",diff_barycenter_clustered);
+	classification_map_double.emplace("PMTLikelihoodQ",pmt_charge_likelihood);
+	classification_map_double.emplace("PMTLikelihoodT",pmt_time_likelihood);
+	classification_map_double.emplace("PMTLikelihoodTheta",pmt_theta_likelihood);
+	classification_map_double.emplace("PMTLikelihoodPhi",pmt_phi_likelihood);
+	classification_map_double.emplace("PMTLikelihoodQRings",pmt_charge_likelihood_rings);
+	classification_map_double.emplace("PMTLikelihoodTRings",pmt_time_likelihood_rings);
+	classification_map_double.emplace("PMTLikelihoodThetaRings",pmt_theta_likelihood_rings);
+	classification_map_double.emplace("PMTLikelihoodPhiRings",pmt_phi_likelihood_rings);
+	classification_map_double.emplace("PMTHitCleaningClusters",pmt_hitcleaning_clusters);
+
+
+	// LAPPD variables
+	classification_map_double.emplace("LAPPDBaryTheta",lappdBaryTheta);
+	classification_map_double.emplace("LAPPDAvgDist",lappd_avgDist);
+	classification_map_double.emplace("LAPPDQtotal",lappd_totalQ);
+	classification_map_double.emplace("LAPPDAvgT",lappd_avgT);
+	classification_map_double.emplace("LAPPDVarT",lappd_varT);
+	classification_map_int.emplace("LAPPDHits",lappd_hits);
+	classification_map_double.emplace("LAPPDRMSTheta",lappd_rmsTheta);
+	classification_map_double.emplace("LAPPDVarTheta",lappd_varTheta);
+	classification_map_double.emplace("LAPPDRMSThetaBary",lappd_rmsThetaBary);
+	classification_map_double.emplace("LAPPDVarThetaBary",lappd_varThetaBary);
+
+
+	// PMT & LAPPD vector variables
+	classification_map_vector.emplace("PMTQVector",pmtQ);
+	classification_map_vector.emplace("PMTTVector",pmtT);
+	classification_map_vector.emplace("PMTDistVector",pmtDist);
+	classification_map_vector.emplace("PMTThetaVector",pmtTheta);
+	classification_map_vector.emplace("PMTThetaBaryVector",pmtThetaBary);
+	classification_map_vector.emplace("PMTPhiVector",pmtPhi);
+	classification_map_vector.emplace("PMTPhiBaryVector",pmtPhiBary);
+	classification_map_vector.emplace("PMTYVector",pmtY);
+	classification_map_vector.emplace("PMTIDVector",pmtID);
+	classification_map_vector.emplace("LAPPDQVector",lappdQ);
+	classification_map_vector.emplace("LAPPDTVector",lappdT);
+	classification_map_vector.emplace("LAPPDDistVector",lappdDist);
+	classification_map_vector.emplace("LAPPDThetaVector",lappdTheta);
+	classification_map_vector.emplace("LAPPDThetaBaryVector",lappdThetaBary);
+	classification_map_vector.emplace("LAPPDIDVector",lappdID);
+
+	// PMT & LAPPD mctruth variables
+	if (!isData){
+
+		classification_map_double.emplace("MCPMTFracRing",pmt_fracRing);
+		classification_map_double.emplace("MCPMTFracRingNoWeight",pmt_fracRingNoWeight);
+		classification_map_double.emplace("MCLAPPDFracRing",lappd_fracRing);
+
+		classification_map_double.emplace("MCPMTBaryTheta",pmtBaryThetaMC);
+		classification_map_double.emplace("MCPMTVarTheta",pmt_varThetaMC);
+		classification_map_double.emplace("MCPMTRMSTheta",pmt_rmsThetaMC);
+		classification_map_double.emplace("MCPMTRMSThetaBary",pmt_rmsThetaBaryMC);
+		classification_map_double.emplace("MCPMTVarThetaBary",pmt_varThetaBaryMC);
+		classification_map_vector.emplace("MCPMTThetaBaryVector",pmtThetaBaryMC);
+
+		classification_map_double.emplace("MCLAPPDBaryTheta",lappdBaryThetaMC);
+		classification_map_double.emplace("MCLAPPDVarTheta",lappd_varThetaMC);
+		classification_map_double.emplace("MCLAPPDRMSTheta",lappd_rmsThetaMC);
+		classification_map_double.emplace("MCLAPPDRMSThetaBary",lappd_rmsThetaBaryMC);
+		classification_map_double.emplace("MCLAPPDVarThetaBary",lappd_varThetaBaryMC);
+		classification_map_vector.emplace("MCLAPPDThetaBaryVector",lappdThetaBaryMC);
+
+		classification_map_vector.emplace("MCPMTTVectorTOF",pmtT_tof);
+		classification_map_vector.emplace("MCLAPPDTVectorTOF",lappdT_tof);
+	}
+
+}
+
+
+int main(int argc, char** argv){
+
+  if(argc>1) n_events = atoi(argv[1]);
+  // Chi2Test complains about the events without PMT hits
+  gErrorIgnoreLevel = kFatal;
+
+  char dirname[] = "/tmp/PMTLAPPDFeatureComparisonXXXXXX";
+  if(mkdtemp(dirname)==nullptr){
+    std::cout << "PMTLAPPDFeatureComparison: could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  directory = dirname;
+
+  std::string chain_tools = "PMTLAPPDFeatureComparison PMTLAPPDFeatureComparison\n";
+  std::string chain_config = "verbose 0\nerror_level 0\nattempt_recover 1\nlog_mode Interactive\n"
+    "log_local_path ./log\nlog_service LogStore\nservice_publish_sec -1\nservice_kick_sec -1\n"
+    "Tools_File "+WriteFile("ToolsConfig",chain_tools)+"\nInline -1\nInteractive 0\n";
+  {
+    ToolChain chain(WriteFile("ToolChainConfig",chain_config));
+  }
+  Check(ran,"the comparison did not run");
+
+  for(const char* name : {"pdf_emu.root","pdf_rings.root","ToolsConfig","ToolChainConfig"}){
+    std::remove((directory+"/"+name).c_str());
+  }
+  rmdir(dirname);
+
+  if(failures){
+    std::cout << "PMTLAPPDFeatureComparison: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "PMTLAPPDFeatureComparison: OK" << std::endl;
+  return 0;
+}
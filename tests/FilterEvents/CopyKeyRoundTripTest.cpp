@@ -0,0 +1,249 @@
+// Copies the keys of a data and a simulated ANNIEEvent entry into a filtered
+// store with annieeventkeys::CopyKey, as FilterEvents does, and checks that
+//  * every key is copied, missing and unknown keys are refused
+//  * the copies equal the source, and are copies (changing the source
+//    afterwards does not change them)
+//  * after saving the filtered store and reading it back as LoadANNIEEvent
+//    would, the entries still equal the source
+//  * TDCData is copied as Hits or MCHits according to the MCFlag passed in
+// Run from the top directory after make: tests/FilterEvents/CopyKeyRoundTripTest
+
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ADCPulse.h"
+#include "ANNIEEventKeys.h"
+#include "BoostStore.h"
+#include "Hit.h"
+#include "TimeClass.h"
+
+namespace {
+
+  int failures = 0;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "CopyKeyRoundTripTest: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  typedef std::map<unsigned long,std::vector<Hit>> HitMap;
+  typedef std::map<unsigned long,std::vector<MCHit>> MCHitMap;
+  typedef std::map<unsigned long,std::vector<std::vector<ADCPulse>>> PulseMap;
+
+  bool Same(const Hit& a, const Hit& b){
+    return a.GetTubeId()==b.GetTubeId() && a.GetTime()==b.GetTime() && a.GetCharge()==b.GetCharge();
+  }
+  bool Same(const MCHit& a, const MCHit& b){
+    return Same(static_cast<const Hit&>(a),static_cast<const Hit&>(b)) && *a.GetParents()==*b.GetParents();
+  }
+  bool Same(const ADCPulse& a, const ADCPulse& b){
+    return a.GetTubeId()==b.GetTubeId() && a.start_time()==b.start_time() && a.peak_time()==b.peak_time()
+      && a.baseline()==b.baseline() && a.sigma_baseline()==b.sigma_baseline() && a.raw_area()==b.raw_area()
+      && a.raw_amplitude()==b.raw_amplitude() && a.amplitude()==b.amplitude() && a.charge()==b.charge();
+  }
+  bool Same(const TimeClass& a, const TimeClass& b){ return a.GetNs()==b.GetNs(); }
+  template<typename T> bool Same(const T& a, const T& b){ return a==b; }
+  template<typename T> bool Same(const std::vector<T>& a, const std::vector<T>& b){
+    if(a.size()!=b.size()) return false;
+    for(size_t i=0; i<a.size(); ++i) if(!Same(a.at(i),b.at(i))) return false;
+    return true;
+  }
+  template<typename K, typename T> bool Same(const std::map<K,T>& a, const std::map<K,T>& b){
+    if(a.size()!=b.size()) return false;
+    for(auto ia=a.begin(), ib=b.begin(); ia!=a.end(); ++ia, ++ib){
+      if(ia->first!=ib->first || !Same(ia->second,ib->second)) return false;
+    }
+    return true;
+  }
+
+  template<typename T> void CheckKey(BoostStore* source, BoostStore* copy, const std::string& key, const std::string& what){
+    T expected, got;
+    if(!source->Get(key,expected)){
+      Check(false,what+": source has no "+key);
+      return;
+    }
+    if(!copy->Get(key,got)){
+      Check(false,what+": "+key+" is missing");
+      return;
+    }
+    Check(Same(expected,got),what+": "+key+" differs from the source");
+  }
+
+  // the keys of a data entry, with their types
+  void CheckDataKeys(BoostStore* source, BoostStore* copy, const std::string& what){
+    CheckKey<int>(source,copy,"RunNumber",what);
+    CheckKey<int>(source,copy,"SubrunNumber",what);
+    CheckKey<int>(source,copy,"PartNumber",what);
+    CheckKey<uint32_t>(source,copy,"EventNumber",what);
+    CheckKey<size_t>(source,copy,"LocalEventNumber",what);
+    CheckKey<uint64_t>(source,copy,"CTCTimestamp",what);
+    CheckKey<uint64_t>(source,copy,"EventTimeTank",what);
+    CheckKey<TimeClass>(source,copy,"EventTimeMRD",what);
+    CheckKey<uint32_t>(source,copy,"TriggerWord",what);
+    CheckKey<std::string>(source,copy,"MRDTriggerType",what);
+    CheckKey<std::map<std::string,bool>>(source,copy,"DataStreams",what);
+    CheckKey<std::map<std::string,int>>(source,copy,"MRDLoopbackTDC",what);
+    CheckKey<HitMap>(source,copy,"Hits",what);
+    CheckKey<HitMap>(source,copy,"AuxHits",what);
+    CheckKey<HitMap>(source,copy,"TDCData",what);
+    CheckKey<std::map<unsigned long,std::vector<int>>>(source,copy,"RawAcqSize",what);
+    CheckKey<PulseMap>(source,copy,"RecoADCData",what);
+  }
+
+  void CheckMCKeys(BoostStore* source, BoostStore* copy, const std::string& what){
+    CheckKey<bool>(source,copy,"MCFlag",what);
+    CheckKey<uint32_t>(source,copy,"EventNumber",what);
+    CheckKey<MCHitMap>(source,copy,"MCHits",what);
+    CheckKey<MCHitMap>(source,copy,"TDCData",what);
+    CheckKey<TimeClass>(source,copy,"EventTime",what);
+  }
+
+  void FillData(BoostStore* event, uint32_t event_number){
+    event->Set("RunNumber",4321);
+    event->Set("SubrunNumber",2);
+    event->Set("PartNumber",7);
+    event->Set("EventNumber",event_number);
+    event->Set("LocalEventNumber",size_t(event_number%100));
+    event->Set("CTCTimestamp",uint64_t(1650000000123456789ull+event_number));
+    event->Set("EventTimeTank",uint64_t(1650000000123450000ull+event_number));
+    event->Set("EventTimeMRD",TimeClass(1650000000123000000ull+event_number));
+    event->Set("TriggerWord",uint32_t(5));
+    event->Set("MRDTriggerType",std::string("Beam"));
+    event->Set("DataStreams",std::map<std::string,bool>{{"Tank",true},{"MRD",true},{"CTC",true},{"LAPPD",false}});
+    event->Set("MRDLoopbackTDC",std::map<std::string,int>{{"BeamLoopbackTDC",10},{"CosmicLoopbackTDC",-1}});
+
+    HitMap hits, aux_hits, tdc_data;
+    std::map<unsigned long,std::vector<int>> raw_acq_size;
+    PulseMap pulses;
+    for(unsigned long detkey=332; detkey<340; ++detkey){
+      for(int i_hit=0; i_hit<3; ++i_hit){
+        double time = 100.*i_hit+detkey+0.25*event_number;
+        hits[detkey].emplace_back(int(detkey),time,0.1*(i_hit+1));
+        aux_hits[detkey+100].emplace_back(int(detkey+100),time+1.,0.01*(i_hit+1));
+        tdc_data[detkey+1000].emplace_back(int(detkey+1000),time+4.,0.);
+      }
+      raw_acq_size[detkey] = {2000,2000,int(event_number)};
+      pulses[detkey].push_back({ADCPulse(int(detkey),10.,12.,350.5,1.25,1234,56,0.0137,0.0042)});
+      pulses[detkey].push_back({});
+    }
+    event->Set("Hits",hits);
+    event->Set("AuxHits",aux_hits);
+    event->Set("TDCData",tdc_data);
+    event->Set("RawAcqSize",raw_acq_size);
+    event->Set("RecoADCData",pulses);
+  }
+
+  void FillMC(BoostStore* event, uint32_t event_number){
+    event->Set("MCFlag",true);
+    event->Set("EventNumber",event_number);
+    event->Set("EventTime",TimeClass(uint64_t(1000)*event_number));
+    MCHitMap mc_hits, tdc_data;
+    for(unsigned long detkey=1; detkey<5; ++detkey){
+      mc_hits[detkey].emplace_back(int(detkey),1.5*detkey,2.5,std::vector<int>{0,int(detkey)});
+      tdc_data[detkey+1000].emplace_back(int(detkey+1000),3.*detkey,0.,std::vector<int>{1});
+    }
+    event->Set("MCHits",mc_hits);
+    event->Set("TDCData",tdc_data);
+  }
+
+  const std::vector<std::string> kDataKeys = {"RunNumber","SubrunNumber","PartNumber","EventNumber",
+    "LocalEventNumber","CTCTimestamp","EventTimeTank","EventTimeMRD","TriggerWord","MRDTriggerType",
+    "DataStreams","MRDLoopbackTDC","Hits","AuxHits","TDCData","RawAcqSize","RecoADCData"};
+  const std::vector<std::string> kMCKeys = {"MCFlag","EventNumber","MCHits","TDCData","EventTime"};
+
+}
+
+
+int main(){
+
+  char dirname[] = "/tmp/CopyKeyRoundTripTestXXXXXX";
+  if(mkdtemp(dirname)==nullptr){
+    std::cout << "CopyKeyRoundTripTest: could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  std::string filename = std::string(dirname)+"/filtered";
+
+  // the store FilterEvents writes, one entry per copied event
+  BoostStore* filtered = new BoostStore(false,2);
+  std::vector<BoostStore*> sources;
+
+  for(uint32_t event_number : {17u, 18u}){
+    BoostStore* source = new BoostStore(false,2);
+    FillData(source,event_number);
+    Check(!annieeventkeys::IsMC(source),"data event taken for simulation");
+    for(const std::string& key : kDataKeys){
+      Check(annieeventkeys::CopyKey(source,filtered,key,annieeventkeys::IsMC(source)),"data: could not copy "+key);
+    }
+    Check(!annieeventkeys::CopyKey(source,filtered,"MCHits",false),"data: copied MCHits that are not there");
+    source->Set("NotAnANNIEEventKey",1);
+    Check(!annieeventkeys::CopyKey(source,filtered,"NotAnANNIEEventKey",false),"data: copied an unknown key");
+
+    std::string what = "data event "+std::to_string(event_number);
+    CheckDataKeys(source,filtered,what);
+
+    // the filtered store has its own copies
+    HitMap* source_hits = nullptr;
+    HitMap filtered_hits;
+    if(source->Get("Hits",source_hits) && source_hits!=nullptr){
+      source_hits->begin()->second.front() = Hit(1,2.,3.);
+      filtered->Get("Hits",filtered_hits);
+      Check(filtered_hits.begin()->second.front().GetTubeId()!=1,what+": Hits in the filtered store changed with the source");
+      source_hits->begin()->second.front() = filtered_hits.begin()->second.front();
+    }
+
+    filtered->Save(filename);
+    filtered->Delete();
+    sources.push_back(source);
+  }
+
+  BoostStore* mc_source = new BoostStore(false,2);
+  FillMC(mc_source,19);
+  Check(annieeventkeys::IsMC(mc_source),"simulated event taken for data");
+  for(const std::string& key : kMCKeys){
+    Check(annieeventkeys::CopyKey(mc_source,filtered,key,annieeventkeys::IsMC(mc_source)),"simulation: could not copy "+key);
+  }
+  CheckMCKeys(mc_source,filtered,"simulated event");
+  filtered->Save(filename);
+  filtered->Delete();
+  filtered->Close();
+  delete filtered;
+
+  // read the file back the way LoadANNIEEvent does
+  BoostStore* reread = new BoostStore(false,2);
+  unsigned long total_entries = 0;
+  if(!reread->Initialise(filename) || !reread->Header->Get("TotalEntries",total_entries)){
+    Check(false,"could not read back "+filename);
+  } else {
+    Check(total_entries==3,"read back "+std::to_string(total_entries)+" entries instead of 3");
+    for(unsigned long i_entry=0; i_entry<total_entries && i_entry<3; ++i_entry){
+      if(!reread->GetEntry(i_entry)){
+        Check(false,"could not read back entry "+std::to_string(i_entry));
+        continue;
+      }
+      std::string what = "read back entry "+std::to_string(i_entry);
+      if(i_entry<2) CheckDataKeys(sources.at(i_entry),reread,what);
+      else CheckMCKeys(mc_source,reread,what);
+      reread->Delete();
+    }
+  }
+  reread->Close();
+  delete reread;
+
+  for(BoostStore* source : sources) delete source;
+  delete mc_source;
+  std::remove(filename.c_str());
+  rmdir(dirname);
+
+  if(failures){
+    std::cout << "CopyKeyRoundTripTest: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "CopyKeyRoundTripTest: OK" << std::endl;
+  return 0;
+}
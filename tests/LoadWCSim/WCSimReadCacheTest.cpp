@@ -0,0 +1,296 @@
+// Generates small WCSim-format files (wcsimT with the tank, MRD and FACC event
+// branches, wcsimGeoT and wcsimRootOptionsT), reads them with the wcsimT reader
+// LoadWCSim uses, with the read cache settings of mctreecache::Configure, and
+// checks that
+//  * every configuration, cached or not, with or without parallel unzip, reads
+//    the entries that were written, across the file boundaries of the chain and
+//    when entries are skipped
+//  * with no cache settings Configure leaves the tree as it is, and refuses a
+//    null tree
+//  * with the cache the same entries are read in fewer reads from the file
+// A WCSim file, or a file pattern, can be given instead of the generated files;
+// every configuration must then read the same trigger headers as the uncached
+// reader. ROOT writes the generated files with its default settings, so real
+// WCSim output (other basket sizes and compression) is the better check.
+// Run from the top directory after make:
+//   tests/LoadWCSim/WCSimReadCacheTest [wcsim file or pattern]
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "WCSimRootEvent.hh"
+#include "WCSimRootGeom.hh"
+#include "WCSimRootOptions.hh"
+
+#include "MCTreeCache.h"
+#include "wcsimT.h"
+
+namespace {
+
+  const int kFiles = 3;
+  const int kEntriesPerFile = 400;
+  const int kStartOffset = 3;   // as LoadWCSim's FileStartOffset
+  const int kBasketSize = 2000; // small baskets, so that there are many of them to read
+  const int kMaxInputEntries = 5000; // entries read from a file given on the command line
+
+  int failures = 0;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "WCSimReadCacheTest: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  // what the test reads back from an entry, set from its number when writing
+  struct EntryInfo {
+    int evtnum = -1;
+    int run = -1;
+    int date = -1;
+    bool operator==(const EntryInfo& other) const {
+      return evtnum==other.evtnum && run==other.run && date==other.date;
+    }
+  };
+
+  // the headers of the tank, MRD and FACC events of an entry
+  typedef std::array<EntryInfo,3> EntryHeaders;
+
+  EntryInfo Expected(int entry){
+    EntryInfo info;
+    info.evtnum = entry;
+    info.run = 1+entry/kEntriesPerFile;
+    info.date = 1000*entry;
+    return info;
+  }
+
+  std::vector<EntryHeaders> Expected(const std::vector<int>& entries){
+    std::vector<EntryHeaders> expected;
+    for(int entry : entries){
+      EntryInfo info = Expected(entry);
+      expected.push_back(EntryHeaders{{info,info,info}});
+    }
+    return expected;
+  }
+
+  // one file as WCSim writes it, with the entries first_entry..first_entry+kEntriesPerFile-1
+  bool WriteWCSimFile(const std::string& filename, int first_entry){
+    TFile file(filename.c_str(),"RECREATE");
+    if(file.IsZombie()) return false;
+
+    WCSimRootGeom* geometry = new WCSimRootGeom();
+    TTree* geotree = new TTree("wcsimGeoT","Geometry Tree");
+    geotree->Branch("wcsimrootgeom","WCSimRootGeom",&geometry,kBasketSize,0);
+    geotree->Fill();
+
+    WCSimRootOptions* options = new WCSimRootOptions();
+    TTree* optstree = new TTree("wcsimRootOptionsT","Options Tree");
+    optstree->Branch("wcsimrootoptions","WCSimRootOptions",&options,kBasketSize,0);
+    optstree->Fill();
+
+    WCSimRootEvent* tank = new WCSimRootEvent();
+    WCSimRootEvent* mrd = new WCSimRootEvent();
+    WCSimRootEvent* facc = new WCSimRootEvent();
+    for(WCSimRootEvent* event : {tank,mrd,facc}) event->Initialize();
+    TTree* tree = new TTree("wcsimT","WCSim Tree");
+    tree->Branch("wcsimrootevent","WCSimRootEvent",&tank,kBasketSize,2);
+    tree->Branch("wcsimrootevent_mrd","WCSimRootEvent",&mrd,kBasketSize,2);
+    tree->Branch("wcsimrootevent_facc","WCSimRootEvent",&facc,kBasketSize,2);
+    for(int entry=first_entry; entry<first_entry+kEntriesPerFile; ++entry){
+      EntryInfo info = Expected(entry);
+      for(WCSimRootEvent* event : {tank,mrd,facc}) event->GetTrigger(0)->SetHeader(info.evtnum,info.run,info.date);
+      tree->Fill();
+      for(WCSimRootEvent* event : {tank,mrd,facc}) event->ReInitialize();
+    }
+
+    file.Write();
+    file.Close();
+    delete tank;
+    delete mrd;
+    delete facc;
+    delete geometry;
+    delete options;
+    return true;
+  }
+
+  // the entries LoadWCSim would load: from the start offset on, skipping some
+  std::vector<int> EntriesToRead(int entries){
+    std::vector<int> to_read;
+    for(int entry=kStartOffset; entry<entries; ++entry){
+      if(entry%7==0) continue;
+      to_read.push_back(entry);
+    }
+    return to_read;
+  }
+
+  // reads the entries through wcsimT, as LoadWCSim does, into headers; returns
+  // the number of reads from the file of the last entry, or -1 if reading failed
+  int ReadEntries(wcsimT& reader, const std::vector<int>& entries, std::vector<EntryHeaders>& headers,
+                  const std::string& what){
+    headers.clear();
+    for(int entry : entries){
+      if(reader.GetEntry(entry)<=0){
+        Check(false,what+": could not read entry "+std::to_string(entry));
+        return -1;
+      }
+      EntryHeaders entry_headers;
+      int i_event = 0;
+      for(WCSimRootEvent* event : {reader.wcsimrootevent,reader.wcsimrootevent_mrd,reader.wcsimrootevent_facc}){
+        if(event==nullptr || event->GetNumberOfEvents()<1){
+          Check(false,what+": entry "+std::to_string(entry)+" has no trigger");
+          return -1;
+        }
+        WCSimRootEventHeader* header = event->GetTrigger(0)->GetHeader();
+        EntryInfo& got = entry_headers[i_event++];
+        got.evtnum = header->GetEvtNum();
+        got.run = header->GetRun();
+        got.date = header->GetDate();
+      }
+      headers.push_back(entry_headers);
+    }
+    TFile* file = reader.GetCurrentFile();
+    return (file==nullptr) ? -1 : file->GetReadCalls();
+  }
+
+  // reads the entries and compares their headers with the expected ones
+  int ReadAndCompare(wcsimT& reader, const std::vector<int>& entries, const std::vector<EntryHeaders>& expected,
+                     const std::string& what){
+    std::vector<EntryHeaders> headers;
+    int reads = ReadEntries(reader,entries,headers,what);
+    if(reads<0) return -1;
+    for(size_t i_entry=0; i_entry<entries.size(); ++i_entry){
+      for(size_t i_event=0; i_event<expected[i_entry].size(); ++i_event){
+        const EntryInfo& got = headers[i_entry][i_event];
+        if(got==expected[i_entry][i_event]) continue;
+        Check(false,what+": entry "+std::to_string(entries[i_entry])+" read as event "+std::to_string(got.evtnum)
+              +" of run "+std::to_string(got.run)+", expected event "+std::to_string(expected[i_entry][i_event].evtnum)
+              +" of run "+std::to_string(expected[i_entry][i_event].run));
+        return -1;
+      }
+    }
+    return reads;
+  }
+
+}
+
+
+int main(int argc, char** argv){
+
+  // the files to read, the entries to read from the whole chain and from its
+  // first file, and the headers expected in those entries
+  std::string pattern, first_file;
+  std::vector<int> chain_entries, file_entries;
+  std::vector<EntryHeaders> chain_expected, file_expected;
+  bool generated = (argc<2);
+
+  char dirname[] = "/tmp/WCSimReadCacheTestXXXXXX";
+  std::vector<std::string> filenames;
+  if(generated){
+    if(mkdtemp(dirname)==nullptr){
+      std::cout << "WCSimReadCacheTest: could not create a temporary directory" << std::endl;
+      return 1;
+    }
+    std::string directory = dirname;
+    for(int i_file=0; i_file<kFiles; ++i_file){
+      filenames.push_back(directory+"/wcsim_0."+std::to_string(i_file)+".root");
+      if(!WriteWCSimFile(filenames.back(),i_file*kEntriesPerFile)){
+        std::cout << "WCSimReadCacheTest: could not write " << filenames.back() << std::endl;
+        return 1;
+      }
+    }
+    pattern = directory+"/wcsim_0.*.root";
+    first_file = filenames.front();
+    chain_entries = EntriesToRead(kFiles*kEntriesPerFile);
+    file_entries = EntriesToRead(kEntriesPerFile);
+    chain_expected = Expected(chain_entries);
+    file_expected = Expected(file_entries);
+  } else {
+    // the headers read without a cache are the reference
+    pattern = argv[1];
+    wcsimT reader(pattern,0);
+    if(reader.GetCurrentFile()==nullptr){
+      std::cout << "WCSimReadCacheTest: could not open " << pattern << std::endl;
+      return 1;
+    }
+    first_file = reader.GetCurrentFile()->GetName();
+    reader.fChain->SetCacheSize(0);
+    chain_entries = EntriesToRead(std::min<ULong64_t>(reader.GetEntries(),kMaxInputEntries));
+    if(ReadEntries(reader,chain_entries,chain_expected,"reference")<0) return 1;
+    wcsimT file_reader(first_file,0);
+    file_reader.fChain->SetCacheSize(0);
+    file_entries = EntriesToRead(std::min<ULong64_t>(file_reader.GetEntries(),kMaxInputEntries));
+    if(ReadEntries(file_reader,file_entries,file_expected,"reference, first file")<0) return 1;
+    std::cout << "WCSimReadCacheTest: reading " << chain_entries.size() << " entries of " << pattern << std::endl;
+  }
+
+  Check(!mctreecache::Configure(nullptr,mctreecache::Config()),"Configure accepted a null tree");
+
+  // the LoadWCSim defaults: no cache settings, the tree is left as it is
+  {
+    wcsimT reader(pattern,0);
+    Long64_t cache_size = reader.fChain->GetCacheSize();
+    Check(mctreecache::Configure(reader.fChain,mctreecache::Config()),"Configure failed without cache settings");
+    Check(reader.fChain->GetCacheSize()==cache_size,"Configure changed the cache size without cache settings");
+    ReadAndCompare(reader,chain_entries,chain_expected,"default settings");
+  }
+
+  // the chain with the configurations LoadWCSim can be given
+  struct Setting {
+    std::string name;
+    mctreecache::Config config;
+    bool no_default_cache = false; // ROOT otherwise sets up a cache of its own
+  };
+  std::vector<Setting> settings(4);
+  settings[0].name = "no cache";
+  settings[0].no_default_cache = true;
+  settings[1].name = "8 MB cache";
+  settings[1].config.cache_bytes = 8*1024*1024;
+  settings[1].config.learn_entries = 10;
+  settings[2].name = "8 MB cache with parallel unzip";
+  settings[2].config = settings[1].config;
+  settings[2].config.parallel_unzip = true;
+  settings[3].name = "learning entries only";
+  settings[3].config.learn_entries = 5;
+  for(const Setting& setting : settings){
+    wcsimT reader(pattern,0);
+    if(setting.no_default_cache) reader.fChain->SetCacheSize(0);
+    Check(mctreecache::Configure(reader.fChain,setting.config),setting.name+": Configure failed");
+    ReadAndCompare(reader,chain_entries,chain_expected,setting.name);
+  }
+
+  // one file, read with and without the cache
+  int uncached_reads = -1, cached_reads = -1;
+  {
+    wcsimT reader(first_file,0);
+    reader.fChain->SetCacheSize(0);
+    uncached_reads = ReadAndCompare(reader,file_entries,file_expected,"one file without cache");
+  }
+  {
+    wcsimT reader(first_file,0);
+    Check(mctreecache::Configure(reader.fChain,settings[1].config),"one file: Configure failed");
+    cached_reads = ReadAndCompare(reader,file_entries,file_expected,"one file with cache");
+  }
+  std::cout << "WCSimReadCacheTest: " << file_entries.size() << " entries read in " << uncached_reads
+            << " reads without cache, " << cached_reads << " with cache" << std::endl;
+  if(uncached_reads>0 && cached_reads>0){
+    Check(cached_reads<uncached_reads,"the cache did not reduce the number of reads");
+  }
+
+  if(generated){
+    for(const std::string& filename : filenames) std::remove(filename.c_str());
+    rmdir(dirname);
+  }
+
+  if(failures){
+    std::cout << "WCSimReadCacheTest: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "WCSimReadCacheTest: OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,231 @@
+// Compares the batched track geometry of MCParticleProperties (TrackGeometryBatch)
+// with the per-particle functions it replaced, on random track segments, and
+// checks that they agree bit for bit (NaN equal to NaN):
+//  * BoxIntercepts against CheckLineBox on the MRD box: return value, error
+//    flag, entry and exit points
+//  * ProjectedPlaneHits against CheckProjectedMRDHit
+//  * InTank against the containment cuts the tool used to make per particle
+//  * TankIntercepts against CheckTankIntercepts and ProjectTankExits against
+//    ProjectTankIntercepts, except for the tracks they flag for the scalar code
+// Besides uniform segments the sample has the awkward ones: in or near a z plane,
+// starting at the origin, along z, in planes parallel to the MRD sides, starting
+// on the MRD front face, and close to the tank.
+// The per-particle functions log through the ToolChain, so the comparison runs
+// as a tool in a ToolChain of its own.
+// Run from the top directory after make:
+//   tests/MCParticleProperties/TrackGeometryValidation [segments, default 2000000]
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Geometry.h"
+#include "MCParticleProperties.h"
+#include "Position.h"
+#include "ToolChain.h"
+#include "ToolRegistry.h"
+#include "TrackGeometryBatch.h"
+
+namespace {
+
+  size_t n_segments = 2000000;
+  std::string directory;
+  bool ran = false;
+  int failures = 0;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "TrackGeometryValidation: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  bool Same(double a, double b){ return (a==b) || (std::isnan(a) && std::isnan(b)); }
+  bool Same(const Position& a, const Position& b){ return Same(a.X(),b.X()) && Same(a.Y(),b.Y()) && Same(a.Z(),b.Z()); }
+
+  std::string Print(const Position& p){
+    char buffer[128];
+    std::snprintf(buffer,sizeof(buffer),"(%.17g, %.17g, %.17g)",p.X(),p.Y(),p.Z());
+    return buffer;
+  }
+
+  // counts the mismatches of one comparison and prints the first few
+  struct Mismatches {
+    std::string name;
+    long count = 0;
+    long compared = 0;
+    long hits = 0;
+    void Add(bool same, bool hit, size_t i, const Position& start, const Position& stop){
+      ++compared;
+      if(hit) ++hits;
+      if(same) return;
+      if(count<5) std::cout << "TrackGeometryValidation: " << name << " differs for segment " << i << " "
+                            << Print(start) << " -> " << Print(stop) << std::endl;
+      ++count;
+    }
+  };
+
+  std::string WriteFile(const std::string& name, const std::string& content){
+    std::string path = directory+"/"+name;
+    std::ofstream file(path);
+    file << content;
+    return path;
+  }
+
+}
+
+
+// Runs the comparison in its Execute, with an MCParticleProperties initialised
+// in the same chain. A friend of MCParticleProperties, for the helper functions.
+class TrackGeometryValidation: public Tool {
+ public:
+  bool Initialise(std::string, DataModel& data){
+    m_data = &data;
+    BoostStore* annie_event = new BoostStore(false,2);
+    annie_event->Header->Set("AnnieGeometry",new Geometry());
+    m_data->Stores["ANNIEEvent"] = annie_event;
+    return scalar.Initialise(WriteFile("MCParticlePropertiesConfig","verbosity 0\n"),data);
+  }
+  bool Execute();
+  bool Finalise(){
+    if(m_data->Stores.count("ANNIEEvent")) delete m_data->Stores["ANNIEEvent"];
+    m_data->Stores.erase("ANNIEEvent");
+    return true;
+  }
+ private:
+  MCParticleProperties scalar;
+};
+REGISTER_TOOL(TrackGeometryValidation);
+
+
+bool TrackGeometryValidation::Execute(){
+
+  // the geometry MCParticleProperties uses: MRDSpecs, with the tank from MRDSpecs too
+  const double width = MRDSpecs::MRD_width;
+  const double height = MRDSpecs::MRD_height;
+  const double mrd_start = MRDSpecs::MRD_start;
+  const double mrd_end = MRDSpecs::MRD_end;
+  const double tank_radius = MCParticleProperties::tank_radius;
+  const double tank_start = MCParticleProperties::tank_start;
+  const double tank_yoffset = MCParticleProperties::tank_yoffset;
+  const double tank_halfheight = MCParticleProperties::tank_halfheight;
+
+  std::mt19937_64 random(12345);
+  std::uniform_real_distribution<double> uniform_x(-400.,400.), uniform_y(-400.,400.), uniform_z(-200.,600.);
+  trackgeometry::TrackBatch tracks;
+  tracks.reserve(n_segments);
+  for(size_t i=0; i<n_segments; ++i){
+    Position start(uniform_x(random),uniform_y(random),uniform_z(random));
+    Position stop(uniform_x(random),uniform_y(random),uniform_z(random));
+    switch(i%10){
+      case 1: stop.SetZ(start.Z()); break;                                   // in a z plane
+      case 2: stop.SetZ(start.Z()+1e-4); break;                              // nearly in a z plane
+      case 3: start = Position(0,0,0); break;                                // from the origin
+      case 4: stop.SetX(start.X()); stop.SetY(start.Y()); break;             // along z
+      case 5: start.SetX(std::round(start.X())); stop.SetX(start.X()); break; // in an x plane
+      case 6: start.SetZ(mrd_start); break;                                  // on the MRD front face
+      case 7: start = Position(0.3*start.X(),0.3*start.Y(),tank_start+tank_radius+0.3*(start.Z()-200.)); break; // near the tank
+      default: break;
+    }
+    tracks.push_back(start,stop);
+  }
+
+  trackgeometry::BoxGeometry mrd_box{-width,-height,mrd_start,width,height,mrd_end};
+  trackgeometry::TankGeometry tank{tank_radius,tank_start,tank_yoffset,tank_halfheight};
+  trackgeometry::InterceptBatch box_intercepts, tank_intercepts, projected_exits;
+  std::vector<uint8_t> projected_hits, starts_in_tank, stops_in_tank;
+  trackgeometry::BoxIntercepts(tracks,mrd_box,box_intercepts);
+  trackgeometry::ProjectedPlaneHits(tracks,width,height,mrd_start,projected_hits);
+  trackgeometry::InTank(tracks.start_x,tracks.start_y,tracks.start_z,tank,starts_in_tank);
+  trackgeometry::InTank(tracks.stop_x,tracks.stop_y,tracks.stop_z,tank,stops_in_tank);
+  trackgeometry::TankIntercepts(tracks,starts_in_tank,stops_in_tank,tank,tank_intercepts);
+  trackgeometry::ProjectTankExits(tracks,tank,projected_exits);
+
+  Mismatches box{"CheckLineBox"}, projected{"CheckProjectedMRDHit"}, in_tank{"tank containment"};
+  Mismatches tank_hits{"CheckTankIntercepts"}, tank_exits{"ProjectTankIntercepts"};
+  for(size_t i=0; i<tracks.size(); ++i){
+    Position start(tracks.start_x[i],tracks.start_y[i],tracks.start_z[i]);
+    Position stop(tracks.stop_x[i],tracks.stop_y[i],tracks.stop_z[i]);
+
+    Position entry(0,0,0), exit(0,0,0);
+    bool error = false;
+    bool hit = scalar.CheckLineBox(start,stop,Position(-width,-height,mrd_start),Position(width,height,mrd_end),entry,exit,error);
+    box.Add(hit==bool(box_intercepts.hit[i]) && error==bool(box_intercepts.flag[i]) &&
+            Same(entry,box_intercepts.Entry(i)) && Same(exit,box_intercepts.Exit(i)),hit,i,start,stop);
+
+    hit = scalar.CheckProjectedMRDHit(start,stop,width,height,mrd_start);
+    projected.Add(hit==bool(projected_hits[i]),hit,i,start,stop);
+
+    // the cuts MCParticleProperties::Execute made before the batch
+    bool starts_in = (std::sqrt(std::pow(start.X(),2.)+std::pow(start.Z()-tank_start-tank_radius,2.))<tank_radius) &&
+                     (std::abs(start.Y()-tank_yoffset)<tank_halfheight);
+    bool stops_in = (std::sqrt(std::pow(stop.X(),2.)+std::pow(stop.Z()-tank_start-tank_radius,2.))<tank_radius) &&
+                    (std::abs(stop.Y()-tank_yoffset)<tank_halfheight);
+    in_tank.Add(starts_in==bool(starts_in_tank[i]) && stops_in==bool(stops_in_tank[i]),starts_in,i,start,stop);
+
+    if(!tank_intercepts.flag[i]){
+      Position tank_exit(0,0,0), tank_entry(0,0,0);
+      hit = scalar.CheckTankIntercepts(start,stop,starts_in,stops_in,tank_exit,tank_entry);
+      tank_hits.Add(hit==bool(tank_intercepts.hit[i]) && Same(tank_exit,tank_intercepts.Exit(i)) &&
+                    Same(tank_entry,tank_intercepts.Entry(i)),hit,i,start,stop);
+    }
+    if(!projected_exits.flag[i]){
+      Position projected_exit(0,0,0);
+      hit = MCParticleProperties::ProjectTankIntercepts(start,stop,projected_exit);
+      tank_exits.Add(hit==bool(projected_exits.hit[i]) && Same(projected_exit,projected_exits.Exit(i)),hit,i,start,stop);
+    }
+  }
+
+  for(const Mismatches* result : {&box,&projected,&in_tank,&tank_hits,&tank_exits}){
+    std::printf("TrackGeometryValidation: %s: %ld segments compared, %ld hits, %ld differ\n",
+                result->name.c_str(),result->compared,result->hits,result->count);
+    Check(result->count==0,result->name+": "+std::to_string(result->count)+" segments differ");
+    Check(result->hits>0,result->name+": no segment hits, the sample does not test it");
+  }
+  // the flagged tracks are the ones in a z plane, the sample has about a tenth of them
+  Check(tank_hits.compared>long(tracks.size()/2) && tank_exits.compared>long(tracks.size()/2),
+        "too many segments were left to the scalar tank functions");
+
+  ran = true;
+  m_data->vars.Set("StopLoop",1);
+  return true;
+}
+
+
+int main(int argc, char** argv){
+
+  if(argc>1) n_segments = strtoul(argv[1],nullptr,10);
+
+  char dirname[] = "/tmp/TrackGeometryValidationXXXXXX";
+  if(mkdtemp(dirname)==nullptr){
+    std::cout << "TrackGeometryValidation: could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  directory = dirname;
+
+  std::string chain_tools = "TrackGeometryValidation TrackGeometryValidation\n";
+  std::string chain_config = "verbose 0\nerror_level 0\nattempt_recover 1\nlog_mode Interactive\n"
+    "log_local_path ./log\nlog_service LogStore\nservice_publish_sec -1\nservice_kick_sec -1\n"
+    "Tools_File "+WriteFile("ToolsConfig",chain_tools)+"\nInline -1\nInteractive 0\n";
+  {
+    ToolChain chain(WriteFile("ToolChainConfig",chain_config));
+  }
+  Check(ran,"the comparison did not run, MCParticleProperties could not be initialised");
+
+  for(const char* name : {"MCParticlePropertiesConfig","ToolsConfig","ToolChainConfig"}){
+    std::remove((directory+"/"+name).c_str());
+  }
+  rmdir(dirname);
+
+  if(failures){
+    std::cout << "TrackGeometryValidation: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "TrackGeometryValidation: OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,299 @@
+// Runs the same sub-chain with PipelineToolChain serially and pipelined, and
+// checks that every tool saw the same events, in the same order, with the
+// same values. The test chain has the things a pipelined chain must get right:
+//  * the head replaces the ANNIEEvent every few events, as LoadANNIEEvent
+//    does for every new file, and a pipelined tool reads its Header
+//  * the head leaves a per-event value in the CStore that an undeclared
+//    (serial) tool after the first pipelined stage reads, as ClusterFinder's
+//    ClusterMap is read by ClusterClassifiers
+//  * a tool that declares a read of that CStore value runs serially, on the
+//    calling thread, and sees the value of its own event; a tool that only
+//    declares a CStore run constant is still pipelined
+//  * the stages take different times, so that events would overtake each
+//    other if they could
+// Run from the top directory after make: tests/PipelineToolChain/PipelineOrderTest
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ToolChain.h"
+#include "ToolRegistry.h"
+
+namespace {
+
+  const uint32_t kEvents = 200;
+  const uint32_t kEventsPerFile = 7;
+  const uint32_t kRunConstant = 42;
+
+  // what each recording tool saw, per event: (EventNumber, value)
+  typedef std::vector<std::pair<uint32_t,uint64_t>> Records;
+  std::map<std::string,Records> records;
+  // the threads each recording tool ran on
+  std::map<std::string,std::set<std::thread::id>> threads;
+  std::mutex records_mutex;
+
+  void Record(const std::string& tool, uint32_t event, uint64_t value){
+    std::lock_guard<std::mutex> lock(records_mutex);
+    records[tool].push_back(std::make_pair(event,value));
+    threads[tool].insert(std::this_thread::get_id());
+  }
+
+  void Work(uint32_t event, int scale){
+    std::this_thread::sleep_for(std::chrono::microseconds(scale*(event%4)));
+  }
+
+}
+
+
+// Reads the events: sets EventNumber, and a new ANNIEEvent with the file
+// number in its Header every kEventsPerFile events
+class PipelineTestSource: public Tool {
+ public:
+  bool Initialise(std::string, DataModel& data){
+    m_data = &data;
+    event = 0;
+    m_data->CStore.Set("TestRunConstant",kRunConstant);
+    return true;
+  }
+  bool Execute(){
+    if(event%kEventsPerFile==0){
+      if(m_data->Stores.count("ANNIEEvent")) delete m_data->Stores["ANNIEEvent"];
+      BoostStore* annie_event = new BoostStore(false,2);
+      annie_event->Header->Set("TestFileNumber",event/kEventsPerFile);
+      m_data->Stores["ANNIEEvent"] = annie_event;
+    }
+    m_data->Stores["ANNIEEvent"]->Set("EventNumber",event);
+    m_data->CStore.Set("TestEventNumber",event);
+    Record("source",event,event);
+    Work(event,50);
+    if(event+1==kEvents) m_data->vars.Set("StopLoop",1);
+    ++event;
+    return true;
+  }
+  bool Finalise(){
+    if(m_data->Stores.count("ANNIEEvent")) delete m_data->Stores["ANNIEEvent"];
+    m_data->Stores.erase("ANNIEEvent");
+    return true;
+  }
+ private:
+  uint32_t event;
+};
+REGISTER_TOOL(PipelineTestSource);
+
+
+// Pipelinable: combines the event number with the file number from the Header.
+// Also reads a CStore run constant, which does not stop it from being pipelined
+class PipelineTestHeader: public Tool {
+ public:
+  bool Initialise(std::string, DataModel& data){ m_data = &data; return true; }
+  bool Execute(){
+    BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+    uint32_t event = 0, file = 0, run_constant = 0;
+    if(!annie_event->Get("EventNumber",event)) return false;
+    if(!annie_event->Header->Get("TestFileNumber",file)) return false;
+    if(!m_data->CStore.Get("TestRunConstant",run_constant) || run_constant!=kRunConstant) return false;
+    Work(event,200);
+    uint64_t value = 1000*uint64_t(event)+file;
+    annie_event->Set("TestValue",value);
+    Record("header",event,value);
+    return true;
+  }
+  bool Finalise(){ return true; }
+};
+REGISTER_TOOL(PipelineTestHeader);
+
+
+// Undeclared, so serial: reads the per-event CStore value left by the head
+class PipelineTestCStoreReader: public Tool {
+ public:
+  bool Initialise(std::string, DataModel& data){ m_data = &data; return true; }
+  bool Execute(){
+    BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+    uint32_t event = 0, cstore_event = 0;
+    uint64_t value = 0;
+    if(!annie_event->Get("EventNumber",event) || !annie_event->Get("TestValue",value)) return false;
+    if(!m_data->CStore.Get("TestEventNumber",cstore_event)) return false;
+    Record("cstore",event,cstore_event);
+    Record("reader",event,value);
+    return true;
+  }
+  bool Finalise(){ return true; }
+};
+REGISTER_TOOL(PipelineTestCStoreReader);
+
+
+// Declares that it reads the per-event CStore value, so it must run serially
+// even though it would otherwise be pipelinable
+class PipelineTestCStoreStage: public Tool {
+ public:
+  bool Initialise(std::string, DataModel& data){ m_data = &data; return true; }
+  bool Execute(){
+    BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+    uint32_t event = 0, cstore_event = 0;
+    if(!annie_event->Get("EventNumber",event)) return false;
+    Work(event,150);
+    if(!m_data->CStore.Get("TestEventNumber",cstore_event)) return false;
+    Record("cstage",event,cstore_event);
+    return true;
+  }
+  bool Finalise(){ return true; }
+};
+REGISTER_TOOL(PipelineTestCStoreStage);
+
+
+// Pipelinable, last: records what reaches the end of the chain
+class PipelineTestSink: public Tool {
+ public:
+  bool Initialise(std::string, DataModel& data){ m_data = &data; return true; }
+  bool Execute(){
+    BoostStore* annie_event = m_data->Stores["ANNIEEvent"];
+    uint32_t event = 0;
+    uint64_t value = 0;
+    if(!annie_event->Get("EventNumber",event) || !annie_event->Get("TestValue",value)) return false;
+    Work(event,100);
+    Record("sink",event,value);
+    return true;
+  }
+  bool Finalise(){ return true; }
+};
+REGISTER_TOOL(PipelineTestSink);
+
+
+namespace {
+
+  std::string directory;
+
+  std::string WriteFile(const std::string& name, const std::string& content){
+    std::string path = directory+"/"+name;
+    std::ofstream file(path);
+    file << content;
+    return path;
+  }
+
+  // runs the sub-chain in a ToolChain and returns what the tools recorded
+  std::map<std::string,Records> Run(const std::string& label, const std::vector<std::string>& tools, bool pipelined){
+
+    std::string tools_file;
+    for(const std::string& tool : tools){
+      std::string config;
+      if(tool=="PipelineTestHeader") config = WriteFile(tool+"Config","PipelineReads ANNIEEvent:EventNumber\nPipelineWrites ANNIEEvent:TestValue\n"
+                                                        "PipelineRunConstants CStore:TestRunConstant\n");
+      if(tool=="PipelineTestCStoreStage") config = WriteFile(tool+"Config","PipelineReads ANNIEEvent:EventNumber,CStore:TestEventNumber\n");
+      if(tool=="PipelineTestSink") config = WriteFile(tool+"Config","PipelineReads ANNIEEvent:EventNumber,ANNIEEvent:TestValue\n");
+      tools_file += tool+" "+tool+" "+config+"\n";
+    }
+    std::string pipeline_config = "verbosity 0\nToolsFile "+WriteFile("PipelineTools",tools_file)+"\n"
+      "Pipelined "+std::to_string(int(pipelined))+"\nMaxEventsInFlight 6\n";
+    std::string chain_tools = "PipelineToolChain PipelineToolChain "+WriteFile("PipelineToolChainConfig",pipeline_config)+"\n";
+    std::string chain_config = "verbose 0\nerror_level 0\nattempt_recover 1\nlog_mode Interactive\n"
+      "log_local_path ./log\nlog_service LogStore\nservice_publish_sec -1\nservice_kick_sec -1\n"
+      "Tools_File "+WriteFile("ToolsConfig",chain_tools)+"\nInline -1\nInteractive 0\n";
+
+    std::cout << "PipelineOrderTest: running " << label << std::endl;
+    records.clear();
+    threads.clear();
+    ToolChain chain(WriteFile("ToolChainConfig",chain_config));
+    return records;
+  }
+
+  int failures = 0;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "PipelineOrderTest: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  void CheckRecords(const Records& got, const Records& expected, const std::string& what){
+    Check(got.size()==expected.size(), what+": "+std::to_string(got.size())+" events instead of "+std::to_string(expected.size()));
+    for(size_t i=0; i<got.size() && i<expected.size(); ++i){
+      if(got.at(i)!=expected.at(i)){
+        Check(false, what+": entry "+std::to_string(i)+" is event "+std::to_string(got.at(i).first)+" with value "
+              +std::to_string(got.at(i).second)+", expected event "+std::to_string(expected.at(i).first)
+              +" with value "+std::to_string(expected.at(i).second));
+        break;
+      }
+    }
+  }
+
+}
+
+
+int main(){
+
+  char dirname[] = "/tmp/PipelineOrderTestXXXXXX";
+  if(mkdtemp(dirname)==nullptr){
+    std::cout << "PipelineOrderTest: could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  directory = dirname;
+
+  // what every tool should see: all events in order, each with the file it came from
+  Records expected_values, expected_cstore;
+  for(uint32_t event=0; event<kEvents; ++event){
+    expected_values.push_back(std::make_pair(event,1000*uint64_t(event)+event/kEventsPerFile));
+    expected_cstore.push_back(std::make_pair(event,uint64_t(event)));
+  }
+
+  const std::vector<std::string> with_reader = {"PipelineTestSource","PipelineTestHeader","PipelineTestCStoreReader","PipelineTestSink"};
+  const std::vector<std::string> without_reader = {"PipelineTestSource","PipelineTestHeader","PipelineTestSink"};
+  const std::vector<std::string> with_stage = {"PipelineTestSource","PipelineTestHeader","PipelineTestCStoreStage","PipelineTestSink"};
+
+  std::map<std::string,Records> serial = Run("serially",with_reader,false);
+  for(const std::string& tool : {"header","reader","sink"}) CheckRecords(serial[tool],expected_values,std::string("serial ")+tool);
+  CheckRecords(serial["cstore"],expected_cstore,"serial CStore");
+
+  std::map<std::string,Records> pipelined = Run("pipelined, with a serial tool after the first stage",with_reader,true);
+  for(const std::string& tool : {"header","reader","sink"}) CheckRecords(pipelined[tool],serial[tool],std::string("pipelined ")+tool);
+  CheckRecords(pipelined["cstore"],serial["cstore"],"pipelined CStore");
+
+  // without a serial tool after the stages the head reads ahead, and when it
+  // opens a new file the events in flight move to the new file's Header, as
+  // the old one is gone. They still arrive in order, never see an older file
+  // than their own, and the sink sees what the header stage set.
+  std::map<std::string,Records> stages_only = Run("pipelined, stages only",without_reader,true);
+  const Records& header = stages_only["header"];
+  Check(header.size()==kEvents,"stages only header: "+std::to_string(header.size())+" events");
+  for(size_t i=0; i<header.size(); ++i){
+    uint32_t event = header.at(i).first;
+    uint64_t file = header.at(i).second%1000;
+    if(event!=i || header.at(i).second/1000!=event || file<event/kEventsPerFile || file>(kEvents-1)/kEventsPerFile){
+      Check(false,"stages only header: entry "+std::to_string(i)+" is event "+std::to_string(event)+" with value "
+            +std::to_string(header.at(i).second));
+      break;
+    }
+  }
+  CheckRecords(stages_only["sink"],header,"stages only sink");
+  Check(threads["header"].size()==1 && !threads["header"].count(*threads["source"].begin()),
+        "stages only: the header tool, which only declares a CStore run constant, was not pipelined");
+
+  // a declared read of a per-event CStore value keeps the tool on the calling
+  // thread, bound to its own event
+  std::map<std::string,Records> with_cstore_stage = Run("pipelined, with a declared CStore read",with_stage,true);
+  CheckRecords(with_cstore_stage["cstage"],expected_cstore,"declared CStore read");
+  CheckRecords(with_cstore_stage["sink"],expected_values,"declared CStore read sink");
+  Check(threads["cstage"]==threads["source"],"the tool that declares a CStore read did not run on the calling thread");
+  Check(!threads["header"].count(*threads["source"].begin()),"with a declared CStore read: the header tool was not pipelined");
+
+  for(const char* name : {"PipelineTestHeaderConfig","PipelineTestSinkConfig","PipelineTestCStoreStageConfig","PipelineTools","PipelineToolChainConfig","ToolsConfig","ToolChainConfig"}){
+    std::remove((directory+"/"+name).c_str());
+  }
+  rmdir(dirname);
+
+  if(failures){
+    std::cout << "PipelineOrderTest: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "PipelineOrderTest: OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,403 @@
+// Compares the weights of PrimaryHadronSWCentralSplineVariationWeightCalc
+// with a copy of the code it replaced (OldSWSplineWeights below, kept as it
+// was apart from the class around it), which smeared the HARP cross section
+// and built the momentum and theta TSpline3s again for every event and
+// universe.
+//  * HARP-like input: the calculator reads its cross section, covariance and
+//    Sanford-Wang parameters from FW_SEARCH_PATH, so the test writes them to
+//    a temporary directory. The cross section is the Sanford-Wang one at the
+//    HARP bin centres, with errors growing with momentum so that some
+//    universes come out negative and are skipped
+//  * MiniBooNE, MicroBooNE and both calculators, with random pi+ parents
+//    inside and outside of the HARP momentum and angle ranges (including
+//    above the guard at the beam momentum) and events with a pi- parent
+//  * the number of weights must be the same, and each weight must agree
+//    within kTolerance: the spline values are rounded to float as before,
+//    so they only differ by the order of the additions
+// Run from the top directory after make:
+//   tests/ReweightFlux/SWCentralSplineComparison [events per calculator, default 2000]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "CLHEP/Random/JamesRandom.h"
+#include "CLHEP/Random/RandGaussQ.h"
+
+#include "TArrayD.h"
+#include "TDecompChol.h"
+#include "TFile.h"
+#include "TH1F.h"
+#include "TLorentzVector.h"
+#include "TMatrixD.h"
+#include "TRandom3.h"
+#include "TSpline.h"
+
+#include "MCEventWeight.h"
+#include "WeightCalc.h"
+#include "WeightCalcFactory.h"
+
+namespace {
+
+  // HARP binning of the pi+ cross section
+  const std::vector<double> kMomentumBounds = {0.75, 1.0, 1.25, 1.5, 1.75, 2.0, 2.25, 2.5, 2.75, 3.0, 3.25, 4.0, 5.0, 6.5};
+  const std::vector<double> kThetaBounds = {0.03, 0.06, 0.09, 0.12, 0.15, 0.18, 0.21};
+  // MiniBooNE pi+ Sanford-Wang parameters, PhysRevD.79.072002
+  const std::vector<double> kSWParam = {220.7, 1.080, 1.0, 1.978, 1.32, 5.572, 0.0868, 9.686};
+  const int kMultisims = 100;
+  const double kTolerance = 1e-6;
+
+  int n_events = 2000;
+  int failures = 0;
+
+  void Check(bool ok, const std::string& what){
+    if(ok) return;
+    std::cout << "SWCentralSplineComparison: FAILED: " << what << std::endl;
+    ++failures;
+  }
+
+  double SanfordWang(double p, double theta){
+    const std::vector<double>& c = kSWParam;
+    double beam = 8.89;
+    return c[0]*pow(p, c[1])*(1. - p/(beam - 1.))*exp(-c[2]*pow(p, c[3])/pow(beam, c[4]))
+      *exp(-c[5]*theta*(p - c[6]*beam*pow(cos(theta), c[7])));
+  }
+
+  // HARP data and Sanford-Wang fit files as the calculator expects them
+  void WriteInputs(const std::string& directory){
+    int Npbins = int(kMomentumBounds.size()) - 1;
+    int Ntbins = int(kThetaBounds.size()) - 1;
+    TMatrixD xsec(Npbins, Ntbins);
+    std::vector<double> error(Npbins*Ntbins);
+    for(int pbin = 0; pbin < Npbins; pbin++){
+      for(int tbin = 0; tbin < Ntbins; tbin++){
+        double p = 0.5*(kMomentumBounds[pbin] + kMomentumBounds[pbin+1]);
+        double theta = 0.5*(kThetaBounds[tbin] + kThetaBounds[tbin+1]);
+        xsec(pbin, tbin) = SanfordWang(p, theta);
+        error[pbin*Ntbins + tbin] = (0.1 + 0.3*pbin/(Npbins - 1.))*xsec(pbin, tbin);
+      }
+    }
+    // neighbouring analysis bins correlated, positive definite for |rho| < 1
+    int Nbins = Npbins*Ntbins;
+    TMatrixD cov(Nbins, Nbins);
+    for(int a = 0; a < Nbins; a++){
+      for(int b = 0; b < Nbins; b++) cov(a, b) = error[a]*error[b]*pow(0.6, std::abs(a - b));
+    }
+    TArrayD momentum(int(kMomentumBounds.size()), kMomentumBounds.data());
+    TArrayD theta(int(kThetaBounds.size()), kThetaBounds.data());
+    TArrayD sw(int(kSWParam.size()), kSWParam.data());
+
+    TFile data((directory + "/HARPData.root").c_str(), "RECREATE");
+    TDirectory* harp = data.mkdir("HARPData")->mkdir("PiPlus");
+    harp->WriteObject(&xsec, "PPCrossSection");
+    harp->WriteObject(&cov, "PPcovarianceMatrix");
+    harp->WriteObject(&momentum, "PPmomentumBoundsArray");
+    harp->WriteObject(&theta, "PPthetaBoundsArray");
+    data.Close();
+
+    TFile fit((directory + "/SWFit.root").c_str(), "RECREATE");
+    fit.mkdir("SW")->mkdir("PiPlus")->WriteObject(&sw, "SWPiPlusFitVal");
+    fit.Close();
+  }
+
+}
+
+
+// PrimaryHadronSWCentralSplineVariationWeightCalc before the precomputed
+// spline bases, for random numbers drawn in multisim mode
+class OldSWSplineWeights {
+ public:
+  void Configure(const std::string& directory, const evwgh::fluxconfig& pset);
+  std::vector<double> GetWeight(evwgh::event& e);
+  int SkippedUniverses() const { return skipped; }
+ private:
+  std::pair<bool, double> SplineWeight(evwgh::event& e, std::vector<double> rand, bool floatGuard);
+
+  int fNmultisims;
+  int fprimaryHad;
+  std::string fWeightCalc;
+  std::vector< std::vector< double > > fWeightArray;
+  TMatrixD* HARPXSec;
+  TMatrixD* HARPLowerTriangluarCov;
+  std::vector<double> HARPmomentumBounds;
+  std::vector<double> HARPthetaBounds;
+  std::vector<double> SWParam;
+  std::vector<TH1F> fMomentumBins;
+  TH1F* fThetaBins;
+  int skipped = 0;
+};
+
+void OldSWSplineWeights::Configure(const std::string& directory, const evwgh::fluxconfig& pset){
+  fNmultisims = pset.number_of_multisims;
+  fprimaryHad = pset.PrimaryHadronGeantCode;
+  fWeightCalc = pset.weight_calculator;
+
+  TFile file((directory + "/" + pset.ExternalData).c_str());
+  HARPXSec = new TMatrixD(*(TMatrixD*) file.Get("HARPData/PiPlus/PPCrossSection"));
+  TMatrixD* HARPCov = (TMatrixD*) file.Get("HARPData/PiPlus/PPcovarianceMatrix");
+  TArrayD* momentum = (TArrayD*) file.Get("HARPData/PiPlus/PPmomentumBoundsArray");
+  TArrayD* theta = (TArrayD*) file.Get("HARPData/PiPlus/PPthetaBoundsArray");
+  HARPmomentumBounds.assign(momentum->GetArray(), momentum->GetArray() + momentum->GetSize());
+  HARPthetaBounds.assign(theta->GetArray(), theta->GetArray() + theta->GetSize());
+  TFile fit((directory + "/" + pset.ExternalFit).c_str());
+  TArrayD* sw = (TArrayD*) fit.Get("SW/PiPlus/SWPiPlusFitVal");
+  SWParam.assign(sw->GetArray(), sw->GetArray() + sw->GetSize());
+
+  CLHEP::HepJamesRandom rng;
+  rng.setSeed(long(pset.random_seed), 0);
+  fWeightArray.resize(2*fNmultisims);
+  for(unsigned int i = 0; i < fWeightArray.size(); i++){
+    fWeightArray[i].resize(HARPCov->GetNcols());
+    for(unsigned int j = 0; j < fWeightArray[i].size(); j++) fWeightArray[i][j] = CLHEP::RandGaussQ::shoot(&rng, 0, 1.);
+  }
+
+  TDecompChol dc = TDecompChol(*(HARPCov));
+  if(!dc.Decompose()) throw std::invalid_argument(" Cannot decompose covariance matrix to begin smearing.");
+  HARPLowerTriangluarCov = new TMatrixD(dc.GetU());
+
+  int Ntbins = int(HARPthetaBounds.size()) - 1;
+  int Npbins = int(HARPmomentumBounds.size()) - 1;
+  fMomentumBins.resize(Ntbins);
+  for(int bin = 0; bin < Ntbins; bin++)
+    fMomentumBins[bin] = TH1F(Form("OldHARPp_%i",bin),";;;", Npbins, HARPmomentumBounds.data());
+  fThetaBins = new TH1F("OldHARPt",";;;", Ntbins, HARPthetaBounds.data());
+}
+
+std::vector<double> OldSWSplineWeights::GetWeight(evwgh::event& e){
+  std::vector<double> weight;
+  if(e.tptype != fprimaryHad){
+    weight.resize(fNmultisims);
+    std::fill(weight.begin(), weight.end(), 1);
+    return weight;
+  }
+  for(unsigned int i = 0; int(weight.size()) < fNmultisims; i++){
+    if(fWeightCalc.find("MicroBooNE") != std::string::npos){
+      std::pair<bool, double> test_weight = SplineWeight(e, fWeightArray[i], false);
+      if(test_weight.first) weight.push_back(test_weight.second);
+      else ++skipped;
+    }
+    if(fWeightCalc.find("MiniBooNE") != std::string::npos){
+      std::pair<bool, double> test_weight = SplineWeight(e, fWeightArray[i], true);
+      if(test_weight.first) weight.push_back(test_weight.second);
+      else ++skipped;
+    }
+  }
+  return weight;
+}
+
+// MiniBooNEWeightCalc (floatGuard) and MicroBooNEWeightCalc, which only
+// differed in the precision of the guard at the beam momentum
+std::pair<bool, double> OldSWSplineWeights::SplineWeight(evwgh::event& e, std::vector<double> rand, bool floatGuard){
+
+  bool parameters_pass = true;
+
+  double c1 = SWParam[0];
+  double c2 = SWParam[1];
+  double c3 = SWParam[2];
+  double c4 = SWParam[3];
+  double c5 = SWParam[4];
+  double c6 = SWParam[5];
+  double c7 = SWParam[6];
+  double c8 = SWParam[7];
+  double c9 = 1.0;
+
+  double HadronMass = 0.13957010;
+  TLorentzVector HadronVec;
+  double HadronE = sqrt(e.tpx*e.tpx + e.tpy*e.tpy + e.tpz*e.tpz + HadronMass*HadronMass);
+  HadronVec.SetPxPyPzE(e.tpx, e.tpy, e.tpz, HadronE);
+
+  double ThetaOfInterest;
+  if(HadronVec.Theta() > 0.195){
+    ThetaOfInterest = 0.195;
+  }
+  else{
+    ThetaOfInterest = HadronVec.Theta();
+  }
+
+  TLorentzVector ProtonVec;
+  double ProtonMass = 0.9382720;
+  double ProtonPz = 8.89; //GeV
+  ProtonVec.SetPxPyPzE(0, 0, ProtonPz, sqrt(ProtonPz*ProtonPz + ProtonMass*ProtonMass));
+
+  double CV = c1 * pow(HadronVec.P(), c2) *
+    (1. - HadronVec.P()/(ProtonVec.P() - c9)) *
+    exp(-1. * c3 * pow(HadronVec.P(), c4) / pow(ProtonVec.P(), c5)) *
+    exp(-1. * c6 * ThetaOfInterest *(HadronVec.P() - c7 * ProtonVec.P() * pow(cos(ThetaOfInterest), c8)));
+
+  if(floatGuard){
+    if(float(HadronVec.P()) > (float(ProtonVec.P()) - float(c9))){
+      CV = 0;}
+  }
+  else{
+    if((HadronVec.P()) > ((ProtonVec.P()) - (c9))){
+      CV = 0;}
+  }
+
+  int Ntbins = int(HARPthetaBounds.size()) - 1;
+  int Npbins = int(HARPmomentumBounds.size()) - 1;
+
+  std::vector< double > HARPCrossSectionAnalysisBins;
+  HARPCrossSectionAnalysisBins.resize(int(Ntbins*Npbins));
+
+  int anaBin = 0;
+  for(int pbin = 0; pbin < Npbins; pbin++){
+    for(int tbin = 0; tbin < Ntbins; tbin++){
+      HARPCrossSectionAnalysisBins[anaBin] = HARPXSec[0][pbin][tbin];
+      anaBin++;
+    }
+  }
+
+  std::vector< double > smearedHARPCrossSectionAnalysisBins =
+    evwgh::WeightCalc::MultiGaussianSmearing(HARPCrossSectionAnalysisBins, HARPLowerTriangluarCov, true, rand);
+
+  for(int check = 0; check < int(smearedHARPCrossSectionAnalysisBins.size()); check++){
+    if(smearedHARPCrossSectionAnalysisBins[check] < 0){ parameters_pass = false;}
+  }
+
+  TMatrixD* smearedHARPXSec = new TMatrixD(Npbins,Ntbins);
+
+  anaBin = 0;
+  for(int pbin = 0; pbin < Npbins; pbin++){
+    for(int tbin = 0; tbin < Ntbins; tbin++){
+      smearedHARPXSec[0][pbin][tbin] = smearedHARPCrossSectionAnalysisBins[anaBin];
+      anaBin++;
+    }
+  }
+
+  std::vector< TSpline3 > SplinesVsMomentum;
+  SplinesVsMomentum.resize(Ntbins);
+
+  for(int tbin = 0; tbin < Ntbins; tbin++){
+    for(int pbin = 0; pbin < Npbins; pbin++){
+      fMomentumBins[tbin].SetBinContent(pbin+1, smearedHARPXSec[0][pbin][tbin]);
+    }
+    SplinesVsMomentum[tbin] = TSpline3(&(fMomentumBins[tbin]),"b2e2",0,0);
+  }
+
+  delete smearedHARPXSec;
+
+  for(int tbin = 0; tbin < Ntbins; tbin++){
+    fThetaBins->SetBinContent(tbin+1, SplinesVsMomentum[tbin].Eval(HadronVec.P()));
+  }
+
+  TSpline3* FinalSpline = new TSpline3(fThetaBins,"b2e2",0,0);
+
+  double RW = FinalSpline->Eval(ThetaOfInterest);
+
+  delete FinalSpline;
+
+  double weight = 1;
+
+  if(RW < 0 || CV < 0){
+    weight = 1;
+  }
+  else if(fabs(CV) < 1.e-12){
+    weight = 1;
+  }
+  else{
+    weight *= RW/CV;
+  }
+
+  if(weight < 0) weight = 0;
+  if(weight > 30) weight = 30;
+  if(!(std::isfinite(weight))) weight = 30;
+
+  std::pair<bool, double> output(parameters_pass, weight);
+
+  return output;
+}
+
+
+int main(int argc, char** argv){
+
+  if(argc>1) n_events = atoi(argv[1]);
+
+  char dirname[] = "/tmp/SWCentralSplineComparisonXXXXXX";
+  if(mkdtemp(dirname)==nullptr){
+    std::cout << "SWCentralSplineComparison: could not create a temporary directory" << std::endl;
+    return 1;
+  }
+  std::string directory = dirname;
+  TH1::AddDirectory(false);
+  WriteInputs(directory);
+  setenv("FW_SEARCH_PATH", dirname, 1);
+
+  int seed = 2;
+  for(std::string calculator : {"MiniBooNE", "MicroBooNE", "MiniBooNE,MicroBooNE"}){
+
+    evwgh::fluxconfig pset;
+    pset.type = "PrimaryHadronSWCentralSplineVariation";
+    pset.random_seed = seed++;
+    pset.parameter_list = {"piplus"};
+    pset.parameter_sigma = 1;
+    pset.mode = "multisim";
+    pset.scale_factor = 1;
+    pset.number_of_multisims = kMultisims;
+    pset.PrimaryHadronGeantCode = 211;
+    pset.weight_calculator = calculator;
+    pset.ExternalData = "HARPData.root";
+    pset.ExternalFit = "SWFit.root";
+    pset.use_MiniBooNE_random_numbers = false;
+
+    // not deleted: WeightCalc has no virtual destructor, as in WeightManager
+    evwgh::WeightCalc* calc = evwgh::WeightCalcFactory::Create("PrimaryHadronSWCentralSplineVariationWeightCalc");
+    if(calc==nullptr){
+      Check(false, "the weight calculator is not registered");
+      break;
+    }
+    calc->Configure(pset);
+    OldSWSplineWeights old;
+    old.Configure(directory, pset);
+
+    TRandom3 random(pset.random_seed);
+    double max_difference = 0;
+    long compared = 0;
+    for(int i_event = 0; i_event < n_events; i_event++){
+      evwgh::event e = evwgh::event();
+      e.tptype = (i_event%10 == 0) ? -211 : 211;
+      double p = random.Uniform(0.3, 8.5);
+      double theta = random.Uniform(0., 0.3);
+      double phi = random.Uniform(0., 2*M_PI);
+      e.tpx = p*sin(theta)*cos(phi);
+      e.tpy = p*sin(theta)*sin(phi);
+      e.tpz = p*cos(theta);
+
+      std::vector<double> expected = old.GetWeight(e);
+      std::vector<double> got = calc->GetWeight(e).at(0);
+      std::string what = calculator + ", event " + std::to_string(i_event) + " (p " + std::to_string(p)
+        + ", theta " + std::to_string(theta) + ")";
+      if(got.size() != expected.size()){
+        Check(false, what + ": " + std::to_string(got.size()) + " weights instead of " + std::to_string(expected.size()));
+        continue;
+      }
+      for(size_t i = 0; i < got.size(); i++){
+        double difference = std::abs(got[i] - expected[i]);
+        max_difference = std::max(max_difference, difference);
+        Check(difference <= kTolerance, what + ", weight " + std::to_string(i) + ": "
+              + std::to_string(got[i]) + " instead of " + std::to_string(expected[i]));
+        compared++;
+      }
+      if(failures > 20) break;
+    }
+    std::cout << "SWCentralSplineComparison: " << calculator << ": " << compared << " weights compared, largest difference "
+              << max_difference << ", " << old.SkippedUniverses() << " negative universes skipped" << std::endl;
+    Check(old.SkippedUniverses() > 0, calculator + ": no universe was skipped, the sample does not test it");
+  }
+
+  std::remove((directory + "/HARPData.root").c_str());
+  std::remove((directory + "/SWFit.root").c_str());
+  rmdir(dirname);
+
+  if(failures){
+    std::cout << "SWCentralSplineComparison: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "SWCentralSplineComparison: OK" << std::endl;
+  return 0;
+}
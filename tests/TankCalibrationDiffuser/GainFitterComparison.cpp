@@ -0,0 +1,200 @@
+// Fits toy single tube charge and time histograms, binned like the ones of
+// TankCalibrationDiffuser, once with the TF1/Minuit fits the tool used to do
+// and once with gainfit, and reports the differences of the fitted parameters
+// in units of the Minuit errors.
+//  * FitSeeds Config: both fits start from the same values and minimise the
+//    same chi2, so they should end up at the same minimum
+//  * time fits: ROOT's own "gaus" start values against the gainfit seeds,
+//    again the same minimum is expected
+//  * FitSeeds Auto: gainfit starts from the seeds it takes from the
+//    histogram; the differences are only reported, together with the number
+//    of toys where one of the two fits ended at a clearly worse chi2
+// Run from the top directory after make:
+//   tests/TankCalibrationDiffuser/GainFitterComparison [toys per model, default 200]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "TF1.h"
+#include "TFitResultPtr.h"
+#include "TH1F.h"
+#include "TRandom3.h"
+
+#include "GainFitter.h"
+
+namespace {
+
+  // binning and range of the single tube histograms in configfiles/TankCalibrationDiffuser
+  const int kChargeBins = 200;
+  const double kChargeMin = -0.004;
+  const double kChargeMax = 0.016;
+  const int kTimeBins = 200;
+  const double kTimeMin = -10.;
+  const double kTimeMax = 30.;
+  const int kEntries = 20000;
+
+  // the same minimum: every parameter within this many Minuit errors
+  const double kTolerance = 0.05;
+  // share of the toys, among those where both fits converged, that must agree
+  const double kMinAgreement = 0.95;
+
+  struct Comparison {
+    std::string name;
+    int npar = 0;
+    int toys = 0;
+    int minuit_ok = 0;
+    int gainfit_ok = 0;
+    int both_ok = 0;
+    int agree = 0;
+    int gainfit_worse = 0;      // gainfit chi2 clearly above the Minuit chi2
+    int minuit_worse = 0;
+    std::vector<double> sum_pull, max_pull;
+
+    Comparison(const std::string& n, int np) : name(n), npar(np), sum_pull(np,0.), max_pull(np,0.) {}
+
+    void Add(int minuit_status, const TF1& minuit, const gainfit::Result& result){
+      ++toys;
+      bool ok_minuit = (minuit_status==0);
+      bool ok_gainfit = gainfit::Converged(result);
+      if(ok_minuit) ++minuit_ok;
+      if(ok_gainfit) ++gainfit_ok;
+      if(!ok_minuit || !ok_gainfit) return;
+      ++both_ok;
+      double largest = 0.;
+      for(int i=0; i<npar; ++i){
+        double error = minuit.GetParError(i);
+        double pull = (error>0.) ? (result.par[i]-minuit.GetParameter(i))/error : 0.;
+        sum_pull[i] += pull;
+        max_pull[i] = std::max(max_pull[i],std::fabs(pull));
+        largest = std::max(largest,std::fabs(pull));
+      }
+      if(largest<kTolerance) ++agree;
+      if(result.chi2>minuit.GetChisquare()+0.1) ++gainfit_worse;
+      if(minuit.GetChisquare()>result.chi2+0.1) ++minuit_worse;
+    }
+
+    double Agreement() const { return (both_ok>0) ? double(agree)/both_ok : 0.; }
+
+    void Print() const {
+      std::printf("%s: %d toys, converged Minuit %d, gainfit %d, both %d\n",name.c_str(),toys,minuit_ok,gainfit_ok,both_ok);
+      std::printf("  same minimum (all |dp| < %.2f sigma): %d (%.1f%%), worse chi2: gainfit %d, Minuit %d\n",
+                  kTolerance,agree,100.*Agreement(),gainfit_worse,minuit_worse);
+      for(int i=0; i<npar; ++i){
+        std::printf("  p%d: mean (gainfit-Minuit)/sigma %+.4f, max |.| %.4f\n",i,(both_ok>0) ? sum_pull[i]/both_ok : 0.,max_pull[i]);
+      }
+    }
+  };
+
+  gainfit::Histogram Bins(const TH1F& hist){
+    gainfit::Histogram data;
+    for(int i_bin=1; i_bin<=hist.GetNbinsX(); ++i_bin){
+      data.x.push_back(hist.GetBinCenter(i_bin));
+      data.y.push_back(hist.GetBinContent(i_bin));
+    }
+    return data;
+  }
+
+  // pedestal, single p.e. peak and an exponential tail, as in the diffuser runs
+  void FillCharge(TH1F& hist, gainfit::Model model, TRandom3& random){
+    for(int i=0; i<kEntries; ++i){
+      double r = random.Uniform(0.,1.);
+      double charge;
+      if(model==gainfit::kGaus) charge = random.Gaus(0.0025,0.0012);
+      else if(r<0.6) charge = random.Gaus(0.0003,0.0004);
+      else if(model==gainfit::kGaus2 || r<0.85) charge = random.Gaus(0.0025,0.0012);
+      else charge = random.Exp(0.004);
+      hist.Fill(charge);
+    }
+  }
+
+  const char* Formula(gainfit::Model model){
+    if(model==gainfit::kGaus2Exp) return "gaus(0)+gaus(3)+expo(6)";
+    if(model==gainfit::kGaus2) return "gaus(0)+gaus(3)";
+    return "gaus";
+  }
+
+  const char* Name(gainfit::Model model){
+    if(model==gainfit::kGaus2Exp) return "Gaus2Exp";
+    if(model==gainfit::kGaus2) return "Gaus2";
+    return "Gaus";
+  }
+
+}
+
+
+int main(int argc, char** argv){
+
+  int n_toys = (argc>1) ? atoi(argv[1]) : 200;
+  TRandom3 random(12345);
+  int failures = 0;
+
+  // start values as in configfiles/LEDPulseAnalysis/TankCalibrationDiffuserConfig, with
+  // the amplitudes scaled to the toys
+  gainfit::Parameters config_seed = {{1500.,0.0005,0.0005,300.,0.002,0.002,1.,-1.}};
+  gainfit::Parameters config_seed_gaus = {{300.,0.002,0.002,0.,0.,0.,0.,0.}};
+
+  Comparison time("time (gaus)",gainfit::kGaus);
+  for(gainfit::Model model : {gainfit::kGaus, gainfit::kGaus2, gainfit::kGaus2Exp}){
+
+    Comparison config(std::string(Name(model))+", FitSeeds Config",model);
+    Comparison automatic(std::string(Name(model))+", FitSeeds Auto",model);
+    const gainfit::Parameters& seed = (model==gainfit::kGaus) ? config_seed_gaus : config_seed;
+
+    for(int i_toy=0; i_toy<n_toys; ++i_toy){
+
+      TH1F charge("charge","charge",kChargeBins,kChargeMin,kChargeMax);
+      charge.SetDirectory(nullptr);
+      FillCharge(charge,model,random);
+      gainfit::Histogram charge_data = Bins(charge);
+
+      // the old tool: TF1 with the configured start values, fitted "QR" (it used
+      // "QR+", which only also keeps the function in the histogram)
+      TF1 minuit("total",Formula(model),kChargeMin,kChargeMax);
+      minuit.SetParameters(seed.data());
+      int minuit_status = charge.Fit(&minuit,"QRN");
+
+      config.Add(minuit_status,minuit,gainfit::Fit(model,charge_data,kChargeMin,kChargeMax,seed));
+      gainfit::Parameters auto_seed = gainfit::Seed(model,charge_data,kChargeMin,kChargeMax);
+      automatic.Add(minuit_status,minuit,gainfit::Fit(model,charge_data,kChargeMin,kChargeMax,auto_seed));
+
+      // the time fit has always been a plain "gaus" with ROOT's start values
+      if(model==gainfit::kGaus){
+        TH1F hit_time("time","time",kTimeBins,kTimeMin,kTimeMax);
+        hit_time.SetDirectory(nullptr);
+        for(int i=0; i<kEntries; ++i) hit_time.Fill(random.Gaus(5.,2.));
+        TF1 minuit_time("gaus","gaus",kTimeMin,kTimeMax);
+        int time_status = hit_time.Fit(&minuit_time,"QN");
+        gainfit::Histogram time_data = Bins(hit_time);
+        time.Add(time_status,minuit_time,gainfit::Fit(gainfit::kGaus,time_data,kTimeMin,kTimeMax,
+          gainfit::Seed(gainfit::kGaus,time_data,kTimeMin,kTimeMax)));
+      }
+    }
+
+    config.Print();
+    automatic.Print();
+    if(config.Agreement()<kMinAgreement){
+      std::cout << "GainFitterComparison: FAILED: " << config.name << " found the Minuit minimum in only "
+                << 100.*config.Agreement() << "% of the toys" << std::endl;
+      ++failures;
+    }
+  }
+
+  time.Print();
+  if(time.Agreement()<kMinAgreement){
+    std::cout << "GainFitterComparison: FAILED: time fits found the Minuit minimum in only "
+              << 100.*time.Agreement() << "% of the toys" << std::endl;
+    ++failures;
+  }
+
+  if(failures){
+    std::cout << "GainFitterComparison: " << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "GainFitterComparison: OK" << std::endl;
+  return 0;
+}